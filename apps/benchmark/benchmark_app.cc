@@ -10,13 +10,16 @@
 #include "apps/benchmark/event.h"
 #include "apps/benchmark/measurements.h"
 #include "apps/benchmark/run_args.h"
+#include "apps/benchmark/statistics.h"
 #include "apps/benchmark/trace_collector_client.h"
+#include "apps/benchmark/trace_parser.h"
 #include "base/bind.h"
 #include "base/files/file_util.h"
 #include "base/macros.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
 #include "mojo/application/application_runner_chromium.h"
@@ -32,7 +35,7 @@ namespace {
 class BenchmarkApp : public mojo::ApplicationDelegate,
                      public TraceCollectorClient::Receiver {
  public:
-  BenchmarkApp() {}
+  BenchmarkApp() : app_(nullptr), iteration_(0) {}
   ~BenchmarkApp() override {}
 
   // mojo:ApplicationDelegate:
@@ -43,28 +46,17 @@ class BenchmarkApp : public mojo::ApplicationDelegate,
       mojo::ApplicationImpl::Terminate();
       return;
     }
+    app_ = app;
 
     // Don't compute the categories string if all categories should be traced.
-    std::string categories_str;
     if (args_.write_output_file) {
-      categories_str = "*";
+      categories_str_ = "*";
     } else {
-      categories_str = ComputeCategoriesStr();
+      categories_str_ = ComputeCategoriesStr();
     }
 
-    // Connect to trace collector, which will fetch the trace events produced by
-    // the app being benchmarked.
-    tracing::TraceCollectorPtr trace_collector;
-    app->ConnectToService("mojo:tracing", &trace_collector);
-    trace_collector_client_.reset(
-        new TraceCollectorClient(this, trace_collector.Pass()));
-    trace_collector_client_->Start(categories_str);
-
-    // Start tracing the application with 1 sec of delay.
-    base::MessageLoop::current()->PostDelayedTask(
-        FROM_HERE, base::Bind(&BenchmarkApp::StartTracedApplication,
-                              base::Unretained(this), app),
-        base::TimeDelta::FromSeconds(1));
+    results_.resize(args_.measurements.size());
+    StartIteration();
   }
 
   // Computes the string of trace categories we want to collect: a union of all
@@ -81,11 +73,34 @@ class BenchmarkApp : public mojo::ApplicationDelegate,
     return JoinString(unique_categories, ',');
   }
 
-  void StartTracedApplication(mojo::ApplicationImpl* app) {
+  void StartIteration() {
+    // Connect to trace collector, which will fetch the trace events produced by
+    // the app being benchmarked.
+    tracing::TraceCollectorPtr trace_collector;
+    app_->ConnectToService("mojo:tracing", &trace_collector);
+    trace_collector_client_.reset(
+        new TraceCollectorClient(this, trace_collector.Pass()));
+    trace_parser_.reset(new TraceParser);
+    if (args_.write_output_file) {
+      // Each iteration overwrites the trace of the previous one.
+      trace_file_.Initialize(
+          args_.output_file_path,
+          base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+    }
+    trace_collector_client_->Start(categories_str_);
+
+    // Start tracing the application with 1 sec of delay.
+    base::MessageLoop::current()->PostDelayedTask(
+        FROM_HERE, base::Bind(&BenchmarkApp::StartTracedApplication,
+                              base::Unretained(this)),
+        base::TimeDelta::FromSeconds(1));
+  }
+
+  void StartTracedApplication() {
     // Record the time origin for measurements just before connecting to the app
     // being benchmarked.
     time_origin_ = base::TimeTicks::FromInternalValue(MojoGetTimeTicksNow());
-    traced_app_connection_ = app->ConnectToApplication(args_.app);
+    traced_app_connection_ = app_->ConnectToApplication(args_.app);
 
     // Post task to stop tracing when the time is up.
     base::MessageLoop::current()->PostDelayedTask(
@@ -101,36 +116,69 @@ class BenchmarkApp : public mojo::ApplicationDelegate,
   }
 
   // TraceCollectorClient::Receiver:
-  void OnTraceCollected(std::string trace_data) override {
-    if (args_.write_output_file) {
-      // Write the trace file regardless of whether it can be parsed (or whether
-      // the measurements succeed), as it can be useful to debug failures.
-      base::File trace_file(
-          args_.output_file_path,
-          base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
-      trace_file.WriteAtCurrentPos(trace_data.data(), trace_data.size());
+  void OnTraceDataAvailable(const char* data, size_t num_bytes) override {
+    // Write the trace file regardless of whether it can be parsed (or whether
+    // the measurements succeed), as it can be useful to debug failures.
+    if (trace_file_.IsValid())
+      trace_file_.WriteAtCurrentPos(data, num_bytes);
+
+    // Parse trace events as they arrive, rather than keeping the whole trace.
+    if (trace_parser_ && !trace_parser_->Feed(data, num_bytes))
+      trace_parser_.reset();
+  }
+
+  void OnTraceCollected() override {
+    if (trace_file_.IsValid()) {
+      trace_file_.Close();
       printf("wrote trace file at: %s\n",
              args_.output_file_path.value().c_str());
     }
 
-    // Parse trace events.
     std::vector<Event> events;
-    if (!GetEvents(trace_data, &events)) {
+    if (!trace_parser_ || !trace_parser_->Finish(&events)) {
       LOG(ERROR) << "Failed to parse the trace data";
       mojo::ApplicationImpl::Terminate();
       return;
     }
+    trace_parser_.reset();
 
-    // Calculate and print the results.
-    bool succeeded = true;
+    // Calculate the results, printing them right away if there is a single
+    // iteration.
+    iteration_++;
+    bool single_iteration = args_.iterations == 1;
     Measurements measurements(events, time_origin_);
-    for (const Measurement& measurement : args_.measurements) {
-      double result = measurements.Measure(measurement);
-      if (result >= 0.0) {
-        printf("measurement: %s %lf\n", measurement.spec.c_str(), result);
-      } else {
+    for (size_t i = 0; i < args_.measurements.size(); ++i) {
+      const Measurement& measurement = args_.measurements[i];
+      Breakdown breakdown;
+      double result = measurements.Measure(measurement, &breakdown);
+      std::string tag = single_iteration
+                            ? "measurement:"
+                            : base::StringPrintf("iteration %d:", iteration_);
+      PrintResult(tag, measurement, result, breakdown);
+      if (result >= 0.0)
+        results_[i].push_back(result);
+    }
+
+    if (iteration_ < args_.iterations) {
+      // Let the trace collector client finish before replacing it.
+      base::MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(&BenchmarkApp::StartIteration, base::Unretained(this)));
+      return;
+    }
+
+    bool succeeded = true;
+    for (size_t i = 0; i < args_.measurements.size(); ++i) {
+      // A measurement that failed in any iteration fails overall, as its
+      // results wouldn't be comparable.
+      if (static_cast<int>(results_[i].size()) < args_.iterations) {
         succeeded = false;
-        printf("measurement: %s FAILED\n", measurement.spec.c_str());
+        if (!single_iteration) {
+          printf("measurement: %s FAILED\n",
+                 args_.measurements[i].spec.c_str());
+        }
+      } else if (!single_iteration) {
+        PrintSummary(args_.measurements[i], Summarize(results_[i]));
       }
     }
 
@@ -146,11 +194,43 @@ class BenchmarkApp : public mojo::ApplicationDelegate,
   }
 
  private:
+  void PrintResult(const std::string& tag,
+                   const Measurement& measurement,
+                   double result,
+                   const Breakdown& breakdown) {
+    if (result < 0.0) {
+      printf("%s %s FAILED\n", tag.c_str(), measurement.spec.c_str());
+      return;
+    }
+    printf("%s %s %lf\n", tag.c_str(), measurement.spec.c_str(), result);
+    for (const auto& part : breakdown)
+      printf("  %s: %lf\n", part.first.c_str(), part.second);
+  }
+
+  void PrintSummary(const Measurement& measurement, const Summary& summary) {
+    // The mean is printed in the same format as a single result, for the
+    // scripts that run benchmarks.
+    printf("measurement: %s %lf\n", measurement.spec.c_str(), summary.mean);
+    printf("  mean %lf +- %lf (95%% confidence), stddev %lf, %d iterations\n",
+           summary.mean, summary.confidence_interval, summary.stddev,
+           static_cast<int>(summary.count));
+  }
+
   RunArgs args_;
+  mojo::ApplicationImpl* app_;
+  std::string categories_str_;
   mojo::ApplicationConnection* traced_app_connection_;
   scoped_ptr<TraceCollectorClient> trace_collector_client_;
+  // Null if the trace of the current iteration failed to parse.
+  scoped_ptr<TraceParser> trace_parser_;
+  base::File trace_file_;
   base::TimeTicks time_origin_;
 
+  // The number of iterations done, and the successful results of each
+  // measurement in these.
+  int iteration_;
+  std::vector<std::vector<double>> results_;
+
   DISALLOW_COPY_AND_ASSIGN(BenchmarkApp);
 };
 }  // namespace
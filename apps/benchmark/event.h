@@ -9,7 +9,6 @@
 #include <vector>
 
 #include "base/time/time.h"
-#include "base/values.h"
 
 namespace benchmark {
 
@@ -23,6 +22,8 @@ struct Event {
   std::string categories;
   base::TimeTicks timestamp;
   base::TimeDelta duration;
+  // The "tid" of the event, if any.
+  std::string thread_id;
 
   Event();
   Event(EventType type,
@@ -45,6 +46,8 @@ struct Event {
 //  |result|. All duration events are joined to form the corresponding complete
 //  events and the resulting complete events appear in |result| instead of the
 //  the duration events.
+//
+// To parse a trace as it arrives, use TraceParser.
 bool GetEvents(const std::string& trace_json, std::vector<Event>* result);
 
 }  // namespace benchmark
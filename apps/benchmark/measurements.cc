@@ -5,6 +5,11 @@
 #include "apps/benchmark/measurements.h"
 
 #include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "apps/benchmark/statistics.h"
+#include "base/strings/stringprintf.h"
 
 namespace benchmark {
 namespace {
@@ -41,6 +46,15 @@ Measurements::Measurements(std::vector<Event> events,
 Measurements::~Measurements() {}
 
 double Measurements::Measure(const Measurement& measurement) const {
+  return Measure(measurement, nullptr);
+}
+
+double Measurements::Measure(const Measurement& measurement,
+                             Breakdown* breakdown) const {
+  Breakdown unused_breakdown;
+  if (!breakdown)
+    breakdown = &unused_breakdown;
+  breakdown->clear();
   switch (measurement.type) {
     case MeasurementType::TIME_UNTIL:
       return TimeUntil(measurement.target_event);
@@ -50,6 +64,21 @@ double Measurements::Measure(const Measurement& measurement) const {
       return AvgDuration(measurement.target_event);
     case MeasurementType::PERCENTILE_DURATION:
       return Percentile(measurement.target_event, measurement.param);
+    case MeasurementType::COUNT:
+      return Count(measurement.target_event);
+    case MeasurementType::THROUGHPUT:
+      return Throughput(measurement.target_event);
+    case MeasurementType::STDDEV_DURATION:
+      return StddevDuration(measurement.target_event);
+    case MeasurementType::MIN_DURATION:
+      return MinDuration(measurement.target_event);
+    case MeasurementType::MAX_DURATION:
+      return MaxDuration(measurement.target_event);
+    case MeasurementType::HISTOGRAM_DURATION:
+      return HistogramDuration(measurement.target_event, measurement.param,
+                               breakdown);
+    case MeasurementType::PER_THREAD_DURATION:
+      return PerThreadDuration(measurement.target_event, breakdown);
     default:
       NOTREACHED();
       return double();
@@ -98,30 +127,108 @@ double Measurements::TimeBetween(const EventSpec& first_event_spec,
 }
 
 double Measurements::AvgDuration(const EventSpec& event_spec) const {
+  std::vector<double> durations = Durations(event_spec);
+  if (durations.empty())
+    return -1.0;
+
   double sum = 0.0;
+  for (double duration : durations)
+    sum += duration;
+  return sum / durations.size();
+}
+
+double Measurements::Percentile(const EventSpec& event_spec,
+                                double percentile) const {
+  DCHECK_GE(percentile, 0.0);
+  DCHECK_LE(percentile, 1.0);
+  std::vector<double> durations = Durations(event_spec);
+  if (durations.size() == 0) {
+    return -1.0;
+  }
+
+  // Nearest-rank method from:
+  // https://en.wikipedia.org/wiki/Percentile
+  double size = static_cast<double>(durations.size());
+  size_t rank = static_cast<size_t>(ceil(size * percentile));
+  size_t index = std::max(size_t{1}, rank) - 1;
+  std::nth_element(durations.begin(), durations.begin() + index,
+                   durations.end());
+  return durations[index];
+}
+
+double Measurements::Count(const EventSpec& event_spec) const {
   int count = 0;
   for (const Event& event : events_) {
-    if (event.type != EventType::COMPLETE)
-      continue;
+    if (Match(event, event_spec))
+      count++;
+  }
+  return count;
+}
 
+double Measurements::Throughput(const EventSpec& event_spec) const {
+  // Occurrences per second, from the time origin to the end of the last
+  // occurrence.
+  int count = 0;
+  base::TimeTicks last_end = time_origin_;
+  for (const Event& event : events_) {
     if (!Match(event, event_spec))
       continue;
 
-    sum += event.duration.InMillisecondsF();
-    count += 1;
+    count++;
+    last_end = std::max(last_end, event.timestamp + event.duration);
   }
+  if (!count || last_end == time_origin_)
+    return -1.0;
+  return count / (last_end - time_origin_).InSecondsF();
+}
 
-  if (!count)
+double Measurements::StddevDuration(const EventSpec& event_spec) const {
+  std::vector<double> durations = Durations(event_spec);
+  if (durations.empty())
     return -1.0;
-  return sum / count;
+  return Summarize(durations).stddev;
 }
 
-double Measurements::Percentile(const EventSpec& event_spec,
-                                double percentile) const {
-  DCHECK_GE(percentile, 0.0);
-  DCHECK_LE(percentile, 1.0);
-  std::vector<double> durations;
+double Measurements::MinDuration(const EventSpec& event_spec) const {
+  std::vector<double> durations = Durations(event_spec);
+  if (durations.empty())
+    return -1.0;
+  return *std::min_element(durations.begin(), durations.end());
+}
+
+double Measurements::MaxDuration(const EventSpec& event_spec) const {
+  std::vector<double> durations = Durations(event_spec);
+  if (durations.empty())
+    return -1.0;
+  return *std::max_element(durations.begin(), durations.end());
+}
+
+double Measurements::HistogramDuration(const EventSpec& event_spec,
+                                       double bucket_width,
+                                       Breakdown* breakdown) const {
+  DCHECK_GT(bucket_width, 0.0);
+  std::vector<double> durations = Durations(event_spec);
+  if (durations.empty())
+    return -1.0;
+
+  // Maps the indices of the non-empty buckets to their counts.
+  std::map<int64, int> buckets;
+  for (double duration : durations)
+    buckets[static_cast<int64>(floor(duration / bucket_width))]++;
+  for (const auto& bucket : buckets) {
+    breakdown->push_back(std::make_pair(
+        base::StringPrintf("%g-%gms", bucket.first * bucket_width,
+                           (bucket.first + 1) * bucket_width),
+        bucket.second));
+  }
+  return durations.size();
+}
 
+double Measurements::PerThreadDuration(const EventSpec& event_spec,
+                                       Breakdown* breakdown) const {
+  std::map<std::string, double> thread_durations;
+  double total = 0.0;
+  bool found = false;
   for (const Event& event : events_) {
     if (event.type != EventType::COMPLETE)
       continue;
@@ -129,20 +236,31 @@ double Measurements::Percentile(const EventSpec& event_spec,
     if (!Match(event, event_spec))
       continue;
 
-    durations.push_back(event.duration.InMillisecondsF());
+    double duration = event.duration.InMillisecondsF();
+    thread_durations[event.thread_id] += duration;
+    total += duration;
+    found = true;
   }
-  if (durations.size() == 0) {
+  if (!found)
     return -1.0;
-  }
 
-  // Nearest-rank method from:
-  // https://en.wikipedia.org/wiki/Percentile
-  double size = static_cast<double>(durations.size());
-  size_t rank = static_cast<size_t>(ceil(size * percentile));
-  size_t index = std::max(size_t{1}, rank) - 1;
-  std::nth_element(durations.begin(), durations.begin() + index,
-                   durations.end());
-  return durations[index];
+  breakdown->assign(thread_durations.begin(), thread_durations.end());
+  return total;
+}
+
+std::vector<double> Measurements::Durations(
+    const EventSpec& event_spec) const {
+  std::vector<double> durations;
+  for (const Event& event : events_) {
+    if (event.type != EventType::COMPLETE)
+      continue;
+
+    if (!Match(event, event_spec))
+      continue;
+
+    durations.push_back(event.duration.InMillisecondsF());
+  }
+  return durations;
 }
 
 }  // namespace benchmark
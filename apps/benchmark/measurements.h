@@ -5,6 +5,8 @@
 #ifndef APPS_BENCHMARK_MEASUREMENTS_HH_
 #define APPS_BENCHMARK_MEASUREMENTS_HH_
 
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "apps/benchmark/event.h"
@@ -30,6 +32,13 @@ enum class MeasurementType {
   TIME_BETWEEN,
   AVG_DURATION,
   PERCENTILE_DURATION,
+  COUNT,
+  THROUGHPUT,
+  STDDEV_DURATION,
+  MIN_DURATION,
+  MAX_DURATION,
+  HISTOGRAM_DURATION,
+  PER_THREAD_DURATION,
 };
 
 // Represents a single measurement to be performed on the collected trace.
@@ -53,15 +62,24 @@ struct Measurement {
   ~Measurement();
 };
 
+// Labeled parts of the result of a measurement, e.g. the buckets of a
+// histogram.
+typedef std::vector<std::pair<std::string, double>> Breakdown;
+
 class Measurements {
  public:
   Measurements(std::vector<Event> events, base::TimeTicks time_origin);
   ~Measurements();
 
-  // Performs the given measurement. Returns the result in milliseconds or -1.0
-  // if the measurement failed, e.g. because no events were matched.
+  // Performs the given measurement. Returns the result (in milliseconds for
+  // times and durations) or -1.0 if the measurement failed, e.g. because no
+  // events were matched.
   double Measure(const Measurement& measurement) const;
 
+  // Same, also storing in |breakdown| the parts of the result for
+  // measurements that have some (HISTOGRAM_DURATION, PER_THREAD_DURATION).
+  double Measure(const Measurement& measurement, Breakdown* breakdown) const;
+
  private:
   bool EarliestOccurence(const EventSpec& event_spec,
                          base::TimeTicks* earliest) const;
@@ -70,6 +88,20 @@ class Measurements {
                      const EventSpec& second_event_spec) const;
   double AvgDuration(const EventSpec& event_spec) const;
   double Percentile(const EventSpec& event_spec, double percentile) const;
+  double Count(const EventSpec& event_spec) const;
+  double Throughput(const EventSpec& event_spec) const;
+  double StddevDuration(const EventSpec& event_spec) const;
+  double MinDuration(const EventSpec& event_spec) const;
+  double MaxDuration(const EventSpec& event_spec) const;
+  double HistogramDuration(const EventSpec& event_spec,
+                           double bucket_width,
+                           Breakdown* breakdown) const;
+  double PerThreadDuration(const EventSpec& event_spec,
+                           Breakdown* breakdown) const;
+
+  // Returns the durations in milliseconds of the complete events matching
+  // |event_spec|.
+  std::vector<double> Durations(const EventSpec& event_spec) const;
 
   std::vector<Event> events_;
   base::TimeTicks time_origin_;
@@ -5,6 +5,7 @@
 #include "apps/benchmark/measurements.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -174,6 +175,91 @@ TEST_F(MeasurementsTest, MeasurePercentileDuration) {
   EXPECT_DOUBLE_EQ(0.010, reversed.Measure(measurement));
 }
 
+TEST_F(MeasurementsTest, MeasureCountAndThroughput) {
+  Measurements regular(events_, base::TimeTicks::FromInternalValue(0));
+  Measurements reversed(reversed_, base::TimeTicks::FromInternalValue(0));
+
+  EXPECT_DOUBLE_EQ(3.0, regular.Measure(Measurement(MeasurementType::COUNT,
+                                                    EventSpec("c", "some"))));
+  EXPECT_DOUBLE_EQ(
+      2.0, reversed.Measure(Measurement(MeasurementType::COUNT,
+                                        EventSpec("multi_occurence",
+                                                  "another"))));
+  EXPECT_DOUBLE_EQ(0.0, regular.Measure(Measurement(MeasurementType::COUNT,
+                                                    EventSpec("miss", "cat"))));
+
+  // 3 events, the last one ending 30us after the time origin.
+  EXPECT_DOUBLE_EQ(100000.0,
+                   regular.Measure(Measurement(MeasurementType::THROUGHPUT,
+                                               EventSpec("c", "some"))));
+  EXPECT_DOUBLE_EQ(100000.0,
+                   reversed.Measure(Measurement(MeasurementType::THROUGHPUT,
+                                                EventSpec("c", "some"))));
+}
+
+TEST_F(MeasurementsTest, MeasureDurationSpread) {
+  Measurements regular(events_, base::TimeTicks::FromInternalValue(2));
+  Measurements reversed(reversed_, base::TimeTicks::FromInternalValue(2));
+
+  EXPECT_DOUBLE_EQ(0.010,
+                   regular.Measure(Measurement(MeasurementType::MIN_DURATION,
+                                               EventSpec("c", "some"))));
+  EXPECT_DOUBLE_EQ(0.012,
+                   reversed.Measure(Measurement(MeasurementType::MAX_DURATION,
+                                                EventSpec("c", "some"))));
+  // Durations of 2us and 4us: the sample standard deviation, like Summarize().
+  EXPECT_DOUBLE_EQ(0.001 * sqrt(2.0),
+                   regular.Measure(Measurement(MeasurementType::STDDEV_DURATION,
+                                               EventSpec("a", "some"))));
+  EXPECT_DOUBLE_EQ(
+      0.0, reversed.Measure(Measurement(MeasurementType::STDDEV_DURATION,
+                                        EventSpec("a", "other"))));
+}
+
+TEST_F(MeasurementsTest, MeasureHistogramDuration) {
+  Measurements measurements(events_, base::TimeTicks::FromInternalValue(2));
+
+  Measurement measurement(MeasurementType::HISTOGRAM_DURATION,
+                          EventSpec("c", "some"));
+  measurement.param = 0.002;
+  Breakdown breakdown;
+  EXPECT_DOUBLE_EQ(3.0, measurements.Measure(measurement, &breakdown));
+  // Durations of 10us, 11us and 12us.
+  ASSERT_EQ(2u, breakdown.size());
+  EXPECT_EQ("0.01-0.012ms", breakdown[0].first);
+  EXPECT_DOUBLE_EQ(2.0, breakdown[0].second);
+  EXPECT_EQ("0.012-0.014ms", breakdown[1].first);
+  EXPECT_DOUBLE_EQ(1.0, breakdown[1].second);
+}
+
+TEST_F(MeasurementsTest, MeasurePerThreadDuration) {
+  events_[0].thread_id = "1";
+  events_[1].thread_id = "2";
+  events_[3].thread_id = "1";
+  events_[4].thread_id = "1";
+  Measurements measurements(events_, base::TimeTicks::FromInternalValue(2));
+
+  Breakdown breakdown;
+  EXPECT_DOUBLE_EQ(
+      0.006, measurements.Measure(
+                 Measurement(MeasurementType::PER_THREAD_DURATION,
+                             EventSpec("a", "some")),
+                 &breakdown));
+  ASSERT_EQ(2u, breakdown.size());
+  EXPECT_EQ("1", breakdown[0].first);
+  EXPECT_DOUBLE_EQ(0.002, breakdown[0].second);
+  EXPECT_EQ("2", breakdown[1].first);
+  EXPECT_DOUBLE_EQ(0.004, breakdown[1].second);
+
+  EXPECT_DOUBLE_EQ(
+      0.048, measurements.Measure(
+                 Measurement(MeasurementType::PER_THREAD_DURATION,
+                             EventSpec("b", "some")),
+                 &breakdown));
+  ASSERT_EQ(1u, breakdown.size());
+  EXPECT_EQ("1", breakdown[0].first);
+}
+
 TEST_F(MeasurementsTest, NoMatchingEvent) {
   // The results should be the same regardless of the order of events.
   Measurements empty(std::vector<Event>(),
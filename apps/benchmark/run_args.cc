@@ -67,6 +67,47 @@ bool GetMeasurement(const std::string& measurement_spec, Measurement* result) {
       LOG(ERROR) << "Expected '" << result->param << "' to be >=0.0 and <=1.0 "
                  << "in " << measurement_spec;
     }
+  } else if (parts[0] == "count") {
+    if (!CheckMeasurementFormat(parts[0], 3, parts.size()))
+      return false;
+    *result =
+        Measurement(MeasurementType::COUNT, EventSpec(parts[2], parts[1]));
+  } else if (parts[0] == "throughput") {
+    if (!CheckMeasurementFormat(parts[0], 3, parts.size()))
+      return false;
+    *result = Measurement(MeasurementType::THROUGHPUT,
+                          EventSpec(parts[2], parts[1]));
+  } else if (parts[0] == "stddev_duration") {
+    if (!CheckMeasurementFormat(parts[0], 3, parts.size()))
+      return false;
+    *result = Measurement(MeasurementType::STDDEV_DURATION,
+                          EventSpec(parts[2], parts[1]));
+  } else if (parts[0] == "min_duration") {
+    if (!CheckMeasurementFormat(parts[0], 3, parts.size()))
+      return false;
+    *result = Measurement(MeasurementType::MIN_DURATION,
+                          EventSpec(parts[2], parts[1]));
+  } else if (parts[0] == "max_duration") {
+    if (!CheckMeasurementFormat(parts[0], 3, parts.size()))
+      return false;
+    *result = Measurement(MeasurementType::MAX_DURATION,
+                          EventSpec(parts[2], parts[1]));
+  } else if (parts[0] == "histogram_duration") {
+    if (!CheckMeasurementFormat(parts[0], 4, parts.size()))
+      return false;
+    *result = Measurement(MeasurementType::HISTOGRAM_DURATION,
+                          EventSpec(parts[2], parts[1]));
+    if (!base::StringToDouble(parts[3], &result->param) ||
+        result->param <= 0.0) {
+      LOG(ERROR) << "Expected '" << parts[3]
+                 << "' to be a positive bucket width in: " << measurement_spec;
+      return false;
+    }
+  } else if (parts[0] == "per_thread_duration") {
+    if (!CheckMeasurementFormat(parts[0], 3, parts.size()))
+      return false;
+    *result = Measurement(MeasurementType::PER_THREAD_DURATION,
+                          EventSpec(parts[2], parts[1]));
   } else {
     LOG(ERROR) << "Could not recognize the measurement type: " << parts[0];
     return false;
@@ -104,6 +145,18 @@ bool GetRunArgs(const std::vector<std::string>& input_args, RunArgs* result) {
   }
   result->duration = base::TimeDelta::FromSeconds(duration_int);
 
+  result->iterations = 1;
+  if (command_line.HasSwitch("iterations")) {
+    std::string iterations_str =
+        command_line.GetSwitchValueASCII("iterations");
+    if (!base::StringToInt(iterations_str, &result->iterations) ||
+        result->iterations <= 0) {
+      LOG(ERROR) << "Could not parse the --iterations value as a positive "
+                 << "integer: " << iterations_str;
+      return false;
+    }
+  }
+
   result->write_output_file = false;
   if (command_line.HasSwitch("trace-output")) {
     result->write_output_file = true;
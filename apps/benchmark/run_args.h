@@ -18,6 +18,9 @@ namespace benchmark {
 struct RunArgs {
   std::string app;
   base::TimeDelta duration;
+  // How many times to run the benchmark, reporting the mean result (and a
+  // confidence interval) of each measurement.
+  int iterations;
   std::vector<Measurement> measurements;
   bool write_output_file;
   base::FilePath output_file_path;
@@ -0,0 +1,57 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "apps/benchmark/statistics.h"
+
+#include <cmath>
+
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace benchmark {
+namespace {
+
+// Two-sided 95% critical values of Student's t-distribution, indexed by the
+// degrees of freedom minus one.
+const double kStudentT95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+// Beyond the table, the normal approximation is close enough.
+const double kNormal95 = 1.960;
+
+double StudentT95(size_t degrees_of_freedom) {
+  DCHECK_GT(degrees_of_freedom, 0u);
+  if (degrees_of_freedom > arraysize(kStudentT95))
+    return kNormal95;
+  return kStudentT95[degrees_of_freedom - 1];
+}
+
+}  // namespace
+
+Summary::Summary()
+    : count(0), mean(0.0), stddev(0.0), confidence_interval(0.0) {}
+
+Summary Summarize(const std::vector<double>& values) {
+  DCHECK(!values.empty());
+  Summary summary;
+  summary.count = values.size();
+  for (double value : values)
+    summary.mean += value;
+  summary.mean /= values.size();
+  if (values.size() < 2)
+    return summary;
+
+  double sum_of_squares = 0.0;
+  for (double value : values)
+    sum_of_squares += (value - summary.mean) * (value - summary.mean);
+  summary.stddev = sqrt(sum_of_squares / (values.size() - 1));
+  summary.confidence_interval = StudentT95(values.size() - 1) *
+                                summary.stddev / sqrt(values.size());
+  return summary;
+}
+
+}  // namespace benchmark
@@ -0,0 +1,32 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef APPS_BENCHMARK_STATISTICS_H_
+#define APPS_BENCHMARK_STATISTICS_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+namespace benchmark {
+
+// Summarizes the results of a measurement over several iterations.
+struct Summary {
+  size_t count;
+  double mean;
+  // Sample standard deviation, 0 for a single result.
+  double stddev;
+  // Half-width of the 95% confidence interval of the mean, based on Student's
+  // t-distribution, 0 for a single result.
+  double confidence_interval;
+
+  Summary();
+};
+
+// Summarizes |values|, which must not be empty.
+Summary Summarize(const std::vector<double>& values);
+
+}  // namespace benchmark
+
+#endif  // APPS_BENCHMARK_STATISTICS_H_
@@ -0,0 +1,47 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "apps/benchmark/statistics.h"
+
+#include <cmath>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace benchmark {
+
+namespace {
+
+TEST(StatisticsTest, SingleValue) {
+  Summary summary = Summarize(std::vector<double>(1, 4.0));
+  EXPECT_EQ(1u, summary.count);
+  EXPECT_DOUBLE_EQ(4.0, summary.mean);
+  EXPECT_DOUBLE_EQ(0.0, summary.stddev);
+  EXPECT_DOUBLE_EQ(0.0, summary.confidence_interval);
+}
+
+TEST(StatisticsTest, Summarize) {
+  std::vector<double> values;
+  values.push_back(2.0);
+  values.push_back(4.0);
+  values.push_back(6.0);
+  Summary summary = Summarize(values);
+  EXPECT_EQ(3u, summary.count);
+  EXPECT_DOUBLE_EQ(4.0, summary.mean);
+  EXPECT_DOUBLE_EQ(2.0, summary.stddev);
+  // t(0.975, 2) * 2 / sqrt(3).
+  EXPECT_NEAR(4.968, summary.confidence_interval, 0.001);
+
+  // Many results: the normal approximation.
+  values.assign(100, 1.0);
+  values.resize(200, 3.0);
+  summary = Summarize(values);
+  EXPECT_DOUBLE_EQ(2.0, summary.mean);
+  EXPECT_NEAR(1.96 * summary.stddev / sqrt(200.0),
+              summary.confidence_interval, 1e-9);
+}
+
+}  // namespace
+
+}  // namespace benchmark
@@ -19,8 +19,7 @@ void TraceCollectorClient::Start(const std::string& categories) {
   collector_->Start(data_pipe.producer_handle.Pass(), categories);
   drainer_.reset(new mojo::common::DataPipeDrainer(
       this, data_pipe.consumer_handle.Pass()));
-  trace_data_.clear();
-  trace_data_ += "[";
+  receiver_->OnTraceDataAvailable("[", 1);
 }
 
 void TraceCollectorClient::Stop() {
@@ -30,13 +29,12 @@ void TraceCollectorClient::Stop() {
 }
 
 void TraceCollectorClient::OnDataAvailable(const void* data, size_t num_bytes) {
-  const char* chars = static_cast<const char*>(data);
-  trace_data_.append(chars, num_bytes);
+  receiver_->OnTraceDataAvailable(static_cast<const char*>(data), num_bytes);
 }
 
 void TraceCollectorClient::OnDataComplete() {
   drainer_.reset();
   collector_.reset();
-  trace_data_ += "]";
-  receiver_->OnTraceCollected(trace_data_);
+  receiver_->OnTraceDataAvailable("]", 1);
+  receiver_->OnTraceCollected();
 }
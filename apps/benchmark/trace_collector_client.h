@@ -12,14 +12,17 @@
 #include "mojo/data_pipe_utils/data_pipe_drainer.h"
 #include "mojo/services/tracing/interfaces/tracing.mojom.h"
 
-// Connects to trace collector in tracing.mojo to get traces and returns the
-// results as a single string to the receiver.
+// Connects to trace collector in tracing.mojo to get traces and passes the
+// results to the receiver as they arrive.
 class TraceCollectorClient : public mojo::common::DataPipeDrainer::Client {
  public:
   class Receiver {
    public:
-    // |trace_data| will be a JSON list of the collected trace events.
-    virtual void OnTraceCollected(std::string trace_data) = 0;
+    // Called with each piece of the trace data, which together form a JSON
+    // list of the collected trace events.
+    virtual void OnTraceDataAvailable(const char* data, size_t num_bytes) = 0;
+    // Called once all the trace data has been passed.
+    virtual void OnTraceCollected() = 0;
 
    protected:
     virtual ~Receiver() {}
@@ -40,7 +43,6 @@ class TraceCollectorClient : public mojo::common::DataPipeDrainer::Client {
   Receiver* receiver_;
   tracing::TraceCollectorPtr collector_;
   scoped_ptr<mojo::common::DataPipeDrainer> drainer_;
-  std::string trace_data_;
   bool currently_tracing_;
 
   DISALLOW_COPY_AND_ASSIGN(TraceCollectorClient);
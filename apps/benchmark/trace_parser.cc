@@ -0,0 +1,517 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "apps/benchmark/trace_parser.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/utf_string_conversion_utils.h"
+
+namespace benchmark {
+namespace {
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsScalarChar(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' ||
+         c == '+' || c == '.' || c == 'E';
+}
+
+int HexDigitValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Reads the JSON tokens of a single trace event, without building values for
+// those that aren't needed.
+class EventScanner {
+ public:
+  EventScanner(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+  // Skips whitespace, then |c| if it's next. Returns whether it was.
+  bool Consume(char c) {
+    while (pos_ != end_ && IsWhitespace(*pos_))
+      ++pos_;
+    if (pos_ == end_ || *pos_ != c)
+      return false;
+    ++pos_;
+    return true;
+  }
+
+  bool AtEnd() {
+    while (pos_ != end_ && IsWhitespace(*pos_))
+      ++pos_;
+    return pos_ == end_;
+  }
+
+  bool NextIsString() { return Peek() == '"'; }
+
+  // Reads a string, unescaping it into |output|.
+  bool ReadString(std::string* output) {
+    output->clear();
+    if (!Consume('"'))
+      return false;
+    while (pos_ != end_) {
+      const char* run_end = pos_;
+      while (run_end != end_ && *run_end != '"' && *run_end != '\\')
+        ++run_end;
+      output->append(pos_, run_end);
+      pos_ = run_end;
+      if (pos_ == end_)
+        return false;
+      if (*pos_++ == '"')
+        return true;
+      if (!ReadEscape(output))
+        return false;
+    }
+    return false;
+  }
+
+  // Reads a number, a boolean or null, as text.
+  bool ReadScalar(std::string* output) {
+    if (AtEnd() || !IsScalarChar(*pos_))
+      return false;
+    const char* begin = pos_;
+    while (pos_ != end_ && IsScalarChar(*pos_))
+      ++pos_;
+    output->assign(begin, pos_);
+    return true;
+  }
+
+  // Skips a value of any type.
+  bool SkipValue() {
+    char c = Peek();
+    if (c == '"')
+      return SkipString();
+    if (c == '{' || c == '[')
+      return SkipContainer();
+    std::string scalar;
+    return ReadScalar(&scalar);
+  }
+
+ private:
+  char Peek() { return AtEnd() ? '\0' : *pos_; }
+
+  bool ReadEscape(std::string* output) {
+    if (pos_ == end_)
+      return false;
+    switch (*pos_++) {
+      case '"':
+        output->push_back('"');
+        return true;
+      case '\\':
+        output->push_back('\\');
+        return true;
+      case '/':
+        output->push_back('/');
+        return true;
+      case 'b':
+        output->push_back('\b');
+        return true;
+      case 'f':
+        output->push_back('\f');
+        return true;
+      case 'n':
+        output->push_back('\n');
+        return true;
+      case 'r':
+        output->push_back('\r');
+        return true;
+      case 't':
+        output->push_back('\t');
+        return true;
+      case 'u': {
+        uint32 code_point;
+        if (!ReadHex4(&code_point))
+          return false;
+        // Combine surrogate pairs.
+        if (code_point >= 0xD800 && code_point <= 0xDBFF &&
+            end_ - pos_ >= 6 && pos_[0] == '\\' && pos_[1] == 'u') {
+          const char* high_end = pos_;
+          pos_ += 2;
+          uint32 low;
+          if (ReadHex4(&low) && low >= 0xDC00 && low <= 0xDFFF)
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          else
+            pos_ = high_end;
+        }
+        if (!base::IsValidCharacter(code_point))
+          code_point = 0xFFFD;
+        base::WriteUnicodeCharacter(code_point, output);
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  bool ReadHex4(uint32* value) {
+    if (end_ - pos_ < 4)
+      return false;
+    *value = 0;
+    for (int i = 0; i < 4; ++i) {
+      int digit = HexDigitValue(*pos_++);
+      if (digit < 0)
+        return false;
+      *value = (*value << 4) | digit;
+    }
+    return true;
+  }
+
+  bool SkipString() {
+    if (!Consume('"'))
+      return false;
+    while (pos_ != end_) {
+      char c = *pos_++;
+      if (c == '"')
+        return true;
+      if (c == '\\' && pos_ != end_)
+        ++pos_;
+    }
+    return false;
+  }
+
+  bool SkipContainer() {
+    char close = Peek() == '{' ? '}' : ']';
+    ++pos_;
+    if (Consume(close))
+      return true;
+    do {
+      if (close == '}' && (!SkipString() || !Consume(':')))
+        return false;
+      if (!SkipValue())
+        return false;
+    } while (Consume(','));
+    return Consume(close);
+  }
+
+  const char* pos_;
+  const char* end_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventScanner);
+};
+
+// Reads a string field, or skips the value if it has another type.
+bool ReadStringField(EventScanner* scanner, std::string* value, bool* found) {
+  if (!scanner->NextIsString())
+    return scanner->SkipValue();
+  *found = true;
+  return scanner->ReadString(value);
+}
+
+// Reads a field that may be a string or an integer, as a string.
+bool ReadIdField(EventScanner* scanner, std::string* value, bool* found) {
+  *found = true;
+  if (scanner->NextIsString())
+    return scanner->ReadString(value);
+  return scanner->ReadScalar(value);
+}
+
+// Reads a number field, or skips the value if it has another type.
+bool ReadNumberField(EventScanner* scanner, double* value, bool* found) {
+  if (scanner->NextIsString())
+    return scanner->SkipValue();
+  std::string text;
+  if (!scanner->ReadScalar(&text))
+    return false;
+  *found = base::StringToDouble(text, value);
+  return true;
+}
+
+}  // namespace
+
+TraceParser::TraceParser()
+    : state_(State::BEFORE_LIST),
+      depth_(0),
+      in_string_(false),
+      escaped_(false) {}
+
+TraceParser::~TraceParser() {}
+
+bool TraceParser::Feed(const char* data, size_t num_bytes) {
+  const char* end = data + num_bytes;
+  const char* event_begin = data;
+  for (const char* p = data; p != end; ++p) {
+    char c = *p;
+    switch (state_) {
+      case State::IN_EVENT:
+        // Find the end of the event, leaving the rest to ParseEvent().
+        if (in_string_) {
+          if (escaped_)
+            escaped_ = false;
+          else if (c == '\\')
+            escaped_ = true;
+          else if (c == '"')
+            in_string_ = false;
+        } else if (c == '"') {
+          in_string_ = true;
+        } else if (c == '{' || c == '[') {
+          depth_++;
+        } else if ((c == '}' || c == ']') && --depth_ == 0) {
+          state_ = State::AFTER_EVENT;
+          if (!OnEventText(event_begin, p + 1))
+            return Fail();
+        }
+        break;
+      case State::BEFORE_LIST:
+        if (c == '[')
+          state_ = State::LIST_START;
+        else if (!IsWhitespace(c))
+          return FormatError();
+        break;
+      case State::LIST_START:
+      case State::BEFORE_EVENT:
+        if (c == '{') {
+          state_ = State::IN_EVENT;
+          depth_ = 1;
+          event_begin = p;
+        } else if (c == ']' && state_ == State::LIST_START) {
+          state_ = State::DONE;
+        } else if (!IsWhitespace(c)) {
+          return FormatError();
+        }
+        break;
+      case State::AFTER_EVENT:
+        if (c == ',')
+          state_ = State::BEFORE_EVENT;
+        else if (c == ']')
+          state_ = State::DONE;
+        else if (!IsWhitespace(c))
+          return FormatError();
+        break;
+      case State::DONE:
+        if (!IsWhitespace(c))
+          return FormatError();
+        break;
+      case State::FAILED:
+        return false;
+    }
+  }
+  if (state_ == State::IN_EVENT)
+    pending_.append(event_begin, end);
+  return true;
+}
+
+bool TraceParser::Finish(std::vector<Event>* result) {
+  if (state_ != State::DONE)
+    return FormatError();
+
+  // Begin events that never ended are dropped.
+  std::vector<size_t> unmatched;
+  for (const auto& it : open_duration_events_)
+    unmatched.insert(unmatched.end(), it.second.begin(), it.second.end());
+  for (const auto& it : open_async_events_)
+    unmatched.insert(unmatched.end(), it.second.begin(), it.second.end());
+  std::sort(unmatched.begin(), unmatched.end());
+  size_t next_unmatched = 0;
+  result->clear();
+  result->reserve(events_.size() - unmatched.size());
+  for (size_t i = 0; i < events_.size(); ++i) {
+    if (next_unmatched < unmatched.size() && unmatched[next_unmatched] == i) {
+      next_unmatched++;
+      continue;
+    }
+    result->push_back(events_[i]);
+  }
+  events_.clear();
+  open_duration_events_.clear();
+  open_async_events_.clear();
+  return true;
+}
+
+bool TraceParser::OnEventText(const char* begin, const char* end) {
+  if (pending_.empty())
+    return ParseEvent(begin, end);
+  pending_.append(begin, end);
+  bool result = ParseEvent(pending_.data(), pending_.data() + pending_.size());
+  pending_.clear();
+  return result;
+}
+
+bool TraceParser::ParseEvent(const char* begin, const char* end) {
+  if (!ScanEvent(begin, end)) {
+    LOG(ERROR) << "Incorrect trace event (malformed JSON): "
+               << std::string(begin, end);
+    return false;
+  }
+  return AddEvent();
+}
+
+bool TraceParser::ScanEvent(const char* begin, const char* end) {
+  fields_.has_phase = false;
+  fields_.has_name = false;
+  fields_.has_thread_id = false;
+  fields_.has_id = false;
+  fields_.has_timestamp = false;
+  fields_.has_duration = false;
+  fields_.categories.clear();
+
+  EventScanner scanner(begin, end);
+  if (!scanner.Consume('{'))
+    return false;
+  if (!scanner.Consume('}')) {
+    do {
+      if (!scanner.ReadString(&key_) || !scanner.Consume(':'))
+        return false;
+      bool ok;
+      if (key_ == "ph") {
+        ok = ReadStringField(&scanner, &fields_.phase, &fields_.has_phase);
+      } else if (key_ == "name") {
+        ok = ReadStringField(&scanner, &fields_.name, &fields_.has_name);
+      } else if (key_ == "cat") {
+        // Some clients do not add categories to events, but we don't want to
+        // fail nor skip the event.
+        bool has_categories;
+        ok = ReadStringField(&scanner, &fields_.categories, &has_categories);
+      } else if (key_ == "ts") {
+        ok = ReadNumberField(&scanner, &fields_.timestamp,
+                             &fields_.has_timestamp);
+      } else if (key_ == "dur") {
+        ok = ReadNumberField(&scanner, &fields_.duration,
+                             &fields_.has_duration);
+      } else if (key_ == "tid") {
+        ok = ReadIdField(&scanner, &fields_.thread_id, &fields_.has_thread_id);
+      } else if (key_ == "id") {
+        ok = ReadIdField(&scanner, &fields_.id, &fields_.has_id);
+      } else {
+        ok = scanner.SkipValue();
+      }
+      if (!ok)
+        return false;
+    } while (scanner.Consume(','));
+    if (!scanner.Consume('}'))
+      return false;
+  }
+  return scanner.AtEnd();
+}
+
+bool TraceParser::AddEvent() {
+  if (!fields_.has_phase) {
+    LOG(ERROR) << "Incorrect trace event (missing phase)";
+    return false;
+  }
+
+  const std::string& phase = fields_.phase;
+  if (phase == "B" || phase == "E") {
+    if (!fields_.has_thread_id) {
+      LOG(ERROR) << "Incorrect trace event (missing tid)";
+      return false;
+    }
+    OpenEvents* open_events = &open_duration_events_[fields_.thread_id];
+    return phase == "B" ? RegisterEventBegin(open_events)
+                        : MergeEventEnd(open_events);
+  }
+
+  if (phase == "b" || phase == "S" || phase == "e" || phase == "F") {
+    if (!fields_.has_id) {
+      LOG(ERROR) << "Incorrect trace event (missing id)";
+      return false;
+    }
+    OpenEvents* open_events =
+        &open_async_events_[AsyncEventStackId(fields_.id, fields_.categories)];
+    return phase == "b" || phase == "S" ? RegisterEventBegin(open_events)
+                                        : MergeEventEnd(open_events);
+  }
+
+  EventType type;
+  if (phase == "X") {
+    type = EventType::COMPLETE;
+  } else if (phase == "I" || phase == "n") {
+    type = EventType::INSTANT;
+  } else {
+    // Skip all event types we do not handle.
+    return true;
+  }
+
+  if (!fields_.has_name) {
+    LOG(ERROR) << "Incorrect trace event (no name)";
+    return false;
+  }
+  if (!fields_.has_timestamp) {
+    LOG(WARNING) << "Ignoring incorrect trace event (no timestamp)";
+    return true;
+  }
+  base::TimeDelta duration;
+  if (type == EventType::COMPLETE) {
+    if (!fields_.has_duration) {
+      LOG(WARNING) << "Ignoring incorrect complete event (no duration)";
+      return true;
+    }
+    duration = base::TimeDelta::FromInternalValue(
+        static_cast<int64>(fields_.duration));
+  }
+
+  events_.push_back(Event(
+      type, fields_.name, fields_.categories,
+      base::TimeTicks::FromInternalValue(static_cast<int64>(fields_.timestamp)),
+      duration));
+  events_.back().thread_id = fields_.thread_id;
+  return true;
+}
+
+bool TraceParser::RegisterEventBegin(OpenEvents* open_events) {
+  if (!fields_.has_name) {
+    LOG(ERROR) << "Incorrect trace event (no name)";
+    return false;
+  }
+  if (!fields_.has_timestamp) {
+    LOG(ERROR) << "Incorrect trace event (no timestamp)";
+    return false;
+  }
+
+  // The begin event stands for the resulting complete event, so that events
+  // keep the order in which they began.
+  open_events->push_back(events_.size());
+  events_.push_back(Event(
+      EventType::COMPLETE, fields_.name, fields_.categories,
+      base::TimeTicks::FromInternalValue(static_cast<int64>(fields_.timestamp)),
+      base::TimeDelta()));
+  events_.back().thread_id = fields_.thread_id;
+  return true;
+}
+
+bool TraceParser::MergeEventEnd(OpenEvents* open_events) {
+  if (open_events->empty()) {
+    LOG(ERROR) << "Incorrect trace event (event end without begin).";
+    return false;
+  }
+  Event* begin_event = &events_[open_events->back()];
+  open_events->pop_back();
+
+  if (!fields_.has_timestamp) {
+    LOG(ERROR) << "Incorrect trace event (no timestamp)";
+    return false;
+  }
+  base::TimeTicks end =
+      base::TimeTicks::FromInternalValue(static_cast<int64>(fields_.timestamp));
+  if (end < begin_event->timestamp) {
+    LOG(ERROR) << "Incorrect trace event (event ends before it begins)";
+    return false;
+  }
+
+  begin_event->duration = end - begin_event->timestamp;
+  return true;
+}
+
+bool TraceParser::FormatError() {
+  LOG(ERROR) << "Incorrect format of the trace data.";
+  return Fail();
+}
+
+bool TraceParser::Fail() {
+  state_ = State::FAILED;
+  return false;
+}
+
+}  // namespace benchmark
@@ -0,0 +1,111 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef APPS_BENCHMARK_TRACE_PARSER_H_
+#define APPS_BENCHMARK_TRACE_PARSER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "apps/benchmark/event.h"
+#include "base/macros.h"
+
+namespace benchmark {
+
+// Parses a JSON list of trace events as it arrives, one piece at a time, and
+// builds the resulting Events directly: only the event being parsed is kept
+// as text, and only the fields that Events need are decoded (arguments are
+// skipped), so memory use and parse time stay proportional to the number of
+// events rather than to the size of the trace.
+//
+// See GetEvents() for the supported event types.
+class TraceParser {
+ public:
+  TraceParser();
+  ~TraceParser();
+
+  // Parses the next |num_bytes| of the trace. Returns false on error, after
+  // which the parser can't be used anymore.
+  bool Feed(const char* data, size_t num_bytes);
+
+  // Signals the end of the trace. Returns false if it is incomplete, or stores
+  // the events in |result| and returns true otherwise.
+  bool Finish(std::vector<Event>* result);
+
+ private:
+  enum class State {
+    BEFORE_LIST,
+    LIST_START,
+    BEFORE_EVENT,
+    IN_EVENT,
+    AFTER_EVENT,
+    DONE,
+    FAILED,
+  };
+
+  // The fields of the trace event being parsed.
+  struct EventFields {
+    std::string phase;
+    std::string name;
+    std::string categories;
+    std::string thread_id;
+    std::string id;
+    double timestamp;
+    double duration;
+    bool has_phase;
+    bool has_name;
+    bool has_thread_id;
+    bool has_id;
+    bool has_timestamp;
+    bool has_duration;
+  };
+
+  // ID uniquely identifying an asynchronous event stack: the event id and the
+  // categories.
+  typedef std::pair<std::string, std::string> AsyncEventStackId;
+
+  // Stacks of the indices in |events_| of the begin events not matched by an
+  // end event yet.
+  typedef std::vector<size_t> OpenEvents;
+
+  // Parses the event in [begin, end), preceded by |pending_| if not empty.
+  bool OnEventText(const char* begin, const char* end);
+  bool ParseEvent(const char* begin, const char* end);
+  // Reads the fields of the event in [begin, end) into |fields_|.
+  bool ScanEvent(const char* begin, const char* end);
+  bool AddEvent();
+  bool RegisterEventBegin(OpenEvents* open_events);
+  bool MergeEventEnd(OpenEvents* open_events);
+
+  bool FormatError();
+  bool Fail();
+
+  State state_;
+
+  // Nesting depth in the event being parsed, and whether we are in a string
+  // (and right after a backslash in it).
+  int depth_;
+  bool in_string_;
+  bool escaped_;
+
+  // The beginning of the event being parsed, if it started in a previous
+  // piece of the trace.
+  std::string pending_;
+
+  EventFields fields_;
+  std::string key_;
+
+  std::vector<Event> events_;
+  // Begin events waiting for their end, per thread for duration events.
+  std::map<std::string, OpenEvents> open_duration_events_;
+  std::map<AsyncEventStackId, OpenEvents> open_async_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceParser);
+};
+
+}  // namespace benchmark
+
+#endif  // APPS_BENCHMARK_TRACE_PARSER_H_
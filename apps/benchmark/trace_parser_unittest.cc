@@ -0,0 +1,122 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "apps/benchmark/trace_parser.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace benchmark {
+
+namespace {
+
+// Nested arguments with brackets and escaped quotes in strings, duration
+// events to join, and an instant event with escapes in its name.
+const char kTrace[] =
+    "[{\"pid\":1,\"tid\":7,\"ts\":10,\"ph\":\"B\",\"cat\":\"cc\","
+    "\"name\":\"outer\",\"args\":{\"a\":[1,{\"b\":\"}]\\\"{\"}],\"c\":null}},"
+    " {\"tid\":7,\"ts\":12,\"ph\":\"X\",\"cat\":\"cc\",\"name\":\"inner\","
+    "\"dur\":3,\"args\":{}},\n"
+    "{\"tid\":\"8\",\"ts\":13,\"ph\":\"I\",\"cat\":\"gpu\","
+    "\"name\":\"q\\\"\\u00e9\\ud83d\\ude00\\n\",\"s\":\"t\"},"
+    "{\"tid\":7,\"ts\":20,\"ph\":\"E\",\"args\":{\"x\":true}},"
+    "{\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":\"Main\"}}]";
+
+void ExpectTraceEvents(const std::vector<Event>& events) {
+  ASSERT_EQ(3u, events.size());
+
+  EXPECT_EQ(EventType::COMPLETE, events[0].type);
+  EXPECT_EQ("outer", events[0].name);
+  EXPECT_EQ("cc", events[0].categories);
+  EXPECT_EQ("7", events[0].thread_id);
+  EXPECT_EQ(base::TimeTicks::FromInternalValue(10), events[0].timestamp);
+  EXPECT_EQ(base::TimeDelta::FromInternalValue(10), events[0].duration);
+
+  EXPECT_EQ(EventType::COMPLETE, events[1].type);
+  EXPECT_EQ("inner", events[1].name);
+  EXPECT_EQ(base::TimeTicks::FromInternalValue(12), events[1].timestamp);
+  EXPECT_EQ(base::TimeDelta::FromInternalValue(3), events[1].duration);
+
+  EXPECT_EQ(EventType::INSTANT, events[2].type);
+  EXPECT_EQ("q\"\xc3\xa9\xf0\x9f\x98\x80\n", events[2].name);
+  EXPECT_EQ("gpu", events[2].categories);
+  EXPECT_EQ("8", events[2].thread_id);
+}
+
+TEST(TraceParserTest, WholeTrace) {
+  TraceParser parser;
+  std::vector<Event> events;
+  ASSERT_TRUE(parser.Feed(kTrace, strlen(kTrace)));
+  ASSERT_TRUE(parser.Finish(&events));
+  ExpectTraceEvents(events);
+}
+
+// The trace may be split anywhere, e.g. in the middle of an event or of a
+// string.
+TEST(TraceParserTest, SplitTrace) {
+  const size_t size = strlen(kTrace);
+  for (size_t split = 0; split <= size; ++split) {
+    TraceParser parser;
+    std::vector<Event> events;
+    ASSERT_TRUE(parser.Feed(kTrace, split));
+    ASSERT_TRUE(parser.Feed(kTrace + split, size - split));
+    ASSERT_TRUE(parser.Finish(&events)) << split;
+    ExpectTraceEvents(events);
+  }
+
+  TraceParser parser;
+  std::vector<Event> events;
+  for (size_t i = 0; i < size; ++i)
+    ASSERT_TRUE(parser.Feed(kTrace + i, 1));
+  ASSERT_TRUE(parser.Finish(&events));
+  ExpectTraceEvents(events);
+}
+
+TEST(TraceParserTest, UnmatchedBeginIsDropped) {
+  const char trace[] =
+      "[{\"tid\":1,\"ts\":1,\"ph\":\"B\",\"cat\":\"cc\",\"name\":\"open\"},"
+      "{\"tid\":1,\"ts\":2,\"ph\":\"B\",\"cat\":\"cc\",\"name\":\"closed\"},"
+      "{\"tid\":1,\"ts\":4,\"ph\":\"E\"},"
+      "{\"tid\":1,\"ts\":5,\"ph\":\"I\",\"cat\":\"cc\",\"name\":\"instant\"}]";
+  TraceParser parser;
+  std::vector<Event> events;
+  ASSERT_TRUE(parser.Feed(trace, strlen(trace)));
+  ASSERT_TRUE(parser.Finish(&events));
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ("closed", events[0].name);
+  EXPECT_EQ(base::TimeDelta::FromInternalValue(2), events[0].duration);
+  EXPECT_EQ("instant", events[1].name);
+}
+
+TEST(TraceParserTest, Malformed) {
+  const char* const traces[] = {
+      "",
+      "[",
+      "[{\"ph\":\"X\"",
+      "[{}",
+      "[{},]",
+      "[{}{}]",
+      "[{}] x",
+      "[{\"ph\":}]",
+      "[{\"ph\":\"I\",}]",
+      "[{\"ph\":\"I\" \"name\":\"a\"}]",
+      "[{\"ph\":\"I\",\"name\":\"\\x\"}]",
+      "[{\"ph\":\"I\",\"args\":{\"a\"]}}]",
+      "[1]",
+  };
+  for (const char* trace : traces) {
+    TraceParser parser;
+    std::vector<Event> events;
+    EXPECT_FALSE(parser.Feed(trace, strlen(trace)) && parser.Finish(&events))
+        << trace;
+  }
+}
+
+}  // namespace
+
+}  // namespace benchmark
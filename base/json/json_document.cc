@@ -0,0 +1,306 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_document.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/compiler_specific.h"
+#include "base/json/json_sax_reader.h"
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// The blocks of a document grow geometrically between these sizes; larger
+// allocations get a block of their own.
+const size_t kMinBlockSize = 4 * 1024;
+const size_t kMaxBlockSize = 4 * 1024 * 1024;
+
+}  // namespace
+
+// Builds the nodes of a document from the values reported by the reader. The
+// nodes of the open containers are kept on a stack, and copied together into
+// the document when their container ends, so that the children of each node
+// are contiguous.
+class JSONDocument::Builder : public JSONSaxHandler {
+ public:
+  explicit Builder(JSONDocument* document) : document_(document) {}
+  ~Builder() override {}
+
+  // Returns the root node, once the whole document has been parsed.
+  const Node* Finish() {
+    DCHECK_EQ(1u, nodes_.size());
+    DCHECK(container_starts_.empty());
+    Node* root =
+        static_cast<Node*>(document_->Allocate(sizeof(Node), ALIGNOF(Node)));
+    *root = nodes_[0];
+    return root;
+  }
+
+  // |JSONSaxHandler|:
+  bool OnNull() override {
+    nodes_.push_back(MakeNode(Value::TYPE_NULL));
+    return true;
+  }
+
+  bool OnBoolean(bool value) override {
+    Node node = MakeNode(Value::TYPE_BOOLEAN);
+    node.boolean_ = value;
+    nodes_.push_back(node);
+    return true;
+  }
+
+  bool OnInteger(int value) override {
+    Node node = MakeNode(Value::TYPE_INTEGER);
+    node.integer_ = value;
+    nodes_.push_back(node);
+    return true;
+  }
+
+  bool OnDouble(double value) override {
+    Node node = MakeNode(Value::TYPE_DOUBLE);
+    node.double_ = value;
+    nodes_.push_back(node);
+    return true;
+  }
+
+  bool OnString(const StringPiece& value) override { return AddString(value); }
+
+  bool OnStartDictionary() override {
+    container_starts_.push_back(nodes_.size());
+    return true;
+  }
+
+  bool OnKey(const StringPiece& key) override { return AddString(key); }
+
+  bool OnEndDictionary() override {
+    return EndContainer(Value::TYPE_DICTIONARY);
+  }
+
+  bool OnStartList() override {
+    container_starts_.push_back(nodes_.size());
+    return true;
+  }
+
+  bool OnEndList() override { return EndContainer(Value::TYPE_LIST); }
+
+ private:
+  static Node MakeNode(Value::Type type) {
+    Node node;
+    memset(&node, 0, sizeof(node));
+    node.type_ = static_cast<uint8>(type);
+    return node;
+  }
+
+  bool AddString(const StringPiece& value) {
+    if (value.size() > kuint32max)
+      return false;
+    Node node = MakeNode(Value::TYPE_STRING);
+    node.size_ = static_cast<uint32>(value.size());
+    char* string = static_cast<char*>(document_->Allocate(value.size(), 1));
+    memcpy(string, value.data(), value.size());
+    node.string_ = string;
+    nodes_.push_back(node);
+    return true;
+  }
+
+  bool EndContainer(Value::Type type) {
+    const size_t start = container_starts_.back();
+    container_starts_.pop_back();
+    const size_t num_children = nodes_.size() - start;
+    if (num_children > kuint32max)
+      return false;
+
+    Node node = MakeNode(type);
+    // Dictionaries have a key node and a value node per member.
+    node.size_ = static_cast<uint32>(
+        type == Value::TYPE_DICTIONARY ? num_children / 2 : num_children);
+    if (num_children) {
+      Node* children = static_cast<Node*>(document_->Allocate(
+          num_children * sizeof(Node), ALIGNOF(Node)));
+      std::copy(nodes_.begin() + start, nodes_.end(), children);
+      node.children_ = children;
+    }
+    nodes_.resize(start);
+    nodes_.push_back(node);
+    return true;
+  }
+
+  JSONDocument* const document_;
+
+  // The nodes of the open containers, and of the root once it is parsed.
+  std::vector<Node> nodes_;
+  // Index in |nodes_| of the first child of each open container.
+  std::vector<size_t> container_starts_;
+
+  DISALLOW_COPY_AND_ASSIGN(Builder);
+};
+
+// JSONDocument::Node //////////////////////////////////////////////////////////
+
+bool JSONDocument::Node::GetAsBoolean(bool* out_value) const {
+  if (!IsType(Value::TYPE_BOOLEAN))
+    return false;
+  *out_value = boolean_;
+  return true;
+}
+
+bool JSONDocument::Node::GetAsInteger(int* out_value) const {
+  if (!IsType(Value::TYPE_INTEGER))
+    return false;
+  *out_value = integer_;
+  return true;
+}
+
+bool JSONDocument::Node::GetAsDouble(double* out_value) const {
+  if (IsType(Value::TYPE_INTEGER)) {
+    *out_value = integer_;
+    return true;
+  }
+  if (!IsType(Value::TYPE_DOUBLE))
+    return false;
+  *out_value = double_;
+  return true;
+}
+
+bool JSONDocument::Node::GetAsString(StringPiece* out_value) const {
+  if (!IsType(Value::TYPE_STRING))
+    return false;
+  *out_value = StringPiece(string_, size_);
+  return true;
+}
+
+size_t JSONDocument::Node::size() const {
+  if (!IsType(Value::TYPE_LIST) && !IsType(Value::TYPE_DICTIONARY))
+    return 0;
+  return size_;
+}
+
+const JSONDocument::Node& JSONDocument::Node::GetListItem(size_t index) const {
+  DCHECK(IsType(Value::TYPE_LIST));
+  DCHECK_LT(index, size_);
+  return children_[index];
+}
+
+StringPiece JSONDocument::Node::GetKey(size_t index) const {
+  DCHECK(IsType(Value::TYPE_DICTIONARY));
+  DCHECK_LT(index, size_);
+  const Node& key = children_[2 * index];
+  return StringPiece(key.string_, key.size_);
+}
+
+const JSONDocument::Node& JSONDocument::Node::GetValue(size_t index) const {
+  DCHECK(IsType(Value::TYPE_DICTIONARY));
+  DCHECK_LT(index, size_);
+  return children_[2 * index + 1];
+}
+
+const JSONDocument::Node* JSONDocument::Node::FindKey(
+    const StringPiece& key) const {
+  if (!IsType(Value::TYPE_DICTIONARY))
+    return NULL;
+  for (size_t i = size_; i > 0; --i) {
+    if (GetKey(i - 1) == key)
+      return &GetValue(i - 1);
+  }
+  return NULL;
+}
+
+scoped_ptr<Value> JSONDocument::Node::CreateValue() const {
+  switch (type()) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return make_scoped_ptr(new FundamentalValue(boolean_));
+    case Value::TYPE_INTEGER:
+      return make_scoped_ptr(new FundamentalValue(integer_));
+    case Value::TYPE_DOUBLE:
+      return make_scoped_ptr(new FundamentalValue(double_));
+    case Value::TYPE_STRING:
+      return make_scoped_ptr(new StringValue(std::string(string_, size_)));
+    case Value::TYPE_LIST: {
+      scoped_ptr<ListValue> list(new ListValue);
+      for (size_t i = 0; i < size_; ++i)
+        list->Append(GetListItem(i).CreateValue());
+      return list.Pass();
+    }
+    case Value::TYPE_DICTIONARY: {
+      scoped_ptr<DictionaryValue> dictionary(new DictionaryValue);
+      for (size_t i = 0; i < size_; ++i) {
+        dictionary->SetWithoutPathExpansion(GetKey(i).as_string(),
+                                            GetValue(i).CreateValue());
+      }
+      return dictionary.Pass();
+    }
+    default:
+      NOTREACHED();
+      return scoped_ptr<Value>();
+  }
+}
+
+// JSONDocument ////////////////////////////////////////////////////////////////
+
+JSONDocument::JSONDocument()
+    : allocated_size_(0), free_begin_(NULL), free_end_(NULL), root_(NULL) {
+}
+
+JSONDocument::~JSONDocument() {
+  for (size_t i = 0; i < blocks_.size(); ++i)
+    delete[] blocks_[i];
+}
+
+// static
+scoped_ptr<JSONDocument> JSONDocument::Parse(const StringPiece& json) {
+  return Parse(json, JSON_PARSE_RFC, NULL, NULL);
+}
+
+// static
+scoped_ptr<JSONDocument> JSONDocument::Parse(const StringPiece& json,
+                                             int options,
+                                             int* error_code_out,
+                                             std::string* error_msg_out) {
+  scoped_ptr<JSONDocument> document(new JSONDocument);
+  Builder builder(document.get());
+  JSONSaxReader reader(options);
+  if (!reader.Parse(json, &builder)) {
+    if (error_code_out)
+      *error_code_out = reader.error_code();
+    if (error_msg_out)
+      *error_msg_out = reader.GetErrorMessage();
+    return scoped_ptr<JSONDocument>();
+  }
+  document->root_ = builder.Finish();
+  return document.Pass();
+}
+
+size_t JSONDocument::GetMemoryUsage() const {
+  return allocated_size_;
+}
+
+void* JSONDocument::Allocate(size_t size, size_t alignment) {
+  DCHECK(alignment && !(alignment & (alignment - 1)));
+  // Blocks are allocated with new[], so are aligned for any type.
+  DCHECK_LE(alignment, ALIGNOF(double));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(free_begin_);
+  begin = (begin + alignment - 1) & ~(alignment - 1);
+  if (!free_begin_ || begin + size > reinterpret_cast<uintptr_t>(free_end_)) {
+    const size_t block_size = std::max(
+        size, std::min(kMaxBlockSize, std::max(kMinBlockSize,
+                                               allocated_size_)));
+    char* block = new char[block_size];
+    blocks_.push_back(block);
+    allocated_size_ += block_size;
+    free_begin_ = block;
+    free_end_ = block + block_size;
+    begin = reinterpret_cast<uintptr_t>(block);
+  }
+  free_begin_ = reinterpret_cast<char*>(begin + size);
+  return reinterpret_cast<void*>(begin);
+}
+
+}  // namespace base
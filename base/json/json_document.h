@@ -0,0 +1,135 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// An immutable, in-memory JSON document. It is parsed with JSONSaxReader,
+// so it accepts the same inputs as JSONReader, but instead of a tree of
+// individually allocated base::Values, all its nodes and strings are packed
+// in a few large blocks owned by the document. This makes building, reading
+// and freeing it much cheaper, and it takes less memory; in exchange it can't
+// be modified, and its nodes can't outlive it.
+//
+// Example:
+//   scoped_ptr<JSONDocument> document = JSONDocument::Parse(json);
+//   if (!document)
+//     return;
+//   const JSONDocument::Node* events = document->root().FindKey("events");
+//   for (size_t i = 0; events && i < events->size(); ++i) {
+//     const JSONDocument::Node* name = events->GetListItem(i).FindKey("name");
+//     StringPiece name_string;
+//     if (name && name->GetAsString(&name_string))
+//       ...
+//   }
+
+#ifndef BASE_JSON_JSON_DOCUMENT_H_
+#define BASE_JSON_JSON_DOCUMENT_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+class BASE_EXPORT JSONDocument {
+ public:
+  // A value of the document. Nodes are only accessed by reference or pointer,
+  // and are valid as long as their document.
+  class BASE_EXPORT Node {
+   public:
+    Value::Type type() const { return static_cast<Value::Type>(type_); }
+    bool IsType(Value::Type type) const { return type == this->type(); }
+
+    // These follow the base::Value getters: they return false if the node
+    // isn't of the requested type, except that GetAsDouble() also accepts
+    // integers.
+    bool GetAsBoolean(bool* out_value) const;
+    bool GetAsInteger(int* out_value) const;
+    bool GetAsDouble(double* out_value) const;
+    // |out_value| points into the document.
+    bool GetAsString(StringPiece* out_value) const;
+
+    // Returns the number of items of a list, or members of a dictionary; 0
+    // for any other type.
+    size_t size() const;
+
+    // Returns the item of a list at |index|, which must be less than size().
+    const Node& GetListItem(size_t index) const;
+
+    // Return the key and value of the member of a dictionary at |index|,
+    // which must be less than size(). Members are in document order.
+    StringPiece GetKey(size_t index) const;
+    const Node& GetValue(size_t index) const;
+
+    // Returns the value of the member of a dictionary called |key| (the last
+    // one if there are several, like DictionaryValue), or NULL if there is
+    // none or this isn't a dictionary. This is a linear search.
+    const Node* FindKey(const StringPiece& key) const;
+
+    // Returns a deep copy of this node as a base::Value, for code which needs
+    // one.
+    scoped_ptr<Value> CreateValue() const;
+
+   private:
+    friend class JSONDocument;
+
+    uint8 type_;
+    // Length of a string, or number of items of a list or of members of a
+    // dictionary.
+    uint32 size_;
+    union {
+      bool boolean_;
+      int integer_;
+      double double_;
+      const char* string_;
+      // The items of a list, or the keys and values of a dictionary
+      // alternately.
+      const Node* children_;
+    };
+  };
+
+  ~JSONDocument();
+
+  // Parses |json| with the given JSONParserOptions (see JSONReader). Returns
+  // NULL if |json| isn't a valid JSON document, with an error code and a
+  // human-readable message in |error_code_out| and |error_msg_out| if they
+  // are not NULL.
+  static scoped_ptr<JSONDocument> Parse(const StringPiece& json);
+  static scoped_ptr<JSONDocument> Parse(const StringPiece& json,
+                                        int options,
+                                        int* error_code_out,
+                                        std::string* error_msg_out);
+
+  const Node& root() const { return *root_; }
+
+  // Returns the memory used by the document.
+  size_t GetMemoryUsage() const;
+
+ private:
+  class Builder;
+
+  JSONDocument();
+
+  // Returns |size| bytes aligned on |alignment|, which live as long as the
+  // document.
+  void* Allocate(size_t size, size_t alignment);
+
+  // Blocks of memory holding the nodes and strings, and the free part of the
+  // last one.
+  std::vector<char*> blocks_;
+  size_t allocated_size_;
+  char* free_begin_;
+  char* free_end_;
+
+  const Node* root_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONDocument);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_DOCUMENT_H_
@@ -0,0 +1,157 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_document.h"
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(JSONDocumentTest, Read) {
+  scoped_ptr<JSONDocument> document = JSONDocument::Parse(
+      "{\"null\": null, \"bool\": true, \"int\": 42, \"double\": 4.5,"
+      " \"string\": \"a\\nb\", \"list\": [1, \"two\", [], {}],"
+      " \"dict\": {\"key\": \"value\"}}");
+  ASSERT_TRUE(document);
+  const JSONDocument::Node& root = document->root();
+  EXPECT_EQ(Value::TYPE_DICTIONARY, root.type());
+  ASSERT_EQ(7u, root.size());
+  EXPECT_EQ("null", root.GetKey(0));
+  EXPECT_EQ("dict", root.GetKey(6));
+  EXPECT_FALSE(root.FindKey("missing"));
+
+  const JSONDocument::Node* node = root.FindKey("null");
+  ASSERT_TRUE(node);
+  EXPECT_TRUE(node->IsType(Value::TYPE_NULL));
+  EXPECT_EQ(node, &root.GetValue(0));
+
+  bool bool_value = false;
+  ASSERT_TRUE(root.FindKey("bool"));
+  EXPECT_TRUE(root.FindKey("bool")->GetAsBoolean(&bool_value));
+  EXPECT_TRUE(bool_value);
+
+  int int_value = 0;
+  double double_value = 0;
+  node = root.FindKey("int");
+  ASSERT_TRUE(node);
+  EXPECT_TRUE(node->GetAsInteger(&int_value));
+  EXPECT_EQ(42, int_value);
+  EXPECT_TRUE(node->GetAsDouble(&double_value));
+  EXPECT_EQ(42.0, double_value);
+  EXPECT_FALSE(node->GetAsBoolean(&bool_value));
+
+  node = root.FindKey("double");
+  ASSERT_TRUE(node);
+  EXPECT_FALSE(node->GetAsInteger(&int_value));
+  EXPECT_TRUE(node->GetAsDouble(&double_value));
+  EXPECT_EQ(4.5, double_value);
+
+  StringPiece string_value;
+  node = root.FindKey("string");
+  ASSERT_TRUE(node);
+  EXPECT_TRUE(node->GetAsString(&string_value));
+  EXPECT_EQ("a\nb", string_value);
+  EXPECT_EQ(0u, node->size());
+
+  node = root.FindKey("list");
+  ASSERT_TRUE(node);
+  ASSERT_EQ(4u, node->size());
+  EXPECT_TRUE(node->GetListItem(0).GetAsInteger(&int_value));
+  EXPECT_EQ(1, int_value);
+  EXPECT_TRUE(node->GetListItem(1).GetAsString(&string_value));
+  EXPECT_EQ("two", string_value);
+  EXPECT_TRUE(node->GetListItem(2).IsType(Value::TYPE_LIST));
+  EXPECT_EQ(0u, node->GetListItem(2).size());
+  EXPECT_TRUE(node->GetListItem(3).IsType(Value::TYPE_DICTIONARY));
+  EXPECT_EQ(0u, node->GetListItem(3).size());
+  EXPECT_FALSE(node->FindKey("two"));
+
+  node = root.FindKey("dict");
+  ASSERT_TRUE(node);
+  ASSERT_TRUE(node->FindKey("key"));
+  EXPECT_TRUE(node->FindKey("key")->GetAsString(&string_value));
+  EXPECT_EQ("value", string_value);
+
+  EXPECT_GT(document->GetMemoryUsage(), 0u);
+}
+
+TEST(JSONDocumentTest, DuplicateKeys) {
+  // The last member wins, like in a DictionaryValue.
+  scoped_ptr<JSONDocument> document =
+      JSONDocument::Parse("{\"a\": 1, \"b\": 2, \"a\": 3}");
+  ASSERT_TRUE(document);
+  EXPECT_EQ(3u, document->root().size());
+  int value = 0;
+  ASSERT_TRUE(document->root().FindKey("a"));
+  EXPECT_TRUE(document->root().FindKey("a")->GetAsInteger(&value));
+  EXPECT_EQ(3, value);
+}
+
+TEST(JSONDocumentTest, Errors) {
+  EXPECT_FALSE(JSONDocument::Parse("[1, 2"));
+
+  int error_code = JSONReader::JSON_NO_ERROR;
+  std::string error_message;
+  EXPECT_FALSE(JSONDocument::Parse("[1,]", JSON_PARSE_RFC, &error_code,
+                                   &error_message));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, error_code);
+  EXPECT_EQ("Line: 1, column: 4, " +
+                JSONReader::ErrorCodeToString(JSONReader::JSON_TRAILING_COMMA),
+            error_message);
+  EXPECT_TRUE(JSONDocument::Parse("[1,]", JSON_ALLOW_TRAILING_COMMAS, NULL,
+                                  NULL));
+}
+
+// Documents which need several blocks of memory, and containers and strings
+// larger than a block.
+TEST(JSONDocumentTest, Large) {
+  std::string json = "[";
+  for (int i = 0; i < 100000; ++i)
+    json.append("{\"id\": 1234, \"name\": \"some name\"},");
+  json.append("\"");
+  json.append(8 * 1024 * 1024, 'x');
+  json.append("\"]");
+
+  scoped_ptr<JSONDocument> document = JSONDocument::Parse(json);
+  ASSERT_TRUE(document);
+  const JSONDocument::Node& root = document->root();
+  ASSERT_EQ(100001u, root.size());
+  StringPiece name;
+  ASSERT_TRUE(root.GetListItem(99999).FindKey("name"));
+  EXPECT_TRUE(root.GetListItem(99999).FindKey("name")->GetAsString(&name));
+  EXPECT_EQ("some name", name);
+  StringPiece large_string;
+  EXPECT_TRUE(root.GetListItem(100000).GetAsString(&large_string));
+  EXPECT_EQ(8u * 1024 * 1024, large_string.size());
+}
+
+// A document has the same contents as the Value JSONReader reads.
+TEST(JSONDocumentTest, SameAsJSONReader) {
+  const char* const kInputs[] = {
+      "null",
+      "[true, false, -0, 12, -12, 2147483648, 1.5e3, 0.25]",
+      "\"\\u00e9\\t\\\"quoted\\\" <tag> \xE2\x82\xAC\"",
+      "{\"a\": {\"b\": [1, {\"c\": \"d\"}]}, \"e\": [], \"f\": {}}",
+      "{\"a.b\": 1, \"a\": 2, \"a\": 3}",
+      "/* comment */ [1, // comment\n 2]",
+      "[1, 2,]",
+      "{\"key\": }",
+      "[\"\\uD834\\uDD1E\", \"\\x41\"]",
+  };
+  for (size_t i = 0; i < arraysize(kInputs); ++i) {
+    SCOPED_TRACE(kInputs[i]);
+    scoped_ptr<Value> expected = JSONReader::Read(kInputs[i]);
+    scoped_ptr<JSONDocument> document = JSONDocument::Parse(kInputs[i]);
+    ASSERT_EQ(!!expected, !!document);
+    if (!expected)
+      continue;
+    EXPECT_TRUE(expected->Equals(document->root().CreateValue().get()));
+  }
+}
+
+}  // namespace base
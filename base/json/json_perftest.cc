@@ -0,0 +1,159 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the throughput of JSONReader, JSONDocument and JSONSaxReader (and
+// of JSONWriter) on trace-like documents of 1 KB to 500 MB.
+
+#include <string>
+
+#include "base/json/json_document.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_sax_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+// Each measurement parses at least this many bytes, repeating small inputs.
+const size_t kMinBytesPerMeasurement = 64 * 1024 * 1024;
+
+// Counts the values of a document, which is about the least work a SAX
+// handler can do.
+class CountingHandler : public JSONSaxHandler {
+ public:
+  CountingHandler() : num_values_(0) {}
+  ~CountingHandler() override {}
+
+  size_t num_values() const { return num_values_; }
+
+  bool OnNull() override { return Count(); }
+  bool OnBoolean(bool value) override { return Count(); }
+  bool OnInteger(int value) override { return Count(); }
+  bool OnDouble(double value) override { return Count(); }
+  bool OnString(const StringPiece& value) override { return Count(); }
+  bool OnStartDictionary() override { return Count(); }
+  bool OnKey(const StringPiece& key) override { return true; }
+  bool OnEndDictionary() override { return true; }
+  bool OnStartList() override { return Count(); }
+  bool OnEndList() override { return true; }
+
+ private:
+  bool Count() {
+    ++num_values_;
+    return true;
+  }
+
+  size_t num_values_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingHandler);
+};
+
+// Returns a trace of about |num_bytes| bytes, like the ones the benchmark app
+// parses: mostly ASCII, with a few escapes and non-ASCII characters.
+std::string MakeTrace(size_t num_bytes) {
+  std::string json = "{\"traceEvents\":[";
+  for (int i = 0; json.size() < num_bytes; ++i) {
+    if (i)
+      json.push_back(',');
+    StringAppendF(&json,
+                  "{\"name\":\"MessageLoop::RunTask %d\",\"cat\":\"toplevel\","
+                  "\"ph\":\"X\",\"ts\":%d.%03d,\"dur\":%d,\"pid\":1234,"
+                  "\"tid\":%d,\"args\":{\"src_file\":\"../../base/"
+                  "message_loop/message_loop.cc\",\"src_func\":\"Post\\\"Task"
+                  "\\\"\",\"label\":\"caf\xC3\xA9\",\"nested\":%s}}",
+                  i, i * 10, i % 1000, i % 97, i % 8,
+                  i % 2 ? "true" : "null");
+  }
+  json.append("],\"displayTimeUnit\":\"ns\"}");
+  return json;
+}
+
+std::string SizeToString(size_t num_bytes) {
+  if (num_bytes >= 1024 * 1024)
+    return SizeTToString(num_bytes / (1024 * 1024)) + "MB";
+  return SizeTToString(num_bytes / 1024) + "KB";
+}
+
+void PrintThroughput(const std::string& measurement,
+                     size_t num_bytes,
+                     const std::string& parser,
+                     size_t total_bytes,
+                     TimeDelta elapsed) {
+  perf_test::PrintResult(
+      measurement, "_" + SizeToString(num_bytes), parser,
+      total_bytes / (1024.0 * 1024.0) / elapsed.InSecondsF(), "MB/s", true);
+}
+
+void RunParsers(size_t num_bytes) {
+  const std::string json = MakeTrace(num_bytes);
+  const size_t iterations =
+      std::max<size_t>(1, kMinBytesPerMeasurement / json.size());
+  const size_t total_bytes = iterations * json.size();
+
+  scoped_ptr<Value> value;
+  TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i) {
+    value = JSONReader::Read(json);
+    ASSERT_TRUE(value);
+  }
+  PrintThroughput("json_parse", num_bytes, "JSONReader", total_bytes,
+                  TimeTicks::Now() - start);
+
+  scoped_ptr<JSONDocument> document;
+  start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i) {
+    document = JSONDocument::Parse(json);
+    ASSERT_TRUE(document);
+  }
+  PrintThroughput("json_parse", num_bytes, "JSONDocument", total_bytes,
+                  TimeTicks::Now() - start);
+  EXPECT_TRUE(value->Equals(document->root().CreateValue().get()));
+  perf_test::PrintResult("json_memory", "_" + SizeToString(num_bytes),
+                         "JSONDocument",
+                         document->GetMemoryUsage() /
+                             static_cast<double>(json.size()),
+                         "bytes/input_byte", true);
+  document.reset();
+
+  start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i) {
+    CountingHandler handler;
+    JSONSaxReader reader(JSON_PARSE_RFC);
+    ASSERT_TRUE(reader.Parse(json, &handler));
+  }
+  PrintThroughput("json_parse", num_bytes, "JSONSaxReader", total_bytes,
+                  TimeTicks::Now() - start);
+
+  std::string written;
+  start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i)
+    ASSERT_TRUE(JSONWriter::Write(*value, &written));
+  PrintThroughput("json_write", num_bytes, "JSONWriter",
+                  iterations * written.size(), TimeTicks::Now() - start);
+}
+
+}  // namespace
+
+TEST(JSONPerfTest, Parse) {
+  const size_t kSizes[] = {1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+  for (size_t i = 0; i < arraysize(kSizes); ++i)
+    RunParsers(kSizes[i]);
+}
+
+// JSONReader needs several GB of memory for these.
+TEST(JSONPerfTest, DISABLED_ParseHuge) {
+  const size_t kSizes[] = {128 * 1024 * 1024, 500 * 1024 * 1024};
+  for (size_t i = 0; i < arraysize(kSizes); ++i)
+    RunParsers(kSizes[i]);
+}
+
+}  // namespace base
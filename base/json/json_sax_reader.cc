@@ -0,0 +1,491 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_sax_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/json/json_string_scan.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversion_utils.h"
+#include "base/third_party/icu/icu_utf.h"
+
+namespace base {
+
+namespace {
+
+// Same as JSONReader.
+const int kStackMaxDepth = 100;
+
+// Numbers with at most this many digits (and no fraction or exponent) are
+// converted without overflowing an int64, and without strtod().
+const int kMaxFastIntegerDigits = 18;
+
+// Reads the |num_digits| hex digits at |pos|.
+bool ReadHexDigits(const char* pos, int num_digits, uint32* value) {
+  *value = 0;
+  for (int i = 0; i < num_digits; ++i) {
+    if (!IsHexDigit(pos[i]))
+      return false;
+    *value = (*value << 4) | HexDigitToInt(pos[i]);
+  }
+  return true;
+}
+
+// Appends |code_point| to |dest| as UTF-8.
+void AppendCodePoint(uint32 code_point, std::string* dest) {
+  char units[CBU8_MAX_LENGTH];
+  int offset = 0;
+  CBU8_APPEND_UNSAFE(units, offset, code_point);
+  dest->append(units, offset);
+}
+
+}  // namespace
+
+JSONSaxReader::JSONSaxReader(int options)
+    : options_(options),
+      start_(NULL),
+      pos_(NULL),
+      end_(NULL),
+      line_number_(0),
+      last_line_(NULL),
+      error_code_(JSONReader::JSON_NO_ERROR),
+      error_line_(0),
+      error_column_(0) {
+}
+
+JSONSaxReader::~JSONSaxReader() {
+}
+
+bool JSONSaxReader::Parse(const StringPiece& json, JSONSaxHandler* handler) {
+  start_ = json.data();
+  pos_ = start_;
+  end_ = start_ + json.length();
+  line_number_ = 1;
+  last_line_ = start_;
+  error_code_ = JSONReader::JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+
+  // Skip a UTF-8 Byte-Order-Mark, like JSONReader.
+  if (json.starts_with("\xEF\xBB\xBF"))
+    pos_ += 3;
+
+  // Whether each open container is a dictionary (or a list).
+  bool in_dictionary[kStackMaxDepth];
+  int depth = 0;
+
+  SkipWhitespace();
+  for (;;) {
+    // |pos_| is at the start of a value.
+    if (pos_ == end_)
+      return ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, 1);
+    switch (*pos_) {
+      case '{':
+      case '[': {
+        // JSONReader counts the container being opened.
+        if (depth + 1 >= kStackMaxDepth)
+          return ReportError(JSONReader::JSON_TOO_MUCH_NESTING, 1);
+        const bool is_dictionary = *pos_ == '{';
+        ++pos_;
+        if (!(is_dictionary ? handler->OnStartDictionary()
+                            : handler->OnStartList())) {
+          return false;
+        }
+        in_dictionary[depth++] = is_dictionary;
+        SkipWhitespace();
+        // An empty container is closed below, like any other.
+        if (pos_ < end_ && *pos_ == (is_dictionary ? '}' : ']'))
+          break;
+        if (is_dictionary && !ParseKey(handler))
+          return false;
+        // Parse the first element.
+        continue;
+      }
+      case '"': {
+        StringPiece value;
+        if (!ParseString(&value))
+          return false;
+        if (!handler->OnString(value))
+          return false;
+        break;
+      }
+      case '-':
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+        if (!ParseNumber(handler))
+          return false;
+        break;
+      case 't':
+      case 'f':
+      case 'n':
+        if (!ParseLiteral(handler))
+          return false;
+        break;
+      default:
+        return ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, 1);
+    }
+
+    // A value was just parsed (or a container opened empty). Close the
+    // containers which end here, up to the start of the next value.
+    for (;;) {
+      SkipWhitespace();
+      if (depth == 0) {
+        if (pos_ != end_)
+          return ReportError(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, 1);
+        return true;
+      }
+
+      const bool is_dictionary = in_dictionary[depth - 1];
+      const char end_char = is_dictionary ? '}' : ']';
+      if (pos_ < end_ && *pos_ == ',') {
+        ++pos_;
+        SkipWhitespace();
+        if (pos_ == end_ || *pos_ != end_char) {
+          if (is_dictionary && !ParseKey(handler))
+            return false;
+          break;
+        }
+        if (!(options_ & JSON_ALLOW_TRAILING_COMMAS))
+          return ReportError(JSONReader::JSON_TRAILING_COMMA, 1);
+      }
+      // JSONReader reports this one column further left in dictionaries.
+      if (pos_ == end_ || *pos_ != end_char) {
+        return ReportError(JSONReader::JSON_SYNTAX_ERROR,
+                           is_dictionary ? 0 : 1);
+      }
+      ++pos_;
+      --depth;
+      if (!(is_dictionary ? handler->OnEndDictionary() : handler->OnEndList()))
+        return false;
+    }
+  }
+}
+
+std::string JSONSaxReader::GetErrorMessage() const {
+  const std::string description = JSONReader::ErrorCodeToString(error_code_);
+  if (error_code_ == JSONReader::JSON_NO_ERROR)
+    return description;
+  return StringPrintf("Line: %i, column: %i, %s", error_line_, error_column_,
+                      description.c_str());
+}
+
+void JSONSaxReader::SkipWhitespace() {
+  while (pos_ < end_) {
+    switch (*pos_) {
+      case '\r':
+      case '\n':
+        last_line_ = pos_;
+        // Don't count "\r\n" as two line breaks.
+        if (!(*pos_ == '\n' && pos_ > start_ && pos_[-1] == '\r'))
+          ++line_number_;
+        ++pos_;
+        break;
+      case ' ':
+      case '\t':
+        ++pos_;
+        break;
+      case '/':
+        ++pos_;
+        if (pos_ == end_)
+          return;
+        if (*pos_ == '/') {
+          // Single line comment, up to the end of the line.
+          ++pos_;
+          while (pos_ < end_ && *pos_ != '\n' && *pos_ != '\r')
+            ++pos_;
+        } else if (*pos_ == '*') {
+          // Block comment, up to the end marker. An unterminated one runs to
+          // the end of the input.
+          const char* comment_end = end_;
+          for (const char* p = pos_ + 1; p + 1 < end_; ++p) {
+            if (p[0] == '*' && p[1] == '/') {
+              comment_end = p + 2;
+              break;
+            }
+          }
+          pos_ = comment_end;
+        } else {
+          // Not a comment: the slash is dropped, and the next character is
+          // taken as the next token, like JSONReader does.
+          return;
+        }
+        break;
+      default:
+        return;
+    }
+  }
+}
+
+bool JSONSaxReader::ParseKey(JSONSaxHandler* handler) {
+  if (pos_ == end_ || *pos_ != '"')
+    return ReportError(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, 1);
+  StringPiece key;
+  if (!ParseString(&key))
+    return false;
+  if (!handler->OnKey(key))
+    return false;
+  SkipWhitespace();
+  if (pos_ == end_ || *pos_ != ':')
+    return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+  ++pos_;
+  SkipWhitespace();
+  return true;
+}
+
+bool JSONSaxReader::ParseString(StringPiece* value) {
+  DCHECK_EQ('"', *pos_);
+  ++pos_;
+  const char* const string_start = pos_;
+  // Beginning of the characters not yet appended to |string_buffer_|, once
+  // an escape sequence has been seen.
+  const char* run_start = NULL;
+
+  for (;;) {
+    pos_ += internal::ScanJSONStringRun(pos_, end_ - pos_, false);
+    if (pos_ == end_) {
+      // JSONReader reports this past the end of the input, unless the string
+      // is empty.
+      return ReportError(JSONReader::JSON_SYNTAX_ERROR,
+                         pos_ == string_start ? 0 : 1);
+    }
+
+    const unsigned char c = *pos_;
+    if (c == '"') {
+      if (run_start) {
+        string_buffer_.append(run_start, pos_ - run_start);
+        *value = string_buffer_;
+      } else {
+        *value = StringPiece(string_start, pos_ - string_start);
+      }
+      ++pos_;
+      return true;
+    }
+
+    if (c == '\\') {
+      if (run_start)
+        string_buffer_.append(run_start, pos_ - run_start);
+      else
+        string_buffer_.assign(string_start, pos_ - string_start);
+      if (!ParseEscape())
+        return false;
+      run_start = pos_;
+    } else if (c < 0x80) {
+      // Control characters are accepted, like JSONReader does.
+      ++pos_;
+    } else {
+      // Validate the UTF-8 sequence, like JSONReader does.
+      int32 offset = 0;
+      const int32 length =
+          static_cast<int32>(std::min<ptrdiff_t>(end_ - pos_, CBU8_MAX_LENGTH));
+      int32 code_point;
+      CBU8_NEXT(pos_, offset, length, code_point);
+      pos_ += offset;
+      if (code_point < 0 || !IsValidCharacter(code_point))
+        return ReportError(JSONReader::JSON_UNSUPPORTED_ENCODING, 1);
+    }
+  }
+}
+
+bool JSONSaxReader::ParseEscape() {
+  DCHECK_EQ('\\', *pos_);
+  // The errors are reported where JSONReader reports them, as an offset from
+  // the backslash.
+  const char* const escape = pos_;
+  if (end_ - escape < 2)
+    return ReportEscapeError(escape, 2);
+
+  uint32 code_unit = 0;
+  switch (escape[1]) {
+    case 'x': {
+      // UTF-8 \x escape sequences are not allowed in the spec, but JSONReader
+      // supports them.
+      if (end_ - escape < 3)
+        return ReportEscapeError(escape, 3);
+      if (end_ - escape < 4 || !ReadHexDigits(escape + 2, 2, &code_unit))
+        return ReportEscapeError(escape, 2);
+      AppendCodePoint(code_unit, &string_buffer_);
+      pos_ += 4;
+      return true;
+    }
+    case 'u': {
+      if (end_ - escape < 6)
+        return ReportEscapeError(escape, 2);
+      if (!ReadHexDigits(escape + 2, 4, &code_unit))
+        return ReportEscapeError(escape, 2);
+      if (!CBU16_IS_SURROGATE(code_unit)) {
+        AppendCodePoint(code_unit, &string_buffer_);
+        pos_ += 6;
+        return true;
+      }
+
+      // A surrogate pair, as two escape sequences.
+      if (!CBU16_IS_SURROGATE_LEAD(code_unit) || end_ - escape < 11)
+        return ReportEscapeError(escape, 5);
+      if (escape[6] != '\\')
+        return ReportEscapeError(escape, 6);
+      if (escape[7] != 'u')
+        return ReportEscapeError(escape, 7);
+      uint32 low_code_unit = 0;
+      if (end_ - escape < 12 || !ReadHexDigits(escape + 8, 4, &low_code_unit))
+        return ReportEscapeError(escape, 8);
+      if (!CBU16_IS_TRAIL(low_code_unit))
+        return ReportEscapeError(escape, 11);
+      AppendCodePoint(CBU16_GET_SUPPLEMENTARY(code_unit, low_code_unit),
+                      &string_buffer_);
+      pos_ += 12;
+      return true;
+    }
+    case '"':
+    case '\\':
+    case '/':
+      string_buffer_.push_back(pos_[1]);
+      break;
+    case 'b':
+      string_buffer_.push_back('\b');
+      break;
+    case 'f':
+      string_buffer_.push_back('\f');
+      break;
+    case 'n':
+      string_buffer_.push_back('\n');
+      break;
+    case 'r':
+      string_buffer_.push_back('\r');
+      break;
+    case 't':
+      string_buffer_.push_back('\t');
+      break;
+    case 'v':  // Not listed as valid escape sequence in the RFC.
+      string_buffer_.push_back('\v');
+      break;
+    default:
+      return ReportEscapeError(escape, 2);
+  }
+  pos_ += 2;
+  return true;
+}
+
+bool JSONSaxReader::ParseNumber(JSONSaxHandler* handler) {
+  const char* const number_start = pos_;
+  const bool negative = *pos_ == '-';
+  if (negative)
+    ++pos_;
+
+  // The integer part, without leading zeros.
+  const char* const digits_start = pos_;
+  int64 integer = 0;
+  while (pos_ < end_ && IsAsciiDigit(*pos_)) {
+    if (pos_ - digits_start < kMaxFastIntegerDigits)
+      integer = integer * 10 + (*pos_ - '0');
+    ++pos_;
+  }
+  const ptrdiff_t num_digits = pos_ - digits_start;
+  if (num_digits == 0 || (num_digits > 1 && *digits_start == '0'))
+    return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+
+  bool is_integer = true;
+  // The optional fraction part.
+  if (pos_ < end_ && *pos_ == '.') {
+    is_integer = false;
+    const char* fraction_start = ++pos_;
+    while (pos_ < end_ && IsAsciiDigit(*pos_))
+      ++pos_;
+    if (pos_ == fraction_start)
+      return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+  }
+  // The optional exponent part.
+  if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+    is_integer = false;
+    ++pos_;
+    if (pos_ < end_ && (*pos_ == '-' || *pos_ == '+'))
+      ++pos_;
+    const char* exponent_start = pos_;
+    while (pos_ < end_ && IsAsciiDigit(*pos_))
+      ++pos_;
+    if (pos_ == exponent_start)
+      return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+  }
+
+  // Like JSONReader, only accept a number followed by the end of the input
+  // or of a container, or by a comma. The whitespace after it is skipped
+  // again afterwards, which counts its line breaks twice, as JSONReader does.
+  const char* const number_end = pos_;
+  SkipWhitespace();
+  if (pos_ < end_ && *pos_ != '}' && *pos_ != ']' && *pos_ != ',')
+    return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+  pos_ = number_end;
+
+  if (is_integer && num_digits <= kMaxFastIntegerDigits) {
+    if (negative)
+      integer = -integer;
+    if (integer >= kint32min && integer <= kint32max)
+      return handler->OnInteger(static_cast<int>(integer));
+  }
+
+  double number;
+  if (!StringToDouble(std::string(number_start, pos_ - number_start),
+                      &number) ||
+      !std::isfinite(number)) {
+    return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+  }
+  return handler->OnDouble(number);
+}
+
+bool JSONSaxReader::ParseLiteral(JSONSaxHandler* handler) {
+  const size_t remaining = end_ - pos_;
+  switch (*pos_) {
+    case 't':
+      if (remaining >= 4 && !memcmp(pos_, "true", 4)) {
+        pos_ += 4;
+        return handler->OnBoolean(true);
+      }
+      break;
+    case 'f':
+      if (remaining >= 5 && !memcmp(pos_, "false", 5)) {
+        pos_ += 5;
+        return handler->OnBoolean(false);
+      }
+      break;
+    case 'n':
+      if (remaining >= 4 && !memcmp(pos_, "null", 4)) {
+        pos_ += 4;
+        return handler->OnNull();
+      }
+      break;
+  }
+  return ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
+}
+
+bool JSONSaxReader::ReportError(JSONReader::JsonParseError code,
+                                int column_adjust) {
+  error_code_ = code;
+  error_line_ = line_number_;
+  error_column_ = static_cast<int>(pos_ - last_line_) + column_adjust;
+  return false;
+}
+
+bool JSONSaxReader::ReportEscapeError(const char* escape, int offset) {
+  // |offset| may reach past the end of the input.
+  const ptrdiff_t in_input = std::min<ptrdiff_t>(offset, end_ - escape);
+  pos_ = escape + in_input;
+  return ReportError(JSONReader::JSON_INVALID_ESCAPE,
+                     static_cast<int>(offset - in_input));
+}
+
+}  // namespace base
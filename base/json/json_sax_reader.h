@@ -0,0 +1,128 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// An event-based ("SAX") JSON parser. Instead of building a tree of values,
+// it reports each value to a JSONSaxHandler as it is parsed, so that callers
+// which only need part of a large document, or which have their own data
+// structures (see JSONDocument), don't pay for a tree of base::Values.
+//
+// It accepts the same inputs as JSONReader (see json_reader.h for the
+// deviations from the RFC), with the same options, and reports errors with
+// the same codes, lines and columns, but:
+// - it doesn't recurse, and scans string literals many bytes at a time
+//   (see base/json/json_string_scan.h);
+// - escape sequences must be followed by exactly the expected number of hex
+//   digits;
+// - a number too large for a double is a JSON_SYNTAX_ERROR, where JSONReader
+//   fails without an error code.
+
+#ifndef BASE_JSON_JSON_SAX_READER_H_
+#define BASE_JSON_JSON_SAX_READER_H_
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// Receives the values of a JSON document, in document order. Each method
+// returns false to stop parsing.
+//
+// The StringPieces passed to OnString() and OnKey() are only valid until the
+// method returns: they point either into the input or into a buffer of the
+// reader.
+class BASE_EXPORT JSONSaxHandler {
+ public:
+  virtual ~JSONSaxHandler() {}
+
+  virtual bool OnNull() = 0;
+  virtual bool OnBoolean(bool value) = 0;
+  // Numbers are reported as integers when JSONReader would create an integer
+  // Value, i.e. when they have no fraction or exponent and fit in an int.
+  virtual bool OnInteger(int value) = 0;
+  virtual bool OnDouble(double value) = 0;
+  virtual bool OnString(const StringPiece& value) = 0;
+
+  // A dictionary is reported as OnStartDictionary(), then OnKey() followed by
+  // the value of each member, then OnEndDictionary().
+  virtual bool OnStartDictionary() = 0;
+  virtual bool OnKey(const StringPiece& key) = 0;
+  virtual bool OnEndDictionary() = 0;
+
+  // A list is reported as OnStartList(), its items, then OnEndList().
+  virtual bool OnStartList() = 0;
+  virtual bool OnEndList() = 0;
+};
+
+class BASE_EXPORT JSONSaxReader {
+ public:
+  // |options| are JSONParserOptions; JSON_DETACHABLE_CHILDREN is meaningless
+  // here and ignored.
+  explicit JSONSaxReader(int options);
+  ~JSONSaxReader();
+
+  // Parses |json|, reporting its values to |handler|. Returns true if the
+  // whole input was a valid JSON document. Returns false if it wasn't, with
+  // error_code() set, or if |handler| stopped the parsing, with error_code()
+  // left to JSON_NO_ERROR. In both cases |handler| may already have been
+  // given part of the document.
+  bool Parse(const StringPiece& json, JSONSaxHandler* handler);
+
+  // Returns the error code of the last call to Parse().
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Returns a human-readable description of the last error, including its
+  // line and column.
+  std::string GetErrorMessage() const;
+
+ private:
+  // Skips whitespace and comments, counting the line breaks.
+  void SkipWhitespace();
+
+  // Each of these is called with |pos_| at the first character of the token,
+  // and leaves |pos_| right after it.
+  bool ParseKey(JSONSaxHandler* handler);
+  bool ParseString(StringPiece* value);
+  bool ParseEscape();
+  bool ParseNumber(JSONSaxHandler* handler);
+  bool ParseLiteral(JSONSaxHandler* handler);
+
+  // Sets the error, at the current position plus |column_adjust| columns,
+  // which is where JSONReader reports it. Returns false.
+  bool ReportError(JSONReader::JsonParseError code, int column_adjust);
+  // Sets a JSON_INVALID_ESCAPE error, |offset| bytes after the backslash of
+  // the escape sequence at |escape|. Returns false.
+  bool ReportEscapeError(const char* escape, int offset);
+
+  const int options_;
+
+  // The input being parsed.
+  const char* start_;
+  const char* pos_;
+  const char* end_;
+
+  // Holds the value of strings with escape sequences, which can't be pointed
+  // to in the input.
+  std::string string_buffer_;
+
+  // The line |pos_| is on, 1-based, and the line break which started it (or
+  // |start_|). Line breaks in strings and comments aren't counted, as in
+  // JSONReader.
+  int line_number_;
+  const char* last_line_;
+
+  JSONReader::JsonParseError error_code_;
+  // Line and column of the error, as JSONReader computes them.
+  int error_line_;
+  int error_column_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONSaxReader);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_SAX_READER_H_
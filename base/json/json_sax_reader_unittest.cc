@@ -0,0 +1,377 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_sax_reader.h"
+
+#include <string>
+
+#include "base/json/json_string_scan.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Records the values it is given as a string of space-separated events.
+class RecordingHandler : public JSONSaxHandler {
+ public:
+  // Stops the parsing after |max_events| events, if not negative.
+  explicit RecordingHandler(int max_events = -1) : max_events_(max_events) {}
+  ~RecordingHandler() override {}
+
+  const std::string& events() const { return events_; }
+
+  bool OnNull() override { return Record("null"); }
+  bool OnBoolean(bool value) override {
+    return Record(value ? "true" : "false");
+  }
+  bool OnInteger(int value) override {
+    return Record("i" + IntToString(value));
+  }
+  bool OnDouble(double value) override {
+    return Record("d" + DoubleToString(value));
+  }
+  bool OnString(const StringPiece& value) override {
+    return Record("s:" + value.as_string());
+  }
+  bool OnStartDictionary() override { return Record("{"); }
+  bool OnKey(const StringPiece& key) override {
+    return Record("k:" + key.as_string());
+  }
+  bool OnEndDictionary() override { return Record("}"); }
+  bool OnStartList() override { return Record("["); }
+  bool OnEndList() override { return Record("]"); }
+
+ private:
+  bool Record(const std::string& event) {
+    if (!events_.empty())
+      events_.push_back(' ');
+    events_.append(event);
+    return max_events_ < 0 || --max_events_ > 0;
+  }
+
+  std::string events_;
+  int max_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingHandler);
+};
+
+// Returns the events of |json|, or "error <code>".
+std::string Parse(const std::string& json, int options = JSON_PARSE_RFC) {
+  RecordingHandler handler;
+  JSONSaxReader reader(options);
+  if (!reader.Parse(json, &handler))
+    return "error " + IntToString(reader.error_code());
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+  return handler.events();
+}
+
+std::string Error(JSONReader::JsonParseError code) {
+  return "error " + IntToString(code);
+}
+
+// Expects |json| to be accepted or rejected like JSONReader does, with the
+// same error code, line and column.
+void ExpectSameAsJSONReader(const std::string& json, int options) {
+  SCOPED_TRACE(json);
+  int expected_code = JSONReader::JSON_NO_ERROR;
+  std::string expected_message;
+  scoped_ptr<Value> value(JSONReader::ReadAndReturnError(
+      json, options, &expected_code, &expected_message));
+
+  JSONSaxReader reader(options);
+  RecordingHandler handler;
+  EXPECT_EQ(!!value, reader.Parse(json, &handler));
+  EXPECT_EQ(expected_code, reader.error_code());
+  EXPECT_EQ(expected_message, reader.GetErrorMessage());
+}
+
+}  // namespace
+
+TEST(JSONSaxReaderTest, Values) {
+  EXPECT_EQ("null", Parse("null"));
+  EXPECT_EQ("true", Parse(" true "));
+  EXPECT_EQ("false", Parse("\n\tfalse\r\n"));
+  EXPECT_EQ("i42", Parse("42"));
+  EXPECT_EQ("i-42", Parse("-42"));
+  EXPECT_EQ("i0", Parse("-0"));
+  EXPECT_EQ("i2147483647", Parse("2147483647"));
+  EXPECT_EQ("d2147483648", Parse("2147483648"));
+  EXPECT_EQ("d-2147483649", Parse("-2147483649"));
+  EXPECT_EQ("d1e+20", Parse("100000000000000000000"));
+  EXPECT_EQ("d1", Parse("1.0"));
+  EXPECT_EQ("d2.5", Parse("25e-1"));
+  EXPECT_EQ("d-1500", Parse("-1.5E3"));
+  EXPECT_EQ("s:", Parse("\"\""));
+  EXPECT_EQ("s:hello world", Parse("\"hello world\""));
+}
+
+TEST(JSONSaxReaderTest, Containers) {
+  EXPECT_EQ("[ ]", Parse("[]"));
+  EXPECT_EQ("{ }", Parse(" { } "));
+  EXPECT_EQ("[ i1 [ ] { } s:x ]", Parse("[1, [], {}, \"x\"]"));
+  EXPECT_EQ("{ k:a i1 k:b [ true { k:c null } ] k:d { } }",
+            Parse("{\"a\": 1, \"b\": [true, {\"c\": null}], \"d\": {}}"));
+  EXPECT_EQ("[ [ [ ] ] ]", Parse("[[[]]]"));
+}
+
+TEST(JSONSaxReaderTest, Strings) {
+  // Escape sequences.
+  EXPECT_EQ("s:\" \\ / \b \f \n \r \t \v",
+            Parse("\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\v\""));
+  EXPECT_EQ("s:A\xC3\xA9", Parse("\"\\u0041\\u00e9\""));
+  EXPECT_EQ("s:A\xC3\xA9", Parse("\"\\x41\\xe9\""));
+  // A surrogate pair: U+1D11E.
+  EXPECT_EQ("s:a\xF0\x9D\x84\x9E" "b", Parse("\"a\\uD834\\uDD1Eb\""));
+  // Strings longer than the scanned blocks, with escapes at every position.
+  std::string long_string(40, 'x');
+  for (size_t i = 0; i < long_string.size(); ++i) {
+    std::string json = "\"" + long_string + "\"";
+    json.replace(i + 1, 1, "\\n");
+    std::string expected = long_string;
+    expected[i] = '\n';
+    EXPECT_EQ("s:" + expected, Parse(json));
+  }
+  // UTF-8 and control characters are passed as they are.
+  EXPECT_EQ("s:\xE2\x82\xAC\t", Parse("\"\xE2\x82\xAC\t\""));
+
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"\\q\""));
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"\\u12\""));
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"\\u12g4\""));
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"\\x4\""));
+  // Unpaired surrogates.
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"\\uD834\""));
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"\\uDD1E\""));
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE),
+            Parse("\"\\uD834\\u0041\""));
+  // Invalid UTF-8.
+  EXPECT_EQ(Error(JSONReader::JSON_UNSUPPORTED_ENCODING), Parse("\"\xC3\""));
+  EXPECT_EQ(Error(JSONReader::JSON_UNSUPPORTED_ENCODING),
+            Parse("\"\xED\xA0\x80\""));
+  EXPECT_EQ(Error(JSONReader::JSON_UNSUPPORTED_ENCODING),
+            Parse("\"abc\xFF\""));
+  // Unterminated.
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("\"abc"));
+  EXPECT_EQ(Error(JSONReader::JSON_INVALID_ESCAPE), Parse("\"abc\\"));
+}
+
+TEST(JSONSaxReaderTest, WhitespaceAndComments) {
+  EXPECT_EQ("[ i1 i2 ]", Parse("/* a */ [1, // b\n 2] // c"));
+  EXPECT_EQ("[ ]", Parse("\xEF\xBB\xBF[]"));
+  // An unterminated comment runs to the end of the input.
+  EXPECT_EQ("[ ]", Parse("[] /* a"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT),
+            Parse("[] / a"));
+}
+
+TEST(JSONSaxReaderTest, Errors) {
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN), Parse(""));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN), Parse("   "));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN), Parse("]"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN), Parse("[,]"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("[1"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("[1 2]"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("[1}"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("{\"a\" 1}"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY), Parse("{a: 1}"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("1 2"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT),
+            Parse("true 2"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT), Parse("{}}"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("tru"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("nul1"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("[truex]"));
+
+  // Numbers.
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("-"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("01"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("1."));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("1e"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("1e+"));
+  EXPECT_EQ(Error(JSONReader::JSON_SYNTAX_ERROR), Parse("1e400"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN), Parse("+1"));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN), Parse(".5"));
+
+  // Trailing commas.
+  EXPECT_EQ(Error(JSONReader::JSON_TRAILING_COMMA), Parse("[1,]"));
+  EXPECT_EQ(Error(JSONReader::JSON_TRAILING_COMMA), Parse("{\"a\": 1 , }"));
+  EXPECT_EQ("[ i1 ]", Parse("[1,]", JSON_ALLOW_TRAILING_COMMAS));
+  EXPECT_EQ("{ k:a i1 }", Parse("{\"a\": 1,}", JSON_ALLOW_TRAILING_COMMAS));
+  EXPECT_EQ(Error(JSONReader::JSON_UNEXPECTED_TOKEN),
+            Parse("[1,,]", JSON_ALLOW_TRAILING_COMMAS));
+}
+
+TEST(JSONSaxReaderTest, Nesting) {
+  std::string json = std::string(99, '[') + std::string(99, ']');
+  EXPECT_NE(std::string::npos, Parse(json).find("[ [ ] ]"));
+  json = std::string(100, '[') + std::string(100, ']');
+  EXPECT_EQ(Error(JSONReader::JSON_TOO_MUCH_NESTING), Parse(json));
+}
+
+TEST(JSONSaxReaderTest, ErrorMessage) {
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  RecordingHandler handler;
+  EXPECT_FALSE(reader.Parse("{\n  \"a\": 1,\n  \"b\": x\n}", &handler));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, reader.error_code());
+  // Like JSONReader, columns after the first line are counted from the line
+  // break.
+  EXPECT_EQ("Line: 3, column: 9, " +
+                JSONReader::ErrorCodeToString(
+                    JSONReader::JSON_UNEXPECTED_TOKEN),
+            reader.GetErrorMessage());
+
+  // The error is reset by the next successful parse.
+  EXPECT_TRUE(reader.Parse("{}", &handler));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+  EXPECT_EQ("", reader.GetErrorMessage());
+}
+
+TEST(JSONSaxReaderTest, MatchesJSONReader) {
+  const struct {
+    const char* json;
+    int options;
+  } kCases[] = {
+      {"", JSON_PARSE_RFC},
+      {"  \n ", JSON_PARSE_RFC},
+      {"[1, {\"a\": [true, null, \"x\"]}, -2.5e3]", JSON_PARSE_RFC},
+      {"]", JSON_PARSE_RFC},
+      {"[}", JSON_PARSE_RFC},
+      {"[,]", JSON_PARSE_RFC},
+      {"[", JSON_PARSE_RFC},
+      {"[\"a\",", JSON_PARSE_RFC},
+      {"[\"a\"", JSON_PARSE_RFC},
+      {"[\"a\" \"b\"]", JSON_PARSE_RFC},
+      {"[true false]", JSON_PARSE_RFC},
+      {"[1", JSON_PARSE_RFC},
+      {"[1 2]", JSON_PARSE_RFC},
+      {"[1}", JSON_PARSE_RFC},
+      {"[1,]", JSON_PARSE_RFC},
+      {"[1,]", JSON_ALLOW_TRAILING_COMMAS},
+      {"[1,,]", JSON_ALLOW_TRAILING_COMMAS},
+      {"{", JSON_PARSE_RFC},
+      {"{\"a\"", JSON_PARSE_RFC},
+      {"{\"a\" 1}", JSON_PARSE_RFC},
+      {"{\"a\":", JSON_PARSE_RFC},
+      {"{\"a\": 1", JSON_PARSE_RFC},
+      {"{\"a\": true", JSON_PARSE_RFC},
+      {"{\"a\": true 1}", JSON_PARSE_RFC},
+      {"{\"a\": 1 true}", JSON_PARSE_RFC},
+      {"{\"a\": 1 , }", JSON_PARSE_RFC},
+      {"{\"a\": 1 , }", JSON_ALLOW_TRAILING_COMMAS},
+      {"{\"a\": 1, b: 2}", JSON_PARSE_RFC},
+      {"{a: 1}", JSON_PARSE_RFC},
+      {"{}}", JSON_PARSE_RFC},
+      {"1 2", JSON_PARSE_RFC},
+      {"1 ]", JSON_PARSE_RFC},
+      {"true 2", JSON_PARSE_RFC},
+      {"truex", JSON_PARSE_RFC},
+      {"tru", JSON_PARSE_RFC},
+      {"nul1", JSON_PARSE_RFC},
+      {"[truex]", JSON_PARSE_RFC},
+      {"-", JSON_PARSE_RFC},
+      {"-a", JSON_PARSE_RFC},
+      {"01", JSON_PARSE_RFC},
+      {"1.", JSON_PARSE_RFC},
+      {"1.x", JSON_PARSE_RFC},
+      {"1e", JSON_PARSE_RFC},
+      {"1e+", JSON_PARSE_RFC},
+      {"+1", JSON_PARSE_RFC},
+      {".5", JSON_PARSE_RFC},
+      // Comments.
+      {"/* a */ [1, // b\n 2] // c", JSON_PARSE_RFC},
+      {"[] /* a", JSON_PARSE_RFC},
+      {"[1 /* a", JSON_PARSE_RFC},
+      {"/* a", JSON_PARSE_RFC},
+      {"[] / a", JSON_PARSE_RFC},
+      {"[1, / 2]", JSON_PARSE_RFC},
+      {"[1 /x]", JSON_PARSE_RFC},
+      {"[] /", JSON_PARSE_RFC},
+      {"/*/ 1", JSON_PARSE_RFC},
+      // Strings.
+      {"\"", JSON_PARSE_RFC},
+      {"\"abc", JSON_PARSE_RFC},
+      {"\"ab\xC3\xA9", JSON_PARSE_RFC},
+      {"\"a\\n", JSON_PARSE_RFC},
+      {"\"abc\\", JSON_PARSE_RFC},
+      {"\"\\q\"", JSON_PARSE_RFC},
+      {"\"\\x", JSON_PARSE_RFC},
+      {"\"\\x4", JSON_PARSE_RFC},
+      {"\"\\x4\"", JSON_PARSE_RFC},
+      {"\"\\x4g\"", JSON_PARSE_RFC},
+      {"\"\\u12", JSON_PARSE_RFC},
+      {"\"\\u12\"", JSON_PARSE_RFC},
+      {"\"\\u12345\"", JSON_PARSE_RFC},
+      {"\"\\u12g4\"", JSON_PARSE_RFC},
+      {"\"\\uD834\"", JSON_PARSE_RFC},
+      {"\"\\uD834\\uDD1", JSON_PARSE_RFC},
+      {"\"\\uD834\\uDD1\"", JSON_PARSE_RFC},
+      {"\"\\uD834\\uDD1E", JSON_PARSE_RFC},
+      {"\"\\uD834x\\uDD1E\"", JSON_PARSE_RFC},
+      {"\"\\uD834\\xDD1E\"", JSON_PARSE_RFC},
+      {"\"\\uD834\\uDG1E\"", JSON_PARSE_RFC},
+      {"\"\\uD834\\u0041\"", JSON_PARSE_RFC},
+      {"\"\\uDD1E\"", JSON_PARSE_RFC},
+      {"\"\xC3\"", JSON_PARSE_RFC},
+      {"\"\xED\xA0\x80\"", JSON_PARSE_RFC},
+      {"\"abc\xFF\"", JSON_PARSE_RFC},
+      {"\"abc\xF0\x9D\x84", JSON_PARSE_RFC},
+      // Lines and columns.
+      {"{\n  \"a\": 1,\n  \"b\": x\n}", JSON_PARSE_RFC},
+      {"[\r\n1,\r\n\r2,\n\n x]", JSON_PARSE_RFC},
+      {"[1\n,\n x]", JSON_PARSE_RFC},
+      {"[1\n\n]\nx", JSON_PARSE_RFC},
+      {"[\"a\nb\", /* c\nd */ x]", JSON_PARSE_RFC},
+      {"[// a\r\n x]", JSON_PARSE_RFC},
+      {"\xEF\xBB\xBF[x]", JSON_PARSE_RFC},
+      {"[\n\"\\q\"]", JSON_PARSE_RFC},
+      {"[\n\"a\xFF\"]", JSON_PARSE_RFC},
+  };
+  for (size_t i = 0; i < arraysize(kCases); ++i)
+    ExpectSameAsJSONReader(kCases[i].json, kCases[i].options);
+
+  for (size_t depth = 98; depth <= 101; ++depth) {
+    ExpectSameAsJSONReader(
+        std::string(depth, '[') + std::string(depth, ']'), JSON_PARSE_RFC);
+  }
+}
+
+TEST(JSONSaxReaderTest, HandlerStops) {
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  RecordingHandler handler(3);
+  EXPECT_FALSE(reader.Parse("{\"a\": [1, 2, 3]}", &handler));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+  EXPECT_EQ("{ k:a [", handler.events());
+}
+
+TEST(JSONSaxReaderTest, ScanJSONStringRun) {
+  std::string data(100, 'a');
+  EXPECT_EQ(100u, internal::ScanJSONStringRun(data.data(), data.size(), true));
+  EXPECT_EQ(0u, internal::ScanJSONStringRun(data.data(), 0, true));
+  const char kStops[] = {'"', '\\', '\n', '\x01', '\x80', '\xFF'};
+  for (size_t position = 0; position < data.size(); ++position) {
+    for (size_t i = 0; i < arraysize(kStops); ++i) {
+      std::string stopped = data;
+      stopped[position] = kStops[i];
+      EXPECT_EQ(position, internal::ScanJSONStringRun(
+                              stopped.data(), stopped.size(), false));
+    }
+    std::string less_than = data;
+    less_than[position] = '<';
+    EXPECT_EQ(position, internal::ScanJSONStringRun(less_than.data(),
+                                                    less_than.size(), true));
+    EXPECT_EQ(100u, internal::ScanJSONStringRun(less_than.data(),
+                                                less_than.size(), false));
+  }
+  // DEL and the other printable characters don't stop the run.
+  const char kPrintable[] = " !#$%&'()*+,-./09:;=>?@AZ[]^_`az{|}~\x7F";
+  EXPECT_EQ(arraysize(kPrintable) - 1,
+            internal::ScanJSONStringRun(kPrintable, arraysize(kPrintable) - 1,
+                                        true));
+}
+
+}  // namespace base
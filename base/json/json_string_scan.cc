@@ -0,0 +1,93 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_string_scan.h"
+
+#include <string.h>
+
+#include "base/basictypes.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && \
+    (defined(__SSE2__) || defined(_M_X64) ||      \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define JSON_STRING_SCAN_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+inline bool IsRunCharacter(unsigned char c, bool stop_at_less_than) {
+  return c >= 0x20 && c < 0x80 && c != '"' && c != '\\' &&
+         !(stop_at_less_than && c == '<');
+}
+
+#if !defined(JSON_STRING_SCAN_USE_SSE2)
+const uint64 kOnes = 0x0101010101010101ULL;
+const uint64 kHighBits = 0x8080808080808080ULL;
+
+// Returns non-zero if a byte of |word| is zero.
+inline uint64 HasZeroByte(uint64 word) {
+  return (word - kOnes) & ~word & kHighBits;
+}
+
+// Returns non-zero if a byte of |word| is less than 0x20 or has its high bit
+// set, or equals one of the special characters.
+inline uint64 HasSpecialByte(uint64 word, bool stop_at_less_than) {
+  uint64 special = ((word - kOnes * 0x20) | word) & kHighBits;
+  special |= HasZeroByte(word ^ (kOnes * '"'));
+  special |= HasZeroByte(word ^ (kOnes * '\\'));
+  if (stop_at_less_than)
+    special |= HasZeroByte(word ^ (kOnes * '<'));
+  return special;
+}
+#endif  // !defined(JSON_STRING_SCAN_USE_SSE2)
+
+}  // namespace
+
+size_t ScanJSONStringRun(const char* data,
+                         size_t length,
+                         bool stop_at_less_than) {
+  size_t i = 0;
+  // Skip whole blocks without special characters; the block containing the
+  // first one (if any) is finished byte per byte below.
+#if defined(JSON_STRING_SCAN_USE_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i less_than = _mm_set1_epi8(stop_at_less_than ? '<' : '"');
+  // Control characters and (as negative signed bytes) non-ASCII bytes.
+  const __m128i space = _mm_set1_epi8(0x20);
+  for (; i + 16 <= length; i += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                     _mm_cmpeq_epi8(block, backslash)),
+        _mm_or_si128(_mm_cmpeq_epi8(block, less_than),
+                     _mm_cmplt_epi8(block, space)));
+    if (_mm_movemask_epi8(special))
+      break;
+  }
+#else
+  for (; i + 8 <= length; i += 8) {
+    uint64 word;
+    memcpy(&word, data + i, sizeof(word));
+    if (HasSpecialByte(word, stop_at_less_than))
+      break;
+  }
+#endif
+
+  while (i < length &&
+         IsRunCharacter(static_cast<unsigned char>(data[i]),
+                        stop_at_less_than)) {
+    ++i;
+  }
+  return i;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,31 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_STRING_SCAN_H_
+#define BASE_JSON_JSON_STRING_SCAN_H_
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+
+namespace base {
+namespace internal {
+
+// Returns the length of the longest prefix of the |length| bytes at |data|
+// made only of printable ASCII characters other than '"' and '\\' -- and '<'
+// if |stop_at_less_than| is true. These characters are copied verbatim
+// between a JSON string literal and its UTF-8 value, so the JSON reader and
+// writer can skip (or append) such runs in bulk and only look at the bytes
+// which end them: quotes, escapes, control characters and non-ASCII UTF-8.
+//
+// The input is scanned 16 bytes at a time with SSE2 where it is available,
+// and 8 bytes at a time otherwise.
+BASE_EXPORT_PRIVATE size_t ScanJSONStringRun(const char* data,
+                                             size_t length,
+                                             bool stop_at_less_than);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STRING_SCAN_H_
@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "base/json/json_string_scan.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversion_utils.h"
@@ -65,6 +66,25 @@ bool EscapeSpecialCodePoint(uint32 code_point, std::string* dest) {
   return true;
 }
 
+// Appends the longest run of code units of |str| starting at |offset| which
+// can be copied to the output as they are, and returns its length. Most
+// strings are mostly printable ASCII, which is much cheaper to copy in runs.
+size_t AppendVerbatimRun(const StringPiece& str,
+                         int32 offset,
+                         std::string* dest) {
+  size_t run_length = internal::ScanJSONStringRun(
+      str.data() + offset, str.length() - offset, true);
+  dest->append(str.data() + offset, run_length);
+  return run_length;
+}
+
+// UTF-16 strings need converting, one code point at a time.
+size_t AppendVerbatimRun(const StringPiece16& str,
+                         int32 offset,
+                         std::string* dest) {
+  return 0;
+}
+
 template <typename S>
 bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   bool did_replacement = false;
@@ -77,6 +97,10 @@ bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   const int32 length = static_cast<int32>(str.length());
 
   for (int32 i = 0; i < length; ++i) {
+    i += static_cast<int32>(AppendVerbatimRun(str, i, dest));
+    if (i == length)
+      break;
+
     uint32 code_point;
     if (!ReadUnicodeCharacter(str.data(), length, &i, &code_point)) {
       code_point = kReplacementCodePoint;
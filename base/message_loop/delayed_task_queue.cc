@@ -0,0 +1,298 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/delayed_task_queue.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "build/build_config.h"
+
+namespace base {
+
+namespace {
+
+// Returns the index of the lowest bit set in |bits|, which must not be zero.
+int FindFirstSet(uint64 bits) {
+#if defined(COMPILER_GCC)
+  return __builtin_ctzll(bits);
+#else
+  int index = 0;
+  while (!(bits & 1)) {
+    bits >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+}  // namespace
+
+// static
+const DelayedTaskQueue::TaskId DelayedTaskQueue::kBadTaskId = 0;
+
+class DelayedTaskQueue::DueOrder {
+ public:
+  explicit DueOrder(const std::vector<Entry>* entries) : entries_(entries) {}
+
+  bool operator()(int a, int b) const {
+    return (*entries_)[a].pending_task < (*entries_)[b].pending_task;
+  }
+
+ private:
+  const std::vector<Entry>* entries_;
+};
+
+DelayedTaskQueue::Entry::Entry(const PendingTask& pending_task)
+    : pending_task(pending_task),
+      generation(1),
+      slot(kFree),
+      prev(-1),
+      next(-1) {
+}
+
+DelayedTaskQueue::Entry::~Entry() {
+}
+
+DelayedTaskQueue::DelayedTaskQueue()
+    : free_list_(-1), current_tick_(0), size_(0) {
+  std::fill(slots_, slots_ + arraysize(slots_), -1);
+  std::fill(occupied_, occupied_ + arraysize(occupied_), 0);
+}
+
+DelayedTaskQueue::~DelayedTaskQueue() {
+}
+
+DelayedTaskQueue::TaskId DelayedTaskQueue::Push(
+    const PendingTask& pending_task) {
+  DCHECK(!pending_task.delayed_run_time.is_null());
+  if (!size_) {
+    // Nothing is in the wheel, so it can start again from now, after
+    // dropping the canceled entries left in |due_|.
+    for (size_t i = 0; i < due_.size(); ++i)
+      AddToFreeList(due_[i]);
+    due_.clear();
+    current_tick_ = TickOf(TimeTicks::Now());
+  }
+
+  int index = free_list_;
+  if (index != -1) {
+    free_list_ = entries_[index].next;
+    entries_[index].pending_task = pending_task;
+  } else {
+    index = static_cast<int>(entries_.size());
+    entries_.push_back(Entry(pending_task));
+  }
+
+  Entry& entry = entries_[index];
+  if (slack_ > TimeDelta()) {
+    const int64 slack = slack_.InMicroseconds();
+    const int64 run_time =
+        entry.pending_task.delayed_run_time.ToInternalValue();
+    entry.pending_task.delayed_run_time =
+        TimeTicks::FromInternalValue((run_time + slack - 1) / slack * slack);
+  }
+  Insert(index);
+  ++size_;
+  return (static_cast<TaskId>(entry.generation) << 32) | index;
+}
+
+const PendingTask* DelayedTaskQueue::Find(TaskId id) const {
+  const size_t index = static_cast<size_t>(id & kuint32max);
+  if (index >= entries_.size())
+    return NULL;
+  const Entry& entry = entries_[index];
+  if (entry.generation != static_cast<uint32>(id >> 32) ||
+      entry.slot == kFree || entry.slot == kDueCanceled) {
+    return NULL;
+  }
+  return &entry.pending_task;
+}
+
+bool DelayedTaskQueue::Cancel(TaskId id) {
+  if (!Find(id))
+    return false;
+  const int index = static_cast<int>(id & kuint32max);
+  // Taking an entry out of the middle of |due_| would not take constant
+  // time, so Release() only marks it, and Top() drops it.
+  if (entries_[index].slot != kDue)
+    Unlink(index);
+  --size_;
+  Release(index);
+  return true;
+}
+
+TimeTicks DelayedTaskQueue::NextRunTime(TimeTicks now) {
+  DCHECK(!empty());
+  const int64 now_tick = TickOf(now);
+  for (;;) {
+    DropCanceledDue();
+    if (!due_.empty())
+      return entries_[due_.front()].pending_task.delayed_run_time;
+    const int64 next_tick = NextTick();
+    if (next_tick > now_tick) {
+      return TimeTicks::FromInternalValue(next_tick *
+                                          Time::kMicrosecondsPerMillisecond);
+    }
+    Turn();
+  }
+}
+
+const PendingTask& DelayedTaskQueue::Top() {
+  DCHECK(!empty());
+  for (;;) {
+    DropCanceledDue();
+    if (!due_.empty())
+      return entries_[due_.front()].pending_task;
+    Turn();
+  }
+}
+
+void DelayedTaskQueue::Pop() {
+  Top();
+  std::pop_heap(due_.begin(), due_.end(), DueOrder(&entries_));
+  const int index = due_.back();
+  due_.pop_back();
+  entries_[index].slot = kFree;
+  --size_;
+  Release(index);
+}
+
+// static
+int64 DelayedTaskQueue::TickOf(TimeTicks time) {
+  return time.ToInternalValue() / Time::kMicrosecondsPerMillisecond;
+}
+
+void DelayedTaskQueue::Insert(int index) {
+  Entry& entry = entries_[index];
+  int64 tick = TickOf(entry.pending_task.delayed_run_time);
+  if (tick <= current_tick_) {
+    entry.slot = kDue;
+    due_.push_back(index);
+    std::push_heap(due_.begin(), due_.end(), DueOrder(&entries_));
+    return;
+  }
+
+  // A task beyond the reach of the top level waits in its farthest slot, and
+  // is placed again from there.
+  const int64 kMaxDelta =
+      (static_cast<int64>(1) << (kLevelBits * kNumLevels)) - 1;
+  tick = std::min(tick, current_tick_ + kMaxDelta);
+  int level = 0;
+  while ((tick - current_tick_) >> (kLevelBits * (level + 1)))
+    ++level;
+
+  const int bit = static_cast<int>((tick >> (kLevelBits * level)) &
+                                   (kSlotsPerLevel - 1));
+  const int slot = level * kSlotsPerLevel + bit;
+  entry.slot = slot;
+  entry.prev = -1;
+  entry.next = slots_[slot];
+  if (entry.next != -1)
+    entries_[entry.next].prev = index;
+  slots_[slot] = index;
+  occupied_[level] |= static_cast<uint64>(1) << bit;
+}
+
+void DelayedTaskQueue::Unlink(int index) {
+  Entry& entry = entries_[index];
+  DCHECK_GE(entry.slot, 0);
+  if (entry.prev != -1)
+    entries_[entry.prev].next = entry.next;
+  else
+    slots_[entry.slot] = entry.next;
+  if (entry.next != -1)
+    entries_[entry.next].prev = entry.prev;
+  if (slots_[entry.slot] == -1) {
+    occupied_[entry.slot / kSlotsPerLevel] &=
+        ~(static_cast<uint64>(1) << (entry.slot % kSlotsPerLevel));
+  }
+  entry.slot = kFree;
+}
+
+void DelayedTaskQueue::DropCanceledDue() {
+  while (!due_.empty() && entries_[due_.front()].slot == kDueCanceled) {
+    std::pop_heap(due_.begin(), due_.end(), DueOrder(&entries_));
+    AddToFreeList(due_.back());
+    due_.pop_back();
+  }
+}
+
+int64 DelayedTaskQueue::NextTick() const {
+  int64 next_tick = kint64max;
+  for (int level = 0; level < kNumLevels; ++level) {
+    if (occupied_[level])
+      next_tick = std::min(next_tick, NextTickOfLevel(level));
+  }
+  DCHECK_NE(kint64max, next_tick);
+  return next_tick;
+}
+
+void DelayedTaskQueue::Turn() {
+  int64 next_ticks[kNumLevels];
+  int64 next_tick = kint64max;
+  for (int level = 0; level < kNumLevels; ++level) {
+    next_ticks[level] = occupied_[level] ? NextTickOfLevel(level) : kint64max;
+    next_tick = std::min(next_tick, next_ticks[level]);
+  }
+  DCHECK_NE(kint64max, next_tick);
+  current_tick_ = next_tick;
+
+  // The tasks of a slot reached by the wheel are all due after its start, and
+  // before the start of the next one, so they go in lower levels, or in
+  // |due_|, never back in a slot reached at this tick.
+  for (int level = kNumLevels - 1; level >= 0; --level) {
+    if (next_ticks[level] != next_tick)
+      continue;
+    const int bit = static_cast<int>((next_tick >> (kLevelBits * level)) &
+                                     (kSlotsPerLevel - 1));
+    const int slot = level * kSlotsPerLevel + bit;
+    int index = slots_[slot];
+    slots_[slot] = -1;
+    occupied_[level] &= ~(static_cast<uint64>(1) << bit);
+    while (index != -1) {
+      const int next = entries_[index].next;
+      Insert(index);
+      index = next;
+    }
+  }
+}
+
+int64 DelayedTaskQueue::NextTickOfLevel(int level) const {
+  DCHECK(occupied_[level]);
+  const int shift = kLevelBits * level;
+  const int64 current_slot_tick = current_tick_ >> shift;
+  // Rotate the bits so that the slot after the current one comes first, and
+  // the current one, which the wheel only gets back to after a full turn,
+  // comes last.
+  const int first =
+      static_cast<int>((current_slot_tick + 1) & (kSlotsPerLevel - 1));
+  uint64 bits = occupied_[level];
+  if (first)
+    bits = (bits >> first) | (bits << (kSlotsPerLevel - first));
+  return (current_slot_tick + FindFirstSet(bits) + 1) << shift;
+}
+
+void DelayedTaskQueue::Release(int index) {
+  Entry& entry = entries_[index];
+  if (!++entry.generation)
+    entry.generation = 1;
+  if (entry.slot == kDue)
+    entry.slot = kDueCanceled;
+  else
+    AddToFreeList(index);
+
+  // Deleting the task may call back into the queue, so it is left to the
+  // destructor of this copy.
+  Closure task = entry.pending_task.task;
+  entry.pending_task.task.Reset();
+}
+
+void DelayedTaskQueue::AddToFreeList(int index) {
+  entries_[index].slot = kFree;
+  entries_[index].next = free_list_;
+  free_list_ = index;
+}
+
+}  // namespace base
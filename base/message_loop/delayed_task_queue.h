@@ -0,0 +1,177 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MESSAGE_LOOP_DELAYED_TASK_QUEUE_H_
+#define BASE_MESSAGE_LOOP_DELAYED_TASK_QUEUE_H_
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/pending_task.h"
+#include "base/time/time.h"
+
+namespace base {
+
+// The queue of delayed tasks of a MessageLoop. Tasks come out in the order
+// of their |delayed_run_time|, and of their |sequence_num| for equal run
+// times, like from a std::priority_queue<PendingTask>, but adding a task and
+// canceling one both take constant time.
+//
+// The queue is a hierarchical timing wheel with a resolution of one
+// millisecond. Each of its kNumLevels levels is a ring of kSlotsPerLevel
+// slots, and the slots of a level span kSlotsPerLevel times as much time as
+// those of the level below. A task goes in the slot of the lowest level which
+// reaches its run time, and moves down a level each time the wheel turns to
+// its slot, until it reaches a slot which has come due. The tasks of the
+// slots that have come due are kept in a binary heap, which orders the tasks
+// of the same millisecond.
+//
+// The wheel turns lazily, when there is no due task left, and the
+// MessageLoop only turns it as far as the current time, with NextRunTime().
+// Tasks pushed with a run time the wheel has already turned past go straight
+// to the heap, where canceling them leaves an entry behind until they come
+// out of it, so the wheel must not run ahead to a task due much later than
+// the ones pushed after it.
+//
+// Cancel() does not call back into the MessageLoop, and a canceled task is
+// deleted at once, instead of sitting in the queue until it is due.
+class BASE_EXPORT DelayedTaskQueue {
+ public:
+  // Identifies a task for Cancel(). Ids of tasks which have been popped or
+  // canceled are not reused until the id wraps around.
+  typedef uint64 TaskId;
+
+  // Never returned by Push().
+  static const TaskId kBadTaskId;
+
+  DelayedTaskQueue();
+  ~DelayedTaskQueue();
+
+  // Coalesces the run times of the tasks which are pushed afterwards: they
+  // are rounded up to a multiple of |slack|, so that the tasks due within the
+  // same |slack| run on the same wake-up. A zero |slack| turns this off.
+  void set_slack(TimeDelta slack) { slack_ = slack; }
+
+  // Adds |pending_task|, which must have a |delayed_run_time|.
+  TaskId Push(const PendingTask& pending_task);
+
+  // Returns the task with |id|, or NULL if it has been popped or canceled.
+  const PendingTask* Find(TaskId id) const;
+
+  // Removes and deletes the task with |id|, if it has not been popped or
+  // canceled already. Returns true if it removed the task.
+  bool Cancel(TaskId id);
+
+  // Returns the run time of the task to run next if the wheel gets to it by
+  // |now|, and otherwise a time after |now| and at or before it, at which to
+  // ask again. Never turns the wheel past |now|. The queue must not be empty.
+  TimeTicks NextRunTime(TimeTicks now);
+
+  // Returns the task to run next, turning the wheel as far as it takes, so
+  // the MessageLoop only calls it once NextRunTime() has found a due task.
+  // The queue must not be empty.
+  const PendingTask& Top();
+
+  // Removes and deletes the task Top() returns.
+  void Pop();
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // Returns the number of entries in the heap of due tasks, including the
+  // canceled ones which have not come out of it yet.
+  size_t due_size_for_testing() const { return due_.size(); }
+
+ private:
+  enum {
+    kLevelBits = 6,
+    kSlotsPerLevel = 1 << kLevelBits,
+    kNumLevels = 6,
+  };
+
+  // Where an Entry is.
+  enum {
+    kFree = -1,
+    kDue = -2,
+    // Popped or canceled, but still in |due_|.
+    kDueCanceled = -3,
+  };
+
+  struct Entry {
+    explicit Entry(const PendingTask& pending_task);
+    ~Entry();
+
+    PendingTask pending_task;
+    // Bumped each time the entry is reused, so that the ids of the tasks it
+    // held before are stale.
+    uint32 generation;
+    // Index of the slot in |slots_|, or one of the values above.
+    int slot;
+    // Links to the neighbors in the slot's list, or to the next entry in the
+    // free list.
+    int prev;
+    int next;
+  };
+
+  // Orders the indices of |due_| like std::priority_queue<PendingTask>.
+  class DueOrder;
+
+  static int64 TickOf(TimeTicks time);
+
+  // Places the entry at |index| in the slot for its run time, or in |due_|
+  // if it is due at the wheel's current time.
+  void Insert(int index);
+
+  // Unlinks the entry at |index| from its slot.
+  void Unlink(int index);
+
+  // Drops the canceled entries from the top of |due_|.
+  void DropCanceledDue();
+
+  // Returns the tick at which the wheel gets to its next non-empty slot, which
+  // no task in the wheel is due before. The wheel must not be empty.
+  int64 NextTick() const;
+
+  // Turns the wheel to its next non-empty slot, and moves the tasks of every
+  // slot which comes due there down a level, or to |due_|.
+  void Turn();
+
+  // Returns the tick at which the wheel gets to the next non-empty slot of
+  // |level|, which must have one.
+  int64 NextTickOfLevel(int level) const;
+
+  // Stales the ids of the task of the entry at |index|, which is in |due_| or
+  // in no slot, and deletes the task. The entry goes to the free list, or is
+  // marked canceled if it is in |due_|. Must come last in a public method,
+  // since deleting the task may call back into the queue.
+  void Release(int index);
+
+  void AddToFreeList(int index);
+
+  std::vector<Entry> entries_;
+  int free_list_;
+
+  // The heads of the slot lists, -1 if empty. The slots of each level follow
+  // those of the level below.
+  int slots_[kNumLevels * kSlotsPerLevel];
+
+  // A bit for each slot of each level which is not empty.
+  uint64 occupied_[kNumLevels];
+
+  // Heap of the indices of the entries due at or before |current_tick_|.
+  std::vector<int> due_;
+
+  // The wheel's current time, in milliseconds.
+  int64 current_tick_;
+
+  size_t size_;
+  TimeDelta slack_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayedTaskQueue);
+};
+
+}  // namespace base
+
+#endif  // BASE_MESSAGE_LOOP_DELAYED_TASK_QUEUE_H_
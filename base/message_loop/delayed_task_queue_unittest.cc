@@ -0,0 +1,277 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/delayed_task_queue.h"
+
+#include <queue>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/location.h"
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void DoNothing() {
+}
+
+// Counts its deletions, and runs |on_delete| when deleted.
+class DeletionProbe {
+ public:
+  DeletionProbe(int* deletions, const Closure& on_delete)
+      : deletions_(deletions), on_delete_(on_delete) {}
+
+  ~DeletionProbe() {
+    ++*deletions_;
+    if (!on_delete_.is_null())
+      on_delete_.Run();
+  }
+
+  void Run() {}
+
+ private:
+  int* deletions_;
+  Closure on_delete_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeletionProbe);
+};
+
+class DelayedTaskQueueTest : public testing::Test {
+ protected:
+  DelayedTaskQueueTest() : now_(TimeTicks::Now()), next_sequence_num_(0) {}
+
+  PendingTask MakeTask(TimeDelta delay) {
+    return MakeTask(delay, Bind(&DoNothing));
+  }
+
+  PendingTask MakeTask(TimeDelta delay, const Closure& task) {
+    PendingTask pending_task(FROM_HERE, task, now_ + delay, true);
+    pending_task.sequence_num = next_sequence_num_++;
+    return pending_task;
+  }
+
+  // Pops all the tasks, and returns their sequence numbers in order.
+  std::vector<int> PopAll() {
+    std::vector<int> sequence_nums;
+    while (!queue_.empty()) {
+      sequence_nums.push_back(queue_.Top().sequence_num);
+      queue_.Pop();
+    }
+    return sequence_nums;
+  }
+
+  const TimeTicks now_;
+  int next_sequence_num_;
+  DelayedTaskQueue queue_;
+};
+
+TEST_F(DelayedTaskQueueTest, PopsInRunTimeOrder) {
+  // Delays across all the levels of the wheel, several of which run at the
+  // same time, and one which is beyond the reach of the wheel.
+  const int64 kDelaysMs[] = {
+      5, 1, 70, 5, 4000, 0, 63, 64, 4095, 4096, 300000, 5,
+      70, 2, 3600000, 86400000, 5000000000LL, 1, 100000000000LL, 300000,
+  };
+  std::priority_queue<PendingTask> expected_queue;
+  for (size_t i = 0; i < arraysize(kDelaysMs); ++i) {
+    PendingTask pending_task =
+        MakeTask(TimeDelta::FromMilliseconds(kDelaysMs[i]));
+    queue_.Push(pending_task);
+    expected_queue.push(pending_task);
+  }
+  EXPECT_EQ(arraysize(kDelaysMs), queue_.size());
+
+  std::vector<int> expected;
+  for (; !expected_queue.empty(); expected_queue.pop())
+    expected.push_back(expected_queue.top().sequence_num);
+  EXPECT_EQ(expected, PopAll());
+}
+
+TEST_F(DelayedTaskQueueTest, MatchesPriorityQueue) {
+  std::priority_queue<PendingTask> expected_queue;
+  for (int round = 0; round < 50; ++round) {
+    for (int i = 0; i < 200; ++i) {
+      // Within a second, with many tasks in the same millisecond, and
+      // sometimes much further.
+      int64 delay_us = RandInt(0, 1000000);
+      if (RandInt(0, 9) == 0)
+        delay_us = RandInt(0, 1000) * 1000;
+      if (RandInt(0, 19) == 0)
+        delay_us *= 10000;
+      PendingTask pending_task =
+          MakeTask(TimeDelta::FromMicroseconds(delay_us));
+      queue_.Push(pending_task);
+      expected_queue.push(pending_task);
+    }
+    // Pop some, so that the wheel turns while tasks are pushed.
+    for (int i = 0; i < 150; ++i) {
+      ASSERT_EQ(expected_queue.top().sequence_num, queue_.Top().sequence_num);
+      queue_.Pop();
+      expected_queue.pop();
+    }
+    EXPECT_EQ(expected_queue.size(), queue_.size());
+  }
+
+  std::vector<int> expected;
+  for (; !expected_queue.empty(); expected_queue.pop())
+    expected.push_back(expected_queue.top().sequence_num);
+  EXPECT_EQ(expected, PopAll());
+}
+
+// A task pushed with a run time the wheel has turned past still comes first.
+TEST_F(DelayedTaskQueueTest, PushBeforeTop) {
+  queue_.Push(MakeTask(TimeDelta::FromSeconds(10)));
+  EXPECT_EQ(0, queue_.Top().sequence_num);
+  queue_.Push(MakeTask(TimeDelta::FromMilliseconds(5)));
+  queue_.Push(MakeTask(TimeDelta::FromSeconds(5)));
+  queue_.Push(MakeTask(TimeDelta::FromSeconds(10)));
+  EXPECT_EQ(1, queue_.Top().sequence_num);
+
+  std::vector<int> expected;
+  expected.push_back(1);
+  expected.push_back(2);
+  expected.push_back(0);
+  expected.push_back(3);
+  EXPECT_EQ(expected, PopAll());
+}
+
+// NextRunTime() does not turn the wheel past |now|, so a much later task at
+// the top of the queue does not send the tasks pushed after it to the heap,
+// where canceling them would leave their entries behind.
+TEST_F(DelayedTaskQueueTest, NextRunTimeDoesNotTurnPastNow) {
+  const TimeTicks long_run_time = now_ + TimeDelta::FromHours(1);
+  queue_.Push(MakeTask(TimeDelta::FromHours(1)));
+  const TimeTicks now = TimeTicks::Now();
+  const TimeTicks bound = queue_.NextRunTime(now);
+  EXPECT_LT(now, bound);
+  EXPECT_LE(bound, long_run_time);
+
+  for (int i = 0; i < 100000; ++i) {
+    DelayedTaskQueue::TaskId id =
+        queue_.Push(MakeTask(TimeDelta::FromSeconds(1)));
+    EXPECT_LT(now, queue_.NextRunTime(now));
+    EXPECT_TRUE(queue_.Cancel(id));
+  }
+  EXPECT_EQ(1u, queue_.size());
+  EXPECT_EQ(0u, queue_.due_size_for_testing());
+
+  // Once the wheel may turn that far, the time is the task's.
+  EXPECT_EQ(long_run_time, queue_.NextRunTime(long_run_time));
+  EXPECT_EQ(0, queue_.Top().sequence_num);
+}
+
+TEST_F(DelayedTaskQueueTest, Cancel) {
+  int deletions = 0;
+  std::vector<DelayedTaskQueue::TaskId> ids;
+  for (int i = 0; i < 10; ++i) {
+    Closure task = Bind(&DeletionProbe::Run,
+                        Owned(new DeletionProbe(&deletions, Closure())));
+    ids.push_back(queue_.Push(MakeTask(TimeDelta::FromMilliseconds(i), task)));
+    EXPECT_NE(DelayedTaskQueue::kBadTaskId, ids.back());
+  }
+  EXPECT_EQ(0, queue_.Top().sequence_num);
+
+  // Cancel a due task, and tasks in the wheel. They are deleted at once.
+  EXPECT_TRUE(queue_.Cancel(ids[0]));
+  EXPECT_TRUE(queue_.Cancel(ids[5]));
+  EXPECT_TRUE(queue_.Cancel(ids[9]));
+  EXPECT_EQ(3, deletions);
+  EXPECT_EQ(7u, queue_.size());
+  EXPECT_FALSE(queue_.Find(ids[5]));
+  ASSERT_TRUE(queue_.Find(ids[6]));
+  EXPECT_EQ(6, queue_.Find(ids[6])->sequence_num);
+
+  // Canceled and popped tasks can't be canceled again.
+  EXPECT_FALSE(queue_.Cancel(ids[5]));
+  EXPECT_EQ(1, queue_.Top().sequence_num);
+  queue_.Pop();
+  EXPECT_EQ(4, deletions);
+  EXPECT_FALSE(queue_.Cancel(ids[1]));
+  EXPECT_FALSE(queue_.Cancel(DelayedTaskQueue::kBadTaskId));
+
+  // The ids of the entries reused by new tasks stay stale.
+  queue_.Push(MakeTask(TimeDelta::FromMilliseconds(3)));
+  queue_.Push(MakeTask(TimeDelta::FromMilliseconds(3)));
+  EXPECT_FALSE(queue_.Cancel(ids[0]));
+  EXPECT_FALSE(queue_.Cancel(ids[1]));
+  EXPECT_EQ(8u, queue_.size());
+
+  std::vector<int> expected;
+  expected.push_back(2);
+  expected.push_back(3);
+  expected.push_back(10);
+  expected.push_back(11);
+  expected.push_back(4);
+  expected.push_back(6);
+  expected.push_back(7);
+  expected.push_back(8);
+  EXPECT_EQ(expected, PopAll());
+  EXPECT_EQ(10, deletions);
+}
+
+// Deleting a task may cancel or push other tasks.
+TEST_F(DelayedTaskQueueTest, ReentrantDeletion) {
+  int deletions = 0;
+  DelayedTaskQueue::TaskId other_id =
+      queue_.Push(MakeTask(TimeDelta::FromMilliseconds(20)));
+  Closure cancel_other = Bind(IgnoreResult(&DelayedTaskQueue::Cancel),
+                              Unretained(&queue_), other_id);
+  DelayedTaskQueue::TaskId id = queue_.Push(
+      MakeTask(TimeDelta::FromMilliseconds(10),
+               Bind(&DeletionProbe::Run,
+                    Owned(new DeletionProbe(&deletions, cancel_other)))));
+  EXPECT_TRUE(queue_.Cancel(id));
+  EXPECT_EQ(1, deletions);
+  EXPECT_TRUE(queue_.empty());
+
+  Closure push_another =
+      Bind(IgnoreResult(&DelayedTaskQueue::Push), Unretained(&queue_),
+           MakeTask(TimeDelta::FromMilliseconds(5)));
+  queue_.Push(MakeTask(TimeDelta::FromMilliseconds(1),
+                       Bind(&DeletionProbe::Run,
+                            Owned(new DeletionProbe(&deletions,
+                                                    push_another)))));
+  queue_.Pop();
+  EXPECT_EQ(2, deletions);
+  ASSERT_EQ(1u, queue_.size());
+  EXPECT_EQ(2, queue_.Top().sequence_num);
+}
+
+TEST_F(DelayedTaskQueueTest, Slack) {
+  const TimeDelta kSlack = TimeDelta::FromMilliseconds(10);
+  queue_.set_slack(kSlack);
+
+  // The delay to the next multiple of |kSlack|.
+  const int64 slack_us = kSlack.InMicroseconds();
+  const TimeDelta to_boundary = TimeDelta::FromMicroseconds(
+      slack_us - now_.ToInternalValue() % slack_us);
+  const TimeTicks boundary = now_ + to_boundary;
+
+  queue_.Push(MakeTask(to_boundary + TimeDelta::FromMilliseconds(7)));
+  queue_.Push(MakeTask(to_boundary + TimeDelta::FromMilliseconds(3)));
+  queue_.Push(MakeTask(to_boundary + TimeDelta::FromMilliseconds(12)));
+  queue_.Push(MakeTask(to_boundary));
+
+  // The tasks are rounded up to the next multiple of |kSlack|, and those
+  // rounded up to the same run time come out in the order they were pushed.
+  EXPECT_EQ(3, queue_.Top().sequence_num);
+  EXPECT_EQ(boundary, queue_.Top().delayed_run_time);
+  queue_.Pop();
+  EXPECT_EQ(0, queue_.Top().sequence_num);
+  EXPECT_EQ(boundary + kSlack, queue_.Top().delayed_run_time);
+  queue_.Pop();
+  EXPECT_EQ(1, queue_.Top().sequence_num);
+  EXPECT_EQ(boundary + kSlack, queue_.Top().delayed_run_time);
+  queue_.Pop();
+  EXPECT_EQ(2, queue_.Top().sequence_num);
+  EXPECT_EQ(boundary + kSlack * 2, queue_.Top().delayed_run_time);
+}
+
+}  // namespace
+
+}  // namespace base
@@ -80,6 +80,11 @@ bool IncomingTaskQueue::HasHighResolutionTasks() {
   return high_res_task_count_ > 0;
 }
 
+int IncomingTaskQueue::GetNextSequenceNum() {
+  AutoLock lock(incoming_queue_lock_);
+  return next_sequence_num_++;
+}
+
 bool IncomingTaskQueue::IsIdleForTesting() {
   AutoLock lock(incoming_queue_lock_);
   return incoming_queue_.empty();
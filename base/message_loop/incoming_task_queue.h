@@ -42,6 +42,10 @@ class BASE_EXPORT IncomingTaskQueue
   // timer resolution. Currently only needed for Windows.
   bool HasHighResolutionTasks();
 
+  // Returns the sequence number of a delayed task which the message loop adds
+  // to its delayed work queue itself, without going through this queue.
+  int GetNextSequenceNum();
+
   // Returns true if the message loop is "idle". Provided for testing.
   bool IsIdleForTesting();
 
@@ -82,6 +82,10 @@ const LinearHistogram::DescriptionPair event_descriptions_[] = {
 };
 #endif  // !defined(OS_NACL)
 
+// With TIMER_SLACK_MAXIMUM, the run times of delayed tasks are rounded up to
+// a multiple of this.
+const int kMaximumTimerSlackMs = 10;
+
 bool enable_histogrammer_ = false;
 
 MessageLoop::MessagePumpFactory* message_pump_for_ui_factory_ = NULL;
@@ -280,6 +284,38 @@ void MessageLoop::PostNonNestableDelayedTask(
   message_loop_proxy_->PostNonNestableDelayedTask(from_here, task, delay);
 }
 
+DelayedTaskQueue::TaskId MessageLoop::PostCancelableDelayedTask(
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    TimeDelta delay) {
+  DCHECK_EQ(this, current());
+  DCHECK(!task.is_null()) << from_here.ToString();
+  DCHECK(delay > TimeDelta());
+  const TimeTicks now = TimeTicks::Now();
+  PendingTask pending_task(from_here, task, now + delay, true);
+  pending_task.sequence_num = incoming_task_queue_->GetNextSequenceNum();
+#if defined(OS_WIN)
+  // See IncomingTaskQueue::AddToIncomingQueue().
+  if (delay.InMilliseconds() < (2 * Time::kMinLowResolutionThresholdMs)) {
+    pending_task.is_high_res = true;
+    pending_high_res_tasks_++;
+  }
+#endif
+  task_annotator_.DidQueueTask("MessageLoop::PostTask", pending_task);
+
+  return AddToDelayedWorkQueueAndReschedule(pending_task, now);
+}
+
+void MessageLoop::CancelDelayedTask(DelayedTaskQueue::TaskId id) {
+  DCHECK_EQ(this, current());
+#if defined(OS_WIN)
+  const PendingTask* pending_task = delayed_work_queue_.Find(id);
+  if (pending_task && pending_task->is_high_res)
+    pending_high_res_tasks_--;
+#endif
+  delayed_work_queue_.Cancel(id);
+}
+
 void MessageLoop::Run() {
   DCHECK(pump_);
   RunLoop run_loop;
@@ -310,6 +346,14 @@ void MessageLoop::QuitNow() {
   }
 }
 
+void MessageLoop::SetTimerSlack(TimerSlack timer_slack) {
+  delayed_work_queue_.set_slack(
+      timer_slack == TIMER_SLACK_MAXIMUM
+          ? TimeDelta::FromMilliseconds(kMaximumTimerSlackMs)
+          : TimeDelta());
+  pump_->SetTimerSlack(timer_slack);
+}
+
 bool MessageLoop::IsType(Type type) const {
   return type_ == type;
 }
@@ -365,6 +409,10 @@ bool MessageLoop::IsIdleForTesting() {
   return incoming_task_queue_->IsIdleForTesting();
 }
 
+size_t MessageLoop::GetDelayedTaskCountForTesting() const {
+  return delayed_work_queue_.size();
+}
+
 //------------------------------------------------------------------------------
 
 scoped_ptr<MessageLoop> MessageLoop::CreateUnbound(
@@ -479,7 +527,24 @@ bool MessageLoop::DeferOrRunPendingTask(const PendingTask& pending_task) {
 
 void MessageLoop::AddToDelayedWorkQueue(const PendingTask& pending_task) {
   // Move to the delayed work queue.
-  delayed_work_queue_.push(pending_task);
+  delayed_work_queue_.Push(pending_task);
+}
+
+DelayedTaskQueue::TaskId MessageLoop::AddToDelayedWorkQueueAndReschedule(
+    const PendingTask& pending_task,
+    TimeTicks now) {
+  // The pump wakes up at or before the queue's next run time, which is only a
+  // lower bound while the task to run next is not due, so it is compared
+  // before and after the push rather than with the new task's run time.
+  const bool was_empty = delayed_work_queue_.empty();
+  TimeTicks old_run_time;
+  if (!was_empty)
+    old_run_time = delayed_work_queue_.NextRunTime(now);
+  DelayedTaskQueue::TaskId id = delayed_work_queue_.Push(pending_task);
+  const TimeTicks next_run_time = delayed_work_queue_.NextRunTime(now);
+  if (was_empty || next_run_time < old_run_time)
+    pump_->ScheduleDelayedWork(next_run_time);
+  return id;
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -505,8 +570,13 @@ bool MessageLoop::DeletePendingTasks() {
   // code is replicating legacy behavior, and should not be considered
   // absolutely "correct" behavior.  See TODO above about deleting all tasks
   // when it's safe.
-  while (!delayed_work_queue_.empty()) {
-    delayed_work_queue_.pop();
+  //
+  // Deleting a delayed task can post a cancelable one straight to the delayed
+  // work queue, so only the tasks already there are deleted here, and the
+  // destructor's loop gets to the new ones.
+  for (size_t i = delayed_work_queue_.size();
+       i && !delayed_work_queue_.empty(); --i) {
+    delayed_work_queue_.Pop();
   }
   return did_work;
 }
@@ -572,10 +642,9 @@ bool MessageLoop::DoWork() {
       PendingTask pending_task = work_queue_.front();
       work_queue_.pop();
       if (!pending_task.delayed_run_time.is_null()) {
-        AddToDelayedWorkQueue(pending_task);
-        // If we changed the topmost task, then it is time to reschedule.
-        if (delayed_work_queue_.top().task.Equals(pending_task.task))
-          pump_->ScheduleDelayedWork(pending_task.delayed_run_time);
+        // |recent_time_| may be behind, which only keeps the wheel of the
+        // queue from turning as far.
+        AddToDelayedWorkQueueAndReschedule(pending_task, recent_time_);
       } else {
         if (DeferOrRunPendingTask(pending_task))
           return true;
@@ -599,21 +668,25 @@ bool MessageLoop::DoDelayedWork(TimeTicks* next_delayed_work_time) {
   // that are ready to run before calling it again.  As a result, the more we
   // fall behind (and have a lot of ready-to-run delayed tasks), the more
   // efficient we'll be at handling the tasks.
-
-  TimeTicks next_run_time = delayed_work_queue_.top().delayed_run_time;
+  //
+  // The queue does not look past |recent_time_| for the task to run next, so
+  // the time it returns may be earlier than that task's, and the pump then
+  // wakes up early and asks again.
+  TimeTicks next_run_time = delayed_work_queue_.NextRunTime(recent_time_);
   if (next_run_time > recent_time_) {
     recent_time_ = TimeTicks::Now();  // Get a better view of Now();
+    next_run_time = delayed_work_queue_.NextRunTime(recent_time_);
     if (next_run_time > recent_time_) {
       *next_delayed_work_time = next_run_time;
       return false;
     }
   }
 
-  PendingTask pending_task = delayed_work_queue_.top();
-  delayed_work_queue_.pop();
+  PendingTask pending_task = delayed_work_queue_.Top();
+  delayed_work_queue_.Pop();
 
   if (!delayed_work_queue_.empty())
-    *next_delayed_work_time = delayed_work_queue_.top().delayed_run_time;
+    *next_delayed_work_time = delayed_work_queue_.NextRunTime(recent_time_);
 
   return DeferOrRunPendingTask(pending_task);
 }
@@ -15,6 +15,7 @@
 #include "base/location.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/message_loop/delayed_task_queue.h"
 #include "base/message_loop/incoming_task_queue.h"
 #include "base/message_loop/message_loop_proxy.h"
 #include "base/message_loop/message_loop_proxy_impl.h"
@@ -192,6 +193,20 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
                                   const Closure& task,
                                   TimeDelta delay);
 
+  // Like PostDelayedTask(), but must be called on this loop's thread, and
+  // returns an id with which CancelDelayedTask() takes the task out of the
+  // delayed work queue. |delay| must be positive. Timer posts its tasks this
+  // way, so that the tasks it abandons don't wait in the queue until they
+  // are due.
+  DelayedTaskQueue::TaskId PostCancelableDelayedTask(
+      const tracked_objects::Location& from_here,
+      const Closure& task,
+      TimeDelta delay);
+
+  // Deletes the task posted by PostCancelableDelayedTask() with |id|, unless
+  // it has already run. Must be called on this loop's thread.
+  void CancelDelayedTask(DelayedTaskQueue::TaskId id);
+
   // A variant on PostTask that deletes the given object.  This is useful
   // if the object needs to live until the next run of the MessageLoop (for
   // example, deleting a RenderProcessHost from within an IPC callback is not
@@ -277,10 +292,10 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
   // arbitrary MessageLoop to QuitWhenIdle.
   static Closure QuitWhenIdleClosure();
 
-  // Set the timer slack for this message loop.
-  void SetTimerSlack(TimerSlack timer_slack) {
-    pump_->SetTimerSlack(timer_slack);
-  }
+  // Set the timer slack for this message loop. TIMER_SLACK_MAXIMUM also
+  // coalesces the delayed tasks due within a few milliseconds of each other,
+  // so that they run on the same wake-up.
+  void SetTimerSlack(TimerSlack timer_slack);
 
   // Returns true if this loop is |type|. This allows subclasses (especially
   // those in tests) to specialize how they are identified.
@@ -395,6 +410,10 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
   // Returns true if the message loop is "idle". Provided for testing.
   bool IsIdleForTesting();
 
+  // Returns the number of tasks waiting in the delayed work queue, which
+  // PostCancelableDelayedTask() adds to directly. Provided for testing.
+  size_t GetDelayedTaskCountForTesting() const;
+
   // Returns the TaskAnnotator which is used to add debug information to posted
   // tasks.
   debug::TaskAnnotator* task_annotator() { return &task_annotator_; }
@@ -449,6 +468,12 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
   // Adds the pending task to delayed_work_queue_.
   void AddToDelayedWorkQueue(const PendingTask& pending_task);
 
+  // Adds the pending task to delayed_work_queue_, and has the pump wake up
+  // earlier if the task moves up the queue's next run time as of |now|.
+  DelayedTaskQueue::TaskId AddToDelayedWorkQueueAndReschedule(
+      const PendingTask& pending_task,
+      TimeTicks now);
+
   // Delete tasks that haven't run yet without running them.  Used in the
   // destructor to make sure all the task's destructors get called.  Returns
   // true if some work was done.
@@ -924,6 +924,42 @@ TEST(MessageLoopTest, IsType) {
   EXPECT_FALSE(loop.IsType(MessageLoop::TYPE_DEFAULT));
 }
 
+namespace {
+
+void RecordRunOrder(int value, std::vector<int>* order) {
+  order->push_back(value);
+}
+
+}  // namespace
+
+TEST(MessageLoopTest, CancelDelayedTask) {
+  MessageLoop loop;
+  std::vector<int> order;
+  scoped_refptr<Foo> foo(new Foo());
+  DelayedTaskQueue::TaskId canceled = loop.PostCancelableDelayedTask(
+      FROM_HERE, Bind(&Foo::Test1ConstRef, foo, std::string("a")),
+      TimeDelta::FromMilliseconds(1));
+  loop.PostCancelableDelayedTask(FROM_HERE, Bind(&RecordRunOrder, 2, &order),
+                                 TimeDelta::FromMilliseconds(20));
+  loop.PostDelayedTask(FROM_HERE, Bind(&RecordRunOrder, 1, &order),
+                       TimeDelta::FromMilliseconds(10));
+
+  // The canceled task is deleted at once.
+  loop.CancelDelayedTask(canceled);
+  EXPECT_TRUE(foo->HasOneRef());
+
+  loop.PostDelayedTask(FROM_HERE, MessageLoop::QuitWhenIdleClosure(),
+                       TimeDelta::FromMilliseconds(30));
+  loop.Run();
+  EXPECT_EQ(0, foo->test_count());
+  ASSERT_EQ(2u, order.size());
+  EXPECT_EQ(1, order[0]);
+  EXPECT_EQ(2, order[1]);
+
+  // Canceling it again does nothing.
+  loop.CancelDelayedTask(canceled);
+}
+
 #if defined(OS_WIN)
 void EmptyFunction() {}
 
@@ -2,15 +2,20 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <queue>
+#include <vector>
+
 #include "base/bind.h"
 #include "base/format_macros.h"
 #include "base/memory/scoped_vector.h"
+#include "base/message_loop/delayed_task_queue.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
 #include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_test.h"
@@ -285,4 +290,166 @@ TEST_F(PostTaskTest, OneHundredTasksPerReload) {
   Run(1000, 100);
 }
 
+// The number of timers kept pending by the tests below, like the timers of a
+// busy service.
+const int kNumPendingTimers = 100000;
+
+// Returns the delay of the |i|th timer: most are due within 100ms, and the
+// rest within 10s. The delays are the same on each run, so that each queue
+// gets the same work.
+TimeDelta PendingTimerDelay(int i) {
+  const uint32 hash = static_cast<uint32>(i) * 2654435761u;
+  return TimeDelta::FromMicroseconds(hash % (i % 4 ? 100000 : 10000000));
+}
+
+// std::priority_queue<PendingTask>, which MessageLoop used to keep its delayed
+// tasks in. A task can't be taken out of it, so a canceled task stays until it
+// is due, and is only dropped then, like an abandoned Timer task.
+class PriorityQueueAdapter {
+ public:
+  typedef int TaskId;
+
+  TaskId Push(const PendingTask& pending_task) {
+    queue_.push(pending_task);
+    canceled_.push_back(false);
+    return pending_task.sequence_num;
+  }
+
+  void Cancel(TaskId id) { canceled_[id] = true; }
+
+  // Pops the next task which is not canceled. Returns false if there is none.
+  bool PopLive() {
+    while (!queue_.empty()) {
+      const bool canceled = canceled_[queue_.top().sequence_num];
+      queue_.pop();
+      if (!canceled)
+        return true;
+    }
+    return false;
+  }
+
+  size_t size() const { return queue_.size(); }
+
+ private:
+  std::priority_queue<PendingTask> queue_;
+  std::vector<bool> canceled_;
+};
+
+class DelayedTaskQueueAdapter {
+ public:
+  typedef DelayedTaskQueue::TaskId TaskId;
+
+  TaskId Push(const PendingTask& pending_task) {
+    return queue_.Push(pending_task);
+  }
+
+  void Cancel(TaskId id) { queue_.Cancel(id); }
+
+  bool PopLive() {
+    if (queue_.empty())
+      return false;
+    queue_.Pop();
+    return true;
+  }
+
+  size_t size() const { return queue_.size(); }
+
+ private:
+  DelayedTaskQueue queue_;
+};
+
+class PendingTimersTest : public testing::Test {
+ public:
+  // Pushes kNumPendingTimers delayed tasks to a Queue, then replaces each with
+  // a new one, the way a timer is restarted, and then pops them all.
+  template <typename Queue>
+  void RunQueueTest(const std::string& name) {
+    Queue queue;
+    std::vector<typename Queue::TaskId> ids(kNumPendingTimers);
+    const TimeTicks now = TimeTicks::Now();
+    const Closure task = Bind(&DoNothing);
+    int sequence_num = 0;
+
+    TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kNumPendingTimers; ++i) {
+      PendingTask pending_task(
+          FROM_HERE, task, now + PendingTimerDelay(i), true);
+      pending_task.sequence_num = sequence_num++;
+      ids[i] = queue.Push(pending_task);
+    }
+    PrintTime(name + "_post", TimeTicks::Now() - start);
+
+    start = TimeTicks::Now();
+    for (int i = 0; i < kNumPendingTimers; ++i) {
+      queue.Cancel(ids[i]);
+      PendingTask pending_task(
+          FROM_HERE, task, now + PendingTimerDelay(i + kNumPendingTimers),
+          true);
+      pending_task.sequence_num = sequence_num++;
+      ids[i] = queue.Push(pending_task);
+    }
+    PrintTime(name + "_restart", TimeTicks::Now() - start);
+    perf_test::PrintResult("task", "", name + "_queued_after_restart",
+                           queue.size(), "tasks", true);
+
+    start = TimeTicks::Now();
+    int num_run = 0;
+    while (queue.PopLive())
+      num_run++;
+    PrintTime(name + "_run", TimeTicks::Now() - start);
+    EXPECT_EQ(kNumPendingTimers, num_run);
+  }
+
+  // Starts kNumPendingTimers Timers on a MessageLoop, restarts each with a
+  // shorter delay, which abandons its task, and then destroys them.
+  void RunTimerTest() {
+    MessageLoop loop(scoped_ptr<MessagePump>(new FakeMessagePump));
+    MessagePump::Delegate* delegate = &loop;
+    ScopedVector<Timer> timers;
+    for (int i = 0; i < kNumPendingTimers; ++i)
+      timers.push_back(new Timer(false, false));
+
+    TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kNumPendingTimers; ++i) {
+      timers[i]->Start(FROM_HERE,
+                       TimeDelta::FromSeconds(10) + PendingTimerDelay(i),
+                       Bind(&DoNothing));
+    }
+    // Move the tasks which went through the incoming queue to the delayed
+    // work queue.
+    delegate->DoWork();
+    PrintTime("Timer_start", TimeTicks::Now() - start);
+
+    start = TimeTicks::Now();
+    for (int i = 0; i < kNumPendingTimers; ++i)
+      timers[i]->Start(FROM_HERE, PendingTimerDelay(i), Bind(&DoNothing));
+    delegate->DoWork();
+    PrintTime("Timer_restart", TimeTicks::Now() - start);
+
+    start = TimeTicks::Now();
+    timers.clear();
+    PrintTime("Timer_destroy", TimeTicks::Now() - start);
+  }
+
+ private:
+  void PrintTime(const std::string& name, TimeDelta time) {
+    perf_test::PrintResult(
+        "task", "", name + "_time ",
+        time.InMicroseconds() / static_cast<double>(kNumPendingTimers),
+        "us/task", true);
+  }
+};
+
+TEST_F(PendingTimersTest, PriorityQueue) {
+  RunQueueTest<PriorityQueueAdapter>("PriorityQueue");
+}
+
+TEST_F(PendingTimersTest, DelayedTaskQueue) {
+  RunQueueTest<DelayedTaskQueueAdapter>("DelayedTaskQueue");
+}
+
+TEST_F(PendingTimersTest, Timers) {
+  RunTimerTest();
+}
+
 }  // namespace base
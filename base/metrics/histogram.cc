@@ -18,6 +18,7 @@
 #include "base/debug/alias.h"
 #include "base/logging.h"
 #include "base/metrics/sample_vector.h"
+#include "base/metrics/shared_histogram_allocator.h"
 #include "base/metrics/statistics_recorder.h"
 #include "base/pickle.h"
 #include "base/strings/string_util.h"
@@ -90,7 +91,16 @@ HistogramBase* Histogram::FactoryGet(const std::string& name,
       InspectConstructionArguments(name, &minimum, &maximum, &bucket_count);
   DCHECK(valid_arguments);
 
-  HistogramBase* histogram = StatisticsRecorder::FindHistogram(name);
+  // Histograms recorded in the shared arena, if any, are found without taking
+  // the StatisticsRecorder's lock.
+  HistogramBase* histogram = nullptr;
+  if (SharedHistogramAllocator* allocator =
+          SharedHistogramAllocator::GetGlobal()) {
+    histogram = allocator->GetOrCreateHistogram(
+        HISTOGRAM, name, minimum, maximum, bucket_count, flags);
+  }
+  if (!histogram)
+    histogram = StatisticsRecorder::FindHistogram(name);
   if (!histogram) {
     // To avoid racy destruction at shutdown, the following will be leaked.
     BucketRanges* ranges = new BucketRanges(bucket_count + 1);
@@ -310,6 +320,19 @@ Histogram::Histogram(const std::string& name,
     samples_.reset(new SampleVector(ranges));
 }
 
+Histogram::Histogram(const std::string& name,
+                     Sample minimum,
+                     Sample maximum,
+                     const BucketRanges* ranges,
+                     AtomicCount* counts,
+                     HistogramSamples::Metadata* meta)
+  : HistogramBase(name),
+    bucket_ranges_(ranges),
+    declared_min_(minimum),
+    declared_max_(maximum),
+    samples_(new SampleVector(ranges, counts, meta)) {
+}
+
 Histogram::~Histogram() {
 }
 
@@ -542,7 +565,16 @@ HistogramBase* LinearHistogram::FactoryGetWithRangeDescription(
       name, &minimum, &maximum, &bucket_count);
   DCHECK(valid_arguments);
 
-  HistogramBase* histogram = StatisticsRecorder::FindHistogram(name);
+  // Shared histograms can't have range descriptions, which only exist in the
+  // process that sets them.
+  HistogramBase* histogram = nullptr;
+  SharedHistogramAllocator* allocator = SharedHistogramAllocator::GetGlobal();
+  if (allocator && !descriptions) {
+    histogram = allocator->GetOrCreateHistogram(
+        LINEAR_HISTOGRAM, name, minimum, maximum, bucket_count, flags);
+  }
+  if (!histogram)
+    histogram = StatisticsRecorder::FindHistogram(name);
   if (!histogram) {
     // To avoid racy destruction at shutdown, the following will be leaked.
     BucketRanges* ranges = new BucketRanges(bucket_count + 1);
@@ -591,6 +623,15 @@ LinearHistogram::LinearHistogram(const std::string& name,
     : Histogram(name, minimum, maximum, ranges) {
 }
 
+LinearHistogram::LinearHistogram(const std::string& name,
+                                 Sample minimum,
+                                 Sample maximum,
+                                 const BucketRanges* ranges,
+                                 AtomicCount* counts,
+                                 HistogramSamples::Metadata* meta)
+    : Histogram(name, minimum, maximum, ranges, counts, meta) {
+}
+
 double LinearHistogram::GetBucketSize(Count current, size_t i) const {
   DCHECK_GT(ranges(i + 1), ranges(i));
   // Adjacent buckets with different widths would have "surprisingly" many (few)
@@ -181,6 +181,15 @@ class BASE_EXPORT Histogram : public HistogramBase {
             Sample maximum,
             const BucketRanges* ranges);
 
+  // Like the above, but records the samples in |counts| and |meta|, which
+  // outlive the histogram (see SampleVector).
+  Histogram(const std::string& name,
+            Sample minimum,
+            Sample maximum,
+            const BucketRanges* ranges,
+            AtomicCount* counts,
+            HistogramSamples::Metadata* meta);
+
   ~Histogram() override;
 
   // HistogramBase implementation:
@@ -205,6 +214,7 @@ class BASE_EXPORT Histogram : public HistogramBase {
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, CorruptSampleCounts);
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, NameMatchTest);
 
+  friend class SharedHistogramAllocator;  // To create shared histograms.
   friend class StatisticsRecorder;  // To allow it to delete duplicates.
   friend class StatisticsRecorderTest;
 
@@ -307,6 +317,12 @@ class BASE_EXPORT LinearHistogram : public Histogram {
                   Sample minimum,
                   Sample maximum,
                   const BucketRanges* ranges);
+  LinearHistogram(const std::string& name,
+                  Sample minimum,
+                  Sample maximum,
+                  const BucketRanges* ranges,
+                  AtomicCount* counts,
+                  HistogramSamples::Metadata* meta);
 
   double GetBucketSize(Count current, size_t i) const override;
 
@@ -319,6 +335,8 @@ class BASE_EXPORT LinearHistogram : public Histogram {
   bool PrintEmptyBucket(size_t index) const override;
 
  private:
+  friend class SharedHistogramAllocator;  // To create shared histograms.
+
   friend BASE_EXPORT_PRIVATE HistogramBase* DeserializeHistogramInfo(
       base::PickleIterator* iter);
   static HistogramBase* DeserializeInfoImpl(base::PickleIterator* iter);
@@ -59,16 +59,21 @@ void SampleCountPickleIterator::Get(HistogramBase::Sample* min,
 
 }  // namespace
 
-HistogramSamples::HistogramSamples() : sum_(0), redundant_count_(0) {}
+HistogramSamples::HistogramSamples() : meta_(&local_meta_) {
+  local_meta_.sum = 0;
+  local_meta_.redundant_count = 0;
+}
+
+HistogramSamples::HistogramSamples(Metadata* meta) : meta_(meta) {
+  local_meta_.sum = 0;
+  local_meta_.redundant_count = 0;
+}
 
 HistogramSamples::~HistogramSamples() {}
 
 void HistogramSamples::Add(const HistogramSamples& other) {
-  sum_ += other.sum();
-  HistogramBase::Count old_redundant_count =
-      subtle::NoBarrier_Load(&redundant_count_);
-  subtle::NoBarrier_Store(&redundant_count_,
-      old_redundant_count + other.redundant_count());
+  IncreaseSum(other.sum());
+  IncreaseRedundantCount(other.redundant_count());
   bool success = AddSubtractImpl(other.Iterator().get(), ADD);
   DCHECK(success);
 }
@@ -79,29 +84,22 @@ bool HistogramSamples::AddFromPickle(PickleIterator* iter) {
 
   if (!iter->ReadInt64(&sum) || !iter->ReadInt(&redundant_count))
     return false;
-  sum_ += sum;
-  HistogramBase::Count old_redundant_count =
-      subtle::NoBarrier_Load(&redundant_count_);
-  subtle::NoBarrier_Store(&redundant_count_,
-                          old_redundant_count + redundant_count);
+  IncreaseSum(sum);
+  IncreaseRedundantCount(redundant_count);
 
   SampleCountPickleIterator pickle_iter(iter);
   return AddSubtractImpl(&pickle_iter, ADD);
 }
 
 void HistogramSamples::Subtract(const HistogramSamples& other) {
-  sum_ -= other.sum();
-  HistogramBase::Count old_redundant_count =
-      subtle::NoBarrier_Load(&redundant_count_);
-  subtle::NoBarrier_Store(&redundant_count_,
-                          old_redundant_count - other.redundant_count());
+  IncreaseSum(-other.sum());
+  IncreaseRedundantCount(-other.redundant_count());
   bool success = AddSubtractImpl(other.Iterator().get(), SUBTRACT);
   DCHECK(success);
 }
 
 bool HistogramSamples::Serialize(Pickle* pickle) const {
-  if (!pickle->WriteInt64(sum_) ||
-      !pickle->WriteInt(subtle::NoBarrier_Load(&redundant_count_)))
+  if (!pickle->WriteInt64(sum()) || !pickle->WriteInt(redundant_count()))
     return false;
 
   HistogramBase::Sample min;
@@ -119,13 +117,24 @@ bool HistogramSamples::Serialize(Pickle* pickle) const {
   return true;
 }
 
+int64 HistogramSamples::sum() const {
+#if defined(ARCH_CPU_64_BITS)
+  return subtle::NoBarrier_Load(&meta_->sum);
+#else
+  return meta_->sum;
+#endif
+}
+
 void HistogramSamples::IncreaseSum(int64 diff) {
-  sum_ += diff;
+#if defined(ARCH_CPU_64_BITS)
+  subtle::NoBarrier_AtomicIncrement(&meta_->sum, diff);
+#else
+  meta_->sum += diff;
+#endif
 }
 
 void HistogramSamples::IncreaseRedundantCount(HistogramBase::Count diff) {
-  subtle::NoBarrier_Store(&redundant_count_,
-      subtle::NoBarrier_Load(&redundant_count_) + diff);
+  subtle::NoBarrier_AtomicIncrement(&meta_->redundant_count, diff);
 }
 
 SampleCountIterator::~SampleCountIterator() {}
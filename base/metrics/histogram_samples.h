@@ -5,9 +5,11 @@
 #ifndef BASE_METRICS_HISTOGRAM_SAMPLES_H_
 #define BASE_METRICS_HISTOGRAM_SAMPLES_H_
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "base/metrics/histogram_base.h"
 #include "base/memory/scoped_ptr.h"
+#include "build/build_config.h"
 
 namespace base {
 
@@ -18,7 +20,29 @@ class SampleCountIterator;
 // HistogramSamples is a container storing all samples of a histogram.
 class BASE_EXPORT HistogramSamples {
  public:
+  // The sum and redundant count of the samples. They may be stored outside of
+  // the object, e.g. in shared memory (see SharedHistogramAllocator), and are
+  // updated atomically where the platform allows it.
+  struct Metadata {
+#if defined(ARCH_CPU_64_BITS)
+    subtle::Atomic64 sum;
+#else
+    int64 sum;
+#endif
+
+    // |redundant_count| helps identify memory corruption. It redundantly
+    // stores the total number of samples accumulated in the histogram. We can
+    // compare this count to the sum of the counts (TotalCount() function), and
+    // detect problems. Note, depending on the implementation of different
+    // histogram types, there might be races during histogram accumulation and
+    // snapshotting that we choose to accept. In this case, the tallies might
+    // mismatch even when no memory corruption has happened.
+    HistogramBase::AtomicCount redundant_count;
+  };
+
   HistogramSamples();
+  // Uses |meta|, which must outlive this object, instead of its own storage.
+  explicit HistogramSamples(Metadata* meta);
   virtual ~HistogramSamples();
 
   virtual void Accumulate(HistogramBase::Sample value,
@@ -37,9 +61,9 @@ class BASE_EXPORT HistogramSamples {
   virtual bool Serialize(Pickle* pickle) const;
 
   // Accessor fuctions.
-  int64 sum() const { return sum_; }
+  int64 sum() const;
   HistogramBase::Count redundant_count() const {
-    return subtle::NoBarrier_Load(&redundant_count_);
+    return subtle::NoBarrier_Load(&meta_->redundant_count);
   }
 
  protected:
@@ -51,16 +75,8 @@ class BASE_EXPORT HistogramSamples {
   void IncreaseRedundantCount(HistogramBase::Count diff);
 
  private:
-  int64 sum_;
-
-  // |redundant_count_| helps identify memory corruption. It redundantly stores
-  // the total number of samples accumulated in the histogram. We can compare
-  // this count to the sum of the counts (TotalCount() function), and detect
-  // problems. Note, depending on the implementation of different histogram
-  // types, there might be races during histogram accumulation and snapshotting
-  // that we choose to accept. In this case, the tallies might mismatch even
-  // when no memory corruption has happened.
-  HistogramBase::AtomicCount redundant_count_;
+  Metadata local_meta_;
+  Metadata* const meta_;
 };
 
 class BASE_EXPORT SampleCountIterator {
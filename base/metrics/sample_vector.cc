@@ -13,7 +13,19 @@ typedef HistogramBase::Count Count;
 typedef HistogramBase::Sample Sample;
 
 SampleVector::SampleVector(const BucketRanges* bucket_ranges)
-    : counts_(bucket_ranges->bucket_count()),
+    : local_counts_(bucket_ranges->bucket_count()),
+      counts_(local_counts_.empty() ? nullptr : &local_counts_[0]),
+      counts_size_(local_counts_.size()),
+      bucket_ranges_(bucket_ranges) {
+  CHECK_GE(bucket_ranges_->bucket_count(), 1u);
+}
+
+SampleVector::SampleVector(const BucketRanges* bucket_ranges,
+                           HistogramBase::AtomicCount* counts,
+                           Metadata* meta)
+    : HistogramSamples(meta),
+      counts_(counts),
+      counts_size_(bucket_ranges->bucket_count()),
       bucket_ranges_(bucket_ranges) {
   CHECK_GE(bucket_ranges_->bucket_count(), 1u);
 }
@@ -22,8 +34,7 @@ SampleVector::~SampleVector() {}
 
 void SampleVector::Accumulate(Sample value, Count count) {
   size_t bucket_index = GetBucketIndex(value);
-  subtle::NoBarrier_Store(&counts_[bucket_index],
-      subtle::NoBarrier_Load(&counts_[bucket_index]) + count);
+  subtle::NoBarrier_AtomicIncrement(&counts_[bucket_index], count);
   IncreaseSum(count * value);
   IncreaseRedundantCount(count);
 }
@@ -35,20 +46,20 @@ Count SampleVector::GetCount(Sample value) const {
 
 Count SampleVector::TotalCount() const {
   Count count = 0;
-  for (size_t i = 0; i < counts_.size(); i++) {
+  for (size_t i = 0; i < counts_size_; i++) {
     count += subtle::NoBarrier_Load(&counts_[i]);
   }
   return count;
 }
 
 Count SampleVector::GetCountAtIndex(size_t bucket_index) const {
-  DCHECK(bucket_index < counts_.size());
+  DCHECK(bucket_index < counts_size_);
   return subtle::NoBarrier_Load(&counts_[bucket_index]);
 }
 
 scoped_ptr<SampleCountIterator> SampleVector::Iterator() const {
   return scoped_ptr<SampleCountIterator>(
-      new SampleVectorIterator(&counts_, bucket_ranges_));
+      new SampleVectorIterator(counts_, counts_size_, bucket_ranges_));
 }
 
 bool SampleVector::AddSubtractImpl(SampleCountIterator* iter,
@@ -59,15 +70,13 @@ bool SampleVector::AddSubtractImpl(SampleCountIterator* iter,
 
   // Go through the iterator and add the counts into correct bucket.
   size_t index = 0;
-  while (index < counts_.size() && !iter->Done()) {
+  while (index < counts_size_ && !iter->Done()) {
     iter->Get(&min, &max, &count);
     if (min == bucket_ranges_->range(index) &&
         max == bucket_ranges_->range(index + 1)) {
       // Sample matches this bucket!
-      HistogramBase::Count old_counts =
-          subtle::NoBarrier_Load(&counts_[index]);
-      subtle::NoBarrier_Store(&counts_[index],
-          old_counts + ((op ==  HistogramSamples::ADD) ? count : -count));
+      subtle::NoBarrier_AtomicIncrement(
+          &counts_[index], (op == HistogramSamples::ADD) ? count : -count);
       iter->Next();
     } else if (min > bucket_ranges_->range(index)) {
       // Sample is larger than current bucket range. Try next.
@@ -111,17 +120,29 @@ size_t SampleVector::GetBucketIndex(Sample value) const {
 
 SampleVectorIterator::SampleVectorIterator(const std::vector<Count>* counts,
                                            const BucketRanges* bucket_ranges)
+    : counts_(counts->empty() ? nullptr : &(*counts)[0]),
+      counts_size_(counts->size()),
+      bucket_ranges_(bucket_ranges),
+      index_(0) {
+  CHECK_GE(bucket_ranges_->bucket_count(), counts_size_);
+  SkipEmptyBuckets();
+}
+
+SampleVectorIterator::SampleVectorIterator(const Count* counts,
+                                           size_t counts_size,
+                                           const BucketRanges* bucket_ranges)
     : counts_(counts),
+      counts_size_(counts_size),
       bucket_ranges_(bucket_ranges),
       index_(0) {
-  CHECK_GE(bucket_ranges_->bucket_count(), counts_->size());
+  CHECK_GE(bucket_ranges_->bucket_count(), counts_size_);
   SkipEmptyBuckets();
 }
 
 SampleVectorIterator::~SampleVectorIterator() {}
 
 bool SampleVectorIterator::Done() const {
-  return index_ >= counts_->size();
+  return index_ >= counts_size_;
 }
 
 void SampleVectorIterator::Next() {
@@ -139,7 +160,7 @@ void SampleVectorIterator::Get(HistogramBase::Sample* min,
   if (max != NULL)
     *max = bucket_ranges_->range(index_ + 1);
   if (count != NULL)
-    *count = subtle::NoBarrier_Load(&(*counts_)[index_]);
+    *count = subtle::NoBarrier_Load(&counts_[index_]);
 }
 
 bool SampleVectorIterator::GetBucketIndex(size_t* index) const {
@@ -153,8 +174,8 @@ void SampleVectorIterator::SkipEmptyBuckets() {
   if (Done())
     return;
 
-  while (index_ < counts_->size()) {
-    if (subtle::NoBarrier_Load(&(*counts_)[index_]) != 0)
+  while (index_ < counts_size_) {
+    if (subtle::NoBarrier_Load(&counts_[index_]) != 0)
       return;
     index_++;
   }
@@ -3,7 +3,9 @@
 // found in the LICENSE file.
 
 // SampleVector implements HistogramSamples interface. It is used by all
-// Histogram based classes to store samples.
+// Histogram based classes to store samples. Its counts are updated with atomic
+// increments, so that samples can be accumulated from several threads (or
+// processes, when the counts are in shared memory) without losing any.
 
 #ifndef BASE_METRICS_SAMPLE_VECTOR_H_
 #define BASE_METRICS_SAMPLE_VECTOR_H_
@@ -23,6 +25,12 @@ class BucketRanges;
 class BASE_EXPORT_PRIVATE SampleVector : public HistogramSamples {
  public:
   explicit SampleVector(const BucketRanges* bucket_ranges);
+  // Stores the samples in |counts|, which must have
+  // |bucket_ranges->bucket_count()| elements, and |meta|. Neither is owned;
+  // both must outlive this object.
+  SampleVector(const BucketRanges* bucket_ranges,
+               HistogramBase::AtomicCount* counts,
+               Metadata* meta);
   ~SampleVector() override;
 
   // HistogramSamples implementation:
@@ -45,7 +53,10 @@ class BASE_EXPORT_PRIVATE SampleVector : public HistogramSamples {
  private:
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, CorruptSampleCounts);
 
-  std::vector<HistogramBase::AtomicCount> counts_;
+  // Storage for |counts_|, unless it is external.
+  std::vector<HistogramBase::AtomicCount> local_counts_;
+  HistogramBase::AtomicCount* const counts_;
+  const size_t counts_size_;
 
   // Shares the same BucketRanges with Histogram object.
   const BucketRanges* const bucket_ranges_;
@@ -57,6 +68,9 @@ class BASE_EXPORT_PRIVATE SampleVectorIterator : public SampleCountIterator {
  public:
   SampleVectorIterator(const std::vector<HistogramBase::AtomicCount>* counts,
                        const BucketRanges* bucket_ranges);
+  SampleVectorIterator(const HistogramBase::AtomicCount* counts,
+                       size_t counts_size,
+                       const BucketRanges* bucket_ranges);
   ~SampleVectorIterator() override;
 
   // SampleCountIterator implementation:
@@ -72,7 +86,8 @@ class BASE_EXPORT_PRIVATE SampleVectorIterator : public SampleCountIterator {
  private:
   void SkipEmptyBuckets();
 
-  const std::vector<HistogramBase::AtomicCount>* counts_;
+  const HistogramBase::AtomicCount* counts_;
+  size_t counts_size_;
   const BucketRanges* bucket_ranges_;
 
   size_t index_;
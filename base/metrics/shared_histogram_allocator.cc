@@ -0,0 +1,343 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/shared_histogram_allocator.h"
+
+#include <string.h>
+
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/statistics_recorder.h"
+
+namespace base {
+
+namespace {
+
+const uint32 kArenaMagic = 0x48495354;  // "HIST".
+const uint32 kArenaVersion = 1;
+
+// Records are aligned for the 64-bit sum in their metadata.
+const size_t kRecordAlignment = 8;
+
+size_t AlignRecordSize(size_t num_bytes) {
+  return (num_bytes + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+subtle::AtomicWord g_allocator = 0;
+
+static_assert(!(SharedHistogramAllocator::kMaxHistograms &
+                (SharedHistogramAllocator::kMaxHistograms - 1)),
+              "kMaxHistograms must be a power of two");
+
+}  // namespace
+
+// static
+const size_t SharedHistogramAllocator::kMaxHistograms;
+// static
+const size_t SharedHistogramAllocator::kMaxNameLength;
+
+// The arena starts with this header, followed by the records.
+struct SharedHistogramAllocator::ArenaHeader {
+  uint32 magic;
+  uint32 version;
+  // Number of bytes allocated so far, including this header.
+  subtle::Atomic32 num_bytes_used;
+  // Offsets of the published records, indexed by the hash of their name (with
+  // linear probing), or 0 for free slots.
+  subtle::Atomic32 slots[kMaxHistograms];
+};
+
+// A record is this header, followed by its |bucket_count| counts and then its
+// name. Only the counts and the metadata change once it is published.
+struct SharedHistogramAllocator::RecordHeader {
+  uint32 name_hash;
+  uint32 name_length;
+  int32 type;
+  HistogramBase::Sample minimum;
+  HistogramBase::Sample maximum;
+  uint32 bucket_count;
+  HistogramSamples::Metadata meta;
+
+  HistogramBase::AtomicCount* counts() {
+    return reinterpret_cast<HistogramBase::AtomicCount*>(this + 1);
+  }
+  const char* name() const {
+    return reinterpret_cast<const char*>(this + 1) +
+           bucket_count * sizeof(HistogramBase::AtomicCount);
+  }
+  static size_t GetSize(size_t bucket_count, size_t name_length) {
+    return AlignRecordSize(sizeof(RecordHeader) +
+                           bucket_count * sizeof(HistogramBase::AtomicCount) +
+                           name_length);
+  }
+};
+
+SharedHistogramAllocator::HistogramData::HistogramData()
+    : type(HISTOGRAM), minimum(0), maximum(0), sum(0) {}
+
+SharedHistogramAllocator::HistogramData::~HistogramData() {}
+
+SharedHistogramAllocator::SharedHistogramAllocator(void* memory,
+                                                   size_t num_bytes)
+    : memory_(static_cast<char*>(memory)),
+      num_bytes_(num_bytes),
+      header_(static_cast<ArenaHeader*>(memory)) {
+  memset(histograms_, 0, sizeof(histograms_));
+}
+
+SharedHistogramAllocator::~SharedHistogramAllocator() {}
+
+// static
+scoped_ptr<SharedHistogramAllocator> SharedHistogramAllocator::Create(
+    void* memory,
+    size_t num_bytes) {
+  DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(memory) % kRecordAlignment);
+  if (num_bytes < AlignRecordSize(sizeof(ArenaHeader)) ||
+      num_bytes > static_cast<size_t>(kint32max)) {
+    return scoped_ptr<SharedHistogramAllocator>();
+  }
+
+  ArenaHeader* header = static_cast<ArenaHeader*>(memory);
+  memset(header, 0, sizeof(ArenaHeader));
+  header->magic = kArenaMagic;
+  header->version = kArenaVersion;
+  subtle::Release_Store(&header->num_bytes_used,
+                        AlignRecordSize(sizeof(ArenaHeader)));
+  return make_scoped_ptr(new SharedHistogramAllocator(memory, num_bytes));
+}
+
+// static
+scoped_ptr<SharedHistogramAllocator> SharedHistogramAllocator::Attach(
+    void* memory,
+    size_t num_bytes) {
+  const ArenaHeader* header = static_cast<const ArenaHeader*>(memory);
+  if (num_bytes < AlignRecordSize(sizeof(ArenaHeader)) ||
+      num_bytes > static_cast<size_t>(kint32max) ||
+      header->magic != kArenaMagic || header->version != kArenaVersion) {
+    return scoped_ptr<SharedHistogramAllocator>();
+  }
+  return make_scoped_ptr(new SharedHistogramAllocator(memory, num_bytes));
+}
+
+// static
+void SharedHistogramAllocator::SetGlobal(
+    scoped_ptr<SharedHistogramAllocator> allocator) {
+  DCHECK(allocator);
+  // Histograms refer to the allocator's memory, so it is leaked.
+  subtle::AtomicWord old = subtle::Release_CompareAndSwap(
+      &g_allocator, 0, reinterpret_cast<subtle::AtomicWord>(allocator.get()));
+  DCHECK(!old) << "The global histogram allocator can only be set once";
+  if (!old)
+    ignore_result(allocator.release());
+}
+
+// static
+SharedHistogramAllocator* SharedHistogramAllocator::GetGlobal() {
+  return reinterpret_cast<SharedHistogramAllocator*>(
+      subtle::Acquire_Load(&g_allocator));
+}
+
+HistogramBase* SharedHistogramAllocator::GetOrCreateHistogram(
+    HistogramType type,
+    const std::string& name,
+    HistogramBase::Sample minimum,
+    HistogramBase::Sample maximum,
+    size_t bucket_count,
+    int32 flags) {
+  DCHECK(type == HISTOGRAM || type == LINEAR_HISTOGRAM);
+  if (name.size() > kMaxNameLength ||
+      bucket_count >= Histogram::kBucketCount_MAX) {
+    return nullptr;
+  }
+
+  uint32 name_hash = Hash(name);
+  size_t slot = FindSlot(name, name_hash, 0);
+  if (slot == kMaxHistograms) {
+    uint32 offset =
+        AllocateRecord(type, name, name_hash, minimum, maximum, bucket_count);
+    if (!offset)
+      return nullptr;
+    // If another thread published a record for |name| first, ours is wasted.
+    slot = FindSlot(name, name_hash, offset);
+    if (slot == kMaxHistograms)
+      return nullptr;
+  }
+
+  RecordHeader* record =
+      GetRecord(subtle::Acquire_Load(&header_->slots[slot]));
+  if (!record || record->type != type || record->minimum != minimum ||
+      record->maximum != maximum || record->bucket_count != bucket_count) {
+    DLOG(ERROR) << "Shared histogram " << name
+                << " has bad construction arguments";
+    return nullptr;
+  }
+
+  // This is the fast path once the histogram has been used in this process.
+  HistogramBase* histogram = reinterpret_cast<HistogramBase*>(
+      subtle::Acquire_Load(&histograms_[slot]));
+  if (histogram)
+    return histogram;
+
+  // To avoid racy destruction at shutdown, the following will be leaked.
+  BucketRanges* ranges = new BucketRanges(bucket_count + 1);
+  if (type == HISTOGRAM)
+    Histogram::InitializeBucketRanges(minimum, maximum, ranges);
+  else
+    LinearHistogram::InitializeBucketRanges(minimum, maximum, ranges);
+  const BucketRanges* registered_ranges =
+      StatisticsRecorder::RegisterOrDeleteDuplicateRanges(ranges);
+
+  Histogram* tentative_histogram;
+  if (type == HISTOGRAM) {
+    tentative_histogram =
+        new Histogram(name, minimum, maximum, registered_ranges,
+                      record->counts(), &record->meta);
+  } else {
+    tentative_histogram =
+        new LinearHistogram(name, minimum, maximum, registered_ranges,
+                            record->counts(), &record->meta);
+  }
+  tentative_histogram->SetFlags(flags);
+  // If a heap histogram named |name| was registered before the arena was
+  // set, that one is returned (and cached).
+  histogram =
+      StatisticsRecorder::RegisterOrDeleteDuplicate(tentative_histogram);
+
+  // Threads racing to get here get the same registered histogram.
+  subtle::AtomicWord cached = subtle::Release_CompareAndSwap(
+      &histograms_[slot], 0, reinterpret_cast<subtle::AtomicWord>(histogram));
+  return cached ? reinterpret_cast<HistogramBase*>(cached) : histogram;
+}
+
+void SharedHistogramAllocator::GetHistograms(
+    std::vector<HistogramData>* histograms) const {
+  for (size_t slot = 0; slot < kMaxHistograms; slot++) {
+    RecordHeader* record =
+        GetRecord(subtle::Acquire_Load(&header_->slots[slot]));
+    if (!record)
+      continue;
+
+    // Copy what is validated, in case the writer changes it.
+    HistogramType type = static_cast<HistogramType>(record->type);
+    HistogramBase::Sample minimum = record->minimum;
+    HistogramBase::Sample maximum = record->maximum;
+    size_t bucket_count = record->bucket_count;
+    size_t name_length = record->name_length;
+    if ((type != HISTOGRAM && type != LINEAR_HISTOGRAM) || minimum < 1 ||
+        maximum >= HistogramBase::kSampleType_MAX || minimum >= maximum ||
+        bucket_count < 3 || bucket_count >= Histogram::kBucketCount_MAX ||
+        static_cast<int64>(bucket_count) >
+            static_cast<int64>(maximum) - minimum + 2 ||
+        name_length > kMaxNameLength) {
+      DLOG(WARNING) << "Skipping bad shared histogram in slot " << slot;
+      continue;
+    }
+    size_t offset = reinterpret_cast<char*>(record) - memory_;
+    if (RecordHeader::GetSize(bucket_count, name_length) > num_bytes_ - offset)
+      continue;
+
+    BucketRanges ranges(bucket_count + 1);
+    if (type == HISTOGRAM)
+      Histogram::InitializeBucketRanges(minimum, maximum, &ranges);
+    else
+      LinearHistogram::InitializeBucketRanges(minimum, maximum, &ranges);
+
+    histograms->push_back(HistogramData());
+    HistogramData* data = &histograms->back();
+    data->name.assign(reinterpret_cast<const char*>(record + 1) +
+                          bucket_count * sizeof(HistogramBase::AtomicCount),
+                      name_length);
+    data->type = type;
+    data->minimum = minimum;
+    data->maximum = maximum;
+#if defined(ARCH_CPU_64_BITS)
+    data->sum = subtle::NoBarrier_Load(&record->meta.sum);
+#else
+    data->sum = record->meta.sum;
+#endif
+    data->ranges.resize(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+      data->ranges[i] = ranges.range(i);
+    data->counts.resize(bucket_count);
+    const HistogramBase::AtomicCount* counts = record->counts();
+    for (size_t i = 0; i < bucket_count; i++)
+      data->counts[i] = subtle::NoBarrier_Load(&counts[i]);
+  }
+}
+
+size_t SharedHistogramAllocator::FindSlot(const std::string& name,
+                                          uint32 name_hash,
+                                          uint32 new_record_offset) {
+  for (size_t i = 0; i < kMaxHistograms; i++) {
+    size_t slot = (name_hash + i) & (kMaxHistograms - 1);
+    uint32 offset = subtle::Acquire_Load(&header_->slots[slot]);
+    if (!offset) {
+      if (!new_record_offset)
+        return kMaxHistograms;
+      if (!subtle::Release_CompareAndSwap(&header_->slots[slot], 0,
+                                          new_record_offset)) {
+        return slot;
+      }
+      // Another record was published in the slot first; it may be for |name|.
+      offset = subtle::Acquire_Load(&header_->slots[slot]);
+    }
+
+    const RecordHeader* record = GetRecord(offset);
+    if (record && record->name_hash == name_hash &&
+        record->name_length == name.size() &&
+        RecordHeader::GetSize(record->bucket_count, name.size()) <=
+            num_bytes_ - offset &&
+        !memcmp(record->name(), name.data(), name.size())) {
+      return slot;
+    }
+  }
+  return kMaxHistograms;
+}
+
+uint32 SharedHistogramAllocator::AllocateRecord(HistogramType type,
+                                                const std::string& name,
+                                                uint32 name_hash,
+                                                HistogramBase::Sample minimum,
+                                                HistogramBase::Sample maximum,
+                                                size_t bucket_count) {
+  size_t size = RecordHeader::GetSize(bucket_count, name.size());
+  subtle::Atomic32 offset = subtle::NoBarrier_Load(&header_->num_bytes_used);
+  for (;;) {
+    if (offset <= 0 || size > num_bytes_ ||
+        static_cast<size_t>(offset) > num_bytes_ - size) {
+      return 0;
+    }
+    subtle::Atomic32 old_offset = subtle::NoBarrier_CompareAndSwap(
+        &header_->num_bytes_used, offset,
+        offset + static_cast<subtle::Atomic32>(size));
+    if (old_offset == offset)
+      break;
+    offset = old_offset;
+  }
+
+  RecordHeader* record = reinterpret_cast<RecordHeader*>(memory_ + offset);
+  memset(record, 0, size);
+  record->name_hash = name_hash;
+  record->name_length = static_cast<uint32>(name.size());
+  record->type = type;
+  record->minimum = minimum;
+  record->maximum = maximum;
+  record->bucket_count = static_cast<uint32>(bucket_count);
+  memcpy(const_cast<char*>(record->name()), name.data(), name.size());
+  return static_cast<uint32>(offset);
+}
+
+SharedHistogramAllocator::RecordHeader* SharedHistogramAllocator::GetRecord(
+    uint32 offset) const {
+  if (offset < AlignRecordSize(sizeof(ArenaHeader)) ||
+      offset % kRecordAlignment || offset > num_bytes_ - sizeof(RecordHeader)) {
+    return nullptr;
+  }
+  return reinterpret_cast<RecordHeader*>(memory_ + offset);
+}
+
+}  // namespace base
@@ -0,0 +1,134 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SharedHistogramAllocator lays out histograms in a caller-provided block of
+// memory (the "arena"), typically shared memory, so that another process can
+// read them directly instead of having them serialized to it.
+//
+// The arena only uses atomic operations: records are allocated by bumping an
+// offset, and published by storing their offset in an open-addressing index
+// keyed by the hash of their name. It can thus be written concurrently from
+// several threads, several copies of base in a process (e.g. a mojo child
+// process and the application it runs) or several processes, and read while it
+// is being written. Records are never freed.
+//
+// Once the arena is installed with |SetGlobal()|, Histogram::FactoryGet() and
+// LinearHistogram::FactoryGet() (and so the UMA_HISTOGRAM_* macros) create
+// their histograms in it. Looking a histogram up then only takes the
+// StatisticsRecorder's lock the first time it is used in the process, to
+// register it.
+
+#ifndef BASE_METRICS_SHARED_HISTOGRAM_ALLOCATOR_H_
+#define BASE_METRICS_SHARED_HISTOGRAM_ALLOCATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram_base.h"
+
+namespace base {
+
+class BASE_EXPORT SharedHistogramAllocator {
+ public:
+  // Maximum number of histograms in an arena.
+  static const size_t kMaxHistograms = 1024;
+  // Maximum length of the name of a histogram in an arena.
+  static const size_t kMaxNameLength = 256;
+
+  // A copy of a histogram read from an arena.
+  struct BASE_EXPORT HistogramData {
+    HistogramData();
+    ~HistogramData();
+
+    std::string name;
+    HistogramType type;
+    HistogramBase::Sample minimum;
+    HistogramBase::Sample maximum;
+    int64 sum;
+    // The |counts.size() + 1| boundaries of the buckets.
+    std::vector<HistogramBase::Sample> ranges;
+    std::vector<HistogramBase::Count> counts;
+  };
+
+  ~SharedHistogramAllocator();
+
+  // Formats the |num_bytes| at |memory| as an empty arena. Returns null if
+  // |num_bytes| is too small.
+  static scoped_ptr<SharedHistogramAllocator> Create(void* memory,
+                                                     size_t num_bytes);
+
+  // Uses the arena formatted by |Create()| at |memory|, possibly in another
+  // process. Returns null if |memory| doesn't hold an arena. Only
+  // |GetHistograms()| may be used if |memory| is read-only.
+  static scoped_ptr<SharedHistogramAllocator> Attach(void* memory,
+                                                     size_t num_bytes);
+
+  // Makes |allocator| the arena histograms are created in, for the rest of the
+  // life of the process. This should be called before any histogram is used,
+  // since histograms which already exist stay in the heap.
+  static void SetGlobal(scoped_ptr<SharedHistogramAllocator> allocator);
+
+  // Returns the arena set with |SetGlobal()|, or null.
+  static SharedHistogramAllocator* GetGlobal();
+
+  // Returns the histogram of |type| (HISTOGRAM or LINEAR_HISTOGRAM) named
+  // |name| recorded in the arena, creating it in the arena and registering it
+  // with the StatisticsRecorder the first time it is used in this process.
+  // Afterwards, this doesn't take any lock. Returns null if the histogram can't
+  // be in the arena (e.g. it is full, or has a histogram with the same name
+  // but other arguments); the caller should then use a heap histogram.
+  HistogramBase* GetOrCreateHistogram(HistogramType type,
+                                      const std::string& name,
+                                      HistogramBase::Sample minimum,
+                                      HistogramBase::Sample maximum,
+                                      size_t bucket_count,
+                                      int32 flags);
+
+  // Appends a copy of each histogram published in the arena to |histograms|.
+  // The arena isn't trusted: records which are inconsistent are skipped.
+  void GetHistograms(std::vector<HistogramData>* histograms) const;
+
+ private:
+  struct ArenaHeader;
+  struct RecordHeader;
+
+  SharedHistogramAllocator(void* memory, size_t num_bytes);
+
+  // Returns the index of the slot holding the record for |name|, publishing
+  // the record at |new_record_offset| in a free slot if there is none and
+  // it isn't 0. Returns |kMaxHistograms| if there is no such slot.
+  size_t FindSlot(const std::string& name,
+                  uint32 name_hash,
+                  uint32 new_record_offset);
+
+  // Allocates and initializes (but doesn't publish) a record, returning its
+  // offset, or 0 if the arena is full.
+  uint32 AllocateRecord(HistogramType type,
+                        const std::string& name,
+                        uint32 name_hash,
+                        HistogramBase::Sample minimum,
+                        HistogramBase::Sample maximum,
+                        size_t bucket_count);
+
+  // Returns the record at |offset|, or null if it doesn't fit in the arena.
+  RecordHeader* GetRecord(uint32 offset) const;
+
+  char* const memory_;
+  const size_t num_bytes_;
+  ArenaHeader* const header_;
+
+  // The HistogramBase objects, in this process, of the records published in
+  // each slot (or null if they haven't been created yet).
+  subtle::AtomicWord histograms_[kMaxHistograms];
+
+  DISALLOW_COPY_AND_ASSIGN(SharedHistogramAllocator);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_SHARED_HISTOGRAM_ALLOCATOR_H_
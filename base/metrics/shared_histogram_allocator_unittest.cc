@@ -0,0 +1,237 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/shared_histogram_allocator.h"
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const size_t kArenaSize = 64 * 1024;
+
+class AddSamplesDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  AddSamplesDelegate(HistogramBase* histogram, int num_samples)
+      : histogram_(histogram), num_samples_(num_samples) {}
+  ~AddSamplesDelegate() override {}
+
+  void Run() override {
+    for (int i = 0; i < num_samples_; i++)
+      histogram_->Add(i % 100);
+  }
+
+ private:
+  HistogramBase* const histogram_;
+  const int num_samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddSamplesDelegate);
+};
+
+}  // namespace
+
+class SharedHistogramAllocatorTest : public testing::Test {
+ protected:
+  SharedHistogramAllocatorTest() : memory_(kArenaSize / sizeof(uint64)) {}
+
+  void* memory() { return &memory_[0]; }
+
+ private:
+  std::vector<uint64> memory_;
+};
+
+TEST_F(SharedHistogramAllocatorTest, RecordAndRead) {
+  scoped_ptr<SharedHistogramAllocator> allocator =
+      SharedHistogramAllocator::Create(memory(), kArenaSize);
+  ASSERT_TRUE(allocator);
+
+  HistogramBase* histogram = allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Exponential", 1, 1000, 10, HistogramBase::kNoFlags);
+  ASSERT_TRUE(histogram);
+  EXPECT_EQ(HISTOGRAM, histogram->GetHistogramType());
+  EXPECT_TRUE(histogram->HasConstructionArguments(1, 1000, 10));
+  histogram->Add(1);
+  histogram->Add(5);
+  histogram->Add(5);
+  histogram->Add(2000);
+
+  // Looking it up again doesn't create another histogram.
+  EXPECT_EQ(histogram, allocator->GetOrCreateHistogram(
+                           HISTOGRAM, "Shared.Exponential", 1, 1000, 10,
+                           HistogramBase::kNoFlags));
+
+  HistogramBase* linear_histogram = allocator->GetOrCreateHistogram(
+      LINEAR_HISTOGRAM, "Shared.Linear", 1, 10, 11, HistogramBase::kNoFlags);
+  ASSERT_TRUE(linear_histogram);
+  EXPECT_EQ(LINEAR_HISTOGRAM, linear_histogram->GetHistogramType());
+  linear_histogram->Add(3);
+
+  // The samples are in the arena, as seen from the histogram...
+  scoped_ptr<HistogramSamples> samples = histogram->SnapshotSamples();
+  EXPECT_EQ(4, samples->TotalCount());
+  EXPECT_EQ(4, samples->redundant_count());
+  EXPECT_EQ(2011, samples->sum());
+  EXPECT_EQ(2, samples->GetCount(5));
+
+  // ... and from another view of the arena.
+  scoped_ptr<SharedHistogramAllocator> reader =
+      SharedHistogramAllocator::Attach(memory(), kArenaSize);
+  ASSERT_TRUE(reader);
+  std::vector<SharedHistogramAllocator::HistogramData> histograms;
+  reader->GetHistograms(&histograms);
+  ASSERT_EQ(2u, histograms.size());
+  const SharedHistogramAllocator::HistogramData* exponential =
+      histograms[0].name == "Shared.Exponential" ? &histograms[0]
+                                                 : &histograms[1];
+  const SharedHistogramAllocator::HistogramData* linear =
+      histograms[0].name == "Shared.Linear" ? &histograms[0] : &histograms[1];
+
+  EXPECT_EQ("Shared.Exponential", exponential->name);
+  EXPECT_EQ(HISTOGRAM, exponential->type);
+  EXPECT_EQ(1, exponential->minimum);
+  EXPECT_EQ(1000, exponential->maximum);
+  EXPECT_EQ(2011, exponential->sum);
+  ASSERT_EQ(10u, exponential->counts.size());
+  ASSERT_EQ(11u, exponential->ranges.size());
+  const Histogram* casted_histogram = static_cast<const Histogram*>(histogram);
+  HistogramBase::Count total_count = 0;
+  for (size_t i = 0; i < exponential->counts.size(); i++) {
+    EXPECT_EQ(casted_histogram->ranges(i), exponential->ranges[i]);
+    EXPECT_EQ(samples->GetCount(exponential->ranges[i]),
+              exponential->counts[i]);
+    total_count += exponential->counts[i];
+  }
+  EXPECT_EQ(4, total_count);
+  EXPECT_EQ(HistogramBase::kSampleType_MAX, exponential->ranges.back());
+
+  EXPECT_EQ("Shared.Linear", linear->name);
+  EXPECT_EQ(LINEAR_HISTOGRAM, linear->type);
+  EXPECT_EQ(3, linear->sum);
+  ASSERT_EQ(11u, linear->counts.size());
+  EXPECT_EQ(3, linear->ranges[3]);
+  EXPECT_EQ(1, linear->counts[3]);
+}
+
+// Several copies of base (or processes) can record into the same arena.
+TEST_F(SharedHistogramAllocatorTest, SeveralWriters) {
+  scoped_ptr<SharedHistogramAllocator> allocator =
+      SharedHistogramAllocator::Create(memory(), kArenaSize);
+  ASSERT_TRUE(allocator);
+  scoped_ptr<SharedHistogramAllocator> other_allocator =
+      SharedHistogramAllocator::Attach(memory(), kArenaSize);
+  ASSERT_TRUE(other_allocator);
+
+  HistogramBase* histogram = allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Writers", 1, 100, 10, HistogramBase::kNoFlags);
+  ASSERT_TRUE(histogram);
+  HistogramBase* other_histogram = other_allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Writers", 1, 100, 10, HistogramBase::kNoFlags);
+  ASSERT_TRUE(other_histogram);
+  histogram->Add(10);
+  other_histogram->Add(10);
+
+  std::vector<SharedHistogramAllocator::HistogramData> histograms;
+  allocator->GetHistograms(&histograms);
+  ASSERT_EQ(1u, histograms.size());
+  EXPECT_EQ(20, histograms[0].sum);
+  EXPECT_EQ(2, histogram->SnapshotSamples()->GetCount(10));
+}
+
+TEST_F(SharedHistogramAllocatorTest, ConcurrentSamples) {
+  scoped_ptr<SharedHistogramAllocator> allocator =
+      SharedHistogramAllocator::Create(memory(), kArenaSize);
+  ASSERT_TRUE(allocator);
+  HistogramBase* histogram = allocator->GetOrCreateHistogram(
+      LINEAR_HISTOGRAM, "Shared.Concurrent", 1, 100, 101,
+      HistogramBase::kNoFlags);
+  ASSERT_TRUE(histogram);
+
+  const int kNumThreads = 4;
+  const int kNumSamples = 10000;
+  AddSamplesDelegate delegate(histogram, kNumSamples);
+  DelegateSimpleThreadPool pool("shared_histogram", kNumThreads);
+  pool.AddWork(&delegate, kNumThreads);
+  pool.Start();
+  pool.JoinAll();
+
+  // No increment is lost.
+  scoped_ptr<HistogramSamples> samples = histogram->SnapshotSamples();
+  EXPECT_EQ(kNumThreads * kNumSamples, samples->TotalCount());
+  EXPECT_EQ(kNumThreads * kNumSamples, samples->redundant_count());
+  EXPECT_EQ(kNumThreads * kNumSamples / 100, samples->GetCount(42));
+}
+
+TEST_F(SharedHistogramAllocatorTest, BadArguments) {
+  scoped_ptr<SharedHistogramAllocator> allocator =
+      SharedHistogramAllocator::Create(memory(), kArenaSize);
+  ASSERT_TRUE(allocator);
+  ASSERT_TRUE(allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Arguments", 1, 100, 10, HistogramBase::kNoFlags));
+
+  // A histogram with the same name but other arguments isn't shared.
+  EXPECT_FALSE(allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Arguments", 1, 100, 20, HistogramBase::kNoFlags));
+  EXPECT_FALSE(allocator->GetOrCreateHistogram(
+      LINEAR_HISTOGRAM, "Shared.Arguments", 1, 100, 10,
+      HistogramBase::kNoFlags));
+
+  // Nor is one with too long a name.
+  std::string long_name(SharedHistogramAllocator::kMaxNameLength + 1, 'x');
+  EXPECT_FALSE(allocator->GetOrCreateHistogram(HISTOGRAM, long_name, 1, 100, 10,
+                                               HistogramBase::kNoFlags));
+}
+
+TEST_F(SharedHistogramAllocatorTest, Full) {
+  // Too small for even the header.
+  EXPECT_FALSE(SharedHistogramAllocator::Create(memory(), 64));
+
+  const size_t kSmallArenaSize = 8 * 1024;
+  scoped_ptr<SharedHistogramAllocator> allocator =
+      SharedHistogramAllocator::Create(memory(), kSmallArenaSize);
+  ASSERT_TRUE(allocator);
+  size_t num_histograms = 0;
+  while (allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Full" + std::string(num_histograms, 'x'), 1, 1000,
+      50, HistogramBase::kNoFlags)) {
+    num_histograms++;
+    ASSERT_LT(num_histograms, SharedHistogramAllocator::kMaxHistograms);
+  }
+  EXPECT_GT(num_histograms, 0u);
+
+  std::vector<SharedHistogramAllocator::HistogramData> histograms;
+  allocator->GetHistograms(&histograms);
+  EXPECT_EQ(num_histograms, histograms.size());
+}
+
+TEST_F(SharedHistogramAllocatorTest, Corrupted) {
+  // Memory which doesn't hold an arena is rejected.
+  EXPECT_FALSE(SharedHistogramAllocator::Attach(memory(), kArenaSize));
+
+  scoped_ptr<SharedHistogramAllocator> allocator =
+      SharedHistogramAllocator::Create(memory(), kArenaSize);
+  ASSERT_TRUE(allocator);
+  ASSERT_TRUE(allocator->GetOrCreateHistogram(
+      HISTOGRAM, "Shared.Corrupted", 1, 100, 10, HistogramBase::kNoFlags));
+
+  // Point every free slot of the index at the end of the arena: the readers
+  // skip them.
+  uint32* words = reinterpret_cast<uint32*>(memory());
+  for (size_t i = 0; i < SharedHistogramAllocator::kMaxHistograms; i++) {
+    if (!words[3 + i])
+      words[3 + i] = kArenaSize - 8;
+  }
+  std::vector<SharedHistogramAllocator::HistogramData> histograms;
+  allocator->GetHistograms(&histograms);
+  ASSERT_EQ(1u, histograms.size());
+  EXPECT_EQ("Shared.Corrupted", histograms[0].name);
+}
+
+}  // namespace base
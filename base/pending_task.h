@@ -16,7 +16,8 @@
 namespace base {
 
 // Contains data about a pending task. Stored in TaskQueue and DelayedTaskQueue
-// for use by classes that queue and execute tasks.
+// (see base/message_loop/delayed_task_queue.h) for use by classes that queue
+// and execute tasks.
 struct BASE_EXPORT PendingTask : public TrackingInfo {
   PendingTask(const tracked_objects::Location& posted_from,
               const Closure& task);
@@ -52,9 +53,6 @@ class BASE_EXPORT TaskQueue : public std::queue<PendingTask> {
   void Swap(TaskQueue* queue);
 };
 
-// PendingTasks are sorted by their |delayed_run_time| property.
-typedef std::priority_queue<base::PendingTask> DelayedTaskQueue;
-
 }  // namespace base
 
 #endif  // BASE_PENDING_TASK_H_
@@ -186,6 +186,7 @@ class BASE_EXPORT ThreadRestrictions {
   friend class MessagePumpDefault;
   friend class SequencedWorkerPool;
   friend class SimpleThread;
+  friend class WorkStealingPool;
   friend class Thread;
   friend class ThreadTestHelper;
   friend class PlatformThread;
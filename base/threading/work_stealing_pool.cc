@@ -0,0 +1,896 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/work_stealing_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <queue>
+#include <vector>
+
+#include "base/atomic_sequence_num.h"
+#include "base/atomicops.h"
+#include "base/callback.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/sequenced_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread_local.h"
+#include "base/threading/thread_restrictions.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "base/tracked_objects.h"
+
+namespace base {
+
+namespace {
+
+const int kNumPriorities = WorkStealingPool::PRIORITY_LAST + 1;
+
+// Sequences are spread over this many maps, each with its own lock.
+const int kNumSequenceShards = 16;
+
+// A task queued on a worker or in a sequence. Only the sequences are queued
+// on the workers, not their tasks: a WorkerTask with a |sequence_token_id|
+// and no |task| on a worker stands for the next task of that sequence.
+struct WorkerTask {
+  WorkerTask()
+      : sequence_token_id(0),
+        priority(WorkStealingPool::PRIORITY_NORMAL),
+        shutdown_behavior(WorkStealingPool::BLOCK_SHUTDOWN) {}
+
+  tracked_objects::Location posted_from;
+  Closure task;
+  int sequence_token_id;
+  WorkStealingPool::Priority priority;
+  WorkStealingPool::WorkerShutdown shutdown_behavior;
+};
+
+struct DelayedWorkerTask {
+  WorkerTask task;
+  TimeTicks run_time;
+  // Keeps the tasks with the same |run_time| in posting order.
+  int64 sequence_num;
+};
+
+struct DelayedWorkerTaskGreater {
+  bool operator()(const DelayedWorkerTask& lhs,
+                  const DelayedWorkerTask& rhs) const {
+    if (lhs.run_time != rhs.run_time)
+      return lhs.run_time > rhs.run_time;
+    return lhs.sequence_num > rhs.sequence_num;
+  }
+};
+
+typedef std::priority_queue<DelayedWorkerTask,
+                            std::vector<DelayedWorkerTask>,
+                            DelayedWorkerTaskGreater> DelayedWorkerTaskQueue;
+
+// WorkStealingPoolTaskRunner -------------------------------------------------
+// A TaskRunner which posts tasks to a WorkStealingPool with a fixed priority
+// and shutdown behavior.
+class WorkStealingPoolTaskRunner : public TaskRunner {
+ public:
+  WorkStealingPoolTaskRunner(const scoped_refptr<WorkStealingPool>& pool,
+                             WorkStealingPool::Priority priority,
+                             WorkStealingPool::WorkerShutdown shutdown_behavior)
+      : pool_(pool),
+        priority_(priority),
+        shutdown_behavior_(shutdown_behavior) {}
+
+  // TaskRunner implementation
+  bool PostDelayedTask(const tracked_objects::Location& from_here,
+                       const Closure& task,
+                       TimeDelta delay) override {
+    return pool_->PostPrioritizedTask(WorkStealingPool::SequenceToken(),
+                                      priority_, shutdown_behavior_, from_here,
+                                      task, delay);
+  }
+
+  bool RunsTasksOnCurrentThread() const override {
+    return pool_->RunsTasksOnCurrentThread();
+  }
+
+ private:
+  ~WorkStealingPoolTaskRunner() override {}
+
+  const scoped_refptr<WorkStealingPool> pool_;
+  const WorkStealingPool::Priority priority_;
+  const WorkStealingPool::WorkerShutdown shutdown_behavior_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingPoolTaskRunner);
+};
+
+// WorkStealingPoolSequencedTaskRunner ----------------------------------------
+// A SequencedTaskRunner which posts tasks to a WorkStealingPool with a fixed
+// sequence token, priority and shutdown behavior.
+class WorkStealingPoolSequencedTaskRunner : public SequencedTaskRunner {
+ public:
+  WorkStealingPoolSequencedTaskRunner(
+      const scoped_refptr<WorkStealingPool>& pool,
+      WorkStealingPool::SequenceToken token,
+      WorkStealingPool::Priority priority,
+      WorkStealingPool::WorkerShutdown shutdown_behavior)
+      : pool_(pool),
+        token_(token),
+        priority_(priority),
+        shutdown_behavior_(shutdown_behavior) {}
+
+  // TaskRunner implementation
+  bool PostDelayedTask(const tracked_objects::Location& from_here,
+                       const Closure& task,
+                       TimeDelta delay) override {
+    return pool_->PostPrioritizedTask(token_, priority_, shutdown_behavior_,
+                                      from_here, task, delay);
+  }
+
+  bool RunsTasksOnCurrentThread() const override {
+    return pool_->IsRunningSequenceOnCurrentThread(token_);
+  }
+
+  // SequencedTaskRunner implementation
+  bool PostNonNestableDelayedTask(const tracked_objects::Location& from_here,
+                                  const Closure& task,
+                                  TimeDelta delay) override {
+    // There's no way to run nested tasks, so simply forward to
+    // PostDelayedTask.
+    return PostDelayedTask(from_here, task, delay);
+  }
+
+ private:
+  ~WorkStealingPoolSequencedTaskRunner() override {}
+
+  const scoped_refptr<WorkStealingPool> pool_;
+  const WorkStealingPool::SequenceToken token_;
+  const WorkStealingPool::Priority priority_;
+  const WorkStealingPool::WorkerShutdown shutdown_behavior_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingPoolSequencedTaskRunner);
+};
+
+}  // namespace
+
+// Worker ----------------------------------------------------------------------
+
+class WorkStealingPool::Worker : public PlatformThread::Delegate {
+ public:
+  Worker(WorkStealingPool* pool,
+         Inner* inner,
+         size_t index,
+         const std::string& name)
+      : pool_(pool),
+        inner_(inner),
+        index_(index),
+        name_(name),
+        num_pushed_(0),
+        num_done_(0),
+        sleeping_(0),
+        wake_up_(false, false),
+        running_sequence_token_id_(0) {}
+  ~Worker() override {}
+
+  // Starts the thread, which holds a reference to the pool until it exits.
+  void Start() {
+    pool_->AddRef();
+    CHECK(PlatformThread::CreateNonJoinable(0, this));
+  }
+
+  size_t index() const { return index_; }
+
+  // Queues |task| after the other tasks of its priority.
+  void Push(const WorkerTask& task) {
+    AutoLock lock(lock_);
+    queues_[task.priority].push_back(task);
+    subtle::Release_Store(&num_pushed_, num_pushed_ + 1);
+  }
+
+  // Takes the oldest task of |priority|; this is how the worker itself gets
+  // its tasks.
+  bool Pop(int priority, WorkerTask* task) {
+    AutoLock lock(lock_);
+    std::deque<WorkerTask>& queue = queues_[priority];
+    if (queue.empty())
+      return false;
+    *task = queue.front();
+    queue.pop_front();
+    return true;
+  }
+
+  // Takes the newest task of |priority|, which the worker would get to last;
+  // this is how the other workers steal its tasks.
+  bool Steal(int priority, WorkerTask* task) {
+    AutoLock lock(lock_);
+    std::deque<WorkerTask>& queue = queues_[priority];
+    if (queue.empty())
+      return false;
+    *task = queue.back();
+    queue.pop_back();
+    return true;
+  }
+
+  // Called by the worker once it has run or deleted a task it got from
+  // Pop() or Steal().
+  void DidCompleteTask() { subtle::Release_Store(&num_done_, num_done_ + 1); }
+
+  // The number of tasks pushed to this worker, and the number of tasks
+  // completed by this worker, which may have been pushed to another one.
+  uint32 num_pushed() const {
+    return static_cast<uint32>(subtle::Acquire_Load(&num_pushed_));
+  }
+  uint32 num_done() const {
+    return static_cast<uint32>(subtle::Acquire_Load(&num_done_));
+  }
+
+  // Called by the worker before it checks for work one last time and waits
+  // for |wake_up_|, and once it is awake.
+  void SetSleeping(bool sleeping) {
+    subtle::NoBarrier_Store(&sleeping_, sleeping);
+    subtle::MemoryBarrier();
+  }
+
+  // Wakes the worker up if it is sleeping; returns false if it isn't. Must be
+  // called after a barrier following the change which the worker should see.
+  bool WakeUpIfSleeping() {
+    if (subtle::NoBarrier_CompareAndSwap(&sleeping_, 1, 0) != 1)
+      return false;
+    wake_up_.Signal();
+    return true;
+  }
+
+  void WakeUp() { wake_up_.Signal(); }
+
+  void Sleep(TimeDelta max_time) {
+    if (max_time == TimeDelta::Max())
+      wake_up_.Wait();
+    else
+      wake_up_.TimedWait(std::max(max_time, TimeDelta()));
+  }
+
+  // Only used on the worker's thread.
+  int running_sequence_token_id() const { return running_sequence_token_id_; }
+  void set_running_sequence_token_id(int id) {
+    running_sequence_token_id_ = id;
+  }
+
+  // PlatformThread::Delegate implementation.
+  void ThreadMain() override;
+
+ private:
+  WorkStealingPool* const pool_;
+  Inner* const inner_;
+  const size_t index_;
+  const std::string name_;
+
+  Lock lock_;
+  std::deque<WorkerTask> queues_[kNumPriorities];
+
+  // These are only counted for FlushForTesting(). |num_pushed_| is written
+  // under |lock_|, and |num_done_| by the worker's thread.
+  subtle::Atomic32 num_pushed_;
+  subtle::Atomic32 num_done_;
+
+  subtle::Atomic32 sleeping_;
+  WaitableEvent wake_up_;
+
+  // The sequence of the task being run, or 0.
+  int running_sequence_token_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+// Inner -----------------------------------------------------------------------
+
+class WorkStealingPool::Inner {
+ public:
+  Inner(WorkStealingPool* pool,
+        size_t num_threads,
+        const std::string& thread_name_prefix);
+  ~Inner();
+
+  int GetSequenceTokenId() { return last_sequence_token_id_.GetNext() + 1; }
+
+  bool PostTask(int sequence_token_id,
+                Priority priority,
+                WorkerShutdown shutdown_behavior,
+                const tracked_objects::Location& from_here,
+                const Closure& task,
+                TimeDelta delay);
+
+  bool RunsTasksOnCurrentThread() const;
+
+  bool IsRunningSequenceOnCurrentThread(int sequence_token_id) const;
+
+  void FlushForTesting();
+
+  void Shutdown();
+
+  bool IsShutdownInProgress() const;
+
+  // Runs the worker loop on the worker's thread.
+  void ThreadLoop(Worker* worker);
+
+ private:
+  struct SequenceShard {
+    Lock lock;
+    // The tasks of the sequences which are queued on a worker or running,
+    // by token id. The first task is the one being run, if any.
+    std::map<int, std::deque<WorkerTask>> sequences;
+  };
+
+  Worker* GetCurrentWorker() const { return current_worker_.Get(); }
+
+  // Queues |task| on |worker|, and wakes up |worker| or another sleeping
+  // worker if |wake_up| is true.
+  void Enqueue(const WorkerTask& task, Worker* worker, bool wake_up);
+
+  // Queues |task| on a worker, or in its sequence.
+  void EnqueueTask(const WorkerTask& task);
+
+  void WakeUpOneWorker(size_t first_index);
+
+  // Takes the highest priority task of |worker|, or of another worker if
+  // that one is of a higher priority.
+  bool GetWork(Worker* worker, WorkerTask* task);
+
+  bool HasWork() const;
+
+  // Runs |task|, or the next task of the sequence it stands for.
+  void RunTask(Worker* worker, WorkerTask* task);
+  void RunSequence(Worker* worker, int sequence_token_id);
+
+  // Returns false if |task| must be deleted instead of run, because of
+  // shutdown.
+  bool WillRunTask(const WorkerTask& task);
+  void DidRunTask(const WorkerTask& task);
+
+  void DecrementBlockingTasks();
+
+  // Moves the delayed tasks which are due to the workers. Returns the run
+  // time of the next delayed task, or a null TimeTicks if there is none, or
+  // if |wait_for_lock| is false and the lock was busy.
+  TimeTicks ScheduleDelayedTasks(bool wait_for_lock);
+
+  ScopedVector<Worker> workers_;
+  mutable ThreadLocalPointer<Worker> current_worker_;
+
+  // Round-robin counter for the tasks posted from other threads.
+  subtle::Atomic32 next_worker_;
+
+  // The number of tasks of each priority queued on the workers, so they
+  // don't have to look at each other's queues to find out there are none.
+  subtle::Atomic32 num_queued_[kNumPriorities];
+
+  AtomicSequenceNumber last_sequence_token_id_;
+
+  SequenceShard sequence_shards_[kNumSequenceShards];
+
+  subtle::Atomic32 shutdown_called_;
+
+  // The number of BLOCK_SHUTDOWN tasks not run yet, plus the number of
+  // SKIP_ON_SHUTDOWN tasks running. Shutdown() waits until it is 0.
+  subtle::Atomic32 num_blocking_tasks_;
+  WaitableEvent blocking_tasks_done_;
+
+  Lock delayed_tasks_lock_;
+  DelayedWorkerTaskQueue delayed_tasks_;
+  int64 next_delayed_sequence_num_;
+  subtle::Atomic32 num_delayed_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(Inner);
+};
+
+void WorkStealingPool::Worker::ThreadMain() {
+  PlatformThread::SetName(name_);
+  // Release our reference to the pool once we're done; this may delete the
+  // pool and this worker, which mustn't be touched afterwards.
+  WorkStealingPool* pool = pool_;
+  inner_->ThreadLoop(this);
+  pool->Release();
+}
+
+WorkStealingPool::Inner::Inner(WorkStealingPool* pool,
+                               size_t num_threads,
+                               const std::string& thread_name_prefix)
+    : next_worker_(0),
+      shutdown_called_(0),
+      num_blocking_tasks_(0),
+      blocking_tasks_done_(false, false),
+      next_delayed_sequence_num_(0),
+      num_delayed_tasks_(0) {
+  DCHECK_GT(num_threads, 0u);
+  for (int i = 0; i < kNumPriorities; ++i)
+    num_queued_[i] = 0;
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.push_back(new Worker(
+        pool, this, i,
+        thread_name_prefix + StringPrintf("Worker%d", static_cast<int>(i))));
+  }
+  // The workers look at each other, so they are only started once they all
+  // exist.
+  for (size_t i = 0; i < num_threads; ++i)
+    workers_[i]->Start();
+}
+
+WorkStealingPool::Inner::~Inner() {
+}
+
+bool WorkStealingPool::Inner::PostTask(
+    int sequence_token_id,
+    Priority priority,
+    WorkerShutdown shutdown_behavior,
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    TimeDelta delay) {
+  DCHECK(!task.is_null());
+  if (delay > TimeDelta())
+    shutdown_behavior = SKIP_ON_SHUTDOWN;
+
+  // Count a BLOCK_SHUTDOWN task before checking for shutdown, so that either
+  // the task is refused or Shutdown() waits for it.
+  if (shutdown_behavior == BLOCK_SHUTDOWN) {
+    subtle::Barrier_AtomicIncrement(&num_blocking_tasks_, 1);
+    if (IsShutdownInProgress()) {
+      DecrementBlockingTasks();
+      return false;
+    }
+  } else if (IsShutdownInProgress()) {
+    return false;
+  }
+
+  WorkerTask worker_task;
+  worker_task.posted_from = from_here;
+  worker_task.task = task;
+  worker_task.sequence_token_id = sequence_token_id;
+  worker_task.priority = priority;
+  worker_task.shutdown_behavior = shutdown_behavior;
+
+  if (delay > TimeDelta()) {
+    bool is_next = false;
+    {
+      AutoLock lock(delayed_tasks_lock_);
+      // Shutdown() deletes the delayed tasks under this lock.
+      if (IsShutdownInProgress())
+        return false;
+      DelayedWorkerTask delayed_task;
+      delayed_task.task = worker_task;
+      delayed_task.run_time = TimeTicks::Now() + delay;
+      delayed_task.sequence_num = next_delayed_sequence_num_++;
+      is_next = delayed_tasks_.empty() ||
+                delayed_task.run_time < delayed_tasks_.top().run_time;
+      delayed_tasks_.push(delayed_task);
+      subtle::NoBarrier_Store(&num_delayed_tasks_,
+                              static_cast<int>(delayed_tasks_.size()));
+    }
+    // A sleeping worker must wake up earlier than it planned to.
+    if (is_next) {
+      subtle::MemoryBarrier();
+      WakeUpOneWorker(0);
+    }
+    return true;
+  }
+
+  EnqueueTask(worker_task);
+  return true;
+}
+
+bool WorkStealingPool::Inner::RunsTasksOnCurrentThread() const {
+  return !!GetCurrentWorker();
+}
+
+bool WorkStealingPool::Inner::IsRunningSequenceOnCurrentThread(
+    int sequence_token_id) const {
+  Worker* worker = GetCurrentWorker();
+  return worker && sequence_token_id &&
+         worker->running_sequence_token_id() == sequence_token_id;
+}
+
+void WorkStealingPool::Inner::FlushForTesting() {
+  DCHECK(!RunsTasksOnCurrentThread());
+  // Every task is completed after it is pushed, and after the tasks it
+  // pushes, so once the completed tasks add up to the pushed tasks, counting
+  // the former first, they all are completed.
+  while (true) {
+    uint32 num_done = 0;
+    for (size_t i = 0; i < workers_.size(); ++i)
+      num_done += workers_[i]->num_done();
+    uint32 num_pushed = 0;
+    for (size_t i = 0; i < workers_.size(); ++i)
+      num_pushed += workers_[i]->num_pushed();
+    if (num_done == num_pushed)
+      return;
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(1));
+  }
+}
+
+void WorkStealingPool::Inner::Shutdown() {
+  DCHECK(!RunsTasksOnCurrentThread());
+  if (subtle::Barrier_AtomicIncrement(&shutdown_called_, 1) != 1)
+    return;
+
+  // Delayed tasks are SKIP_ON_SHUTDOWN, so none of them will run.
+  DelayedWorkerTaskQueue delayed_tasks;
+  {
+    AutoLock lock(delayed_tasks_lock_);
+    delayed_tasks.swap(delayed_tasks_);
+    subtle::NoBarrier_Store(&num_delayed_tasks_, 0);
+  }
+
+  {
+    base::ThreadRestrictions::ScopedAllowWait allow_wait;
+    while (subtle::Acquire_Load(&num_blocking_tasks_) > 0)
+      blocking_tasks_done_.Wait();
+  }
+
+  // The workers delete the tasks left and exit.
+  for (size_t i = 0; i < workers_.size(); ++i)
+    workers_[i]->WakeUp();
+}
+
+bool WorkStealingPool::Inner::IsShutdownInProgress() const {
+  return !!subtle::Acquire_Load(&shutdown_called_);
+}
+
+void WorkStealingPool::Inner::ThreadLoop(Worker* worker) {
+  current_worker_.Set(worker);
+
+  WorkerTask task;
+  while (true) {
+    if (subtle::NoBarrier_Load(&num_delayed_tasks_))
+      ScheduleDelayedTasks(false);
+
+    if (GetWork(worker, &task)) {
+      RunTask(worker, &task);
+      worker->DidCompleteTask();
+      continue;
+    }
+
+    // Check for work once more after telling the posters that this worker
+    // is about to sleep, so that either the worker sees their tasks or they
+    // wake it up.
+    worker->SetSleeping(true);
+    TimeTicks next_delayed_run_time = ScheduleDelayedTasks(true);
+    if (HasWork()) {
+      worker->SetSleeping(false);
+      continue;
+    }
+    if (IsShutdownInProgress() &&
+        !subtle::Acquire_Load(&num_blocking_tasks_)) {
+      break;
+    }
+    worker->Sleep(next_delayed_run_time.is_null()
+                      ? TimeDelta::Max()
+                      : next_delayed_run_time - TimeTicks::Now());
+    worker->SetSleeping(false);
+  }
+
+  current_worker_.Set(NULL);
+}
+
+void WorkStealingPool::Inner::Enqueue(const WorkerTask& task,
+                                      Worker* worker,
+                                      bool wake_up) {
+  worker->Push(task);
+  // This is also the barrier before the sleeping workers are checked.
+  subtle::Barrier_AtomicIncrement(&num_queued_[task.priority], 1);
+  if (!wake_up || worker->WakeUpIfSleeping())
+    return;
+  // |worker| is busy, so another worker may steal the task.
+  WakeUpOneWorker(worker->index() + 1);
+}
+
+void WorkStealingPool::Inner::EnqueueTask(const WorkerTask& task) {
+  if (!task.sequence_token_id) {
+    Worker* worker = GetCurrentWorker();
+    if (!worker) {
+      uint32 next = static_cast<uint32>(
+          subtle::NoBarrier_AtomicIncrement(&next_worker_, 1));
+      worker = workers_[next % workers_.size()];
+    }
+    Enqueue(task, worker, true);
+    return;
+  }
+
+  SequenceShard& shard =
+      sequence_shards_[task.sequence_token_id % kNumSequenceShards];
+  {
+    AutoLock lock(shard.lock);
+    std::deque<WorkerTask>& tasks = shard.sequences[task.sequence_token_id];
+    tasks.push_back(task);
+    // Otherwise the sequence is already queued or running.
+    if (tasks.size() > 1)
+      return;
+  }
+
+  // A sequence is queued on the same worker each time, so that it tends to
+  // stay on one thread.
+  WorkerTask sequence;
+  sequence.sequence_token_id = task.sequence_token_id;
+  sequence.priority = task.priority;
+  Enqueue(sequence, workers_[task.sequence_token_id % workers_.size()], true);
+}
+
+void WorkStealingPool::Inner::WakeUpOneWorker(size_t first_index) {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    if (workers_[(first_index + i) % workers_.size()]->WakeUpIfSleeping())
+      return;
+  }
+}
+
+bool WorkStealingPool::Inner::GetWork(Worker* worker, WorkerTask* task) {
+  const size_t num_workers = workers_.size();
+  for (int priority = kNumPriorities - 1; priority >= 0; --priority) {
+    if (subtle::Acquire_Load(&num_queued_[priority]) <= 0)
+      continue;
+    bool found = worker->Pop(priority, task);
+    for (size_t i = 1; !found && i < num_workers; ++i) {
+      found = workers_[(worker->index() + i) % num_workers]->Steal(priority,
+                                                                   task);
+    }
+    if (found) {
+      subtle::NoBarrier_AtomicIncrement(&num_queued_[priority], -1);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingPool::Inner::HasWork() const {
+  for (int priority = 0; priority < kNumPriorities; ++priority) {
+    if (subtle::Acquire_Load(&num_queued_[priority]) > 0)
+      return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::Inner::RunTask(Worker* worker, WorkerTask* task) {
+  if (task->task.is_null()) {
+    RunSequence(worker, task->sequence_token_id);
+    return;
+  }
+
+  if (WillRunTask(*task)) {
+    TRACE_EVENT2("toplevel", "WorkStealingPool::RunTask",
+                 "src_file", task->posted_from.file_name(),
+                 "src_func", task->posted_from.function_name());
+    worker->set_running_sequence_token_id(task->sequence_token_id);
+    task->task.Run();
+    // Delete the task while its sequence is still the current one, and
+    // before the next task of its sequence can start.
+    task->task.Reset();
+    worker->set_running_sequence_token_id(0);
+    DidRunTask(*task);
+  }
+  task->task.Reset();
+}
+
+void WorkStealingPool::Inner::RunSequence(Worker* worker,
+                                          int sequence_token_id) {
+  SequenceShard& shard =
+      sequence_shards_[sequence_token_id % kNumSequenceShards];
+  WorkerTask task;
+  {
+    AutoLock lock(shard.lock);
+    std::deque<WorkerTask>& tasks = shard.sequences[sequence_token_id];
+    DCHECK(!tasks.empty());
+    // The empty task left in front keeps the sequence from being queued
+    // again while this one runs.
+    std::swap(task, tasks.front());
+  }
+
+  RunTask(worker, &task);
+
+  WorkerTask sequence;
+  {
+    AutoLock lock(shard.lock);
+    std::map<int, std::deque<WorkerTask>>::iterator it =
+        shard.sequences.find(sequence_token_id);
+    DCHECK(it != shard.sequences.end());
+    it->second.pop_front();
+    if (it->second.empty()) {
+      shard.sequences.erase(it);
+      return;
+    }
+    sequence.sequence_token_id = sequence_token_id;
+    sequence.priority = it->second.front().priority;
+  }
+  // The worker will run the sequence again, after the tasks already queued.
+  Enqueue(sequence, worker, false);
+}
+
+bool WorkStealingPool::Inner::WillRunTask(const WorkerTask& task) {
+  switch (task.shutdown_behavior) {
+    case CONTINUE_ON_SHUTDOWN:
+      return !IsShutdownInProgress();
+    case SKIP_ON_SHUTDOWN:
+      // As when posting a BLOCK_SHUTDOWN task: either Shutdown() waits for
+      // this task, or it isn't run.
+      subtle::Barrier_AtomicIncrement(&num_blocking_tasks_, 1);
+      if (IsShutdownInProgress()) {
+        DecrementBlockingTasks();
+        return false;
+      }
+      return true;
+    case BLOCK_SHUTDOWN:
+      return true;
+  }
+  NOTREACHED();
+  return false;
+}
+
+void WorkStealingPool::Inner::DidRunTask(const WorkerTask& task) {
+  if (task.shutdown_behavior != CONTINUE_ON_SHUTDOWN)
+    DecrementBlockingTasks();
+}
+
+void WorkStealingPool::Inner::DecrementBlockingTasks() {
+  if (!subtle::Barrier_AtomicIncrement(&num_blocking_tasks_, -1) &&
+      IsShutdownInProgress()) {
+    blocking_tasks_done_.Signal();
+  }
+}
+
+TimeTicks WorkStealingPool::Inner::ScheduleDelayedTasks(bool wait_for_lock) {
+  if (!subtle::NoBarrier_Load(&num_delayed_tasks_))
+    return TimeTicks();
+
+  std::vector<WorkerTask> due_tasks;
+  TimeTicks next_run_time;
+  if (wait_for_lock)
+    delayed_tasks_lock_.Acquire();
+  else if (!delayed_tasks_lock_.Try())
+    return TimeTicks();
+  const TimeTicks now = TimeTicks::Now();
+  while (!delayed_tasks_.empty() && delayed_tasks_.top().run_time <= now) {
+    due_tasks.push_back(delayed_tasks_.top().task);
+    delayed_tasks_.pop();
+  }
+  if (!delayed_tasks_.empty())
+    next_run_time = delayed_tasks_.top().run_time;
+  subtle::NoBarrier_Store(&num_delayed_tasks_,
+                          static_cast<int>(delayed_tasks_.size()));
+  delayed_tasks_lock_.Release();
+
+  for (size_t i = 0; i < due_tasks.size(); ++i)
+    EnqueueTask(due_tasks[i]);
+  return next_run_time;
+}
+
+// WorkStealingPool ------------------------------------------------------------
+
+WorkStealingPool::WorkStealingPool(size_t num_threads,
+                                   const std::string& thread_name_prefix)
+    : inner_(new Inner(this, num_threads, thread_name_prefix)) {
+}
+
+WorkStealingPool::~WorkStealingPool() {
+}
+
+WorkStealingPool::SequenceToken WorkStealingPool::GetSequenceToken() {
+  return SequenceToken(inner_->GetSequenceTokenId());
+}
+
+scoped_refptr<TaskRunner> WorkStealingPool::GetTaskRunner(
+    Priority priority,
+    WorkerShutdown shutdown_behavior) {
+  return new WorkStealingPoolTaskRunner(this, priority, shutdown_behavior);
+}
+
+scoped_refptr<TaskRunner> WorkStealingPool::GetTaskRunnerWithShutdownBehavior(
+    WorkerShutdown shutdown_behavior) {
+  return GetTaskRunner(PRIORITY_NORMAL, shutdown_behavior);
+}
+
+scoped_refptr<SequencedTaskRunner> WorkStealingPool::GetSequencedTaskRunner(
+    SequenceToken token,
+    Priority priority,
+    WorkerShutdown shutdown_behavior) {
+  return new WorkStealingPoolSequencedTaskRunner(this, token, priority,
+                                                 shutdown_behavior);
+}
+
+scoped_refptr<SequencedTaskRunner> WorkStealingPool::GetSequencedTaskRunner(
+    SequenceToken token) {
+  return GetSequencedTaskRunner(token, PRIORITY_NORMAL, BLOCK_SHUTDOWN);
+}
+
+scoped_refptr<SequencedTaskRunner>
+WorkStealingPool::GetSequencedTaskRunnerWithShutdownBehavior(
+    SequenceToken token,
+    WorkerShutdown shutdown_behavior) {
+  return GetSequencedTaskRunner(token, PRIORITY_NORMAL, shutdown_behavior);
+}
+
+bool WorkStealingPool::PostPrioritizedTask(
+    SequenceToken sequence_token,
+    Priority priority,
+    WorkerShutdown shutdown_behavior,
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    TimeDelta delay) {
+  return inner_->PostTask(sequence_token.id_, priority, shutdown_behavior,
+                          from_here, task, delay);
+}
+
+bool WorkStealingPool::PostWorkerTask(
+    const tracked_objects::Location& from_here,
+    const Closure& task) {
+  return PostPrioritizedTask(SequenceToken(), PRIORITY_NORMAL, BLOCK_SHUTDOWN,
+                             from_here, task, TimeDelta());
+}
+
+bool WorkStealingPool::PostDelayedWorkerTask(
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    TimeDelta delay) {
+  return PostPrioritizedTask(SequenceToken(), PRIORITY_NORMAL, BLOCK_SHUTDOWN,
+                             from_here, task, delay);
+}
+
+bool WorkStealingPool::PostWorkerTaskWithShutdownBehavior(
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    WorkerShutdown shutdown_behavior) {
+  return PostPrioritizedTask(SequenceToken(), PRIORITY_NORMAL,
+                             shutdown_behavior, from_here, task, TimeDelta());
+}
+
+bool WorkStealingPool::PostSequencedWorkerTask(
+    SequenceToken sequence_token,
+    const tracked_objects::Location& from_here,
+    const Closure& task) {
+  return PostPrioritizedTask(sequence_token, PRIORITY_NORMAL, BLOCK_SHUTDOWN,
+                             from_here, task, TimeDelta());
+}
+
+bool WorkStealingPool::PostDelayedSequencedWorkerTask(
+    SequenceToken sequence_token,
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    TimeDelta delay) {
+  return PostPrioritizedTask(sequence_token, PRIORITY_NORMAL, BLOCK_SHUTDOWN,
+                             from_here, task, delay);
+}
+
+bool WorkStealingPool::PostSequencedWorkerTaskWithShutdownBehavior(
+    SequenceToken sequence_token,
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    WorkerShutdown shutdown_behavior) {
+  return PostPrioritizedTask(sequence_token, PRIORITY_NORMAL,
+                             shutdown_behavior, from_here, task, TimeDelta());
+}
+
+bool WorkStealingPool::PostDelayedTask(
+    const tracked_objects::Location& from_here,
+    const Closure& task,
+    TimeDelta delay) {
+  return PostDelayedWorkerTask(from_here, task, delay);
+}
+
+bool WorkStealingPool::RunsTasksOnCurrentThread() const {
+  return inner_->RunsTasksOnCurrentThread();
+}
+
+bool WorkStealingPool::IsRunningSequenceOnCurrentThread(
+    SequenceToken sequence_token) const {
+  return inner_->IsRunningSequenceOnCurrentThread(sequence_token.id_);
+}
+
+void WorkStealingPool::FlushForTesting() {
+  inner_->FlushForTesting();
+}
+
+void WorkStealingPool::Shutdown() {
+  inner_->Shutdown();
+}
+
+bool WorkStealingPool::IsShutdownInProgress() {
+  return inner_->IsShutdownInProgress();
+}
+
+}  // namespace base
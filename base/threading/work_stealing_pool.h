@@ -0,0 +1,204 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_THREADING_WORK_STEALING_POOL_H_
+#define BASE_THREADING_WORK_STEALING_POOL_H_
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/callback_forward.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/task_runner.h"
+
+namespace tracked_objects {
+class Location;
+}  // namespace tracked_objects
+
+namespace base {
+
+class SequencedTaskRunner;
+
+// A worker thread pool with the task semantics of SequencedWorkerPool
+// (sequence tokens, shutdown behaviors), plus task priorities, which scales
+// better when many threads post to it.
+//
+// SequencedWorkerPool keeps all its tasks in one set, behind one lock which
+// every post, every worker wakeup and every sequence check takes. This pool
+// instead gives each worker thread its own queues, with its own lock:
+//
+//   - Tasks posted from a worker go to that worker's queues, and tasks posted
+//     from other threads are spread over the workers round-robin. A worker
+//     runs the tasks of its queues oldest first.
+//
+//   - A worker whose queues are empty steals the newest task of another
+//     worker's queues, so no worker idles while tasks are waiting.
+//
+//   - The tasks of a sequence are queued apart from the workers' queues, and
+//     the sequence itself is queued on a worker while it has tasks, so that
+//     only one of its tasks runs at a time. A sequence is queued on the same
+//     worker each time it gets new tasks, unless another worker steals it.
+//
+//   - Each worker has a priority queue per Priority, and workers run (and
+//     steal) higher priority tasks first.
+//
+// Like SequencedWorkerPool, this pool must be shut down with Shutdown(), or
+// leaked; its threads are started by the constructor and exit after
+// shutdown.
+//
+// Example:
+//   scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(4, "Worker"));
+//   scoped_refptr<SequencedTaskRunner> runner = pool->GetSequencedTaskRunner(
+//       pool->GetSequenceToken(), WorkStealingPool::PRIORITY_HIGH,
+//       WorkStealingPool::SKIP_ON_SHUTDOWN);
+//   runner->PostTask(FROM_HERE, base::Bind(...));
+//   ...
+//   pool->Shutdown();
+class BASE_EXPORT WorkStealingPool : public TaskRunner {
+ public:
+  // What happens to a task on shutdown. These have the same meaning as in
+  // SequencedWorkerPool.
+  enum WorkerShutdown {
+    // Not run if not started at shutdown, and not waited for if running.
+    CONTINUE_ON_SHUTDOWN,
+    // Not run if not started at shutdown, but waited for if running.
+    SKIP_ON_SHUTDOWN,
+    // Run, and waited for, by shutdown.
+    BLOCK_SHUTDOWN,
+  };
+
+  // Workers run the tasks of a higher priority first.
+  enum Priority {
+    PRIORITY_BACKGROUND,
+    PRIORITY_NORMAL,
+    PRIORITY_HIGH,
+    PRIORITY_LAST = PRIORITY_HIGH,
+  };
+
+  // Opaque identifier that defines sequencing of tasks posted to the pool.
+  class SequenceToken {
+   public:
+    SequenceToken() : id_(0) {}
+    ~SequenceToken() {}
+
+    bool Equals(const SequenceToken& other) const {
+      return id_ == other.id_;
+    }
+
+    bool IsValid() const { return id_ != 0; }
+
+   private:
+    friend class WorkStealingPool;
+
+    explicit SequenceToken(int id) : id_(id) {}
+
+    int id_;
+  };
+
+  // Starts |num_threads| worker threads, named |thread_name_prefix| followed
+  // by their number.
+  WorkStealingPool(size_t num_threads, const std::string& thread_name_prefix);
+
+  // Returns a unique token that can be used to sequence tasks. Valid tokens
+  // are always nonzero.
+  SequenceToken GetSequenceToken();
+
+  // These return wrappers which post to this pool with the given priority,
+  // shutdown behavior and sequence token. As with SequencedWorkerPool, tasks
+  // with a nonzero delay are posted with SKIP_ON_SHUTDOWN behavior, and the
+  // runners whose shutdown behavior isn't given post with BLOCK_SHUTDOWN.
+  scoped_refptr<TaskRunner> GetTaskRunner(Priority priority,
+                                          WorkerShutdown shutdown_behavior);
+  scoped_refptr<TaskRunner> GetTaskRunnerWithShutdownBehavior(
+      WorkerShutdown shutdown_behavior);
+  scoped_refptr<SequencedTaskRunner> GetSequencedTaskRunner(
+      SequenceToken token,
+      Priority priority,
+      WorkerShutdown shutdown_behavior);
+  scoped_refptr<SequencedTaskRunner> GetSequencedTaskRunner(
+      SequenceToken token);
+  scoped_refptr<SequencedTaskRunner> GetSequencedTaskRunnerWithShutdownBehavior(
+      SequenceToken token,
+      WorkerShutdown shutdown_behavior);
+
+  // Posts |task| to run after |delay| on a worker, after the tasks posted
+  // before it with the same |sequence_token| if it is valid. A nonzero
+  // |delay| implies SKIP_ON_SHUTDOWN. Returns false, and deletes |task|, if
+  // the pool is shut down.
+  bool PostPrioritizedTask(SequenceToken sequence_token,
+                           Priority priority,
+                           WorkerShutdown shutdown_behavior,
+                           const tracked_objects::Location& from_here,
+                           const Closure& task,
+                           TimeDelta delay);
+
+  // These are the SequencedWorkerPool methods of the same names. They post
+  // with PRIORITY_NORMAL and, unless given, BLOCK_SHUTDOWN behavior.
+  bool PostWorkerTask(const tracked_objects::Location& from_here,
+                      const Closure& task);
+  bool PostDelayedWorkerTask(const tracked_objects::Location& from_here,
+                             const Closure& task,
+                             TimeDelta delay);
+  bool PostWorkerTaskWithShutdownBehavior(
+      const tracked_objects::Location& from_here,
+      const Closure& task,
+      WorkerShutdown shutdown_behavior);
+  bool PostSequencedWorkerTask(SequenceToken sequence_token,
+                               const tracked_objects::Location& from_here,
+                               const Closure& task);
+  bool PostDelayedSequencedWorkerTask(
+      SequenceToken sequence_token,
+      const tracked_objects::Location& from_here,
+      const Closure& task,
+      TimeDelta delay);
+  bool PostSequencedWorkerTaskWithShutdownBehavior(
+      SequenceToken sequence_token,
+      const tracked_objects::Location& from_here,
+      const Closure& task,
+      WorkerShutdown shutdown_behavior);
+
+  // TaskRunner implementation. Forwards to PostDelayedWorkerTask().
+  bool PostDelayedTask(const tracked_objects::Location& from_here,
+                       const Closure& task,
+                       TimeDelta delay) override;
+  bool RunsTasksOnCurrentThread() const override;
+
+  // Returns true if the current thread is running a task with the given
+  // sequence token.
+  bool IsRunningSequenceOnCurrentThread(SequenceToken sequence_token) const;
+
+  // Blocks until all the tasks which are not delayed have completed. Only
+  // for tests, which must not post tasks meanwhile from other threads.
+  void FlushForTesting();
+
+  // Stops accepting tasks, deletes the delayed tasks, and blocks until the
+  // BLOCK_SHUTDOWN tasks, and the SKIP_ON_SHUTDOWN tasks already running,
+  // have completed. The other tasks are deleted without being run. Must not
+  // be called from a worker.
+  void Shutdown();
+
+  // Returns true once Shutdown() has been called. Can be called from any
+  // thread.
+  bool IsShutdownInProgress();
+
+ private:
+  friend class RefCountedThreadSafe<WorkStealingPool>;
+
+  class Inner;
+  class Worker;
+
+  ~WorkStealingPool() override;
+
+  // Everything, including the workers, is in |inner_|, which keeps the
+  // implementation out of this header.
+  const scoped_ptr<Inner> inner_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingPool);
+};
+
+}  // namespace base
+
+#endif  // BASE_THREADING_WORK_STEALING_POOL_H_
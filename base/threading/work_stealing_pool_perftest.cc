@@ -0,0 +1,186 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the cost of running tiny tasks on SequencedWorkerPool and on
+// WorkStealingPool, posted from one or several threads, in sequences, or
+// from the workers themselves.
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_switches.h"
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/threading/thread.h"
+#include "base/threading/work_stealing_pool.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kNumTasks = 100000;
+const size_t kNumWorkers = 4;
+
+// Signals when it has been run a number of times.
+class TaskCounter {
+ public:
+  explicit TaskCounter(int num_tasks)
+      : remaining_(num_tasks), done_(false, false) {}
+
+  void RunTask() {
+    if (!subtle::Barrier_AtomicIncrement(&remaining_, -1))
+      done_.Signal();
+  }
+
+  void Wait() { done_.Wait(); }
+
+ private:
+  subtle::Atomic32 remaining_;
+  WaitableEvent done_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskCounter);
+};
+
+template <typename Pool>
+void PostTasks(Pool* pool, TaskCounter* counter, int num_tasks) {
+  for (int i = 0; i < num_tasks; ++i) {
+    pool->PostWorkerTask(FROM_HERE,
+                         Bind(&TaskCounter::RunTask, Unretained(counter)));
+  }
+}
+
+template <typename Pool>
+void PostSequencedTasks(Pool* pool,
+                        TaskCounter* counter,
+                        int num_tasks,
+                        int num_sequences) {
+  std::vector<typename Pool::SequenceToken> tokens;
+  for (int i = 0; i < num_sequences; ++i)
+    tokens.push_back(pool->GetSequenceToken());
+  for (int i = 0; i < num_tasks; ++i) {
+    pool->PostSequencedWorkerTask(
+        tokens[i % num_sequences], FROM_HERE,
+        Bind(&TaskCounter::RunTask, Unretained(counter)));
+  }
+}
+
+// Runs as 2^(depth + 1) - 1 tasks, each of which posts the next two.
+template <typename Pool>
+void FanOut(Pool* pool, TaskCounter* counter, int depth) {
+  if (depth) {
+    for (int i = 0; i < 2; ++i) {
+      pool->PostWorkerTask(FROM_HERE, Bind(&FanOut<Pool>, Unretained(pool),
+                                           counter, depth - 1));
+    }
+  }
+  counter->RunTask();
+}
+
+class WorkerPoolPerfTest : public testing::Test {
+ public:
+  WorkerPoolPerfTest() {
+    // Disable the task profiler as it adds significant cost!
+    CommandLine::Init(0, NULL);
+    CommandLine::ForCurrentProcess()->AppendSwitchASCII(
+        switches::kProfilerTiming,
+        switches::kProfilerTimingDisabledValue);
+  }
+
+  // Posts kNumTasks tasks from |num_posters| threads.
+  template <typename Pool>
+  void RunPostTest(const std::string& name, int num_posters) {
+    scoped_refptr<Pool> pool(new Pool(kNumWorkers, "PerfTest"));
+    ScopedVector<Thread> posters;
+    for (int i = 0; i < num_posters; ++i) {
+      posters.push_back(new Thread("Poster"));
+      posters.back()->Start();
+    }
+
+    TaskCounter counter(kNumTasks);
+    TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < num_posters; ++i) {
+      posters[i]->task_runner()->PostTask(
+          FROM_HERE, Bind(&PostTasks<Pool>, pool, &counter,
+                          kNumTasks / num_posters));
+    }
+    counter.Wait();
+    PrintTime(name + "_" + IntToString(num_posters) + "_posters",
+              TimeTicks::Now() - start, kNumTasks);
+    pool->Shutdown();
+  }
+
+  // Posts kNumTasks tasks from this thread to |num_sequences| sequences.
+  template <typename Pool>
+  void RunSequencedTest(const std::string& name, int num_sequences) {
+    scoped_refptr<Pool> pool(new Pool(kNumWorkers, "PerfTest"));
+    TaskCounter counter(kNumTasks);
+    TimeTicks start = TimeTicks::Now();
+    PostSequencedTasks(pool.get(), &counter, kNumTasks, num_sequences);
+    counter.Wait();
+    PrintTime(name + "_" + IntToString(num_sequences) + "_sequences",
+              TimeTicks::Now() - start, kNumTasks);
+    pool->Shutdown();
+  }
+
+  // Runs tasks which post tasks from the workers.
+  template <typename Pool>
+  void RunFanOutTest(const std::string& name) {
+    const int kDepth = 16;
+    const int kNumFanOutTasks = (2 << kDepth) - 1;
+    scoped_refptr<Pool> pool(new Pool(kNumWorkers, "PerfTest"));
+    TaskCounter counter(kNumFanOutTasks);
+    TimeTicks start = TimeTicks::Now();
+    pool->PostWorkerTask(FROM_HERE, Bind(&FanOut<Pool>, Unretained(pool.get()),
+                                         &counter, kDepth));
+    counter.Wait();
+    PrintTime(name + "_fan_out", TimeTicks::Now() - start, kNumFanOutTasks);
+    pool->Shutdown();
+  }
+
+ private:
+  void PrintTime(const std::string& name, TimeDelta time, int num_tasks) {
+    double us_per_task =
+        time.InMicroseconds() / static_cast<double>(num_tasks);
+    perf_test::PrintResult("task", "", name + "_time ", us_per_task, "us/task",
+                           true);
+  }
+
+  // SequencedWorkerPool needs a message loop on the thread it's created on.
+  MessageLoop message_loop_;
+};
+
+TEST_F(WorkerPoolPerfTest, PostFromOneThread) {
+  RunPostTest<SequencedWorkerPool>("SequencedWorkerPool", 1);
+  RunPostTest<WorkStealingPool>("WorkStealingPool", 1);
+}
+
+TEST_F(WorkerPoolPerfTest, PostFromFourThreads) {
+  RunPostTest<SequencedWorkerPool>("SequencedWorkerPool", 4);
+  RunPostTest<WorkStealingPool>("WorkStealingPool", 4);
+}
+
+TEST_F(WorkerPoolPerfTest, PostSequenced) {
+  RunSequencedTest<SequencedWorkerPool>("SequencedWorkerPool", 16);
+  RunSequencedTest<WorkStealingPool>("WorkStealingPool", 16);
+}
+
+TEST_F(WorkerPoolPerfTest, PostFromWorkers) {
+  RunFanOutTest<SequencedWorkerPool>("SequencedWorkerPool");
+  RunFanOutTest<WorkStealingPool>("WorkStealingPool");
+}
+
+}  // namespace
+
+}  // namespace base
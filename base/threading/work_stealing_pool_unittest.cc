@@ -0,0 +1,276 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/work_stealing_pool.h"
+
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/sequenced_task_runner_test_template.h"
+#include "base/test/task_runner_test_template.h"
+#include "base/test/test_timeouts.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void Increment(subtle::Atomic32* counter) {
+  subtle::NoBarrier_AtomicIncrement(counter, 1);
+}
+
+// Records the order in which tasks run.
+class TaskLog {
+ public:
+  TaskLog() {}
+
+  void Add(int value) {
+    AutoLock lock(lock_);
+    values_.push_back(value);
+  }
+
+  std::vector<int> values() {
+    AutoLock lock(lock_);
+    return values_;
+  }
+
+ private:
+  Lock lock_;
+  std::vector<int> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskLog);
+};
+
+// Adds |value| to |log|, and checks that no other task of the same sequence
+// runs at the same time.
+void AddSequencedValue(WorkStealingPool* pool,
+                       WorkStealingPool::SequenceToken token,
+                       subtle::Atomic32* running,
+                       TaskLog* log,
+                       int value) {
+  EXPECT_TRUE(pool->RunsTasksOnCurrentThread());
+  EXPECT_TRUE(pool->IsRunningSequenceOnCurrentThread(token));
+  EXPECT_EQ(0, subtle::NoBarrier_AtomicIncrement(running, 1) - 1);
+  log->Add(value);
+  subtle::NoBarrier_AtomicIncrement(running, -1);
+}
+
+// Runs until |pool| starts shutting down.
+void WaitForShutdown(WorkStealingPool* pool, WaitableEvent* started) {
+  started->Signal();
+  while (!pool->IsShutdownInProgress())
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(1));
+}
+
+void Wait(WaitableEvent* event) {
+  event->Wait();
+}
+
+// Posts a task to the current worker, and waits for another worker to steal
+// and run it.
+void PostAndWaitForSteal(WorkStealingPool* pool, bool* stolen) {
+  WaitableEvent event(false, false);
+  pool->PostWorkerTask(FROM_HERE,
+                       Bind(&WaitableEvent::Signal, Unretained(&event)));
+  *stolen = event.TimedWait(TestTimeouts::action_timeout());
+  // Let the task run before |event| goes away.
+  if (!*stolen)
+    event.Wait();
+}
+
+TEST(WorkStealingPoolTest, RunsTasks) {
+  scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(4, "Test"));
+  EXPECT_FALSE(pool->RunsTasksOnCurrentThread());
+  subtle::Atomic32 counter = 0;
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_TRUE(pool->PostWorkerTask(FROM_HERE, Bind(&Increment, &counter)));
+  // Shutdown() waits for the BLOCK_SHUTDOWN tasks.
+  pool->Shutdown();
+  EXPECT_EQ(1000, subtle::NoBarrier_Load(&counter));
+  EXPECT_FALSE(pool->PostWorkerTask(FROM_HERE, Bind(&Increment, &counter)));
+}
+
+TEST(WorkStealingPoolTest, Sequences) {
+  const int kNumSequences = 8;
+  const int kNumTasks = 1000;
+  scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(4, "Test"));
+  WorkStealingPool::SequenceToken tokens[kNumSequences];
+  subtle::Atomic32 running[kNumSequences] = {0};
+  TaskLog logs[kNumSequences];
+  for (int i = 0; i < kNumSequences; ++i)
+    tokens[i] = pool->GetSequenceToken();
+  EXPECT_FALSE(tokens[0].Equals(tokens[1]));
+
+  for (int task = 0; task < kNumTasks; ++task) {
+    for (int i = 0; i < kNumSequences; ++i) {
+      pool->PostSequencedWorkerTask(
+          tokens[i], FROM_HERE,
+          Bind(&AddSequencedValue, pool, tokens[i], &running[i], &logs[i],
+               task));
+    }
+  }
+  pool->Shutdown();
+
+  for (int i = 0; i < kNumSequences; ++i) {
+    std::vector<int> values = logs[i].values();
+    ASSERT_EQ(static_cast<size_t>(kNumTasks), values.size());
+    for (int task = 0; task < kNumTasks; ++task)
+      EXPECT_EQ(task, values[task]);
+  }
+}
+
+TEST(WorkStealingPoolTest, ShutdownBehaviors) {
+  scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(1, "Test"));
+  WaitableEvent started(false, false);
+  pool->PostWorkerTask(FROM_HERE, Bind(&WaitForShutdown, pool, &started));
+  started.Wait();
+
+  // These are queued behind the task above until shutdown.
+  subtle::Atomic32 continued = 0;
+  subtle::Atomic32 skipped = 0;
+  subtle::Atomic32 blocked = 0;
+  subtle::Atomic32 delayed = 0;
+  pool->PostWorkerTaskWithShutdownBehavior(
+      FROM_HERE, Bind(&Increment, &continued),
+      WorkStealingPool::CONTINUE_ON_SHUTDOWN);
+  pool->PostWorkerTaskWithShutdownBehavior(
+      FROM_HERE, Bind(&Increment, &skipped),
+      WorkStealingPool::SKIP_ON_SHUTDOWN);
+  pool->PostWorkerTaskWithShutdownBehavior(
+      FROM_HERE, Bind(&Increment, &blocked), WorkStealingPool::BLOCK_SHUTDOWN);
+  pool->PostSequencedWorkerTaskWithShutdownBehavior(
+      pool->GetSequenceToken(), FROM_HERE, Bind(&Increment, &skipped),
+      WorkStealingPool::SKIP_ON_SHUTDOWN);
+  pool->PostSequencedWorkerTaskWithShutdownBehavior(
+      pool->GetSequenceToken(), FROM_HERE, Bind(&Increment, &blocked),
+      WorkStealingPool::BLOCK_SHUTDOWN);
+  pool->PostDelayedWorkerTask(FROM_HERE, Bind(&Increment, &delayed),
+                              TimeDelta::FromMilliseconds(1));
+
+  pool->Shutdown();
+  EXPECT_EQ(0, subtle::NoBarrier_Load(&continued));
+  EXPECT_EQ(0, subtle::NoBarrier_Load(&skipped));
+  EXPECT_EQ(2, subtle::NoBarrier_Load(&blocked));
+  EXPECT_EQ(0, subtle::NoBarrier_Load(&delayed));
+  EXPECT_TRUE(pool->IsShutdownInProgress());
+  EXPECT_FALSE(pool->PostWorkerTaskWithShutdownBehavior(
+      FROM_HERE, Bind(&Increment, &blocked), WorkStealingPool::BLOCK_SHUTDOWN));
+}
+
+TEST(WorkStealingPoolTest, Priorities) {
+  scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(1, "Test"));
+  WaitableEvent release(false, false);
+  pool->PostWorkerTask(FROM_HERE, Bind(&Wait, &release));
+
+  TaskLog log;
+  const WorkStealingPool::Priority kPriorities[] = {
+      WorkStealingPool::PRIORITY_BACKGROUND, WorkStealingPool::PRIORITY_NORMAL,
+      WorkStealingPool::PRIORITY_HIGH, WorkStealingPool::PRIORITY_NORMAL,
+  };
+  for (size_t i = 0; i < arraysize(kPriorities); ++i) {
+    pool->GetTaskRunner(kPriorities[i], WorkStealingPool::BLOCK_SHUTDOWN)
+        ->PostTask(FROM_HERE, Bind(&TaskLog::Add, Unretained(&log),
+                                   static_cast<int>(i)));
+  }
+  release.Signal();
+  pool->Shutdown();
+
+  std::vector<int> values = log.values();
+  ASSERT_EQ(4u, values.size());
+  EXPECT_EQ(2, values[0]);
+  EXPECT_EQ(1, values[1]);
+  EXPECT_EQ(3, values[2]);
+  EXPECT_EQ(0, values[3]);
+}
+
+// A task posted from a worker is queued on that worker, so it only runs
+// while the worker is busy if another worker steals it.
+TEST(WorkStealingPoolTest, Stealing) {
+  scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(2, "Test"));
+  bool stolen = false;
+  pool->PostWorkerTask(FROM_HERE, Bind(&PostAndWaitForSteal, pool, &stolen));
+  pool->FlushForTesting();
+  pool->Shutdown();
+  EXPECT_TRUE(stolen);
+}
+
+TEST(WorkStealingPoolTest, DelayedTask) {
+  scoped_refptr<WorkStealingPool> pool(new WorkStealingPool(2, "Test"));
+  const TimeDelta kDelay = TimeDelta::FromMilliseconds(50);
+  WaitableEvent event(false, false);
+  const TimeTicks start = TimeTicks::Now();
+  pool->PostDelayedWorkerTask(
+      FROM_HERE, Bind(&WaitableEvent::Signal, Unretained(&event)), kDelay);
+  EXPECT_TRUE(event.TimedWait(TestTimeouts::action_timeout()));
+  EXPECT_GE(TimeTicks::Now() - start, kDelay);
+  pool->Shutdown();
+}
+
+class WorkStealingPoolTaskRunnerTestDelegate {
+ public:
+  WorkStealingPoolTaskRunnerTestDelegate() {}
+  ~WorkStealingPoolTaskRunnerTestDelegate() {}
+
+  void StartTaskRunner() {
+    pool_ = new WorkStealingPool(10, "WorkStealingPoolTaskRunnerTest");
+  }
+
+  scoped_refptr<WorkStealingPool> GetTaskRunner() { return pool_; }
+
+  void StopTaskRunner() {
+    // Make sure all tasks are run before shutting down. Delayed tasks are
+    // not run, they're simply deleted.
+    pool_->FlushForTesting();
+    pool_->Shutdown();
+  }
+
+ private:
+  scoped_refptr<WorkStealingPool> pool_;
+};
+
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingPool,
+                              TaskRunnerTest,
+                              WorkStealingPoolTaskRunnerTestDelegate);
+
+class WorkStealingPoolSequencedTaskRunnerTestDelegate {
+ public:
+  WorkStealingPoolSequencedTaskRunnerTestDelegate() {}
+  ~WorkStealingPoolSequencedTaskRunnerTestDelegate() {}
+
+  void StartTaskRunner() {
+    pool_ = new WorkStealingPool(10, "WorkStealingPoolSequencedTaskRunnerTest");
+    task_runner_ = pool_->GetSequencedTaskRunner(pool_->GetSequenceToken());
+  }
+
+  scoped_refptr<SequencedTaskRunner> GetTaskRunner() { return task_runner_; }
+
+  void StopTaskRunner() {
+    // Make sure all tasks are run before shutting down. Delayed tasks are
+    // not run, they're simply deleted.
+    pool_->FlushForTesting();
+    pool_->Shutdown();
+  }
+
+ private:
+  scoped_refptr<WorkStealingPool> pool_;
+  scoped_refptr<SequencedTaskRunner> task_runner_;
+};
+
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingPoolSequencedTaskRunner,
+                              TaskRunnerTest,
+                              WorkStealingPoolSequencedTaskRunnerTestDelegate);
+
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingPoolSequencedTaskRunner,
+                              SequencedTaskRunnerTest,
+                              WorkStealingPoolSequencedTaskRunnerTestDelegate);
+
+}  // namespace
+
+}  // namespace base
@@ -8,6 +8,7 @@
 
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
+#include "base/message_loop/message_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/thread_task_runner_handle.h"
 #include "base/threading/platform_thread.h"
@@ -22,10 +23,16 @@ namespace base {
 class BaseTimerTaskInternal {
  public:
   explicit BaseTimerTaskInternal(Timer* timer)
-      : timer_(timer) {
+      : timer_(timer),
+        message_loop_(NULL),
+        task_id_(DelayedTaskQueue::kBadTaskId) {
   }
 
   ~BaseTimerTaskInternal() {
+    // This task is being deleted by the task runner, so it mustn't cancel
+    // itself when abandoned.
+    message_loop_ = NULL;
+
     // This task may be getting cleared because the task runner has been
     // destructed.  If so, don't leave Timer with a dangling pointer
     // to this.
@@ -50,15 +57,51 @@ class BaseTimerTaskInternal {
   }
 
   // The task remains in the MessageLoop queue, but nothing will happen when it
-  // runs.
+  // runs. If it was posted with MessageLoop::PostCancelableDelayedTask(), it
+  // is taken out of the queue and deleted instead.
   void Abandon() {
     timer_ = NULL;
+    if (message_loop_) {
+      MessageLoop* message_loop = message_loop_;
+      message_loop_ = NULL;
+      // Deletes |this|.
+      message_loop->CancelDelayedTask(task_id_);
+    }
+  }
+
+  // Whether Abandon() takes the task out of the MessageLoop queue.
+  bool is_cancelable() const { return message_loop_ != NULL; }
+
+  void set_cancelable(MessageLoop* message_loop,
+                      DelayedTaskQueue::TaskId task_id) {
+    message_loop_ = message_loop;
+    task_id_ = task_id;
   }
 
  private:
   Timer* timer_;
+
+  // The loop and id with which Abandon() cancels the task, if it can.
+  MessageLoop* message_loop_;
+  DelayedTaskQueue::TaskId task_id_;
 };
 
+namespace {
+
+// Returns the current MessageLoop if it runs the tasks of the current
+// thread's task runner, so that a Timer without its own task runner can post
+// cancelable tasks to it.
+MessageLoop* GetMessageLoopForTimer() {
+  MessageLoop* message_loop = MessageLoop::current();
+  if (!message_loop || !ThreadTaskRunnerHandle::IsSet() ||
+      message_loop->task_runner() != ThreadTaskRunnerHandle::Get()) {
+    return NULL;
+  }
+  return message_loop;
+}
+
+}  // namespace
+
 Timer::Timer(bool retain_user_task, bool is_repeating)
     : scheduled_task_(NULL),
       thread_id_(0),
@@ -110,6 +153,9 @@ void Timer::Stop() {
   is_running_ = false;
   if (!retain_user_task_)
     user_task_.Reset();
+  // A task which can be canceled is not worth keeping for a later Reset().
+  if (scheduled_task_ && scheduled_task_->is_cancelable())
+    AbandonScheduledTask();
 }
 
 void Timer::Reset() {
@@ -128,8 +174,10 @@ void Timer::Reset() {
     desired_run_time_ = TimeTicks();
 
   // We can use the existing scheduled task if it arrives before the new
-  // desired_run_time_.
-  if (desired_run_time_ >= scheduled_run_time_) {
+  // desired_run_time_, unless it can be canceled, which is cheaper than
+  // waking up for it only to post a continuation.
+  if (desired_run_time_ >= scheduled_run_time_ &&
+      !scheduled_task_->is_cancelable()) {
     is_running_ = true;
     return;
   }
@@ -151,7 +199,16 @@ void Timer::PostNewScheduledTask(TimeDelta delay) {
   DCHECK(scheduled_task_ == NULL);
   is_running_ = true;
   scheduled_task_ = new BaseTimerTaskInternal(this);
-  if (delay > TimeDelta::FromMicroseconds(0)) {
+  MessageLoop* message_loop = task_runner_.get() ? NULL
+                                                : GetMessageLoopForTimer();
+  if (delay > TimeDelta::FromMicroseconds(0) && message_loop) {
+    DelayedTaskQueue::TaskId task_id = message_loop->PostCancelableDelayedTask(
+        posted_from_,
+        base::Bind(&BaseTimerTaskInternal::Run, base::Owned(scheduled_task_)),
+        delay);
+    scheduled_task_->set_cancelable(message_loop, task_id);
+    scheduled_run_time_ = desired_run_time_ = TimeTicks::Now() + delay;
+  } else if (delay > TimeDelta::FromMicroseconds(0)) {
     GetTaskRunner()->PostDelayedTask(posted_from_,
         base::Bind(&BaseTimerTaskInternal::Run, base::Owned(scheduled_task_)),
         delay);
@@ -177,8 +177,10 @@ class BASE_EXPORT Timer {
   // greater than scheduled_run_time_, a continuation task will be posted to
   // wait for the remaining time. This allows us to reuse the pending task so as
   // not to flood the MessageLoop with orphaned tasks when the user code
-  // excessively Stops and Starts the timer. This time can be a "zero" TimeTicks
-  // if the task must be run immediately.
+  // excessively Stops and Starts the timer. A task posted with
+  // MessageLoop::PostCancelableDelayedTask() is canceled by Stop() and Reset()
+  // instead. This time can be a "zero" TimeTicks if the task must be run
+  // immediately.
   TimeTicks desired_run_time_;
 
   // Thread ID of current MessageLoop for verifying single-threaded usage.
@@ -483,6 +483,30 @@ TEST(TimerTest, RetainNonRepeatIsRunning) {
   EXPECT_TRUE(timer.IsRunning());
 }
 
+// A Timer which posts its task with MessageLoop::PostCancelableDelayedTask()
+// takes the task out of the loop as soon as it is stopped or restarted,
+// rather than leaving it there to run for nothing.
+TEST(TimerTest, StopAndRestartCancelScheduledTask) {
+  base::MessageLoop loop;
+  base::Timer timer(true, false);
+  timer.Start(FROM_HERE, TimeDelta::FromDays(1),
+              base::Bind(&TimerTestCallback));
+  EXPECT_EQ(1u, loop.GetDelayedTaskCountForTesting());
+  timer.Stop();
+  EXPECT_EQ(0u, loop.GetDelayedTaskCountForTesting());
+
+  timer.Reset();
+  EXPECT_EQ(1u, loop.GetDelayedTaskCountForTesting());
+  timer.Start(FROM_HERE, TimeDelta::FromHours(1),
+              base::Bind(&TimerTestCallback));
+  EXPECT_EQ(1u, loop.GetDelayedTaskCountForTesting());
+  timer.Start(FROM_HERE, TimeDelta::FromDays(2),
+              base::Bind(&TimerTestCallback));
+  EXPECT_EQ(1u, loop.GetDelayedTaskCountForTesting());
+  timer.Stop();
+  EXPECT_EQ(0u, loop.GetDelayedTaskCountForTesting());
+}
+
 namespace {
 
 bool g_callback_happened1 = false;
@@ -0,0 +1,331 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_event_binary.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/trace_event/trace_event.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const char kChunkMagic = 'T';
+const uint8 kChunkVersion = 1;
+const char kStringRecord = 'S';
+const char kEventRecord = 'E';
+
+class ChunkReader {
+ public:
+  ChunkReader(const char* data, size_t size) : ptr_(data), end_(data + size) {}
+
+  bool AtEnd() const { return ptr_ == end_; }
+
+  bool ReadU8(uint8* value) {
+    if (ptr_ == end_)
+      return false;
+    *value = static_cast<uint8>(*ptr_++);
+    return true;
+  }
+
+  bool ReadVarint(uint64* value) {
+    uint64 result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8 byte;
+      if (!ReadU8(&byte))
+        return false;
+      result |= static_cast<uint64>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadSignedVarint(int64* value) {
+    uint64 zigzag;
+    if (!ReadVarint(&zigzag))
+      return false;
+    *value = static_cast<int64>(zigzag >> 1) ^ -static_cast<int64>(zigzag & 1);
+    return true;
+  }
+
+  bool ReadDouble(double* value) {
+    if (static_cast<size_t>(end_ - ptr_) < sizeof(*value))
+      return false;
+    memcpy(value, ptr_, sizeof(*value));
+    ptr_ += sizeof(*value);
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint64 length;
+    if (!ReadVarint(&length) || length > static_cast<uint64>(end_ - ptr_))
+      return false;
+    value->assign(ptr_, static_cast<size_t>(length));
+    ptr_ += length;
+    return true;
+  }
+
+  bool ReadStringId(const std::vector<std::string>& strings,
+                    const std::string** value) {
+    uint64 id;
+    if (!ReadVarint(&id) || id >= strings.size())
+      return false;
+    *value = &strings[static_cast<size_t>(id)];
+    return true;
+  }
+
+ private:
+  const char* ptr_;
+  const char* const end_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkReader);
+};
+
+// Mirrors TraceEvent::AppendAsJSON().
+bool AppendEventAsJSON(ChunkReader* reader,
+                       int64 process_id,
+                       const std::vector<std::string>& strings,
+                       std::string* out) {
+  int64 thread_id;
+  int64 timestamp;
+  uint8 phase;
+  uint8 flags;
+  uint8 fields;
+  const std::string* category;
+  const std::string* name;
+  uint8 num_args;
+  if (!reader->ReadSignedVarint(&thread_id) ||
+      !reader->ReadSignedVarint(&timestamp) || !reader->ReadU8(&phase) ||
+      !reader->ReadU8(&flags) || !reader->ReadU8(&fields) ||
+      !reader->ReadStringId(strings, &category) ||
+      !reader->ReadStringId(strings, &name) || !reader->ReadU8(&num_args) ||
+      num_args > kTraceMaxNumArgs) {
+    return false;
+  }
+
+  StringAppendF(out, "{\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64
+                     ","
+                     "\"ph\":\"%c\",\"cat\":\"%s\",\"name\":\"%s\",\"args\":{",
+                static_cast<int>(process_id), static_cast<int>(thread_id),
+                timestamp, phase, category->c_str(), name->c_str());
+
+  if (fields & kTraceEventBinaryArgsStripped)
+    *out += "\"stripped\":1";
+  for (int i = 0; i < num_args; ++i) {
+    const std::string* arg_name;
+    uint8 type;
+    if (!reader->ReadStringId(strings, &arg_name) || !reader->ReadU8(&type))
+      return false;
+    if (i > 0)
+      *out += ",";
+    *out += "\"";
+    *out += *arg_name;
+    *out += "\":";
+
+    TraceEvent::TraceValue value;
+    std::string string_value;
+    switch (type) {
+      case TRACE_VALUE_TYPE_BOOL: {
+        uint8 bool_value;
+        if (!reader->ReadU8(&bool_value))
+          return false;
+        value.as_bool = bool_value != 0;
+        break;
+      }
+      case TRACE_VALUE_TYPE_UINT: {
+        uint64 uint_value;
+        if (!reader->ReadVarint(&uint_value))
+          return false;
+        value.as_uint = uint_value;
+        break;
+      }
+      case TRACE_VALUE_TYPE_INT: {
+        int64 int_value;
+        if (!reader->ReadSignedVarint(&int_value))
+          return false;
+        value.as_int = int_value;
+        break;
+      }
+      case TRACE_VALUE_TYPE_DOUBLE:
+        if (!reader->ReadDouble(&value.as_double))
+          return false;
+        break;
+      case TRACE_VALUE_TYPE_POINTER: {
+        // Not converted back to a pointer, which may be narrower in this
+        // process than in the traced one.
+        uint64 pointer_value;
+        if (!reader->ReadVarint(&pointer_value))
+          return false;
+        StringAppendF(out, "\"0x%" PRIx64 "\"", pointer_value);
+        continue;
+      }
+      case TRACE_VALUE_TYPE_STRING:
+      case TRACE_VALUE_TYPE_COPY_STRING:
+        if (!reader->ReadString(&string_value))
+          return false;
+        value.as_string = string_value.c_str();
+        break;
+      case TRACE_VALUE_TYPE_CONVERTABLE:
+        if (!reader->ReadString(&string_value))
+          return false;
+        *out += string_value;
+        continue;
+      default:
+        return false;
+    }
+    TraceEvent::AppendValueAsJSON(type, value, out);
+  }
+  *out += "}";
+
+  int64 value;
+  if (fields & kTraceEventBinaryHasDuration) {
+    if (!reader->ReadSignedVarint(&value))
+      return false;
+    StringAppendF(out, ",\"dur\":%" PRId64, value);
+  }
+  if (fields & kTraceEventBinaryHasThreadDuration) {
+    if (!reader->ReadSignedVarint(&value))
+      return false;
+    StringAppendF(out, ",\"tdur\":%" PRId64, value);
+  }
+  if (fields & kTraceEventBinaryHasThreadTimestamp) {
+    if (!reader->ReadSignedVarint(&value))
+      return false;
+    StringAppendF(out, ",\"tts\":%" PRId64, value);
+  }
+
+  if (flags & TRACE_EVENT_FLAG_ASYNC_TTS)
+    StringAppendF(out, ", \"use_async_tts\":1");
+
+  if (flags & TRACE_EVENT_FLAG_HAS_ID) {
+    uint64 id;
+    if (!reader->ReadVarint(&id))
+      return false;
+    StringAppendF(out, ",\"id\":\"0x%" PRIx64 "\"", id);
+  }
+
+  if (phase == TRACE_EVENT_PHASE_INSTANT) {
+    char scope = '?';
+    switch (flags & TRACE_EVENT_FLAG_SCOPE_MASK) {
+      case TRACE_EVENT_SCOPE_GLOBAL:
+        scope = TRACE_EVENT_SCOPE_NAME_GLOBAL;
+        break;
+
+      case TRACE_EVENT_SCOPE_PROCESS:
+        scope = TRACE_EVENT_SCOPE_NAME_PROCESS;
+        break;
+
+      case TRACE_EVENT_SCOPE_THREAD:
+        scope = TRACE_EVENT_SCOPE_NAME_THREAD;
+        break;
+    }
+    StringAppendF(out, ",\"s\":\"%c\"", scope);
+  }
+
+  *out += "}";
+  return true;
+}
+
+}  // namespace
+
+TraceEventBinaryWriter::TraceEventBinaryWriter(int process_id,
+                                               std::string* out)
+    : out_(out), next_string_id_(0) {
+  out_->push_back(kChunkMagic);
+  WriteU8(kChunkVersion);
+  WriteSignedVarint(process_id);
+}
+
+TraceEventBinaryWriter::~TraceEventBinaryWriter() {}
+
+uint32 TraceEventBinaryWriter::InternString(const char* str, bool is_static) {
+  if (is_static) {
+    hash_map<const char*, uint32>::const_iterator it =
+        static_string_ids_.find(str);
+    if (it != static_string_ids_.end())
+      return it->second;
+    static_string_ids_[str] = next_string_id_;
+  }
+  out_->push_back(kStringRecord);
+  WriteString(str, strlen(str));
+  return next_string_id_++;
+}
+
+void TraceEventBinaryWriter::BeginEvent() {
+  out_->push_back(kEventRecord);
+}
+
+void TraceEventBinaryWriter::WriteU8(uint8 value) {
+  out_->push_back(static_cast<char>(value));
+}
+
+void TraceEventBinaryWriter::WriteVarint(uint64 value) {
+  while (value >= 0x80) {
+    out_->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out_->push_back(static_cast<char>(value));
+}
+
+void TraceEventBinaryWriter::WriteSignedVarint(int64 value) {
+  WriteVarint((static_cast<uint64>(value) << 1) ^
+              static_cast<uint64>(value >> 63));
+}
+
+void TraceEventBinaryWriter::WriteDouble(double value) {
+  out_->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void TraceEventBinaryWriter::WriteString(const char* data, size_t length) {
+  WriteVarint(length);
+  out_->append(data, length);
+}
+
+bool AppendBinaryTraceEventsAsJSON(const char* data,
+                                   size_t size,
+                                   std::string* out) {
+  ChunkReader reader(data, size);
+  uint8 magic;
+  uint8 version;
+  int64 process_id;
+  if (!reader.ReadU8(&magic) || magic != kChunkMagic ||
+      !reader.ReadU8(&version) || version != kChunkVersion ||
+      !reader.ReadSignedVarint(&process_id)) {
+    return false;
+  }
+
+  std::vector<std::string> strings;
+  bool first_event = true;
+  while (!reader.AtEnd()) {
+    uint8 record;
+    if (!reader.ReadU8(&record))
+      return false;
+    if (record == kStringRecord) {
+      strings.push_back(std::string());
+      if (!reader.ReadString(&strings.back()))
+        return false;
+    } else if (record == kEventRecord) {
+      if (!first_event)
+        out->append(",\n");
+      first_event = false;
+      if (!AppendEventAsJSON(&reader, process_id, strings, out))
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace trace_event
+}  // namespace base
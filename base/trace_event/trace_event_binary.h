@@ -0,0 +1,89 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A compact binary encoding of trace events, produced by
+// TraceLog::FlushAsBinary(). Producing it involves no number formatting or
+// string escaping, so a traced process can hand its events over cheaply and
+// leave the conversion to the JSON trace format
+// (AppendBinaryTraceEventsAsJSON()) to whoever collects them.
+//
+// Each chunk passed to the flush callback is self-contained (or empty, if it
+// has no events):
+//   chunk  := 'T' version:u8 pid:svarint record*
+//   record := 'S' length:varint byte*     Defines the next string ID (from 0).
+//           | 'E' event
+//   event  := tid:svarint ts:svarint phase:u8 flags:u8 fields:u8
+//             category:varint name:varint num_args:u8 arg*
+//             [dur:svarint]                if fields & kHasDuration
+//             [tdur:svarint]               if fields & kHasThreadDuration
+//             [tts:svarint]                if fields & kHasThreadTimestamp
+//             [id:varint]                  if flags & TRACE_EVENT_FLAG_HAS_ID
+//   arg    := name:varint type:u8 value
+// where category, name and argument names are string IDs, varints are
+// unsigned LEB128 and svarints are zigzag-encoded LEB128. Values are encoded
+// according to their TRACE_VALUE_TYPE_*: bools as a u8, unsigned ints and
+// pointers as varints, ints as svarints, doubles as their 8 bytes (in host
+// order), and strings and convertables (already in the trace format) as a
+// varint length followed by their bytes.
+
+#ifndef BASE_TRACE_EVENT_TRACE_EVENT_BINARY_H_
+#define BASE_TRACE_EVENT_TRACE_EVENT_BINARY_H_
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+
+namespace base {
+namespace trace_event {
+
+// Bits of the |fields| byte of an event.
+enum TraceEventBinaryFields {
+  kTraceEventBinaryHasDuration = 1 << 0,
+  kTraceEventBinaryHasThreadDuration = 1 << 1,
+  kTraceEventBinaryHasThreadTimestamp = 1 << 2,
+  kTraceEventBinaryArgsStripped = 1 << 3,
+};
+
+// Writes one chunk to a string (see TraceEvent::AppendAsBinary()).
+class BASE_EXPORT TraceEventBinaryWriter {
+ public:
+  // Appends the chunk header to |out|.
+  TraceEventBinaryWriter(int process_id, std::string* out);
+  ~TraceEventBinaryWriter();
+
+  // Returns the ID of |str|, defining it first if needed. Must be called
+  // before starting the event that uses it. Strings that live as long as the
+  // process (|is_static|) are only defined once per chunk.
+  uint32 InternString(const char* str, bool is_static);
+
+  void BeginEvent();
+  void WriteU8(uint8 value);
+  void WriteVarint(uint64 value);
+  void WriteSignedVarint(int64 value);
+  void WriteDouble(double value);
+  void WriteString(const char* data, size_t length);
+
+  size_t size() const { return out_->size(); }
+
+ private:
+  std::string* const out_;
+  uint32 next_string_id_;
+  hash_map<const char*, uint32> static_string_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceEventBinaryWriter);
+};
+
+// Appends the events of a chunk to |out| in the JSON trace format, separated
+// like in the output of TraceLog::Flush(). Returns false (possibly after
+// appending some events) if the chunk is malformed.
+BASE_EXPORT bool AppendBinaryTraceEventsAsJSON(const char* data,
+                                               size_t size,
+                                               std::string* out);
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_TRACE_EVENT_BINARY_H_
@@ -0,0 +1,230 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_event_binary.h"
+
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/bind.h"
+#include "base/json/json_reader.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_argument.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+class TraceEventBinaryTest : public testing::Test {
+ public:
+  void SetUp() override { TraceLog::DeleteForTesting(); }
+  void TearDown() override { TraceLog::DeleteForTesting(); }
+
+  // Checks that |event| is converted to the same JSON through the binary
+  // format as directly.
+  void ExpectSameJSON(const TraceEvent& event) {
+    std::string json;
+    event.AppendAsJSON(&json, TraceEvent::ArgumentFilterPredicate());
+
+    std::string binary;
+    {
+      TraceEventBinaryWriter writer(TraceLog::GetInstance()->process_id(),
+                                    &binary);
+      event.AppendAsBinary(&writer, TraceEvent::ArgumentFilterPredicate());
+    }
+    std::string json_from_binary;
+    EXPECT_TRUE(AppendBinaryTraceEventsAsJSON(binary.data(), binary.size(),
+                                              &json_from_binary));
+    EXPECT_EQ(json, json_from_binary);
+  }
+
+  void InitializeEvent(TraceEvent* event,
+                       char phase,
+                       const char* name,
+                       unsigned long long id,
+                       int num_args,
+                       const char** arg_names,
+                       const unsigned char* arg_types,
+                       const unsigned long long* arg_values,
+                       unsigned char flags) {
+    scoped_refptr<ConvertableToTraceFormat> convertable_values[2];
+    for (int i = 0; i < num_args; ++i) {
+      if (arg_types[i] == TRACE_VALUE_TYPE_CONVERTABLE) {
+        scoped_refptr<TracedValue> value = new TracedValue();
+        value->SetInteger("answer", 42);
+        value->SetString("quote", "\"");
+        convertable_values[i] = value;
+      }
+    }
+    event->Initialize(
+        7, TraceTicks::FromInternalValue(123456789),
+        ThreadTicks::FromInternalValue(4321), phase,
+        TraceLog::GetCategoryGroupEnabled("binary_test"), name, id, num_args,
+        arg_names, arg_types, arg_values, convertable_values, flags);
+  }
+
+  void OnChunk(std::vector<std::string>* chunks,
+               const scoped_refptr<RefCountedString>& chunk,
+               bool has_more_events) {
+    chunks->push_back(chunk->data());
+  }
+
+ private:
+  // Tears the TraceLog singleton down after each test.
+  ShadowingAtExitManager at_exit_manager_;
+};
+
+unsigned long long AsArgValue(TraceEvent::TraceValue value) {
+  return value.as_uint;
+}
+
+TEST_F(TraceEventBinaryTest, ArgumentTypes) {
+  const char* arg_names[] = {"a", "b"};
+  TraceEvent::TraceValue values[2];
+  unsigned char types[2];
+  unsigned long long arg_values[2];
+
+  types[0] = TRACE_VALUE_TYPE_BOOL;
+  values[0].as_bool = true;
+  types[1] = TRACE_VALUE_TYPE_UINT;
+  values[1].as_uint = 0xfedcba9876543210ull;
+  for (int i = 0; i < 2; ++i)
+    arg_values[i] = AsArgValue(values[i]);
+  TraceEvent event;
+  InitializeEvent(&event, TRACE_EVENT_PHASE_BEGIN, "bool_uint", 0, 2,
+                  arg_names, types, arg_values, TRACE_EVENT_FLAG_NONE);
+  ExpectSameJSON(event);
+
+  types[0] = TRACE_VALUE_TYPE_INT;
+  values[0].as_int = -1234567890123ll;
+  types[1] = TRACE_VALUE_TYPE_DOUBLE;
+  values[1].as_double = -0.25;
+  for (int i = 0; i < 2; ++i)
+    arg_values[i] = AsArgValue(values[i]);
+  event.Reset();
+  InitializeEvent(&event, TRACE_EVENT_PHASE_END, "int_double", 0, 2,
+                  arg_names, types, arg_values, TRACE_EVENT_FLAG_NONE);
+  ExpectSameJSON(event);
+
+  types[0] = TRACE_VALUE_TYPE_POINTER;
+  values[0].as_pointer = &event;
+  types[1] = TRACE_VALUE_TYPE_STRING;
+  values[1].as_string = "needs \"escaping\"\n";
+  for (int i = 0; i < 2; ++i)
+    arg_values[i] = AsArgValue(values[i]);
+  event.Reset();
+  InitializeEvent(&event, TRACE_EVENT_PHASE_INSTANT, "pointer_string", 0, 2,
+                  arg_names, types, arg_values, TRACE_EVENT_SCOPE_PROCESS);
+  ExpectSameJSON(event);
+
+  types[0] = TRACE_VALUE_TYPE_CONVERTABLE;
+  arg_values[0] = 0;
+  types[1] = TRACE_VALUE_TYPE_COPY_STRING;
+  values[1].as_string = "copied";
+  arg_values[1] = AsArgValue(values[1]);
+  event.Reset();
+  InitializeEvent(&event, TRACE_EVENT_PHASE_INSTANT, "convertable_copy", 0, 2,
+                  arg_names, types, arg_values,
+                  TRACE_EVENT_FLAG_COPY | TRACE_EVENT_SCOPE_THREAD);
+  ExpectSameJSON(event);
+}
+
+TEST_F(TraceEventBinaryTest, PhasesAndFlags) {
+  TraceEvent event;
+  InitializeEvent(&event, TRACE_EVENT_PHASE_ASYNC_BEGIN, "async",
+                  0x123456789abcull, 0, nullptr, nullptr, nullptr,
+                  TRACE_EVENT_FLAG_HAS_ID | TRACE_EVENT_FLAG_ASYNC_TTS);
+  ExpectSameJSON(event);
+
+  event.Reset();
+  InitializeEvent(&event, TRACE_EVENT_PHASE_COMPLETE, "complete", 0, 0,
+                  nullptr, nullptr, nullptr, TRACE_EVENT_FLAG_NONE);
+  // Not ended yet.
+  ExpectSameJSON(event);
+  event.UpdateDuration(TraceTicks::FromInternalValue(123456999),
+                       ThreadTicks::FromInternalValue(4400));
+  ExpectSameJSON(event);
+}
+
+TEST_F(TraceEventBinaryTest, FlushAsBinary) {
+  TraceLog* trace_log = TraceLog::GetInstance();
+  trace_log->SetEnabled(TraceConfig("*", ""), TraceLog::RECORDING_MODE);
+  const int kNumEvents = 10000;
+  for (int i = 0; i < kNumEvents; ++i)
+    TRACE_EVENT_INSTANT1("binary_test", "event", TRACE_EVENT_SCOPE_THREAD,
+                         "i", i);
+  trace_log->SetDisabled();
+
+  std::vector<std::string> chunks;
+  trace_log->FlushAsBinary(Bind(&TraceEventBinaryTest::OnChunk,
+                                Unretained(this), Unretained(&chunks)));
+  // Events are split into several chunks, each with its own string table.
+  ASSERT_LT(1u, chunks.size());
+
+  std::string json = "[";
+  for (const std::string& chunk : chunks) {
+    if (chunk.empty())
+      continue;
+    if (json.size() > 1)
+      json += ",";
+    size_t size = json.size();
+    ASSERT_TRUE(AppendBinaryTraceEventsAsJSON(chunk.data(), chunk.size(),
+                                              &json));
+    EXPECT_LT(size, json.size());
+  }
+  json += "]";
+
+  scoped_ptr<Value> value = JSONReader::Read(json);
+  ListValue* events = nullptr;
+  ASSERT_TRUE(value && value->GetAsList(&events));
+  int next_i = 0;
+  for (size_t j = 0; j < events->GetSize(); ++j) {
+    DictionaryValue* event = nullptr;
+    std::string name;
+    ASSERT_TRUE(events->GetDictionary(j, &event));
+    ASSERT_TRUE(event->GetString("name", &name));
+    if (name != "event")
+      continue;
+    int i = -1;
+    EXPECT_TRUE(event->GetInteger("args.i", &i));
+    EXPECT_EQ(next_i++, i);
+  }
+  EXPECT_EQ(kNumEvents, next_i);
+}
+
+TEST_F(TraceEventBinaryTest, MalformedChunks) {
+  std::string binary;
+  {
+    TraceEventBinaryWriter writer(1, &binary);
+    writer.InternString("category", true);
+    writer.BeginEvent();
+    writer.WriteSignedVarint(1);
+    writer.WriteSignedVarint(2);
+    writer.WriteU8(TRACE_EVENT_PHASE_BEGIN);
+    writer.WriteU8(TRACE_EVENT_FLAG_NONE);
+    writer.WriteU8(0);
+    writer.WriteVarint(0);
+    // An undefined string ID.
+    writer.WriteVarint(1);
+    writer.WriteU8(0);
+  }
+  std::string json;
+  EXPECT_FALSE(
+      AppendBinaryTraceEventsAsJSON(binary.data(), binary.size(), &json));
+  EXPECT_FALSE(AppendBinaryTraceEventsAsJSON("{}", 2, &json));
+  // Truncated.
+  EXPECT_FALSE(
+      AppendBinaryTraceEventsAsJSON(binary.data(), binary.size() - 3, &json));
+}
+
+}  // namespace
+
+}  // namespace trace_event
+}  // namespace base
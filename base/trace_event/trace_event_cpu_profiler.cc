@@ -0,0 +1,420 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_event_cpu_profiler.h"
+
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/debug/stack_trace.h"
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_argument.h"
+
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+#include <dlfcn.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/ucontext.h>
+#include <unistd.h>
+
+#if defined(__GLIBCXX__)
+#include <cxxabi.h>
+#endif
+#endif  // defined(TRACE_CPU_PROFILER_SUPPORTED)
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const char kCategory[] = TRACE_DISABLED_BY_DEFAULT("cpu_profiler");
+
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+
+// Stacks deeper than this are truncated, dropping their outermost frames.
+const size_t kMaxFrames = 32;
+// A thread's samples are dropped if its buffer fills up between flushes. This
+// must be a power of 2, so that the wrapping indices below stay consistent.
+const uint32 kSamplesPerThread = 128;
+// Threads are given a buffer the first time they are sampled, and keep it
+// until they exit. Samples of threads beyond this many are dropped.
+const size_t kMaxThreads = TraceCpuProfiler::kMaxThreads;
+
+struct Sample {
+  int64 timestamp;
+  size_t num_frames;
+  // Innermost first.
+  const void* frames[kMaxFrames];
+};
+
+// The samples of one thread. Only the signal handler, on that thread, advances
+// |write_index|, and only FlushSamples() advances |read_index|, so neither
+// needs a lock.
+struct ThreadBuffer {
+  // 0 until the buffer is claimed by a thread, and again once FlushSamples()
+  // finds that the thread has exited.
+  subtle::Atomic32 thread_id;
+  subtle::Atomic32 write_index;
+  subtle::Atomic32 read_index;
+  Sample samples[kSamplesPerThread];
+};
+
+struct SampleBuffers {
+  ThreadBuffer threads[kMaxThreads];
+  subtle::Atomic32 num_dropped_samples;
+};
+
+// Set while a profiler is sampling.
+subtle::Atomic32 g_profiler_active = 0;
+// Whether the signal handler records samples.
+subtle::Atomic32 g_sampling = 0;
+// Allocated the first time a profiler starts, and never freed, since a signal
+// may still be delivered after sampling stops.
+SampleBuffers* g_buffers = nullptr;
+bool g_signal_handler_installed = false;
+
+// Returns the address of the instruction the signal interrupted, or null if
+// it can't be found on this architecture.
+const void* GetInterruptedPc(void* context) {
+  const ucontext_t* ucontext = static_cast<const ucontext_t*>(context);
+#if defined(ARCH_CPU_X86_64)
+  return reinterpret_cast<const void*>(ucontext->uc_mcontext.gregs[REG_RIP]);
+#elif defined(ARCH_CPU_X86)
+  return reinterpret_cast<const void*>(ucontext->uc_mcontext.gregs[REG_EIP]);
+#elif defined(ARCH_CPU_ARMEL)
+  return reinterpret_cast<const void*>(ucontext->uc_mcontext.arm_pc);
+#elif defined(ARCH_CPU_ARM64)
+  return reinterpret_cast<const void*>(ucontext->uc_mcontext.pc);
+#else
+  return nullptr;
+#endif
+}
+
+// Returns the calling thread's buffer, claiming one if needed, or null if
+// they're all taken.
+ThreadBuffer* GetThreadBuffer(subtle::Atomic32 thread_id) {
+  // Look for a buffer the thread already owns first: FlushSamples() may have
+  // freed a slot in front of it, and claiming that one would give the thread
+  // two buffers.
+  for (size_t i = 0; i < kMaxThreads; i++) {
+    ThreadBuffer* buffer = &g_buffers->threads[i];
+    if (subtle::NoBarrier_Load(&buffer->thread_id) == thread_id)
+      return buffer;
+  }
+  for (size_t i = 0; i < kMaxThreads; i++) {
+    ThreadBuffer* buffer = &g_buffers->threads[i];
+    if (subtle::NoBarrier_Load(&buffer->thread_id) == 0 &&
+        subtle::NoBarrier_CompareAndSwap(&buffer->thread_id, 0, thread_id) ==
+            0) {
+      return buffer;
+    }
+  }
+  return nullptr;
+}
+
+void RecordSample(void* context) {
+  // NOTE: This code MUST be async-signal safe. NO malloc or locks are allowed
+  // here.
+  ThreadBuffer* buffer = GetThreadBuffer(
+      static_cast<subtle::Atomic32>(PlatformThread::CurrentId()));
+  if (!buffer) {
+    subtle::NoBarrier_AtomicIncrement(&g_buffers->num_dropped_samples, 1);
+    return;
+  }
+  uint32 write_index =
+      static_cast<uint32>(subtle::NoBarrier_Load(&buffer->write_index));
+  uint32 read_index =
+      static_cast<uint32>(subtle::Acquire_Load(&buffer->read_index));
+  if (write_index - read_index >= kSamplesPerThread) {
+    subtle::NoBarrier_AtomicIncrement(&g_buffers->num_dropped_samples, 1);
+    return;
+  }
+
+  Sample* sample = &buffer->samples[write_index % kSamplesPerThread];
+  sample->timestamp = TraceTicks::Now().ToInternalValue();
+
+  // The stack trace starts with the signal handler's own frames. They end with
+  // the interrupted instruction; if it can't be found, the unwinding didn't
+  // get through the signal frame, and the instruction is all there is.
+  debug::StackTrace stack_trace;
+  size_t count = 0;
+  const void* const* frames = stack_trace.Addresses(&count);
+  const void* pc = GetInterruptedPc(context);
+  size_t first = 0;
+  while (first < count && frames[first] != pc)
+    first++;
+  if (first == count) {
+    sample->frames[0] = pc;
+    sample->num_frames = pc ? 1 : 0;
+  } else {
+    size_t num_frames = 0;
+    for (size_t i = first; i < count && num_frames < kMaxFrames; i++)
+      sample->frames[num_frames++] = frames[i];
+    sample->num_frames = num_frames;
+  }
+
+  subtle::Release_Store(&buffer->write_index,
+                        static_cast<subtle::Atomic32>(write_index + 1));
+}
+
+void ProfSignalHandler(int signal, siginfo_t* info, void* context) {
+  if (!subtle::Acquire_Load(&g_sampling))
+    return;
+  int saved_errno = errno;
+  RecordSample(context);
+  errno = saved_errno;
+}
+
+// Returns a name for the frame at |pc|: its symbol if it has one, and the
+// module and offset (for offline symbolization) otherwise.
+std::string GetFrameName(const void* pc) {
+  Dl_info info;
+  if (!dladdr(pc, &info))
+    return StringPrintf("%p", pc);
+  if (info.dli_sname) {
+#if defined(__GLIBCXX__)
+    int status = 0;
+    char* demangled =
+        abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    if (demangled) {
+      std::string name(demangled);
+      free(demangled);
+      return name;
+    }
+#endif
+    return info.dli_sname;
+  }
+  std::string module =
+      info.dli_fname ? FilePath(info.dli_fname).BaseName().value() : "?";
+  return StringPrintf(
+      "%s+0x%" PRIxPTR, module.c_str(),
+      reinterpret_cast<uintptr_t>(pc) -
+          reinterpret_cast<uintptr_t>(info.dli_fbase));
+}
+
+// Returns whether the thread with |thread_id| has exited. Its id may have
+// been reused by then, but only after a while, so the buffer of a thread which
+// exits between two flushes is released by the second.
+bool HasThreadExited(subtle::Atomic32 thread_id) {
+  return syscall(__NR_tgkill, getpid(), thread_id, 0) != 0 && errno == ESRCH;
+}
+
+#endif  // defined(TRACE_CPU_PROFILER_SUPPORTED)
+
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////////////
+
+// static
+const size_t TraceCpuProfiler::kMaxThreads;
+
+TraceCpuProfiler::TraceCpuProfiler(
+    scoped_refptr<SingleThreadTaskRunner> task_runner)
+    : task_runner_(task_runner.Pass()),
+      num_dropped_samples_at_start_(0),
+      weak_factory_(this) {
+  // Force the "cpu_profiler" category to show up in the trace viewer.
+  TRACE_EVENT0(kCategory, "init");
+  // Watch for the tracing system being enabled.
+  TraceLog::GetInstance()->AddEnabledStateObserver(this);
+}
+
+TraceCpuProfiler::~TraceCpuProfiler() {
+  if (flush_timer_.IsRunning())
+    StopProfiling();
+  TraceLog::GetInstance()->RemoveEnabledStateObserver(this);
+}
+
+// base::trace_event::TraceLog::EnabledStateChangedObserver overrides:
+void TraceCpuProfiler::OnTraceLogEnabled() {
+  // Check to see if tracing is enabled for the cpu_profiler category.
+  bool enabled;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(kCategory, &enabled);
+  if (!enabled)
+    return;
+  task_runner_->PostTask(FROM_HERE,
+                         base::Bind(&TraceCpuProfiler::StartProfiling,
+                                    weak_factory_.GetWeakPtr()));
+}
+
+void TraceCpuProfiler::OnTraceLogDisabled() {
+  // The category is always disabled before OnTraceLogDisabled() is called, so
+  // we cannot tell if it was enabled before. Always try to stop sampling.
+  task_runner_->PostTask(FROM_HERE,
+                         base::Bind(&TraceCpuProfiler::StopProfiling,
+                                    weak_factory_.GetWeakPtr()));
+}
+
+void TraceCpuProfiler::StartProfiling() {
+  // Watch for the tracing framework sending enabling more than once.
+  if (flush_timer_.IsRunning())
+    return;
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+  if (subtle::Acquire_CompareAndSwap(&g_profiler_active, 0, 1) != 0) {
+    LOG(WARNING) << "Another CPU profiler is already sampling";
+    return;
+  }
+  DVLOG(1) << "Starting CPU profiler";
+
+  if (!g_buffers)
+    g_buffers = new SampleBuffers();
+  // Drop whatever was left from the last time, and release the buffers of
+  // the threads which exited since: the signal handler isn't running, so the
+  // threads still alive can claim them again.
+  for (size_t i = 0; i < kMaxThreads; i++) {
+    ThreadBuffer* buffer = &g_buffers->threads[i];
+    subtle::Release_Store(&buffer->read_index,
+                          subtle::Acquire_Load(&buffer->write_index));
+    subtle::Release_Store(&buffer->thread_id, 0);
+  }
+  num_dropped_samples_at_start_ =
+      subtle::NoBarrier_Load(&g_buffers->num_dropped_samples);
+
+  // The first unwinding may allocate (e.g., to load the unwinder), so that
+  // must not happen in the signal handler.
+  debug::StackTrace();
+
+  // The handler stays installed once sampling stops: a pending SIGPROF's
+  // default action would terminate the process.
+  if (!g_signal_handler_installed) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = &ProfSignalHandler;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+      PLOG(ERROR) << "sigaction";
+      subtle::Release_Store(&g_profiler_active, 0);
+      return;
+    }
+    g_signal_handler_installed = true;
+  }
+
+  // ITIMER_PROF counts the CPU time of the whole process, and delivers
+  // SIGPROF to a thread that is using it.
+  subtle::Release_Store(&g_sampling, 1);
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = kSamplingIntervalMicroseconds;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    PLOG(ERROR) << "setitimer";
+    subtle::Release_Store(&g_sampling, 0);
+    subtle::Release_Store(&g_profiler_active, 0);
+    return;
+  }
+
+  flush_timer_.Start(FROM_HERE,
+                     TimeDelta::FromMilliseconds(kFlushIntervalMilliseconds),
+                     base::Bind(&TraceCpuProfiler::FlushSamples,
+                                weak_factory_.GetWeakPtr()));
+#else
+  DVLOG(1) << "CPU profiling is not supported on this platform";
+#endif  // defined(TRACE_CPU_PROFILER_SUPPORTED)
+}
+
+void TraceCpuProfiler::FlushSamples() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+  if (!flush_timer_.IsRunning())
+    return;
+
+  size_t num_frames = frame_ids_.size();
+  scoped_refptr<TracedValue> new_frames = new TracedValue();
+  for (size_t i = 0; i < kMaxThreads; i++) {
+    ThreadBuffer* buffer = &g_buffers->threads[i];
+    subtle::Atomic32 thread_id = subtle::Acquire_Load(&buffer->thread_id);
+    if (!thread_id)
+      continue;
+    // Checked before reading the samples, so that an exited thread can't have
+    // added any after them.
+    bool thread_exited = HasThreadExited(thread_id);
+    uint32 write_index =
+        static_cast<uint32>(subtle::Acquire_Load(&buffer->write_index));
+    uint32 read_index =
+        static_cast<uint32>(subtle::NoBarrier_Load(&buffer->read_index));
+    for (; read_index != write_index; read_index++) {
+      const Sample& sample = buffer->samples[read_index % kSamplesPerThread];
+      // Frames are interned outermost first.
+      int frame_id = 0;
+      for (size_t j = sample.num_frames; j > 0; j--) {
+        frame_id =
+            InternFrame(frame_id, sample.frames[j - 1], new_frames.get());
+      }
+      TRACE_EVENT_SAMPLE_WITH_TID_AND_TIMESTAMP1(kCategory, "CpuSample",
+                                                 thread_id, sample.timestamp,
+                                                 "sf", frame_id);
+    }
+    subtle::Release_Store(&buffer->read_index,
+                          static_cast<subtle::Atomic32>(write_index));
+    if (thread_exited)
+      subtle::Release_Store(&buffer->thread_id, 0);
+  }
+
+  if (frame_ids_.size() != num_frames) {
+    TRACE_EVENT_INSTANT1(kCategory, "StackFrames", TRACE_EVENT_SCOPE_PROCESS,
+                         "frames",
+                         scoped_refptr<ConvertableToTraceFormat>(new_frames));
+  }
+
+  subtle::Atomic32 num_dropped_samples =
+      subtle::NoBarrier_Load(&g_buffers->num_dropped_samples) -
+      num_dropped_samples_at_start_;
+  if (num_dropped_samples)
+    TRACE_COUNTER1(kCategory, "DroppedCpuSamples", num_dropped_samples);
+#endif  // defined(TRACE_CPU_PROFILER_SUPPORTED)
+}
+
+void TraceCpuProfiler::StopProfiling() {
+  // Watch for the tracing framework sending disabled more than once.
+  if (!flush_timer_.IsRunning())
+    return;
+  DVLOG(1) << "Stopping CPU profiler";
+  flush_timer_.Stop();
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+  struct itimerval timer = {};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  subtle::Release_Store(&g_sampling, 0);
+  subtle::Release_Store(&g_profiler_active, 0);
+#endif
+  frame_ids_.clear();
+}
+
+int TraceCpuProfiler::InternFrame(int parent_id,
+                                  const void* pc,
+                                  TracedValue* new_frames) {
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+  int& id = frame_ids_[std::make_pair(parent_id, pc)];
+  if (id)
+    return id;
+  id = static_cast<int>(frame_ids_.size());
+  new_frames->BeginDictionary(IntToString(id).c_str());
+  new_frames->SetString("name", GetFrameName(pc));
+  if (parent_id)
+    new_frames->SetInteger("parent", parent_id);
+  new_frames->EndDictionary();
+  return id;
+#else
+  return 0;
+#endif
+}
+
+bool TraceCpuProfiler::IsTimerRunningForTest() const {
+  return flush_timer_.IsRunning();
+}
+
+}  // namespace trace_event
+}  // namespace base
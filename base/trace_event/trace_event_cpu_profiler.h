@@ -0,0 +1,110 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_TRACE_EVENT_CPU_PROFILER_H_
+#define BASE_TRACE_EVENT_TRACE_EVENT_CPU_PROFILER_H_
+
+#include <map>
+#include <utility>
+
+#include "base/base_export.h"
+#include "base/gtest_prod_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/timer/timer.h"
+#include "base/trace_event/trace_event_impl.h"
+
+#if (defined(OS_LINUX) || defined(OS_ANDROID)) && !defined(OS_NACL)
+#define TRACE_CPU_PROFILER_SUPPORTED 1
+#endif
+
+namespace base {
+
+class SingleThreadTaskRunner;
+
+namespace trace_event {
+
+class TracedValue;
+
+// Watches for tracing to be enabled or disabled. While tracing is enabled with
+// the "disabled-by-default-cpu_profiler" category, samples the stacks of the
+// threads running in the process every |kSamplingIntervalMicroseconds| of CPU
+// time, using SIGPROF.
+//
+// The signal handler unwinds the interrupted thread's stack with
+// base::debug::StackTrace into a per-thread ring buffer, without locks or
+// allocations. The buffers are periodically drained on |task_runner| into
+// trace events, so samples taken during the last |kFlushIntervalMilliseconds|
+// before tracing stops are lost:
+//   - a "CpuSample" sample event per stack, on the sampled thread, whose "sf"
+//     argument is the id of its innermost stack frame;
+//   - a "StackFrames" instant event per flush with the frames seen for the
+//     first time, as a dictionary from id to {"name", "parent"}. Frames are
+//     interned as a tree, so a stack is identified by its innermost frame.
+//
+// Only one profiler may be sampling at a time in a process, and it must not
+// share SIGPROF with another user (e.g. gperftools' CPU profiler).
+class BASE_EXPORT TraceCpuProfiler : public TraceLog::EnabledStateObserver {
+ public:
+  // CPU time between samples, summed over all the threads of the process.
+  static const int kSamplingIntervalMicroseconds = 10000;
+  // Time between conversions of the samples into trace events.
+  static const int kFlushIntervalMilliseconds = 100;
+  // Threads sampled at once. A thread's buffer is released at the first flush
+  // after it exits, so this only bounds the threads alive between flushes.
+  static const size_t kMaxThreads = 64;
+
+  // |task_runner| must be a task runner for the primary thread for the client
+  // process, e.g. the main thread of a mojo application.
+  explicit TraceCpuProfiler(scoped_refptr<SingleThreadTaskRunner> task_runner);
+  virtual ~TraceCpuProfiler();
+
+  // base::trace_event::TraceLog::EnabledStateChangedObserver overrides:
+  void OnTraceLogEnabled() override;
+  void OnTraceLogDisabled() override;
+
+  // Starts sampling, if no other profiler is.
+  void StartProfiling();
+
+  // Adds the samples taken since the last flush to the trace.
+  void FlushSamples();
+
+  // Stops sampling, dropping the samples not yet flushed.
+  void StopProfiling();
+
+ private:
+  FRIEND_TEST_ALL_PREFIXES(TraceCpuProfilerTest, TraceCpuProfiler);
+
+  // Frames are identified by their address and their caller's id (0 for the
+  // outermost frames).
+  typedef std::map<std::pair<int, const void*>, int> FrameIdMap;
+
+  // Returns the id of the frame at |pc| called from |parent_id|, adding it to
+  // |new_frames| if it's seen for the first time.
+  int InternFrame(int parent_id, const void* pc, TracedValue* new_frames);
+
+  bool IsTimerRunningForTest() const;
+
+  // Ensures the observer starts and stops sampling on the primary thread.
+  scoped_refptr<SingleThreadTaskRunner> task_runner_;
+
+  // Timer to schedule flushes.
+  RepeatingTimer<TraceCpuProfiler> flush_timer_;
+
+  // Interned frames. They are forgotten when sampling stops, since each trace
+  // needs its own "StackFrames" events.
+  FrameIdMap frame_ids_;
+
+  // The process-wide number of dropped samples when sampling started.
+  int32 num_dropped_samples_at_start_;
+
+  WeakPtrFactory<TraceCpuProfiler> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceCpuProfiler);
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_TRACE_EVENT_CPU_PROFILER_H_
@@ -0,0 +1,239 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_event_cpu_profiler.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/json/json_reader.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_impl.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const char kCategory[] = TRACE_DISABLED_BY_DEFAULT("cpu_profiler");
+
+void OnTraceDataCollected(RunLoop* run_loop,
+                          std::string* json,
+                          const scoped_refptr<RefCountedString>& events_str,
+                          bool has_more_events) {
+  if (!json->empty() && !events_str->data().empty())
+    json->append(",");
+  json->append(events_str->data());
+  if (!has_more_events)
+    run_loop->Quit();
+}
+
+// Disables tracing and returns the events, as a list.
+scoped_ptr<ListValue> EndTraceAndFlush() {
+  TraceLog::GetInstance()->SetDisabled();
+  RunLoop run_loop;
+  std::string json;
+  TraceLog::GetInstance()->Flush(
+      Bind(&OnTraceDataCollected, Unretained(&run_loop), Unretained(&json)));
+  run_loop.Run();
+  scoped_ptr<Value> value = JSONReader::Read("[" + json + "]");
+  ListValue* list = nullptr;
+  if (!value || !value->GetAsList(&list))
+    return scoped_ptr<ListValue>();
+  ignore_result(value.release());
+  return make_scoped_ptr(list);
+}
+
+// Uses |num_intervals| sampling intervals of CPU time.
+void BurnCpu(int num_intervals) {
+  TimeTicks end =
+      TimeTicks::Now() +
+      TimeDelta::FromMicroseconds(
+          num_intervals * TraceCpuProfiler::kSamplingIntervalMicroseconds);
+  while (TimeTicks::Now() < end) {
+  }
+}
+
+class BusyThread : public PlatformThread::Delegate {
+ public:
+  BusyThread() {}
+  ~BusyThread() override {}
+
+  void ThreadMain() override { BurnCpu(3); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BusyThread);
+};
+
+}  // namespace
+
+// Exists as a class so it can be a friend of TraceCpuProfiler.
+class TraceCpuProfilerTest : public testing::Test {
+ public:
+  TraceCpuProfilerTest() {}
+  ~TraceCpuProfilerTest() override {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TraceCpuProfilerTest);
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+TEST_F(TraceCpuProfilerTest, TraceCpuProfiler) {
+  MessageLoop message_loop;
+
+  // Start with no observers of the TraceLog.
+  EXPECT_EQ(0u, TraceLog::GetInstance()->GetObserverCountForTest());
+
+  // Creating a profiler adds it to the TraceLog observer list.
+  scoped_ptr<TraceCpuProfiler> profiler(
+      new TraceCpuProfiler(message_loop.task_runner()));
+  EXPECT_EQ(1u, TraceLog::GetInstance()->GetObserverCountForTest());
+  EXPECT_TRUE(TraceLog::GetInstance()->HasEnabledStateObserver(profiler.get()));
+
+  // By default the profiler isn't sampling.
+  EXPECT_FALSE(profiler->IsTimerRunningForTest());
+
+  // Enabling tracing without the category doesn't start it.
+  TraceLog::GetInstance()->SetEnabled(TraceConfig("foo", ""),
+                                      TraceLog::RECORDING_MODE);
+  message_loop.RunUntilIdle();
+  EXPECT_FALSE(profiler->IsTimerRunningForTest());
+  TraceLog::GetInstance()->SetDisabled();
+  message_loop.RunUntilIdle();
+
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+  TraceLog::GetInstance()->SetEnabled(TraceConfig(kCategory, ""),
+                                      TraceLog::RECORDING_MODE);
+  message_loop.RunUntilIdle();
+  EXPECT_TRUE(profiler->IsTimerRunningForTest());
+
+  // Only one profiler samples at a time.
+  {
+    TraceCpuProfiler other_profiler(message_loop.task_runner());
+    other_profiler.StartProfiling();
+    EXPECT_FALSE(other_profiler.IsTimerRunningForTest());
+  }
+
+  TraceLog::GetInstance()->SetDisabled();
+  message_loop.RunUntilIdle();
+  EXPECT_FALSE(profiler->IsTimerRunningForTest());
+#endif  // defined(TRACE_CPU_PROFILER_SUPPORTED)
+
+  // Deleting the profiler removes it from the TraceLog observer list.
+  profiler.reset();
+  EXPECT_EQ(0u, TraceLog::GetInstance()->GetObserverCountForTest());
+}
+
+#if defined(TRACE_CPU_PROFILER_SUPPORTED)
+TEST_F(TraceCpuProfilerTest, Samples) {
+  MessageLoop message_loop;
+  TraceCpuProfiler profiler(message_loop.task_runner());
+  TraceLog::GetInstance()->SetEnabled(TraceConfig(kCategory, ""),
+                                      TraceLog::RECORDING_MODE);
+  message_loop.RunUntilIdle();
+
+  // Use enough CPU time for a few samples.
+  BurnCpu(20);
+  profiler.FlushSamples();
+
+  scoped_ptr<ListValue> events = EndTraceAndFlush();
+  ASSERT_TRUE(events);
+  message_loop.RunUntilIdle();
+
+  DictionaryValue frames;
+  size_t num_samples = 0;
+  std::vector<int> sample_frame_ids;
+  for (size_t i = 0; i < events->GetSize(); i++) {
+    DictionaryValue* event = nullptr;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    std::string name;
+    event->GetString("name", &name);
+    if (name == "StackFrames") {
+      DictionaryValue* new_frames = nullptr;
+      ASSERT_TRUE(event->GetDictionary("args.frames", &new_frames));
+      frames.MergeDictionary(new_frames);
+    } else if (name == "CpuSample") {
+      std::string phase;
+      EXPECT_TRUE(event->GetString("ph", &phase));
+      EXPECT_EQ("P", phase);
+      int frame_id = 0;
+      EXPECT_TRUE(event->GetInteger("args.sf", &frame_id));
+      sample_frame_ids.push_back(frame_id);
+      num_samples++;
+    }
+  }
+  // Sampling is driven by the CPU time actually used, so this is lenient.
+  EXPECT_GT(num_samples, 0u);
+
+  // Every sampled stack is made of interned frames.
+  for (int frame_id : sample_frame_ids) {
+    if (!frame_id)
+      continue;
+    for (int depth = 0; frame_id; depth++) {
+      ASSERT_LT(depth, 100);
+      const DictionaryValue* frame = nullptr;
+      ASSERT_TRUE(frames.GetDictionaryWithoutPathExpansion(
+          IntToString(frame_id), &frame));
+      std::string frame_name;
+      EXPECT_TRUE(frame->GetString("name", &frame_name));
+      EXPECT_FALSE(frame_name.empty());
+      frame_id = 0;
+      frame->GetInteger("parent", &frame_id);
+    }
+  }
+}
+
+// The buffers of exited threads are reused, so more threads than
+// |kMaxThreads| can be sampled in a trace.
+TEST_F(TraceCpuProfilerTest, ShortLivedThreads) {
+  MessageLoop message_loop;
+  TraceCpuProfiler profiler(message_loop.task_runner());
+  TraceLog::GetInstance()->SetEnabled(TraceConfig(kCategory, ""),
+                                      TraceLog::RECORDING_MODE);
+  message_loop.RunUntilIdle();
+
+  const size_t kNumThreads = TraceCpuProfiler::kMaxThreads + 16;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    BusyThread busy_thread;
+    PlatformThreadHandle handle;
+    ASSERT_TRUE(PlatformThread::Create(0, &busy_thread, &handle));
+    PlatformThread::Join(handle);
+    profiler.FlushSamples();
+  }
+
+  scoped_ptr<ListValue> events = EndTraceAndFlush();
+  ASSERT_TRUE(events);
+  message_loop.RunUntilIdle();
+
+  std::set<int> sampled_threads;
+  for (size_t i = 0; i < events->GetSize(); i++) {
+    DictionaryValue* event = nullptr;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    std::string name;
+    event->GetString("name", &name);
+    EXPECT_NE("DroppedCpuSamples", name);
+    int thread_id = 0;
+    if (name == "CpuSample" && event->GetInteger("tid", &thread_id))
+      sampled_threads.insert(thread_id);
+  }
+  // Most threads are sampled; none would be past the first |kMaxThreads| if
+  // their buffers weren't released.
+  EXPECT_GT(sampled_threads.size(), TraceCpuProfiler::kMaxThreads);
+}
+
+#endif  // defined(TRACE_CPU_PROFILER_SUPPORTED)
+
+}  // namespace trace_event
+}  // namespace base
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cmath>
 
+#include "base/barrier_closure.h"
 #include "base/base_switches.h"
 #include "base/bind.h"
 #include "base/command_line.h"
@@ -31,9 +32,11 @@
 #include "base/thread_task_runner_handle.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread_id_name_manager.h"
+#include "base/threading/thread_local_storage.h"
 #include "base/threading/worker_pool.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_binary.h"
 #include "base/trace_event/trace_event_synthetic_delay.h"
 
 #if defined(OS_WIN)
@@ -114,6 +117,11 @@ base::subtle::AtomicWord g_category_index = g_num_builtin_categories;
 LazyInstance<ThreadLocalPointer<const char> >::Leaky
     g_current_thread_name = LAZY_INSTANCE_INITIALIZER;
 
+// Holds the thread local event buffer of a thread without a message loop, so
+// that the buffer is flushed and deleted when the thread exits.
+ThreadLocalStorage::StaticSlot g_thread_local_event_buffer_at_exit =
+    TLS_INITIALIZER;
+
 ThreadTicks ThreadNow() {
   return ThreadTicks::IsSupported() ? ThreadTicks::Now() : ThreadTicks();
 }
@@ -775,6 +783,105 @@ void TraceEvent::AppendAsJSON(
   *out += "}";
 }
 
+void TraceEvent::AppendAsBinary(
+    TraceEventBinaryWriter* writer,
+    const ArgumentFilterPredicate& argument_filter_predicate) const {
+  const char* category_group_name =
+      TraceLog::GetCategoryGroupName(category_group_enabled_);
+  // Copied names only live as long as the event.
+  bool names_are_static = !(flags_ & TRACE_EVENT_FLAG_COPY);
+
+  // Strings are defined before the event that uses them.
+  uint32 category_id = writer->InternString(category_group_name, true);
+  uint32 name_id = writer->InternString(name_, names_are_static);
+  int num_args = 0;
+  uint8 fields = 0;
+  if (arg_names_[0]) {
+    if (argument_filter_predicate.is_null() ||
+        argument_filter_predicate.Run(category_group_name, name_)) {
+      while (num_args < kTraceMaxNumArgs && arg_names_[num_args])
+        ++num_args;
+    } else {
+      fields |= kTraceEventBinaryArgsStripped;
+    }
+  }
+  uint32 arg_name_ids[kTraceMaxNumArgs];
+  for (int i = 0; i < num_args; ++i)
+    arg_name_ids[i] = writer->InternString(arg_names_[i], names_are_static);
+
+  int64 duration = -1;
+  int64 thread_duration = -1;
+  if (phase_ == TRACE_EVENT_PHASE_COMPLETE) {
+    duration = duration_.ToInternalValue();
+    if (duration != -1)
+      fields |= kTraceEventBinaryHasDuration;
+    if (!thread_timestamp_.is_null()) {
+      thread_duration = thread_duration_.ToInternalValue();
+      if (thread_duration != -1)
+        fields |= kTraceEventBinaryHasThreadDuration;
+    }
+  }
+  if (!thread_timestamp_.is_null())
+    fields |= kTraceEventBinaryHasThreadTimestamp;
+
+  writer->BeginEvent();
+  writer->WriteSignedVarint(thread_id_);
+  writer->WriteSignedVarint(timestamp_.ToInternalValue());
+  writer->WriteU8(phase_);
+  writer->WriteU8(flags_);
+  writer->WriteU8(fields);
+  writer->WriteVarint(category_id);
+  writer->WriteVarint(name_id);
+  writer->WriteU8(num_args);
+  for (int i = 0; i < num_args; ++i) {
+    writer->WriteVarint(arg_name_ids[i]);
+    writer->WriteU8(arg_types_[i]);
+    const TraceValue& value = arg_values_[i];
+    switch (arg_types_[i]) {
+      case TRACE_VALUE_TYPE_BOOL:
+        writer->WriteU8(value.as_bool);
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        writer->WriteVarint(value.as_uint);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        writer->WriteSignedVarint(value.as_int);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE:
+        writer->WriteDouble(value.as_double);
+        break;
+      case TRACE_VALUE_TYPE_POINTER:
+        writer->WriteVarint(static_cast<uint64>(
+            reinterpret_cast<intptr_t>(value.as_pointer)));
+        break;
+      case TRACE_VALUE_TYPE_STRING:
+      case TRACE_VALUE_TYPE_COPY_STRING: {
+        const char* str = value.as_string ? value.as_string : "NULL";
+        writer->WriteString(str, strlen(str));
+        break;
+      }
+      case TRACE_VALUE_TYPE_CONVERTABLE: {
+        std::string json;
+        convertable_values_[i]->AppendAsTraceFormat(&json);
+        writer->WriteString(json.data(), json.size());
+        break;
+      }
+      default:
+        NOTREACHED() << "Don't know how to serialize this value";
+        break;
+    }
+  }
+
+  if (fields & kTraceEventBinaryHasDuration)
+    writer->WriteSignedVarint(duration);
+  if (fields & kTraceEventBinaryHasThreadDuration)
+    writer->WriteSignedVarint(thread_duration);
+  if (fields & kTraceEventBinaryHasThreadTimestamp)
+    writer->WriteSignedVarint(thread_timestamp_.ToInternalValue());
+  if (flags_ & TRACE_EVENT_FLAG_HAS_ID)
+    writer->WriteVarint(id_);
+}
+
 void TraceEvent::AppendPrettyPrinted(std::ostringstream* out) const {
   *out << name_ << "[";
   *out << TraceLog::GetCategoryGroupName(category_group_enabled_);
@@ -986,14 +1093,45 @@ TraceBucketData::~TraceBucketData() {
 class TraceLog::ThreadLocalEventBuffer
     : public MessageLoop::DestructionObserver {
  public:
+  // Marks the chunk of |buffer| (which may be NULL) as in use by the current
+  // thread for the scope of the object, see TryReturnChunkWhileLocked().
+  class AutoUse {
+   public:
+    explicit AutoUse(ThreadLocalEventBuffer* buffer) : buffer_(buffer) {
+      if (buffer_)
+        buffer_->BeginUse();
+    }
+    ~AutoUse() {
+      if (buffer_)
+        buffer_->EndUse();
+    }
+
+   private:
+    ThreadLocalEventBuffer* buffer_;
+
+    DISALLOW_COPY_AND_ASSIGN(AutoUse);
+  };
+
   ThreadLocalEventBuffer(TraceLog* trace_log);
   ~ThreadLocalEventBuffer() override;
 
   TraceEvent* AddTraceEvent(TraceEventHandle* handle);
 
+  // Returns the current chunk to the main buffer. The next event will be added
+  // to a new chunk.
+  void ReturnChunk();
+
+  // Called from any thread to return the current chunk of a buffer whose thread
+  // has no message loop to handle the flush. Fails without waiting if the chunk
+  // is in use by its thread, as that thread may be waiting for the lock.
+  bool TryReturnChunkWhileLocked();
+
   void ReportOverhead(const TraceTicks& event_timestamp,
                       const ThreadTicks& event_thread_timestamp);
 
+  // Deletes the buffer of a thread without a message loop when it exits.
+  void WillExitCurrentThread();
+
   TraceEvent* GetEventByHandle(TraceEventHandle handle) {
     if (!chunk_ || handle.chunk_seq != chunk_->seq() ||
         handle.chunk_index != chunk_index_)
@@ -1005,9 +1143,20 @@ class TraceLog::ThreadLocalEventBuffer
   int generation() const { return generation_; }
 
  private:
+  enum ChunkState {
+    CHUNK_IDLE,
+    // The thread owning the buffer is adding or updating an event.
+    CHUNK_IN_USE,
+    // Another thread is returning the chunk to the main buffer.
+    CHUNK_RETURNING
+  };
+
   // MessageLoop::DestructionObserver
   void WillDestroyCurrentMessageLoop() override;
 
+  void BeginUse();
+  void EndUse();
+
   void FlushWhileLocked();
 
   void CheckThisIsCurrentBuffer() const {
@@ -1017,8 +1166,12 @@ class TraceLog::ThreadLocalEventBuffer
   // Since TraceLog is a leaky singleton, trace_log_ will always be valid
   // as long as the thread exists.
   TraceLog* trace_log_;
+  // NULL if the thread has no message loop or blocks it, in which case the
+  // buffer is deleted at thread exit and flushed by the flushing thread.
+  MessageLoop* message_loop_;
   scoped_ptr<TraceBufferChunk> chunk_;
   size_t chunk_index_;
+  subtle::Atomic32 chunk_state_;
   int event_count_;
   TimeDelta overhead_;
   int generation_;
@@ -1028,27 +1181,37 @@ class TraceLog::ThreadLocalEventBuffer
 
 TraceLog::ThreadLocalEventBuffer::ThreadLocalEventBuffer(TraceLog* trace_log)
     : trace_log_(trace_log),
+      message_loop_(trace_log->thread_blocks_message_loop_.Get()
+                        ? NULL
+                        : MessageLoop::current()),
       chunk_index_(0),
+      chunk_state_(CHUNK_IDLE),
       event_count_(0),
       generation_(trace_log->generation()) {
-  // ThreadLocalEventBuffer is created only if the thread has a message loop, so
-  // the following message_loop won't be NULL.
-  MessageLoop* message_loop = MessageLoop::current();
-  message_loop->AddDestructionObserver(this);
+  if (message_loop_)
+    message_loop_->AddDestructionObserver(this);
+  else
+    g_thread_local_event_buffer_at_exit.Set(this);
 
   AutoLock lock(trace_log->lock_);
-  trace_log->thread_message_loops_.insert(message_loop);
+  if (message_loop_)
+    trace_log->thread_message_loops_.insert(message_loop_);
+  else
+    trace_log->event_buffers_without_message_loop_.insert(this);
 }
 
 TraceLog::ThreadLocalEventBuffer::~ThreadLocalEventBuffer() {
   CheckThisIsCurrentBuffer();
-  MessageLoop::current()->RemoveDestructionObserver(this);
+  if (message_loop_)
+    message_loop_->RemoveDestructionObserver(this);
+  else
+    g_thread_local_event_buffer_at_exit.Set(NULL);
 
   // Zero event_count_ happens in either of the following cases:
   // - no event generated for the thread;
-  // - the thread has no message loop;
   // - trace_event_overhead is disabled.
   if (event_count_) {
+    AutoUse use(this);
     InitializeMetadataEvent(AddTraceEvent(NULL),
                             static_cast<int>(base::PlatformThread::CurrentId()),
                             "overhead", "average_overhead",
@@ -1058,7 +1221,10 @@ TraceLog::ThreadLocalEventBuffer::~ThreadLocalEventBuffer() {
   {
     AutoLock lock(trace_log_->lock_);
     FlushWhileLocked();
-    trace_log_->thread_message_loops_.erase(MessageLoop::current());
+    if (message_loop_)
+      trace_log_->thread_message_loops_.erase(message_loop_);
+    else
+      trace_log_->event_buffers_without_message_loop_.erase(this);
   }
   trace_log_->thread_local_event_buffer_.Set(NULL);
 }
@@ -1067,13 +1233,12 @@ TraceEvent* TraceLog::ThreadLocalEventBuffer::AddTraceEvent(
     TraceEventHandle* handle) {
   CheckThisIsCurrentBuffer();
 
-  if (chunk_ && chunk_->IsFull()) {
+  if (!chunk_ || chunk_->IsFull()) {
+    // Exchange the full chunk for a new one in a single critical section. This
+    // is the only time the lock is taken, once per kTraceBufferChunkSize
+    // events.
     AutoLock lock(trace_log_->lock_);
     FlushWhileLocked();
-    chunk_.reset();
-  }
-  if (!chunk_) {
-    AutoLock lock(trace_log_->lock_);
     chunk_ = trace_log_->logged_events_->GetChunk(&chunk_index_);
     trace_log_->CheckIfBufferIsFullWhileLocked();
   }
@@ -1088,6 +1253,39 @@ TraceEvent* TraceLog::ThreadLocalEventBuffer::AddTraceEvent(
   return trace_event;
 }
 
+void TraceLog::ThreadLocalEventBuffer::ReturnChunk() {
+  CheckThisIsCurrentBuffer();
+
+  AutoLock lock(trace_log_->lock_);
+  FlushWhileLocked();
+}
+
+bool TraceLog::ThreadLocalEventBuffer::TryReturnChunkWhileLocked() {
+  trace_log_->lock_.AssertAcquired();
+  if (subtle::Acquire_CompareAndSwap(&chunk_state_, CHUNK_IDLE,
+                                     CHUNK_RETURNING) != CHUNK_IDLE) {
+    return false;
+  }
+  FlushWhileLocked();
+  subtle::Release_Store(&chunk_state_, CHUNK_IDLE);
+  return true;
+}
+
+void TraceLog::ThreadLocalEventBuffer::BeginUse() {
+  CheckThisIsCurrentBuffer();
+
+  // Another thread only holds the chunk for the time it takes to return it.
+  while (subtle::Acquire_CompareAndSwap(&chunk_state_, CHUNK_IDLE,
+                                        CHUNK_IN_USE) != CHUNK_IDLE) {
+    PlatformThread::YieldCurrentThread();
+  }
+}
+
+void TraceLog::ThreadLocalEventBuffer::EndUse() {
+  DCHECK_EQ(CHUNK_IN_USE, subtle::NoBarrier_Load(&chunk_state_));
+  subtle::Release_Store(&chunk_state_, CHUNK_IDLE);
+}
+
 void TraceLog::ThreadLocalEventBuffer::ReportOverhead(
     const TraceTicks& event_timestamp,
     const ThreadTicks& event_thread_timestamp) {
@@ -1101,6 +1299,7 @@ void TraceLog::ThreadLocalEventBuffer::ReportOverhead(
   TraceTicks now = trace_log_->OffsetNow();
   TimeDelta overhead = now - event_timestamp;
   if (overhead.InMicroseconds() >= kOverheadReportThresholdInMicroseconds) {
+    AutoUse use(this);
     TraceEvent* trace_event = AddTraceEvent(NULL);
     if (trace_event) {
       trace_event->Initialize(
@@ -1119,6 +1318,14 @@ void TraceLog::ThreadLocalEventBuffer::WillDestroyCurrentMessageLoop() {
   delete this;
 }
 
+void TraceLog::ThreadLocalEventBuffer::WillExitCurrentThread() {
+  DCHECK(!message_loop_);
+  // The thread local pointer may have been reset already, as the thread is
+  // tearing down its local storage.
+  trace_log_->thread_local_event_buffer_.Set(this);
+  delete this;
+}
+
 void TraceLog::ThreadLocalEventBuffer::FlushWhileLocked() {
   if (!chunk_)
     return;
@@ -1130,6 +1337,7 @@ void TraceLog::ThreadLocalEventBuffer::FlushWhileLocked() {
   }
   // Otherwise this method may be called from the destructor, or TraceLog will
   // find the generation mismatch and delete this buffer soon.
+  chunk_.reset();
 }
 
 TraceLogStatus::TraceLogStatus() : event_capacity(0), event_count(0) {
@@ -1158,7 +1366,8 @@ TraceLog::TraceLog()
       event_callback_trace_config_(TraceConfig()),
       thread_shared_chunk_index_(0),
       generation_(0),
-      use_worker_thread_(false) {
+      use_worker_thread_(false),
+      flush_as_binary_(false) {
   // Trace is enabled or disabled on one thread while other threads are
   // accessing the enabled flag. We don't care whether edge-case events are
   // traced or not, so we allow races on the enabled flag to keep the trace
@@ -1194,12 +1403,22 @@ TraceLog::TraceLog()
   }
 #endif
 
+  if (!g_thread_local_event_buffer_at_exit.initialized())
+    g_thread_local_event_buffer_at_exit.Initialize(&TraceLog::OnThreadExit);
+
   logged_events_.reset(CreateTraceBuffer());
 }
 
 TraceLog::~TraceLog() {
 }
 
+// static
+void TraceLog::OnThreadExit(void* thread_local_event_buffer) {
+  // This will flush the thread local buffer.
+  static_cast<ThreadLocalEventBuffer*>(thread_local_event_buffer)
+      ->WillExitCurrentThread();
+}
+
 const unsigned char* TraceLog::GetCategoryGroupEnabled(
     const char* category_group) {
   TraceLog* tracelog = GetInstance();
@@ -1625,9 +1844,23 @@ void TraceLog::SetEventCallbackDisabled() {
 //    - The message loop will be removed from thread_message_loops_;
 //    If this is the last message loop, finish the flush;
 // 4. If any thread hasn't finish its flush in time, finish the flush.
+// The chunks of the threads without a message loop are returned to the main
+// buffer by the thread finishing the flush.
 void TraceLog::Flush(const TraceLog::OutputCallback& cb,
                      bool use_worker_thread) {
+  FlushInternal(cb, use_worker_thread, false);
+}
+
+void TraceLog::FlushAsBinary(const TraceLog::OutputCallback& cb,
+                             bool use_worker_thread) {
+  FlushInternal(cb, use_worker_thread, true);
+}
+
+void TraceLog::FlushInternal(const TraceLog::OutputCallback& cb,
+                             bool use_worker_thread,
+                             bool binary) {
   use_worker_thread_ = use_worker_thread;
+  flush_as_binary_ = binary;
   if (IsEnabled()) {
     // Can't flush when tracing is enabled because otherwise PostTask would
     // - generate more trace events;
@@ -1687,10 +1920,46 @@ void TraceLog::Flush(const TraceLog::OutputCallback& cb,
 void TraceLog::ConvertTraceEventsToTraceFormat(
     scoped_ptr<TraceBuffer> logged_events,
     const OutputCallback& flush_output_callback,
-    const TraceEvent::ArgumentFilterPredicate& argument_filter_predicate) {
+    const TraceEvent::ArgumentFilterPredicate& argument_filter_predicate,
+    bool binary,
+    TraceTicks since) {
   if (flush_output_callback.is_null())
     return;
 
+  if (binary) {
+    int process_id = TraceLog::GetInstance()->process_id();
+    bool has_more_events = true;
+    do {
+      scoped_refptr<RefCountedString> binary_events_str_ptr =
+          new RefCountedString();
+      bool has_events = false;
+      {
+        TraceEventBinaryWriter writer(process_id,
+                                      &binary_events_str_ptr->data());
+        while (writer.size() < kTraceEventBufferSizeInBytes) {
+          const TraceBufferChunk* chunk = logged_events->NextChunk();
+          has_more_events = chunk != NULL;
+          if (!chunk)
+            break;
+          for (size_t j = 0; j < chunk->size(); ++j) {
+            const TraceEvent* event = chunk->GetEventAt(j);
+            if (event->timestamp() < since &&
+                event->phase() != TRACE_EVENT_PHASE_METADATA) {
+              continue;
+            }
+            event->AppendAsBinary(&writer, argument_filter_predicate);
+            has_events = true;
+          }
+        }
+      }
+      // Like JSON chunks, chunks without events are empty.
+      if (!has_events)
+        binary_events_str_ptr->data().clear();
+      flush_output_callback.Run(binary_events_str_ptr, has_more_events);
+    } while (has_more_events);
+    return;
+  }
+
   // The callback need to be called at least once even if there is no events
   // to let the caller know the completion of flush.
   bool has_more_events = true;
@@ -1704,10 +1973,15 @@ void TraceLog::ConvertTraceEventsToTraceFormat(
       if (!chunk)
         break;
       for (size_t j = 0; j < chunk->size(); ++j) {
+        const TraceEvent* event = chunk->GetEventAt(j);
+        if (event->timestamp() < since &&
+            event->phase() != TRACE_EVENT_PHASE_METADATA) {
+          continue;
+        }
         if (json_events_str_ptr->size())
           json_events_str_ptr->data().append(",\n");
-        chunk->GetEventAt(j)->AppendAsJSON(&(json_events_str_ptr->data()),
-                                           argument_filter_predicate);
+        event->AppendAsJSON(&(json_events_str_ptr->data()),
+                            argument_filter_predicate);
       }
     }
     flush_output_callback.Run(json_events_str_ptr, has_more_events);
@@ -1722,6 +1996,8 @@ void TraceLog::FinishFlush(int generation) {
   if (!CheckGeneration(generation))
     return;
 
+  ReturnChunksOfThreadsWithoutMessageLoop();
+
   {
     AutoLock lock(lock_);
 
@@ -1743,14 +2019,15 @@ void TraceLog::FinishFlush(int generation) {
       WorkerPool::PostTask(
           FROM_HERE, Bind(&TraceLog::ConvertTraceEventsToTraceFormat,
                           Passed(&previous_logged_events),
-                          flush_output_callback, argument_filter_predicate),
+                          flush_output_callback, argument_filter_predicate,
+                          flush_as_binary_, TraceTicks()),
           true)) {
     return;
   }
 
-  ConvertTraceEventsToTraceFormat(previous_logged_events.Pass(),
-                                  flush_output_callback,
-                                  argument_filter_predicate);
+  ConvertTraceEventsToTraceFormat(
+      previous_logged_events.Pass(), flush_output_callback,
+      argument_filter_predicate, flush_as_binary_, TraceTicks());
 }
 
 // Run in each thread holding a local event buffer.
@@ -1775,6 +2052,35 @@ void TraceLog::FlushCurrentThread(int generation) {
       FROM_HERE, Bind(&TraceLog::FinishFlush, Unretained(this), generation));
 }
 
+void TraceLog::ReturnChunksOfThreadsWithoutMessageLoop() {
+  // A thread may be adding an event (tracing may still be enabled, or the
+  // thread may have checked the category before tracing was disabled), and
+  // possibly waiting for the lock to get a new chunk, so release the lock
+  // between attempts.
+  TimeTicks deadline =
+      TimeTicks::Now() + TimeDelta::FromMilliseconds(kThreadFlushTimeoutMs);
+  while (true) {
+    {
+      AutoLock lock(lock_);
+      bool all_returned = true;
+      for (hash_set<ThreadLocalEventBuffer*>::const_iterator it =
+               event_buffers_without_message_loop_.begin();
+           it != event_buffers_without_message_loop_.end(); ++it) {
+        if (!(*it)->TryReturnChunkWhileLocked())
+          all_returned = false;
+      }
+      if (all_returned)
+        return;
+    }
+    if (TimeTicks::Now() > deadline) {
+      LOG(WARNING) << "Some threads without a message loop haven't returned "
+                      "their trace events in time.";
+      return;
+    }
+    PlatformThread::YieldCurrentThread();
+  }
+}
+
 void TraceLog::OnFlushTimeout(int generation) {
   {
     AutoLock lock(lock_);
@@ -1799,8 +2105,72 @@ void TraceLog::OnFlushTimeout(int generation) {
 
 void TraceLog::FlushButLeaveBufferIntact(
     const TraceLog::OutputCallback& flush_output_callback) {
+  FlushButLeaveBufferIntactInternal(flush_output_callback, false, TraceTicks());
+}
+
+// Snapshots work like Flush(), except that the threads holding a local event
+// buffer only return their current chunk to the main buffer, and that the
+// events are then copied rather than taken out of it.
+void TraceLog::SnapshotAsBinary(TimeDelta max_age,
+                                const TraceLog::OutputCallback& cb) {
+  TraceTicks since;
+  if (!max_age.is_zero())
+    since = OffsetNow() - max_age;
+
+  std::vector<scoped_refptr<SingleThreadTaskRunner>>
+      thread_message_loop_task_runners;
+  {
+    AutoLock lock(lock_);
+    for (hash_set<MessageLoop*>::const_iterator it =
+             thread_message_loops_.begin();
+         it != thread_message_loops_.end(); ++it) {
+      thread_message_loop_task_runners.push_back((*it)->task_runner());
+    }
+  }
+
+  // Finishes once, when all the threads have returned their chunk or on
+  // timeout, whichever comes first (the copies of the callback share |done|).
+  scoped_refptr<SingleThreadTaskRunner> task_runner =
+      ThreadTaskRunnerHandle::Get();
+  Closure finish = Bind(&TraceLog::FinishSnapshot, Unretained(this), since, cb,
+                        Owned(new bool(false)));
+  Closure all_chunks_returned = BarrierClosure(
+      thread_message_loop_task_runners.size(),
+      Bind(IgnoreResult(&SingleThreadTaskRunner::PostTask), task_runner,
+           FROM_HERE, finish));
+  for (size_t i = 0; i < thread_message_loop_task_runners.size(); ++i) {
+    thread_message_loop_task_runners[i]->PostTask(
+        FROM_HERE, Bind(&TraceLog::ReturnThreadLocalChunk, Unretained(this),
+                        all_chunks_returned));
+  }
+  task_runner->PostDelayedTask(
+      FROM_HERE, finish, TimeDelta::FromMilliseconds(kThreadFlushTimeoutMs));
+}
+
+void TraceLog::ReturnThreadLocalChunk(const Closure& done_callback) {
+  ThreadLocalEventBuffer* thread_local_event_buffer =
+      thread_local_event_buffer_.Get();
+  if (thread_local_event_buffer)
+    thread_local_event_buffer->ReturnChunk();
+  done_callback.Run();
+}
+
+void TraceLog::FinishSnapshot(TraceTicks since,
+                              const OutputCallback& cb,
+                              bool* done) {
+  if (*done)
+    return;
+  *done = true;
+  FlushButLeaveBufferIntactInternal(cb, true, since);
+}
+
+void TraceLog::FlushButLeaveBufferIntactInternal(
+    const TraceLog::OutputCallback& flush_output_callback,
+    bool binary,
+    TraceTicks since) {
   scoped_ptr<TraceBuffer> previous_logged_events;
   TraceEvent::ArgumentFilterPredicate argument_filter_predicate;
+  ReturnChunksOfThreadsWithoutMessageLoop();
   {
     AutoLock lock(lock_);
     AddMetadataEventsWhileLocked();
@@ -1819,7 +2189,7 @@ void TraceLog::FlushButLeaveBufferIntact(
 
   ConvertTraceEventsToTraceFormat(previous_logged_events.Pass(),
                                   flush_output_callback,
-                                  argument_filter_predicate);
+                                  argument_filter_predicate, binary, since);
 }
 
 void TraceLog::UseNextTraceBuffer() {
@@ -1885,23 +2255,20 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
       OffsetNow() : offset_event_timestamp;
   ThreadTicks thread_now = ThreadNow();
 
-  ThreadLocalEventBuffer* thread_local_event_buffer = NULL;
-  // A ThreadLocalEventBuffer needs the message loop
-  // - to know when the thread exits;
-  // - to handle the final flush.
-  // For a thread without a message loop or the message loop may be blocked, the
-  // trace events will be added into the main buffer directly.
-  if (!thread_blocks_message_loop_.Get() && MessageLoop::current()) {
-    thread_local_event_buffer = thread_local_event_buffer_.Get();
-    if (thread_local_event_buffer &&
-        !CheckGeneration(thread_local_event_buffer->generation())) {
-      delete thread_local_event_buffer;
-      thread_local_event_buffer = NULL;
-    }
-    if (!thread_local_event_buffer) {
-      thread_local_event_buffer = new ThreadLocalEventBuffer(this);
-      thread_local_event_buffer_.Set(thread_local_event_buffer);
-    }
+  // Every thread adds its events into a ThreadLocalEventBuffer, so that the
+  // lock is only taken once per chunk. The buffer of a thread with a message
+  // loop is flushed on that thread, others are flushed by the flushing thread
+  // (see ReturnChunksOfThreadsWithoutMessageLoop()).
+  ThreadLocalEventBuffer* thread_local_event_buffer =
+      thread_local_event_buffer_.Get();
+  if (thread_local_event_buffer &&
+      !CheckGeneration(thread_local_event_buffer->generation())) {
+    delete thread_local_event_buffer;
+    thread_local_event_buffer = NULL;
+  }
+  if (!thread_local_event_buffer) {
+    thread_local_event_buffer = new ThreadLocalEventBuffer(this);
+    thread_local_event_buffer_.Set(thread_local_event_buffer);
   }
 
   // Check and update the current thread name only if the event is for the
@@ -1953,16 +2320,10 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
   std::string console_message;
   if (*category_group_enabled &
       (ENABLED_FOR_RECORDING | ENABLED_FOR_MONITORING)) {
-    OptionalAutoLock lock(&lock_);
-
-    TraceEvent* trace_event = NULL;
-    if (thread_local_event_buffer) {
-      trace_event = thread_local_event_buffer->AddTraceEvent(&handle);
-    } else {
-      lock.EnsureAcquired();
-      trace_event = AddEventToThreadSharedChunkWhileLocked(&handle, true);
-    }
+    ThreadLocalEventBuffer::AutoUse use(thread_local_event_buffer);
 
+    TraceEvent* trace_event =
+        thread_local_event_buffer->AddTraceEvent(&handle);
     if (trace_event) {
       trace_event->Initialize(thread_id, offset_event_timestamp, thread_now,
                               phase, category_group_enabled, name, id,
@@ -2012,8 +2373,7 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
     }
   }
 
-  if (thread_local_event_buffer)
-    thread_local_event_buffer->ReportOverhead(now, thread_now);
+  thread_local_event_buffer->ReportOverhead(now, thread_now);
 
   return handle;
 }
@@ -2107,6 +2467,7 @@ void TraceLog::UpdateTraceEventDuration(
   std::string console_message;
   if (*category_group_enabled & ENABLED_FOR_RECORDING) {
     OptionalAutoLock lock(&lock_);
+    ThreadLocalEventBuffer::AutoUse use(thread_local_event_buffer_.Get());
 
     TraceEvent* trace_event = GetEventByHandleInternal(handle, &lock);
     if (trace_event) {
@@ -2329,7 +2690,8 @@ size_t TraceLog::GetObserverCountForTest() const {
 void TraceLog::SetCurrentThreadBlocksMessageLoop() {
   thread_blocks_message_loop_.Set(true);
   if (thread_local_event_buffer_.Get()) {
-    // This will flush the thread local buffer.
+    // This will flush the thread local buffer. The next event will create a
+    // buffer which doesn't rely on the message loop.
     delete thread_local_event_buffer_.Get();
   }
 }
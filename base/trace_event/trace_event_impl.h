@@ -54,6 +54,8 @@ class MessageLoop;
 
 namespace trace_event {
 
+class TraceEventBinaryWriter;
+
 // For any argument of type TRACE_VALUE_TYPE_CONVERTABLE the provided
 // class must implement this interface.
 class BASE_EXPORT ConvertableToTraceFormat
@@ -129,6 +131,10 @@ class BASE_EXPORT TraceEvent {
   void AppendAsJSON(
       std::string* out,
       const ArgumentFilterPredicate& argument_filter_predicate) const;
+  // Serialize event data to the binary format of trace_event_binary.h.
+  void AppendAsBinary(
+      TraceEventBinaryWriter* writer,
+      const ArgumentFilterPredicate& argument_filter_predicate) const;
   void AppendPrettyPrinted(std::ostringstream* out) const;
 
   static void AppendValueAsJSON(unsigned char type,
@@ -406,6 +412,17 @@ class BASE_EXPORT TraceLog {
                               bool has_more_events)> OutputCallback;
   void Flush(const OutputCallback& cb, bool use_worker_thread = false);
   void FlushButLeaveBufferIntact(const OutputCallback& flush_output_callback);
+  // Like Flush(), but the chunks are in the binary format of
+  // trace_event_binary.h, which is much cheaper to produce. Use
+  // AppendBinaryTraceEventsAsJSON() to convert them to JSON.
+  void FlushAsBinary(const OutputCallback& cb, bool use_worker_thread = false);
+  // Like FlushButLeaveBufferIntact(), but only with the events of the last
+  // |max_age| (all of them if it is zero), in the binary format, and including
+  // the events that threads with a message loop haven't added to the main
+  // buffer yet (so that the most recent events aren't missing). For flight
+  // recording, i.e. while tracing with RECORD_CONTINUOUSLY. |cb| is run
+  // asynchronously on the current thread, which must have a message loop.
+  void SnapshotAsBinary(TimeDelta max_age, const OutputCallback& cb);
 
   // Called by TRACE_EVENT* macros, don't call this directly.
   // The name parameter is a category group for example:
@@ -574,14 +591,30 @@ class BASE_EXPORT TraceLog {
 
   // |generation| is used in the following callbacks to check if the callback
   // is called for the flush of the current |logged_events_|.
+  void FlushInternal(const OutputCallback& cb,
+                     bool use_worker_thread,
+                     bool binary);
   void FlushCurrentThread(int generation);
+  // Runs in each thread holding a local event buffer during SnapshotAsBinary().
+  void ReturnThreadLocalChunk(const Closure& done_callback);
+  void FinishSnapshot(TraceTicks since, const OutputCallback& cb, bool* done);
+  void FlushButLeaveBufferIntactInternal(const OutputCallback& cb,
+                                         bool binary,
+                                         TraceTicks since);
   // Usually it runs on a different thread.
   static void ConvertTraceEventsToTraceFormat(
       scoped_ptr<TraceBuffer> logged_events,
       const TraceLog::OutputCallback& flush_output_callback,
-      const TraceEvent::ArgumentFilterPredicate& argument_filter_predicate);
+      const TraceEvent::ArgumentFilterPredicate& argument_filter_predicate,
+      bool binary,
+      TraceTicks since);
   void FinishFlush(int generation);
   void OnFlushTimeout(int generation);
+  // Returns the current chunk of the threads without a message loop to the
+  // main buffer.
+  void ReturnChunksOfThreadsWithoutMessageLoop();
+  // Deletes the local event buffer of a thread without a message loop.
+  static void OnThreadExit(void* thread_local_event_buffer);
 
   int generation() const {
     return static_cast<int>(subtle::NoBarrier_Load(&generation_));
@@ -663,8 +696,12 @@ class BASE_EXPORT TraceLog {
   // because we need to know the life time of the message loops.
   hash_set<MessageLoop*> thread_message_loops_;
 
-  // For events which can't be added into the thread local buffer, e.g. events
-  // from threads without a message loop.
+  // Contains the local event buffers of the threads which have no message loop
+  // or block it. Their chunks are returned by the flushing thread.
+  hash_set<ThreadLocalEventBuffer*> event_buffers_without_message_loop_;
+
+  // For events which can't be added into the thread local buffer, e.g. the
+  // metadata events.
   scoped_ptr<TraceBufferChunk> thread_shared_chunk_;
   size_t thread_shared_chunk_index_;
 
@@ -674,6 +711,7 @@ class BASE_EXPORT TraceLog {
   TraceEvent::ArgumentFilterPredicate argument_filter_predicate_;
   subtle::AtomicWord generation_;
   bool use_worker_thread_;
+  bool flush_as_binary_;
 
   DISALLOW_COPY_AND_ASSIGN(TraceLog);
 };
@@ -0,0 +1,191 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/bind.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_binary.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+// Fits in the default (record until full) trace buffer.
+const int kNumEvents = 100000;
+
+void OnChunk(std::vector<std::string>* chunks,
+             const scoped_refptr<RefCountedString>& chunk,
+             bool has_more_events) {
+  if (!chunk->data().empty())
+    chunks->push_back(chunk->data());
+}
+
+// Adds its share of the events once all the threads are started.
+class AddEventsDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  AddEventsDelegate(WaitableEvent* start, int num_events)
+      : start_(start), num_events_(num_events) {}
+
+  void Run() override {
+    start_->Wait();
+    for (int i = 0; i < num_events_; ++i) {
+      TRACE_EVENT0("perf", "scoped");
+    }
+  }
+
+ private:
+  WaitableEvent* start_;
+  int num_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddEventsDelegate);
+};
+
+// Measures the cost per event of tracing: on the hot path, when the event is
+// added, and then when it is flushed out of the traced process (as JSON, or in
+// the binary format which the collector converts to JSON).
+class TraceEventPerfTest : public testing::Test {
+ public:
+  void SetUp() override { TraceLog::DeleteForTesting(); }
+  void TearDown() override { TraceLog::DeleteForTesting(); }
+
+  void BeginTrace() {
+    TraceLog::GetInstance()->SetEnabled(
+        TraceConfig("*", RECORD_UNTIL_FULL), TraceLog::RECORDING_MODE);
+  }
+
+  void AddEvents() {
+    for (int i = 0; i < kNumEvents; ++i) {
+      TRACE_EVENT_INSTANT2("perf", "event", TRACE_EVENT_SCOPE_THREAD, "i", i,
+                           "name", "value");
+    }
+  }
+
+  // Flushes, and returns the number of bytes flushed.
+  size_t EndTraceAndFlush(bool binary, std::vector<std::string>* chunks) {
+    const char* format = binary ? "binary" : "json";
+    TraceLog::GetInstance()->SetDisabled();
+    TimeTicks start = TimeTicks::Now();
+    if (binary)
+      TraceLog::GetInstance()->FlushAsBinary(Bind(&OnChunk, chunks));
+    else
+      TraceLog::GetInstance()->Flush(Bind(&OnChunk, chunks));
+    PrintPerEvent("flush", format, TimeTicks::Now() - start);
+
+    size_t num_bytes = 0;
+    for (const std::string& chunk : *chunks)
+      num_bytes += chunk.size();
+    perf_test::PrintResult("flush_size", "", format,
+                           num_bytes / static_cast<double>(kNumEvents),
+                           "bytes/event", true);
+    return num_bytes;
+  }
+
+  void PrintPerEvent(const std::string& measurement,
+                     const std::string& trace,
+                     TimeDelta elapsed) {
+    perf_test::PrintResult(
+        measurement, "", trace,
+        elapsed.InMicroseconds() * 1000 / static_cast<double>(kNumEvents),
+        "ns/event", true);
+  }
+
+ private:
+  // Tears the TraceLog singleton down after each test.
+  ShadowingAtExitManager at_exit_manager_;
+};
+
+TEST_F(TraceEventPerfTest, AddTraceEvent) {
+  BeginTrace();
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kNumEvents; ++i)
+    TRACE_EVENT_INSTANT0("perf", "event", TRACE_EVENT_SCOPE_THREAD);
+  PrintPerEvent("add_trace_event", "instant", TimeTicks::Now() - start);
+  TraceLog::GetInstance()->SetDisabled();
+
+  TraceLog::DeleteForTesting();
+  BeginTrace();
+  start = TimeTicks::Now();
+  AddEvents();
+  PrintPerEvent("add_trace_event", "instant_2_args", TimeTicks::Now() - start);
+  TraceLog::GetInstance()->SetDisabled();
+
+  TraceLog::DeleteForTesting();
+  BeginTrace();
+  start = TimeTicks::Now();
+  // TRACE_EVENT0 expands to several statements.
+  for (int i = 0; i < kNumEvents; ++i) {
+    TRACE_EVENT0("perf", "scoped");
+  }
+  PrintPerEvent("add_trace_event", "scoped", TimeTicks::Now() - start);
+  TraceLog::GetInstance()->SetDisabled();
+}
+
+// The threads have no message loop. Reports the time each thread spends per
+// event, which only stays flat if the threads don't contend for a lock (and
+// there are enough cores).
+TEST_F(TraceEventPerfTest, AddTraceEventFromThreads) {
+  const int kMaxThreads = 32;
+  for (int num_threads = 1; num_threads <= kMaxThreads; num_threads *= 2) {
+    TraceLog::DeleteForTesting();
+    BeginTrace();
+    WaitableEvent start(true, false);
+    AddEventsDelegate delegate(&start, kNumEvents / num_threads);
+    ScopedVector<DelegateSimpleThread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(new DelegateSimpleThread(
+          &delegate, StringPrintf("TraceEventPerfTest%d", i)));
+      threads.back()->Start();
+    }
+
+    TimeTicks start_time = TimeTicks::Now();
+    start.Signal();
+    for (DelegateSimpleThread* thread : threads)
+      thread->Join();
+    PrintPerEvent("add_trace_event_per_thread",
+                  StringPrintf("%d_threads", num_threads),
+                  (TimeTicks::Now() - start_time) * num_threads);
+    TraceLog::GetInstance()->SetDisabled();
+  }
+}
+
+TEST_F(TraceEventPerfTest, FlushAsJSON) {
+  BeginTrace();
+  AddEvents();
+  std::vector<std::string> chunks;
+  EXPECT_LT(0u, EndTraceAndFlush(false, &chunks));
+}
+
+TEST_F(TraceEventPerfTest, FlushAsBinary) {
+  BeginTrace();
+  AddEvents();
+  std::vector<std::string> chunks;
+  EXPECT_LT(0u, EndTraceAndFlush(true, &chunks));
+
+  // What the collector then spends.
+  TimeTicks start = TimeTicks::Now();
+  std::string json;
+  for (const std::string& chunk : chunks) {
+    json.clear();
+    EXPECT_TRUE(
+        AppendBinaryTraceEventsAsJSON(chunk.data(), chunk.size(), &json));
+  }
+  PrintPerEvent("convert_to_json", "binary", TimeTicks::Now() - start);
+}
+
+}  // namespace
+
+}  // namespace trace_event
+}  // namespace base
@@ -12,15 +12,18 @@
 #include "base/location.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/memory/singleton.h"
 #include "base/process/process_handle.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
 #include "base/threading/thread.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_binary.h"
 #include "base/trace_event/trace_event_synthetic_delay.h"
 #include "base/values.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -124,6 +127,41 @@ class TraceEventTestFixture : public testing::Test {
                    base::Unretained(flush_complete_event)));
   }
 
+  // Snapshots from a thread with a message loop, as required.
+  void SnapshotInThreadWithMessageLoop(TimeDelta max_age) {
+    WaitableEvent flush_complete_event(false, false);
+    Thread flush_thread("flush");
+    flush_thread.Start();
+    flush_thread.task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&TraceEventTestFixture::SnapshotAsync,
+                   base::Unretained(this), max_age, &flush_complete_event));
+    flush_complete_event.Wait();
+  }
+
+  void SnapshotAsync(TimeDelta max_age, WaitableEvent* flush_complete_event) {
+    TraceLog::GetInstance()->SnapshotAsBinary(
+        max_age,
+        base::Bind(&TraceEventTestFixture::OnBinaryTraceDataCollected,
+                   base::Unretained(this),
+                   base::Unretained(flush_complete_event)));
+  }
+
+  void OnBinaryTraceDataCollected(
+      WaitableEvent* flush_complete_event,
+      const scoped_refptr<base::RefCountedString>& events_str,
+      bool has_more_events) {
+    scoped_refptr<base::RefCountedString> json_events_str =
+        new base::RefCountedString;
+    if (events_str->size()) {
+      EXPECT_TRUE(AppendBinaryTraceEventsAsJSON(events_str->data().data(),
+                                                events_str->size(),
+                                                &json_events_str->data()));
+    }
+    OnTraceDataCollected(flush_complete_event, json_events_str,
+                         has_more_events);
+  }
+
   void SetUp() override {
     const char* name = PlatformThread::GetName();
     old_thread_name_ = name ? strdup(name) : NULL;
@@ -1440,6 +1478,71 @@ TEST_F(TraceEventTestFixture, DataCapturedManyThreads) {
   }
 }
 
+// Adds events on a thread without a message loop, then optionally blocks until
+// signaled.
+class ManyInstantEventsDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  ManyInstantEventsDelegate(int thread_id,
+                            int num_events,
+                            WaitableEvent* task_complete_event,
+                            WaitableEvent* task_stop_event)
+      : thread_id_(thread_id),
+        num_events_(num_events),
+        task_complete_event_(task_complete_event),
+        task_stop_event_(task_stop_event) {}
+
+  void Run() override {
+    TraceManyInstantEvents(thread_id_, num_events_, task_complete_event_);
+    if (task_stop_event_)
+      task_stop_event_->Wait();
+  }
+
+ private:
+  int thread_id_;
+  int num_events_;
+  WaitableEvent* task_complete_event_;
+  WaitableEvent* task_stop_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(ManyInstantEventsDelegate);
+};
+
+TEST_F(TraceEventTestFixture, DataCapturedManyThreadsWithoutMessageLoop) {
+  BeginTrace();
+
+  const int num_threads = 4;
+  // More than a chunk per thread.
+  const int num_events = 1000;
+  WaitableEvent task_stop_event(true, false);
+  ScopedVector<ManyInstantEventsDelegate> delegates;
+  ScopedVector<DelegateSimpleThread> threads;
+  ScopedVector<WaitableEvent> task_complete_events;
+  for (int i = 0; i < num_threads; i++) {
+    task_complete_events.push_back(new WaitableEvent(false, false));
+    // Half of the threads end before flush, the other half are still running
+    // (but blocked) when flushing.
+    delegates.push_back(new ManyInstantEventsDelegate(
+        i, num_events, task_complete_events[i],
+        i < num_threads / 2 ? NULL : &task_stop_event));
+    threads.push_back(
+        new DelegateSimpleThread(delegates[i], StringPrintf("Thread %d", i)));
+    threads[i]->Start();
+  }
+
+  for (int i = 0; i < num_threads; i++)
+    task_complete_events[i]->Wait();
+  for (int i = 0; i < num_threads / 2; i++)
+    threads[i]->Join();
+
+  EndTraceAndFlush();
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_,
+                                           num_threads, num_events);
+
+  // Let the other half of the threads end after flush.
+  task_stop_event.Signal();
+  for (int i = num_threads / 2; i < num_threads; i++)
+    threads[i]->Join();
+}
+
 // Test that thread and process names show up in the trace
 TEST_F(TraceEventTestFixture, ThreadNames) {
   // Create threads before we enable tracing to make sure
@@ -1863,6 +1966,56 @@ TEST_F(TraceEventTestFixture, TraceContinuousSampling) {
   Clear();
 }
 
+void TraceInstantEvent(const char* name, WaitableEvent* task_complete_event) {
+  TRACE_EVENT_INSTANT0("all", name, TRACE_EVENT_SCOPE_THREAD);
+  task_complete_event->Signal();
+}
+
+// Test that snapshots of a continuous trace include the events that threads
+// haven't added to the main buffer yet, and only the recent ones if asked.
+TEST_F(TraceEventTestFixture, SnapshotAsBinary) {
+  TraceLog::GetInstance()->SetEnabled(TraceConfig("*", RECORD_CONTINUOUSLY),
+                                      TraceLog::RECORDING_MODE);
+  Thread thread("1");
+  WaitableEvent task_complete_event(false, false);
+  thread.Start();
+
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&TraceInstantEvent, "old", &task_complete_event));
+  task_complete_event.Wait();
+  PlatformThread::Sleep(TimeDelta::FromMilliseconds(20));
+  TimeTicks boundary = TimeTicks::Now();
+  PlatformThread::Sleep(TimeDelta::FromMilliseconds(20));
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&TraceInstantEvent, "new", &task_complete_event));
+  task_complete_event.Wait();
+
+  SnapshotInThreadWithMessageLoop(TimeDelta());
+  EXPECT_TRUE(FindNamePhase("old", "I"));
+  EXPECT_TRUE(FindNamePhase("new", "I"));
+  EXPECT_TRUE(TraceLog::GetInstance()->IsEnabled());
+  Clear();
+
+  SnapshotInThreadWithMessageLoop(TimeTicks::Now() - boundary);
+  EXPECT_FALSE(FindNamePhase("old", "I"));
+  EXPECT_TRUE(FindNamePhase("new", "I"));
+  // Metadata isn't filtered out.
+  EXPECT_TRUE(FindNamePhase("thread_name", "M"));
+  Clear();
+
+  // Events added after a snapshot are recorded as usual.
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&TraceInstantEvent, "newer", &task_complete_event));
+  task_complete_event.Wait();
+  SnapshotInThreadWithMessageLoop(TimeDelta());
+  EXPECT_TRUE(FindNamePhase("new", "I"));
+  EXPECT_TRUE(FindNamePhase("newer", "I"));
+  Clear();
+
+  thread.Stop();
+  TraceLog::GetInstance()->SetDisabled();
+}
+
 class MyData : public ConvertableToTraceFormat {
  public:
   MyData() {}
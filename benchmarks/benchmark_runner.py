@@ -6,6 +6,7 @@
 import argparse
 import imp
 import importlib
+import json
 import os
 import sys
 
@@ -26,6 +27,7 @@ class BenchmarkRunner(object):
     else:
       build_directory = os.path.join('out', 'Debug')
     self._paths = Paths(build_dir=build_directory)
+    self._results = {}
 
   def _list_tests(self):
     for name in os.listdir(self._benchmark_dir):
@@ -41,13 +43,22 @@ class BenchmarkRunner(object):
       importlib.import_module(run_module)
       result = sys.modules[run_module].run(self._args, self._paths)
 
-      #TODO(yzshen): (1) consider using more structured result;
-      #              (2) upload the result to server.
-      print result
+      #TODO(yzshen): upload the result to server.
+      # Structured results (measurements by name) are printed one per line, in
+      # order, so that the output of two runs can be diffed.
+      if isinstance(result, dict):
+        for name in sorted(result):
+          print "%s: %s" % (name, result[name])
+      else:
+        print result
+      self._results[test_name] = result
 
   def run(self):
     for test in self._list_tests():
       self._run_test(test)
+    if self._args.output_file:
+      with open(self._args.output_file, 'w') as output_file:
+        json.dump(self._results, output_file, indent=2, sort_keys=True)
 
 
 def main():
@@ -60,6 +71,8 @@ def main():
                            default=True, action='store_true')
   debug_group.add_argument('--debug', help='test against debug build',
                            default=False, dest='release', action='store_false')
+  parser.add_argument('--output-file',
+                      help='also write the results to this file, as JSON')
 
   args = parser.parse_args()
 
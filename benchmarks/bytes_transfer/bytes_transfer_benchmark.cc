@@ -0,0 +1,114 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Sends byte arrays of a given size to mojo:bytes_transfer_server one after
+// the other, and traces how long each takes to be received and acknowledged.
+// Accepts the following arguments:
+//   --size=<bytes>: the size of the arrays (1 MB by default);
+//   --inline: send the arrays in the message rather than in a shared buffer.
+
+#include <string.h>
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/trace_event/trace_event.h"
+#include "benchmarks/bytes_transfer/bytes_transfer.mojom.h"
+#include "mojo/application/application_runner_chromium.h"
+#include "mojo/common/tracing_impl.h"
+#include "mojo/public/c/system/main.h"
+#include "mojo/public/cpp/application/application_delegate.h"
+#include "mojo/public/cpp/application/application_impl.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+namespace benchmarks {
+namespace {
+
+const base::TimeDelta kWarmupTime = base::TimeDelta::FromMilliseconds(1000);
+
+const char kSizeArgument[] = "--size=";
+const char kInlineArgument[] = "--inline";
+
+}  // namespace
+
+class BytesTransferBenchmark : public ApplicationDelegate {
+ public:
+  BytesTransferBenchmark()
+      : size_(1024 * 1024), inline_(false), warmup_(true) {}
+  ~BytesTransferBenchmark() override {}
+
+  // ApplicationDelegate implementation.
+  void Initialize(ApplicationImpl* app) override {
+    tracing_.Initialize(app);
+
+    for (const std::string& argument : app->args()) {
+      if (argument.find(kSizeArgument) == 0) {
+        if (!base::StringToSizeT(argument.substr(strlen(kSizeArgument)),
+                                 &size_)) {
+          LOG(ERROR) << "Invalid argument: " << argument;
+        }
+      } else if (argument == kInlineArgument) {
+        inline_ = true;
+      }
+    }
+
+    data_ = Array<uint8_t>::New(size_);
+    for (size_t i = 0; i < size_; ++i)
+      data_[i] = static_cast<uint8_t>(i);
+
+    app->ConnectToService("mojo:bytes_transfer_server", &sink_);
+    base::MessageLoop::current()->PostDelayedTask(
+        FROM_HERE, base::Bind(&BytesTransferBenchmark::EndWarmup,
+                              base::Unretained(this)),
+        kWarmupTime);
+    Send();
+  }
+
+ private:
+  void Send() {
+    bool traced = !warmup_;
+    if (traced)
+      TRACE_EVENT_ASYNC_BEGIN0("bytes_transfer_benchmark", "transfer", this);
+
+    // Each call gets its own copy of the data, as a real client would.
+    auto callback = [this, traced](uint32_t num_bytes) {
+      OnReceived(traced, num_bytes);
+    };
+    if (inline_)
+      sink_->SendInline(data_.Clone(), callback);
+    else
+      sink_->SendSpillable(data_.Clone(), callback);
+  }
+
+  void OnReceived(bool traced, uint32_t num_bytes) {
+    DCHECK_EQ(size_, num_bytes);
+    if (traced)
+      TRACE_EVENT_ASYNC_END0("bytes_transfer_benchmark", "transfer", this);
+    Send();
+  }
+
+  void EndWarmup() { warmup_ = false; }
+
+  size_t size_;
+  bool inline_;
+  bool warmup_;
+  Array<uint8_t> data_;
+  BytesSinkPtr sink_;
+  TracingImpl tracing_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(BytesTransferBenchmark);
+};
+
+}  // namespace benchmarks
+}  // namespace mojo
+
+MojoResult MojoMain(MojoHandle application_request) {
+  mojo::ApplicationRunnerChromium runner(
+      new mojo::benchmarks::BytesTransferBenchmark);
+  return runner.Run(application_request);
+}
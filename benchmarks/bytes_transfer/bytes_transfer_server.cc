@@ -0,0 +1,72 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+
+#include "benchmarks/bytes_transfer/bytes_transfer.mojom.h"
+#include "mojo/public/c/system/main.h"
+#include "mojo/public/cpp/application/application_connection.h"
+#include "mojo/public/cpp/application/application_delegate.h"
+#include "mojo/public/cpp/application/application_runner.h"
+#include "mojo/public/cpp/application/interface_factory.h"
+#include "mojo/public/cpp/bindings/strong_binding.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+namespace benchmarks {
+
+class BytesSinkImpl : public BytesSink {
+ public:
+  explicit BytesSinkImpl(InterfaceRequest<BytesSink> request)
+      : binding_(this, request.Pass()) {}
+  ~BytesSinkImpl() override {}
+
+  // BytesSink implementation.
+  void SendInline(Array<uint8_t> data,
+                  const SendInlineCallback& callback) override {
+    callback.Run(static_cast<uint32_t>(data.size()));
+  }
+
+  void SendSpillable(Array<uint8_t> data,
+                     const SendSpillableCallback& callback) override {
+    callback.Run(static_cast<uint32_t>(data.size()));
+  }
+
+ private:
+  StrongBinding<BytesSink> binding_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(BytesSinkImpl);
+};
+
+class BytesTransferServer : public ApplicationDelegate,
+                            public InterfaceFactory<BytesSink> {
+ public:
+  BytesTransferServer() {}
+  ~BytesTransferServer() override {}
+
+  // ApplicationDelegate implementation.
+  bool ConfigureIncomingConnection(ApplicationConnection* connection) override {
+    connection->AddService<BytesSink>(this);
+    return true;
+  }
+
+  // InterfaceFactory<BytesSink> implementation.
+  void Create(ApplicationConnection* connection,
+              InterfaceRequest<BytesSink> request) override {
+    new BytesSinkImpl(request.Pass());
+  }
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(BytesTransferServer);
+};
+
+}  // namespace benchmarks
+}  // namespace mojo
+
+MojoResult MojoMain(MojoHandle application_request) {
+  mojo::ApplicationRunner runner(
+      std::unique_ptr<mojo::benchmarks::BytesTransferServer>(
+          new mojo::benchmarks::BytesTransferServer()));
+  return runner.Run(application_request);
+}
@@ -0,0 +1,45 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+
+#include <memory>
+
+#include "mojo/public/c/system/main.h"
+#include "mojo/public/cpp/application/application_delegate.h"
+#include "mojo/public/cpp/application/application_impl.h"
+#include "mojo/public/cpp/application/application_runner.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace {
+
+// One link of a chain of applications, each of which connects to the next one
+// (NEXT_APP_URL) as soon as it is initialized. The last one terminates the
+// process, like mojo_benchmark_startup does, so the overall execution time
+// reflects how long the shell takes to start a graph of applications that
+// depend on each other.
+class ChainApp : public mojo::ApplicationDelegate {
+ public:
+  ChainApp() {}
+  ~ChainApp() override {}
+
+  void Initialize(mojo::ApplicationImpl* app) override {
+#if defined(NEXT_APP_URL)
+    app->ConnectToApplication(NEXT_APP_URL);
+#else
+    exit(0);
+#endif
+  }
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(ChainApp);
+};
+
+}  // namespace
+
+MojoResult MojoMain(MojoHandle application_request) {
+  mojo::ApplicationRunner runner(
+      std::unique_ptr<mojo::ApplicationDelegate>(new ChainApp()));
+  return runner.Run(application_request);
+}
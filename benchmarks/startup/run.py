@@ -2,22 +2,142 @@
 # Use of this source code is governed by a BSD-style license that can be
 # found in the LICENSE file.
 
+import BaseHTTPServer
 import os
+import shutil
+import SimpleHTTPServer
 import subprocess
+import tempfile
+import threading
 import timeit
 
 
+# Shell arguments for each configuration measured, and its description.
+_CONFIGURATIONS = [
+    ([], 'in process'),
+    (['--enable-multiprocess'], 'out of process'),
+    (['--enable-multiprocess', '--child-process-pool-size=1'],
+     'out of process, with a pre-started child process'),
+]
+
+
+# Shell arguments and app URL (where %s is the URL of the build directory
+# served over HTTP) for each configuration whose startup timeline is measured,
+# and its description. Apps served over HTTP are fetched and cached on every
+# start when cold, and loaded straight from the cache when warm.
+_TIMELINE_CONFIGURATIONS = [
+    ([], 'mojo:mojo_benchmark_startup', 'local file'),
+    (['--disable-cache'], '%s/mojo_benchmark_startup.mojo',
+     'cold, over HTTP'),
+    (['--force-offline-by-default'], '%s/mojo_benchmark_startup.mojo',
+     'warm, over HTTP'),
+    (['--enable-multiprocess'], 'mojo:mojo_benchmark_startup',
+     'local file, out of process'),
+]
+
+_TIMELINE_ROUNDS = 100
+
+# Percentiles of the duration of each phase that are reported.
+_PERCENTILES = [50, 90, 99]
+
+
+def _measure_startup_time(paths, shell_args, rounds,
+                          app='mojo:mojo_benchmark_startup'):
+  command = [paths.mojo_shell_path] + shell_args + [app]
+  return timeit.timeit("subprocess.call(%r)" % command,
+                       "import subprocess", number=rounds)
+
+
+class _BuildDirectoryHandler(SimpleHTTPServer.SimpleHTTPRequestHandler):
+  """Serves the files of the build directory (and nothing else)."""
+
+  def translate_path(self, path):
+    name = os.path.basename(path.split('?', 1)[0])
+    return os.path.join(self.server.build_dir, name)
+
+  def log_message(self, *_):
+    pass
+
+
+def _start_http_server(build_dir):
+  server = BaseHTTPServer.HTTPServer(('127.0.0.1', 0), _BuildDirectoryHandler)
+  server.build_dir = build_dir
+  thread = threading.Thread(target=server.serve_forever)
+  thread.daemon = True
+  thread.start()
+  return server
+
+
+def _read_startup_timeline(path):
+  """Returns the phases in the startup timeline written by the shell (see
+  shell/startup_timeline.h) at |path|, as a list of
+  (phase, begin_us, end_us, target) tuples."""
+  phases = []
+  with open(path) as timeline:
+    for line in timeline:
+      fields = line.rstrip('\n').split(' ', 3)
+      if len(fields) < 3:
+        continue
+      target = fields[3] if len(fields) == 4 else ''
+      phases.append((fields[0], int(fields[1]), int(fields[2]), target))
+  return phases
+
+
+def _get_phase_durations(phases, app_name):
+  """Returns the duration in ms of each phase of the shell itself (including
+  launching child processes) and of |app_name|, by phase, and the time from the
+  start of the shell to the MojoMain() of |app_name| as 'Total'. Returns None if
+  |app_name| wasn't started."""
+  shell_start = None
+  durations = {}
+  for phase, begin, end, target in phases:
+    if phase == 'ShellStart':
+      shell_start = begin
+    elif phase == 'MojoMain' and app_name in target:
+      if shell_start is None:
+        return None
+      durations['Total'] = (begin - shell_start) / 1000.0
+    elif (not target or app_name in target or phase == 'LaunchChild') and \
+        end > begin:
+      durations[phase] = durations.get(phase, 0) + (end - begin) / 1000.0
+  if 'Total' not in durations:
+    return None
+  return durations
+
+
+def _percentile(values, percentile):
+  values = sorted(values)
+  index = min(len(values) - 1, len(values) * percentile // 100)
+  return values[index]
+
+
+def _measure_startup_timeline(paths, shell_args, app, rounds):
+  """Starts |app| |rounds| times, and returns the list of percentiles of the
+  duration of each phase of its startup, by phase."""
+  timeline_dir = tempfile.mkdtemp()
+  timeline_path = os.path.join(timeline_dir, 'startup_timeline')
+  command = ([paths.mojo_shell_path, '--startup-timeline=' + timeline_path] +
+             shell_args + [app])
+  app_name = os.path.basename(app).split(':')[-1].split('.')[0]
+  all_durations = {}
+  try:
+    for _ in range(rounds):
+      subprocess.call(command)
+      durations = _get_phase_durations(_read_startup_timeline(timeline_path),
+                                       app_name)
+      if durations is None:
+        continue
+      for phase, duration in durations.iteritems():
+        all_durations.setdefault(phase, []).append(duration)
+  finally:
+    shutil.rmtree(timeline_dir)
+  return dict((phase, [_percentile(durations, p) for p in _PERCENTILES])
+              for phase, durations in all_durations.iteritems())
+
+
 def run(args, paths):
   rounds = 1000
 
-  # Because mojo_benchmark_startup terminates the process immediately when its
-  # MojoMain() is called. The overall execution time reflects the startup
-  # performance of the mojo shell.
-  startup_time = timeit.timeit(
-      ("subprocess.call(['%s', 'mojo:mojo_benchmark_startup'])" %
-           paths.mojo_shell_path),
-      "import subprocess", number=rounds)
-
   # The execution time of a noop executable is also measured, in order to offset
   # the cost of timeit()/subprocess.call()/etc.
   noop_time = timeit.timeit(
@@ -25,11 +145,56 @@ def run(args, paths):
            os.path.join(paths.build_dir, 'mojo_benchmark_startup_noop')),
       "import subprocess", number=rounds)
 
-  # TODO(yzshen): Consider also testing the startup time when
-  # mojo_benchmark_startup is served by an HTTP server.
+  # TODO(yzshen): The average startup time is only measured for local files.
+  # Startup over HTTP is only broken down into phases, by the timelines below.
+
+  results = {}
+  for shell_args, description in _CONFIGURATIONS:
+    # Because mojo_benchmark_startup terminates the process immediately when
+    # its MojoMain() is called. The overall execution time reflects the startup
+    # performance of the mojo shell.
+    startup_time = _measure_startup_time(paths, shell_args, rounds)
+
+    # Convert the execution time to milliseconds and compute the average for
+    # a single run.
+    result = (startup_time - noop_time) * 1000 / rounds
+    results["average startup time (%s) ms" % description] = result
+
+  # Also measure a chain of three apps, each connecting to the next one, with
+  # and without preloading dependencies. The first run with preloading records
+  # the dependencies.
+  manifest_dir = tempfile.mkdtemp()
+  try:
+    preload_args = ['--preload-dependencies=%s' %
+                        os.path.join(manifest_dir, 'preload_manifest.json')]
+    chain_app = 'mojo:mojo_benchmark_startup_chain_1'
+    _measure_startup_time(paths, preload_args, 1, chain_app)
+    for shell_args, description in [([], 'without preloading'),
+                                    (preload_args, 'with preloading')]:
+      startup_time = _measure_startup_time(paths, shell_args, rounds,
+                                           chain_app)
+      result = (startup_time - noop_time) * 1000 / rounds
+      results["average startup time of 3 apps (%s) ms" % description] = result
+  finally:
+    shutil.rmtree(manifest_dir)
+
+  # Finally, measure where the startup time goes: the percentiles of the
+  # duration of each phase of the startup timeline recorded by the shell.
+  server = _start_http_server(paths.build_dir)
+  server_url = 'http://127.0.0.1:%d' % server.server_address[1]
+  try:
+    for shell_args, app, description in _TIMELINE_CONFIGURATIONS:
+      if '%s' in app:
+        app = app % server_url
+        # Make sure that the app is in the cache for warm starts.
+        subprocess.call([paths.mojo_shell_path] + [app])
+      phases = _measure_startup_timeline(paths, shell_args, app,
+                                         _TIMELINE_ROUNDS)
+      for phase, percentiles in phases.iteritems():
+        for percentile, duration in zip(_PERCENTILES, percentiles):
+          results["startup phase %s (%s) p%d ms" %
+                  (phase, description, percentile)] = duration
+  finally:
+    server.shutdown()
 
-  # Convert the execution time to milliseconds and compute the average for
-  # a single run.
-  result = (startup_time - noop_time) * 1000 / rounds
-  return ("Result: rounds tested: %d; average startup time: %f ms" %
-          (rounds, result))
+  return results
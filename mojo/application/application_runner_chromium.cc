@@ -9,10 +9,24 @@
 #include "base/debug/stack_trace.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
+#include "base/metrics/shared_histogram_allocator.h"
 #include "mojo/message_pump/message_pump_mojo.h"
 #include "mojo/public/cpp/application/application_delegate.h"
 #include "mojo/public/cpp/application/application_impl.h"
 
+// Called by the shell's child process, before |MojoMain()|, with the shared
+// memory in which the child records its histograms, so that the application's
+// histograms are recorded there too (they would otherwise stay in this copy of
+// base). The shell reads them from there.
+extern "C" __attribute__((visibility("default"))) void MojoSetHistogramArena(
+    void* memory,
+    size_t num_bytes) {
+  scoped_ptr<base::SharedHistogramAllocator> allocator =
+      base::SharedHistogramAllocator::Attach(memory, num_bytes);
+  if (allocator)
+    base::SharedHistogramAllocator::SetGlobal(allocator.Pass());
+}
+
 namespace mojo {
 
 // static
@@ -0,0 +1,290 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/common/bindings_trace_instrumentation.h"
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/stl_util.h"
+#include "base/strings/string_util.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "base/trace_event/trace_event.h"
+
+namespace mojo {
+namespace {
+
+const char kCategory[] = "mojo_bindings";
+
+// Times are in microseconds, from 1us to 10s.
+base::HistogramBase* GetTimeHistogram(const char* prefix,
+                                      const std::string& name) {
+  return base::Histogram::FactoryGet(
+      std::string(prefix) + name, 1, 10 * 1000 * 1000, 50,
+      base::HistogramBase::kNoFlags);
+}
+
+base::LazyInstance<BindingsTraceInstrumentation>::Leaky g_instrumentation =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+BindingsTraceInstrumentation::MethodStats::MethodStats(const std::string& name)
+    : calls_counter_name(name + ".calls"),
+      bytes_counter_name(name + ".bytes"),
+      handler_time(GetTimeHistogram("Mojo.Bindings.HandlerTime.", name)),
+      queueing_time(GetTimeHistogram("Mojo.Bindings.QueueingTime.", name)),
+      round_trip_time(GetTimeHistogram("Mojo.Bindings.RoundTripTime.", name)) {
+}
+
+BindingsTraceInstrumentation::MethodStats::~MethodStats() {
+}
+
+BindingsTraceInstrumentation::MethodCounts::MethodCounts()
+    : calls_sent(0), bytes_sent(0), calls_dispatched(0), bytes_dispatched(0) {
+}
+
+BindingsTraceInstrumentation::ThreadMethodCounts::ThreadMethodCounts(
+    MethodStats* stats)
+    : stats(stats),
+      calls_sent(0),
+      bytes_sent(0),
+      calls_dispatched(0),
+      bytes_dispatched(0) {
+}
+
+void BindingsTraceInstrumentation::ThreadMethodCounts::AddTo(
+    MethodCounts* counts) const {
+  counts->calls_sent += base::subtle::NoBarrier_Load(&calls_sent);
+  counts->bytes_sent += base::subtle::NoBarrier_Load(&bytes_sent);
+  counts->calls_dispatched += base::subtle::NoBarrier_Load(&calls_dispatched);
+  counts->bytes_dispatched += base::subtle::NoBarrier_Load(&bytes_dispatched);
+}
+
+size_t BindingsTraceInstrumentation::MethodKeyHash::operator()(
+    const MethodKey& key) const {
+  return base::HashInts64(reinterpret_cast<uintptr_t>(key.first),
+                          reinterpret_cast<uintptr_t>(key.second));
+}
+
+BindingsTraceInstrumentation::ThreadCounts::ThreadCounts(
+    BindingsTraceInstrumentation* instrumentation)
+    : instrumentation(instrumentation) {
+}
+
+BindingsTraceInstrumentation::ThreadCounts::~ThreadCounts() {
+}
+
+BindingsTraceInstrumentation::Counter::Counter(
+    BindingsTraceInstrumentation* instrumentation,
+    const char* interface_name)
+    : instrumentation_(instrumentation),
+      interface_name_(interface_name),
+      count_(0),
+      num_bytes_(0) {
+  base::AutoLock locker(instrumentation_->lock_);
+  instrumentation_->pending_responses_counters_.insert(this);
+}
+
+BindingsTraceInstrumentation::Counter::~Counter() {
+  base::AutoLock locker(instrumentation_->lock_);
+  instrumentation_->pending_responses_counters_.erase(this);
+}
+
+void BindingsTraceInstrumentation::Counter::Add(int32_t count_delta,
+                                                int64_t num_bytes_delta) {
+  // Only this thread writes the counts, so they needn't be updated
+  // atomically.
+  base::subtle::NoBarrier_Store(
+      &count_, base::subtle::NoBarrier_Load(&count_) + count_delta);
+  base::subtle::NoBarrier_Store(
+      &num_bytes_,
+      base::subtle::NoBarrier_Load(&num_bytes_) +
+          static_cast<base::subtle::AtomicWord>(num_bytes_delta));
+  DCHECK_GE(base::subtle::NoBarrier_Load(&count_), 0);
+  DCHECK_GE(base::subtle::NoBarrier_Load(&num_bytes_), 0);
+}
+
+void BindingsTraceInstrumentation::Counter::AddTo(
+    PendingResponses* pending) const {
+  pending->count += base::subtle::NoBarrier_Load(&count_);
+  pending->num_bytes += base::subtle::NoBarrier_Load(&num_bytes_);
+}
+
+BindingsTraceInstrumentation::BindingsTraceInstrumentation()
+    : thread_counts_slot_(&BindingsTraceInstrumentation::OnThreadExit) {
+}
+
+BindingsTraceInstrumentation::~BindingsTraceInstrumentation() {
+  // Threads exiting from now on leave their counts alone.
+  thread_counts_slot_.Free();
+  STLDeleteElements(&thread_counts_);
+  STLDeleteValues(&method_stats_);
+}
+
+// static
+void BindingsTraceInstrumentation::Install() {
+  // The instance is leaked, so that it outlives every binding, and so that it
+  // needn't be unregistered from the |MemoryDumpManager|.
+  SetBindingsInstrumentation(g_instrumentation.Pointer());
+  base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+      g_instrumentation.Pointer());
+}
+
+void BindingsTraceInstrumentation::OnMessageSent(const char* interface_name,
+                                                 const char* method_name,
+                                                 bool is_response,
+                                                 uint32_t num_bytes) {
+  // Only this thread writes its counts, so they needn't be incremented
+  // atomically.
+  ThreadMethodCounts* counts =
+      GetThreadMethodCounts(interface_name, method_name);
+  base::subtle::NoBarrier_Store(
+      &counts->calls_sent,
+      base::subtle::NoBarrier_Load(&counts->calls_sent) + 1);
+  base::subtle::NoBarrier_Store(
+      &counts->bytes_sent,
+      base::subtle::NoBarrier_Load(&counts->bytes_sent) + num_bytes);
+}
+
+void BindingsTraceInstrumentation::OnMessageDispatched(
+    const char* interface_name,
+    const char* method_name,
+    bool is_response,
+    uint32_t num_bytes,
+    MojoTimeTicks queueing_time,
+    MojoTimeTicks handler_time) {
+  ThreadMethodCounts* counts =
+      GetThreadMethodCounts(interface_name, method_name);
+  base::subtle::NoBarrier_Store(
+      &counts->calls_dispatched,
+      base::subtle::NoBarrier_Load(&counts->calls_dispatched) + 1);
+  base::subtle::NoBarrier_Store(
+      &counts->bytes_dispatched,
+      base::subtle::NoBarrier_Load(&counts->bytes_dispatched) + num_bytes);
+  // Histograms are thread-safe.
+  counts->stats->handler_time->Add(static_cast<int>(handler_time));
+  if (queueing_time >= 0)
+    counts->stats->queueing_time->Add(static_cast<int>(queueing_time));
+}
+
+void BindingsTraceInstrumentation::OnResponseReceived(
+    const char* interface_name,
+    const char* method_name,
+    MojoTimeTicks round_trip_time) {
+  GetThreadMethodCounts(interface_name, method_name)
+      ->stats->round_trip_time->Add(static_cast<int>(round_trip_time));
+}
+
+PendingResponsesCounter*
+BindingsTraceInstrumentation::CreatePendingResponsesCounter(
+    const char* interface_name) {
+  return new Counter(this, interface_name);
+}
+
+bool BindingsTraceInstrumentation::OnMemoryDump(
+    base::trace_event::ProcessMemoryDump* pmd) {
+  using base::trace_event::MemoryAllocatorDump;
+
+  std::map<MethodStats*, MethodCounts> method_counts;
+  GetMethodCounts(&method_counts);
+  TraceCounters(method_counts);
+
+  // The same name may be at different addresses (e.g., in different modules),
+  // but each dump's name must be unique.
+  std::map<std::string, PendingResponses> totals;
+  {
+    base::AutoLock locker(lock_);
+    for (const Counter* counter : pending_responses_counters_)
+      counter->AddTo(&totals[counter->interface_name()]);
+  }
+
+  for (const auto& it : totals) {
+    // Dump names can't contain dots.
+    std::string interface_name;
+    base::ReplaceChars(it.first, ".", "_", &interface_name);
+    MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(
+        "mojo/bindings/" + interface_name + "/pending_responses");
+    dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                    MemoryAllocatorDump::kUnitsBytes,
+                    static_cast<uint64_t>(it.second.num_bytes));
+    dump->AddScalar(MemoryAllocatorDump::kNameObjectsCount,
+                    MemoryAllocatorDump::kUnitsObjects,
+                    static_cast<uint64_t>(it.second.count));
+  }
+  return true;
+}
+
+void BindingsTraceInstrumentation::GetMethodCounts(
+    std::map<MethodStats*, MethodCounts>* totals) {
+  base::AutoLock locker(lock_);
+  *totals = exited_thread_counts_;
+  for (const ThreadCounts* thread_counts : thread_counts_) {
+    for (const auto& it : thread_counts->methods)
+      it.second.AddTo(&(*totals)[it.second.stats]);
+  }
+}
+
+void BindingsTraceInstrumentation::TraceCounters(
+    const std::map<MethodStats*, MethodCounts>& totals) {
+  // Building the counter events is comparatively expensive, so only do it when
+  // someone is listening.
+  bool enabled;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(kCategory, &enabled);
+  if (!enabled)
+    return;
+  for (const auto& it : totals) {
+    const MethodStats& stats = *it.first;
+    const MethodCounts& counts = it.second;
+    TRACE_COPY_COUNTER2(kCategory, stats.calls_counter_name.c_str(), "sent",
+                        counts.calls_sent, "dispatched",
+                        counts.calls_dispatched);
+    TRACE_COPY_COUNTER2(kCategory, stats.bytes_counter_name.c_str(), "sent",
+                        counts.bytes_sent, "dispatched",
+                        counts.bytes_dispatched);
+  }
+}
+
+BindingsTraceInstrumentation::ThreadMethodCounts*
+BindingsTraceInstrumentation::GetThreadMethodCounts(const char* interface_name,
+                                                    const char* method_name) {
+  ThreadCounts* thread_counts =
+      static_cast<ThreadCounts*>(thread_counts_slot_.Get());
+  if (!thread_counts) {
+    thread_counts = new ThreadCounts(this);
+    thread_counts_slot_.Set(thread_counts);
+    base::AutoLock locker(lock_);
+    thread_counts_.insert(thread_counts);
+  }
+
+  const MethodKey key(interface_name, method_name);
+  ThreadMethodCountsMap::iterator it = thread_counts->methods.find(key);
+  if (it != thread_counts->methods.end())
+    return &it->second;
+
+  base::AutoLock locker(lock_);
+  MethodStats*& stats = method_stats_[key];
+  if (!stats) {
+    stats = new MethodStats(std::string(interface_name) + "." + method_name);
+  }
+  return &thread_counts->methods.insert(std::make_pair(
+      key, ThreadMethodCounts(stats))).first->second;
+}
+
+// static
+void BindingsTraceInstrumentation::OnThreadExit(void* thread_counts) {
+  ThreadCounts* counts = static_cast<ThreadCounts*>(thread_counts);
+  BindingsTraceInstrumentation* self = counts->instrumentation;
+  {
+    base::AutoLock locker(self->lock_);
+    for (const auto& it : counts->methods)
+      it.second.AddTo(&self->exited_thread_counts_[it.second.stats]);
+    self->thread_counts_.erase(counts);
+  }
+  delete counts;
+}
+
+}  // namespace mojo
@@ -0,0 +1,182 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_COMMON_BINDINGS_TRACE_INSTRUMENTATION_H_
+#define MOJO_COMMON_BINDINGS_TRACE_INSTRUMENTATION_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/containers/hash_tables.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
+#include "base/trace_event/memory_dump_provider.h"
+#include "mojo/public/cpp/bindings/bindings_instrumentation.h"
+
+namespace base {
+class HistogramBase;
+}
+
+namespace mojo {
+
+// Exposes the statistics collected by the bindings (see
+// bindings_instrumentation.h) as trace counters and histograms, per interface
+// method:
+//   - "<interface>.<method>" counters in the "mojo_bindings" trace category,
+//     with the number of calls and bytes sent and dispatched, traced each time
+//     a memory dump is taken;
+//   - "Mojo.Bindings.{HandlerTime,QueueingTime,RoundTripTime}.<interface>.
+//     <method>" histograms, in microseconds;
+//   - "mojo/bindings/<interface>/pending_responses" memory dumps, with the
+//     number of responses awaited by the process's InterfacePtrs and the memory
+//     held for them. Dots in the interface name are replaced by underscores.
+class BindingsTraceInstrumentation
+    : public BindingsInstrumentation,
+      public base::trace_event::MemoryDumpProvider {
+ public:
+  BindingsTraceInstrumentation();
+  ~BindingsTraceInstrumentation() override;
+
+  // Installs a process-wide instance, which is never destroyed, and registers
+  // it with the |MemoryDumpManager|.
+  static void Install();
+
+  // BindingsInstrumentation implementation:
+  void OnMessageSent(const char* interface_name,
+                     const char* method_name,
+                     bool is_response,
+                     uint32_t num_bytes) override;
+  void OnMessageDispatched(const char* interface_name,
+                           const char* method_name,
+                           bool is_response,
+                           uint32_t num_bytes,
+                           MojoTimeTicks queueing_time,
+                           MojoTimeTicks handler_time) override;
+  void OnResponseReceived(const char* interface_name,
+                          const char* method_name,
+                          MojoTimeTicks round_trip_time) override;
+  PendingResponsesCounter* CreatePendingResponsesCounter(
+      const char* interface_name) override;
+
+  // base::trace_event::MemoryDumpProvider implementation:
+  bool OnMemoryDump(base::trace_event::ProcessMemoryDump* pmd) override;
+
+ private:
+  // The histograms and counter names of a method, shared by all threads.
+  struct MethodStats {
+    explicit MethodStats(const std::string& name);
+    ~MethodStats();
+
+    const std::string calls_counter_name;
+    const std::string bytes_counter_name;
+    base::HistogramBase* const handler_time;
+    base::HistogramBase* const queueing_time;
+    base::HistogramBase* const round_trip_time;
+  };
+  // Interface and method names are static strings, so their addresses
+  // identify them.
+  typedef std::pair<const char*, const char*> MethodKey;
+  typedef std::map<MethodKey, MethodStats*> MethodStatsMap;
+
+  struct MethodCounts {
+    MethodCounts();
+
+    int64_t calls_sent;
+    int64_t bytes_sent;
+    int64_t calls_dispatched;
+    int64_t bytes_dispatched;
+  };
+
+  // A thread's counts for a method. Only that thread writes them, but
+  // OnMemoryDump() reads them from another, so they're atomic. They're
+  // pointer-sized, and may wrap on 32-bit platforms.
+  struct ThreadMethodCounts {
+    explicit ThreadMethodCounts(MethodStats* stats);
+
+    void AddTo(MethodCounts* counts) const;
+
+    MethodStats* const stats;
+    base::subtle::AtomicWord calls_sent;
+    base::subtle::AtomicWord bytes_sent;
+    base::subtle::AtomicWord calls_dispatched;
+    base::subtle::AtomicWord bytes_dispatched;
+  };
+  struct MethodKeyHash {
+    size_t operator()(const MethodKey& key) const;
+  };
+  typedef base::hash_map<MethodKey, ThreadMethodCounts, MethodKeyHash>
+      ThreadMethodCountsMap;
+
+  // The counts of a thread, found through |thread_counts_slot_| so that
+  // recording a message takes no lock. Its thread looks methods up without
+  // |lock_|; they're added with |lock_| held, so that OnMemoryDump() can read
+  // them while holding it.
+  struct ThreadCounts {
+    explicit ThreadCounts(BindingsTraceInstrumentation* instrumentation);
+    ~ThreadCounts();
+
+    BindingsTraceInstrumentation* const instrumentation;
+    ThreadMethodCountsMap methods;
+  };
+
+  struct PendingResponses {
+    PendingResponses() : count(0), num_bytes(0) {}
+
+    int64_t count;
+    int64_t num_bytes;
+  };
+
+  // The counter of an InterfacePtr. Only the InterfacePtr's thread updates it,
+  // and OnMemoryDump() reads it while holding |lock_|.
+  class Counter : public PendingResponsesCounter {
+   public:
+    Counter(BindingsTraceInstrumentation* instrumentation,
+            const char* interface_name);
+    ~Counter() override;
+
+    // PendingResponsesCounter implementation:
+    void Add(int32_t count_delta, int64_t num_bytes_delta) override;
+
+    void AddTo(PendingResponses* pending) const;
+
+    const char* interface_name() const { return interface_name_; }
+
+   private:
+    BindingsTraceInstrumentation* const instrumentation_;
+    const char* const interface_name_;
+    base::subtle::AtomicWord count_;
+    base::subtle::AtomicWord num_bytes_;
+
+    DISALLOW_COPY_AND_ASSIGN(Counter);
+  };
+
+  // Adds up the calls and bytes of every method, on all threads.
+  void GetMethodCounts(std::map<MethodStats*, MethodCounts>* totals);
+  void TraceCounters(const std::map<MethodStats*, MethodCounts>& totals);
+
+  // Returns the calling thread's counts for the method.
+  ThreadMethodCounts* GetThreadMethodCounts(const char* interface_name,
+                                            const char* method_name);
+
+  // Folds the counts of an exiting thread into |exited_thread_counts_|.
+  static void OnThreadExit(void* thread_counts);
+
+  base::ThreadLocalStorage::Slot thread_counts_slot_;
+
+  base::Lock lock_;
+  MethodStatsMap method_stats_;
+  std::set<ThreadCounts*> thread_counts_;
+  std::map<MethodStats*, MethodCounts> exited_thread_counts_;
+  std::set<const Counter*> pending_responses_counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(BindingsTraceInstrumentation);
+};
+
+}  // namespace mojo
+
+#endif  // MOJO_COMMON_BINDINGS_TRACE_INSTRUMENTATION_H_
@@ -4,6 +4,8 @@
 
 #include "mojo/common/trace_provider_impl.h"
 
+#include <string.h>
+
 #include "base/callback.h"
 #include "base/logging.h"
 #include "base/memory/weak_ptr.h"
@@ -15,8 +17,26 @@
 
 namespace mojo {
 
+namespace {
+
+void SendBinaryEvents(const std::string& events,
+                      tracing::TraceRecorderPtr* recorder) {
+  // The string will be empty if an error eccured or there were no trace
+  // events. Empty string is not a valid chunk to record so skip in this case.
+  if (events.empty())
+    return;
+  auto binary_events = Array<uint8_t>::New(events.size());
+  memcpy(binary_events.data(), events.data(), events.size());
+  (*recorder)->RecordBinary(binary_events.Pass());
+}
+
+}  // namespace
+
 TraceProviderImpl::TraceProviderImpl()
-    : binding_(this), tracing_forced_(false), weak_factory_(this) {}
+    : binding_(this),
+      tracing_forced_(false),
+      flight_recording_(false),
+      weak_factory_(this) {}
 
 TraceProviderImpl::~TraceProviderImpl() {}
 
@@ -33,6 +53,8 @@ void TraceProviderImpl::StartTracing(const String& categories,
   DCHECK(!recorder_.get());
   recorder_ = recorder.Pass();
   tracing_forced_ = false;
+  // If flight recording, what has been recorded so far is part of the trace.
+  flight_recording_ = false;
   if (!base::trace_event::TraceLog::GetInstance()->IsEnabled()) {
     std::string categories_str = categories.To<std::string>();
     base::trace_event::TraceLog::GetInstance()->SetEnabled(
@@ -43,13 +65,56 @@ void TraceProviderImpl::StartTracing(const String& categories,
 }
 
 void TraceProviderImpl::StopTracing() {
-  DCHECK(recorder_);
+  if (!recorder_) {
+    if (flight_recording_) {
+      flight_recording_ = false;
+      base::trace_event::TraceLog::GetInstance()->SetDisabled();
+    }
+    return;
+  }
   base::trace_event::TraceLog::GetInstance()->SetDisabled();
 
-  base::trace_event::TraceLog::GetInstance()->Flush(
+  // The events are sent in the binary format, and converted to JSON by the
+  // collector, so that stopping tracing doesn't stall this application.
+  base::trace_event::TraceLog::GetInstance()->FlushAsBinary(
       base::Bind(&TraceProviderImpl::SendChunk, base::Unretained(this)));
 }
 
+void TraceProviderImpl::StartFlightRecorder(const String& categories) {
+  if (recorder_ || flight_recording_) {
+    LOG(WARNING) << "Not flight recording: already tracing.";
+    return;
+  }
+  base::trace_event::TraceLog* trace_log =
+      base::trace_event::TraceLog::GetInstance();
+  // Startup tracing gives way to flight recording.
+  if (tracing_forced_) {
+    tracing_forced_ = false;
+    trace_log->SetDisabled();
+  }
+  if (trace_log->IsEnabled()) {
+    LOG(WARNING) << "Not flight recording: already tracing.";
+    return;
+  }
+  trace_log->SetEnabled(
+      base::trace_event::TraceConfig(categories.To<std::string>(),
+                                     base::trace_event::RECORD_CONTINUOUSLY),
+      base::trace_event::TraceLog::RECORDING_MODE);
+  flight_recording_ = true;
+}
+
+void TraceProviderImpl::Snapshot(uint32_t seconds,
+                                 tracing::TraceRecorderPtr recorder) {
+  // Dropping |recorder| closes it.
+  if (!flight_recording_ || snapshot_recorder_)
+    return;
+  snapshot_recorder_ = recorder.Pass();
+  base::trace_event::TraceLog::GetInstance()->SnapshotAsBinary(
+      base::TimeDelta::FromSeconds(seconds),
+      base::Bind(&TraceProviderImpl::SendSnapshotChunk,
+                 weak_factory_.GetWeakPtr()));
+}
+
 void TraceProviderImpl::ForceEnableTracing() {
   base::trace_event::TraceLog::GetInstance()->SetEnabled(
       base::trace_event::TraceConfig("*", base::trace_event::RECORD_UNTIL_FULL),
@@ -85,14 +150,19 @@ void TraceProviderImpl::SendChunk(
     const scoped_refptr<base::RefCountedString>& events_str,
     bool has_more_events) {
   DCHECK(recorder_);
-  // The string will be empty if an error eccured or there were no trace
-  // events. Empty string is not a valid chunk to record so skip in this case.
-  if (!events_str->data().empty()) {
-    recorder_->Record(mojo::String(events_str->data()));
-  }
+  SendBinaryEvents(events_str->data(), &recorder_);
   if (!has_more_events) {
     recorder_.reset();
   }
 }
 
+void TraceProviderImpl::SendSnapshotChunk(
+    const scoped_refptr<base::RefCountedString>& events_str,
+    bool has_more_events) {
+  DCHECK(snapshot_recorder_);
+  SendBinaryEvents(events_str->data(), &snapshot_recorder_);
+  if (!has_more_events)
+    snapshot_recorder_.reset();
+}
+
 }  // namespace mojo
@@ -29,9 +29,14 @@ class TraceProviderImpl : public tracing::TraceProvider {
   void StartTracing(const String& categories,
                     tracing::TraceRecorderPtr recorder) override;
   void StopTracing() override;
+  void StartFlightRecorder(const String& categories) override;
+  void Snapshot(uint32_t seconds, tracing::TraceRecorderPtr recorder) override;
 
   void SendChunk(const scoped_refptr<base::RefCountedString>& events_str,
                  bool has_more_events);
+  void SendSnapshotChunk(
+      const scoped_refptr<base::RefCountedString>& events_str,
+      bool has_more_events);
 
   void DelayedStop();
   // Stop the collection of traces if no external connection asked for them yet.
@@ -40,6 +45,9 @@ class TraceProviderImpl : public tracing::TraceProvider {
   Binding<tracing::TraceProvider> binding_;
   bool tracing_forced_;
   tracing::TraceRecorderPtr recorder_;
+  bool flight_recording_;
+  // Set while a snapshot is being sent.
+  tracing::TraceRecorderPtr snapshot_recorder_;
 
   base::WeakPtrFactory<TraceProviderImpl> weak_factory_;
   DISALLOW_COPY_AND_ASSIGN(TraceProviderImpl);
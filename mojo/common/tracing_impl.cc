@@ -4,17 +4,41 @@
 
 #include "mojo/common/tracing_impl.h"
 
+#include "base/atomicops.h"
+#include "base/message_loop/message_loop.h"
+#include "base/trace_event/trace_event_cpu_profiler.h"
 #include "base/trace_event/trace_event_impl.h"
+#include "mojo/common/bindings_trace_instrumentation.h"
 #include "mojo/public/cpp/application/application_connection.h"
 #include "mojo/public/cpp/application/application_impl.h"
 
 namespace mojo {
+namespace {
+
+// Set while a TracingImpl of the process has a CPU profiler. Applications may
+// share a process (e.g. in a single-process shell), and one profiler samples
+// all of its threads.
+base::subtle::Atomic32 g_has_cpu_profiler = 0;
+
+}  // namespace
 
 TracingImpl::TracingImpl() {}
 
-TracingImpl::~TracingImpl() {}
+TracingImpl::~TracingImpl() {
+  if (cpu_profiler_) {
+    cpu_profiler_.reset();
+    base::subtle::Release_Store(&g_has_cpu_profiler, 0);
+  }
+}
 
 void TracingImpl::Initialize(ApplicationImpl* app) {
+  if (app->HasArg("--trace-bindings"))
+    BindingsTraceInstrumentation::Install();
+  if (base::subtle::Acquire_CompareAndSwap(&g_has_cpu_profiler, 0, 1) == 0) {
+    cpu_profiler_.reset(new base::trace_event::TraceCpuProfiler(
+        base::MessageLoop::current()->task_runner()));
+  }
+
   ApplicationConnection* connection = app->ConnectToApplication("mojo:tracing");
   connection->AddService(this);
 
@@ -6,10 +6,17 @@
 #define MOJO_COMMON_TRACING_IMPL_H_
 
 #include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
 #include "mojo/common/trace_provider_impl.h"
 #include "mojo/public/cpp/application/interface_factory.h"
 #include "mojo/services/tracing/interfaces/tracing.mojom.h"
 
+namespace base {
+namespace trace_event {
+class TraceCpuProfiler;
+}
+}
+
 namespace mojo {
 
 class ApplicationImpl;
@@ -29,6 +36,10 @@ class TracingImpl : public InterfaceFactory<tracing::TraceProvider> {
               InterfaceRequest<tracing::TraceProvider> request) override;
 
   TraceProviderImpl provider_impl_;
+  // Samples the process' stacks while it is traced with the
+  // "disabled-by-default-cpu_profiler" category. Only the first TracingImpl
+  // of the process has one.
+  scoped_ptr<base::trace_event::TraceCpuProfiler> cpu_profiler_;
 
   DISALLOW_COPY_AND_ASSIGN(TracingImpl);
 };
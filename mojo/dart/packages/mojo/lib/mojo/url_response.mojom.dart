@@ -15,7 +15,8 @@ import 'package:mojo/mojo/network_error.mojom.dart' as network_error_mojom;
 
 class UrlResponse extends bindings.Struct {
   static const List<bindings.StructDataHeader> kVersions = const [
-    const bindings.StructDataHeader(88, 0)
+    const bindings.StructDataHeader(88, 0),
+    const bindings.StructDataHeader(112, 1)
   ];
   network_error_mojom.NetworkError error = null;
   core.MojoDataPipeConsumer body = null;
@@ -28,6 +29,9 @@ class UrlResponse extends bindings.Struct {
   String redirectMethod = null;
   String redirectUrl = null;
   String redirectReferrer = null;
+  core.MojoSharedBuffer bodyBuffer = null;
+  int bodyBufferOffset = 0;
+  int bodyBufferSize = 0;
 
   UrlResponse() : super(kVersions.last.size);
 
@@ -120,6 +124,18 @@ class UrlResponse extends bindings.Struct {
       
       result.redirectReferrer = decoder0.decodeString(80, true);
     }
+    if (mainDataHeader.version >= 1) {
+      
+      result.bodyBuffer = decoder0.decodeSharedBufferHandle(88, true);
+    }
+    if (mainDataHeader.version >= 1) {
+      
+      result.bodyBufferOffset = decoder0.decodeUint64(96);
+    }
+    if (mainDataHeader.version >= 1) {
+      
+      result.bodyBufferSize = decoder0.decodeUint64(104);
+    }
     return result;
   }
 
@@ -155,6 +171,12 @@ class UrlResponse extends bindings.Struct {
     encoder0.encodeString(redirectUrl, 72, true);
     
     encoder0.encodeString(redirectReferrer, 80, true);
+    
+    encoder0.encodeSharedBufferHandle(bodyBuffer, 88, true);
+    
+    encoder0.encodeUint64(bodyBufferOffset, 96);
+    
+    encoder0.encodeUint64(bodyBufferSize, 104);
   }
 
   String toString() {
@@ -169,7 +191,10 @@ class UrlResponse extends bindings.Struct {
            "charset: $charset" ", "
            "redirectMethod: $redirectMethod" ", "
            "redirectUrl: $redirectUrl" ", "
-           "redirectReferrer: $redirectReferrer" ")";
+           "redirectReferrer: $redirectReferrer" ", "
+           "bodyBuffer: $bodyBuffer" ", "
+           "bodyBufferOffset: $bodyBufferOffset" ", "
+           "bodyBufferSize: $bodyBufferSize" ")";
   }
 
   Map toJson() {
@@ -143,6 +143,147 @@ class _TraceProviderStopTracingParams extends bindings.Struct {
 }
 
 
+class _TraceProviderStartFlightRecorderParams extends bindings.Struct {
+  static const List<bindings.StructDataHeader> kVersions = const [
+    const bindings.StructDataHeader(16, 0)
+  ];
+  String categories = null;
+
+  _TraceProviderStartFlightRecorderParams() : super(kVersions.last.size);
+
+  static _TraceProviderStartFlightRecorderParams deserialize(bindings.Message message) {
+    var decoder = new bindings.Decoder(message);
+    var result = decode(decoder);
+    if (decoder.excessHandles != null) {
+      decoder.excessHandles.forEach((h) => h.close());
+    }
+    return result;
+  }
+
+  static _TraceProviderStartFlightRecorderParams decode(bindings.Decoder decoder0) {
+    if (decoder0 == null) {
+      return null;
+    }
+    _TraceProviderStartFlightRecorderParams result = new _TraceProviderStartFlightRecorderParams();
+
+    var mainDataHeader = decoder0.decodeStructDataHeader();
+    if (mainDataHeader.version <= kVersions.last.version) {
+      // Scan in reverse order to optimize for more recent versions.
+      for (int i = kVersions.length - 1; i >= 0; --i) {
+        if (mainDataHeader.version >= kVersions[i].version) {
+          if (mainDataHeader.size == kVersions[i].size) {
+            // Found a match.
+            break;
+          }
+          throw new bindings.MojoCodecError(
+              'Header size doesn\'t correspond to known version size.');
+        }
+      }
+    } else if (mainDataHeader.size < kVersions.last.size) {
+      throw new bindings.MojoCodecError(
+        'Message newer than the last known version cannot be shorter than '
+        'required by the last known version.');
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.categories = decoder0.decodeString(8, false);
+    }
+    return result;
+  }
+
+  void encode(bindings.Encoder encoder) {
+    var encoder0 = encoder.getStructEncoderAtOffset(kVersions.last);
+    
+    encoder0.encodeString(categories, 8, false);
+  }
+
+  String toString() {
+    return "_TraceProviderStartFlightRecorderParams("
+           "categories: $categories" ")";
+  }
+
+  Map toJson() {
+    Map map = new Map();
+    map["categories"] = categories;
+    return map;
+  }
+}
+
+
+class _TraceProviderSnapshotParams extends bindings.Struct {
+  static const List<bindings.StructDataHeader> kVersions = const [
+    const bindings.StructDataHeader(24, 0)
+  ];
+  int seconds = 0;
+  Object recorder = null;
+
+  _TraceProviderSnapshotParams() : super(kVersions.last.size);
+
+  static _TraceProviderSnapshotParams deserialize(bindings.Message message) {
+    var decoder = new bindings.Decoder(message);
+    var result = decode(decoder);
+    if (decoder.excessHandles != null) {
+      decoder.excessHandles.forEach((h) => h.close());
+    }
+    return result;
+  }
+
+  static _TraceProviderSnapshotParams decode(bindings.Decoder decoder0) {
+    if (decoder0 == null) {
+      return null;
+    }
+    _TraceProviderSnapshotParams result = new _TraceProviderSnapshotParams();
+
+    var mainDataHeader = decoder0.decodeStructDataHeader();
+    if (mainDataHeader.version <= kVersions.last.version) {
+      // Scan in reverse order to optimize for more recent versions.
+      for (int i = kVersions.length - 1; i >= 0; --i) {
+        if (mainDataHeader.version >= kVersions[i].version) {
+          if (mainDataHeader.size == kVersions[i].size) {
+            // Found a match.
+            break;
+          }
+          throw new bindings.MojoCodecError(
+              'Header size doesn\'t correspond to known version size.');
+        }
+      }
+    } else if (mainDataHeader.size < kVersions.last.size) {
+      throw new bindings.MojoCodecError(
+        'Message newer than the last known version cannot be shorter than '
+        'required by the last known version.');
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.seconds = decoder0.decodeUint32(8);
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.recorder = decoder0.decodeServiceInterface(12, false, TraceRecorderProxy.newFromEndpoint);
+    }
+    return result;
+  }
+
+  void encode(bindings.Encoder encoder) {
+    var encoder0 = encoder.getStructEncoderAtOffset(kVersions.last);
+    
+    encoder0.encodeUint32(seconds, 8);
+    
+    encoder0.encodeInterface(recorder, 12, false);
+  }
+
+  String toString() {
+    return "_TraceProviderSnapshotParams("
+           "seconds: $seconds" ", "
+           "recorder: $recorder" ")";
+  }
+
+  Map toJson() {
+    throw new bindings.MojoCodecError(
+        'Object containing handles cannot be encoded to JSON.');
+  }
+}
+
+
 class _TraceRecorderRecordParams extends bindings.Struct {
   static const List<bindings.StructDataHeader> kVersions = const [
     const bindings.StructDataHeader(16, 0)
@@ -210,6 +351,73 @@ class _TraceRecorderRecordParams extends bindings.Struct {
 }
 
 
+class _TraceRecorderRecordBinaryParams extends bindings.Struct {
+  static const List<bindings.StructDataHeader> kVersions = const [
+    const bindings.StructDataHeader(16, 0)
+  ];
+  List<int> events = null;
+
+  _TraceRecorderRecordBinaryParams() : super(kVersions.last.size);
+
+  static _TraceRecorderRecordBinaryParams deserialize(bindings.Message message) {
+    var decoder = new bindings.Decoder(message);
+    var result = decode(decoder);
+    if (decoder.excessHandles != null) {
+      decoder.excessHandles.forEach((h) => h.close());
+    }
+    return result;
+  }
+
+  static _TraceRecorderRecordBinaryParams decode(bindings.Decoder decoder0) {
+    if (decoder0 == null) {
+      return null;
+    }
+    _TraceRecorderRecordBinaryParams result = new _TraceRecorderRecordBinaryParams();
+
+    var mainDataHeader = decoder0.decodeStructDataHeader();
+    if (mainDataHeader.version <= kVersions.last.version) {
+      // Scan in reverse order to optimize for more recent versions.
+      for (int i = kVersions.length - 1; i >= 0; --i) {
+        if (mainDataHeader.version >= kVersions[i].version) {
+          if (mainDataHeader.size == kVersions[i].size) {
+            // Found a match.
+            break;
+          }
+          throw new bindings.MojoCodecError(
+              'Header size doesn\'t correspond to known version size.');
+        }
+      }
+    } else if (mainDataHeader.size < kVersions.last.size) {
+      throw new bindings.MojoCodecError(
+        'Message newer than the last known version cannot be shorter than '
+        'required by the last known version.');
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.events = decoder0.decodeUint8Array(8, bindings.kNothingNullable, bindings.kUnspecifiedArrayLength);
+    }
+    return result;
+  }
+
+  void encode(bindings.Encoder encoder) {
+    var encoder0 = encoder.getStructEncoderAtOffset(kVersions.last);
+    
+    encoder0.encodeUint8Array(events, 8, bindings.kNothingNullable, bindings.kUnspecifiedArrayLength);
+  }
+
+  String toString() {
+    return "_TraceRecorderRecordBinaryParams("
+           "events: $events" ")";
+  }
+
+  Map toJson() {
+    Map map = new Map();
+    map["events"] = events;
+    return map;
+  }
+}
+
+
 class _TraceCollectorStartParams extends bindings.Struct {
   static const List<bindings.StructDataHeader> kVersions = const [
     const bindings.StructDataHeader(24, 0)
@@ -341,13 +549,158 @@ class _TraceCollectorStopAndFlushParams extends bindings.Struct {
   }
 }
 
+
+class _TraceCollectorStartFlightRecorderParams extends bindings.Struct {
+  static const List<bindings.StructDataHeader> kVersions = const [
+    const bindings.StructDataHeader(16, 0)
+  ];
+  String categories = null;
+
+  _TraceCollectorStartFlightRecorderParams() : super(kVersions.last.size);
+
+  static _TraceCollectorStartFlightRecorderParams deserialize(bindings.Message message) {
+    var decoder = new bindings.Decoder(message);
+    var result = decode(decoder);
+    if (decoder.excessHandles != null) {
+      decoder.excessHandles.forEach((h) => h.close());
+    }
+    return result;
+  }
+
+  static _TraceCollectorStartFlightRecorderParams decode(bindings.Decoder decoder0) {
+    if (decoder0 == null) {
+      return null;
+    }
+    _TraceCollectorStartFlightRecorderParams result = new _TraceCollectorStartFlightRecorderParams();
+
+    var mainDataHeader = decoder0.decodeStructDataHeader();
+    if (mainDataHeader.version <= kVersions.last.version) {
+      // Scan in reverse order to optimize for more recent versions.
+      for (int i = kVersions.length - 1; i >= 0; --i) {
+        if (mainDataHeader.version >= kVersions[i].version) {
+          if (mainDataHeader.size == kVersions[i].size) {
+            // Found a match.
+            break;
+          }
+          throw new bindings.MojoCodecError(
+              'Header size doesn\'t correspond to known version size.');
+        }
+      }
+    } else if (mainDataHeader.size < kVersions.last.size) {
+      throw new bindings.MojoCodecError(
+        'Message newer than the last known version cannot be shorter than '
+        'required by the last known version.');
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.categories = decoder0.decodeString(8, false);
+    }
+    return result;
+  }
+
+  void encode(bindings.Encoder encoder) {
+    var encoder0 = encoder.getStructEncoderAtOffset(kVersions.last);
+    
+    encoder0.encodeString(categories, 8, false);
+  }
+
+  String toString() {
+    return "_TraceCollectorStartFlightRecorderParams("
+           "categories: $categories" ")";
+  }
+
+  Map toJson() {
+    Map map = new Map();
+    map["categories"] = categories;
+    return map;
+  }
+}
+
+
+class _TraceCollectorSnapshotParams extends bindings.Struct {
+  static const List<bindings.StructDataHeader> kVersions = const [
+    const bindings.StructDataHeader(16, 0)
+  ];
+  core.MojoDataPipeProducer stream = null;
+  int seconds = 0;
+
+  _TraceCollectorSnapshotParams() : super(kVersions.last.size);
+
+  static _TraceCollectorSnapshotParams deserialize(bindings.Message message) {
+    var decoder = new bindings.Decoder(message);
+    var result = decode(decoder);
+    if (decoder.excessHandles != null) {
+      decoder.excessHandles.forEach((h) => h.close());
+    }
+    return result;
+  }
+
+  static _TraceCollectorSnapshotParams decode(bindings.Decoder decoder0) {
+    if (decoder0 == null) {
+      return null;
+    }
+    _TraceCollectorSnapshotParams result = new _TraceCollectorSnapshotParams();
+
+    var mainDataHeader = decoder0.decodeStructDataHeader();
+    if (mainDataHeader.version <= kVersions.last.version) {
+      // Scan in reverse order to optimize for more recent versions.
+      for (int i = kVersions.length - 1; i >= 0; --i) {
+        if (mainDataHeader.version >= kVersions[i].version) {
+          if (mainDataHeader.size == kVersions[i].size) {
+            // Found a match.
+            break;
+          }
+          throw new bindings.MojoCodecError(
+              'Header size doesn\'t correspond to known version size.');
+        }
+      }
+    } else if (mainDataHeader.size < kVersions.last.size) {
+      throw new bindings.MojoCodecError(
+        'Message newer than the last known version cannot be shorter than '
+        'required by the last known version.');
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.stream = decoder0.decodeProducerHandle(8, false);
+    }
+    if (mainDataHeader.version >= 0) {
+      
+      result.seconds = decoder0.decodeUint32(12);
+    }
+    return result;
+  }
+
+  void encode(bindings.Encoder encoder) {
+    var encoder0 = encoder.getStructEncoderAtOffset(kVersions.last);
+    
+    encoder0.encodeProducerHandle(stream, 8, false);
+    
+    encoder0.encodeUint32(seconds, 12);
+  }
+
+  String toString() {
+    return "_TraceCollectorSnapshotParams("
+           "stream: $stream" ", "
+           "seconds: $seconds" ")";
+  }
+
+  Map toJson() {
+    throw new bindings.MojoCodecError(
+        'Object containing handles cannot be encoded to JSON.');
+  }
+}
+
 const int _TraceProvider_startTracingName = 0;
 const int _TraceProvider_stopTracingName = 1;
+const int _TraceProvider_startFlightRecorderName = 2;
+const int _TraceProvider_snapshotName = 3;
 
 abstract class TraceProvider {
   static const String serviceName = "tracing::TraceProvider";
   void startTracing(String categories, Object recorder);
   void stopTracing();
+  void startFlightRecorder(String categories);
+  void snapshot(int seconds, Object recorder);
 }
 
 
@@ -404,6 +757,25 @@ class _TraceProviderProxyCalls implements TraceProvider {
       var params = new _TraceProviderStopTracingParams();
       _proxyImpl.sendMessage(params, _TraceProvider_stopTracingName);
     }
+    void startFlightRecorder(String categories) {
+      if (!_proxyImpl.isBound) {
+        _proxyImpl.proxyError("The Proxy is closed.");
+        return;
+      }
+      var params = new _TraceProviderStartFlightRecorderParams();
+      params.categories = categories;
+      _proxyImpl.sendMessage(params, _TraceProvider_startFlightRecorderName);
+    }
+    void snapshot(int seconds, Object recorder) {
+      if (!_proxyImpl.isBound) {
+        _proxyImpl.proxyError("The Proxy is closed.");
+        return;
+      }
+      var params = new _TraceProviderSnapshotParams();
+      params.seconds = seconds;
+      params.recorder = recorder;
+      _proxyImpl.sendMessage(params, _TraceProvider_snapshotName);
+    }
 }
 
 
@@ -504,6 +876,16 @@ class TraceProviderStub extends bindings.Stub {
             message.payload);
         _impl.stopTracing();
         break;
+      case _TraceProvider_startFlightRecorderName:
+        var params = _TraceProviderStartFlightRecorderParams.deserialize(
+            message.payload);
+        _impl.startFlightRecorder(params.categories);
+        break;
+      case _TraceProvider_snapshotName:
+        var params = _TraceProviderSnapshotParams.deserialize(
+            message.payload);
+        _impl.snapshot(params.seconds, params.recorder);
+        break;
       default:
         throw new bindings.MojoCodecError("Unexpected message name");
         break;
@@ -526,10 +908,12 @@ class TraceProviderStub extends bindings.Stub {
 }
 
 const int _TraceRecorder_recordName = 0;
+const int _TraceRecorder_recordBinaryName = 1;
 
 abstract class TraceRecorder {
   static const String serviceName = null;
   void record(String json);
+  void recordBinary(List<int> events);
 }
 
 
@@ -577,6 +961,15 @@ class _TraceRecorderProxyCalls implements TraceRecorder {
       params.json = json;
       _proxyImpl.sendMessage(params, _TraceRecorder_recordName);
     }
+    void recordBinary(List<int> events) {
+      if (!_proxyImpl.isBound) {
+        _proxyImpl.proxyError("The Proxy is closed.");
+        return;
+      }
+      var params = new _TraceRecorderRecordBinaryParams();
+      params.events = events;
+      _proxyImpl.sendMessage(params, _TraceRecorder_recordBinaryName);
+    }
 }
 
 
@@ -672,6 +1065,11 @@ class TraceRecorderStub extends bindings.Stub {
             message.payload);
         _impl.record(params.json);
         break;
+      case _TraceRecorder_recordBinaryName:
+        var params = _TraceRecorderRecordBinaryParams.deserialize(
+            message.payload);
+        _impl.recordBinary(params.events);
+        break;
       default:
         throw new bindings.MojoCodecError("Unexpected message name");
         break;
@@ -695,11 +1093,15 @@ class TraceRecorderStub extends bindings.Stub {
 
 const int _TraceCollector_startName = 0;
 const int _TraceCollector_stopAndFlushName = 1;
+const int _TraceCollector_startFlightRecorderName = 2;
+const int _TraceCollector_snapshotName = 3;
 
 abstract class TraceCollector {
   static const String serviceName = "tracing::TraceCollector";
   void start(core.MojoDataPipeProducer stream, String categories);
   void stopAndFlush();
+  void startFlightRecorder(String categories);
+  void snapshot(core.MojoDataPipeProducer stream, int seconds);
 }
 
 
@@ -756,6 +1158,25 @@ class _TraceCollectorProxyCalls implements TraceCollector {
       var params = new _TraceCollectorStopAndFlushParams();
       _proxyImpl.sendMessage(params, _TraceCollector_stopAndFlushName);
     }
+    void startFlightRecorder(String categories) {
+      if (!_proxyImpl.isBound) {
+        _proxyImpl.proxyError("The Proxy is closed.");
+        return;
+      }
+      var params = new _TraceCollectorStartFlightRecorderParams();
+      params.categories = categories;
+      _proxyImpl.sendMessage(params, _TraceCollector_startFlightRecorderName);
+    }
+    void snapshot(core.MojoDataPipeProducer stream, int seconds) {
+      if (!_proxyImpl.isBound) {
+        _proxyImpl.proxyError("The Proxy is closed.");
+        return;
+      }
+      var params = new _TraceCollectorSnapshotParams();
+      params.stream = stream;
+      params.seconds = seconds;
+      _proxyImpl.sendMessage(params, _TraceCollector_snapshotName);
+    }
 }
 
 
@@ -856,6 +1277,16 @@ class TraceCollectorStub extends bindings.Stub {
             message.payload);
         _impl.stopAndFlush();
         break;
+      case _TraceCollector_startFlightRecorderName:
+        var params = _TraceCollectorStartFlightRecorderParams.deserialize(
+            message.payload);
+        _impl.startFlightRecorder(params.categories);
+        break;
+      case _TraceCollector_snapshotName:
+        var params = _TraceCollectorSnapshotParams.deserialize(
+            message.payload);
+        _impl.snapshot(params.stream, params.seconds);
+        break;
       default:
         throw new bindings.MojoCodecError("Unexpected message name");
         break;
@@ -0,0 +1,184 @@
+# Copyright 2015 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Statistical tools to tell whether the results of two sets of benchmark runs
+really differ, or only differ because of noise."""
+
+import math
+import random
+
+# Significance level of the tests.
+_ALPHA = 0.05
+
+# Runs whose modified z-score is beyond this are outliers, see Iglewicz and
+# Hoaglin, "How to Detect and Handle Outliers".
+_OUTLIER_Z_SCORE = 3.5
+
+# Absolute rank correlation between the run order and the results above which
+# the results are considered to drift (e.g. as the device heats up).
+_DRIFT_CORRELATION = 0.8
+_DRIFT_MIN_RUNS = 6
+
+# Minimum number of results on each side to conclude anything.
+_MIN_RUNS = 3
+
+_BOOTSTRAP_RESAMPLES = 2000
+
+
+def median(values):
+  """Returns the median of the non-empty list |values|."""
+  ordered = sorted(values)
+  middle = len(ordered) / 2
+  if len(ordered) % 2:
+    return float(ordered[middle])
+  return (ordered[middle - 1] + ordered[middle]) / 2.0
+
+
+def _ranks(values):
+  """Returns the ranks (starting at 1) of |values|, giving tied values the
+  average of their ranks, and the sizes of the groups of ties."""
+  order = sorted(range(len(values)), key=lambda i: values[i])
+  ranks = [0.0] * len(values)
+  tie_sizes = []
+  i = 0
+  while i < len(order):
+    j = i
+    while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+      j += 1
+    for k in xrange(i, j + 1):
+      ranks[order[k]] = (i + j) / 2.0 + 1
+    tie_sizes.append(j - i + 1)
+    i = j + 1
+  return ranks, tie_sizes
+
+
+def mann_whitney_u(a, b):
+  """Runs the two-sided Mann-Whitney U test on the samples |a| and |b|, using
+  the normal approximation with tie and continuity corrections.
+
+  Returns:
+    A tuple (u, p_value), where u is the U statistic of |a|.
+  """
+  n1 = len(a)
+  n2 = len(b)
+  n = n1 + n2
+  ranks, tie_sizes = _ranks(list(a) + list(b))
+  u = sum(ranks[:n1]) - n1 * (n1 + 1) / 2.0
+  mean = n1 * n2 / 2.0
+  ties = sum(t ** 3 - t for t in tie_sizes)
+  variance = n1 * n2 / 12.0 * ((n + 1) - ties / float(n * (n - 1)))
+  if variance <= 0:
+    return u, 1.0
+  z = max(0.0, abs(u - mean) - 0.5) / math.sqrt(variance)
+  return u, math.erfc(z / math.sqrt(2))
+
+
+def bootstrap_ci(a, b, confidence=0.95, resamples=_BOOTSTRAP_RESAMPLES,
+                 rng=None):
+  """Returns the bootstrap (percentile) confidence interval of the difference
+  between the median of |b| and the median of |a|, as a (low, high) tuple."""
+  rng = rng or random.Random(0)
+  differences = []
+  for _ in xrange(resamples):
+    resampled_a = [rng.choice(a) for _ in a]
+    resampled_b = [rng.choice(b) for _ in b]
+    differences.append(median(resampled_b) - median(resampled_a))
+  differences.sort()
+  tail = (1 - confidence) / 2
+  low = differences[int(math.floor(tail * (resamples - 1)))]
+  high = differences[int(math.ceil((1 - tail) * (resamples - 1)))]
+  return low, high
+
+
+def find_outliers(values):
+  """Returns the indices of the outliers in |values|, based on their distance
+  to the median in median absolute deviations (which, unlike the standard
+  deviation, isn't inflated by the outliers themselves)."""
+  if len(values) < _MIN_RUNS:
+    return []
+  center = median(values)
+  mad = median([abs(value - center) for value in values])
+  if not mad:
+    return []
+  return [i for i, value in enumerate(values)
+          if abs(0.6745 * (value - center) / mad) > _OUTLIER_Z_SCORE]
+
+
+def rank_correlation(values):
+  """Returns Spearman's rank correlation between |values| and their order, or
+  0 if it is undefined."""
+  if len(values) < 2:
+    return 0.0
+  value_ranks, _ = _ranks(values)
+  order_ranks = range(1, len(values) + 1)
+  mean = (len(values) + 1) / 2.0
+  covariance = sum((x - mean) * (y - mean)
+                   for x, y in zip(value_ranks, order_ranks))
+  deviation = math.sqrt(sum((x - mean) ** 2 for x in value_ranks) *
+                        sum((y - mean) ** 2 for y in order_ranks))
+  if not deviation:
+    return 0.0
+  return covariance / deviation
+
+
+def has_drift(values):
+  """Tells whether |values|, in the order of the runs that produced them,
+  steadily go up or down, as happens e.g. with thermal throttling or CPU
+  frequency scaling."""
+  return (len(values) >= _DRIFT_MIN_RUNS and
+          abs(rank_correlation(values)) >= _DRIFT_CORRELATION)
+
+
+def _describe(values, outliers):
+  return {
+      'n': len(values) - len(outliers),
+      'median': median(values) if values else None,
+      'outliers': [values[i] for i in outliers],
+      'drift': has_drift(values),
+  }
+
+
+def compare(a, b, rng=None):
+  """Compares the results |a| and |b| of a measurement in two sets of runs,
+  each in the order of the runs.
+
+  Outlier runs are left out of the comparison. The verdict is 'increase' or
+  'decrease' if the results of |b| are significantly higher or lower than
+  those of |a|. A Mann-Whitney U test must show the difference, and the
+  bootstrap confidence interval of the difference of the medians must not
+  contain 0. Otherwise the verdict is 'no_change'. It is 'inconclusive' if
+  there aren't enough runs.
+
+  Returns:
+    A dictionary describing the comparison, which can be serialized as JSON.
+  """
+  a_outliers = find_outliers(a)
+  b_outliers = find_outliers(b)
+  result = {
+      'a': _describe(a, a_outliers),
+      'b': _describe(b, b_outliers),
+      'p_value': None,
+      'ci': None,
+      'difference': None,
+      'relative_difference': None,
+      'verdict': 'inconclusive',
+  }
+  a = [value for i, value in enumerate(a) if i not in a_outliers]
+  b = [value for i, value in enumerate(b) if i not in b_outliers]
+  if len(a) < _MIN_RUNS or len(b) < _MIN_RUNS:
+    return result
+
+  _, p_value = mann_whitney_u(a, b)
+  low, high = bootstrap_ci(a, b, rng=rng)
+  difference = median(b) - median(a)
+  result['p_value'] = p_value
+  result['ci'] = [low, high]
+  result['difference'] = difference
+  if median(a):
+    result['relative_difference'] = difference / median(a)
+  if p_value < _ALPHA and (low > 0 or high < 0):
+    result['verdict'] = 'increase' if difference > 0 else 'decrease'
+  else:
+    result['verdict'] = 'no_change'
+  return result
@@ -0,0 +1,93 @@
+# Copyright 2015 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Tests for the statistical comparison of benchmark results."""
+
+import imp
+import os.path
+import random
+import sys
+import unittest
+
+try:
+  imp.find_module("devtoolslib")
+except ImportError:
+  sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from devtoolslib import statistics
+
+
+class StatisticsTest(unittest.TestCase):
+  """Tests the statistics module."""
+
+  def test_median(self):
+    self.assertEquals(2.0, statistics.median([3, 1, 2]))
+    self.assertEquals(2.5, statistics.median([4, 1, 3, 2]))
+
+  def test_mann_whitney_u(self):
+    """Checks the U statistic and p-value against reference values."""
+    u, p_value = statistics.mann_whitney_u([1, 2, 3, 4, 5], [6, 7, 8, 9, 10])
+    self.assertEquals(0, u)
+    self.assertAlmostEquals(0.0122, p_value, places=3)
+
+    u, p_value = statistics.mann_whitney_u([1, 3, 5, 7], [2, 4, 6, 8])
+    self.assertEquals(6, u)
+    self.assertGreater(p_value, 0.5)
+
+    # All values tied.
+    _, p_value = statistics.mann_whitney_u([1, 1, 1], [1, 1, 1])
+    self.assertEquals(1.0, p_value)
+
+  def test_bootstrap_ci(self):
+    a = [10.0, 10.5, 9.5, 10.2, 9.8, 10.1]
+    b = [12.0, 12.5, 11.5, 12.2, 11.8, 12.1]
+    low, high = statistics.bootstrap_ci(a, b, rng=random.Random(1))
+    self.assertLessEqual(low, 2.0)
+    self.assertGreaterEqual(high, 2.0)
+    self.assertGreater(low, 0)
+
+  def test_find_outliers(self):
+    self.assertEquals([4], statistics.find_outliers([10, 11, 10, 12, 50, 11]))
+    self.assertEquals([], statistics.find_outliers([10, 11, 10, 12, 11]))
+    self.assertEquals([], statistics.find_outliers([5, 5, 5, 9]))
+
+  def test_has_drift(self):
+    self.assertTrue(statistics.has_drift([10, 11, 12, 12.5, 13, 14, 15]))
+    self.assertTrue(statistics.has_drift([15, 14, 13, 12, 11, 10]))
+    self.assertFalse(statistics.has_drift([10, 12, 11, 10, 12, 11]))
+    # Too few runs to tell.
+    self.assertFalse(statistics.has_drift([1, 2, 3]))
+
+  def test_compare(self):
+    rng = random.Random(0)
+    a = [10 + rng.gauss(0, 0.2) for _ in xrange(10)]
+    b = [11 + rng.gauss(0, 0.2) for _ in xrange(10)]
+    result = statistics.compare(a, b, rng=random.Random(0))
+    self.assertEquals('increase', result['verdict'])
+    self.assertLess(result['p_value'], 0.05)
+    self.assertAlmostEquals(0.1, result['relative_difference'], places=1)
+
+    result = statistics.compare(b, a, rng=random.Random(0))
+    self.assertEquals('decrease', result['verdict'])
+
+    c = [10 + rng.gauss(0, 0.2) for _ in xrange(10)]
+    result = statistics.compare(a, c, rng=random.Random(0))
+    self.assertEquals('no_change', result['verdict'])
+
+  def test_compare_leaves_outliers_out(self):
+    a = [10, 10.1, 9.9, 10, 10.2, 9.8, 10]
+    b = [10, 10.1, 9.9, 10, 10.2, 9.8, 100]
+    result = statistics.compare(a, b, rng=random.Random(0))
+    self.assertEquals([100], result['b']['outliers'])
+    self.assertEquals(6, result['b']['n'])
+    self.assertEquals('no_change', result['verdict'])
+
+  def test_compare_inconclusive(self):
+    result = statistics.compare([1, 2], [3, 4])
+    self.assertEquals('inconclusive', result['verdict'])
+    self.assertEquals(None, result['p_value'])
+
+
+if __name__ == "__main__":
+  unittest.main()
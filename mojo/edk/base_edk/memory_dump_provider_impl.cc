@@ -0,0 +1,75 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/edk/base_edk/memory_dump_provider_impl.h"
+
+#include <string>
+
+#include "base/logging.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "mojo/edk/embedder/embedder.h"
+#include "mojo/edk/embedder/memory_usage_dump.h"
+#include "mojo/edk/embedder/multiprocess_embedder.h"
+
+using base::trace_event::MemoryAllocatorDump;
+using base::trace_event::ProcessMemoryDump;
+
+namespace base_edk {
+namespace {
+
+// Turns each reported structure into a "mojo/<name>" allocator dump.
+class AllocatorDumpWriter : public mojo::embedder::MemoryUsageDump {
+ public:
+  explicit AllocatorDumpWriter(ProcessMemoryDump* pmd) : pmd_(pmd) {}
+  ~AllocatorDumpWriter() override {}
+
+  // |mojo::embedder::MemoryUsageDump| implementation:
+  void AddUsage(const std::string& name,
+                size_t num_objects,
+                size_t num_bytes) override {
+    MemoryAllocatorDump* dump = pmd_->CreateAllocatorDump("mojo/" + name);
+    dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                    MemoryAllocatorDump::kUnitsBytes, num_bytes);
+    dump->AddScalar(MemoryAllocatorDump::kNameObjectsCount,
+                    MemoryAllocatorDump::kUnitsObjects, num_objects);
+  }
+
+ private:
+  ProcessMemoryDump* const pmd_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocatorDumpWriter);
+};
+
+}  // namespace
+
+MemoryDumpProviderImpl::MemoryDumpProviderImpl(bool dump_ipc)
+    : dump_ipc_(dump_ipc) {}
+
+MemoryDumpProviderImpl::~MemoryDumpProviderImpl() {}
+
+// static
+void MemoryDumpProviderImpl::Install(
+    const scoped_refptr<base::SingleThreadTaskRunner>& io_task_runner) {
+  MemoryDumpProviderImpl* provider =
+      new MemoryDumpProviderImpl(!!io_task_runner);
+  if (io_task_runner) {
+    base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+        provider, io_task_runner);
+  } else {
+    base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+        provider);
+  }
+}
+
+bool MemoryDumpProviderImpl::OnMemoryDump(ProcessMemoryDump* pmd) {
+  AllocatorDumpWriter writer(pmd);
+  mojo::embedder::DumpMemoryUsage(&writer);
+  if (dump_ipc_)
+    mojo::embedder::DumpIPCMemoryUsageOnIOThread(&writer);
+  return true;
+}
+
+}  // namespace base_edk
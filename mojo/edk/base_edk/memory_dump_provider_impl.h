@@ -0,0 +1,47 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file provides an implementation of
+// |base::trace_event::MemoryDumpProvider| that reports the memory used by the
+// EDK's internal structures (see |mojo::embedder::DumpMemoryUsage()|) as
+// "mojo/..." allocator dumps.
+
+#ifndef MOJO_EDK_BASE_EDK_MEMORY_DUMP_PROVIDER_IMPL_H_
+#define MOJO_EDK_BASE_EDK_MEMORY_DUMP_PROVIDER_IMPL_H_
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/trace_event/memory_dump_provider.h"
+
+namespace base_edk {
+
+class MemoryDumpProviderImpl : public base::trace_event::MemoryDumpProvider {
+ public:
+  // If |dump_ipc| is true, |OnMemoryDump()| must be called on the I/O thread
+  // given to |mojo::embedder::InitIPCSupport()|, and the dumps include the
+  // channels' buffers.
+  explicit MemoryDumpProviderImpl(bool dump_ipc);
+  ~MemoryDumpProviderImpl() override;
+
+  // Registers a process-wide instance, which is never destroyed, with the
+  // |MemoryDumpManager|. This must be called after |mojo::embedder::Init()|.
+  // If |io_task_runner| is non-null, it should be for the I/O thread given to
+  // |mojo::embedder::InitIPCSupport()|; dumps are then taken on it and include
+  // the channels.
+  static void Install(
+      const scoped_refptr<base::SingleThreadTaskRunner>& io_task_runner);
+
+  // |base::trace_event::MemoryDumpProvider| implementation:
+  bool OnMemoryDump(base::trace_event::ProcessMemoryDump* pmd) override;
+
+ private:
+  const bool dump_ipc_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryDumpProviderImpl);
+};
+
+}  // namespace base_edk
+
+#endif  // MOJO_EDK_BASE_EDK_MEMORY_DUMP_PROVIDER_IMPL_H_
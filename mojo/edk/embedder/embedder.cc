@@ -4,12 +4,15 @@
 
 #include "mojo/edk/embedder/embedder.h"
 
+#include <utility>
+
 #include "base/logging.h"
 #include "mojo/edk/embedder/embedder_internal.h"
-//#include "mojo/edk/embedder/platform_support.h"
+#include "mojo/edk/embedder/platform_support.h"
 #include "mojo/edk/system/configuration.h"
 #include "mojo/edk/system/core.h"
 #include "mojo/edk/system/platform_handle_dispatcher.h"
+#include "mojo/edk/system/shared_buffer_dispatcher.h"
 
 using mojo::platform::ScopedPlatformHandle;
 
@@ -83,5 +86,42 @@ MojoResult PassWrappedPlatformHandle(MojoHandle platform_handle_wrapper_handle,
   return MOJO_RESULT_OK;
 }
 
+MojoResult CreateSharedBufferFromFile(ScopedPlatformHandle platform_handle,
+                                      size_t num_bytes,
+                                      MojoHandle* shared_buffer_handle) {
+  DCHECK(shared_buffer_handle);
+
+  if (!num_bytes ||
+      num_bytes > system::GetConfiguration().max_shared_memory_num_bytes)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  DCHECK(internal::g_platform_support);
+  auto shared_buffer =
+      internal::g_platform_support->CreateSharedBufferFromHandle(
+          num_bytes, platform_handle.Pass());
+  if (!shared_buffer)
+    return MOJO_RESULT_INVALID_ARGUMENT;
+
+  auto dispatcher =
+      system::SharedBufferDispatcher::CreateFromPlatformSharedBuffer(
+          std::move(shared_buffer));
+
+  DCHECK(internal::g_core);
+  MojoHandle h = internal::g_core->AddDispatcher(dispatcher.get());
+  if (h == MOJO_HANDLE_INVALID) {
+    LOG(ERROR) << "Handle table full";
+    dispatcher->Close();
+    return MOJO_RESULT_RESOURCE_EXHAUSTED;
+  }
+
+  *shared_buffer_handle = h;
+  return MOJO_RESULT_OK;
+}
+
+void DumpMemoryUsage(MemoryUsageDump* dump) {
+  DCHECK(internal::g_core);
+  internal::g_core->DumpMemoryUsage(dump);
+}
+
 }  // namespace embedder
 }  // namespace mojo
@@ -5,6 +5,8 @@
 #ifndef MOJO_EDK_EMBEDDER_EMBEDDER_H_
 #define MOJO_EDK_EMBEDDER_EMBEDDER_H_
 
+#include <stddef.h>
+
 #include <functional>
 #include <memory>
 
@@ -16,6 +18,7 @@ namespace mojo {
 namespace embedder {
 
 struct Configuration;
+class MemoryUsageDump;
 class PlatformSupport;
 
 // Basic configuration/initialization ------------------------------------------
@@ -60,6 +63,26 @@ MojoResult PassWrappedPlatformHandle(
     MojoHandle platform_handle_wrapper_handle,
     platform::ScopedPlatformHandle* platform_handle);
 
+// Creates a shared buffer |MojoHandle| whose contents are those of the file
+// |platform_handle| (taking ownership of it, even on failure, as for
+// |CreatePlatformHandleWrapper()|), which must be exactly |num_bytes| long. This
+// allows the contents of a file to be handed to another application (possibly
+// in another process) without copying them. If |platform_handle| was opened
+// read-only, mappings of the buffer are private (copy-on-write): writes to them
+// are allowed, but never reach the file. (On Android, shared buffers must be
+// ashmem regions, so this fails for regular files.)
+MojoResult CreateSharedBufferFromFile(
+    platform::ScopedPlatformHandle platform_handle,
+    size_t num_bytes,
+    MojoHandle* shared_buffer_handle);
+
+// Reports the memory used by the system's internal structures -- the handle
+// table, the messages queued on message pipes, data pipe buffers and mapped
+// shared buffers -- to |dump| (see memory_usage_dump.h), with a breakdown per
+// handle for the message and data pipes holding on to memory. This may be
+// called from any thread, and is cheap enough to call periodically.
+void DumpMemoryUsage(MemoryUsageDump* dump);
+
 }  // namespace embedder
 }  // namespace mojo
 
@@ -4,7 +4,16 @@
 
 #include "mojo/edk/embedder/embedder.h"
 
+#include <fcntl.h>
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "build/build_config.h"
 #include "mojo/edk/embedder/test_embedder.h"
 #include "mojo/edk/system/test/test_io_thread.h"
 #include "mojo/edk/system/test/timeouts.h"
@@ -13,11 +22,14 @@
 #include "mojo/edk/util/thread_annotations.h"
 #include "mojo/edk/util/waitable_event.h"
 #include "mojo/public/c/system/types.h"
+#include "mojo/public/cpp/system/buffer.h"
 #include "mojo/public/cpp/system/handle.h"
 #include "mojo/public/cpp/system/macros.h"
 #include "mojo/public/cpp/system/message_pipe.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+using mojo::platform::PlatformHandle;
+using mojo::platform::ScopedPlatformHandle;
 using mojo::system::test::TestIOThread;
 using mojo::util::ManualResetWaitableEvent;
 using mojo::util::Mutex;
@@ -133,6 +145,54 @@ TEST_F(EmbedderTest, AsyncWait) {
             unsatisfiable_waiter.wait_result());
 }
 
+ScopedPlatformHandle OpenReadOnly(const base::FilePath& path) {
+  return ScopedPlatformHandle(
+      PlatformHandle(HANDLE_EINTR(open(path.value().c_str(), O_RDONLY))));
+}
+
+#if defined(OS_ANDROID)
+// On Android, shared buffers must be ashmem regions, not regular files.
+#define MAYBE_CreateSharedBufferFromFile DISABLED_CreateSharedBufferFromFile
+#else
+#define MAYBE_CreateSharedBufferFromFile CreateSharedBufferFromFile
+#endif  // defined(OS_ANDROID)
+TEST_F(EmbedderTest, MAYBE_CreateSharedBufferFromFile) {
+  static const char kContents[] = "hello from a file";
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.path().Append("file");
+  ASSERT_EQ(static_cast<int>(sizeof(kContents)),
+            base::WriteFile(path, kContents, sizeof(kContents)));
+
+  // The size must match that of the file.
+  MojoHandle h = MOJO_HANDLE_INVALID;
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            CreateSharedBufferFromFile(OpenReadOnly(path),
+                                       sizeof(kContents) + 1, &h));
+  EXPECT_EQ(MOJO_RESULT_INVALID_ARGUMENT,
+            CreateSharedBufferFromFile(OpenReadOnly(path), 0u, &h));
+
+  ASSERT_EQ(MOJO_RESULT_OK,
+            CreateSharedBufferFromFile(OpenReadOnly(path), sizeof(kContents),
+                                       &h));
+  ScopedSharedBufferHandle buffer((SharedBufferHandle(h)));
+
+  void* pointer = nullptr;
+  ASSERT_EQ(MOJO_RESULT_OK, MapBuffer(buffer.get(), 0u, sizeof(kContents),
+                                      &pointer, MOJO_MAP_BUFFER_FLAG_NONE));
+  EXPECT_STREQ(kContents, static_cast<const char*>(pointer));
+
+  // The file was opened read-only, so the mapping is copy-on-write: writing to
+  // it mustn't change the file.
+  static_cast<char*>(pointer)[0] = 'j';
+  EXPECT_EQ('j', static_cast<const char*>(pointer)[0]);
+  EXPECT_EQ(MOJO_RESULT_OK, UnmapBuffer(pointer));
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(path, &contents));
+  EXPECT_EQ(std::string(kContents, sizeof(kContents)), contents);
+}
+
 }  // namespace
 }  // namespace embedder
 }  // namespace mojo
@@ -0,0 +1,44 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_EDK_EMBEDDER_MEMORY_USAGE_DUMP_H_
+#define MOJO_EDK_EMBEDDER_MEMORY_USAGE_DUMP_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+namespace embedder {
+
+// An interface for receiving the memory used by the system implementation's
+// internal structures (see |DumpMemoryUsage()| and
+// |DumpIPCMemoryUsageOnIOThread()|), so that embedders may forward it to their
+// memory instrumentation.
+class MemoryUsageDump {
+ public:
+  // Called for each structure, named by a "/"-separated path (e.g.,
+  // "message_pipes/handle_12"). Each name is reported at most once per dump.
+  // The memory reported for a name includes that reported for the names below
+  // it (e.g., "message_pipes" is the total for all message pipes).
+  // |num_objects| is the number of objects (e.g., messages or handles) making
+  // up |num_bytes|.
+  virtual void AddUsage(const std::string& name,
+                        size_t num_objects,
+                        size_t num_bytes) = 0;
+
+ protected:
+  MemoryUsageDump() {}
+  virtual ~MemoryUsageDump() {}
+
+ private:
+  MOJO_DISALLOW_COPY_AND_ASSIGN(MemoryUsageDump);
+};
+
+}  // namespace embedder
+}  // namespace mojo
+
+#endif  // MOJO_EDK_EMBEDDER_MEMORY_USAGE_DUMP_H_
@@ -102,6 +102,14 @@ void ShutdownIPCSupport() {
   });
 }
 
+void DumpIPCMemoryUsageOnIOThread(MemoryUsageDump* dump) {
+  if (!internal::g_ipc_support)
+    return;
+  DCHECK(internal::g_ipc_support->io_task_runner()->RunsTasksOnCurrentThread());
+
+  internal::g_ipc_support->channel_manager()->DumpMemoryUsage(dump);
+}
+
 ScopedMessagePipeHandle ConnectToSlave(
     SlaveInfo slave_info,
     ScopedPlatformHandle platform_handle,
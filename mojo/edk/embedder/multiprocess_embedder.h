@@ -23,6 +23,7 @@ class PlatformHandleWatcher;
 
 namespace embedder {
 
+class MemoryUsageDump;
 class ProcessDelegate;
 
 // Initialialization/shutdown for interprocess communication (IPC) -------------
@@ -65,6 +66,12 @@ void ShutdownIPCSupportOnIOThread();
 // |OnShutdownComplete()|.
 void ShutdownIPCSupport();
 
+// Reports the memory held by the read and write buffers of each channel to
+// |dump| (see memory_usage_dump.h). This must be called on the I/O thread
+// (given to |InitIPCSupport()|), so that it can't race with shutdown; it does
+// nothing if IPC support isn't initialized (or has been shut down).
+void DumpIPCMemoryUsageOnIOThread(MemoryUsageDump* dump);
+
 // Interprocess communication (IPC) functions ----------------------------------
 
 // Called in the master process to connect to a slave process to the IPC system.
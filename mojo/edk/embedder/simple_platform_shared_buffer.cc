@@ -4,6 +4,8 @@
 
 #include "mojo/edk/embedder/simple_platform_shared_buffer.h"
 
+#include <errno.h>
+#include <fcntl.h>  // For |fcntl()|.
 #include <stdint.h>
 #include <stdio.h>     // For |fileno()|.
 #include <sys/mman.h>  // For |mmap()|/|munmap()|.
@@ -38,6 +40,16 @@ static_assert(sizeof(off_t) <= sizeof(uint64_t), "off_t too big");
 namespace mojo {
 namespace embedder {
 
+namespace {
+
+bool IsOpenForReadingOnly(int fd) {
+  // Note: |fcntl()| with |F_GETFL| is not interruptible.
+  int flags = fcntl(fd, F_GETFL);
+  return flags != -1 && (flags & O_ACCMODE) == O_RDONLY;
+}
+
+}  // namespace
+
 // SimplePlatformSharedBuffer --------------------------------------------------
 
 // static
@@ -107,6 +119,16 @@ SimplePlatformSharedBuffer::MapNoCheck(size_t offset, size_t length) {
   void* real_base =
       mmap(nullptr, real_length, PROT_READ | PROT_WRITE, MAP_SHARED,
            handle_.get().fd, static_cast<off_t>(real_offset));
+  // If the buffer was created from a file that's only open for reading (see
+  // |embedder::CreateSharedBufferFromFile()|), fall back to a private
+  // (copy-on-write) mapping, so that writes to it never reach the file. Other
+  // buffers must be mapped shared, or writes to one mapping wouldn't be seen
+  // through the others, so they just fail.
+  if (real_base == MAP_FAILED && errno == EACCES &&
+      IsOpenForReadingOnly(handle_.get().fd)) {
+    real_base = mmap(nullptr, real_length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                     handle_.get().fd, static_cast<off_t>(real_offset));
+  }
   // |mmap()| should return |MAP_FAILED| (a.k.a. -1) on error. But it shouldn't
   // return null either.
   if (real_base == MAP_FAILED || !real_base) {
@@ -149,6 +149,20 @@ bool Channel::IsWriteBufferEmpty() {
   return raw_channel_->IsWriteBufferEmpty();
 }
 
+void Channel::GetMemoryUsage(size_t* read_buffer_num_bytes,
+                             size_t* num_write_buffer_messages,
+                             size_t* write_buffer_num_bytes) {
+  MutexLocker locker(&mutex_);
+  if (!is_running_) {
+    *read_buffer_num_bytes = 0;
+    *num_write_buffer_messages = 0;
+    *write_buffer_num_bytes = 0;
+    return;
+  }
+  raw_channel_->GetMemoryUsage(read_buffer_num_bytes, num_write_buffer_messages,
+                               write_buffer_num_bytes);
+}
+
 void Channel::DetachEndpoint(ChannelEndpoint* endpoint,
                              ChannelEndpointId local_id,
                              ChannelEndpointId remote_id) {
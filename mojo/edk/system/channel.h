@@ -109,6 +109,12 @@ class Channel final : public util::RefCountedThreadSafe<Channel>,
   // |FlushWriteBufferAndShutdown()| or something like that.
   bool IsWriteBufferEmpty();
 
+  // See |RawChannel::GetMemoryUsage()|. (This reports nothing if the channel
+  // isn't running.)
+  void GetMemoryUsage(size_t* read_buffer_num_bytes,
+                      size_t* num_write_buffer_messages,
+                      size_t* write_buffer_num_bytes);
+
   // Removes the given endpoint from this channel (|local_id| and |remote_id|
   // are specified as an optimization; the latter should be an invalid
   // |ChannelEndpointId| if the endpoint is not yet running). Note: If this is
@@ -4,12 +4,16 @@
 
 #include "mojo/edk/system/channel_manager.h"
 
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "mojo/edk/embedder/memory_usage_dump.h"
 #include "mojo/edk/platform/platform_handle.h"
 #include "mojo/edk/system/channel.h"
 #include "mojo/edk/system/channel_endpoint.h"
 #include "mojo/edk/system/message_pipe_dispatcher.h"
+#include "mojo/edk/util/string_printf.h"
 
 using mojo::platform::PlatformHandle;
 using mojo::platform::PlatformHandleWatcher;
@@ -18,6 +22,7 @@ using mojo::platform::TaskRunner;
 using mojo::util::MakeRefCounted;
 using mojo::util::MutexLocker;
 using mojo::util::RefPtr;
+using mojo::util::StringPrintf;
 
 namespace mojo {
 namespace system {
@@ -166,6 +171,38 @@ void ChannelManager::ShutdownChannel(
       });
 }
 
+void ChannelManager::DumpMemoryUsage(embedder::MemoryUsageDump* dump) const {
+  DCHECK(dump);
+
+  // |Channel| methods may not be called under |mutex_|.
+  std::vector<std::pair<ChannelId, RefPtr<Channel>>> channels;
+  {
+    MutexLocker locker(&mutex_);
+    channels.assign(channels_.begin(), channels_.end());
+  }
+
+  size_t total_num_objects = 0;
+  size_t total_num_bytes = 0;
+  for (const auto& entry : channels) {
+    size_t read_buffer_num_bytes = 0;
+    size_t num_write_buffer_messages = 0;
+    size_t write_buffer_num_bytes = 0;
+    entry.second->GetMemoryUsage(&read_buffer_num_bytes,
+                                 &num_write_buffer_messages,
+                                 &write_buffer_num_bytes);
+    std::string name = StringPrintf(
+        "channels/channel_%llu", static_cast<unsigned long long>(entry.first));
+    dump->AddUsage(name + "/read_buffer", read_buffer_num_bytes ? 1u : 0u,
+                   read_buffer_num_bytes);
+    dump->AddUsage(name + "/write_buffer", num_write_buffer_messages,
+                   write_buffer_num_bytes);
+    total_num_objects +=
+        (read_buffer_num_bytes ? 1u : 0u) + num_write_buffer_messages;
+    total_num_bytes += read_buffer_num_bytes + write_buffer_num_bytes;
+  }
+  dump->AddUsage("channels", total_num_objects, total_num_bytes);
+}
+
 RefPtr<Channel> ChannelManager::CreateChannelOnIOThreadHelper(
     ChannelId channel_id,
     ScopedPlatformHandle platform_handle,
@@ -25,6 +25,7 @@ class TaskRunner;
 namespace mojo {
 
 namespace embedder {
+class MemoryUsageDump;
 class PlatformSupport;
 }
 
@@ -125,6 +126,12 @@ class ChannelManager {
       std::function<void()>&& callback,
       util::RefPtr<platform::TaskRunner>&& callback_thread_task_runner);
 
+  // Reports the memory held by the channels' read and write buffers to |dump|,
+  // as "channels/channel_<id>/{read,write}_buffer" (see
+  // |embedder::DumpIPCMemoryUsageOnIOThread()|). This may be called from any
+  // thread.
+  void DumpMemoryUsage(embedder::MemoryUsageDump* dump) const;
+
   ConnectionManager* connection_manager() const { return connection_manager_; }
 
  private:
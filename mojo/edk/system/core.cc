@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/logging.h"
+#include "mojo/edk/embedder/memory_usage_dump.h"
 #include "mojo/edk/embedder/platform_shared_buffer.h"
 #include "mojo/edk/embedder/platform_support.h"
 #include "mojo/edk/system/async_waiter.h"
@@ -23,6 +24,7 @@
 #include "mojo/edk/system/message_pipe_dispatcher.h"
 #include "mojo/edk/system/shared_buffer_dispatcher.h"
 #include "mojo/edk/system/waiter.h"
+#include "mojo/edk/util/string_printf.h"
 #include "mojo/public/c/system/macros.h"
 #include "mojo/public/cpp/system/macros.h"
 
@@ -123,6 +125,63 @@ MojoResult Core::AsyncWait(MojoHandle handle,
   return rv;
 }
 
+void Core::DumpMemoryUsage(embedder::MemoryUsageDump* dump) {
+  DCHECK(dump);
+
+  std::vector<std::pair<MojoHandle, RefPtr<Dispatcher>>> dispatchers;
+  {
+    MutexLocker locker(&handle_table_mutex_);
+    dump->AddUsage("handles", handle_table_.num_handles(),
+                   handle_table_.EstimateNumBytes());
+    handle_table_.GetAllDispatchers(&dispatchers);
+  }
+
+  // Only handles that hold on to something get their own entry, so that the
+  // (common) idle ones don't bloat the dump.
+  size_t message_pipe_num_objects = 0;
+  size_t message_pipe_num_bytes = 0;
+  size_t data_pipe_num_objects = 0;
+  size_t data_pipe_num_bytes = 0;
+  for (const auto& entry : dispatchers) {
+    const char* name;
+    size_t* total_num_objects;
+    size_t* total_num_bytes;
+    switch (entry.second->GetType()) {
+      case Dispatcher::Type::MESSAGE_PIPE:
+        name = "message_pipes";
+        total_num_objects = &message_pipe_num_objects;
+        total_num_bytes = &message_pipe_num_bytes;
+        break;
+      case Dispatcher::Type::DATA_PIPE_PRODUCER:
+      case Dispatcher::Type::DATA_PIPE_CONSUMER:
+        name = "data_pipes";
+        total_num_objects = &data_pipe_num_objects;
+        total_num_bytes = &data_pipe_num_bytes;
+        break;
+      default:
+        continue;
+    }
+
+    size_t num_objects = 0;
+    size_t num_bytes = 0;
+    entry.second->GetMemoryUsage(&num_objects, &num_bytes);
+    if (!num_bytes)
+      continue;
+    dump->AddUsage(util::StringPrintf("%s/handle_%u", name,
+                                      static_cast<unsigned>(entry.first)),
+                   num_objects, num_bytes);
+    *total_num_objects += num_objects;
+    *total_num_bytes += num_bytes;
+  }
+  dump->AddUsage("message_pipes", message_pipe_num_objects,
+                 message_pipe_num_bytes);
+  dump->AddUsage("data_pipes", data_pipe_num_objects, data_pipe_num_bytes);
+
+  MutexLocker locker(&mapping_table_mutex_);
+  dump->AddUsage("mapped_buffers", mapping_table_.num_mappings(),
+                 mapping_table_.mapped_num_bytes());
+}
+
 MojoTimeTicks Core::GetTimeTicksNow() {
   return platform_support_->GetTimeTicksNow();
 }
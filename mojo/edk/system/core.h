@@ -24,6 +24,7 @@
 namespace mojo {
 
 namespace embedder {
+class MemoryUsageDump;
 class PlatformSupport;
 }
 
@@ -73,6 +74,12 @@ class Core {
     return platform_support_;
   }
 
+  // Reports the memory used by the handle table, message pipe queues, data
+  // pipe buffers and buffer mappings to |dump| (see
+  // |embedder::DumpMemoryUsage()|). This takes references to all the
+  // dispatchers under the handle table lock, then looks at them one at a time.
+  void DumpMemoryUsage(embedder::MemoryUsageDump* dump);
+
   // ---------------------------------------------------------------------------
 
   // The following methods are essentially implementations of the Mojo Core
@@ -7,10 +7,14 @@
 #include <stdint.h>
 
 #include <limits>
+#include <map>
+#include <string>
 
+#include "mojo/edk/embedder/memory_usage_dump.h"
 #include "mojo/edk/system/awakable.h"
 #include "mojo/edk/system/core_test_base.h"
 #include "mojo/edk/system/test/sleep.h"
+#include "mojo/edk/util/string_printf.h"
 #include "mojo/public/cpp/system/macros.h"
 
 namespace mojo {
@@ -1311,6 +1315,120 @@ TEST_F(CoreTest, AsyncWait) {
 
 // TODO(vtl): Test |DuplicateBufferHandle()| and |MapBuffer()|.
 
+class TestMemoryUsageDump : public embedder::MemoryUsageDump {
+ public:
+  struct Usage {
+    size_t num_objects;
+    size_t num_bytes;
+  };
+
+  TestMemoryUsageDump() {}
+  ~TestMemoryUsageDump() override {}
+
+  // |embedder::MemoryUsageDump| implementation:
+  void AddUsage(const std::string& name,
+                size_t num_objects,
+                size_t num_bytes) override {
+    EXPECT_TRUE(usages_.find(name) == usages_.end()) << name;
+    Usage& usage = usages_[name];
+    usage.num_objects = num_objects;
+    usage.num_bytes = num_bytes;
+  }
+
+  const std::map<std::string, Usage>& usages() const { return usages_; }
+
+ private:
+  std::map<std::string, Usage> usages_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(TestMemoryUsageDump);
+};
+
+TEST_F(CoreTest, DumpMemoryUsage) {
+  MojoHandle h[2];
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateMessagePipe(NullUserPointer(), MakeUserPointer(&h[0]),
+                                      MakeUserPointer(&h[1])));
+  // Nothing is queued yet, so the message pipe doesn't get its own entry.
+  {
+    TestMemoryUsageDump dump;
+    core()->DumpMemoryUsage(&dump);
+    ASSERT_EQ(1u, dump.usages().count("handles"));
+    EXPECT_EQ(2u, dump.usages().at("handles").num_objects);
+    EXPECT_GT(dump.usages().at("handles").num_bytes, 0u);
+    ASSERT_EQ(1u, dump.usages().count("message_pipes"));
+    EXPECT_EQ(0u, dump.usages().at("message_pipes").num_bytes);
+    EXPECT_EQ(0u, dump.usages().at("data_pipes").num_bytes);
+    EXPECT_EQ(0u, dump.usages().at("mapped_buffers").num_bytes);
+    EXPECT_EQ(4u, dump.usages().size());
+  }
+
+  // Queue two messages for |h[1]|.
+  const char kHello[] = "hello";
+  for (size_t i = 0; i < 2; i++) {
+    EXPECT_EQ(MOJO_RESULT_OK,
+              core()->WriteMessage(h[0], UserPointer<const void>(kHello),
+                                   sizeof(kHello), NullUserPointer(), 0,
+                                   MOJO_WRITE_MESSAGE_FLAG_NONE));
+  }
+
+  // Create a data pipe, with some data in it.
+  const MojoCreateDataPipeOptions options = {
+      static_cast<uint32_t>(sizeof(MojoCreateDataPipeOptions)),
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE, 1u, 1000u};
+  MojoHandle ph, ch;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->CreateDataPipe(MakeUserPointer(&options),
+                                   MakeUserPointer(&ph), MakeUserPointer(&ch)));
+  uint32_t num_bytes = 2u;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->WriteData(ph, UserPointer<const void>(kHello),
+                              MakeUserPointer(&num_bytes),
+                              MOJO_WRITE_DATA_FLAG_NONE));
+
+  // And map a shared buffer.
+  MojoHandle bh = MOJO_HANDLE_INVALID;
+  EXPECT_EQ(MOJO_RESULT_OK, core()->CreateSharedBuffer(NullUserPointer(), 100u,
+                                                       MakeUserPointer(&bh)));
+  void* address = nullptr;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            core()->MapBuffer(bh, 0u, 100u, MakeUserPointer(&address),
+                              MOJO_MAP_BUFFER_FLAG_NONE));
+
+  {
+    TestMemoryUsageDump dump;
+    core()->DumpMemoryUsage(&dump);
+    EXPECT_EQ(5u, dump.usages().at("handles").num_objects);
+
+    std::string pipe_name = util::StringPrintf(
+        "message_pipes/handle_%u", static_cast<unsigned>(h[1]));
+    ASSERT_EQ(1u, dump.usages().count(pipe_name));
+    EXPECT_EQ(2u, dump.usages().at(pipe_name).num_objects);
+    EXPECT_GE(dump.usages().at(pipe_name).num_bytes, 2u * sizeof(kHello));
+    EXPECT_EQ(2u, dump.usages().at("message_pipes").num_objects);
+    EXPECT_EQ(dump.usages().at(pipe_name).num_bytes,
+              dump.usages().at("message_pipes").num_bytes);
+
+    // The data pipe's buffer is only reported once, by the consumer.
+    std::string data_pipe_name = util::StringPrintf(
+        "data_pipes/handle_%u", static_cast<unsigned>(ch));
+    ASSERT_EQ(1u, dump.usages().count(data_pipe_name));
+    EXPECT_EQ(1000u, dump.usages().at(data_pipe_name).num_bytes);
+    EXPECT_EQ(1000u, dump.usages().at("data_pipes").num_bytes);
+
+    EXPECT_EQ(1u, dump.usages().at("mapped_buffers").num_objects);
+    EXPECT_EQ(100u, dump.usages().at("mapped_buffers").num_bytes);
+
+    EXPECT_EQ(6u, dump.usages().size());
+  }
+
+  EXPECT_EQ(MOJO_RESULT_OK, core()->UnmapBuffer(MakeUserPointer(address)));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(bh));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(ph));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(ch));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[0]));
+  EXPECT_EQ(MOJO_RESULT_OK, core()->Close(h[1]));
+}
+
 }  // namespace
 }  // namespace system
 }  // namespace mojo
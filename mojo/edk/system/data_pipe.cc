@@ -447,6 +447,19 @@ bool DataPipe::ProducerIsBusy() const {
   return producer_in_two_phase_write_no_lock();
 }
 
+void DataPipe::ProducerGetMemoryUsage(size_t* num_objects,
+                                      size_t* num_bytes) const {
+  MutexLocker locker(&mutex_);
+  DCHECK(has_local_producer_no_lock());
+  if (has_local_consumer_no_lock()) {
+    *num_objects = 0;
+    *num_bytes = 0;
+    return;
+  }
+  *num_bytes = impl_->GetBufferNumBytes();
+  *num_objects = *num_bytes ? 1 : 0;
+}
+
 void DataPipe::ConsumerCancelAllAwakables() {
   MutexLocker locker(&mutex_);
   DCHECK(has_local_consumer_no_lock());
@@ -655,6 +668,14 @@ bool DataPipe::ConsumerIsBusy() const {
   return consumer_in_two_phase_read_no_lock();
 }
 
+void DataPipe::ConsumerGetMemoryUsage(size_t* num_objects,
+                                      size_t* num_bytes) const {
+  MutexLocker locker(&mutex_);
+  DCHECK(has_local_consumer_no_lock());
+  *num_bytes = impl_->GetBufferNumBytes();
+  *num_objects = *num_bytes ? 1 : 0;
+}
+
 DataPipe::DataPipe(bool has_local_producer,
                    bool has_local_consumer,
                    const MojoCreateDataPipeOptions& validated_options,
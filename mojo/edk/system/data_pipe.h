@@ -126,6 +126,9 @@ class DataPipe final : public ChannelEndpointClient {
       size_t* actual_size,
       std::vector<platform::ScopedPlatformHandle>* platform_handles);
   bool ProducerIsBusy() const;
+  // The buffer is reported by the consumer if it's local, else by the producer
+  // (so that it's only counted once).
+  void ProducerGetMemoryUsage(size_t* num_objects, size_t* num_bytes) const;
 
   // These are called by the consumer dispatcher to implement its methods of
   // corresponding names.
@@ -159,6 +162,7 @@ class DataPipe final : public ChannelEndpointClient {
       size_t* actual_size,
       std::vector<platform::ScopedPlatformHandle>* platform_handles);
   bool ConsumerIsBusy() const;
+  void ConsumerGetMemoryUsage(size_t* num_objects, size_t* num_bytes) const;
 
   // The following are only to be used by |DataPipeImpl| (and its subclasses):
 
@@ -150,6 +150,13 @@ void DataPipeConsumerDispatcher::RemoveAwakableImplNoLock(
   data_pipe_->ConsumerRemoveAwakable(awakable, signals_state);
 }
 
+void DataPipeConsumerDispatcher::GetMemoryUsageImplNoLock(
+    size_t* num_objects,
+    size_t* num_bytes) const {
+  mutex().AssertHeld();
+  data_pipe_->ConsumerGetMemoryUsage(num_objects, num_bytes);
+}
+
 void DataPipeConsumerDispatcher::StartSerializeImplNoLock(
     Channel* channel,
     size_t* max_size,
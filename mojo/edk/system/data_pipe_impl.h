@@ -108,6 +108,9 @@ class DataPipeImpl {
   virtual bool OnReadMessage(unsigned port, MessageInTransit* message) = 0;
   virtual void OnDetachFromChannel(unsigned port) = 0;
 
+  // Returns the size of the buffer currently allocated (if any).
+  virtual size_t GetBufferNumBytes() const = 0;
+
  protected:
   DataPipeImpl() : owner_() {}
 
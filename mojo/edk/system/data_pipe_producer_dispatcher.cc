@@ -126,6 +126,13 @@ void DataPipeProducerDispatcher::RemoveAwakableImplNoLock(
   data_pipe_->ProducerRemoveAwakable(awakable, signals_state);
 }
 
+void DataPipeProducerDispatcher::GetMemoryUsageImplNoLock(
+    size_t* num_objects,
+    size_t* num_bytes) const {
+  mutex().AssertHeld();
+  data_pipe_->ProducerGetMemoryUsage(num_objects, num_bytes);
+}
+
 void DataPipeProducerDispatcher::StartSerializeImplNoLock(
     Channel* channel,
     size_t* max_size,
@@ -61,6 +61,8 @@ class DataPipeProducerDispatcher final : public Dispatcher {
                                    HandleSignalsState* signals_state) override;
   void RemoveAwakableImplNoLock(Awakable* awakable,
                                 HandleSignalsState* signals_state) override;
+  void GetMemoryUsageImplNoLock(size_t* num_objects,
+                                size_t* num_bytes) const override;
   void StartSerializeImplNoLock(Channel* channel,
                                 size_t* max_size,
                                 size_t* max_platform_handles) override
@@ -251,6 +251,19 @@ void Dispatcher::RemoveAwakable(Awakable* awakable,
   RemoveAwakableImplNoLock(awakable, handle_signals_state);
 }
 
+void Dispatcher::GetMemoryUsage(size_t* num_objects, size_t* num_bytes) const {
+  DCHECK(num_objects);
+  DCHECK(num_bytes);
+
+  *num_objects = 0;
+  *num_bytes = 0;
+  MutexLocker locker(&mutex_);
+  if (is_closed_)
+    return;
+
+  GetMemoryUsageImplNoLock(num_objects, num_bytes);
+}
+
 Dispatcher::Dispatcher() : is_closed_(false) {
 }
 
@@ -400,6 +413,13 @@ void Dispatcher::RemoveAwakableImplNoLock(Awakable* /*awakable*/,
     *signals_state = HandleSignalsState();
 }
 
+void Dispatcher::GetMemoryUsageImplNoLock(size_t* /*num_objects*/,
+                                          size_t* /*num_bytes*/) const {
+  mutex_.AssertHeld();
+  DCHECK(!is_closed_);
+  // By default, nothing is reported. (The outputs are already zeroed.)
+}
+
 void Dispatcher::StartSerializeImplNoLock(Channel* /*channel*/,
                                           size_t* max_size,
                                           size_t* max_platform_handles) {
@@ -152,6 +152,12 @@ class Dispatcher : public util::RefCountedThreadSafe<Dispatcher> {
   // |*signals_state| will be set to the current handle signals state.
   void RemoveAwakable(Awakable* awakable, HandleSignalsState* signals_state);
 
+  // Gets the memory held on behalf of this handle, for memory dumps: e.g., the
+  // messages queued for reading from a message pipe, or a data pipe's buffer.
+  // |*num_objects| is the number of objects (e.g., messages) this is made up
+  // of. (The default implementation reports nothing.)
+  void GetMemoryUsage(size_t* num_objects, size_t* num_bytes) const;
+
   // A dispatcher must be put into a special state in order to be sent across a
   // message pipe. Outside of tests, only |HandleTableAccess| is allowed to do
   // this, since there are requirements on the handle table (see below).
@@ -281,6 +287,9 @@ class Dispatcher : public util::RefCountedThreadSafe<Dispatcher> {
   virtual void RemoveAwakableImplNoLock(Awakable* awakable,
                                         HandleSignalsState* signals_state)
       MOJO_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  virtual void GetMemoryUsageImplNoLock(size_t* num_objects,
+                                        size_t* num_bytes) const
+      MOJO_SHARED_LOCKS_REQUIRED(mutex_);
 
   // These implement the API used to serialize dispatchers to a |Channel|
   // (described below). They will only be called on a dispatcher that's attached
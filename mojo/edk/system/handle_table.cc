@@ -240,5 +240,22 @@ void HandleTable::RestoreBusyHandles(const MojoHandle* handles,
   }
 }
 
+size_t HandleTable::EstimateNumBytes() const {
+  // Each entry is a node holding the key/value pair and a "next" pointer, and
+  // there's a pointer per bucket.
+  return handle_to_entry_map_.size() *
+             (sizeof(HandleToEntryMap::value_type) + sizeof(void*)) +
+         handle_to_entry_map_.bucket_count() * sizeof(void*);
+}
+
+void HandleTable::GetAllDispatchers(
+    std::vector<std::pair<MojoHandle, RefPtr<Dispatcher>>>* dispatchers)
+    const {
+  DCHECK(dispatchers);
+  dispatchers->reserve(dispatchers->size() + handle_to_entry_map_.size());
+  for (const auto& entry : handle_to_entry_map_)
+    dispatchers->emplace_back(entry.first, entry.second.dispatcher);
+}
+
 }  // namespace system
 }  // namespace mojo
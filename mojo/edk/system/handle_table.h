@@ -5,6 +5,8 @@
 #ifndef MOJO_EDK_SYSTEM_HANDLE_TABLE_H_
 #define MOJO_EDK_SYSTEM_HANDLE_TABLE_H_
 
+#include <stddef.h>
+
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -96,6 +98,16 @@ class HandleTable {
   // state.
   void RestoreBusyHandles(const MojoHandle* handles, uint32_t num_handles);
 
+  // For memory dumps:
+  size_t num_handles() const { return handle_to_entry_map_.size(); }
+  // Estimates the memory used by the table itself (excluding the dispatchers).
+  size_t EstimateNumBytes() const;
+  // Gets all the handles with their dispatchers (taking references, so that
+  // they may be used outside |Core|'s lock).
+  void GetAllDispatchers(
+      std::vector<std::pair<MojoHandle, util::RefPtr<Dispatcher>>>*
+          dispatchers) const;
+
  private:
   friend bool internal::ShutdownCheckNoLeaks(Core*);
 
@@ -392,6 +392,10 @@ void LocalDataPipeImpl::OnDetachFromChannel(unsigned /*port*/) {
   NOTREACHED();
 }
 
+size_t LocalDataPipeImpl::GetBufferNumBytes() const {
+  return buffer_ ? capacity_num_bytes() : 0;
+}
+
 void LocalDataPipeImpl::EnsureBuffer() {
   DCHECK(producer_open());
   if (buffer_)
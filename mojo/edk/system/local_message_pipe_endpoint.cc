@@ -181,5 +181,11 @@ void LocalMessagePipeEndpoint::RemoveAwakable(
     *signals_state = GetHandleSignalsState();
 }
 
+void LocalMessagePipeEndpoint::GetMemoryUsage(size_t* num_objects,
+                                              size_t* num_bytes) const {
+  *num_objects = message_queue_.Size();
+  *num_bytes = message_queue_.NumBytes();
+}
+
 }  // namespace system
 }  // namespace mojo
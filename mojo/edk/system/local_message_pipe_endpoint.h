@@ -43,6 +43,7 @@ class LocalMessagePipeEndpoint final : public MessagePipeEndpoint {
                          HandleSignalsState* signals_state) override;
   void RemoveAwakable(Awakable* awakable,
                       HandleSignalsState* signals_state) override;
+  void GetMemoryUsage(size_t* num_objects, size_t* num_bytes) const override;
 
   // This is only to be used by |MessagePipe|:
   MessageInTransitQueue* message_queue() { return &message_queue_; }
@@ -11,7 +11,7 @@
 namespace mojo {
 namespace system {
 
-MappingTable::MappingTable() {
+MappingTable::MappingTable() : mapped_num_bytes_(0) {
 }
 
 MappingTable::~MappingTable() {
@@ -30,6 +30,7 @@ MojoResult MappingTable::AddMapping(
   uintptr_t address = reinterpret_cast<uintptr_t>(mapping->GetBase());
   DCHECK(address_to_mapping_map_.find(address) ==
          address_to_mapping_map_.end());
+  mapped_num_bytes_ += mapping->GetLength();
   address_to_mapping_map_[address] = mapping.release();
   return MOJO_RESULT_OK;
 }
@@ -40,6 +41,7 @@ MojoResult MappingTable::RemoveMapping(uintptr_t address) {
     return MOJO_RESULT_INVALID_ARGUMENT;
   embedder::PlatformSharedBufferMapping* mapping_to_delete = it->second;
   address_to_mapping_map_.erase(it);
+  mapped_num_bytes_ -= mapping_to_delete->GetLength();
   delete mapping_to_delete;
   return MOJO_RESULT_OK;
 }
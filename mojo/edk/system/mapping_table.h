@@ -5,6 +5,7 @@
 #ifndef MOJO_EDK_SYSTEM_MAPPING_TABLE_H_
 #define MOJO_EDK_SYSTEM_MAPPING_TABLE_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <memory>
@@ -45,6 +46,10 @@ class MappingTable {
       std::unique_ptr<embedder::PlatformSharedBufferMapping> mapping);
   MojoResult RemoveMapping(uintptr_t address);
 
+  size_t num_mappings() const { return address_to_mapping_map_.size(); }
+  // Total length of the mappings (this is kept up to date).
+  size_t mapped_num_bytes() const { return mapped_num_bytes_; }
+
  private:
   friend bool internal::ShutdownCheckNoLeaks(Core*);
 
@@ -52,6 +57,7 @@ class MappingTable {
   using AddressToMappingMap =
       std::unordered_map<uintptr_t, embedder::PlatformSharedBufferMapping*>;
   AddressToMappingMap address_to_mapping_map_;
+  size_t mapped_num_bytes_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(MappingTable);
 };
@@ -4,12 +4,14 @@
 
 #include "mojo/edk/system/message_in_transit_queue.h"
 
+#include <utility>
+
 #include "base/logging.h"
 
 namespace mojo {
 namespace system {
 
-MessageInTransitQueue::MessageInTransitQueue() {
+MessageInTransitQueue::MessageInTransitQueue() : num_bytes_(0) {
 }
 
 MessageInTransitQueue::~MessageInTransitQueue() {
@@ -23,10 +25,12 @@ void MessageInTransitQueue::Clear() {
   for (auto* message : queue_)
     delete message;
   queue_.clear();
+  num_bytes_ = 0;
 }
 
 void MessageInTransitQueue::Swap(MessageInTransitQueue* other) {
   queue_.swap(other->queue_);
+  std::swap(num_bytes_, other->num_bytes_);
 }
 
 }  // namespace system
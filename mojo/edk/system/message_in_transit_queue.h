@@ -23,14 +23,19 @@ class MessageInTransitQueue {
 
   bool IsEmpty() const { return queue_.empty(); }
   size_t Size() const { return queue_.size(); }
+  // Returns the total size (see |MessageInTransit::total_size()|) of the queued
+  // messages. This is kept up to date, so it's cheap (e.g., for memory dumps).
+  size_t NumBytes() const { return num_bytes_; }
 
   void AddMessage(std::unique_ptr<MessageInTransit> message) {
+    num_bytes_ += message->total_size();
     queue_.push_back(message.release());
   }
 
   std::unique_ptr<MessageInTransit> GetMessage() {
     MessageInTransit* rv = queue_.front();
     queue_.pop_front();
+    num_bytes_ -= rv->total_size();
     return std::unique_ptr<MessageInTransit>(rv);
   }
 
@@ -38,6 +43,7 @@ class MessageInTransitQueue {
   MessageInTransit* PeekMessage() { return queue_.front(); }
 
   void DiscardMessage() {
+    num_bytes_ -= queue_.front()->total_size();
     delete queue_.front();
     queue_.pop_front();
   }
@@ -51,6 +57,7 @@ class MessageInTransitQueue {
   // TODO(vtl): When C++11 is available, switch this to a deque of
   // |unique_ptr|s.
   std::deque<MessageInTransit*> queue_;
+  size_t num_bytes_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(MessageInTransitQueue);
 };
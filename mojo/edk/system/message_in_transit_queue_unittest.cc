@@ -86,6 +86,30 @@ TEST(MessageInTransitQueueTest, Swap) {
   EXPECT_TRUE(queue1.IsEmpty());
 }
 
+TEST(MessageInTransitQueueTest, NumBytes) {
+  const size_t message_size = test::MakeTestMessage(0)->total_size();
+
+  MessageInTransitQueue queue1;
+  EXPECT_EQ(0u, queue1.NumBytes());
+  queue1.AddMessage(test::MakeTestMessage(1));
+  queue1.AddMessage(test::MakeTestMessage(2));
+  queue1.AddMessage(test::MakeTestMessage(3));
+  EXPECT_EQ(3u * message_size, queue1.NumBytes());
+
+  queue1.DiscardMessage();
+  EXPECT_EQ(2u * message_size, queue1.NumBytes());
+  queue1.GetMessage();
+  EXPECT_EQ(message_size, queue1.NumBytes());
+
+  MessageInTransitQueue queue2;
+  queue1.Swap(&queue2);
+  EXPECT_EQ(0u, queue1.NumBytes());
+  EXPECT_EQ(message_size, queue2.NumBytes());
+
+  queue2.Clear();
+  EXPECT_EQ(0u, queue2.NumBytes());
+}
+
 }  // namespace
 }  // namespace system
 }  // namespace mojo
@@ -217,6 +217,17 @@ void MessagePipe::RemoveAwakable(unsigned port,
   endpoints_[port]->RemoveAwakable(awakable, signals_state);
 }
 
+void MessagePipe::GetMemoryUsage(unsigned port,
+                                 size_t* num_objects,
+                                 size_t* num_bytes) const {
+  DCHECK(port == 0 || port == 1);
+
+  MutexLocker locker(&mutex_);
+  DCHECK(endpoints_[port]);
+
+  endpoints_[port]->GetMemoryUsage(num_objects, num_bytes);
+}
+
 void MessagePipe::StartSerialize(unsigned /*port*/,
                                  Channel* channel,
                                  size_t* max_size,
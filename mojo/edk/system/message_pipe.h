@@ -105,6 +105,9 @@ class MessagePipe final : public ChannelEndpointClient {
   void RemoveAwakable(unsigned port,
                       Awakable* awakable,
                       HandleSignalsState* signals_state);
+  void GetMemoryUsage(unsigned port,
+                      size_t* num_objects,
+                      size_t* num_bytes) const;
   void StartSerialize(unsigned port,
                       Channel* channel,
                       size_t* max_size,
@@ -192,6 +192,12 @@ void MessagePipeDispatcher::RemoveAwakableImplNoLock(
   message_pipe_->RemoveAwakable(port_, awakable, signals_state);
 }
 
+void MessagePipeDispatcher::GetMemoryUsageImplNoLock(size_t* num_objects,
+                                                     size_t* num_bytes) const {
+  mutex().AssertHeld();
+  message_pipe_->GetMemoryUsage(port_, num_objects, num_bytes);
+}
+
 void MessagePipeDispatcher::StartSerializeImplNoLock(
     Channel* channel,
     size_t* max_size,
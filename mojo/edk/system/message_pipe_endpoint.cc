@@ -44,6 +44,11 @@ void MessagePipeEndpoint::RemoveAwakable(Awakable* /*awakable*/,
     *signals_state = HandleSignalsState();
 }
 
+void MessagePipeEndpoint::GetMemoryUsage(size_t* /*num_objects*/,
+                                         size_t* /*num_bytes*/) const {
+  NOTREACHED();
+}
+
 void MessagePipeEndpoint::Attach(ChannelEndpoint* /*channel_endpoint*/) {
   NOTREACHED();
 }
@@ -69,6 +69,7 @@ class MessagePipeEndpoint {
                                  HandleSignalsState* signals_state);
   virtual void RemoveAwakable(Awakable* awakable,
                               HandleSignalsState* signals_state);
+  virtual void GetMemoryUsage(size_t* num_objects, size_t* num_bytes) const;
 
   // Implementations must override these if they represent a proxy endpoint. An
   // implementation for a local endpoint needs not override these methods, since
@@ -162,6 +162,7 @@ RawChannel::RawChannel()
       delegate_(nullptr),
       set_on_shutdown_(nullptr),
       write_stopped_(false),
+      read_buffer_num_bytes_(0),
       weak_ptr_factory_(this) {}
 
 RawChannel::~RawChannel() {
@@ -193,6 +194,7 @@ void RawChannel::Init(RefPtr<TaskRunner>&& io_task_runner,
   read_buffer_.reset(new ReadBuffer);
   DCHECK(!write_buffer_);
   write_buffer_.reset(new WriteBuffer(GetSerializedPlatformHandleSize()));
+  read_buffer_num_bytes_ = read_buffer_->buffer_.size();
 
   OnInit();
 
@@ -227,6 +229,7 @@ void RawChannel::Shutdown() {
   }
   write_stopped_ = true;
   weak_ptr_factory_.InvalidateWeakPtrs();
+  read_buffer_num_bytes_ = 0;
 
   OnShutdownNoLock(std::move(read_buffer_), std::move(write_buffer_));
 }
@@ -275,6 +278,21 @@ bool RawChannel::IsWriteBufferEmpty() {
   return write_buffer_->message_queue_.IsEmpty();
 }
 
+void RawChannel::GetMemoryUsage(size_t* read_buffer_num_bytes,
+                                size_t* num_write_buffer_messages,
+                                size_t* write_buffer_num_bytes) {
+  MutexLocker locker(&write_mutex_);
+  *read_buffer_num_bytes = read_buffer_num_bytes_;
+  if (!write_buffer_) {
+    // We've been shut down.
+    *num_write_buffer_messages = 0;
+    *write_buffer_num_bytes = 0;
+    return;
+  }
+  *num_write_buffer_messages = write_buffer_->message_queue_.Size();
+  *write_buffer_num_bytes = write_buffer_->message_queue_.NumBytes();
+}
+
 void RawChannel::OnReadCompleted(IOResult io_result, size_t bytes_read) {
   DCHECK(io_task_runner_->RunsTasksOnCurrentThread());
 
@@ -401,6 +419,9 @@ void RawChannel::OnReadCompleted(IOResult io_result, size_t bytes_read) {
 
       // TODO(vtl): It's suboptimal to zero out the fresh memory.
       read_buffer_->buffer_.resize(new_size, 0);
+
+      MutexLocker locker(&write_mutex_);
+      read_buffer_num_bytes_ = new_size;
     }
 
     // (1) If we dispatched any messages, stop reading for now (and let the
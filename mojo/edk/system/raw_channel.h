@@ -110,6 +110,12 @@ class RawChannel {
   // becomes empty (or something like that).
   bool IsWriteBufferEmpty();
 
+  // Gets the memory held by the read buffer and by the messages in the write
+  // buffer (i.e., not yet sent), for memory dumps. This method is thread-safe.
+  void GetMemoryUsage(size_t* read_buffer_num_bytes,
+                      size_t* num_write_buffer_messages,
+                      size_t* write_buffer_num_bytes);
+
   // Returns the amount of space needed in the |MessageInTransit|'s
   // |TransportData|'s "platform handle table" per platform handle (to be
   // attached to a message). (This amount may be zero.)
@@ -331,6 +337,10 @@ class RawChannel {
   util::Mutex write_mutex_;  // Protects the following members.
   bool write_stopped_ MOJO_GUARDED_BY(write_mutex_);
   std::unique_ptr<WriteBuffer> write_buffer_ MOJO_GUARDED_BY(write_mutex_);
+  // The size of |read_buffer_|'s buffer, for |GetMemoryUsage()| (the buffer
+  // itself may only be looked at on the I/O thread). |OnReadCompleted()| sets
+  // it, with |write_mutex_| held, each time it grows the buffer.
+  size_t read_buffer_num_bytes_ MOJO_GUARDED_BY(write_mutex_);
 
   // This is used for posting tasks from write threads to the I/O thread. The
   // weak pointers it produces are only used/invalidated on the I/O thread.
@@ -401,6 +401,10 @@ void RemoteConsumerDataPipeImpl::OnDetachFromChannel(unsigned /*port*/) {
   Disconnect();
 }
 
+size_t RemoteConsumerDataPipeImpl::GetBufferNumBytes() const {
+  return buffer_ ? capacity_num_bytes() : 0;
+}
+
 void RemoteConsumerDataPipeImpl::EnsureBuffer() {
   DCHECK(producer_open());
   if (buffer_)
@@ -395,6 +395,10 @@ void RemoteProducerDataPipeImpl::OnDetachFromChannel(unsigned /*port*/) {
   Disconnect();
 }
 
+size_t RemoteProducerDataPipeImpl::GetBufferNumBytes() const {
+  return buffer_ ? capacity_num_bytes() : 0;
+}
+
 void RemoteProducerDataPipeImpl::EnsureBuffer() {
   DCHECK(producer_open());
   if (buffer_)
@@ -88,6 +88,7 @@ class RemoteProducerDataPipeImpl final : public DataPipeImpl {
       std::vector<platform::ScopedPlatformHandle>* platform_handles) override;
   bool OnReadMessage(unsigned port, MessageInTransit* message) override;
   void OnDetachFromChannel(unsigned port) override;
+  size_t GetBufferNumBytes() const override;
 
   void EnsureBuffer();
   void DestroyBuffer();
@@ -50,6 +50,13 @@ class SharedBufferDispatcher final : public SimpleDispatcher {
       uint64_t num_bytes,
       MojoResult* result);
 
+  // Static factory method that wraps an existing |shared_buffer| (e.g., one
+  // created from a file by |PlatformSupport::CreateSharedBufferFromHandle()|).
+  static util::RefPtr<SharedBufferDispatcher> CreateFromPlatformSharedBuffer(
+      util::RefPtr<embedder::PlatformSharedBuffer>&& shared_buffer) {
+    return CreateInternal(std::move(shared_buffer));
+  }
+
   // |Dispatcher| public methods:
   Type GetType() const override;
 
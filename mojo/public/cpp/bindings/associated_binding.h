@@ -0,0 +1,164 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_BINDING_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_BINDING_H_
+
+#include <memory>
+
+#include "mojo/public/cpp/bindings/associated_group.h"
+#include "mojo/public/cpp/bindings/associated_interface_ptr_info.h"
+#include "mojo/public/cpp/bindings/associated_interface_request.h"
+#include "mojo/public/cpp/bindings/callback.h"
+#include "mojo/public/cpp/bindings/lib/filter_chain.h"
+#include "mojo/public/cpp/bindings/lib/interface_endpoint_client.h"
+#include "mojo/public/cpp/bindings/lib/scoped_interface_endpoint_handle.h"
+#include "mojo/public/cpp/environment/logging.h"
+
+namespace mojo {
+
+// Represents the implementation side of an associated interface. It is similar
+// to Binding, except that it doesn't own a message pipe handle: the interface
+// is served over the pipe of the interface that carried the request, and its
+// calls are dispatched in order with the calls made on that interface.
+//
+// Example:
+//
+//   // foo.mojom: interface Foo { GetBar(associated Bar& bar); };
+//
+//   class FooImpl : public Foo {
+//    public:
+//     void GetBar(AssociatedInterfaceRequest<Bar> bar) override {
+//       bar_binding_.Bind(bar.Pass());
+//     }
+//
+//    private:
+//     BarImpl bar_impl_;
+//     AssociatedBinding<Bar> bar_binding_{&bar_impl_};
+//   };
+template <typename Interface>
+class AssociatedBinding {
+ public:
+  // Constructs an incomplete associated binding that will use the
+  // implementation |impl|. It may be completed with a subsequent call to the
+  // |Bind| method. Does not take ownership of |impl|, which must outlive this
+  // object.
+  explicit AssociatedBinding(Interface* impl) : impl_(impl) {
+    stub_.set_sink(impl_);
+  }
+
+  // Constructs a completed associated binding of |impl|. The output |ptr_info|
+  // should be passed through the message pipe referred to by
+  // |associated_group| to set up the corresponding associated interface
+  // pointer on the other side. Does not take ownership of |impl|, which must
+  // outlive this object.
+  AssociatedBinding(Interface* impl,
+                    AssociatedInterfacePtrInfo<Interface>* ptr_info,
+                    const AssociatedGroup& associated_group)
+      : AssociatedBinding(impl) {
+    Bind(ptr_info, associated_group);
+  }
+
+  // Constructs a completed associated binding of |impl|. Does not take
+  // ownership of |impl|, which must outlive this object.
+  AssociatedBinding(Interface* impl,
+                    AssociatedInterfaceRequest<Interface> request)
+      : AssociatedBinding(impl) {
+    Bind(request.Pass());
+  }
+
+  // Tears down the associated binding. The other side is notified
+  // asynchronously.
+  ~AssociatedBinding() {}
+
+  // Sets up this object as the implementation side of an associated
+  // interface, creating the interface on the pipe referred to by
+  // |associated_group|. The output |ptr_info| should be passed through that
+  // pipe to set up the corresponding associated interface pointer on the other
+  // side.
+  void Bind(AssociatedInterfacePtrInfo<Interface>* ptr_info,
+            const AssociatedGroup& associated_group) {
+    internal::ScopedInterfaceEndpointHandle local;
+    internal::ScopedInterfaceEndpointHandle remote;
+    associated_group.CreateEndpointHandlePair(&local, &remote);
+
+    ptr_info->set_handle(remote.Pass());
+    ptr_info->set_version(Interface::Version_);
+    Bind(MakeAssociatedRequest<Interface>(local.Pass()));
+  }
+
+  // Sets up this object as the implementation side of the associated interface
+  // requested by |request|. Messages that arrived for the interface before
+  // this call are dispatched to the implementation before it returns.
+  void Bind(AssociatedInterfaceRequest<Interface> request) {
+    MOJO_DCHECK(!endpoint_client_);
+
+    internal::ScopedInterfaceEndpointHandle handle = request.PassHandle();
+    MOJO_DCHECK(!handle.is_valid() || handle.is_local());
+    if (!handle.is_valid())
+      return;
+
+    internal::FilterChain filters;
+    filters.Append<typename Interface::RequestValidator_>();
+
+    endpoint_client_.reset(
+        new internal::InterfaceEndpointClient(handle.Pass(), filters.Pass()));
+    endpoint_client_->set_incoming_receiver(&stub_);
+    endpoint_client_->set_connection_error_handler(
+        [this]() { connection_error_handler_.Run(); });
+    stub_.set_router(endpoint_client_->router());
+
+    endpoint_client_->DispatchPendingMessages();
+  }
+
+  // Closes the associated interface. Puts this object into a state where it
+  // can be rebound.
+  void Close() {
+    MOJO_DCHECK(endpoint_client_);
+    endpoint_client_.reset();
+  }
+
+  // Unbinds and returns the associated interface request so it can be used in
+  // another context, such as with a different implementation. Puts this
+  // object into a state where it can be rebound.
+  AssociatedInterfaceRequest<Interface> Unbind() {
+    MOJO_DCHECK(endpoint_client_);
+    auto request =
+        MakeAssociatedRequest<Interface>(endpoint_client_->PassHandle());
+    endpoint_client_.reset();
+    return request;
+  }
+
+  // Sets an error handler that will be called if the other side closes the
+  // associated interface, or the underlying message pipe is closed.
+  void set_connection_error_handler(const Closure& error_handler) {
+    connection_error_handler_ = error_handler;
+  }
+
+  // Returns the interface implementation that was previously specified.
+  Interface* impl() { return impl_; }
+
+  // Indicates whether the associated binding has been completed.
+  bool is_bound() const { return !!endpoint_client_; }
+
+  // Returns the associated group that this object belongs to. Returns an
+  // invalid group if this object is unbound or the pipe is gone.
+  AssociatedGroup associated_group() {
+    internal::Router* router =
+        endpoint_client_ ? endpoint_client_->router() : nullptr;
+    return router ? AssociatedGroup(router->weak_self()) : AssociatedGroup();
+  }
+
+ private:
+  std::unique_ptr<internal::InterfaceEndpointClient> endpoint_client_;
+  typename Interface::Stub_ stub_;
+  Interface* impl_;
+  Closure connection_error_handler_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(AssociatedBinding);
+};
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_BINDING_H_
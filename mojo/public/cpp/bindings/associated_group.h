@@ -0,0 +1,51 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_GROUP_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_GROUP_H_
+
+#include "mojo/public/cpp/bindings/lib/router.h"
+#include "mojo/public/cpp/bindings/lib/scoped_interface_endpoint_handle.h"
+#include "mojo/public/cpp/bindings/lib/shared_data.h"
+
+namespace mojo {
+
+// AssociatedGroup refers to all the interfaces (the master interface and the
+// associated interfaces) that share one message pipe. It is used to create
+// associated interfaces on that pipe; see GetProxy() in
+// associated_interface_ptr.h. An AssociatedGroup is cheap to copy and may
+// outlive the pipe, in which case it creates invalid endpoints.
+class AssociatedGroup {
+ public:
+  // Creates an AssociatedGroup that isn't associated with any pipe.
+  AssociatedGroup() {}
+
+  explicit AssociatedGroup(
+      const internal::SharedData<internal::Router*>& router)
+      : router_(router) {}
+
+  // Returns whether the pipe that this group refers to is still alive.
+  bool is_valid() const { return !!router_.value(); }
+
+  // Allocates a new associated interface on the pipe. Both handles are
+  // invalid if the pipe is gone.
+  void CreateEndpointHandlePair(
+      internal::ScopedInterfaceEndpointHandle* local_endpoint,
+      internal::ScopedInterfaceEndpointHandle* remote_endpoint) const {
+    internal::Router* router = router_.value();
+    if (!router) {
+      local_endpoint->reset();
+      remote_endpoint->reset();
+      return;
+    }
+    router->CreateEndpointHandlePair(local_endpoint, remote_endpoint);
+  }
+
+ private:
+  internal::SharedData<internal::Router*> router_;
+};
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_GROUP_H_
@@ -0,0 +1,166 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_INTERFACE_PTR_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_INTERFACE_PTR_H_
+
+#include "mojo/public/cpp/bindings/associated_group.h"
+#include "mojo/public/cpp/bindings/associated_interface_ptr_info.h"
+#include "mojo/public/cpp/bindings/associated_interface_request.h"
+#include "mojo/public/cpp/bindings/callback.h"
+#include "mojo/public/cpp/bindings/lib/associated_interface_ptr_state.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+
+// Represents the client side of an associated interface. It is similar to
+// InterfacePtr, except that it doesn't own a message pipe handle: calls are
+// sent over the pipe of the interface through which the associated interface
+// was requested, and are therefore ordered with respect to the calls made on
+// that interface (and on any other interface associated with it).
+template <typename Interface>
+class AssociatedInterfacePtr {
+ public:
+  // Constructs an unbound AssociatedInterfacePtr.
+  AssociatedInterfacePtr() {}
+  AssociatedInterfacePtr(decltype(nullptr)) {}
+
+  AssociatedInterfacePtr(AssociatedInterfacePtr&& other) {
+    internal_state_.Swap(&other.internal_state_);
+  }
+
+  AssociatedInterfacePtr& operator=(AssociatedInterfacePtr&& other) {
+    reset();
+    internal_state_.Swap(&other.internal_state_);
+    return *this;
+  }
+
+  // Assigning nullptr to this class causes it to close the associated
+  // interface (if any) and returns the pointer to the unbound state.
+  AssociatedInterfacePtr& operator=(decltype(nullptr)) {
+    reset();
+    return *this;
+  }
+
+  ~AssociatedInterfacePtr() {}
+
+  // Sets up this object as the client side of an associated interface.
+  // Calling with an invalid |info| has the same effect as reset(). In this
+  // case, the AssociatedInterfacePtr is not considered as bound.
+  //
+  // NOTE: Please see the comments of |GetProxy(AssociatedInterfacePtr<I>*,
+  // const AssociatedGroup&)| about when you can use this object to make calls.
+  void Bind(AssociatedInterfacePtrInfo<Interface> info) {
+    reset();
+    if (info.is_valid())
+      internal_state_.Bind(info.Pass());
+  }
+
+  bool is_bound() const { return internal_state_.is_bound(); }
+
+  Interface* get() const { return internal_state_.instance(); }
+
+  // Functions like a pointer to Interface. Must already be bound.
+  Interface* operator->() const { return get(); }
+  Interface& operator*() const { return *get(); }
+
+  // Returns the version number of the interface that the remote side supports.
+  uint32_t version() const { return internal_state_.version(); }
+
+  // Queries the max version that the remote side supports. On completion, the
+  // result will be returned as the input of |callback|. The version number of
+  // this object will also be updated.
+  void QueryVersion(const Callback<void(uint32_t)>& callback) {
+    internal_state_.QueryVersion(callback);
+  }
+
+  // If the remote side doesn't support the specified version, it will close the
+  // associated interface asynchronously. This does nothing if it's already
+  // known that the remote side supports the specified version, i.e., if
+  // |version <= this->version()|.
+  //
+  // After calling RequireVersion() with a version not supported by the remote
+  // side, all subsequent calls to interface methods will be ignored.
+  void RequireVersion(uint32_t version) {
+    internal_state_.RequireVersion(version);
+  }
+
+  // Closes the associated interface (if any) and returns the pointer to the
+  // unbound state.
+  void reset() {
+    State doomed;
+    internal_state_.Swap(&doomed);
+  }
+
+  // Indicates whether an error has been encountered. If true, method calls
+  // made on this interface will be dropped (and may already have been
+  // dropped).
+  bool encountered_error() const { return internal_state_.encountered_error(); }
+
+  // Registers a handler to receive error notifications.
+  //
+  // This method may only be called after the AssociatedInterfacePtr has been
+  // bound.
+  void set_connection_error_handler(const Closure& error_handler) {
+    internal_state_.set_connection_error_handler(error_handler);
+  }
+
+  // Unbinds and returns the associated interface pointer information which
+  // could be used to setup an AssociatedInterfacePtr again on the same pipe.
+  AssociatedInterfacePtrInfo<Interface> PassInterface() {
+    State state;
+    internal_state_.Swap(&state);
+    return state.PassInterface();
+  }
+
+  // Returns the associated group that this object belongs to. Returns an
+  // invalid group if this object is unbound or the pipe is gone.
+  AssociatedGroup associated_group() {
+    return internal_state_.associated_group();
+  }
+
+  // DO NOT USE. Exposed only for internal use and for testing.
+  internal::AssociatedInterfacePtrState<Interface>* internal_state() {
+    return &internal_state_;
+  }
+
+  // Tests as true if bound, false if not.
+  explicit operator bool() const { return internal_state_.is_bound(); }
+
+ private:
+  typedef internal::AssociatedInterfacePtrState<Interface> State;
+  mutable State internal_state_;
+
+  MOJO_MOVE_ONLY_TYPE(AssociatedInterfacePtr);
+};
+
+// Creates an associated interface. The output |ptr| should be used locally
+// while the returned request should be passed through the message pipe
+// referred to by |group| (i.e., as a parameter of a method of an interface
+// bound to that pipe, or of one associated with it) to set up the
+// implementation on the other side.
+//
+// Calls may be made on |ptr| right away: messages sent before the request
+// reaches the other side are queued there until the request is bound.
+template <typename Interface>
+AssociatedInterfaceRequest<Interface> GetProxy(
+    AssociatedInterfacePtr<Interface>* ptr,
+    const AssociatedGroup& group) {
+  internal::ScopedInterfaceEndpointHandle local;
+  internal::ScopedInterfaceEndpointHandle remote;
+  group.CreateEndpointHandlePair(&local, &remote);
+
+  if (!local.is_valid()) {
+    ptr->reset();
+    return AssociatedInterfaceRequest<Interface>();
+  }
+
+  ptr->Bind(AssociatedInterfacePtrInfo<Interface>(local.Pass(),
+                                                  Interface::Version_));
+  return MakeAssociatedRequest<Interface>(remote.Pass());
+}
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_INTERFACE_PTR_H_
@@ -0,0 +1,82 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_INTERFACE_REQUEST_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_INTERFACE_REQUEST_H_
+
+#include "mojo/public/cpp/bindings/lib/scoped_interface_endpoint_handle.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+
+// AssociatedInterfaceRequest represents an associated interface request. It is
+// similar to InterfaceRequest except that it doesn't own a message pipe handle;
+// the interface is served over the pipe of the interface that carried the
+// request.
+template <typename Interface>
+class AssociatedInterfaceRequest {
+ public:
+  // Constructs an empty AssociatedInterfaceRequest, representing that the
+  // client is not requesting an implementation of Interface.
+  AssociatedInterfaceRequest() {}
+  AssociatedInterfaceRequest(decltype(nullptr)) {}
+
+  // Takes the interface endpoint handle from another
+  // AssociatedInterfaceRequest.
+  AssociatedInterfaceRequest(AssociatedInterfaceRequest&& other) {
+    handle_ = other.handle_.Pass();
+  }
+  AssociatedInterfaceRequest& operator=(AssociatedInterfaceRequest&& other) {
+    if (this != &other)
+      handle_ = other.handle_.Pass();
+    return *this;
+  }
+
+  // Assigning to nullptr resets the AssociatedInterfaceRequest to an empty
+  // state, closing the interface endpoint handle currently bound to it (if
+  // any).
+  AssociatedInterfaceRequest& operator=(decltype(nullptr)) {
+    handle_.reset();
+    return *this;
+  }
+
+  // Binds the request to an interface endpoint over which Interface is to be
+  // requested. If the request is already bound, the current endpoint will be
+  // closed.
+  void Bind(internal::ScopedInterfaceEndpointHandle handle) {
+    handle_ = handle.Pass();
+  }
+
+  // Indicates whether the request currently contains a valid interface
+  // endpoint handle.
+  bool is_pending() const { return handle_.is_valid(); }
+
+  // Removes the interface endpoint handle from the request and returns it.
+  internal::ScopedInterfaceEndpointHandle PassHandle() {
+    return handle_.Pass();
+  }
+  const internal::ScopedInterfaceEndpointHandle& handle() const {
+    return handle_;
+  }
+
+ private:
+  internal::ScopedInterfaceEndpointHandle handle_;
+
+  MOJO_MOVE_ONLY_TYPE(AssociatedInterfaceRequest);
+};
+
+// Makes an AssociatedInterfaceRequest bound to the specified interface
+// endpoint. If |handle| is invalid, the resulting request will represent the
+// absence of a request.
+template <typename Interface>
+AssociatedInterfaceRequest<Interface> MakeAssociatedRequest(
+    internal::ScopedInterfaceEndpointHandle handle) {
+  AssociatedInterfaceRequest<Interface> request;
+  request.Bind(handle.Pass());
+  return request;
+}
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_ASSOCIATED_INTERFACE_REQUEST_H_
@@ -8,6 +8,7 @@
 #include <memory>
 
 #include "mojo/public/c/environment/async_waiter.h"
+#include "mojo/public/cpp/bindings/associated_group.h"
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/bindings/interface_ptr.h"
 #include "mojo/public/cpp/bindings/interface_ptr_info.h"
@@ -15,6 +16,7 @@
 #include "mojo/public/cpp/bindings/lib/filter_chain.h"
 #include "mojo/public/cpp/bindings/lib/message_header_validator.h"
 #include "mojo/public/cpp/bindings/lib/router.h"
+#include "mojo/public/cpp/bindings/lib/trusted_peer_validator.h"
 #include "mojo/public/cpp/environment/logging.h"
 #include "mojo/public/cpp/system/core.h"
 
@@ -64,7 +66,9 @@ class Binding {
   // Constructs an incomplete binding that will use the implementation |impl|.
   // The binding may be completed with a subsequent call to the |Bind| method.
   // Does not take ownership of |impl|, which must outlive the binding.
-  explicit Binding(Interface* impl) : impl_(impl) { stub_.set_sink(impl_); }
+  explicit Binding(Interface* impl) : impl_(impl), trusted_peer_(false) {
+    stub_.set_sink(impl_);
+  }
 
   // Constructs a completed binding of message pipe |handle| to implementation
   // |impl|. Does not take ownership of |impl|, which must outlive the binding.
@@ -113,13 +117,22 @@ class Binding {
     MOJO_DCHECK(!internal_router_);
     internal::FilterChain filters;
     filters.Append<internal::MessageHeaderValidator>();
-    filters.Append<typename Interface::RequestValidator_>();
+    if (trusted_peer_) {
+      filters.Append<internal::TrustedPeerValidator<
+          typename Interface::RequestValidator_>>();
+    } else {
+      filters.Append<typename Interface::RequestValidator_>();
+    }
 
     internal_router_.reset(
         new internal::Router(handle.Pass(), filters.Pass(), waiter));
     internal_router_->set_incoming_receiver(&stub_);
     internal_router_->set_connection_error_handler(
         [this]() { connection_error_handler_.Run(); });
+    internal_router_->set_interface_id_namespace_bit(true);
+    internal_router_->EnableInstrumentation(Interface::QualifiedName_,
+                                            &Interface::MethodName_);
+    stub_.set_router(internal_router_.get());
   }
 
   // Completes a binding that was constructed with only an interface
@@ -148,6 +161,18 @@ class Binding {
     Bind(request.PassMessagePipe(), waiter);
   }
 
+  // Declares that the client on the other end of the message pipe lives in the
+  // same process (and is built from the same binary) as this binding, so that
+  // incoming requests need not be validated beyond their message header. Only
+  // call this when the embedder knows the peer is in-process, e.g. for pipes
+  // created by an in-process application loader; never for a pipe received
+  // from another process. Debug builds still validate a sample of the
+  // requests. Must be called before the binding is completed.
+  void EnableTrustedPeerMode() {
+    MOJO_DCHECK(!internal_router_);
+    trusted_peer_ = true;
+  }
+
   // Blocks the calling thread until either a call arrives on the previously
   // bound message pipe, the deadline is exceeded, or an error occurs. Returns
   // true if a method was successfully read and dispatched.
@@ -167,7 +192,8 @@ class Binding {
   // Unbinds the underlying pipe from this binding and returns it so it can be
   // used in another context, such as on another thread or with a different
   // implementation. Put this object into a state where it can be rebound to a
-  // new pipe.
+  // new pipe. Returns an invalid request, and closes the pipe, if called while
+  // handling a call from the middle of a batch (see InterfacePtr::BatchScope).
   InterfaceRequest<Interface> Unbind() {
     auto request = MakeRequest<Interface>(internal_router_->PassMessagePipe());
     internal_router_.reset();
@@ -197,6 +223,13 @@ class Binding {
     return internal_router_->handle();
   }
 
+  // Returns the associated group of the bound message pipe, which can be used
+  // to create associated interfaces on it. Requires that the Binding be bound.
+  AssociatedGroup associated_group() {
+    MOJO_DCHECK(is_bound());
+    return AssociatedGroup(internal_router_->weak_self());
+  }
+
   // Exposed for testing, should not generally be used.
   internal::Router* internal_router() { return internal_router_.get(); }
 
@@ -204,6 +237,7 @@ class Binding {
   std::unique_ptr<internal::Router> internal_router_;
   typename Interface::Stub_ stub_;
   Interface* impl_;
+  bool trusted_peer_;
   Closure connection_error_handler_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(Binding);
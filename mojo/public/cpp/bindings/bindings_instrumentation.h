@@ -0,0 +1,80 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_BINDINGS_INSTRUMENTATION_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_BINDINGS_INSTRUMENTATION_H_
+
+#include <stdint.h>
+
+#include "mojo/public/c/system/types.h"
+
+namespace mojo {
+
+// Counts the requests sent by an InterfacePtr that are still awaiting their
+// responses, and the memory it holds for them (the pending callbacks and their
+// bookkeeping). It is updated on the InterfacePtr's thread for every request
+// and response, so Add() must be cheap; it shouldn't take a lock.
+class PendingResponsesCounter {
+ public:
+  virtual ~PendingResponsesCounter() {}
+
+  virtual void Add(int32_t count_delta, int64_t num_bytes_delta) = 0;
+};
+
+// BindingsInstrumentation receives per-method statistics about the messages
+// sent and dispatched by InterfacePtrs and Bindings. Interfaces and methods are
+// identified by their fully-qualified name (e.g. "mojo.Shell") and method name
+// (e.g. "ConnectToApplication"), which are static strings.
+//
+// The methods are called on whichever thread the InterfacePtr or Binding lives
+// on, for every message, so they must be thread-safe and cheap.
+class BindingsInstrumentation {
+ public:
+  virtual ~BindingsInstrumentation() {}
+
+  // A request (or a response, if |is_response| is true) of |num_bytes| bytes
+  // was written to the pipe.
+  virtual void OnMessageSent(const char* interface_name,
+                             const char* method_name,
+                             bool is_response,
+                             uint32_t num_bytes) = 0;
+
+  // A request was dispatched to the implementation, or a response to its
+  // callback. |queueing_time| is the time from when the message was sent until
+  // dispatch began, or -1 if the sender didn't record a send time.
+  // |handler_time| is the time spent in the implementation or callback.
+  virtual void OnMessageDispatched(const char* interface_name,
+                                   const char* method_name,
+                                   bool is_response,
+                                   uint32_t num_bytes,
+                                   MojoTimeTicks queueing_time,
+                                   MojoTimeTicks handler_time) = 0;
+
+  // A response arrived |round_trip_time| after the request was sent.
+  virtual void OnResponseReceived(const char* interface_name,
+                                  const char* method_name,
+                                  MojoTimeTicks round_trip_time) = 0;
+
+  // Returns a counter for the responses awaited by an InterfacePtr of
+  // |interface_name|, or null not to count them. It is called once, when the
+  // InterfacePtr is bound, and the counter is deleted (with whatever is still
+  // counted) when the InterfacePtr goes away.
+  virtual PendingResponsesCounter* CreatePendingResponsesCounter(
+      const char* interface_name) {
+    return nullptr;
+  }
+};
+
+// Installs |instrumentation| for the process; null uninstalls it. It only
+// applies to InterfacePtrs and Bindings bound afterwards, so this should be
+// called at startup, before any are bound, and |instrumentation| must outlive
+// them. While instrumentation is installed, messages carry their send time
+// in an extended (version 3) message header.
+void SetBindingsInstrumentation(BindingsInstrumentation* instrumentation);
+
+BindingsInstrumentation* GetBindingsInstrumentation();
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_BINDINGS_INSTRUMENTATION_H_
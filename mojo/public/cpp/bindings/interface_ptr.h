@@ -7,6 +7,7 @@
 
 #include <algorithm>
 
+#include "mojo/public/cpp/bindings/associated_group.h"
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/bindings/interface_ptr_info.h"
 #include "mojo/public/cpp/bindings/lib/interface_ptr_internal.h"
@@ -29,6 +30,40 @@ namespace mojo {
 template <typename Interface>
 class InterfacePtr {
  public:
+  // While a BatchScope is alive, calls to methods that have no response are
+  // packed together and written to the pipe as a single message when the
+  // outermost scope ends, saving the per-message cost of the write, the
+  // wakeup and the read. The implementation still sees the calls one by one
+  // and in order. Calling a method that has a response, or waiting for one,
+  // flushes the batch early, as does a batch that grows too large. Scopes may
+  // be nested.
+  //
+  //   {
+  //     FooPtr::BatchScope batch(&foo);
+  //     for (size_t i = 0; i < updates.size(); ++i)
+  //       foo->Update(updates[i].Pass());
+  //   }
+  //
+  // The other end of the pipe must be bound with these C++ bindings, which
+  // know how to unpack batches. The implementation can't unbind the pipe
+  // while it handles a call from the middle of a batch, since the rest of the
+  // batch can't be handed over: the pipe is closed instead.
+  class BatchScope {
+   public:
+    explicit BatchScope(InterfacePtr* ptr)
+        : router_(ptr->internal_state_.BeginBatch()) {}
+    ~BatchScope() {
+      internal::Router* router = router_.value();
+      if (router)
+        router->EndBatch();
+    }
+
+   private:
+    internal::SharedData<internal::Router*> router_;
+
+    MOJO_DISALLOW_COPY_AND_ASSIGN(BatchScope);
+  };
+
   // Constructs an unbound InterfacePtr.
   InterfacePtr() {}
   InterfacePtr(decltype(nullptr)) {}
@@ -72,6 +107,17 @@ class InterfacePtr {
       internal_state_.Bind(info.Pass(), waiter);
   }
 
+  // Declares that the implementation on the other end of the message pipe
+  // lives in the same process (and is built from the same binary) as this
+  // pointer, so that incoming responses need not be validated beyond their
+  // message header. Only call this when the embedder knows the peer is
+  // in-process; never for a pipe received from another process. Debug builds
+  // still validate a sample of the responses.
+  //
+  // This method may only be called after the InterfacePtr has been bound to a
+  // message pipe, and before any method is called through it.
+  void EnableTrustedPeerMode() { internal_state_.EnableTrustedPeerMode(); }
+
   // Returns whether or not this InterfacePtr is bound to a message pipe.
   bool is_bound() const { return internal_state_.is_bound(); }
 
@@ -149,6 +195,15 @@ class InterfacePtr {
     internal_state_.set_connection_error_handler(error_handler);
   }
 
+  // Returns the associated group of the bound message pipe, which can be used
+  // to create associated interfaces on it.
+  //
+  // This method may only be called after the InterfacePtr has been bound to a
+  // message pipe.
+  AssociatedGroup associated_group() {
+    return internal_state_.associated_group();
+  }
+
   // Unbinds the InterfacePtr and returns the information which could be used
   // to setup an InterfacePtr again. This method may be used to move the proxy
   // to a different thread (see class comments for details).
@@ -0,0 +1,126 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_ASSOCIATED_INTERFACE_PTR_STATE_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_ASSOCIATED_INTERFACE_PTR_STATE_H_
+
+#include <algorithm>  // For |std::swap()|.
+
+#include "mojo/public/cpp/bindings/associated_group.h"
+#include "mojo/public/cpp/bindings/associated_interface_ptr_info.h"
+#include "mojo/public/cpp/bindings/callback.h"
+#include "mojo/public/cpp/bindings/lib/control_message_proxy.h"
+#include "mojo/public/cpp/bindings/lib/filter_chain.h"
+#include "mojo/public/cpp/bindings/lib/interface_endpoint_client.h"
+#include "mojo/public/cpp/environment/logging.h"
+
+namespace mojo {
+namespace internal {
+
+template <typename Interface>
+class AssociatedInterfacePtrState {
+ public:
+  AssociatedInterfacePtrState()
+      : proxy_(nullptr), endpoint_client_(nullptr), version_(0u) {}
+
+  ~AssociatedInterfacePtrState() {
+    // As with InterfacePtrState, delete |proxy_| first so that destructors for
+    // any request callbacks still pending can interact with the pointer.
+    delete proxy_;
+    delete endpoint_client_;
+  }
+
+  Interface* instance() {
+    // This will be null if the object is not bound.
+    return proxy_;
+  }
+
+  uint32_t version() const { return version_; }
+
+  void QueryVersion(const Callback<void(uint32_t)>& callback) {
+    // It is safe to capture |this| because the callback won't be run after this
+    // object goes away.
+    auto callback_wrapper = [this, callback](uint32_t version) {
+      this->version_ = version;
+      callback.Run(version);
+    };
+
+    // Do a static cast in case the interface contains methods with the same
+    // name.
+    static_cast<ControlMessageProxy*>(proxy_)->QueryVersion(callback_wrapper);
+  }
+
+  void RequireVersion(uint32_t version) {
+    if (version <= version_)
+      return;
+
+    version_ = version;
+    // Do a static cast in case the interface contains methods with the same
+    // name.
+    static_cast<ControlMessageProxy*>(proxy_)->RequireVersion(version);
+  }
+
+  void Swap(AssociatedInterfacePtrState* other) {
+    using std::swap;
+    swap(other->proxy_, proxy_);
+    swap(other->endpoint_client_, endpoint_client_);
+    swap(other->version_, version_);
+  }
+
+  void Bind(AssociatedInterfacePtrInfo<Interface> info) {
+    MOJO_DCHECK(!proxy_);
+    MOJO_DCHECK(!endpoint_client_);
+    MOJO_DCHECK(version_ == 0u);
+    MOJO_DCHECK(info.is_valid());
+
+    FilterChain filters;
+    filters.Append<typename Interface::ResponseValidator_>();
+
+    version_ = info.version();
+    endpoint_client_ =
+        new InterfaceEndpointClient(info.PassHandle(), filters.Pass());
+    proxy_ = new Proxy(endpoint_client_);
+    endpoint_client_->DispatchPendingMessages();
+  }
+
+  // After this method is called, the object is in an invalid state and
+  // shouldn't be reused.
+  AssociatedInterfacePtrInfo<Interface> PassInterface() {
+    return AssociatedInterfacePtrInfo<Interface>(
+        endpoint_client_ ? endpoint_client_->PassHandle()
+                         : ScopedInterfaceEndpointHandle(),
+        version_);
+  }
+
+  bool is_bound() const { return !!endpoint_client_; }
+
+  bool encountered_error() const {
+    return endpoint_client_ ? endpoint_client_->encountered_error() : false;
+  }
+
+  void set_connection_error_handler(const Closure& error_handler) {
+    MOJO_DCHECK(endpoint_client_);
+    endpoint_client_->set_connection_error_handler(error_handler);
+  }
+
+  AssociatedGroup associated_group() {
+    Router* router = endpoint_client_ ? endpoint_client_->router() : nullptr;
+    return router ? AssociatedGroup(router->weak_self()) : AssociatedGroup();
+  }
+
+ private:
+  using Proxy = typename Interface::Proxy_;
+
+  Proxy* proxy_;
+  InterfaceEndpointClient* endpoint_client_;
+
+  uint32_t version_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(AssociatedInterfacePtrState);
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_ASSOCIATED_INTERFACE_PTR_STATE_H_
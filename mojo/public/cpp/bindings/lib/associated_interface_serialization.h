@@ -0,0 +1,70 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_ASSOCIATED_INTERFACE_SERIALIZATION_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_ASSOCIATED_INTERFACE_SERIALIZATION_H_
+
+#include "mojo/public/cpp/bindings/associated_interface_ptr_info.h"
+#include "mojo/public/cpp/bindings/associated_interface_request.h"
+#include "mojo/public/cpp/bindings/lib/bindings_internal.h"
+#include "mojo/public/cpp/bindings/lib/router.h"
+#include "mojo/public/cpp/environment/logging.h"
+
+namespace mojo {
+namespace internal {
+
+// Only the remote end of an associated interface may be sent. Serialization
+// gives up the handle without closing the endpoint; the receiving router
+// claims the ID when the message is deserialized.
+
+template <typename T>
+inline void AssociatedInterfacePtrInfoToData(
+    AssociatedInterfacePtrInfo<T> input,
+    AssociatedInterface_Data* output) {
+  ScopedInterfaceEndpointHandle handle = input.PassHandle();
+  MOJO_DCHECK(!handle.is_valid() || !handle.is_local())
+      << "Only the remote end of an associated interface can be sent.";
+  output->interface_id = handle.release();
+  output->version = input.version();
+}
+
+template <typename T>
+inline void AssociatedInterfaceRequestToData(
+    AssociatedInterfaceRequest<T> input,
+    AssociatedInterfaceRequest_Data* output) {
+  ScopedInterfaceEndpointHandle handle = input.PassHandle();
+  MOJO_DCHECK(!handle.is_valid() || !handle.is_local())
+      << "Only the remote end of an associated interface can be sent.";
+  output->interface_id = handle.release();
+}
+
+template <typename T>
+inline void AssociatedInterfaceDataToPtrInfo(
+    AssociatedInterface_Data* input,
+    AssociatedInterfacePtrInfo<T>* output,
+    Router* router) {
+  InterfaceId id = input->interface_id;
+  input->interface_id = kInvalidInterfaceId;
+  output->set_handle(router && IsValidInterfaceId(id)
+                         ? router->CreateLocalEndpointHandle(id)
+                         : ScopedInterfaceEndpointHandle());
+  output->set_version(input->version);
+}
+
+template <typename T>
+inline void AssociatedInterfaceRequestDataToRequest(
+    AssociatedInterfaceRequest_Data* input,
+    AssociatedInterfaceRequest<T>* output,
+    Router* router) {
+  InterfaceId id = input->interface_id;
+  input->interface_id = kInvalidInterfaceId;
+  output->Bind(router && IsValidInterfaceId(id)
+                   ? router->CreateLocalEndpointHandle(id)
+                   : ScopedInterfaceEndpointHandle());
+}
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_ASSOCIATED_INTERFACE_SERIALIZATION_H_
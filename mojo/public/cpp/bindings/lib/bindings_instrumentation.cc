@@ -0,0 +1,22 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/bindings_instrumentation.h"
+
+namespace mojo {
+namespace {
+
+BindingsInstrumentation* g_instrumentation = nullptr;
+
+}  // namespace
+
+void SetBindingsInstrumentation(BindingsInstrumentation* instrumentation) {
+  g_instrumentation = instrumentation;
+}
+
+BindingsInstrumentation* GetBindingsInstrumentation() {
+  return g_instrumentation;
+}
+
+}  // namespace mojo
@@ -7,6 +7,7 @@
 
 #include <type_traits>
 
+#include "mojo/public/cpp/bindings/lib/interface_id.h"
 #include "mojo/public/cpp/bindings/lib/template_util.h"
 #include "mojo/public/cpp/bindings/struct_ptr.h"
 #include "mojo/public/cpp/system/core.h"
@@ -17,6 +18,12 @@ class String;
 template <typename T>
 class Array;
 
+template <typename Interface>
+class AssociatedInterfacePtrInfo;
+
+template <typename Interface>
+class AssociatedInterfaceRequest;
+
 template <typename Interface>
 class InterfacePtr;
 
@@ -70,6 +77,19 @@ struct Interface_Data {
 };
 static_assert(sizeof(Interface_Data) == 8, "Bad_sizeof(Interface_Data)");
 
+struct AssociatedInterface_Data {
+  InterfaceId interface_id;
+  uint32_t version;
+};
+static_assert(sizeof(AssociatedInterface_Data) == 8,
+              "Bad_sizeof(AssociatedInterface_Data)");
+
+struct AssociatedInterfaceRequest_Data {
+  InterfaceId interface_id;
+};
+static_assert(sizeof(AssociatedInterfaceRequest_Data) == 4,
+              "Bad_sizeof(AssociatedInterfaceRequest_Data)");
+
 template <typename T>
 union UnionPointer {
   uint64_t offset;
@@ -272,6 +292,23 @@ struct ValueTraits<InterfaceRequest<I>> {
   }
 };
 
+// Associated interface endpoints are held uniquely too.
+template <typename I>
+struct ValueTraits<AssociatedInterfacePtrInfo<I>> {
+  static bool Equals(const AssociatedInterfacePtrInfo<I>& a,
+                     const AssociatedInterfacePtrInfo<I>& b) {
+    return (&a == &b) || (!a.is_valid() && !b.is_valid());
+  }
+};
+
+template <typename I>
+struct ValueTraits<AssociatedInterfaceRequest<I>> {
+  static bool Equals(const AssociatedInterfaceRequest<I>& a,
+                     const AssociatedInterfaceRequest<I>& b) {
+    return (&a == &b) || (!a.is_pending() && !b.is_pending());
+  }
+};
+
 }  // namespace internal
 }  // namespace mojo
 
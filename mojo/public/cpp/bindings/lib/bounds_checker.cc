@@ -17,7 +17,8 @@ BoundsChecker::BoundsChecker(const void* data,
     : data_begin_(reinterpret_cast<uintptr_t>(data)),
       data_end_(data_begin_ + data_num_bytes),
       handle_begin_(0),
-      handle_end_(static_cast<uint32_t>(num_handles)) {
+      handle_end_(static_cast<uint32_t>(num_handles)),
+      handles_(nullptr) {
   if (data_end_ < data_begin_) {
     // The calculation of |data_end_| overflowed.
     // It shouldn't happen but if it does, set the range to empty so
@@ -61,6 +62,15 @@ bool BoundsChecker::ClaimHandle(const Handle& encoded_handle) {
   return true;
 }
 
+Handle BoundsChecker::GetHandle(const Handle& encoded_handle) const {
+  uint32_t index = encoded_handle.value();
+  if (!handles_ || index == kEncodedInvalidHandleValue ||
+      index >= handles_->size()) {
+    return Handle();
+  }
+  return (*handles_)[index];
+}
+
 bool BoundsChecker::IsValidRange(const void* position,
                                  uint32_t num_bytes) const {
   uintptr_t begin = reinterpret_cast<uintptr_t>(position);
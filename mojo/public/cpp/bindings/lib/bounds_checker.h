@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "mojo/public/cpp/system/macros.h"
 
 namespace mojo {
@@ -39,6 +41,14 @@ class BoundsChecker {
   // case, the valid range is shinked to begin right after the claimed handle.
   bool ClaimHandle(const Handle& encoded_handle);
 
+  // Optionally gives access to the message's handles, so that validation can
+  // check the objects they refer to (e.g. the size of a shared buffer).
+  void set_handles(const std::vector<Handle>* handles) { handles_ = handles; }
+
+  // Returns the handle that the claimed |encoded_handle| refers to, or an
+  // invalid handle if it is invalid or set_handles() wasn't called.
+  Handle GetHandle(const Handle& encoded_handle) const;
+
   // Returns true if the specified range is not empty, and the range is
   // contained inside the valid memory range.
   bool IsValidRange(const void* position, uint32_t num_bytes) const;
@@ -54,6 +64,9 @@ class BoundsChecker {
   uint32_t handle_begin_;
   uint32_t handle_end_;
 
+  // Not owned. May be null.
+  const std::vector<Handle>* handles_;
+
   MOJO_DISALLOW_COPY_AND_ASSIGN(BoundsChecker);
 };
 
@@ -0,0 +1,212 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/lib/interface_endpoint_client.h"
+
+#include "mojo/public/cpp/bindings/lib/router.h"
+#include "mojo/public/cpp/environment/logging.h"
+
+namespace mojo {
+namespace internal {
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+// Sends the response to a request received on an associated endpoint. As with
+// the Router's responders, dropping a request without responding closes the
+// message pipe, so that the caller doesn't wait forever.
+class ResponderThunk : public MessageReceiverWithStatus {
+ public:
+  explicit ResponderThunk(
+      const SharedData<InterfaceEndpointClient*>& endpoint_client)
+      : endpoint_client_(endpoint_client), accept_was_invoked_(false) {}
+  ~ResponderThunk() override {
+    if (!accept_was_invoked_) {
+      InterfaceEndpointClient* endpoint_client = endpoint_client_.value();
+      Router* router = endpoint_client ? endpoint_client->router() : nullptr;
+      if (router)
+        router->CloseMessagePipe();
+    }
+  }
+
+  // MessageReceiver implementation:
+  bool Accept(Message* message) override {
+    accept_was_invoked_ = true;
+    MOJO_DCHECK(message->has_flag(kMessageIsResponse));
+
+    bool result = false;
+
+    InterfaceEndpointClient* endpoint_client = endpoint_client_.value();
+    if (endpoint_client)
+      result = endpoint_client->Accept(message);
+
+    return result;
+  }
+
+  // MessageReceiverWithStatus implementation:
+  bool IsValid() override {
+    InterfaceEndpointClient* endpoint_client = endpoint_client_.value();
+    return endpoint_client && !endpoint_client->encountered_error() &&
+           endpoint_client->router();
+  }
+
+ private:
+  SharedData<InterfaceEndpointClient*> endpoint_client_;
+  bool accept_was_invoked_;
+};
+
+}  // namespace
+
+// ----------------------------------------------------------------------------
+
+InterfaceEndpointClient::HandleIncomingMessageThunk::HandleIncomingMessageThunk(
+    InterfaceEndpointClient* owner)
+    : owner_(owner) {
+}
+
+InterfaceEndpointClient::HandleIncomingMessageThunk::
+    ~HandleIncomingMessageThunk() {
+}
+
+bool InterfaceEndpointClient::HandleIncomingMessageThunk::Accept(
+    Message* message) {
+  return owner_->HandleValidatedMessage(message);
+}
+
+// ----------------------------------------------------------------------------
+
+InterfaceEndpointClient::InterfaceEndpointClient(
+    ScopedInterfaceEndpointHandle handle,
+    FilterChain payload_validators)
+    : handle_(handle.Pass()),
+      thunk_(this),
+      payload_validators_(payload_validators.Pass()),
+      weak_self_(this),
+      incoming_receiver_(nullptr),
+      next_request_id_(0),
+      encountered_error_(false) {
+  MOJO_DCHECK(handle_.is_local());
+  payload_validators_.SetSink(&thunk_);
+
+  Router* router = handle_.router();
+  if (router)
+    router->AttachEndpointClient(handle_.id(), this);
+  else
+    encountered_error_ = true;
+}
+
+InterfaceEndpointClient::~InterfaceEndpointClient() {
+  weak_self_.set_value(nullptr);
+
+  Router* router = handle_.router();
+  if (router)
+    router->DetachEndpointClient(handle_.id());
+
+  DeleteResponders();
+}
+
+void InterfaceEndpointClient::DispatchPendingMessages() {
+  Router* router = handle_.router();
+  if (router)
+    router->DispatchPendingMessages(handle_.id());
+}
+
+ScopedInterfaceEndpointHandle InterfaceEndpointClient::PassHandle() {
+  Router* router = handle_.router();
+  if (router)
+    router->DetachEndpointClient(handle_.id());
+
+  DeleteResponders();
+  return handle_.Pass();
+}
+
+bool InterfaceEndpointClient::Accept(Message* message) {
+  MOJO_DCHECK(!message->has_flag(kMessageExpectsResponse));
+
+  Router* router = handle_.router();
+  if (!router || encountered_error_)
+    return false;
+  return router->SendAssociatedMessage(handle_.id(), message);
+}
+
+bool InterfaceEndpointClient::AcceptWithResponder(Message* message,
+                                                  MessageReceiver* responder) {
+  MOJO_DCHECK(message->has_flag(kMessageExpectsResponse));
+
+  Router* router = handle_.router();
+  if (!router || encountered_error_)
+    return false;
+
+  // Reserve 0 in case we want it to convey special meaning in the future.
+  uint64_t request_id = next_request_id_++;
+  if (request_id == 0)
+    request_id = next_request_id_++;
+
+  message->set_request_id(request_id);
+  if (!router->SendAssociatedMessage(handle_.id(), message))
+    return false;
+
+  // We assume ownership of |responder|.
+  responders_[request_id] = responder;
+  return true;
+}
+
+bool InterfaceEndpointClient::HandleIncomingMessage(Message* message) {
+  return payload_validators_.GetHead()->Accept(message);
+}
+
+void InterfaceEndpointClient::NotifyError() {
+  if (encountered_error_)
+    return;
+  encountered_error_ = true;
+
+  // Responses will never arrive now.
+  DeleteResponders();
+
+  if (!connection_error_handler_.is_null())
+    connection_error_handler_.Run();
+}
+
+bool InterfaceEndpointClient::HandleValidatedMessage(Message* message) {
+  if (message->has_flag(kMessageExpectsResponse)) {
+    if (!incoming_receiver_)
+      return false;
+
+    MessageReceiverWithStatus* responder = new ResponderThunk(weak_self_);
+    bool ok = incoming_receiver_->AcceptWithResponder(message, responder);
+    if (!ok)
+      delete responder;
+    return ok;
+  }
+
+  if (message->has_flag(kMessageIsResponse)) {
+    uint64_t request_id = message->request_id();
+    ResponderMap::iterator it = responders_.find(request_id);
+    if (it == responders_.end())
+      return false;
+    MessageReceiver* responder = it->second;
+    responders_.erase(it);
+    bool ok = responder->Accept(message);
+    delete responder;
+    return ok;
+  }
+
+  if (incoming_receiver_)
+    return incoming_receiver_->Accept(message);
+  // OK to drop message on the floor.
+  return false;
+}
+
+void InterfaceEndpointClient::DeleteResponders() {
+  ResponderMap responders;
+  responders.swap(responders_);
+  for (ResponderMap::const_iterator i = responders.begin();
+       i != responders.end(); ++i) {
+    delete i->second;
+  }
+}
+
+}  // namespace internal
+}  // namespace mojo
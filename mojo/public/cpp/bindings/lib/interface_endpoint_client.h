@@ -0,0 +1,104 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_INTERFACE_ENDPOINT_CLIENT_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_INTERFACE_ENDPOINT_CLIENT_H_
+
+#include <map>
+
+#include "mojo/public/cpp/bindings/callback.h"
+#include "mojo/public/cpp/bindings/lib/filter_chain.h"
+#include "mojo/public/cpp/bindings/lib/scoped_interface_endpoint_handle.h"
+#include "mojo/public/cpp/bindings/lib/shared_data.h"
+#include "mojo/public/cpp/bindings/message.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+namespace internal {
+
+class Router;
+
+// InterfaceEndpointClient is to an associated interface endpoint what the
+// Router is to a message pipe: it sends requests (keeping track of their
+// responders) and dispatches incoming messages, after running them through
+// |payload_validators|, to the incoming receiver. Messages travel over the
+// pipe of the Router that owns the endpoint.
+class InterfaceEndpointClient : public MessageReceiverWithResponder {
+ public:
+  InterfaceEndpointClient(ScopedInterfaceEndpointHandle handle,
+                          FilterChain payload_validators);
+  ~InterfaceEndpointClient() override;
+
+  // Sets the receiver to handle messages that do not have the
+  // kMessageIsResponse flag set.
+  void set_incoming_receiver(MessageReceiverWithResponderStatus* receiver) {
+    incoming_receiver_ = receiver;
+  }
+
+  // Sets the error handler to receive notifications when the other end of the
+  // endpoint, or the underlying message pipe, is closed.
+  void set_connection_error_handler(const Closure& error_handler) {
+    connection_error_handler_ = error_handler;
+  }
+
+  // Returns true if the other end of the endpoint, or the underlying message
+  // pipe, has been closed.
+  bool encountered_error() const { return encountered_error_; }
+
+  // Dispatches the messages that arrived for the endpoint before this object
+  // was fully set up. Must be called once the incoming receiver and the error
+  // handler are in place; may run them (and destroy this object).
+  void DispatchPendingMessages();
+
+  // Returns the router that owns the endpoint, or null if it is gone.
+  Router* router() const { return handle_.router(); }
+
+  // Detaches from the router and returns the endpoint handle. Pending
+  // responders are dropped.
+  ScopedInterfaceEndpointHandle PassHandle();
+
+  // MessageReceiver implementation:
+  bool Accept(Message* message) override;
+  bool AcceptWithResponder(Message* message,
+                           MessageReceiver* responder) override;
+
+  // The following methods are called by the router.
+  bool HandleIncomingMessage(Message* message);
+  void NotifyError();
+
+ private:
+  typedef std::map<uint64_t, MessageReceiver*> ResponderMap;
+
+  class HandleIncomingMessageThunk : public MessageReceiver {
+   public:
+    explicit HandleIncomingMessageThunk(InterfaceEndpointClient* owner);
+    ~HandleIncomingMessageThunk() override;
+
+    // MessageReceiver implementation:
+    bool Accept(Message* message) override;
+
+   private:
+    InterfaceEndpointClient* owner_;
+  };
+
+  bool HandleValidatedMessage(Message* message);
+  void DeleteResponders();
+
+  ScopedInterfaceEndpointHandle handle_;
+  HandleIncomingMessageThunk thunk_;
+  FilterChain payload_validators_;
+  SharedData<InterfaceEndpointClient*> weak_self_;
+  MessageReceiverWithResponderStatus* incoming_receiver_;
+  Closure connection_error_handler_;
+  ResponderMap responders_;
+  uint64_t next_request_id_;
+  bool encountered_error_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(InterfaceEndpointClient);
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_INTERFACE_ENDPOINT_CLIENT_H_
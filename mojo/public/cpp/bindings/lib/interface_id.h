@@ -0,0 +1,37 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_INTERFACE_ID_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_INTERFACE_ID_H_
+
+#include <stdint.h>
+
+namespace mojo {
+namespace internal {
+
+// Identifies one of the interfaces multiplexed over a single message pipe. The
+// interface bound directly to the pipe (the "master" interface) always has ID
+// |kMasterInterfaceId|; associated interfaces get IDs allocated by the router
+// on either end of the pipe.
+using InterfaceId = uint32_t;
+
+const InterfaceId kMasterInterfaceId = 0u;
+const InterfaceId kInvalidInterfaceId = 0xFFFFFFFFu;
+
+// IDs allocated by the side of the pipe that owns the Binding have this bit
+// set, so that the two sides can allocate IDs without coordination.
+const uint32_t kInterfaceIdNamespaceMask = 0x80000000u;
+
+inline bool IsMasterInterfaceId(InterfaceId id) {
+  return id == kMasterInterfaceId;
+}
+
+inline bool IsValidInterfaceId(InterfaceId id) {
+  return id != kInvalidInterfaceId;
+}
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_INTERFACE_ID_H_
@@ -7,12 +7,14 @@
 
 #include <algorithm>  // For |std::swap()|.
 
+#include "mojo/public/cpp/bindings/associated_group.h"
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/bindings/interface_ptr_info.h"
 #include "mojo/public/cpp/bindings/lib/control_message_proxy.h"
 #include "mojo/public/cpp/bindings/lib/filter_chain.h"
 #include "mojo/public/cpp/bindings/lib/message_header_validator.h"
 #include "mojo/public/cpp/bindings/lib/router.h"
+#include "mojo/public/cpp/bindings/lib/trusted_peer_validator.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 struct MojoAsyncWaiter;
@@ -24,7 +26,11 @@ template <typename Interface>
 class InterfacePtrState {
  public:
   InterfacePtrState()
-      : proxy_(nullptr), router_(nullptr), waiter_(nullptr), version_(0u) {}
+      : proxy_(nullptr),
+        router_(nullptr),
+        waiter_(nullptr),
+        version_(0u),
+        trusted_peer_(false) {}
 
   ~InterfacePtrState() {
     // Destruction order matters here. We delete |proxy_| first, even though
@@ -77,6 +83,7 @@ class InterfacePtrState {
     handle_.swap(other->handle_);
     swap(other->waiter_, waiter_);
     swap(other->version_, version_);
+    swap(other->trusted_peer_, trusted_peer_);
   }
 
   void Bind(InterfacePtrInfo<Interface> info, const MojoAsyncWaiter* waiter) {
@@ -92,6 +99,13 @@ class InterfacePtrState {
     version_ = info.version();
   }
 
+  void EnableTrustedPeerMode() {
+    // The validators are fixed once the router has been created.
+    MOJO_DCHECK(!router_);
+    MOJO_DCHECK(handle_.is_valid());
+    trusted_peer_ = true;
+  }
+
   bool WaitForIncomingResponse(
       MojoDeadline deadline = MOJO_DEADLINE_INDEFINITE) {
     ConfigureProxyIfNecessary();
@@ -120,6 +134,24 @@ class InterfacePtrState {
     router_->set_connection_error_handler(error_handler);
   }
 
+  // Starts a batch on the router (see Router::BeginBatch()) and returns a weak
+  // reference to it, whose value is null if the pointer is not bound.
+  SharedData<Router*> BeginBatch() {
+    ConfigureProxyIfNecessary();
+
+    if (!router_)
+      return SharedData<Router*>();
+    router_->BeginBatch();
+    return router_->weak_self();
+  }
+
+  AssociatedGroup associated_group() {
+    ConfigureProxyIfNecessary();
+
+    MOJO_DCHECK(router_);
+    return AssociatedGroup(router_->weak_self());
+  }
+
   Router* router_for_testing() {
     ConfigureProxyIfNecessary();
     return router_;
@@ -142,9 +174,16 @@ class InterfacePtrState {
 
     FilterChain filters;
     filters.Append<MessageHeaderValidator>();
-    filters.Append<typename Interface::ResponseValidator_>();
+    if (trusted_peer_) {
+      filters.Append<
+          TrustedPeerValidator<typename Interface::ResponseValidator_>>();
+    } else {
+      filters.Append<typename Interface::ResponseValidator_>();
+    }
 
     router_ = new Router(handle_.Pass(), filters.Pass(), waiter_);
+    router_->EnableInstrumentation(Interface::QualifiedName_,
+                                   &Interface::MethodName_);
     waiter_ = nullptr;
 
     proxy_ = new Proxy(router_);
@@ -161,6 +200,10 @@ class InterfacePtrState {
 
   uint32_t version_;
 
+  // Whether responses are validated by a TrustedPeerValidator instead of the
+  // full ResponseValidator_.
+  bool trusted_peer_;
+
   MOJO_DISALLOW_COPY_AND_ASSIGN(InterfacePtrState);
 };
 
@@ -4,10 +4,11 @@
 
 #include "mojo/public/cpp/bindings/message.h"
 
-#include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
 
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
@@ -30,13 +31,16 @@ void Message::Reset() {
 void Message::AllocData(uint32_t num_bytes) {
   MOJO_DCHECK(!data_);
   data_num_bytes_ = num_bytes;
-  data_ = static_cast<internal::MessageData*>(calloc(num_bytes, 1));
+  data_ = static_cast<internal::MessageData*>(
+      internal::AllocMessageBuffer(num_bytes));
+  memset(data_, 0, num_bytes);
 }
 
 void Message::AllocUninitializedData(uint32_t num_bytes) {
   MOJO_DCHECK(!data_);
   data_num_bytes_ = num_bytes;
-  data_ = static_cast<internal::MessageData*>(malloc(num_bytes));
+  data_ = static_cast<internal::MessageData*>(
+      internal::AllocMessageBuffer(num_bytes));
 }
 
 void Message::MoveTo(Message* destination) {
@@ -59,7 +63,7 @@ void Message::Initialize() {
 }
 
 void Message::FreeDataAndCloseHandles() {
-  free(data_);
+  internal::FreeMessageBuffer(data_);
 
   for (std::vector<Handle>::iterator it = handles_.begin();
        it != handles_.end(); ++it) {
@@ -0,0 +1,164 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "mojo/public/cpp/environment/logging.h"
+
+namespace mojo {
+namespace internal {
+namespace {
+
+// Size classes are powers of two from 64 bytes to 8KB, which covers the vast
+// majority of messages.
+const size_t kMinSizeClassNumBytes = 64;
+const uint32_t kNumSizeClasses = 8;
+const uint32_t kUncachedSizeClass = 0xFFFFFFFF;
+
+// Bounds the memory a thread can hold on to (at most 8 buffers per class, i.e.
+// a little under 128KB).
+const size_t kMaxCachedBuffersPerClass = 8;
+
+// Precedes every buffer. It is 8 bytes, which keeps the buffer itself 8-byte
+// aligned.
+struct BufferHeader {
+  uint32_t size_class;
+  uint32_t padding;
+};
+static_assert(sizeof(BufferHeader) == 8, "Bad sizeof(BufferHeader)");
+
+// A cached buffer; the link to the next one is stored in the buffer itself.
+struct FreeBuffer {
+  FreeBuffer* next;
+};
+
+struct ThreadCache {
+  FreeBuffer* free_lists[kNumSizeClasses];
+  size_t num_free_buffers[kNumSizeClasses];
+};
+
+size_t SizeClassNumBytes(uint32_t size_class) {
+  return kMinSizeClassNumBytes << size_class;
+}
+
+uint32_t SizeClassFor(size_t num_bytes) {
+  for (uint32_t size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+    if (num_bytes <= SizeClassNumBytes(size_class))
+      return size_class;
+  }
+  return kUncachedSizeClass;
+}
+
+BufferHeader* HeaderFromBuffer(void* buffer) {
+  return static_cast<BufferHeader*>(buffer) - 1;
+}
+
+void* BufferFromHeader(BufferHeader* header) {
+  return header + 1;
+}
+
+#ifndef _WIN32
+
+pthread_key_t g_thread_cache_key;
+pthread_once_t g_thread_cache_key_once = PTHREAD_ONCE_INIT;
+
+void DestroyThreadCache(void* value) {
+  ThreadCache* cache = static_cast<ThreadCache*>(value);
+  for (uint32_t size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+    FreeBuffer* buffer = cache->free_lists[size_class];
+    while (buffer) {
+      FreeBuffer* next = buffer->next;
+      free(HeaderFromBuffer(buffer));
+      buffer = next;
+    }
+  }
+  free(cache);
+}
+
+void CreateThreadCacheKey() {
+  int result = pthread_key_create(&g_thread_cache_key, &DestroyThreadCache);
+  MOJO_CHECK(result == 0);
+}
+
+// Returns the calling thread's cache, creating it if |create| is true.
+ThreadCache* GetThreadCache(bool create) {
+  pthread_once(&g_thread_cache_key_once, &CreateThreadCacheKey);
+  ThreadCache* cache =
+      static_cast<ThreadCache*>(pthread_getspecific(g_thread_cache_key));
+  if (!cache && create) {
+    cache = static_cast<ThreadCache*>(calloc(1, sizeof(ThreadCache)));
+    pthread_setspecific(g_thread_cache_key, cache);
+  }
+  return cache;
+}
+
+#else  // _WIN32
+
+// Windows TLS slots don't run destructors on thread exit, so buffers aren't
+// cached there.
+ThreadCache* GetThreadCache(bool create) {
+  return nullptr;
+}
+
+#endif  // _WIN32
+
+}  // namespace
+
+void* AllocMessageBuffer(size_t num_bytes) {
+  uint32_t size_class = SizeClassFor(num_bytes);
+
+  if (size_class != kUncachedSizeClass) {
+    ThreadCache* cache = GetThreadCache(true);
+    if (cache && cache->free_lists[size_class]) {
+      FreeBuffer* buffer = cache->free_lists[size_class];
+      cache->free_lists[size_class] = buffer->next;
+      cache->num_free_buffers[size_class]--;
+      return buffer;
+    }
+    num_bytes = SizeClassNumBytes(size_class);
+  }
+
+  BufferHeader* header =
+      static_cast<BufferHeader*>(malloc(sizeof(BufferHeader) + num_bytes));
+  MOJO_CHECK(header);
+  header->size_class = size_class;
+  header->padding = 0;
+  return BufferFromHeader(header);
+}
+
+void FreeMessageBuffer(void* buffer) {
+  if (!buffer)
+    return;
+
+  BufferHeader* header = HeaderFromBuffer(buffer);
+  uint32_t size_class = header->size_class;
+  MOJO_DCHECK(size_class < kNumSizeClasses ||
+              size_class == kUncachedSizeClass);
+
+  if (size_class != kUncachedSizeClass) {
+    // Threads that never allocate don't get a cache just for freeing; this
+    // also avoids resurrecting the cache during thread teardown.
+    ThreadCache* cache = GetThreadCache(false);
+    if (cache &&
+        cache->num_free_buffers[size_class] < kMaxCachedBuffersPerClass) {
+      FreeBuffer* free_buffer = static_cast<FreeBuffer*>(buffer);
+      free_buffer->next = cache->free_lists[size_class];
+      cache->free_lists[size_class] = free_buffer;
+      cache->num_free_buffers[size_class]++;
+      return;
+    }
+  }
+
+  free(header);
+}
+
+}  // namespace internal
+}  // namespace mojo
@@ -0,0 +1,31 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_BUFFER_POOL_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_BUFFER_POOL_H_
+
+#include <stddef.h>
+
+namespace mojo {
+namespace internal {
+
+// Message data buffers are recycled through a per-thread cache of free
+// buffers, bucketed by size class, so that sending and receiving small
+// messages doesn't hit the allocator every time. Buffers larger than the
+// largest size class are not cached.
+//
+// A buffer may be freed on a different thread than the one that allocated it,
+// in which case it is cached by the freeing thread.
+
+// Returns an 8-byte aligned buffer of at least |num_bytes| bytes. Its contents
+// are unspecified.
+void* AllocMessageBuffer(size_t num_bytes);
+
+// Frees a buffer returned by AllocMessageBuffer(). |buffer| may be null.
+void FreeMessageBuffer(void* buffer);
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_BUFFER_POOL_H_
@@ -4,6 +4,9 @@
 
 #include "mojo/public/cpp/bindings/lib/message_builder.h"
 
+#include <string.h>
+
+#include "mojo/public/cpp/bindings/bindings_instrumentation.h"
 #include "mojo/public/cpp/bindings/lib/bindings_serialization.h"
 #include "mojo/public/cpp/bindings/message.h"
 
@@ -11,6 +14,7 @@ namespace mojo {
 namespace {
 using internal::MessageHeader;
 using internal::MessageHeaderWithRequestID;
+using internal::MessageHeaderWithSendTime;
 
 template <typename Header>
 void Allocate(internal::Buffer* buf, Header** header) {
@@ -26,7 +30,12 @@ MessageWithRequestIDBuilder::MessageWithRequestIDBuilder(uint32_t name,
                                                          size_t payload_size,
                                                          uint32_t flags,
                                                          uint64_t request_id) {
-  Initialize(sizeof(MessageHeaderWithRequestID) + payload_size);
+  if (GetBindingsInstrumentation()) {
+    InitializeWithSendTime(name, flags, request_id, payload_size);
+    return;
+  }
+
+  Initialize(sizeof(MessageHeaderWithRequestID), payload_size);
   MessageHeaderWithRequestID* header;
   Allocate(&buf_, &header);
   header->version = 1;
@@ -38,7 +47,12 @@ MessageWithRequestIDBuilder::MessageWithRequestIDBuilder(uint32_t name,
 }  // namespace internal
 
 MessageBuilder::MessageBuilder(uint32_t name, size_t payload_size) {
-  Initialize(sizeof(MessageHeader) + payload_size);
+  if (GetBindingsInstrumentation()) {
+    InitializeWithSendTime(name, 0, 0, payload_size);
+    return;
+  }
+
+  Initialize(sizeof(MessageHeader), payload_size);
 
   MessageHeader* header;
   Allocate(&buf_, &header);
@@ -52,9 +66,33 @@ MessageBuilder::~MessageBuilder() {
 
 MessageBuilder::MessageBuilder() {}
 
-void MessageBuilder::Initialize(size_t size) {
-  message_.AllocData(static_cast<uint32_t>(internal::Align(size)));
+void MessageBuilder::Initialize(size_t header_size, size_t payload_size) {
+  size_t size = internal::Align(header_size + payload_size);
+  message_.AllocUninitializedData(static_cast<uint32_t>(size));
+
+  // The constructors write every byte of the header, so only the payload needs
+  // zeroing: serialization leaves padding, bit-packed bools and absent
+  // nullable fields untouched.
+  memset(message_.mutable_data() + header_size, 0, size - header_size);
   buf_.Initialize(message_.mutable_data(), message_.data_num_bytes());
 }
 
+void MessageBuilder::InitializeWithSendTime(uint32_t name,
+                                            uint32_t flags,
+                                            uint64_t request_id,
+                                            size_t payload_size) {
+  Initialize(sizeof(MessageHeaderWithSendTime), payload_size);
+
+  MessageHeaderWithSendTime* header;
+  Allocate(&buf_, &header);
+  header->version = 3;
+  header->name = name;
+  header->flags = flags;
+  header->request_id = request_id;
+  header->interface_id = internal::kMasterInterfaceId;
+  header->padding = 0;
+  // Set by the router when the message is written.
+  header->send_time_ticks = 0;
+}
+
 }  // namespace mojo
@@ -38,7 +38,15 @@ class MessageBuilder {
 
  protected:
   MessageBuilder();
-  void Initialize(size_t size);
+  // Allocates the message data. The header is left for the caller to fill in
+  // completely; the payload is zeroed.
+  void Initialize(size_t header_size, size_t payload_size);
+  // Initializes the message with a version 3 header, which has room for the
+  // send time. Used while bindings instrumentation is enabled.
+  void InitializeWithSendTime(uint32_t name,
+                              uint32_t flags,
+                              uint64_t request_id,
+                              size_t payload_size);
 
   Message message_;
   internal::FixedBuffer buf_;
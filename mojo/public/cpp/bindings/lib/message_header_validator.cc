@@ -33,10 +33,17 @@ ValidationError ValidateMessageHeader(const MessageHeader* header,
           << "message header (version = 1) size is incorrect";
       return ValidationError::UNEXPECTED_STRUCT_HEADER;
     }
-  } else if (header->version > 1) {
-    if (header->num_bytes < sizeof(MessageHeaderWithRequestID)) {
+  } else if (header->version == 2) {
+    if (header->num_bytes != sizeof(MessageHeaderWithInterfaceID)) {
       MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
-          << "message header (version > 1) size is too small";
+          << "message header (version = 2) size is incorrect";
+      return ValidationError::UNEXPECTED_STRUCT_HEADER;
+    }
+  } else if (header->version > 2) {
+    // Version 3 adds |send_time_ticks|, which Message::send_time() reads.
+    if (header->num_bytes < sizeof(MessageHeaderWithSendTime)) {
+      MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+          << "message header (version > 2) size is too small";
       return ValidationError::UNEXPECTED_STRUCT_HEADER;
     }
   }
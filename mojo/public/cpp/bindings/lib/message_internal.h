@@ -6,6 +6,7 @@
 #define MOJO_PUBLIC_CPP_BINDINGS_LIB_MESSAGE_INTERNAL_H_
 
 #include "mojo/public/cpp/bindings/lib/bindings_internal.h"
+#include "mojo/public/cpp/bindings/lib/interface_id.h"
 
 namespace mojo {
 namespace internal {
@@ -26,6 +27,24 @@ struct MessageHeaderWithRequestID : MessageHeader {
 static_assert(sizeof(MessageHeaderWithRequestID) == 24,
               "Bad sizeof(MessageHeaderWithRequestID)");
 
+// Version 2 of the header is only used by messages addressed to an associated
+// interface, i.e., an interface other than the master interface of the pipe.
+struct MessageHeaderWithInterfaceID : MessageHeaderWithRequestID {
+  InterfaceId interface_id;
+  uint32_t padding;
+};
+static_assert(sizeof(MessageHeaderWithInterfaceID) == 32,
+              "Bad sizeof(MessageHeaderWithInterfaceID)");
+
+// Version 3 of the header is only used while bindings instrumentation is
+// enabled (see bindings_instrumentation.h). |send_time_ticks| is the
+// MojoTimeTicks at which the sender wrote the message, or 0 if unknown.
+struct MessageHeaderWithSendTime : MessageHeaderWithInterfaceID {
+  int64_t send_time_ticks;
+};
+static_assert(sizeof(MessageHeaderWithSendTime) == 40,
+              "Bad sizeof(MessageHeaderWithSendTime)");
+
 struct MessageData {
   MessageHeader header;
 };
@@ -31,6 +31,7 @@ ValidationError ValidateMessagePayload(const Message* message,
                                        std::string* err) {
   BoundsChecker bounds_checker(message->payload(), message->payload_num_bytes(),
                                message->handles()->size());
+  bounds_checker.set_handles(message->handles());
   return ParamsType::Validate(message->payload(), &bounds_checker, err);
 }
 
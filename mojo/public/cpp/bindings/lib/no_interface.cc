@@ -7,6 +7,7 @@
 namespace mojo {
 
 const char* NoInterface::Name_ = "mojo::NoInterface";
+const char NoInterface::QualifiedName_[] = "mojo.NoInterface";
 
 bool NoInterfaceStub::Accept(Message* message) {
   return false;
@@ -4,10 +4,126 @@
 
 #include "mojo/public/cpp/bindings/lib/router.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "mojo/public/cpp/bindings/bindings_instrumentation.h"
+#include "mojo/public/cpp/bindings/lib/bindings_serialization.h"
+#include "mojo/public/cpp/bindings/lib/interface_endpoint_client.h"
+#include "mojo/public/cpp/bindings/lib/message_builder.h"
+#include "mojo/public/cpp/bindings/lib/validation_errors.h"
 #include "mojo/public/cpp/environment/logging.h"
 
 namespace mojo {
 namespace internal {
+namespace {
+
+// Sent on an associated interface ID to let the other side of the pipe know
+// that the sender closed its endpoint. The ordinal is reserved next to the
+// interface control messages (see interface_control_messages.mojom); it is
+// only ever intercepted by the router and never reaches user code.
+const uint32_t kPeerAssociatedEndpointClosedMessageId = 0xFFFFFFFD;
+
+// Carries a run of messages written while batching (see Router::BeginBatch()).
+// The payload is a sequence of entries, each a BatchEntryHeader followed by the
+// bytes of one message padded to 8 bytes. The handles of all the messages are
+// attached to the batch message in order.
+const uint32_t kBatchMessageId = 0xFFFFFFFC;
+
+// Batches are flushed before they grow beyond this size. Larger messages are
+// never batched.
+const size_t kMaxBatchNumBytes = 64 * 1024;
+
+// Bounds the associated interface IDs that the other side can make us keep
+// track of before it sends them to us. More are a validation error.
+const size_t kMaxUnclaimedPeerEndpoints = 64;
+
+#pragma pack(push, 1)
+struct BatchEntryHeader {
+  uint32_t num_bytes;
+  uint32_t num_handles;
+};
+#pragma pack(pop)
+static_assert(sizeof(BatchEntryHeader) == 8, "Bad sizeof(BatchEntryHeader)");
+
+bool IsBatchMessage(const Message& message) {
+  return message.data_num_bytes() >= sizeof(MessageHeader) &&
+         message.header()->num_bytes == sizeof(MessageHeader) &&
+         message.name() == kBatchMessageId;
+}
+
+// Packs |messages| into |batch|, transferring their handles.
+void BuildBatchMessage(const std::vector<Message*>& messages,
+                       size_t payload_num_bytes,
+                       Message* batch) {
+  // Every byte is written below, so the data needn't be zeroed first.
+  batch->AllocUninitializedData(
+      static_cast<uint32_t>(sizeof(MessageHeader) + payload_num_bytes));
+
+  MessageHeader* header = reinterpret_cast<MessageHeader*>(
+      batch->mutable_data());
+  header->num_bytes = sizeof(MessageHeader);
+  header->version = 0;
+  header->name = kBatchMessageId;
+  header->flags = 0;
+
+  uint8_t* cursor = batch->mutable_payload();
+  std::vector<Handle>* handles = batch->mutable_handles();
+  for (size_t i = 0; i < messages.size(); ++i) {
+    Message* message = messages[i];
+    BatchEntryHeader* entry = reinterpret_cast<BatchEntryHeader*>(cursor);
+    entry->num_bytes = message->data_num_bytes();
+    entry->num_handles =
+        static_cast<uint32_t>(message->mutable_handles()->size());
+    cursor += sizeof(BatchEntryHeader);
+
+    size_t num_bytes = message->data_num_bytes();
+    memcpy(cursor, message->data(), num_bytes);
+    memset(cursor + num_bytes, 0, Align(num_bytes) - num_bytes);
+    cursor += Align(num_bytes);
+
+    handles->insert(handles->end(), message->mutable_handles()->begin(),
+                    message->mutable_handles()->end());
+    message->mutable_handles()->clear();
+  }
+  MOJO_DCHECK(cursor == batch->mutable_payload() + payload_num_bytes);
+}
+
+// Copies |message| into |framed|, whose header addresses it to the associated
+// interface |id|. The payload only contains relative pointers, so it can be
+// moved behind a larger header as is. Handles are transferred.
+void FrameAssociatedMessage(InterfaceId id,
+                            Message* message,
+                            Message* framed) {
+  // Keep the send time, if the message has one.
+  bool has_send_time = message->has_send_time();
+  uint32_t header_num_bytes = has_send_time
+                                  ? sizeof(MessageHeaderWithSendTime)
+                                  : sizeof(MessageHeaderWithInterfaceID);
+  uint32_t payload_num_bytes = message->payload_num_bytes();
+  framed->AllocUninitializedData(header_num_bytes + payload_num_bytes);
+
+  MessageHeaderWithInterfaceID* header =
+      reinterpret_cast<MessageHeaderWithInterfaceID*>(framed->mutable_data());
+  header->num_bytes = header_num_bytes;
+  header->version = has_send_time ? 3 : 2;
+  header->name = message->name();
+  header->flags = message->header()->flags;
+  header->request_id = message->has_request_id() ? message->request_id() : 0;
+  header->interface_id = id;
+  header->padding = 0;
+  if (has_send_time)
+    framed->set_send_time(message->send_time());
+
+  if (payload_num_bytes)
+    memcpy(framed->mutable_payload(), message->payload(), payload_num_bytes);
+  framed->mutable_handles()->swap(*message->mutable_handles());
+}
+
+}  // namespace
 
 // ----------------------------------------------------------------------------
 
@@ -68,35 +184,103 @@ bool Router::HandleIncomingMessageThunk::Accept(Message* message) {
   return router_->HandleIncomingMessage(message);
 }
 
+Router::DemuxIncomingMessageThunk::DemuxIncomingMessageThunk(Router* router)
+    : router_(router) {
+}
+
+Router::DemuxIncomingMessageThunk::~DemuxIncomingMessageThunk() {
+}
+
+bool Router::DemuxIncomingMessageThunk::Accept(Message* message) {
+  return router_->DemuxIncomingMessage(message);
+}
+
+// ----------------------------------------------------------------------------
+
+Router::HandleAssociatedMessageThunk::HandleAssociatedMessageThunk(
+    Router* router)
+    : router_(router) {
+}
+
+Router::HandleAssociatedMessageThunk::~HandleAssociatedMessageThunk() {
+}
+
+bool Router::HandleAssociatedMessageThunk::Accept(Message* message) {
+  return router_->HandleAssociatedMessage(message);
+}
+
+// ----------------------------------------------------------------------------
+
+Router::Endpoint::Endpoint()
+    : claimed(false), closed(false), peer_closed(false), client(nullptr) {
+}
+
+Router::Endpoint::~Endpoint() {
+  for (std::deque<Message*>::iterator it = pending_messages.begin();
+       it != pending_messages.end(); ++it) {
+    delete *it;
+  }
+}
+
 // ----------------------------------------------------------------------------
 
 Router::Router(ScopedMessagePipeHandle message_pipe,
                FilterChain filters,
                const MojoAsyncWaiter* waiter)
     : thunk_(this),
+      demux_thunk_(this),
+      associated_thunk_(this),
       filters_(filters.Pass()),
+      associated_validator_(&associated_thunk_),
       connector_(message_pipe.Pass(), waiter),
       weak_self_(this),
       incoming_receiver_(nullptr),
       next_request_id_(0),
-      testing_mode_(false) {
+      testing_mode_(false),
+      interface_id_namespace_bit_(0u),
+      next_interface_id_(1u),
+      num_unclaimed_peer_endpoints_(0u),
+      batch_depth_(0u),
+      batched_num_bytes_(0u),
+      dispatching_batch_with_tail_(false),
+      instrumentation_(nullptr),
+      interface_name_(nullptr),
+      method_name_getter_(nullptr),
+      pending_responses_counter_(nullptr) {
   filters_.SetSink(&thunk_);
-  connector_.set_incoming_receiver(filters_.GetHead());
+  connector_.set_incoming_receiver(&demux_thunk_);
+  connector_.set_connection_error_handler(
+      [this]() { OnConnectionError(); });
 }
 
 Router::~Router() {
+  // Messages written before the router goes away are delivered, batched or
+  // not. Anything written from here on (e.g. endpoint closure notifications)
+  // goes straight to the pipe.
+  FlushBatch();
+  batch_depth_ = 0u;
+
+  // Associated endpoints can't outlive the pipe. Their clients may still
+  // detach (or close other endpoints) from within their error handlers, so
+  // |weak_self_| is only reset afterwards.
+  NotifyEndpointsOfPeerClosure();
   weak_self_.set_value(nullptr);
 
+  delete pending_responses_counter_;
   for (ResponderMap::const_iterator i = responders_.begin();
        i != responders_.end();
        ++i) {
-    delete i->second;
+    delete i->second.responder;
   }
 }
 
 bool Router::Accept(Message* message) {
   MOJO_DCHECK(!message->has_flag(kMessageExpectsResponse));
-  return connector_.Accept(message);
+  if (message->has_send_time())
+    message->set_send_time(MojoGetTimeTicksNow());
+  if (instrumentation_)
+    RecordSentMessage(*message);
+  return WriteMessage(message);
 }
 
 bool Router::AcceptWithResponder(Message* message, MessageReceiver* responder) {
@@ -108,20 +292,99 @@ bool Router::AcceptWithResponder(Message* message, MessageReceiver* responder) {
     request_id = next_request_id_++;
 
   message->set_request_id(request_id);
-  if (!connector_.Accept(message))
+
+  PendingResponse pending_response;
+  pending_response.responder = responder;
+  pending_response.send_time = 0;
+  if (message->has_send_time() || instrumentation_) {
+    pending_response.send_time = MojoGetTimeTicksNow();
+    if (message->has_send_time())
+      message->set_send_time(pending_response.send_time);
+  }
+  if (instrumentation_)
+    RecordSentMessage(*message);
+
+  if (!WriteMessage(message))
     return false;
 
   // We assume ownership of |responder|.
-  responders_[request_id] = responder;
+  responders_[request_id] = pending_response;
+  if (pending_responses_counter_)
+    pending_responses_counter_->Add(1, GetPendingResponseNumBytes());
   return true;
 }
 
+ScopedMessagePipeHandle Router::PassMessagePipe() {
+  FlushBatch();
+  if (dispatching_batch_with_tail_) {
+    MOJO_LOG(ERROR) << "Can't pass a message pipe while dispatching a batch; "
+                    << "closing it instead";
+    connector_.CloseMessagePipe();
+    return ScopedMessagePipeHandle();
+  }
+  return connector_.PassMessagePipe();
+}
+
+void Router::EndBatch() {
+  MOJO_DCHECK(batch_depth_ > 0u);
+  if (--batch_depth_ == 0u)
+    FlushBatch();
+}
+
+void Router::EnableInstrumentation(const char* interface_name,
+                                   MethodNameGetter method_name_getter) {
+  instrumentation_ = GetBindingsInstrumentation();
+  interface_name_ = interface_name;
+  method_name_getter_ = method_name_getter;
+  if (instrumentation_ && !pending_responses_counter_) {
+    pending_responses_counter_ =
+        instrumentation_->CreatePendingResponsesCounter(interface_name);
+  }
+}
+
 void Router::EnableTestingMode() {
   testing_mode_ = true;
   connector_.set_enforce_errors_from_incoming_receiver(false);
 }
 
 bool Router::HandleIncomingMessage(Message* message) {
+  if (!instrumentation_)
+    return DispatchIncomingMessage(message);
+
+  // Dispatch may destroy |this|, so everything needed afterwards is copied.
+  BindingsInstrumentation* instrumentation = instrumentation_;
+  const char* interface_name = interface_name_;
+  const char* method_name = method_name_getter_(message->name());
+  bool is_response = message->has_flag(kMessageIsResponse);
+  uint32_t num_bytes = message->data_num_bytes();
+
+  MojoTimeTicks start_time = MojoGetTimeTicksNow();
+  MojoTimeTicks queueing_time = -1;
+  if (message->has_send_time() && message->send_time() != 0)
+    queueing_time = start_time - message->send_time();
+  MojoTimeTicks round_trip_time = -1;
+  if (is_response) {
+    ResponderMap::const_iterator it = responders_.find(message->request_id());
+    if (it != responders_.end() && it->second.send_time != 0)
+      round_trip_time = start_time - it->second.send_time;
+  }
+
+  bool result = DispatchIncomingMessage(message);
+
+  // Control messages have no method name, and aren't recorded.
+  if (method_name) {
+    instrumentation->OnMessageDispatched(
+        interface_name, method_name, is_response, num_bytes, queueing_time,
+        MojoGetTimeTicksNow() - start_time);
+    if (round_trip_time >= 0) {
+      instrumentation->OnResponseReceived(interface_name, method_name,
+                                          round_trip_time);
+    }
+  }
+  return result;
+}
+
+bool Router::DispatchIncomingMessage(Message* message) {
   if (message->has_flag(kMessageExpectsResponse)) {
     if (incoming_receiver_) {
       MessageReceiverWithStatus* responder = new ResponderThunk(weak_self_);
@@ -141,8 +404,13 @@ bool Router::HandleIncomingMessage(Message* message) {
       MOJO_DCHECK(testing_mode_);
       return false;
     }
-    MessageReceiver* responder = it->second;
+    MessageReceiver* responder = it->second.responder;
     responders_.erase(it);
+    // |responder| may destroy |this|, so this is reported first.
+    if (pending_responses_counter_) {
+      pending_responses_counter_->Add(
+          -1, -static_cast<int64_t>(GetPendingResponseNumBytes()));
+    }
     bool ok = responder->Accept(message);
     delete responder;
     return ok;
@@ -155,6 +423,350 @@ bool Router::HandleIncomingMessage(Message* message) {
   return false;
 }
 
+void Router::CreateEndpointHandlePair(
+    ScopedInterfaceEndpointHandle* local_endpoint,
+    ScopedInterfaceEndpointHandle* remote_endpoint) {
+  InterfaceId id;
+  do {
+    id = (next_interface_id_++ & ~kInterfaceIdNamespaceMask) |
+         interface_id_namespace_bit_;
+  } while (IsMasterInterfaceId(id) || !IsValidInterfaceId(id) ||
+           endpoints_.find(id) != endpoints_.end());
+
+  endpoints_[id].claimed = true;
+  *local_endpoint = ScopedInterfaceEndpointHandle(id, true, weak_self_);
+  *remote_endpoint = ScopedInterfaceEndpointHandle(id, false, weak_self_);
+}
+
+ScopedInterfaceEndpointHandle Router::CreateLocalEndpointHandle(
+    InterfaceId id) {
+  if (!IsValidInterfaceId(id) || IsMasterInterfaceId(id) ||
+      (id & kInterfaceIdNamespaceMask) == interface_id_namespace_bit_) {
+    return ScopedInterfaceEndpointHandle();
+  }
+
+  EndpointMap::iterator it = endpoints_.find(id);
+  if (it == endpoints_.end()) {
+    it = endpoints_.insert(std::make_pair(id, Endpoint())).first;
+  } else if (it->second.claimed) {
+    return ScopedInterfaceEndpointHandle();
+  } else {
+    num_unclaimed_peer_endpoints_--;
+  }
+  it->second.claimed = true;
+  return ScopedInterfaceEndpointHandle(id, true, weak_self_);
+}
+
+void Router::CloseEndpointHandle(InterfaceId id, bool is_local) {
+  EndpointMap::iterator it = endpoints_.find(id);
+  MOJO_DCHECK(it != endpoints_.end());
+  if (it == endpoints_.end())
+    return;
+
+  Endpoint& endpoint = it->second;
+  if (is_local) {
+    MOJO_DCHECK(!endpoint.client);
+    MOJO_DCHECK(!endpoint.closed);
+    endpoint.closed = true;
+    if (!endpoint.peer_closed)
+      NotifyPeerOfEndpointClosure(id);
+    MaybeEraseEndpoint(it);
+    return;
+  }
+
+  // The remote endpoint was dropped before it could be sent.
+  if (endpoint.peer_closed)
+    return;
+  endpoint.peer_closed = true;
+  InterfaceEndpointClient* client = endpoint.client;
+  MaybeEraseEndpoint(it);
+  if (client)
+    client->NotifyError();
+}
+
+void Router::AttachEndpointClient(InterfaceId id,
+                                  InterfaceEndpointClient* client) {
+  EndpointMap::iterator it = endpoints_.find(id);
+  MOJO_DCHECK(it != endpoints_.end());
+  MOJO_DCHECK(!it->second.closed);
+  MOJO_DCHECK(!it->second.client);
+  it->second.client = client;
+}
+
+void Router::DispatchPendingMessages(InterfaceId id) {
+  SharedData<Router*> weak_self = weak_self_;
+  EndpointMap::iterator it = endpoints_.find(id);
+  if (it == endpoints_.end() || !it->second.client)
+    return;
+  InterfaceEndpointClient* client = it->second.client;
+
+  while (!it->second.pending_messages.empty()) {
+    Message* message = it->second.pending_messages.front();
+    it->second.pending_messages.pop_front();
+    bool ok = client->HandleIncomingMessage(message);
+    delete message;
+
+    // Dispatching may detach |client| or destroy |this|, so look the endpoint
+    // up again after each message.
+    if (!weak_self.value())
+      return;
+    if (!ok && !testing_mode_) {
+      connector_.CloseMessagePipe();
+      return;
+    }
+    it = endpoints_.find(id);
+    if (it == endpoints_.end() || it->second.client != client)
+      return;
+  }
+
+  if (it->second.peer_closed || encountered_error())
+    client->NotifyError();
+}
+
+void Router::DetachEndpointClient(InterfaceId id) {
+  EndpointMap::iterator it = endpoints_.find(id);
+  if (it != endpoints_.end())
+    it->second.client = nullptr;
+}
+
+bool Router::SendAssociatedMessage(InterfaceId id, Message* message) {
+  EndpointMap::iterator it = endpoints_.find(id);
+  MOJO_DCHECK(it != endpoints_.end() && !it->second.closed);
+  if (it == endpoints_.end() || it->second.peer_closed) {
+    // Nobody is listening on the other side; drop the message, just as writes
+    // to a closed message pipe are dropped.
+    return true;
+  }
+
+  Message framed;
+  FrameAssociatedMessage(id, message, &framed);
+  return WriteMessage(&framed);
+}
+
+bool Router::DemuxIncomingMessage(Message* message) {
+  if (IsBatchMessage(*message))
+    return DispatchBatch(message);
+  return DemuxUnbatchedMessage(message);
+}
+
+bool Router::DemuxUnbatchedMessage(Message* message) {
+  // Only messages with a version 2 header can be addressed to an associated
+  // interface; everything else takes the usual path, untouched.
+  if (message->data_num_bytes() >= sizeof(MessageHeaderWithInterfaceID) &&
+      message->header()->num_bytes >= sizeof(MessageHeaderWithInterfaceID) &&
+      !IsMasterInterfaceId(message->interface_id())) {
+    return associated_validator_.Accept(message);
+  }
+  return filters_.GetHead()->Accept(message);
+}
+
+bool Router::DispatchBatch(Message* batch) {
+  const uint8_t* payload = batch->payload();
+  uint32_t payload_num_bytes = batch->payload_num_bytes();
+  std::vector<Handle>* handles = batch->mutable_handles();
+  size_t next_handle = 0;
+
+  SharedData<Router*> weak_self = weak_self_;
+  uint32_t offset = 0;
+  while (offset < payload_num_bytes) {
+    if (payload_num_bytes - offset < sizeof(BatchEntryHeader)) {
+      ReportValidationError(ValidationError::ILLEGAL_MEMORY_RANGE);
+      return false;
+    }
+    const BatchEntryHeader* entry =
+        reinterpret_cast<const BatchEntryHeader*>(payload + offset);
+    offset += sizeof(BatchEntryHeader);
+    if (entry->num_bytes > payload_num_bytes - offset) {
+      ReportValidationError(ValidationError::ILLEGAL_MEMORY_RANGE);
+      return false;
+    }
+    if (entry->num_handles > handles->size() - next_handle) {
+      ReportValidationError(ValidationError::ILLEGAL_HANDLE);
+      return false;
+    }
+
+    // Batches don't nest, so a batch inside a batch takes the regular path
+    // and is rejected by the validators as an unknown message.
+    Message message;
+    message.AllocUninitializedData(entry->num_bytes);
+    memcpy(message.mutable_data(), payload + offset, entry->num_bytes);
+    for (uint32_t i = 0; i < entry->num_handles; ++i) {
+      message.mutable_handles()->push_back((*handles)[next_handle]);
+      (*handles)[next_handle++] = Handle();
+    }
+    offset += static_cast<uint32_t>(
+        std::min<size_t>(Align(entry->num_bytes), payload_num_bytes - offset));
+
+    const bool was_dispatching_batch_with_tail = dispatching_batch_with_tail_;
+    dispatching_batch_with_tail_ = offset < payload_num_bytes;
+    bool ok = DemuxUnbatchedMessage(&message);
+    if (!weak_self.value())
+      return ok;
+    dispatching_batch_with_tail_ = was_dispatching_batch_with_tail;
+    if (!ok)
+      return false;
+
+    // Dispatching a message may close the pipe, after which the rest of the
+    // batch is dropped, just like messages left in the pipe. (Passing the pipe
+    // on would also drop them, which is why PassMessagePipe() refuses to.)
+    if (!connector_.is_valid() || connector_.encountered_error())
+      return true;
+  }
+  return true;
+}
+
+bool Router::HandleAssociatedMessage(Message* message) {
+  InterfaceId id = message->interface_id();
+  EndpointMap::iterator it = endpoints_.find(id);
+  if (it == endpoints_.end() &&
+      (id & kInterfaceIdNamespaceMask) != interface_id_namespace_bit_) {
+    // The other side may use an endpoint as soon as it has allocated it, so
+    // messages can arrive before the one that carries the endpoint to us.
+    if (num_unclaimed_peer_endpoints_ >= kMaxUnclaimedPeerEndpoints) {
+      ReportValidationError(ValidationError::ILLEGAL_INTERFACE_ID);
+      return false;
+    }
+    it = endpoints_.insert(std::make_pair(id, Endpoint())).first;
+    num_unclaimed_peer_endpoints_++;
+  }
+
+  if (message->name() == kPeerAssociatedEndpointClosedMessageId) {
+    if (it == endpoints_.end() || it->second.peer_closed)
+      return true;
+    it->second.peer_closed = true;
+    InterfaceEndpointClient* client = it->second.client;
+    MaybeEraseEndpoint(it);
+    if (client)
+      client->NotifyError();
+    return true;
+  }
+
+  // Messages for endpoints that we allocated and have since forgotten, or that
+  // are closed on this side, are discarded.
+  if (it == endpoints_.end() || it->second.closed)
+    return true;
+
+  Endpoint& endpoint = it->second;
+  if (!endpoint.client) {
+    Message* pending = new Message();
+    message->MoveTo(pending);
+    endpoint.pending_messages.push_back(pending);
+    return true;
+  }
+  return endpoint.client->HandleIncomingMessage(message);
+}
+
+// static
+size_t Router::GetPendingResponseNumBytes() {
+  // The map node: the entry, the tree links and the node's color.
+  return sizeof(ResponderMap::value_type) + 4 * sizeof(void*);
+}
+
+void Router::RecordSentMessage(const Message& message) {
+  const char* method_name = method_name_getter_(message.name());
+  if (!method_name)
+    return;
+  instrumentation_->OnMessageSent(interface_name_, method_name,
+                                  message.has_flag(kMessageIsResponse),
+                                  message.data_num_bytes());
+}
+
+bool Router::WriteMessage(Message* message) {
+  if (!batch_depth_ || message->has_flag(kMessageExpectsResponse) ||
+      message->data_num_bytes() > kMaxBatchNumBytes) {
+    // Anything already batched must go out first.
+    FlushBatch();
+    return connector_.Accept(message);
+  }
+
+  // Mirror Connector::Accept(), which fails once the pipe has seen an error.
+  if (connector_.encountered_error())
+    return false;
+
+  size_t entry_num_bytes =
+      sizeof(BatchEntryHeader) + Align(message->data_num_bytes());
+  if (batched_num_bytes_ + entry_num_bytes > kMaxBatchNumBytes)
+    FlushBatch();
+
+  Message* batched = new Message();
+  message->MoveTo(batched);
+  batched_messages_.push_back(batched);
+  batched_num_bytes_ += entry_num_bytes;
+  return true;
+}
+
+bool Router::FlushBatch() {
+  if (batched_messages_.empty())
+    return true;
+
+  std::vector<Message*> messages;
+  messages.swap(batched_messages_);
+  size_t payload_num_bytes = batched_num_bytes_;
+  batched_num_bytes_ = 0;
+
+  bool result;
+  if (messages.size() == 1) {
+    // Not worth the extra copy on either side.
+    result = connector_.Accept(messages[0]);
+  } else {
+    Message batch;
+    BuildBatchMessage(messages, payload_num_bytes, &batch);
+    result = connector_.Accept(&batch);
+  }
+
+  for (size_t i = 0; i < messages.size(); ++i)
+    delete messages[i];
+  return result;
+}
+
+void Router::OnConnectionError() {
+  if (!NotifyEndpointsOfPeerClosure())
+    return;
+  if (!connection_error_handler_.is_null())
+    connection_error_handler_.Run();
+}
+
+bool Router::NotifyEndpointsOfPeerClosure() {
+  std::vector<InterfaceId> ids_to_notify;
+  for (EndpointMap::iterator it = endpoints_.begin(); it != endpoints_.end();) {
+    EndpointMap::iterator current = it++;
+    if (current->second.peer_closed)
+      continue;
+    current->second.peer_closed = true;
+    if (current->second.client)
+      ids_to_notify.push_back(current->first);
+    else
+      MaybeEraseEndpoint(current);
+  }
+
+  SharedData<Router*> weak_self = weak_self_;
+  for (size_t i = 0; i < ids_to_notify.size(); ++i) {
+    // An error handler may detach or close other endpoints, or destroy |this|.
+    if (!weak_self.value())
+      return false;
+    EndpointMap::iterator it = endpoints_.find(ids_to_notify[i]);
+    if (it != endpoints_.end() && it->second.client)
+      it->second.client->NotifyError();
+  }
+  return !!weak_self.value();
+}
+
+void Router::NotifyPeerOfEndpointClosure(InterfaceId id) {
+  if (!connector_.is_valid() || connector_.encountered_error())
+    return;
+
+  MessageBuilder builder(kPeerAssociatedEndpointClosedMessageId, 0);
+  Message framed;
+  FrameAssociatedMessage(id, builder.message(), &framed);
+  // Failure means the pipe is gone, in which case the peer will notice anyway.
+  (void)WriteMessage(&framed);
+}
+
+void Router::MaybeEraseEndpoint(EndpointMap::iterator it) {
+  if (it->second.closed && it->second.peer_closed)
+    endpoints_.erase(it);
+}
+
 // ----------------------------------------------------------------------------
 
 }  // namespace internal
@@ -5,17 +5,34 @@
 #ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_ROUTER_H_
 #define MOJO_PUBLIC_CPP_BINDINGS_LIB_ROUTER_H_
 
+#include <deque>
 #include <map>
+#include <vector>
 
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/bindings/lib/connector.h"
 #include "mojo/public/cpp/bindings/lib/filter_chain.h"
+#include "mojo/public/cpp/bindings/lib/interface_id.h"
+#include "mojo/public/cpp/bindings/lib/message_header_validator.h"
+#include "mojo/public/cpp/bindings/lib/scoped_interface_endpoint_handle.h"
 #include "mojo/public/cpp/bindings/lib/shared_data.h"
 #include "mojo/public/cpp/environment/environment.h"
 
 namespace mojo {
+
+class BindingsInstrumentation;
+class PendingResponsesCounter;
+
 namespace internal {
 
+class InterfaceEndpointClient;
+
+// The Router dispatches messages read from its message pipe to the master
+// interface bound to the pipe (via the incoming receiver) and, for messages
+// whose header carries a non-master interface ID, to the associated interface
+// endpoints multiplexed over the same pipe. Since all interfaces share the
+// pipe, messages are dispatched in the order they were sent, regardless of
+// which interface they are addressed to.
 class Router : public MessageReceiverWithResponder {
  public:
   Router(ScopedMessagePipeHandle message_pipe,
@@ -31,8 +48,9 @@ class Router : public MessageReceiverWithResponder {
 
   // Sets the error handler to receive notifications when an error is
   // encountered while reading from the pipe or waiting to read from the pipe.
+  // Associated endpoints are notified before the handler is run.
   void set_connection_error_handler(const Closure& error_handler) {
-    connector_.set_connection_error_handler(error_handler);
+    connection_error_handler_ = error_handler;
   }
 
   // Returns true if an error was encountered while reading from the pipe or
@@ -42,12 +60,16 @@ class Router : public MessageReceiverWithResponder {
   // Is the router bound to a MessagePipe handle?
   bool is_valid() const { return connector_.is_valid(); }
 
-  void CloseMessagePipe() { connector_.CloseMessagePipe(); }
-
-  ScopedMessagePipeHandle PassMessagePipe() {
-    return connector_.PassMessagePipe();
+  void CloseMessagePipe() {
+    FlushBatch();
+    connector_.CloseMessagePipe();
   }
 
+  // Returns an invalid handle, and closes the pipe, if called while a batch
+  // message is being dispatched and some of its messages have not been
+  // dispatched yet: those can't be handed over along with the pipe.
+  ScopedMessagePipeHandle PassMessagePipe();
+
   // MessageReceiver implementation:
   bool Accept(Message* message) override;
   bool AcceptWithResponder(Message* message,
@@ -60,6 +82,7 @@ class Router : public MessageReceiverWithResponder {
   // |MOJO_RESULT_DEADLINE_EXCEEDED|.
   // Use |encountered_error| to see if an error occurred.
   bool WaitForIncomingMessage(MojoDeadline deadline) {
+    FlushBatch();
     return connector_.WaitForIncomingMessage(deadline);
   }
 
@@ -72,8 +95,96 @@ class Router : public MessageReceiverWithResponder {
 
   MessagePipeHandle handle() const { return connector_.handle(); }
 
+  // Returns the name of the method with the given ordinal, or null if there
+  // is none.
+  typedef const char* (*MethodNameGetter)(uint32_t ordinal);
+
+  // Reports the messages sent and dispatched by this router to the bindings
+  // instrumentation, if one is installed (see bindings_instrumentation.h).
+  // |interface_name| must be a static string.
+  void EnableInstrumentation(const char* interface_name,
+                             MethodNameGetter method_name_getter);
+
+  // Batching ------------------------------------------------------------------
+
+  // Between BeginBatch() and the matching EndBatch(), messages that don't
+  // expect a response (including those on associated interfaces) are held
+  // back and written together as a single batch message, which the receiving
+  // router unpacks and dispatches in order. Writing a message that expects a
+  // response, waiting for a message, or passing or closing the pipe flushes
+  // the batch first, so the relative order of all messages is preserved.
+  // Calls may be nested; the batch is flushed when the outermost one ends.
+  void BeginBatch() { ++batch_depth_; }
+  void EndBatch();
+
+  // Associated interfaces -----------------------------------------------------
+
+  // Interface IDs allocated by the two ends of a pipe must not collide, so
+  // exactly one of the two routers (by convention, the one owned by the
+  // Binding) must set the namespace bit.
+  void set_interface_id_namespace_bit(bool set) {
+    interface_id_namespace_bit_ = set ? kInterfaceIdNamespaceMask : 0u;
+  }
+
+  // Allocates a new associated interface ID and returns handles to both of its
+  // endpoints. |local_endpoint| is meant to be used on this side of the pipe;
+  // |remote_endpoint| is meant to be sent to the other side in a message.
+  void CreateEndpointHandlePair(ScopedInterfaceEndpointHandle* local_endpoint,
+                                ScopedInterfaceEndpointHandle* remote_endpoint);
+
+  // Claims an associated interface ID received from the other side of the
+  // pipe and returns a local handle to it. Returns an invalid handle if |id|
+  // was not allocated by the other side, or has already been claimed.
+  ScopedInterfaceEndpointHandle CreateLocalEndpointHandle(InterfaceId id);
+
+  // Called by ScopedInterfaceEndpointHandle when an endpoint handle is closed.
+  void CloseEndpointHandle(InterfaceId id, bool is_local);
+
+  // Attaches |client| to the local endpoint |id|, which must not have another
+  // client attached. Messages that arrive for the endpoint while no client is
+  // attached are queued until DispatchPendingMessages() is called.
+  void AttachEndpointClient(InterfaceId id, InterfaceEndpointClient* client);
+  void DetachEndpointClient(InterfaceId id);
+
+  // Dispatches the messages queued for |id| to its client, then notifies the
+  // client if the other end is already closed. Either may destroy the client
+  // (or |this|).
+  void DispatchPendingMessages(InterfaceId id);
+
+  // Sends |message| to the other end of the associated interface |id|.
+  bool SendAssociatedMessage(InterfaceId id, Message* message);
+
+  // Returns a weak reference to this object, whose value is reset to null when
+  // this object is destroyed.
+  const SharedData<Router*>& weak_self() const { return weak_self_; }
+
  private:
-  typedef std::map<uint64_t, MessageReceiver*> ResponderMap;
+  struct PendingResponse {
+    MessageReceiver* responder;
+    // When the request was sent, if instrumentation is enabled; 0 otherwise.
+    MojoTimeTicks send_time;
+  };
+  typedef std::map<uint64_t, PendingResponse> ResponderMap;
+
+  // Bookkeeping for one associated interface ID.
+  struct Endpoint {
+    Endpoint();
+    ~Endpoint();
+
+    // Whether a local handle has been handed out for the ID. Messages may
+    // arrive for IDs allocated by the other side before the message carrying
+    // the ID itself has been dispatched; they are queued until then.
+    bool claimed;
+    // Whether the local endpoint handle has been closed.
+    bool closed;
+    // Whether the remote endpoint has been closed, either by the other side of
+    // the pipe or because the remote handle was dropped without being sent.
+    bool peer_closed;
+    InterfaceEndpointClient* client;
+    // Owned messages that arrived before |client| was attached.
+    std::deque<Message*> pending_messages;
+  };
+  typedef std::map<InterfaceId, Endpoint> EndpointMap;
 
   class HandleIncomingMessageThunk : public MessageReceiver {
    public:
@@ -87,16 +198,94 @@ class Router : public MessageReceiverWithResponder {
     Router* router_;
   };
 
+  class DemuxIncomingMessageThunk : public MessageReceiver {
+   public:
+    DemuxIncomingMessageThunk(Router* router);
+    ~DemuxIncomingMessageThunk() override;
+
+    // MessageReceiver implementation:
+    bool Accept(Message* message) override;
+
+   private:
+    Router* router_;
+  };
+
+  class HandleAssociatedMessageThunk : public MessageReceiver {
+   public:
+    HandleAssociatedMessageThunk(Router* router);
+    ~HandleAssociatedMessageThunk() override;
+
+    // MessageReceiver implementation:
+    bool Accept(Message* message) override;
+
+   private:
+    Router* router_;
+  };
+
+  // Unpacks batch messages, then sends messages addressed to the master
+  // interface down |filters_| and messages addressed to associated interfaces
+  // to |associated_validator_|.
+  bool DemuxIncomingMessage(Message* message);
+  bool DemuxUnbatchedMessage(Message* message);
+  bool DispatchBatch(Message* batch);
   bool HandleIncomingMessage(Message* message);
+  bool DispatchIncomingMessage(Message* message);
+  bool HandleAssociatedMessage(Message* message);
+
+  // The memory held for each entry of |responders_|, as counted by
+  // |pending_responses_counter_|.
+  static size_t GetPendingResponseNumBytes();
+
+  void RecordSentMessage(const Message& message);
+
+  // Writes |message| to the pipe, or appends it to the current batch.
+  bool WriteMessage(Message* message);
+  bool FlushBatch();
+
+  void OnConnectionError();
+  // Marks every associated endpoint as closed by the peer and runs the error
+  // handlers of the attached clients. Returns false if |this| was destroyed.
+  bool NotifyEndpointsOfPeerClosure();
+  void NotifyPeerOfEndpointClosure(InterfaceId id);
+  // Erases the bookkeeping for |id| once both of its ends are closed.
+  void MaybeEraseEndpoint(EndpointMap::iterator it);
 
   HandleIncomingMessageThunk thunk_;
+  DemuxIncomingMessageThunk demux_thunk_;
+  HandleAssociatedMessageThunk associated_thunk_;
   FilterChain filters_;
+  MessageHeaderValidator associated_validator_;
   Connector connector_;
   SharedData<Router*> weak_self_;
   MessageReceiverWithResponderStatus* incoming_receiver_;
+  Closure connection_error_handler_;
   ResponderMap responders_;
   uint64_t next_request_id_;
   bool testing_mode_;
+
+  EndpointMap endpoints_;
+  uint32_t interface_id_namespace_bit_;
+  InterfaceId next_interface_id_;
+  // Endpoints that messages from the other side were addressed to before a
+  // local handle was handed out for them.
+  size_t num_unclaimed_peer_endpoints_;
+
+  uint32_t batch_depth_;
+  // Owned messages held back since the current batch was last flushed, and
+  // their total size once packed into a batch message.
+  std::vector<Message*> batched_messages_;
+  size_t batched_num_bytes_;
+  // True while a message unpacked from a received batch is dispatched, if
+  // more messages follow it in the batch.
+  bool dispatching_batch_with_tail_;
+
+  // Null unless EnableInstrumentation() was called with an instrumentation
+  // installed.
+  BindingsInstrumentation* instrumentation_;
+  const char* interface_name_;
+  MethodNameGetter method_name_getter_;
+  // Owned. Null if the instrumentation doesn't count pending responses.
+  PendingResponsesCounter* pending_responses_counter_;
 };
 
 }  // namespace internal
@@ -0,0 +1,74 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_SCOPED_INTERFACE_ENDPOINT_HANDLE_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_SCOPED_INTERFACE_ENDPOINT_HANDLE_H_
+
+#include "mojo/public/cpp/bindings/lib/interface_id.h"
+#include "mojo/public/cpp/bindings/lib/shared_data.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+namespace internal {
+
+class Router;
+
+// ScopedInterfaceEndpointHandle refers to one end of an associated interface,
+// i.e., one of the interfaces multiplexed over the message pipe owned by a
+// Router. It is the associated-interface analog of ScopedMessagePipeHandle:
+// the endpoint is closed when the handle is destroyed, unless it has been
+// released for sending to the other end of the pipe.
+//
+// A "local" handle is one whose endpoint is (or will be) used on this side of
+// the pipe. A "remote" handle refers to the end that is to be sent to the
+// other side of the pipe.
+class ScopedInterfaceEndpointHandle {
+ public:
+  // Creates an invalid endpoint handle.
+  ScopedInterfaceEndpointHandle();
+
+  ScopedInterfaceEndpointHandle(ScopedInterfaceEndpointHandle&& other);
+
+  ~ScopedInterfaceEndpointHandle();
+
+  ScopedInterfaceEndpointHandle& operator=(
+      ScopedInterfaceEndpointHandle&& other);
+
+  bool is_valid() const { return IsValidInterfaceId(id_); }
+
+  InterfaceId id() const { return id_; }
+  bool is_local() const { return is_local_; }
+
+  // Returns the router that owns the endpoint, or null if the handle is
+  // invalid or the router has been destroyed.
+  Router* router() const { return router_ ? router_->value() : nullptr; }
+
+  // Closes the endpoint (if any) and makes the handle invalid.
+  void reset();
+  void swap(ScopedInterfaceEndpointHandle& other);
+
+  // Makes the handle invalid without closing the endpoint, and returns the ID.
+  // This is used when a remote handle is serialized into a message.
+  InterfaceId release();
+
+ private:
+  friend class Router;
+
+  ScopedInterfaceEndpointHandle(InterfaceId id,
+                                bool is_local,
+                                const SharedData<Router*>& router);
+
+  InterfaceId id_;
+  bool is_local_;
+  // A weak reference to the owning router; its value is reset to null when the
+  // router goes away. Only allocated for valid handles.
+  SharedData<Router*>* router_;
+
+  MOJO_MOVE_ONLY_TYPE(ScopedInterfaceEndpointHandle);
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_SCOPED_INTERFACE_ENDPOINT_HANDLE_H_
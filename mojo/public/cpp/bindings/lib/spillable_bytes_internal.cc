@@ -0,0 +1,115 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/lib/spillable_bytes_internal.h"
+
+#include <new>
+
+#include "mojo/public/cpp/bindings/lib/bindings_serialization.h"
+#include "mojo/public/cpp/bindings/lib/bounds_checker.h"
+#include "mojo/public/cpp/bindings/lib/buffer.h"
+#include "mojo/public/cpp/bindings/lib/validate_params.h"
+#include "mojo/public/cpp/bindings/lib/validation_util.h"
+
+namespace mojo {
+namespace internal {
+
+// static
+SpillableBytes_Data* SpillableBytes_Data::New(Buffer* buf) {
+  return new (buf->Allocate(sizeof(SpillableBytes_Data))) SpillableBytes_Data();
+}
+
+// static
+ValidationError SpillableBytes_Data::Validate(const void* data,
+                                              BoundsChecker* bounds_checker,
+                                              std::string* err) {
+  if (!data)
+    return ValidationError::NONE;
+
+  ValidationError retval =
+      ValidateStructHeaderAndClaimMemory(data, bounds_checker, err);
+  if (retval != ValidationError::NONE)
+    return retval;
+
+  const SpillableBytes_Data* object =
+      static_cast<const SpillableBytes_Data*>(data);
+  if (object->header_.num_bytes != sizeof(SpillableBytes_Data) ||
+      object->header_.version != 0) {
+    MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+        << "spillable bytes struct header is incorrect (size = "
+        << object->header_.num_bytes
+        << ", version = " << object->header_.version << ")";
+    return ValidationError::UNEXPECTED_STRUCT_HEADER;
+  }
+
+  if (object->bytes.offset) {
+    if (object->buffer.value() != kEncodedInvalidHandleValue) {
+      MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+          << "spillable bytes with both inline bytes and a shared buffer";
+      return ValidationError::ILLEGAL_HANDLE;
+    }
+    if (!ValidateEncodedPointer(&object->bytes.offset)) {
+      MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+          << "invalid inline bytes pointer in spillable bytes";
+      return ValidationError::ILLEGAL_POINTER;
+    }
+    const ArrayValidateParams bytes_validate_params(0, false, nullptr);
+    return Array_Data<uint8_t>::Validate(DecodePointerRaw(&object->bytes.offset),
+                                         bounds_checker, &bytes_validate_params,
+                                         err);
+  }
+
+  if (object->buffer.value() == kEncodedInvalidHandleValue) {
+    MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+        << "spillable bytes with neither inline bytes nor a shared buffer";
+    return ValidationError::UNEXPECTED_INVALID_HANDLE;
+  }
+  if (!bounds_checker->ClaimHandle(object->buffer)) {
+    MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+        << "invalid shared buffer handle in spillable bytes";
+    return ValidationError::ILLEGAL_HANDLE;
+  }
+  if (!object->buffer_num_bytes) {
+    MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+        << "empty shared buffer in spillable bytes";
+    return ValidationError::UNEXPECTED_ARRAY_HEADER;
+  }
+
+  // Make sure that the buffer is at least |buffer_num_bytes| long, so that
+  // deserialization can rely on mapping it. This can only be checked when the
+  // bounds checker has the message's handles.
+  Handle buffer = bounds_checker->GetHandle(object->buffer);
+  if (buffer.is_valid()) {
+    void* mapped = nullptr;
+    if (MojoMapBuffer(buffer.value(), 0, object->buffer_num_bytes, &mapped,
+                      MOJO_MAP_BUFFER_FLAG_NONE) != MOJO_RESULT_OK) {
+      MOJO_INTERNAL_DEBUG_SET_ERROR_MSG(err)
+          << "shared buffer in spillable bytes is smaller than "
+          << object->buffer_num_bytes << " bytes";
+      return ValidationError::UNEXPECTED_ARRAY_HEADER;
+    }
+    MojoUnmapBuffer(mapped);
+  }
+  return ValidationError::NONE;
+}
+
+void SpillableBytes_Data::EncodePointersAndHandles(
+    std::vector<Handle>* handles) {
+  Encode(&bytes, handles);
+  EncodeHandle(&buffer, handles);
+}
+
+void SpillableBytes_Data::DecodePointersAndHandles(
+    std::vector<Handle>* handles) {
+  Decode(&bytes, handles);
+  DecodeHandle(&buffer, handles);
+}
+
+SpillableBytes_Data::SpillableBytes_Data() : buffer_num_bytes(0) {
+  header_.num_bytes = sizeof(*this);
+  header_.version = 0;
+}
+
+}  // namespace internal
+}  // namespace mojo
@@ -0,0 +1,60 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_SPILLABLE_BYTES_INTERNAL_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_SPILLABLE_BYTES_INTERNAL_H_
+
+#include <string>
+#include <vector>
+
+#include "mojo/public/cpp/bindings/lib/array_internal.h"
+#include "mojo/public/cpp/bindings/lib/bindings_internal.h"
+#include "mojo/public/cpp/bindings/lib/validation_errors.h"
+#include "mojo/public/cpp/system/buffer.h"
+
+namespace mojo {
+namespace internal {
+
+class BoundsChecker;
+
+#pragma pack(push, 1)
+
+// The serialized form of an array<uint8> field marked with the
+// [SharedBufferThreshold=N] attribute. Arrays shorter than N bytes are stored
+// inline in |bytes|, like any other array. Longer arrays are written to a
+// shared buffer of |buffer_num_bytes| bytes instead, which is passed as
+// |buffer|, so that the bytes don't have to be copied through the message
+// pipe. Exactly one of |bytes| and |buffer| is set.
+//
+// This is only understood by the C++ bindings, so the attribute must only be
+// used on interfaces whose both ends are implemented in C++.
+class SpillableBytes_Data {
+ public:
+  static SpillableBytes_Data* New(Buffer* buf);
+
+  static ValidationError Validate(const void* data,
+                                  BoundsChecker* bounds_checker,
+                                  std::string* err);
+
+  void EncodePointersAndHandles(std::vector<Handle>* handles);
+  void DecodePointersAndHandles(std::vector<Handle>* handles);
+
+  StructHeader header_;
+  ArrayPointer<uint8_t> bytes;
+  SharedBufferHandle buffer;
+  uint32_t buffer_num_bytes;
+
+ private:
+  SpillableBytes_Data();
+  ~SpillableBytes_Data() = delete;
+};
+static_assert(sizeof(SpillableBytes_Data) == 24,
+              "Bad sizeof(SpillableBytes_Data)");
+
+#pragma pack(pop)
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_SPILLABLE_BYTES_INTERNAL_H_
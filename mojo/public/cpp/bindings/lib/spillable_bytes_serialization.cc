@@ -0,0 +1,251 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/bindings/lib/spillable_bytes_serialization.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include <vector>
+
+#include "mojo/public/cpp/bindings/lib/array_serialization.h"
+#include "mojo/public/cpp/bindings/lib/bindings_serialization.h"
+#include "mojo/public/cpp/environment/logging.h"
+#include "mojo/public/cpp/system/buffer.h"
+
+namespace mojo {
+namespace {
+
+// A shared buffer created and mapped by GetSerializedSizeSpillable_() for the
+// array whose storage is |data|, waiting for SerializeSpillable_() to fill it
+// in. Doing the steps that can fail while the size is computed lets an array
+// whose buffer can't be created be sized, and then written, inline instead.
+struct PreparedBuffer {
+  const uint8_t* data;  // Null if the slot is unused.
+  size_t num_bytes;
+  MojoHandle buffer;  // MOJO_HANDLE_INVALID if the buffer couldn't be created.
+  void* mapped;
+};
+
+// Bounds the buffers a thread can hold on to when arrays are sized but never
+// serialized. Messages rarely have more than a few spillable fields.
+const size_t kNumPreparedBuffers = 4;
+
+struct ThreadCache {
+  PreparedBuffer slots[kNumPreparedBuffers];
+  size_t next_slot;
+};
+
+void ReleasePreparedBuffer(PreparedBuffer* prepared) {
+  if (prepared->mapped)
+    MojoUnmapBuffer(prepared->mapped);
+  if (prepared->buffer != MOJO_HANDLE_INVALID)
+    MojoClose(prepared->buffer);
+  prepared->data = nullptr;
+}
+
+#ifndef _WIN32
+
+pthread_key_t g_thread_cache_key;
+pthread_once_t g_thread_cache_key_once = PTHREAD_ONCE_INIT;
+
+void DestroyThreadCache(void* value) {
+  ThreadCache* cache = static_cast<ThreadCache*>(value);
+  for (size_t i = 0; i < kNumPreparedBuffers; ++i) {
+    if (cache->slots[i].data)
+      ReleasePreparedBuffer(&cache->slots[i]);
+  }
+  free(cache);
+}
+
+void CreateThreadCacheKey() {
+  int result = pthread_key_create(&g_thread_cache_key, &DestroyThreadCache);
+  MOJO_CHECK(result == 0);
+}
+
+ThreadCache* GetThreadCache() {
+  pthread_once(&g_thread_cache_key_once, &CreateThreadCacheKey);
+  ThreadCache* cache =
+      static_cast<ThreadCache*>(pthread_getspecific(g_thread_cache_key));
+  if (!cache) {
+    cache = static_cast<ThreadCache*>(calloc(1, sizeof(ThreadCache)));
+    MOJO_CHECK(cache);
+    pthread_setspecific(g_thread_cache_key, cache);
+  }
+  return cache;
+}
+
+#else  // _WIN32
+
+// Windows TLS slots don't run destructors on thread exit, so buffers are only
+// created during serialization there, without an inline fallback.
+ThreadCache* GetThreadCache() {
+  return nullptr;
+}
+
+#endif  // _WIN32
+
+bool ShouldSpill(const Array<uint8_t>& input, size_t threshold) {
+  return input.size() >= threshold && input.size() > 0;
+}
+
+// Creates a shared buffer for |input| and maps it. On failure, |*buffer| is
+// set to MOJO_HANDLE_INVALID.
+void CreateAndMapBuffer(const Array<uint8_t>& input,
+                        MojoHandle* buffer,
+                        void** mapped) {
+  *buffer = MOJO_HANDLE_INVALID;
+  *mapped = nullptr;
+  MojoHandle handle;
+  if (MojoCreateSharedBuffer(nullptr, input.size(), &handle) != MOJO_RESULT_OK)
+    return;
+  if (MojoMapBuffer(handle, 0, input.size(), mapped,
+                    MOJO_MAP_BUFFER_FLAG_NONE) != MOJO_RESULT_OK) {
+    MojoClose(handle);
+    *mapped = nullptr;
+    return;
+  }
+  *buffer = handle;
+}
+
+PreparedBuffer* FindPreparedBuffer(ThreadCache* cache,
+                                   const Array<uint8_t>& input) {
+  for (size_t i = 0; i < kNumPreparedBuffers; ++i) {
+    PreparedBuffer* prepared = &cache->slots[i];
+    if (prepared->data == input.data() && prepared->num_bytes == input.size())
+      return prepared;
+  }
+  return nullptr;
+}
+
+// Returns whether |input| will be spilled, preparing its buffer if so.
+bool PrepareBuffer(const Array<uint8_t>& input) {
+  ThreadCache* cache = GetThreadCache();
+  if (!cache)
+    return true;
+
+  // The array may be sized more than once; reuse its buffer.
+  PreparedBuffer* prepared = FindPreparedBuffer(cache, input);
+  if (!prepared) {
+    prepared = &cache->slots[cache->next_slot];
+    cache->next_slot = (cache->next_slot + 1) % kNumPreparedBuffers;
+    if (prepared->data)
+      ReleasePreparedBuffer(prepared);
+    prepared->data = input.data();
+    prepared->num_bytes = input.size();
+    CreateAndMapBuffer(input, &prepared->buffer, &prepared->mapped);
+    if (prepared->buffer == MOJO_HANDLE_INVALID) {
+      MOJO_LOG(WARNING) << "Failed to create a shared buffer of "
+                        << input.size() << " bytes; sending them inline";
+    }
+  }
+  return prepared->buffer != MOJO_HANDLE_INVALID;
+}
+
+internal::SpillableBytes_Data* SerializeInline(const Array<uint8_t>& input,
+                                               internal::Buffer* buf) {
+  internal::SpillableBytes_Data* result =
+      internal::SpillableBytes_Data::New(buf);
+  result->bytes.ptr = internal::Array_Data<uint8_t>::New(input.size(), buf);
+  if (input.size())
+    memcpy(result->bytes.ptr->storage(), input.data(), input.size());
+  return result;
+}
+
+}  // namespace
+
+size_t GetSerializedSizeSpillable_(const Array<uint8_t>& input,
+                                   size_t threshold) {
+  if (!input)
+    return 0;
+  size_t size = sizeof(internal::SpillableBytes_Data);
+  if (!ShouldSpill(input, threshold) || !PrepareBuffer(input))
+    size += GetSerializedSize_(input);
+  return size;
+}
+
+void SerializeSpillable_(const Array<uint8_t>& input,
+                         size_t threshold,
+                         internal::Buffer* buf,
+                         internal::SpillableBytes_Data** output) {
+  if (!input) {
+    *output = nullptr;
+    return;
+  }
+
+  if (!ShouldSpill(input, threshold)) {
+    *output = SerializeInline(input, buf);
+    return;
+  }
+
+  MojoHandle buffer;
+  void* mapped;
+  ThreadCache* cache = GetThreadCache();
+  PreparedBuffer* prepared = cache ? FindPreparedBuffer(cache, input) : nullptr;
+  if (prepared) {
+    buffer = prepared->buffer;
+    mapped = prepared->mapped;
+    prepared->buffer = MOJO_HANDLE_INVALID;
+    prepared->mapped = nullptr;
+    ReleasePreparedBuffer(prepared);
+    if (buffer == MOJO_HANDLE_INVALID) {
+      // GetSerializedSizeSpillable_() made room for the bytes.
+      *output = SerializeInline(input, buf);
+      return;
+    }
+  } else {
+    // The array wasn't sized first, so there is no room to fall back to.
+    CreateAndMapBuffer(input, &buffer, &mapped);
+    if (buffer == MOJO_HANDLE_INVALID) {
+      MOJO_LOG(ERROR) << "Failed to create a shared buffer of " << input.size()
+                      << " bytes";
+      *output = nullptr;
+      return;
+    }
+  }
+
+  memcpy(mapped, input.data(), input.size());
+  MojoUnmapBuffer(mapped);
+  internal::SpillableBytes_Data* result =
+      internal::SpillableBytes_Data::New(buf);
+  result->bytes.ptr = nullptr;
+  result->buffer.set_value(buffer);
+  result->buffer_num_bytes = static_cast<uint32_t>(input.size());
+  *output = result;
+}
+
+void Deserialize_(internal::SpillableBytes_Data* input,
+                  Array<uint8_t>* output) {
+  if (!input) {
+    output->reset();
+    return;
+  }
+
+  if (input->bytes.ptr) {
+    const uint8_t* bytes = input->bytes.ptr->storage();
+    std::vector<uint8_t> result(bytes, bytes + input->bytes.ptr->size());
+    output->Swap(&result);
+    return;
+  }
+
+  // Validation checked that the buffer can be mapped, so this only fails when
+  // the address space is exhausted, which is treated like a failed allocation.
+  ScopedSharedBufferHandle buffer(internal::FetchAndReset(&input->buffer));
+  void* data = nullptr;
+  MojoResult result = MapBuffer(buffer.get(), 0, input->buffer_num_bytes,
+                                &data, MOJO_MAP_BUFFER_FLAG_NONE);
+  MOJO_CHECK(result == MOJO_RESULT_OK)
+      << "Failed to map a shared buffer of " << input->buffer_num_bytes
+      << " bytes";
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  std::vector<uint8_t> copy(bytes, bytes + input->buffer_num_bytes);
+  UnmapBuffer(data);
+  output->Swap(&copy);
+}
+
+}  // namespace mojo
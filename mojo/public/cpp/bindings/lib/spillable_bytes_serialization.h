@@ -0,0 +1,40 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_SPILLABLE_BYTES_SERIALIZATION_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_SPILLABLE_BYTES_SERIALIZATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mojo/public/cpp/bindings/array.h"
+#include "mojo/public/cpp/bindings/lib/spillable_bytes_internal.h"
+
+namespace mojo {
+
+// Serialization of array<uint8> fields marked [SharedBufferThreshold=N] (see
+// SpillableBytes_Data). |threshold| is N: arrays of at least that many bytes
+// are written to a shared buffer instead of the message.
+
+// Creates the shared buffer for a large array up front. If that fails, the
+// array is sized, and then serialized, inline like a small one.
+size_t GetSerializedSizeSpillable_(const Array<uint8_t>& input,
+                                   size_t threshold);
+
+// If a large array wasn't sized by GetSerializedSizeSpillable_() on this
+// thread first and a shared buffer can't be created for it, |*output| is set
+// to null, so that a message carrying it is rejected by the receiver.
+void SerializeSpillable_(const Array<uint8_t>& input,
+                         size_t threshold,
+                         internal::Buffer* buf,
+                         internal::SpillableBytes_Data** output);
+
+// Takes ownership of the shared buffer in |input|, if any, and copies its
+// contents out. |input| must have been validated with the message's handles,
+// which rejects buffers smaller than the sender claimed.
+void Deserialize_(internal::SpillableBytes_Data* input, Array<uint8_t>* output);
+
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_SPILLABLE_BYTES_SERIALIZATION_H_
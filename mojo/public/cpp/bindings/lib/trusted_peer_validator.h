@@ -0,0 +1,60 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_BINDINGS_LIB_TRUSTED_PEER_VALIDATOR_H_
+#define MOJO_PUBLIC_CPP_BINDINGS_LIB_TRUSTED_PEER_VALIDATOR_H_
+
+#include <stdint.h>
+
+#include "mojo/public/cpp/bindings/message_filter.h"
+
+namespace mojo {
+namespace internal {
+
+// In debug builds, one in every |kTrustedPeerValidationSampleRate| messages
+// received from a trusted peer is still run through the full validator.
+const uint32_t kTrustedPeerValidationSampleRate = 16u;
+
+// A filter that stands in for |ValidatorType| (a generated RequestValidator_ or
+// ResponseValidator_) on pipes whose peer is known to live in the same process
+// and trust domain. Release builds forward every message straight to |sink_|,
+// eliding the payload validation pass. Debug builds keep validating a sample of
+// the messages so that serialization bugs are still caught in testing.
+template <typename ValidatorType>
+class TrustedPeerValidator : public MessageFilter {
+ public:
+  explicit TrustedPeerValidator(MessageReceiver* sink = nullptr)
+      : MessageFilter(sink)
+#ifndef NDEBUG
+        ,
+        validator_(sink),
+        message_count_(0u)
+#endif
+  {
+  }
+
+  bool Accept(Message* message) override {
+#ifndef NDEBUG
+    if (message_count_++ % kTrustedPeerValidationSampleRate == 0u) {
+      // |sink_| may have been changed by FilterChain since construction.
+      validator_.set_sink(sink_);
+      return validator_.Accept(message);
+    }
+#endif
+    return sink_->Accept(message);
+  }
+
+ private:
+#ifndef NDEBUG
+  ValidatorType validator_;
+  uint32_t message_count_;
+#endif
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(TrustedPeerValidator);
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_BINDINGS_LIB_TRUSTED_PEER_VALIDATOR_H_
@@ -50,6 +50,10 @@ const char* ValidationErrorToString(ValidationError error) {
       return "VALIDATION_ERROR_DIFFERENT_SIZED_ARRAYS_IN_MAP";
     case ValidationError::UNEXPECTED_NULL_UNION:
       return "VALIDATION_ERROR_UNEXPECTED_NULL_UNION";
+    case ValidationError::ILLEGAL_INTERFACE_ID:
+      return "VALIDATION_ERROR_ILLEGAL_INTERFACE_ID";
+    case ValidationError::UNEXPECTED_INVALID_INTERFACE_ID:
+      return "VALIDATION_ERROR_UNEXPECTED_INVALID_INTERFACE_ID";
   }
 
   return "Unknown error";
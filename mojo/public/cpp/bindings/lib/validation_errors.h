@@ -59,6 +59,11 @@ enum class ValidationError {
   DIFFERENT_SIZED_ARRAYS_IN_MAP,
   // A non-nullable union is set to null. (Has size 0)
   UNEXPECTED_NULL_UNION,
+  // An associated interface ID is illegal, e.g. it refers to the master
+  // interface of the pipe.
+  ILLEGAL_INTERFACE_ID,
+  // A non-nullable associated interface field is set to the invalid ID.
+  UNEXPECTED_INVALID_INTERFACE_ID,
 };
 
 const char* ValidationErrorToString(ValidationError error);
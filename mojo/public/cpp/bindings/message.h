@@ -56,6 +56,29 @@ class Message {
         ->request_id = request_id;
   }
 
+  // Access the interface_id field (if present). Messages without one are
+  // addressed to the master interface of the pipe.
+  bool has_interface_id() const { return data_->header.version >= 2; }
+  internal::InterfaceId interface_id() const {
+    if (!has_interface_id())
+      return internal::kMasterInterfaceId;
+    return static_cast<const internal::MessageHeaderWithInterfaceID*>(
+               &data_->header)->interface_id;
+  }
+
+  // Access the send_time_ticks field (if present).
+  bool has_send_time() const { return data_->header.version >= 3; }
+  MojoTimeTicks send_time() const {
+    MOJO_DCHECK(has_send_time());
+    return static_cast<const internal::MessageHeaderWithSendTime*>(
+               &data_->header)->send_time_ticks;
+  }
+  void set_send_time(MojoTimeTicks send_time) {
+    MOJO_DCHECK(has_send_time());
+    static_cast<internal::MessageHeaderWithSendTime*>(&data_->header)
+        ->send_time_ticks = send_time;
+  }
+
   // Access the payload.
   const uint8_t* payload() const {
     return reinterpret_cast<const uint8_t*>(data_) + data_->header.num_bytes;
@@ -10,6 +10,9 @@
 #include "mojo/public/cpp/system/core.h"
 
 namespace mojo {
+namespace internal {
+class Router;
+}  // namespace internal
 
 // NoInterface is for use in cases when a non-existent or empty interface is
 // needed.
@@ -20,6 +23,8 @@ class NoInterfaceStub;
 class NoInterface {
  public:
   static const char* Name_;
+  static const char QualifiedName_[];
+  static const char* MethodName_(uint32_t ordinal) { return nullptr; }
   typedef NoInterfaceProxy Proxy_;
   typedef NoInterfaceStub Stub_;
   typedef PassThroughFilter RequestValidator_;
@@ -37,6 +42,7 @@ class NoInterfaceStub : public MessageReceiverWithResponder {
   NoInterfaceStub() {}
   void set_sink(NoInterface* sink) {}
   NoInterface* sink() { return nullptr; }
+  void set_router(internal::Router* router) {}
   bool Accept(Message* message) override;
   bool AcceptWithResponder(Message* message,
                            MessageReceiver* responder) override;
@@ -134,6 +134,10 @@ class StrongBinding {
     binding_.Bind(request.Pass(), waiter);
   }
 
+  // See Binding::EnableTrustedPeerMode(). Must be called before the binding is
+  // completed.
+  void EnableTrustedPeerMode() { binding_.EnableTrustedPeerMode(); }
+
   // Blocks the calling thread until either a call arrives on the previously
   // bound message pipe, the deadline is exceeded, or an error occurs. Returns
   // true if a method was successfully read and dispatched.
@@ -174,6 +178,10 @@ class StrongBinding {
   // transferred to the caller.
   MessagePipeHandle handle() const { return binding_.handle(); }
 
+  // Returns the associated group of the bound message pipe. See
+  // Binding::associated_group().
+  AssociatedGroup associated_group() { return binding_.associated_group(); }
+
   // Exposed for testing, should not generally be used.
   internal::Router* internal_router() { return binding_.internal_router(); }
 
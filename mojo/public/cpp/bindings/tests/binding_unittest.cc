@@ -222,6 +222,30 @@ TEST_F(BindingTest, SetInterfacePtrVersion) {
   EXPECT_EQ(3u, ptr.version());
 }
 
+// Tests that requests and responses keep flowing when both ends of the pipe
+// are in trusted-peer mode, i.e. when payload validation is (mostly) elided.
+TEST_F(BindingTest, TrustedPeerMode) {
+  ServiceImpl impl;
+  sample::ServicePtr ptr;
+  auto request = GetProxy(&ptr);
+  ptr.EnableTrustedPeerMode();
+  Binding<sample::Service> binding(&impl);
+  binding.EnableTrustedPeerMode();
+  binding.Bind(request.Pass());
+
+  // Send more calls than the debug-build sampling interval so that both
+  // validated and unvalidated messages are dispatched.
+  const int kNumCalls = 40;
+  int num_responses = 0;
+  for (int i = 0; i < kNumCalls; ++i) {
+    ptr->Frobinate(nullptr, sample::Service::BazOptions::REGULAR, nullptr,
+                   [&num_responses](int32_t result) { num_responses++; });
+  }
+  loop().RunUntilIdle();
+  EXPECT_EQ(kNumCalls, num_responses);
+  EXPECT_FALSE(ptr.encountered_error());
+}
+
 // StrongBindingTest -----------------------------------------------------------
 
 using StrongBindingTest = BindingTestBase;
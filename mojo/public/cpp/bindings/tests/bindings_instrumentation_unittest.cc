@@ -0,0 +1,242 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/bindings_instrumentation.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/interfaces/bindings/tests/math_calculator.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+struct Event {
+  std::string type;
+  std::string interface_name;
+  std::string method_name;
+  bool is_response;
+  MojoTimeTicks time;
+};
+
+class RecordingInstrumentation : public BindingsInstrumentation {
+ public:
+  RecordingInstrumentation()
+      : pending_responses_(0), pending_responses_num_bytes_(0) {}
+  ~RecordingInstrumentation() override {}
+
+  const std::vector<Event>& events() const { return events_; }
+  int32_t pending_responses() const { return pending_responses_; }
+  int64_t pending_responses_num_bytes() const {
+    return pending_responses_num_bytes_;
+  }
+
+  void AddPendingResponses(int32_t count_delta, int64_t num_bytes_delta) {
+    pending_responses_ += count_delta;
+    pending_responses_num_bytes_ += num_bytes_delta;
+  }
+
+  // BindingsInstrumentation implementation:
+  void OnMessageSent(const char* interface_name,
+                     const char* method_name,
+                     bool is_response,
+                     uint32_t num_bytes) override {
+    events_.push_back({"sent", interface_name, method_name, is_response, 0});
+  }
+  void OnMessageDispatched(const char* interface_name,
+                           const char* method_name,
+                           bool is_response,
+                           uint32_t num_bytes,
+                           MojoTimeTicks queueing_time,
+                           MojoTimeTicks handler_time) override {
+    events_.push_back({"dispatched", interface_name, method_name, is_response,
+                       queueing_time});
+  }
+  void OnResponseReceived(const char* interface_name,
+                          const char* method_name,
+                          MojoTimeTicks round_trip_time) override {
+    events_.push_back(
+        {"response", interface_name, method_name, true, round_trip_time});
+  }
+  PendingResponsesCounter* CreatePendingResponsesCounter(
+      const char* interface_name) override;
+
+ private:
+  std::vector<Event> events_;
+  int32_t pending_responses_;
+  int64_t pending_responses_num_bytes_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(RecordingInstrumentation);
+};
+
+// Adds to the totals of a RecordingInstrumentation, and takes back what it
+// still counts when it is deleted.
+class RecordingCounter : public PendingResponsesCounter {
+ public:
+  explicit RecordingCounter(RecordingInstrumentation* instrumentation)
+      : instrumentation_(instrumentation), count_(0), num_bytes_(0) {}
+  ~RecordingCounter() override {
+    instrumentation_->AddPendingResponses(-count_, -num_bytes_);
+  }
+
+  void Add(int32_t count_delta, int64_t num_bytes_delta) override {
+    count_ += count_delta;
+    num_bytes_ += num_bytes_delta;
+    instrumentation_->AddPendingResponses(count_delta, num_bytes_delta);
+  }
+
+ private:
+  RecordingInstrumentation* instrumentation_;
+  int32_t count_;
+  int64_t num_bytes_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(RecordingCounter);
+};
+
+PendingResponsesCounter*
+RecordingInstrumentation::CreatePendingResponsesCounter(
+    const char* interface_name) {
+  EXPECT_EQ("math.Calculator", std::string(interface_name));
+  return new RecordingCounter(this);
+}
+
+class MathCalculatorImpl : public math::Calculator {
+ public:
+  explicit MathCalculatorImpl(InterfaceRequest<math::Calculator> request)
+      : total_(0.0), binding_(this, request.Pass()) {}
+  ~MathCalculatorImpl() override {}
+
+  void Clear(const ClearCallback& callback) override {
+    total_ = 0.0;
+    callback.Run(total_);
+  }
+
+  void Add(double value, const AddCallback& callback) override {
+    total_ += value;
+    callback.Run(total_);
+  }
+
+  void Multiply(double value, const MultiplyCallback& callback) override {
+    total_ *= value;
+    callback.Run(total_);
+  }
+
+ private:
+  double total_;
+  Binding<math::Calculator> binding_;
+};
+
+class BindingsInstrumentationTest : public testing::Test {
+ public:
+  BindingsInstrumentationTest() {
+    SetBindingsInstrumentation(&instrumentation_);
+  }
+  ~BindingsInstrumentationTest() override {
+    SetBindingsInstrumentation(nullptr);
+  }
+
+  void PumpMessages() { loop_.RunUntilIdle(); }
+
+  const std::vector<Event>& events() const {
+    return instrumentation_.events();
+  }
+  const RecordingInstrumentation& instrumentation() const {
+    return instrumentation_;
+  }
+
+ private:
+  RecordingInstrumentation instrumentation_;
+  Environment env_;
+  RunLoop loop_;
+};
+
+TEST_F(BindingsInstrumentationTest, RequestResponse) {
+  math::CalculatorPtr calc;
+  MathCalculatorImpl impl(GetProxy(&calc));
+
+  double result = 0.0;
+  calc->Add(2.0, [&result](double value) { result = value; });
+  PumpMessages();
+  EXPECT_EQ(2.0, result);
+
+  ASSERT_EQ(5u, events().size());
+
+  EXPECT_EQ("sent", events()[0].type);
+  EXPECT_FALSE(events()[0].is_response);
+
+  EXPECT_EQ("sent", events()[1].type);
+  EXPECT_TRUE(events()[1].is_response);
+
+  EXPECT_EQ("dispatched", events()[2].type);
+  EXPECT_FALSE(events()[2].is_response);
+  EXPECT_GE(events()[2].time, 0);
+
+  EXPECT_EQ("dispatched", events()[3].type);
+  EXPECT_TRUE(events()[3].is_response);
+  EXPECT_GE(events()[3].time, 0);
+
+  EXPECT_EQ("response", events()[4].type);
+  EXPECT_GE(events()[4].time, 0);
+
+  for (const Event& event : events()) {
+    EXPECT_EQ("math.Calculator", event.interface_name);
+    EXPECT_EQ("Add", event.method_name);
+  }
+}
+
+TEST_F(BindingsInstrumentationTest, UninstrumentedPeer) {
+  math::CalculatorPtr calc;
+  MathCalculatorImpl impl(GetProxy(&calc));
+
+  // |calc| sets up its router on first use, after the instrumentation is
+  // removed, so only the binding's side of the call is reported.
+  SetBindingsInstrumentation(nullptr);
+
+  double result = 0.0;
+  calc->Add(1.0, [&result](double value) { result = value; });
+  PumpMessages();
+  EXPECT_EQ(1.0, result);
+
+  ASSERT_EQ(2u, events().size());
+  EXPECT_EQ("sent", events()[0].type);
+  EXPECT_TRUE(events()[0].is_response);
+  EXPECT_EQ("dispatched", events()[1].type);
+  EXPECT_FALSE(events()[1].is_response);
+  // The request was sent without the instrumentation, so it carries no send
+  // time.
+  EXPECT_EQ(-1, events()[1].time);
+}
+
+TEST_F(BindingsInstrumentationTest, PendingResponses) {
+  math::CalculatorPtr calc;
+  MathCalculatorImpl impl(GetProxy(&calc));
+
+  calc->Add(1.0, [](double value) {});
+  calc->Add(2.0, [](double value) {});
+  EXPECT_EQ(2, instrumentation().pending_responses());
+  int64_t num_bytes = instrumentation().pending_responses_num_bytes();
+  EXPECT_GT(num_bytes, 0);
+
+  // Responses are no longer pending once their callbacks have run.
+  PumpMessages();
+  EXPECT_EQ(0, instrumentation().pending_responses());
+  EXPECT_EQ(0, instrumentation().pending_responses_num_bytes());
+
+  // Nor are those still awaited when the InterfacePtr goes away.
+  calc->Add(3.0, [](double value) {});
+  EXPECT_EQ(1, instrumentation().pending_responses());
+  EXPECT_EQ(num_bytes / 2, instrumentation().pending_responses_num_bytes());
+  calc.reset();
+  EXPECT_EQ(0, instrumentation().pending_responses());
+  EXPECT_EQ(0, instrumentation().pending_responses_num_bytes());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
@@ -2,10 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <map>
+
 #include "mojo/public/cpp/bindings/binding.h"
 #include "mojo/public/cpp/test_support/test_support.h"
 #include "mojo/public/cpp/utility/run_loop.h"
 #include "mojo/public/interfaces/bindings/tests/ping_service.mojom.h"
+#include "mojo/public/interfaces/bindings/tests/sample_interfaces.mojom.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace mojo {
@@ -71,6 +74,87 @@ void PingPongTest::OnPingDone() {
   service_->Ping([this]() { OnPingDone(); });
 }
 
+class IntegerAccessorImpl : public sample::IntegerAccessor {
+ public:
+  IntegerAccessorImpl() : num_calls_(0u) {}
+  ~IntegerAccessorImpl() override {}
+
+  uint64_t num_calls() const { return num_calls_; }
+
+  // |IntegerAccessor| methods:
+  void GetInteger(const GetIntegerCallback& callback) override {
+    callback.Run(0, sample::Enum::VALUE);
+  }
+  void SetInteger(int64_t data, sample::Enum type) override { num_calls_++; }
+
+ private:
+  uint64_t num_calls_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(IntegerAccessorImpl);
+};
+
+// Forwards to the default async waiter, counting the wakeups it delivers.
+class CountingAsyncWaiter {
+ public:
+  static const MojoAsyncWaiter* Get() {
+    static const MojoAsyncWaiter kWaiter = {&AsyncWait, &CancelWait};
+    return &kWaiter;
+  }
+
+  static uint64_t num_wakeups() { return num_wakeups_; }
+  static void ResetNumWakeups() { num_wakeups_ = 0u; }
+
+ private:
+  struct Wait {
+    MojoAsyncWaitID id;
+    MojoAsyncWaitCallback callback;
+    void* closure;
+  };
+  typedef std::map<MojoAsyncWaitID, Wait*> WaitMap;
+
+  static MojoAsyncWaitID AsyncWait(MojoHandle handle,
+                                   MojoHandleSignals signals,
+                                   MojoDeadline deadline,
+                                   MojoAsyncWaitCallback callback,
+                                   void* closure) {
+    Wait* wait = new Wait();
+    wait->callback = callback;
+    wait->closure = closure;
+    // The callback is never run from within |AsyncWait()|.
+    wait->id = Environment::GetDefaultAsyncWaiter()->AsyncWait(
+        handle, signals, deadline, &OnWaitDone, wait);
+    waits()[wait->id] = wait;
+    return wait->id;
+  }
+
+  static void CancelWait(MojoAsyncWaitID wait_id) {
+    WaitMap::iterator it = waits().find(wait_id);
+    MOJO_CHECK(it != waits().end());
+    Environment::GetDefaultAsyncWaiter()->CancelWait(wait_id);
+    delete it->second;
+    waits().erase(it);
+  }
+
+  static void OnWaitDone(void* closure, MojoResult result) {
+    Wait* wait = static_cast<Wait*>(closure);
+    waits().erase(wait->id);
+    num_wakeups_++;
+    MojoAsyncWaitCallback callback = wait->callback;
+    void* callback_closure = wait->closure;
+    delete wait;
+    callback(callback_closure, result);
+  }
+
+  static WaitMap& waits() {
+    static WaitMap* waits = new WaitMap();
+    return *waits;
+  }
+
+  static uint64_t num_wakeups_;
+};
+
+uint64_t CountingAsyncWaiter::num_wakeups_ = 0u;
+
 struct BoundPingService {
   BoundPingService() : binding(&impl) {
     binding.Bind(GetProxy(&service));
@@ -122,5 +206,97 @@ TEST_F(MojoBindingsPerftest, InProcessPingPong) {
   }
 }
 
+// Measures the cost of validation by comparing ping-pong throughput of a
+// regular binding against one where both ends are in trusted-peer mode.
+TEST_F(MojoBindingsPerftest, InProcessPingPongTrustedPeer) {
+  const unsigned int kIterations = 100000;
+  const char* const kSubTests[] = {"Validated", "TrustedPeer"};
+
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kSubTests); ++i) {
+    const bool trusted_peer = i == 1;
+
+    test::PingServicePtr service;
+    auto request = GetProxy(&service);
+    PingServiceImpl impl;
+    Binding<test::PingService> binding(&impl);
+    if (trusted_peer) {
+      service.EnableTrustedPeerMode();
+      binding.EnableTrustedPeerMode();
+    }
+    binding.Bind(request.Pass());
+    PingPongTest test(service.Pass());
+
+    const MojoTimeTicks start_time = MojoGetTimeTicksNow();
+    test.Run(kIterations);
+    const MojoTimeTicks end_time = MojoGetTimeTicksNow();
+    test::LogPerfResult(
+        "InProcessPingPongTrustedPeer", kSubTests[i],
+        kIterations / MojoTicksToSeconds(end_time - start_time),
+        "pings/second");
+  }
+}
+
+// Measures one-way call throughput, and the number of messages and wakeups it
+// takes, with and without batching the calls (see InterfacePtr::BatchScope).
+TEST_F(MojoBindingsPerftest, InProcessOneWayCalls) {
+  const uint32_t kIterations = 100000;
+  // Calls are made in rounds, after each of which the receiver runs.
+  const uint32_t kCallsPerRound = 64;
+  const uint32_t kBatchSizes[] = {1, 8, 64};
+  const char* const kSubTests[] = {"Unbatched", "Batch8", "Batch64"};
+
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kBatchSizes); ++i) {
+    const uint32_t batch_size = kBatchSizes[i];
+
+    // Count the transport messages used by one round.
+    uint32_t messages_per_round = 0;
+    {
+      sample::IntegerAccessorPtr ptr;
+      MessagePipe pipe;
+      ptr.Bind(InterfacePtrInfo<sample::IntegerAccessor>(pipe.handle0.Pass(),
+                                                         0u));
+      for (uint32_t j = 0; j < kCallsPerRound; j += batch_size) {
+        sample::IntegerAccessorPtr::BatchScope batch(&ptr);
+        for (uint32_t k = 0; k < batch_size; ++k)
+          ptr->SetInteger(j + k, sample::Enum::VALUE);
+      }
+      while (ReadMessageRaw(pipe.handle1.get(), nullptr, nullptr, nullptr,
+                            nullptr, MOJO_READ_MESSAGE_FLAG_MAY_DISCARD) ==
+             MOJO_RESULT_RESOURCE_EXHAUSTED) {
+        messages_per_round++;
+      }
+    }
+
+    sample::IntegerAccessorPtr ptr;
+    IntegerAccessorImpl impl;
+    Binding<sample::IntegerAccessor> binding(&impl, GetProxy(&ptr),
+                                             CountingAsyncWaiter::Get());
+    CountingAsyncWaiter::ResetNumWakeups();
+
+    const MojoTimeTicks start_time = MojoGetTimeTicksNow();
+    for (uint32_t round = 0; round < kIterations / kCallsPerRound; ++round) {
+      for (uint32_t j = 0; j < kCallsPerRound; j += batch_size) {
+        sample::IntegerAccessorPtr::BatchScope batch(&ptr);
+        for (uint32_t k = 0; k < batch_size; ++k)
+          ptr->SetInteger(j + k, sample::Enum::VALUE);
+      }
+      run_loop_.RunUntilIdle();
+    }
+    const MojoTimeTicks end_time = MojoGetTimeTicksNow();
+    const double seconds = MojoTicksToSeconds(end_time - start_time);
+    const uint32_t num_rounds = kIterations / kCallsPerRound;
+    EXPECT_EQ(num_rounds * kCallsPerRound, impl.num_calls());
+
+    test::LogPerfResult("InProcessOneWayCalls", kSubTests[i],
+                        impl.num_calls() / seconds, "calls/second");
+    test::LogPerfResult("InProcessOneWayCalls_Messages", kSubTests[i],
+                        num_rounds * messages_per_round / seconds,
+                        "messages/second");
+    test::LogPerfResult("InProcessOneWayCalls_Wakeups", kSubTests[i],
+                        CountingAsyncWaiter::num_wakeups() / seconds,
+                        "wakeups/second");
+  }
+}
+
 }  // namespace
 }  // namespace mojo
@@ -0,0 +1,64 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mojo/public/cpp/bindings/lib/message_buffer_pool.h"
+#include "mojo/public/cpp/bindings/message.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+TEST(MessageBufferPoolTest, Alignment) {
+  const size_t kSizes[] = {0, 1, 8, 63, 64, 65, 1000, 8192, 8193, 1 << 20};
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kSizes); ++i) {
+    void* buffer = internal::AllocMessageBuffer(kSizes[i]);
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(buffer) % 8);
+    // The whole buffer must be writable.
+    memset(buffer, 0xAB, kSizes[i]);
+    internal::FreeMessageBuffer(buffer);
+  }
+  internal::FreeMessageBuffer(nullptr);
+}
+
+#ifndef _WIN32
+TEST(MessageBufferPoolTest, BuffersAreReused) {
+  void* buffer = internal::AllocMessageBuffer(100);
+  internal::FreeMessageBuffer(buffer);
+
+  // Anything in the same size class gets the buffer back.
+  void* reused = internal::AllocMessageBuffer(128);
+  EXPECT_EQ(buffer, reused);
+
+  // Other size classes don't.
+  void* other = internal::AllocMessageBuffer(129);
+  EXPECT_NE(reused, other);
+
+  internal::FreeMessageBuffer(other);
+  internal::FreeMessageBuffer(reused);
+}
+#endif
+
+TEST(MessageBufferPoolTest, AllocDataIsZeroed) {
+  const uint32_t kNumBytes = 48;
+  {
+    Message message;
+    message.AllocUninitializedData(kNumBytes);
+    memset(message.mutable_data(), 0xFF, kNumBytes);
+  }
+
+  // Even if it gets the dirty buffer back.
+  Message message;
+  message.AllocData(kNumBytes);
+  for (uint32_t i = 0; i < kNumBytes; ++i)
+    EXPECT_EQ(0u, message.data()[i]);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
@@ -5,6 +5,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <vector>
+
+#include "mojo/public/cpp/bindings/lib/interface_endpoint_client.h"
 #include "mojo/public/cpp/bindings/lib/message_builder.h"
 #include "mojo/public/cpp/bindings/lib/router.h"
 #include "mojo/public/cpp/bindings/tests/message_queue.h"
@@ -25,6 +28,14 @@ void AllocRequestMessage(uint32_t name, const char* text, Message* message) {
   builder.message()->MoveTo(message);
 }
 
+void AllocOneWayMessage(uint32_t name, const char* text, Message* message) {
+  size_t payload_size = strlen(text) + 1;  // Plus null terminator.
+  MessageBuilder builder(name, payload_size);
+  memcpy(builder.buffer()->Allocate(payload_size), text, payload_size);
+
+  builder.message()->MoveTo(message);
+}
+
 void AllocResponseMessage(uint32_t name,
                           const char* text,
                           uint64_t request_id,
@@ -49,6 +60,57 @@ class MessageAccumulator : public MessageReceiver {
   MessageQueue* queue_;
 };
 
+// Accumulates the messages that don't expect a response; requests are answered
+// by echoing them back.
+class OneWayMessageAccumulator : public MessageReceiverWithResponderStatus {
+ public:
+  explicit OneWayMessageAccumulator(MessageQueue* queue) : queue_(queue) {}
+
+  bool Accept(Message* message) override {
+    queue_->Push(message);
+    return true;
+  }
+
+  bool AcceptWithResponder(Message* message,
+                           MessageReceiverWithStatus* responder) override {
+    Message response;
+    AllocResponseMessage(message->name(),
+                         reinterpret_cast<const char*>(message->payload()),
+                         message->request_id(), &response);
+    bool result = responder->Accept(&response);
+    delete responder;
+    return result;
+  }
+
+ private:
+  MessageQueue* queue_;
+};
+
+// Accumulates one-way messages, and passes |router|'s pipe on when it gets
+// the message named |pass_on|.
+class PipePassingAccumulator : public OneWayMessageAccumulator {
+ public:
+  PipePassingAccumulator(MessageQueue* queue,
+                         internal::Router* router,
+                         uint32_t pass_on)
+      : OneWayMessageAccumulator(queue), router_(router), pass_on_(pass_on) {}
+
+  bool Accept(Message* message) override {
+    bool pass = message->name() == pass_on_;
+    bool result = OneWayMessageAccumulator::Accept(message);
+    if (pass)
+      passed_pipe_ = router_->PassMessagePipe();
+    return result;
+  }
+
+  ScopedMessagePipeHandle passed_pipe() { return passed_pipe_.Pass(); }
+
+ private:
+  internal::Router* router_;
+  uint32_t pass_on_;
+  ScopedMessagePipeHandle passed_pipe_;
+};
+
 class ResponseGenerator : public MessageReceiverWithResponderStatus {
  public:
   ResponseGenerator() {}
@@ -459,6 +521,338 @@ TEST_F(RouterTest, LateResponse) {
   generator.CompleteWithResponse();  // This should end up doing nothing.
 }
 
+TEST_F(RouterTest, AssociatedRequestResponse) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+  router1.set_interface_id_namespace_bit(true);
+
+  internal::ScopedInterfaceEndpointHandle local_endpoint;
+  internal::ScopedInterfaceEndpointHandle remote_endpoint;
+  router0.CreateEndpointHandlePair(&local_endpoint, &remote_endpoint);
+  ASSERT_TRUE(local_endpoint.is_valid());
+  ASSERT_TRUE(remote_endpoint.is_valid());
+  internal::InterfaceId id = remote_endpoint.release();
+
+  internal::InterfaceEndpointClient client0(local_endpoint.Pass(),
+                                            internal::FilterChain());
+
+  // Send a request before the other side has claimed the endpoint. It must be
+  // queued rather than dropped.
+  Message request;
+  AllocRequestMessage(1, "hello", &request);
+  MessageQueue message_queue;
+  client0.AcceptWithResponder(&request,
+                              new MessageAccumulator(&message_queue));
+  PumpMessages();
+  EXPECT_TRUE(message_queue.IsEmpty());
+
+  // The master interface is not involved.
+  MessageQueue master_queue;
+  ResponseGenerator master_generator;
+  router1.set_incoming_receiver(&master_generator);
+
+  internal::ScopedInterfaceEndpointHandle claimed_endpoint =
+      router1.CreateLocalEndpointHandle(id);
+  ASSERT_TRUE(claimed_endpoint.is_valid());
+  // An ID can only be claimed once.
+  EXPECT_FALSE(router1.CreateLocalEndpointHandle(id).is_valid());
+
+  ResponseGenerator generator;
+  internal::InterfaceEndpointClient client1(claimed_endpoint.Pass(),
+                                            internal::FilterChain());
+  client1.set_incoming_receiver(&generator);
+  client1.DispatchPendingMessages();
+
+  PumpMessages();
+
+  EXPECT_FALSE(message_queue.IsEmpty());
+  Message response;
+  message_queue.Pop(&response);
+  EXPECT_EQ(std::string("hello world!"),
+            std::string(reinterpret_cast<const char*>(response.payload())));
+
+  // Requests on the master interface still work alongside.
+  Message master_request;
+  AllocRequestMessage(1, "master", &master_request);
+  router0.AcceptWithResponder(&master_request,
+                              new MessageAccumulator(&master_queue));
+  PumpMessages();
+
+  EXPECT_FALSE(master_queue.IsEmpty());
+  master_queue.Pop(&response);
+  EXPECT_EQ(std::string("master world!"),
+            std::string(reinterpret_cast<const char*>(response.payload())));
+  EXPECT_FALSE(client0.encountered_error());
+  EXPECT_FALSE(client1.encountered_error());
+}
+
+TEST_F(RouterTest, AssociatedEndpointClosed) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+  router1.set_interface_id_namespace_bit(true);
+
+  internal::ScopedInterfaceEndpointHandle local_endpoint;
+  internal::ScopedInterfaceEndpointHandle remote_endpoint;
+  router1.CreateEndpointHandlePair(&local_endpoint, &remote_endpoint);
+
+  // IDs allocated by one side can't be claimed by the same side.
+  EXPECT_FALSE(router1.CreateLocalEndpointHandle(local_endpoint.id())
+                   .is_valid());
+
+  internal::InterfaceEndpointClient client1(local_endpoint.Pass(),
+                                            internal::FilterChain());
+  bool error_handler_called = false;
+  client1.set_connection_error_handler(
+      [&error_handler_called]() { error_handler_called = true; });
+
+  {
+    internal::InterfaceEndpointClient client0(
+        router0.CreateLocalEndpointHandle(remote_endpoint.release()),
+        internal::FilterChain());
+    EXPECT_FALSE(client0.encountered_error());
+  }
+
+  PumpMessages();
+
+  EXPECT_TRUE(error_handler_called);
+  EXPECT_TRUE(client1.encountered_error());
+  // The pipe itself is unaffected.
+  EXPECT_FALSE(router0.encountered_error());
+  EXPECT_FALSE(router1.encountered_error());
+}
+
+TEST_F(RouterTest, PipeClosedNotifiesAssociatedEndpoints) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+
+  internal::ScopedInterfaceEndpointHandle local_endpoint;
+  internal::ScopedInterfaceEndpointHandle remote_endpoint;
+  router0.CreateEndpointHandlePair(&local_endpoint, &remote_endpoint);
+  remote_endpoint.release();
+
+  internal::InterfaceEndpointClient client0(local_endpoint.Pass(),
+                                            internal::FilterChain());
+  bool endpoint_error = false;
+  bool master_error = false;
+  client0.set_connection_error_handler([&endpoint_error, &master_error]() {
+    // Associated endpoints are notified before the master interface.
+    EXPECT_FALSE(master_error);
+    endpoint_error = true;
+  });
+  router0.set_connection_error_handler(
+      [&master_error]() { master_error = true; });
+
+  handle1_.reset();
+  PumpMessages();
+
+  EXPECT_TRUE(endpoint_error);
+  EXPECT_TRUE(master_error);
+  EXPECT_TRUE(client0.encountered_error());
+}
+
+TEST_F(RouterTest, TooManyUnclaimedAssociatedEndpoints) {
+  // Matches the limit in router.cc.
+  const size_t kMaxUnclaimedPeerEndpoints = 64;
+
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+  router1.set_interface_id_namespace_bit(true);
+
+  // Use endpoints without ever sending them to the other side, which has to
+  // queue the messages in case the endpoints show up later.
+  std::vector<internal::InterfaceEndpointClient*> clients;
+  for (size_t i = 0; i <= kMaxUnclaimedPeerEndpoints; ++i) {
+    internal::ScopedInterfaceEndpointHandle local_endpoint;
+    internal::ScopedInterfaceEndpointHandle remote_endpoint;
+    router0.CreateEndpointHandlePair(&local_endpoint, &remote_endpoint);
+    remote_endpoint.release();
+    clients.push_back(new internal::InterfaceEndpointClient(
+        local_endpoint.Pass(), internal::FilterChain()));
+
+    Message message;
+    AllocOneWayMessage(1, "hello", &message);
+    EXPECT_TRUE(clients.back()->Accept(&message));
+    PumpMessages();
+    EXPECT_EQ(i == kMaxUnclaimedPeerEndpoints, router1.encountered_error());
+  }
+
+  for (size_t i = 0; i < clients.size(); ++i)
+    delete clients[i];
+}
+
+TEST_F(RouterTest, BatchIsWrittenAsOneMessage) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+
+  router0.BeginBatch();
+  for (uint32_t i = 0; i < 3; ++i) {
+    Message message;
+    AllocOneWayMessage(i, "hello", &message);
+    EXPECT_TRUE(router0.Accept(&message));
+  }
+
+  uint32_t num_bytes = 0;
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            ReadMessageRaw(handle1_.get(), nullptr, &num_bytes, nullptr,
+                           nullptr, MOJO_READ_MESSAGE_FLAG_NONE));
+
+  router0.EndBatch();
+
+  // Discard the batch, which is too large for the (empty) buffer.
+  EXPECT_EQ(MOJO_RESULT_RESOURCE_EXHAUSTED,
+            ReadMessageRaw(handle1_.get(), nullptr, nullptr, nullptr, nullptr,
+                           MOJO_READ_MESSAGE_FLAG_MAY_DISCARD));
+  EXPECT_EQ(MOJO_RESULT_SHOULD_WAIT,
+            ReadMessageRaw(handle1_.get(), nullptr, &num_bytes, nullptr,
+                           nullptr, MOJO_READ_MESSAGE_FLAG_NONE));
+}
+
+TEST_F(RouterTest, BatchedMessagesAreDispatchedInOrder) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+
+  MessageQueue message_queue;
+  OneWayMessageAccumulator accumulator(&message_queue);
+  router1.set_incoming_receiver(&accumulator);
+
+  MessagePipe pipe;
+  router0.BeginBatch();
+  {
+    Message message;
+    AllocOneWayMessage(0, "first", &message);
+    EXPECT_TRUE(router0.Accept(&message));
+
+    // The handles of batched messages are transferred along with them.
+    AllocOneWayMessage(1, "second", &message);
+    message.mutable_handles()->push_back(pipe.handle0.release());
+    EXPECT_TRUE(router0.Accept(&message));
+
+    AllocOneWayMessage(2, "third", &message);
+    EXPECT_TRUE(router0.Accept(&message));
+  }
+
+  PumpMessages();
+  EXPECT_TRUE(message_queue.IsEmpty());
+
+  router0.EndBatch();
+  PumpMessages();
+
+  const char* const kExpected[] = {"first", "second", "third"};
+  for (uint32_t i = 0; i < MOJO_ARRAYSIZE(kExpected); ++i) {
+    ASSERT_FALSE(message_queue.IsEmpty());
+    Message message;
+    message_queue.Pop(&message);
+    EXPECT_EQ(i, message.name());
+    EXPECT_EQ(std::string(kExpected[i]),
+              std::string(reinterpret_cast<const char*>(message.payload())));
+    EXPECT_EQ(i == 1 ? 1u : 0u, message.handles()->size());
+  }
+  EXPECT_TRUE(message_queue.IsEmpty());
+  EXPECT_FALSE(router1.encountered_error());
+}
+
+TEST_F(RouterTest, RequestFlushesBatch) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+
+  MessageQueue message_queue;
+  OneWayMessageAccumulator accumulator(&message_queue);
+  router1.set_incoming_receiver(&accumulator);
+
+  router0.BeginBatch();
+
+  Message message;
+  AllocOneWayMessage(1, "one-way", &message);
+  EXPECT_TRUE(router0.Accept(&message));
+
+  // The request must not overtake the batched message, nor wait for the batch
+  // to end.
+  Message request;
+  AllocRequestMessage(2, "request", &request);
+  MessageQueue response_queue;
+  EXPECT_TRUE(router0.AcceptWithResponder(
+      &request, new MessageAccumulator(&response_queue)));
+
+  PumpMessages();
+
+  ASSERT_FALSE(message_queue.IsEmpty());
+  message_queue.Pop(&message);
+  EXPECT_EQ(std::string("one-way"),
+            std::string(reinterpret_cast<const char*>(message.payload())));
+  EXPECT_FALSE(response_queue.IsEmpty());
+
+  router0.EndBatch();
+}
+
+// The rest of a batch can't be handed over with the pipe, so the pipe is
+// closed rather than passed on with messages silently missing.
+TEST_F(RouterTest, PassPipeInTheMiddleOfABatch) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+
+  MessageQueue message_queue;
+  PipePassingAccumulator accumulator(&message_queue, &router1, 1u);
+  router1.set_incoming_receiver(&accumulator);
+
+  router0.BeginBatch();
+  for (uint32_t i = 0; i < 3; ++i) {
+    Message message;
+    AllocOneWayMessage(i, "hello", &message);
+    EXPECT_TRUE(router0.Accept(&message));
+  }
+  router0.EndBatch();
+  PumpMessages();
+
+  EXPECT_FALSE(accumulator.passed_pipe().is_valid());
+  EXPECT_FALSE(router1.is_valid());
+  EXPECT_TRUE(router0.encountered_error());
+  for (uint32_t i = 0; i < 2; ++i) {
+    ASSERT_FALSE(message_queue.IsEmpty());
+    Message message;
+    message_queue.Pop(&message);
+    EXPECT_EQ(i, message.name());
+  }
+  EXPECT_TRUE(message_queue.IsEmpty());
+}
+
+// Once the whole batch has been dispatched, the pipe can be passed on as
+// usual, and it still carries the messages that follow the batch.
+TEST_F(RouterTest, PassPipeAtTheEndOfABatch) {
+  internal::Router router0(handle0_.Pass(), internal::FilterChain());
+  internal::Router router1(handle1_.Pass(), internal::FilterChain());
+
+  MessageQueue message_queue;
+  PipePassingAccumulator accumulator(&message_queue, &router1, 1u);
+  router1.set_incoming_receiver(&accumulator);
+
+  router0.BeginBatch();
+  for (uint32_t i = 0; i < 2; ++i) {
+    Message message;
+    AllocOneWayMessage(i, "hello", &message);
+    EXPECT_TRUE(router0.Accept(&message));
+  }
+  router0.EndBatch();
+  PumpMessages();
+
+  ScopedMessagePipeHandle passed_pipe = accumulator.passed_pipe();
+  EXPECT_TRUE(passed_pipe.is_valid());
+
+  Message message;
+  AllocOneWayMessage(2, "after", &message);
+  EXPECT_TRUE(router0.Accept(&message));
+  PumpMessages();
+  EXPECT_FALSE(router0.encountered_error());
+
+  internal::Router router2(passed_pipe.Pass(), internal::FilterChain());
+  MessageQueue passed_queue;
+  OneWayMessageAccumulator passed_accumulator(&passed_queue);
+  router2.set_incoming_receiver(&passed_accumulator);
+  PumpMessages();
+
+  ASSERT_FALSE(passed_queue.IsEmpty());
+  passed_queue.Pop(&message);
+  EXPECT_EQ(2u, message.name());
+  EXPECT_TRUE(passed_queue.IsEmpty());
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace mojo
@@ -0,0 +1,253 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/bindings/lib/bounds_checker.h"
+#include "mojo/public/cpp/bindings/lib/fixed_buffer.h"
+#include "mojo/public/cpp/bindings/lib/spillable_bytes_internal.h"
+#include "mojo/public/cpp/environment/environment.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "mojo/public/cpp/system/macros.h"
+#include "mojo/public/cpp/utility/run_loop.h"
+#include "mojo/public/interfaces/bindings/tests/spillable_bytes.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace mojo {
+namespace test {
+namespace {
+
+// The threshold given to the fields in spillable_bytes.mojom.
+const size_t kThreshold = 1024;
+
+Array<uint8_t> MakeBytes(size_t size) {
+  auto bytes = Array<uint8_t>::New(size);
+  for (size_t i = 0; i < size; ++i)
+    bytes[i] = static_cast<uint8_t>(i * 7);
+  return bytes.Pass();
+}
+
+class BytesEchoImpl : public BytesEcho {
+ public:
+  explicit BytesEchoImpl(InterfaceRequest<BytesEcho> request)
+      : binding_(this, request.Pass()) {}
+  ~BytesEchoImpl() override {}
+
+  void Echo(Array<uint8_t> data, const EchoCallback& callback) override {
+    callback.Run(data.Pass());
+  }
+
+  void EchoHolder(SpillableBytesHolderPtr holder,
+                  const EchoHolderCallback& callback) override {
+    callback.Run(holder.Pass());
+  }
+
+ private:
+  Binding<BytesEcho> binding_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(BytesEchoImpl);
+};
+
+class SpillableBytesTest : public testing::Test {
+ public:
+  SpillableBytesTest() {}
+  ~SpillableBytesTest() override {}
+
+  void PumpMessages() { loop_.RunUntilIdle(); }
+
+ private:
+  Environment env_;
+  RunLoop loop_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(SpillableBytesTest);
+};
+
+// Serializes |holder|, checks whether its bytes were spilled, and returns the
+// result of deserializing it again.
+SpillableBytesHolderPtr RoundTrip(SpillableBytesHolderPtr holder,
+                                  bool expect_spilled) {
+  size_t size = GetSerializedSize_(*holder);
+  mojo::internal::FixedBufferForTesting buf(size);
+  internal::SpillableBytesHolder_Data* data;
+  EXPECT_EQ(mojo::internal::ValidationError::NONE,
+            Serialize_(holder.get(), &buf, &data));
+  EXPECT_TRUE(data->data.ptr);
+  EXPECT_EQ(expect_spilled, !data->data.ptr->bytes.ptr);
+  EXPECT_EQ(expect_spilled, data->data.ptr->buffer.is_valid());
+
+  std::vector<Handle> handles;
+  data->EncodePointersAndHandles(&handles);
+  EXPECT_EQ(expect_spilled ? 1u : 0u, handles.size());
+
+  mojo::internal::BoundsChecker bounds_checker(
+      data, static_cast<uint32_t>(size), handles.size());
+  bounds_checker.set_handles(&handles);
+  EXPECT_EQ(mojo::internal::ValidationError::NONE,
+            internal::SpillableBytesHolder_Data::Validate(data, &bounds_checker,
+                                                          nullptr));
+
+  data->DecodePointersAndHandles(&handles);
+  SpillableBytesHolderPtr output(SpillableBytesHolder::New());
+  Deserialize_(data, output.get());
+  return output.Pass();
+}
+
+TEST_F(SpillableBytesTest, SmallArrayIsInline) {
+  SpillableBytesHolderPtr holder(SpillableBytesHolder::New());
+  holder->data = MakeBytes(kThreshold - 1);
+  holder->tag = 42u;
+
+  SpillableBytesHolderPtr output = RoundTrip(holder.Clone(), false);
+  EXPECT_TRUE(output->Equals(*holder));
+}
+
+TEST_F(SpillableBytesTest, LargeArrayIsSpilled) {
+  SpillableBytesHolderPtr holder(SpillableBytesHolder::New());
+  holder->data = MakeBytes(kThreshold);
+  holder->tag = 42u;
+
+  SpillableBytesHolderPtr output = RoundTrip(holder.Clone(), true);
+  EXPECT_TRUE(output->Equals(*holder));
+}
+
+TEST_F(SpillableBytesTest, NullArray) {
+  SpillableBytesHolderPtr holder(SpillableBytesHolder::New());
+  holder->tag = 42u;
+
+  size_t size = GetSerializedSize_(*holder);
+  mojo::internal::FixedBufferForTesting buf(size);
+  internal::SpillableBytesHolder_Data* data;
+  EXPECT_EQ(mojo::internal::ValidationError::NONE,
+            Serialize_(holder.get(), &buf, &data));
+  EXPECT_FALSE(data->data.ptr);
+
+  SpillableBytesHolderPtr output(SpillableBytesHolder::New());
+  Deserialize_(data, output.get());
+  EXPECT_TRUE(output->data.is_null());
+  EXPECT_EQ(42u, output->tag);
+}
+
+TEST_F(SpillableBytesTest, RejectsMissingBytesAndBuffer) {
+  mojo::internal::FixedBufferForTesting buf(
+      sizeof(mojo::internal::SpillableBytes_Data));
+  mojo::internal::SpillableBytes_Data* data =
+      mojo::internal::SpillableBytes_Data::New(&buf);
+
+  std::vector<Handle> handles;
+  data->EncodePointersAndHandles(&handles);
+  mojo::internal::BoundsChecker bounds_checker(
+      data, sizeof(mojo::internal::SpillableBytes_Data), 0);
+  EXPECT_EQ(mojo::internal::ValidationError::UNEXPECTED_INVALID_HANDLE,
+            mojo::internal::SpillableBytes_Data::Validate(
+                data, &bounds_checker, nullptr));
+}
+
+TEST_F(SpillableBytesTest, SizedTwiceIsSpilledOnce) {
+  SpillableBytesHolderPtr holder(SpillableBytesHolder::New());
+  holder->data = MakeBytes(kThreshold);
+  holder->tag = 42u;
+
+  size_t size = GetSerializedSize_(*holder);
+  EXPECT_EQ(size, GetSerializedSize_(*holder));
+  SpillableBytesHolderPtr output = RoundTrip(holder.Clone(), true);
+  EXPECT_TRUE(output->Equals(*holder));
+}
+
+// Returns spilled bytes claiming |buffer_num_bytes| bytes, but backed by a
+// buffer of |actual_num_bytes| bytes. Its handle is appended to |handles|.
+mojo::internal::SpillableBytes_Data* MakeSpilledBytes(
+    mojo::internal::Buffer* buf,
+    uint32_t buffer_num_bytes,
+    uint64_t actual_num_bytes,
+    std::vector<Handle>* handles) {
+  mojo::internal::SpillableBytes_Data* data =
+      mojo::internal::SpillableBytes_Data::New(buf);
+  ScopedSharedBufferHandle buffer;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            CreateSharedBuffer(nullptr, actual_num_bytes, &buffer));
+  data->buffer = buffer.release();
+  data->buffer_num_bytes = buffer_num_bytes;
+  data->EncodePointersAndHandles(handles);
+  return data;
+}
+
+mojo::internal::ValidationError ValidateSpilledBytes(
+    mojo::internal::SpillableBytes_Data* data,
+    const std::vector<Handle>& handles) {
+  mojo::internal::BoundsChecker bounds_checker(
+      data, sizeof(mojo::internal::SpillableBytes_Data), handles.size());
+  bounds_checker.set_handles(&handles);
+  return mojo::internal::SpillableBytes_Data::Validate(data, &bounds_checker,
+                                                       nullptr);
+}
+
+TEST_F(SpillableBytesTest, AcceptsBufferOfClaimedSize) {
+  mojo::internal::FixedBufferForTesting buf(
+      sizeof(mojo::internal::SpillableBytes_Data));
+  std::vector<Handle> handles;
+  mojo::internal::SpillableBytes_Data* data =
+      MakeSpilledBytes(&buf, kThreshold, kThreshold, &handles);
+  EXPECT_EQ(mojo::internal::ValidationError::NONE,
+            ValidateSpilledBytes(data, handles));
+  CloseRaw(handles[0]);
+}
+
+TEST_F(SpillableBytesTest, RejectsBufferSmallerThanClaimed) {
+  mojo::internal::FixedBufferForTesting buf(
+      sizeof(mojo::internal::SpillableBytes_Data));
+  std::vector<Handle> handles;
+  mojo::internal::SpillableBytes_Data* data =
+      MakeSpilledBytes(&buf, 1024 * 1024, kThreshold, &handles);
+  EXPECT_EQ(mojo::internal::ValidationError::UNEXPECTED_ARRAY_HEADER,
+            ValidateSpilledBytes(data, handles));
+  CloseRaw(handles[0]);
+}
+
+TEST_F(SpillableBytesTest, RejectsEmptyBuffer) {
+  mojo::internal::FixedBufferForTesting buf(
+      sizeof(mojo::internal::SpillableBytes_Data));
+  std::vector<Handle> handles;
+  mojo::internal::SpillableBytes_Data* data =
+      MakeSpilledBytes(&buf, 0, kThreshold, &handles);
+  EXPECT_EQ(mojo::internal::ValidationError::UNEXPECTED_ARRAY_HEADER,
+            ValidateSpilledBytes(data, handles));
+  CloseRaw(handles[0]);
+}
+
+TEST_F(SpillableBytesTest, MethodParameters) {
+  BytesEchoPtr echo;
+  BytesEchoImpl impl(GetProxy(&echo));
+
+  const size_t kSizes[] = {0, kThreshold - 1, kThreshold, 1024 * 1024};
+  for (size_t size : kSizes) {
+    Array<uint8_t> bytes = MakeBytes(size);
+    Array<uint8_t> result;
+    echo->Echo(bytes.Clone(),
+               [&result](Array<uint8_t> data) { result = data.Pass(); });
+    PumpMessages();
+    EXPECT_TRUE(result.Equals(bytes)) << "size " << size;
+  }
+}
+
+TEST_F(SpillableBytesTest, StructParameters) {
+  BytesEchoPtr echo;
+  BytesEchoImpl impl(GetProxy(&echo));
+
+  SpillableBytesHolderPtr holder(SpillableBytesHolder::New());
+  holder->data = MakeBytes(64 * 1024);
+  holder->tag = 7u;
+
+  SpillableBytesHolderPtr result;
+  echo->EchoHolder(holder.Clone(), [&result](SpillableBytesHolderPtr holder) {
+    result = holder.Pass();
+  });
+  PumpMessages();
+  ASSERT_TRUE(result);
+  EXPECT_TRUE(result->Equals(*holder));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace mojo
@@ -403,6 +403,45 @@ TEST_F(ValidationTest, ResponseBoundsCheck) {
   RunValidationTests("resp_boundscheck_", validators.GetHead());
 }
 
+// Version 3 message headers carry |send_time_ticks|, so they must be large
+// enough to hold it. This is checked here rather than by a data file, since
+// only the C++ bindings know about version 3 headers.
+TEST_F(ValidationTest, MessageHeaderWithSendTime) {
+  const struct {
+    const char* input;
+    mojo::internal::ValidationError expected;
+  } kTestCases[] = {
+      {"[u4]40 [u4]3 [u4]0 [u4]0 [u8]0 [u4]0 [u4]0 [s8]12345",
+       mojo::internal::ValidationError::NONE},
+      // Too small for |send_time_ticks|.
+      {"[u4]32 [u4]3 [u4]0 [u4]0 [u8]0 [u4]0 [u4]0",
+       mojo::internal::ValidationError::UNEXPECTED_STRUCT_HEADER},
+      {"[u4]32 [u4]4 [u4]0 [u4]0 [u8]0 [u4]0 [u4]0",
+       mojo::internal::ValidationError::UNEXPECTED_STRUCT_HEADER},
+  };
+
+  DummyMessageReceiver dummy_receiver;
+  mojo::internal::FilterChain validators(&dummy_receiver);
+  validators.Append<mojo::internal::MessageHeaderValidator>();
+  for (size_t i = 0; i < MOJO_ARRAYSIZE(kTestCases); ++i) {
+    std::vector<uint8_t> data;
+    size_t num_handles = 0;
+    std::string error_message;
+    ASSERT_TRUE(ParseValidationTestInput(kTestCases[i].input, &data,
+                                         &num_handles, &error_message))
+        << error_message;
+
+    Message message;
+    message.AllocUninitializedData(static_cast<uint32_t>(data.size()));
+    memcpy(message.mutable_data(), &data[0], data.size());
+
+    mojo::internal::ValidationErrorObserverForTesting observer;
+    mojo_ignore_result(validators.GetHead()->Accept(&message));
+    EXPECT_EQ(kTestCases[i].expected, observer.last_error())
+        << "failed test: " << kTestCases[i].input;
+  }
+}
+
 // Test that InterfacePtr<X> applies the correct validators and they don't
 // conflict with each other:
 //   - MessageHeaderValidator
@@ -0,0 +1,295 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mojo/public/cpp/utility/lib/delayed_task_queue.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "mojo/public/cpp/system/functions.h"
+
+namespace mojo {
+namespace internal {
+namespace {
+
+const int64_t kMicrosecondsPerTick = 1000;
+
+// Returns the index of the lowest bit set in |bits|, which must not be zero.
+int FindFirstSet(uint64_t bits) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(bits);
+#else
+  int index = 0;
+  while (!(bits & 1)) {
+    bits >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+}  // namespace
+
+// Orders the indices of |due_| so that the task to run next is at the top of
+// the heap.
+class DelayedTaskQueue::DueOrder {
+ public:
+  explicit DueOrder(const std::vector<Entry>* entries) : entries_(entries) {}
+
+  bool operator()(int a, int b) const {
+    const Entry& entry_a = (*entries_)[a];
+    const Entry& entry_b = (*entries_)[b];
+    if (entry_a.run_time != entry_b.run_time)
+      return entry_a.run_time > entry_b.run_time;
+    return entry_a.sequence_number > entry_b.sequence_number;
+  }
+
+ private:
+  const std::vector<Entry>* entries_;
+};
+
+DelayedTaskQueue::Entry::Entry()
+    : run_time(0),
+      sequence_number(0),
+      generation(1),
+      slot(kFree),
+      prev(-1),
+      next(-1) {
+}
+
+DelayedTaskQueue::Entry::~Entry() {
+}
+
+DelayedTaskQueue::DelayedTaskQueue()
+    : free_list_(-1), current_tick_(0), size_(0), next_sequence_number_(0) {
+  std::fill(slots_, slots_ + kNumLevels * kSlotsPerLevel, -1);
+  std::fill(occupied_, occupied_ + kNumLevels, 0);
+}
+
+DelayedTaskQueue::~DelayedTaskQueue() {
+}
+
+DelayedTaskQueue::TaskId DelayedTaskQueue::Push(const Closure& task,
+                                                MojoTimeTicks run_time) {
+  if (!size_) {
+    // Nothing is in the wheel, so it can start again from now, after dropping
+    // the canceled entries left in |due_|.
+    for (size_t i = 0; i < due_.size(); ++i)
+      AddToFreeList(due_[i]);
+    due_.clear();
+    current_tick_ = TickOf(GetTimeTicksNow());
+  }
+
+  int index = free_list_;
+  if (index != -1) {
+    free_list_ = entries_[index].next;
+  } else {
+    index = static_cast<int>(entries_.size());
+    entries_.push_back(Entry());
+  }
+
+  Entry& entry = entries_[index];
+  entry.task = task;
+  entry.run_time = run_time;
+  entry.sequence_number = next_sequence_number_++;
+  Insert(index);
+  ++size_;
+  return (static_cast<TaskId>(entry.generation) << 32) |
+         static_cast<uint32_t>(index);
+}
+
+bool DelayedTaskQueue::Cancel(TaskId id) {
+  const int index = Find(id);
+  if (index == -1)
+    return false;
+
+  Entry& entry = entries_[index];
+  if (!++entry.generation)
+    entry.generation = 1;
+  // Taking an entry out of the middle of |due_| would not take constant
+  // time, so it is only marked, and NextRunTime() drops it.
+  if (entry.slot == kDue) {
+    entry.slot = kDueCanceled;
+  } else {
+    Unlink(index);
+    AddToFreeList(index);
+  }
+  --size_;
+
+  // Deleting the task may call back into the queue, so it is left to the
+  // destructor of this copy.
+  Closure task = entry.task;
+  entry.task.reset();
+  return true;
+}
+
+MojoTimeTicks DelayedTaskQueue::NextRunTime(MojoTimeTicks now) {
+  assert(!empty());
+  const int64_t now_tick = TickOf(now);
+  for (;;) {
+    while (!due_.empty() && entries_[due_.front()].slot == kDueCanceled)
+      PopDue();
+    if (!due_.empty())
+      return entries_[due_.front()].run_time;
+    const int64_t next_tick = NextTick();
+    if (next_tick > now_tick)
+      return next_tick * kMicrosecondsPerTick;
+    Turn();
+  }
+}
+
+Closure DelayedTaskQueue::Pop() {
+  NextRunTime(std::numeric_limits<MojoTimeTicks>::max());
+  Entry& entry = entries_[due_.front()];
+  if (!++entry.generation)
+    entry.generation = 1;
+  Closure task = entry.task;
+  entry.task.reset();
+  PopDue();
+  --size_;
+  return task;
+}
+
+// static
+int64_t DelayedTaskQueue::TickOf(MojoTimeTicks time) {
+  return time / kMicrosecondsPerTick;
+}
+
+int DelayedTaskQueue::Find(TaskId id) const {
+  const size_t index = static_cast<size_t>(id & 0xffffffff);
+  if (index >= entries_.size())
+    return -1;
+  const Entry& entry = entries_[index];
+  if (entry.generation != static_cast<uint32_t>(id >> 32) ||
+      entry.slot == kFree || entry.slot == kDueCanceled) {
+    return -1;
+  }
+  return static_cast<int>(index);
+}
+
+// Places the entry at |index| in the slot for its run time, or in |due_| if
+// it is due at the wheel's current time.
+void DelayedTaskQueue::Insert(int index) {
+  Entry& entry = entries_[index];
+  int64_t tick = TickOf(entry.run_time);
+  if (tick <= current_tick_) {
+    entry.slot = kDue;
+    due_.push_back(index);
+    std::push_heap(due_.begin(), due_.end(), DueOrder(&entries_));
+    return;
+  }
+
+  // A task beyond the reach of the top level waits in its farthest slot, and
+  // is placed again from there.
+  const int64_t kMaxDelta =
+      (static_cast<int64_t>(1) << (kLevelBits * kNumLevels)) - 1;
+  tick = std::min(tick, current_tick_ + kMaxDelta);
+  int level = 0;
+  while ((tick - current_tick_) >> (kLevelBits * (level + 1)))
+    ++level;
+
+  const int bit = static_cast<int>((tick >> (kLevelBits * level)) &
+                                   (kSlotsPerLevel - 1));
+  const int slot = level * kSlotsPerLevel + bit;
+  entry.slot = slot;
+  entry.prev = -1;
+  entry.next = slots_[slot];
+  if (entry.next != -1)
+    entries_[entry.next].prev = index;
+  slots_[slot] = index;
+  occupied_[level] |= static_cast<uint64_t>(1) << bit;
+}
+
+// Unlinks the entry at |index| from its slot.
+void DelayedTaskQueue::Unlink(int index) {
+  Entry& entry = entries_[index];
+  assert(entry.slot >= 0);
+  if (entry.prev != -1)
+    entries_[entry.prev].next = entry.next;
+  else
+    slots_[entry.slot] = entry.next;
+  if (entry.next != -1)
+    entries_[entry.next].prev = entry.prev;
+  if (slots_[entry.slot] == -1) {
+    occupied_[entry.slot / kSlotsPerLevel] &=
+        ~(static_cast<uint64_t>(1) << (entry.slot % kSlotsPerLevel));
+  }
+  entry.slot = kFree;
+}
+
+// Returns the tick at which the wheel gets to its next non-empty slot, which
+// no task in the wheel is due before. The wheel must not be empty.
+int64_t DelayedTaskQueue::NextTick() const {
+  int64_t next_tick = std::numeric_limits<int64_t>::max();
+  for (int level = 0; level < kNumLevels; ++level) {
+    if (occupied_[level])
+      next_tick = std::min(next_tick, NextTickOfLevel(level));
+  }
+  assert(next_tick != std::numeric_limits<int64_t>::max());
+  return next_tick;
+}
+
+// Turns the wheel to its next non-empty slot, and moves the tasks of every
+// slot which comes due there down a level, or to |due_|.
+void DelayedTaskQueue::Turn() {
+  const int64_t kNoTick = std::numeric_limits<int64_t>::max();
+  int64_t next_ticks[kNumLevels];
+  int64_t next_tick = kNoTick;
+  for (int level = 0; level < kNumLevels; ++level) {
+    next_ticks[level] = occupied_[level] ? NextTickOfLevel(level) : kNoTick;
+    next_tick = std::min(next_tick, next_ticks[level]);
+  }
+  assert(next_tick != kNoTick);
+  current_tick_ = next_tick;
+
+  for (int level = kNumLevels - 1; level >= 0; --level) {
+    if (next_ticks[level] != next_tick)
+      continue;
+    const int bit = static_cast<int>((next_tick >> (kLevelBits * level)) &
+                                     (kSlotsPerLevel - 1));
+    const int slot = level * kSlotsPerLevel + bit;
+    int index = slots_[slot];
+    slots_[slot] = -1;
+    occupied_[level] &= ~(static_cast<uint64_t>(1) << bit);
+    while (index != -1) {
+      const int next = entries_[index].next;
+      Insert(index);
+      index = next;
+    }
+  }
+}
+
+// Returns the tick at which the wheel gets to the next non-empty slot of
+// |level|, which must have one.
+int64_t DelayedTaskQueue::NextTickOfLevel(int level) const {
+  assert(occupied_[level]);
+  const int shift = kLevelBits * level;
+  const int64_t current_slot_tick = current_tick_ >> shift;
+  // Rotate the bits so that the slot after the current one comes first, and
+  // the current one comes last.
+  const int first =
+      static_cast<int>((current_slot_tick + 1) & (kSlotsPerLevel - 1));
+  uint64_t bits = occupied_[level];
+  if (first)
+    bits = (bits >> first) | (bits << (kSlotsPerLevel - first));
+  return (current_slot_tick + FindFirstSet(bits) + 1) << shift;
+}
+
+// Removes the top of |due_|, and frees its entry.
+void DelayedTaskQueue::PopDue() {
+  std::pop_heap(due_.begin(), due_.end(), DueOrder(&entries_));
+  AddToFreeList(due_.back());
+  due_.pop_back();
+}
+
+void DelayedTaskQueue::AddToFreeList(int index) {
+  entries_[index].slot = kFree;
+  entries_[index].next = free_list_;
+  free_list_ = index;
+}
+
+}  // namespace internal
+}  // namespace mojo
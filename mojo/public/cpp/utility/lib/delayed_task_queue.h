@@ -0,0 +1,132 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MOJO_PUBLIC_CPP_UTILITY_LIB_DELAYED_TASK_QUEUE_H_
+#define MOJO_PUBLIC_CPP_UTILITY_LIB_DELAYED_TASK_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "mojo/public/c/system/types.h"
+#include "mojo/public/cpp/bindings/callback.h"
+#include "mojo/public/cpp/system/macros.h"
+
+namespace mojo {
+namespace internal {
+
+// The delayed tasks of a RunLoop. Tasks come out in the order of their run
+// times, and in the order they were pushed for equal run times, but adding a
+// task and canceling one both take constant time.
+//
+// This is a hierarchical timing wheel with a resolution of one millisecond,
+// like base::DelayedTaskQueue: a task goes in the slot of the lowest level
+// which reaches its run time, and moves down a level each time the wheel
+// turns to its slot. The tasks of the slots which have come due are kept in a
+// binary heap. The wheel only turns when the due tasks have all been popped,
+// and NextRunTime() does not turn it past the current time, so that the tasks
+// pushed after one due much later still go in its slots rather than in the
+// heap, where canceling them would leave their entries behind.
+class DelayedTaskQueue {
+ public:
+  // Identifies a task for Cancel(). Never 0.
+  typedef uint64_t TaskId;
+
+  DelayedTaskQueue();
+  ~DelayedTaskQueue();
+
+  TaskId Push(const Closure& task, MojoTimeTicks run_time);
+
+  // Removes and deletes the task with |id|, if it has not been popped or
+  // canceled already. Returns true if it removed the task.
+  bool Cancel(TaskId id);
+
+  // Returns the run time of the task to run next if the wheel gets to it by
+  // |now|, and otherwise a time after |now| and at or before it, at which to
+  // ask again. The queue must not be empty.
+  MojoTimeTicks NextRunTime(MojoTimeTicks now);
+
+  // Removes the task to run next, and returns it, turning the wheel as far as
+  // it takes. The queue must not be empty.
+  Closure Pop();
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+ private:
+  enum {
+    kLevelBits = 6,
+    kSlotsPerLevel = 1 << kLevelBits,
+    kNumLevels = 6,
+  };
+
+  // Where an Entry is.
+  enum {
+    kFree = -1,
+    kDue = -2,
+    // Canceled, but still in |due_|.
+    kDueCanceled = -3,
+  };
+
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    Closure task;
+    MojoTimeTicks run_time;
+    uint64_t sequence_number;
+    // Bumped each time the entry is reused, so that the ids of the tasks it
+    // held before are stale.
+    uint32_t generation;
+    // Index of the slot in |slots_|, or one of the values above.
+    int slot;
+    // Links to the neighbors in the slot's list, or to the next entry in the
+    // free list.
+    int prev;
+    int next;
+  };
+
+  class DueOrder;
+
+  static int64_t TickOf(MojoTimeTicks time);
+
+  // Returns the index of the entry with |id|, or -1 if its task has been
+  // popped or canceled.
+  int Find(TaskId id) const;
+
+  void Insert(int index);
+  void Unlink(int index);
+  int64_t NextTick() const;
+  void Turn();
+  int64_t NextTickOfLevel(int level) const;
+  void PopDue();
+  void AddToFreeList(int index);
+
+  std::vector<Entry> entries_;
+  int free_list_;
+
+  // The heads of the slot lists, -1 if empty. The slots of each level follow
+  // those of the level below.
+  int slots_[kNumLevels * kSlotsPerLevel];
+
+  // A bit for each slot of each level which is not empty.
+  uint64_t occupied_[kNumLevels];
+
+  // Heap of the indices of the entries due at or before |current_tick_|.
+  std::vector<int> due_;
+
+  // The wheel's current time, in milliseconds.
+  int64_t current_tick_;
+
+  size_t size_;
+  uint64_t next_sequence_number_;
+
+  MOJO_DISALLOW_COPY_AND_ASSIGN(DelayedTaskQueue);
+};
+
+}  // namespace internal
+}  // namespace mojo
+
+#endif  // MOJO_PUBLIC_CPP_UTILITY_LIB_DELAYED_TASK_QUEUE_H_
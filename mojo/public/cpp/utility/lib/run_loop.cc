@@ -37,7 +37,7 @@ struct RunLoop::RunState {
 };
 
 RunLoop::RunLoop()
-    : run_state_(nullptr), next_handler_id_(0), next_sequence_number_(0) {
+    : run_state_(nullptr), next_handler_id_(0) {
   assert(!current());
   current_run_loop.Set(this);
 }
@@ -121,10 +121,8 @@ void RunLoop::RunInternal(RunMode run_mode) {
 
 bool RunLoop::DoDelayedWork() {
   MojoTimeTicks now = GetTimeTicksNow();
-  if (!delayed_tasks_.empty() && delayed_tasks_.top().run_time <= now) {
-    PendingTask task = delayed_tasks_.top();
-    delayed_tasks_.pop();
-    task.task.Run();
+  if (!delayed_tasks_.empty() && delayed_tasks_.NextRunTime(now) <= now) {
+    delayed_tasks_.Pop().Run();
     return true;
   }
   return false;
@@ -136,10 +134,15 @@ void RunLoop::Quit() {
     run_state_->should_quit = true;
 }
 
-void RunLoop::PostDelayedTask(const Closure& task, MojoTimeTicks delay) {
+uint64_t RunLoop::PostDelayedTask(const Closure& task, MojoTimeTicks delay) {
   assert(current() == this);
   MojoTimeTicks run_time = delay + GetTimeTicksNow();
-  delayed_tasks_.push(PendingTask(task, run_time, next_sequence_number_++));
+  return delayed_tasks_.Push(task, run_time);
+}
+
+bool RunLoop::CancelDelayedTask(uint64_t id) {
+  assert(current() == this);
+  return delayed_tasks_.Cancel(id);
 }
 
 bool RunLoop::Wait(bool non_blocking) {
@@ -212,7 +215,7 @@ bool RunLoop::NotifyHandlers(MojoResult error, CheckDeadline check) {
   return notified;
 }
 
-RunLoop::WaitState RunLoop::GetWaitState(bool non_blocking) const {
+RunLoop::WaitState RunLoop::GetWaitState(bool non_blocking) {
   WaitState wait_state;
   MojoTimeTicks min_time = kInvalidTimeTicks;
   for (HandleToHandlerData::const_iterator i = handler_data_.begin();
@@ -226,7 +229,10 @@ RunLoop::WaitState RunLoop::GetWaitState(bool non_blocking) const {
     }
   }
   if (!delayed_tasks_.empty()) {
-    MojoTimeTicks delayed_min_time = delayed_tasks_.top().run_time;
+    // Only a lower bound while no task is due, so the loop may wake up early
+    // and wait again.
+    MojoTimeTicks delayed_min_time =
+        delayed_tasks_.NextRunTime(GetTimeTicksNow());
     if (min_time == kInvalidTimeTicks)
       min_time = delayed_min_time;
     else
@@ -244,24 +250,4 @@ RunLoop::WaitState RunLoop::GetWaitState(bool non_blocking) const {
   return wait_state;
 }
 
-RunLoop::PendingTask::PendingTask(const Closure& task,
-                                  MojoTimeTicks run_time,
-                                  uint64_t sequence_number)
-    : task(task), run_time(run_time), sequence_number(sequence_number) {
-}
-
-RunLoop::PendingTask::~PendingTask() {
-}
-
-bool RunLoop::PendingTask::operator<(const RunLoop::PendingTask& other) const {
-  if (run_time != other.run_time) {
-    // std::priority_queue<> puts the least element at the end of the queue. We
-    // want the soonest eligible task to be at the head of the queue, so
-    // run_times further in the future are considered lesser.
-    return run_time > other.run_time;
-  }
-
-  return sequence_number > other.sequence_number;
-}
-
 }  // namespace mojo
@@ -5,11 +5,13 @@
 #ifndef MOJO_PUBLIC_CPP_UTILITY_RUN_LOOP_H_
 #define MOJO_PUBLIC_CPP_UTILITY_RUN_LOOP_H_
 
+#include <stdint.h>
+
 #include <map>
-#include <queue>
 
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/public/cpp/system/core.h"
+#include "mojo/public/cpp/utility/lib/delayed_task_queue.h"
 
 namespace mojo {
 
@@ -63,8 +65,12 @@ class RunLoop {
   void Quit();
 
   // Adds a task to be performed after delay has elapsed. Must be posted to the
-  // current thread's RunLoop.
-  void PostDelayedTask(const Closure& task, MojoTimeTicks delay);
+  // current thread's RunLoop. Returns an id for CancelDelayedTask().
+  uint64_t PostDelayedTask(const Closure& task, MojoTimeTicks delay);
+
+  // Removes and deletes the task posted with |id|, unless it has already run
+  // or been canceled. Returns true if it removed the task.
+  bool CancelDelayedTask(uint64_t id);
 
  private:
   struct RunState;
@@ -115,7 +121,7 @@ class RunLoop {
   bool NotifyHandlers(MojoResult error, CheckDeadline check);
 
   // Returns the state needed to pass to WaitMany().
-  WaitState GetWaitState(bool non_blocking) const;
+  WaitState GetWaitState(bool non_blocking);
 
   HandleToHandlerData handler_data_;
 
@@ -130,23 +136,8 @@ class RunLoop {
   // notify it.
   int next_handler_id_;
 
-  struct PendingTask {
-    PendingTask(const Closure& task,
-                MojoTimeTicks runtime,
-                uint64_t sequence_number);
-    ~PendingTask();
-
-    bool operator<(const PendingTask& other) const;
-
-    Closure task;
-    MojoTimeTicks run_time;
-    uint64_t sequence_number;
-  };
-  // An ever increasing sequence number attached to each pending task in order
-  // to preserve relative order of tasks posted at the 'same' time.
-  uint64_t next_sequence_number_;
-  typedef std::priority_queue<PendingTask> DelayedTaskQueue;
-  DelayedTaskQueue delayed_tasks_;
+  // Tasks posted at the 'same' time run in the order they were posted.
+  internal::DelayedTaskQueue delayed_tasks_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(RunLoop);
 };
@@ -401,6 +401,40 @@ TEST_F(RunLoopTest, DelayedTaskOrder) {
   EXPECT_EQ(3, sequence[2]);
 }
 
+TEST_F(RunLoopTest, DelayedTaskRunTimeOrder) {
+  std::vector<int> sequence;
+  RunLoop run_loop;
+  run_loop.PostDelayedTask(Closure(Task(1, &sequence)), 20000);
+  run_loop.PostDelayedTask(Closure(Task(2, &sequence)), 0);
+  run_loop.PostDelayedTask(Closure(Task(3, &sequence)), 5000);
+  run_loop.PostDelayedTask(Closure(Task(4, &sequence)), 5000);
+  run_loop.Run();
+
+  ASSERT_EQ(4u, sequence.size());
+  EXPECT_EQ(2, sequence[0]);
+  EXPECT_EQ(3, sequence[1]);
+  EXPECT_EQ(4, sequence[2]);
+  EXPECT_EQ(1, sequence[3]);
+}
+
+TEST_F(RunLoopTest, CancelDelayedTask) {
+  std::vector<int> sequence;
+  RunLoop run_loop;
+  uint64_t id1 = run_loop.PostDelayedTask(Closure(Task(1, &sequence)), 0);
+  uint64_t id2 = run_loop.PostDelayedTask(Closure(Task(2, &sequence)), 0);
+  uint64_t id3 =
+      run_loop.PostDelayedTask(Closure(Task(3, &sequence)), 1000000000);
+  EXPECT_TRUE(run_loop.CancelDelayedTask(id2));
+  EXPECT_FALSE(run_loop.CancelDelayedTask(id2));
+  EXPECT_TRUE(run_loop.CancelDelayedTask(id3));
+  // Run() returns as soon as the canceled tasks are gone.
+  run_loop.Run();
+
+  ASSERT_EQ(1u, sequence.size());
+  EXPECT_EQ(1, sequence[0]);
+  EXPECT_FALSE(run_loop.CancelDelayedTask(id1));
+}
+
 struct QuittingTask {
   explicit QuittingTask(RunLoop* run_loop) : run_loop(run_loop) {}
 
@@ -42,6 +42,10 @@ _kind_to_cpp_literal_suffix = {
   mojom.UINT64:       "ULL",
 }
 
+# Attribute of array<uint8> fields whose value is the size, in bytes, from
+# which the array is sent in a shared buffer rather than in the message.
+_SPILL_THRESHOLD_ATTRIBUTE = "SharedBufferThreshold"
+
 def ConstantValue(constant):
   return ExpressionToText(constant.value, kind=constant.kind)
 
@@ -93,6 +97,10 @@ def GetCppType(kind):
     return "mojo::internal::Interface_Data"
   if mojom.IsInterfaceRequestKind(kind):
     return "mojo::MessagePipeHandle"
+  if mojom.IsAssociatedInterfaceKind(kind):
+    return "mojo::internal::AssociatedInterface_Data"
+  if mojom.IsAssociatedInterfaceRequestKind(kind):
+    return "mojo::internal::AssociatedInterfaceRequest_Data"
   if mojom.IsEnumKind(kind):
     return "int32_t"
   if mojom.IsStringKind(kind):
@@ -117,6 +125,11 @@ def GetCppArrayArgWrapperType(kind):
                                    GetCppArrayArgWrapperType(kind.value_kind))
   if mojom.IsInterfaceRequestKind(kind):
     return "mojo::InterfaceRequest<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceKind(kind):
+    return "mojo::AssociatedInterfacePtrInfo<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceRequestKind(kind):
+    return "mojo::AssociatedInterfaceRequest<%s>" % (
+        GetNameForKind(kind.kind.kind))
   if mojom.IsStringKind(kind):
     return "mojo::String"
   if mojom.IsGenericHandleKind(kind):
@@ -145,6 +158,11 @@ def GetCppResultWrapperType(kind):
     return "%sPtr" % GetNameForKind(kind)
   if mojom.IsInterfaceRequestKind(kind):
     return "mojo::InterfaceRequest<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceKind(kind):
+    return "mojo::AssociatedInterfacePtrInfo<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceRequestKind(kind):
+    return "mojo::AssociatedInterfaceRequest<%s>" % (
+        GetNameForKind(kind.kind.kind))
   if mojom.IsStringKind(kind):
     return "mojo::String"
   if mojom.IsGenericHandleKind(kind):
@@ -173,6 +191,11 @@ def GetCppWrapperType(kind):
     return "%sPtr" % GetNameForKind(kind)
   if mojom.IsInterfaceRequestKind(kind):
     return "mojo::InterfaceRequest<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceKind(kind):
+    return "mojo::AssociatedInterfacePtrInfo<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceRequestKind(kind):
+    return "mojo::AssociatedInterfaceRequest<%s>" % (
+        GetNameForKind(kind.kind.kind))
   if mojom.IsStringKind(kind):
     return "mojo::String"
   if mojom.IsGenericHandleKind(kind):
@@ -199,6 +222,11 @@ def GetCppConstWrapperType(kind):
     return "%sPtr" % GetNameForKind(kind)
   if mojom.IsInterfaceRequestKind(kind):
     return "mojo::InterfaceRequest<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceKind(kind):
+    return "mojo::AssociatedInterfacePtrInfo<%s>" % GetNameForKind(kind.kind)
+  if mojom.IsAssociatedInterfaceRequestKind(kind):
+    return "mojo::AssociatedInterfaceRequest<%s>" % (
+        GetNameForKind(kind.kind.kind))
   if mojom.IsEnumKind(kind):
     return GetNameForKind(kind)
   if mojom.IsStringKind(kind):
@@ -232,6 +260,10 @@ def GetCppFieldType(kind):
     return "mojo::internal::Interface_Data"
   if mojom.IsInterfaceRequestKind(kind):
     return "mojo::MessagePipeHandle"
+  if mojom.IsAssociatedInterfaceKind(kind):
+    return "mojo::internal::AssociatedInterface_Data"
+  if mojom.IsAssociatedInterfaceRequestKind(kind):
+    return "mojo::internal::AssociatedInterfaceRequest_Data"
   if mojom.IsEnumKind(kind):
     return GetNameForKind(kind)
   if mojom.IsStringKind(kind):
@@ -377,6 +409,78 @@ def GetMapValidateParamsCtorArgs(value_kind):
   return "0, %s, %s" % ("true" if element_is_nullable else "false",
                         GetNewArrayValidateParams(value_kind))
 
+def ContainsAssociatedKinds(kind):
+  if mojom.IsAssociatedKind(kind):
+    return True
+  if mojom.IsArrayKind(kind):
+    return ContainsAssociatedKinds(kind.kind)
+  if mojom.IsMapKind(kind):
+    return ContainsAssociatedKinds(kind.value_kind)
+  return False
+
+def CheckAssociatedKinds(module):
+  # An associated interface (request) is attached to the message pipe of the
+  # message that carries it, so the bindings only support passing one as a
+  # top-level request parameter of a method.
+  def Check(kind, where, allow_top_level=False):
+    if allow_top_level and mojom.IsAssociatedKind(kind):
+      return
+    if ContainsAssociatedKinds(kind):
+      raise Exception("Associated interfaces can only be passed as method "
+                      "request parameters (found in %s)." % where)
+
+  for struct in module.structs:
+    for field in struct.fields:
+      Check(field.kind, "struct %s" % struct.name)
+  for union in module.unions:
+    for field in union.fields:
+      Check(field.kind, "union %s" % union.name)
+  for interface in module.interfaces:
+    for method in interface.methods:
+      for param in method.parameters:
+        Check(param.kind, "%s.%s" % (interface.name, method.name),
+              allow_top_level=True)
+      for param in method.response_parameters or []:
+        Check(param.kind, "%s.%s response" % (interface.name, method.name))
+
+def GetSpillThreshold(field):
+  if not field.attributes:
+    return None
+  return field.attributes.get(_SPILL_THRESHOLD_ATTRIBUTE)
+
+def IsSpillableBytesField(field):
+  return GetSpillThreshold(field) is not None
+
+def CheckSpillableBytesFields(module):
+  # Only variable-size byte arrays in structs (including method parameters) can
+  # be spilled into a shared buffer.
+  def Check(field, where):
+    threshold = GetSpillThreshold(field)
+    if threshold is None:
+      return
+    if (not mojom.IsArrayKind(field.kind) or field.kind.kind != mojom.UINT8 or
+        field.kind.length is not None):
+      raise Exception("%s can only be used on array<uint8> (found on %s in %s)."
+                      % (_SPILL_THRESHOLD_ATTRIBUTE, field.name, where))
+    if not isinstance(threshold, int) or threshold < 0:
+      raise Exception("%s must be a non-negative integer (found on %s in %s)."
+                      % (_SPILL_THRESHOLD_ATTRIBUTE, field.name, where))
+
+  for struct in module.structs:
+    for field in struct.fields:
+      Check(field, "struct %s" % struct.name)
+  for union in module.unions:
+    for field in union.fields:
+      if IsSpillableBytesField(field):
+        raise Exception("%s can't be used in unions (found on %s in union %s)."
+                        % (_SPILL_THRESHOLD_ATTRIBUTE, field.name, union.name))
+  for interface in module.interfaces:
+    for method in interface.methods:
+      for param in method.parameters:
+        Check(param, "%s.%s" % (interface.name, method.name))
+      for param in method.response_parameters or []:
+        Check(param, "%s.%s response" % (interface.name, method.name))
+
 class Generator(generator.Generator):
 
   cpp_filters = {
@@ -398,7 +502,12 @@ class Generator(generator.Generator):
     "has_callbacks": mojom.HasCallbacks,
     "should_inline": ShouldInlineStruct,
     "should_inline_union": ShouldInlineUnion,
+    "spill_threshold": GetSpillThreshold,
     "is_array_kind": mojom.IsArrayKind,
+    "is_associated_interface_kind": mojom.IsAssociatedInterfaceKind,
+    "is_associated_interface_request_kind":
+        mojom.IsAssociatedInterfaceRequestKind,
+    "is_associated_kind": mojom.IsAssociatedKind,
     "is_cloneable_kind": mojom.IsCloneableKind,
     "is_enum_kind": mojom.IsEnumKind,
     "is_integral_kind": mojom.IsIntegralKind,
@@ -409,6 +518,7 @@ class Generator(generator.Generator):
     "is_map_kind": mojom.IsMapKind,
     "is_nullable_kind": mojom.IsNullableKind,
     "is_object_kind": mojom.IsObjectKind,
+    "is_spillable_bytes_field": IsSpillableBytesField,
     "is_string_kind": mojom.IsStringKind,
     "is_struct_kind": mojom.IsStructKind,
     "is_union_kind": mojom.IsUnionKind,
@@ -419,6 +529,8 @@ class Generator(generator.Generator):
   }
 
   def GetJinjaExports(self):
+    CheckAssociatedKinds(self.module)
+    CheckSpillableBytesFields(self.module)
     return {
       "module": self.module,
       "namespace": self.module.namespace,
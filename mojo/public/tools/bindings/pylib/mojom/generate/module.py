@@ -322,6 +322,35 @@ class InterfaceRequest(ReferenceKind):
     self.kind = kind
 
 
+class AssociatedInterface(ReferenceKind):
+  ReferenceKind.AddSharedProperty('kind')
+
+  def __init__(self, kind=None):
+    if kind is not None:
+      if not isinstance(kind, Interface):
+        raise Exception(
+            "Associated interface requires %r to be an interface." % kind.spec)
+      ReferenceKind.__init__(self, 'asso:' + kind.spec)
+    else:
+      ReferenceKind.__init__(self)
+    self.kind = kind
+
+
+class AssociatedInterfaceRequest(ReferenceKind):
+  ReferenceKind.AddSharedProperty('kind')
+
+  def __init__(self, kind=None):
+    if kind is not None:
+      if not isinstance(kind, InterfaceRequest):
+        raise Exception(
+            "Associated interface request requires %r to be an interface "
+            "request." % kind.spec)
+      ReferenceKind.__init__(self, 'asso:' + kind.spec)
+    else:
+      ReferenceKind.__init__(self)
+    self.kind = kind
+
+
 class Parameter(object):
   def __init__(self, name=None, kind=None, ordinal=None, default=None,
                attributes=None):
@@ -526,6 +555,19 @@ def IsInterfaceRequestKind(kind):
   return isinstance(kind, InterfaceRequest)
 
 
+def IsAssociatedInterfaceKind(kind):
+  return isinstance(kind, AssociatedInterface)
+
+
+def IsAssociatedInterfaceRequestKind(kind):
+  return isinstance(kind, AssociatedInterfaceRequest)
+
+
+def IsAssociatedKind(kind):
+  return (IsAssociatedInterfaceKind(kind) or
+          IsAssociatedInterfaceRequestKind(kind))
+
+
 def IsEnumKind(kind):
   return isinstance(kind, Enum)
 
@@ -564,7 +606,7 @@ def IsAnyHandleKind(kind):
 
 def IsMoveOnlyKind(kind):
   return (not IsStringKind(kind) and IsObjectKind(kind)) or \
-      IsAnyHandleKind(kind) or IsInterfaceKind(kind)
+      IsAnyHandleKind(kind) or IsInterfaceKind(kind) or IsAssociatedKind(kind)
 
 
 def IsCloneableKind(kind):
@@ -573,7 +615,8 @@ def IsCloneableKind(kind):
       # No need to examine the kind again.
       return False
     visited_kinds.add(kind)
-    if IsAnyHandleKind(kind) or IsInterfaceKind(kind):
+    if (IsAnyHandleKind(kind) or IsInterfaceKind(kind) or
+        IsAssociatedKind(kind)):
       return True
     if IsArrayKind(kind):
       return ContainsHandles(kind.kind, visited_kinds)
@@ -263,7 +263,8 @@ class Parser(object):
                             | array
                             | fixed_array
                             | associative_array
-                            | interfacerequest"""
+                            | interfacerequest
+                            | associated"""
     p[0] = p[1]
 
   def p_basictypename(self, p):
@@ -309,6 +310,11 @@ class Parser(object):
     """interfacerequest : identifier AMP"""
     p[0] = p[1] + "&"
 
+  def p_associated(self, p):
+    """associated : ASSOCIATED identifier
+                  | ASSOCIATED interfacerequest"""
+    p[0] = "asso<" + p[2] + ">"
+
   def p_ordinal_1(self, p):
     """ordinal : """
     p[0] = None
@@ -58,6 +58,9 @@ def _MapKind(kind):
       raise Exception(
           'A type (spec "%s") cannot be made nullable' % base_kind)
     return '?' + base_kind
+  if kind.startswith('asso<'):
+    assert kind.endswith('>')
+    return 'asso:' + _MapKind(kind[5:-1])
   if kind.endswith('}'):
     lbracket = kind.rfind('{')
     value = kind[0:lbracket]
@@ -127,6 +127,34 @@ class DataTest(unittest.TestCase):
     self.assertNotIn(map_kind.spec, module.kinds)
     self.assertNotIn(interface_req.spec, module.kinds)
 
+  def testAssociatedKindsFromData(self):
+    """Tests that associated kinds are built from their specs."""
+    module = mojom.Module('test_module', 'test_namespace')
+    interface = mojom.Interface('TestInterface', module=module)
+    module.kinds[interface.spec] = interface
+
+    kind = data.KindFromData(module.kinds, 'asso:' + interface.spec, ())
+    self.assertIsInstance(kind, mojom.AssociatedInterface)
+    self.assertIs(interface, kind.kind)
+
+    kind = data.KindFromData(module.kinds, 'asso:r:' + interface.spec, ())
+    self.assertIsInstance(kind, mojom.AssociatedInterfaceRequest)
+    self.assertIs(interface, kind.kind.kind)
+
+  def testNonInterfaceAsAssociatedInterface(self):
+    """Tests that a non-interface cannot be associated."""
+    module = mojom.Module('test_module', 'test_namespace')
+    interface = mojom.Interface('TestInterface', module=module)
+    method_dict = {
+        'name': 'Foo',
+        'parameters': [{'name': 'foo', 'kind': 'asso:i32'}],
+    }
+    with self.assertRaises(Exception) as e:
+      data.MethodFromData(module, method_dict, interface)
+    self.assertEquals(e.exception.__str__(),
+                      'Associated interface requires \'i32\' to be an '
+                      'interface.')
+
   def testNonInterfaceAsInterfaceRequest(self):
     """Tests that a non-interface cannot be used for interface requests."""
     module = mojom.Module('test_module', 'test_namespace')
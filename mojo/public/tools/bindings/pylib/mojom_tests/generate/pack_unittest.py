@@ -124,3 +124,16 @@ class PackTest(unittest.TestCase):
     fields = (1, 2)
     offsets = (0, 4)
     self._CheckPackSequence(kinds, fields, offsets)
+
+  def testAssociatedKinds(self):
+    """Tests that associated interfaces are packed like interfaces, and that
+    associated interface requests take 4 bytes, like handles.
+    """
+    interface = mojom.Interface('test_interface')
+    kinds = (mojom.INT32,
+             mojom.AssociatedInterface(interface),
+             mojom.AssociatedInterfaceRequest(mojom.InterfaceRequest(interface)),
+             mojom.INT32)
+    fields = (1, 2, 3, 4)
+    offsets = (0, 4, 12, 16)
+    self._CheckPackSequence(kinds, fields, offsets)
@@ -849,6 +849,60 @@ class ParserTest(unittest.TestCase):
                                                      'bool')]))))])
     self.assertEquals(parser.Parse(source3, "my_file.mojom"), expected3)
 
+  def testValidAssociatedKinds(self):
+    """Tests parsing associated interfaces and requests."""
+
+    source = """\
+        interface MyInterface {
+          MyMethod(associated MyOtherInterface a,
+                   associated MyOtherInterface& b);
+        };
+        """
+    expected = ast.Mojom(
+        None,
+        ast.ImportList(),
+        [ast.Interface(
+            'MyInterface',
+            None,
+            ast.InterfaceBody(
+                ast.Method(
+                    'MyMethod',
+                    None,
+                    None,
+                    ast.ParameterList([
+                        ast.Parameter('a', None, None,
+                                      'asso<MyOtherInterface>'),
+                        ast.Parameter('b', None, None,
+                                      'asso<MyOtherInterface&>')]),
+                    None)))])
+    self.assertEquals(parser.Parse(source, "my_file.mojom"), expected)
+
+  def testInvalidAssociatedKinds(self):
+    """Tests that invalid associated kinds are correctly detected."""
+
+    # Only interfaces and interface requests can be associated.
+    source1 = """\
+        interface MyInterface {
+          MyMethod(associated int32[] a);
+        };
+        """
+    with self.assertRaisesRegexp(
+        parser.ParseError,
+        r"^my_file\.mojom:2: Error: Unexpected '\[':\n"
+            r" *MyMethod\(associated int32\[\] a\);$"):
+      parser.Parse(source1, "my_file.mojom")
+
+    source2 = """\
+        interface MyInterface {
+          MyMethod(associated associated MyOtherInterface a);
+        };
+        """
+    with self.assertRaisesRegexp(
+        parser.ParseError,
+        r"^my_file\.mojom:2: Error: Unexpected 'associated':\n"
+            r" *MyMethod\(associated associated MyOtherInterface a\);$"):
+      parser.Parse(source2, "my_file.mojom")
+
   def testInvalidMethods(self):
     """Tests that invalid method declarations are correctly detected."""
 
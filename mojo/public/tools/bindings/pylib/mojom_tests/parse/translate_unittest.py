@@ -44,6 +44,14 @@ class TranslateTest(unittest.TestCase):
     # pylint: disable=W0212
     self.assertEquals(translate._MapKind("uint8[]{string}"), "m[s][a:u8]")
 
+  def testAssociatedKinds(self):
+    """Tests associated interfaces and interface requests."""
+    # pylint: disable=W0212
+    self.assertEquals(translate._MapKind("asso<SomeInterface>"),
+                      "asso:x:SomeInterface")
+    self.assertEquals(translate._MapKind("asso<SomeInterface&>"),
+                      "asso:r:x:SomeInterface")
+
   def testTranslateSimpleUnions(self):
     """Makes sure that a simple union is translated correctly."""
     tree = ast.Mojom(
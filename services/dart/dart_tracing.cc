@@ -24,7 +24,7 @@ void DartTimelineController::Disable() {
 }
 
 DartTraceProvider::DartTraceProvider()
-    : binding_(this) {
+    : binding_(this), flight_recording_(false) {
 }
 
 DartTraceProvider::~DartTraceProvider() {
@@ -44,6 +44,7 @@ void DartTraceProvider::StartTracing(const mojo::String& categories,
                                      tracing::TraceRecorderPtr recorder) {
   DCHECK(!recorder_.get());
   recorder_ = recorder.Pass();
+  flight_recording_ = false;
   DartTimelineController::Enable(categories);
 }
 
@@ -67,13 +68,15 @@ static void AppendStreamConsumer(Dart_StreamConsumer_State state,
   data->insert(data->end(), buffer, buffer + buffer_length);
 }
 
-// recorder_->Record():
+// TraceRecorder::Record():
 // 1. Doesn't like big hunks of data.
 //    See: https://github.com/domokit/mojo/issues/564
 // 2. Expects to receive one or more complete JSON maps per call.
 // Therefore, we do a little parsing of data to split it up and send it
 // over to the trace recorder.
-void DartTraceProvider::SplitAndRecord(char* data, size_t length) {
+void DartTraceProvider::SplitAndRecord(char* data,
+                                       size_t length,
+                                       tracing::TraceRecorder* recorder) {
   const size_t kInvalidIndex = length;
   const size_t kMinChunkLength = 1024 * 1024;  // 1MB.
   size_t start = kInvalidIndex;
@@ -98,7 +101,7 @@ void DartTraceProvider::SplitAndRecord(char* data, size_t length) {
       char* json_start = data + start;
       char* json_end = data + end + 1;
       mojo::String json(json_start, json_end - json_start);
-      recorder_->Record(json);
+      recorder->Record(json);
       start = kInvalidIndex;
     }
   }
@@ -106,14 +109,41 @@ void DartTraceProvider::SplitAndRecord(char* data, size_t length) {
 
 // tracing::TraceProvider implementation:
 void DartTraceProvider::StopTracing() {
-  DCHECK(recorder_);
+  if (!recorder_) {
+    if (flight_recording_) {
+      flight_recording_ = false;
+      DartTimelineController::Disable();
+    }
+    return;
+  }
   DartTimelineController::Disable();
+  RecordTimeline(recorder_.get());
+  recorder_.reset();
+}
+
+// The timeline of the VM is recorded in a ring buffer, so flight recording
+// only needs enabling it.
+void DartTraceProvider::StartFlightRecorder(const mojo::String& categories) {
+  if (recorder_)
+    return;
+  flight_recording_ = true;
+  DartTimelineController::Enable(categories);
+}
+
+// The timeline can't be filtered by time, so |seconds| isn't respected: all
+// the events in its ring buffer are sent.
+void DartTraceProvider::Snapshot(uint32_t seconds,
+                                 tracing::TraceRecorderPtr recorder) {
+  if (flight_recording_)
+    RecordTimeline(recorder.get());
+}
+
+void DartTraceProvider::RecordTimeline(tracing::TraceRecorder* recorder) {
   std::vector<uint8_t> data;
   bool got_trace = Dart_GlobalTimelineGetTrace(AppendStreamConsumer, &data);
   if (got_trace) {
-    SplitAndRecord(reinterpret_cast<char*>(data.data()), data.size());
+    SplitAndRecord(reinterpret_cast<char*>(data.data()), data.size(), recorder);
   }
-  recorder_.reset();
 }
 
 DartTracingImpl::DartTracingImpl() {
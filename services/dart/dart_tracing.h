@@ -31,11 +31,18 @@ class DartTraceProvider : public tracing::TraceProvider {
   void StartTracing(const mojo::String& categories,
                     tracing::TraceRecorderPtr recorder) override;
   void StopTracing() override;
+  void StartFlightRecorder(const mojo::String& categories) override;
+  void Snapshot(uint32_t seconds, tracing::TraceRecorderPtr recorder) override;
 
-  void SplitAndRecord(char* data, size_t length);
+  // Sends the events recorded by the timeline via |recorder|.
+  void RecordTimeline(tracing::TraceRecorder* recorder);
+  void SplitAndRecord(char* data,
+                      size_t length,
+                      tracing::TraceRecorder* recorder);
 
   mojo::Binding<tracing::TraceProvider> binding_;
   tracing::TraceRecorderPtr recorder_;
+  bool flight_recording_;
 
   DISALLOW_COPY_AND_ASSIGN(DartTraceProvider);
 };
@@ -32,7 +32,11 @@ namespace debugger {
 class Debugger : public mojo::ApplicationDelegate,
                     public http_server::HttpHandler {
  public:
-  Debugger() : is_tracing_(false), app_(nullptr), handler_binding_(this) {}
+  Debugger()
+      : is_tracing_(false),
+        is_flight_recording_(false),
+        app_(nullptr),
+        handler_binding_(this) {}
   ~Debugger() override {}
 
  private:
@@ -99,6 +103,12 @@ class Debugger : public mojo::ApplicationDelegate,
       StartTracing(callback);
     } else if (request->relative_url == "/stop_tracing") {
       StopTracing(callback);
+    } else if (request->relative_url == "/start_flight_recorder") {
+      StartFlightRecorder(callback);
+    } else if (request->relative_url == "/snapshot_trace") {
+      std::string seconds;
+      mojo::common::BlockingCopyToString(request->body.Pass(), &seconds);
+      SnapshotTrace(callback, seconds);
     } else {
       Help(callback, request->relative_url);
     }
@@ -157,6 +167,8 @@ class Debugger : public mojo::ApplicationDelegate,
     if (!tracing_)
       app_->ConnectToService("mojo:tracing", &tracing_);
     is_tracing_ = true;
+    // What has been flight recorded so far becomes part of the trace.
+    is_flight_recording_ = false;
     mojo::DataPipe pipe;
     tracing_->Start(pipe.producer_handle.Pass(), mojo::String("*"));
     trace_collector_.reset(new TraceCollector(pipe.consumer_handle.Pass()));
@@ -180,6 +192,52 @@ class Debugger : public mojo::ApplicationDelegate,
     Respond(callback, trace);
   }
 
+  void StartFlightRecorder(const HandleRequestCallback& callback) {
+    if (is_tracing_) {
+      Error(callback, "Already tracing. Use stop_tracing to stop.\n");
+      return;
+    }
+
+    if (!tracing_)
+      app_->ConnectToService("mojo:tracing", &tracing_);
+    is_flight_recording_ = true;
+    tracing_->StartFlightRecorder(mojo::String("*"));
+    Respond(callback,
+            "Flight recording (type 'snapshot_trace' to get the recent "
+            "events)\n");
+  }
+
+  // Gets the events flight recorded in the last |seconds_str| seconds (all of
+  // them if empty).
+  void SnapshotTrace(const HandleRequestCallback& callback,
+                     const std::string& seconds_str) {
+    if (!is_flight_recording_) {
+      Error(callback,
+            "Not flight recording. Use start_flight_recorder to start.\n");
+      return;
+    }
+    if (snapshot_collector_) {
+      Error(callback, "Already taking a snapshot.\n");
+      return;
+    }
+    unsigned seconds = 0;
+    if (!seconds_str.empty() && !base::StringToUint(seconds_str, &seconds)) {
+      Error(callback, "Invalid number of seconds: " + seconds_str + "\n");
+      return;
+    }
+
+    mojo::DataPipe pipe;
+    tracing_->Snapshot(pipe.producer_handle.Pass(), seconds);
+    snapshot_collector_.reset(new TraceCollector(pipe.consumer_handle.Pass()));
+    snapshot_collector_->GetTrace(base::Bind(&Debugger::OnSnapshotAvailable,
+                                             base::Unretained(this), callback));
+  }
+
+  void OnSnapshotAvailable(HandleRequestCallback callback, std::string trace) {
+    snapshot_collector_.reset();
+    Respond(callback, trace);
+  }
+
   void StartProfiling(const HandleRequestCallback& callback) {
 #if !defined(NDEBUG) || !defined(ENABLE_PROFILING)
     Error(callback,
@@ -201,6 +259,7 @@ class Debugger : public mojo::ApplicationDelegate,
   }
 
   bool is_tracing_;
+  bool is_flight_recording_;
   mojo::ApplicationImpl* app_;
   mojo::WindowManagerPtr window_manager_;
   tracing::TraceCollectorPtr tracing_;
@@ -211,6 +270,7 @@ class Debugger : public mojo::ApplicationDelegate,
   mojo::Binding<http_server::HttpHandler> handler_binding_;
 
   scoped_ptr<TraceCollector> trace_collector_;
+  scoped_ptr<TraceCollector> snapshot_collector_;
 
   DISALLOW_COPY_AND_ASSIGN(Debugger);
 };
@@ -11,6 +11,7 @@
 #include "gin/try_catch.h"
 #include "mojo/data_pipe_utils/data_pipe_utils.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
+#include "mojo/public/cpp/system/buffer.h"
 #include "services/js/js_app_message_loop_observers.h"
 #include "services/js/system/core.h"
 #include "services/js/system/handle.h"
@@ -18,6 +19,31 @@
 
 namespace js {
 
+namespace {
+
+// Gets the body of |response|, preferably by mapping |body_buffer| (e.g., a
+// read-only mapping of the shell's cached copy of the file) rather than reading
+// it out of the |body| data pipe.
+std::string GetSource(mojo::URLResponse* response) {
+  std::string source;
+  if (response->body_buffer.is_valid()) {
+    void* buffer = nullptr;
+    if (mojo::MapBuffer(response->body_buffer.get(),
+                        response->body_buffer_offset,
+                        response->body_buffer_size, &buffer,
+                        MOJO_MAP_BUFFER_FLAG_NONE) == MOJO_RESULT_OK) {
+      source.assign(static_cast<const char*>(buffer),
+                    static_cast<size_t>(response->body_buffer_size));
+      CHECK_EQ(MOJO_RESULT_OK, mojo::UnmapBuffer(buffer));
+      return source;
+    }
+  }
+  CHECK(mojo::common::BlockingCopyToString(response->body.Pass(), &source));
+  return source;
+}
+
+}  // namespace
+
 const char JSApp::kMainModuleName[] = "main";
 
 JSApp::JSApp(mojo::InterfaceRequest<mojo::Application> application_request,
@@ -28,8 +54,7 @@ JSApp::JSApp(mojo::InterfaceRequest<mojo::Application> application_request,
 
   DCHECK(!response.is_null());
   std::string url(response->url);
-  std::string source;
-  CHECK(mojo::common::BlockingCopyToString(response->body.Pass(), &source));
+  std::string source = GetSource(response.get());
 
   shell_runner_.reset(new gin::ShellRunner(&runner_delegate_, isolate));
   gin::Runner::Scope scope(shell_runner_.get());
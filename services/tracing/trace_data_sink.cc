@@ -4,15 +4,32 @@
 
 #include "services/tracing/trace_data_sink.h"
 
-#include "base/logging.h"
-#include "mojo/data_pipe_utils/data_pipe_utils.h"
+#include <algorithm>
+#include <limits>
 
-using mojo::common::BlockingCopyFromString;
+#include "base/bind.h"
+#include "base/logging.h"
 
 namespace tracing {
 
+namespace {
+
+uint32_t ClampToUint32(size_t num_bytes) {
+  return static_cast<uint32_t>(std::min<size_t>(
+      num_bytes, std::numeric_limits<uint32_t>::max()));
+}
+
+}  // namespace
+
+const size_t TraceDataSink::kMaxBufferedBytes;
+
 TraceDataSink::TraceDataSink(mojo::ScopedDataPipeProducerHandle pipe)
-    : pipe_(pipe.Pass()), empty_(true) {
+    : pipe_(pipe.Pass()),
+      empty_(true),
+      first_chunk_offset_(0),
+      buffered_bytes_(0),
+      waiting_(false),
+      weak_factory_(this) {
 }
 
 TraceDataSink::~TraceDataSink() {
@@ -23,9 +40,106 @@ TraceDataSink::~TraceDataSink() {
 
 void TraceDataSink::AddChunk(const std::string& json) {
   if (!empty_)
-    BlockingCopyFromString(",", pipe_);
+    Write(",", 1);
   empty_ = false;
-  BlockingCopyFromString(json, pipe_);
+  Write(json.data(), json.size());
+}
+
+void TraceDataSink::TryWrite() {
+  while (!chunks_.empty() && pipe_.is_valid()) {
+    const std::string& chunk = chunks_.front();
+    uint32_t num_bytes = ClampToUint32(chunk.size() - first_chunk_offset_);
+    MojoResult result =
+        WriteDataRaw(pipe_.get(), chunk.data() + first_chunk_offset_,
+                     &num_bytes, MOJO_WRITE_DATA_FLAG_NONE);
+    if (result != MOJO_RESULT_OK) {
+      CheckWriteResult(result);
+      break;
+    }
+    first_chunk_offset_ += num_bytes;
+    buffered_bytes_ -= num_bytes;
+    if (first_chunk_offset_ == chunk.size()) {
+      chunks_.pop_front();
+      first_chunk_offset_ = 0;
+    }
+  }
+  WaitForWritable();
+}
+
+void TraceDataSink::Close(const base::Closure& callback) {
+  DCHECK(close_callback_.is_null());
+  close_callback_ = callback;
+  TryWrite();
+  CloseIfDone();
+}
+
+void TraceDataSink::Write(const char* data, size_t num_bytes) {
+  if (!pipe_.is_valid())
+    return;
+
+  if (chunks_.empty()) {
+    uint32_t num_written = ClampToUint32(num_bytes);
+    MojoResult result = WriteDataRaw(pipe_.get(), data, &num_written,
+                                     MOJO_WRITE_DATA_FLAG_NONE);
+    if (result != MOJO_RESULT_OK) {
+      if (!CheckWriteResult(result))
+        return;
+      num_written = 0;
+    }
+    data += num_written;
+    num_bytes -= num_written;
+    if (!num_bytes)
+      return;
+  }
+
+  chunks_.push_back(std::string(data, num_bytes));
+  buffered_bytes_ += num_bytes;
+  WaitForWritable();
+}
+
+bool TraceDataSink::CheckWriteResult(MojoResult result) {
+  if (result == MOJO_RESULT_SHOULD_WAIT)
+    return true;
+
+  // The consumer is gone, so is the data.
+  LOG_IF(ERROR, result != MOJO_RESULT_FAILED_PRECONDITION)
+      << "Unexpected result writing trace data: " << result;
+  pipe_.reset();
+  chunks_.clear();
+  first_chunk_offset_ = 0;
+  buffered_bytes_ = 0;
+  handle_watcher_.Stop();
+  waiting_ = false;
+  return false;
+}
+
+void TraceDataSink::WaitForWritable() {
+  if (waiting_ || chunks_.empty() || !pipe_.is_valid())
+    return;
+  waiting_ = true;
+  handle_watcher_.Start(
+      pipe_.get(), MOJO_HANDLE_SIGNAL_WRITABLE, MOJO_DEADLINE_INDEFINITE,
+      base::Bind(&TraceDataSink::OnWritable, weak_factory_.GetWeakPtr()));
+}
+
+void TraceDataSink::OnWritable(MojoResult result) {
+  waiting_ = false;
+  if (result == MOJO_RESULT_OK)
+    TryWrite();
+  else
+    CheckWriteResult(result);
+  CloseIfDone();
+}
+
+void TraceDataSink::CloseIfDone() {
+  if (close_callback_.is_null() || !chunks_.empty())
+    return;
+  pipe_.reset();
+  handle_watcher_.Stop();
+  waiting_ = false;
+  base::Closure callback = close_callback_;
+  close_callback_.Reset();
+  callback.Run();
 }
 
 }  // namespace tracing
@@ -5,24 +5,80 @@
 #ifndef SERVICES_TRACING_TRACE_DATA_SINK_H_
 #define SERVICES_TRACING_TRACE_DATA_SINK_H_
 
+#include <deque>
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "mojo/message_pump/handle_watcher.h"
 #include "mojo/public/cpp/system/data_pipe.h"
 
 namespace tracing {
 
+// Writes the trace data collected from all the traced applications to a data
+// pipe, as a comma-separated list of JSON trace events. Never blocks: what the
+// pipe doesn't take right away is queued, and written when the pipe becomes
+// writable again.
 class TraceDataSink {
  public:
+  // How much data may be queued before IsFull().
+  static const size_t kMaxBufferedBytes = 8 * 1024 * 1024;
+
   explicit TraceDataSink(mojo::ScopedDataPipeProducerHandle pipe);
   ~TraceDataSink();
 
+  // Writes |json| (trace events, in the JSON trace format). This queues it
+  // even if IsFull(): to keep memory use bounded, callers should stop feeding
+  // the sink until it isn't.
   void AddChunk(const std::string& json);
 
+  // Whether the consumer is too far behind.
+  bool IsFull() const { return buffered_bytes_ >= kMaxBufferedBytes; }
+
+  size_t buffered_bytes() const { return buffered_bytes_; }
+
+  // Writes as much queued data as the pipe takes right away. This is done
+  // automatically when the pipe becomes writable, if the message loop runs.
+  void TryWrite();
+
+  // The pipe, which callers that don't let the message loop run may wait on
+  // (to become writable) while buffered_bytes() isn't 0.
+  mojo::Handle handle() const { return pipe_.get(); }
+
+  // Closes the pipe once all the queued data has been written (or the
+  // consumer has gone away), and then runs |callback|, which may delete the
+  // sink.
+  void Close(const base::Closure& callback);
+
  private:
+  // Writes as much of |data| as the pipe takes if nothing is queued, and
+  // queues the rest.
+  void Write(const char* data, size_t num_bytes);
+
+  // Handles a failure to write, returning false if the pipe is gone.
+  bool CheckWriteResult(MojoResult result);
+
+  void WaitForWritable();
+  void OnWritable(MojoResult result);
+
+  void CloseIfDone();
+
   mojo::ScopedDataPipeProducerHandle pipe_;
   bool empty_;
 
+  // Data not written yet. The first chunk has been written up to
+  // |first_chunk_offset_|, which isn't counted in |buffered_bytes_|.
+  std::deque<std::string> chunks_;
+  size_t first_chunk_offset_;
+  size_t buffered_bytes_;
+
+  mojo::common::HandleWatcher handle_watcher_;
+  bool waiting_;
+  base::Closure close_callback_;
+
+  base::WeakPtrFactory<TraceDataSink> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(TraceDataSink);
 };
 
@@ -0,0 +1,167 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/tracing/trace_data_sink.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "mojo/data_pipe_utils/data_pipe_drainer.h"
+#include "mojo/message_pump/message_pump_mojo.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tracing {
+namespace {
+
+const uint32_t kPipeCapacity = 1024 * 1024;
+
+MojoCreateDataPipeOptions PipeOptions() {
+  MojoCreateDataPipeOptions options = {sizeof(MojoCreateDataPipeOptions),
+                                       MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,
+                                       1, kPipeCapacity};
+  return options;
+}
+
+// Reads at most |max_num_bytes| from |consumer|, counting the bytes and the
+// commas read.
+void ReadSome(mojo::DataPipeConsumerHandle consumer,
+              uint32_t max_num_bytes,
+              size_t* num_bytes_read,
+              size_t* num_commas_read) {
+  const void* buffer = nullptr;
+  uint32_t num_bytes = 0;
+  MojoResult result = mojo::BeginReadDataRaw(consumer, &buffer, &num_bytes,
+                                             MOJO_READ_DATA_FLAG_NONE);
+  if (result == MOJO_RESULT_SHOULD_WAIT)
+    return;
+  ASSERT_EQ(MOJO_RESULT_OK, result);
+  num_bytes = std::min(num_bytes, max_num_bytes);
+  const char* chars = static_cast<const char*>(buffer);
+  *num_commas_read += std::count(chars, chars + num_bytes, ',');
+  *num_bytes_read += num_bytes;
+  ASSERT_EQ(MOJO_RESULT_OK, mojo::EndReadDataRaw(consumer, num_bytes));
+}
+
+class Drainer : public mojo::common::DataPipeDrainer::Client {
+ public:
+  explicit Drainer(mojo::ScopedDataPipeConsumerHandle consumer)
+      : num_bytes_read_(0), drainer_(this, consumer.Pass()) {}
+
+  size_t num_bytes_read() const { return num_bytes_read_; }
+
+ private:
+  // mojo::common::DataPipeDrainer::Client implementation.
+  void OnDataAvailable(const void* data, size_t num_bytes) override {
+    num_bytes_read_ += num_bytes;
+  }
+  void OnDataComplete() override { base::MessageLoop::current()->Quit(); }
+
+  size_t num_bytes_read_;
+  mojo::common::DataPipeDrainer drainer_;
+
+  DISALLOW_COPY_AND_ASSIGN(Drainer);
+};
+
+void SetTrue(bool* value) {
+  *value = true;
+}
+
+class TraceDataSinkTest : public testing::Test {
+ public:
+  TraceDataSinkTest()
+      : message_loop_(mojo::common::MessagePumpMojo::Create()) {}
+
+ private:
+  base::MessageLoop message_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceDataSinkTest);
+};
+
+// Streams a 1 GB trace to a consumer that reads less at a time than the
+// collector produces, feeding the sink only while it isn't full (as
+// TracingApp::StopAndFlush() does), and checks that the data in memory stays
+// bounded.
+TEST_F(TraceDataSinkTest, BoundedMemoryWithSlowConsumer) {
+  const size_t kChunkSize = 1024 * 1024;
+  const size_t kNumChunks = 1024;
+  const uint32_t kReadSize = 256 * 1024;
+  const std::string chunk(kChunkSize, 'x');
+
+  mojo::DataPipe pipe(PipeOptions());
+  TraceDataSink sink(pipe.producer_handle.Pass());
+  size_t num_chunks_added = 0;
+  size_t max_buffered_bytes = 0;
+  size_t num_bytes_read = 0;
+  size_t num_commas_read = 0;
+  while (num_chunks_added < kNumChunks || sink.buffered_bytes()) {
+    while (num_chunks_added < kNumChunks && !sink.IsFull()) {
+      sink.AddChunk(chunk);
+      num_chunks_added++;
+      max_buffered_bytes = std::max(max_buffered_bytes, sink.buffered_bytes());
+    }
+    ReadSome(pipe.consumer_handle.get(), kReadSize, &num_bytes_read,
+             &num_commas_read);
+    sink.TryWrite();
+  }
+  while (num_bytes_read < kNumChunks * kChunkSize + kNumChunks - 1) {
+    size_t previous_num_bytes_read = num_bytes_read;
+    ReadSome(pipe.consumer_handle.get(), kReadSize, &num_bytes_read,
+             &num_commas_read);
+    ASSERT_LT(previous_num_bytes_read, num_bytes_read);
+  }
+
+  EXPECT_EQ(kNumChunks * kChunkSize + kNumChunks - 1, num_bytes_read);
+  EXPECT_EQ(kNumChunks - 1, num_commas_read);
+  // The sink may go over its limit by at most the chunk that fills it.
+  EXPECT_LE(max_buffered_bytes,
+            TraceDataSink::kMaxBufferedBytes + kChunkSize + 1);
+  // And the consumer was slow enough for it to fill up.
+  EXPECT_LE(TraceDataSink::kMaxBufferedBytes, max_buffered_bytes);
+}
+
+// Checks that closing the sink waits for the consumer to read what it
+// hasn't read yet.
+TEST_F(TraceDataSinkTest, CloseWritesQueuedData) {
+  const std::string chunk(3 * kPipeCapacity, 'x');
+  mojo::DataPipe pipe(PipeOptions());
+  TraceDataSink sink(pipe.producer_handle.Pass());
+  sink.AddChunk(chunk);
+  sink.AddChunk(chunk);
+  EXPECT_LT(0u, sink.buffered_bytes());
+
+  bool closed = false;
+  sink.Close(base::Bind(&SetTrue, base::Unretained(&closed)));
+  EXPECT_FALSE(closed);
+
+  Drainer drainer(pipe.consumer_handle.Pass());
+  base::RunLoop().Run();
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(2 * chunk.size() + 1, drainer.num_bytes_read());
+}
+
+TEST_F(TraceDataSinkTest, ConsumerGoesAway) {
+  const std::string chunk(3 * kPipeCapacity, 'x');
+  mojo::DataPipe pipe(PipeOptions());
+  TraceDataSink sink(pipe.producer_handle.Pass());
+  sink.AddChunk(chunk);
+  EXPECT_LT(0u, sink.buffered_bytes());
+
+  pipe.consumer_handle.reset();
+  sink.TryWrite();
+  EXPECT_EQ(0u, sink.buffered_bytes());
+  EXPECT_FALSE(sink.handle().is_valid());
+  // Chunks added later are dropped right away.
+  sink.AddChunk(chunk);
+  EXPECT_EQ(0u, sink.buffered_bytes());
+
+  bool closed = false;
+  sink.Close(base::Bind(&SetTrue, base::Unretained(&closed)));
+  EXPECT_TRUE(closed);
+}
+
+}  // namespace
+}  // namespace tracing
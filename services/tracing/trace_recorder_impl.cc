@@ -4,6 +4,9 @@
 
 #include "services/tracing/trace_recorder_impl.h"
 
+#include "base/logging.h"
+#include "base/trace_event/trace_event_binary.h"
+
 namespace tracing {
 
 TraceRecorderImpl::TraceRecorderImpl(
@@ -27,4 +30,16 @@ void TraceRecorderImpl::Record(const mojo::String& json) {
   sink_->AddChunk(json.To<std::string>());
 }
 
+void TraceRecorderImpl::RecordBinary(mojo::Array<uint8_t> events) {
+  std::string json;
+  if (!base::trace_event::AppendBinaryTraceEventsAsJSON(
+          reinterpret_cast<const char*>(events.data()), events.size(),
+          &json)) {
+    LOG(ERROR) << "Dropping malformed binary trace events";
+    return;
+  }
+  if (!json.empty())
+    sink_->AddChunk(json);
+}
+
 }  // namespace tracing
@@ -6,6 +6,7 @@
 #define SERVICES_TRACING_TRACE_RECORDER_IMPL_H_
 
 #include "base/macros.h"
+#include "mojo/public/cpp/bindings/array.h"
 #include "mojo/public/cpp/bindings/binding.h"
 #include "mojo/public/cpp/bindings/string.h"
 #include "mojo/services/tracing/interfaces/tracing.mojom.h"
@@ -31,6 +32,7 @@ class TraceRecorderImpl : public TraceRecorder {
  private:
   // tracing::TraceRecorder implementation.
   void Record(const mojo::String& json) override;
+  void RecordBinary(mojo::Array<uint8_t> events) override;
 
   TraceDataSink* sink_;
   mojo::Binding<TraceRecorder> binding_;
@@ -4,13 +4,18 @@
 
 #include "services/tracing/tracing_app.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/logging.h"
 #include "base/message_loop/message_loop.h"
 
 namespace tracing {
 
-TracingApp::TracingApp() : collector_binding_(this), tracing_active_(false) {
+TracingApp::TracingApp()
+    : collector_binding_(this),
+      tracing_active_(false),
+      flight_recording_(false) {
 }
 
 TracingApp::~TracingApp() {
@@ -32,6 +37,8 @@ bool TracingApp::ConfigureIncomingConnection(
     recorder_impls_.push_back(
         new TraceRecorderImpl(GetProxy(&recorder_ptr), sink_.get()));
     provider_ptr->StartTracing(tracing_categories_, recorder_ptr.Pass());
+  } else if (flight_recording_) {
+    provider_ptr->StartFlightRecorder(tracing_categories_);
   }
   provider_ptrs_.AddInterfacePtr(provider_ptr.Pass());
   return true;
@@ -47,6 +54,8 @@ void TracingApp::Create(mojo::ApplicationConnection* connection,
 void TracingApp::Start(mojo::ScopedDataPipeProducerHandle stream,
                        const mojo::String& categories) {
   tracing_categories_ = categories;
+  // Providers that are flight recording keep what they have recorded so far.
+  flight_recording_ = false;
   sink_.reset(new TraceDataSink(stream.Pass()));
   provider_ptrs_.ForAllPtrs([categories, this](TraceProvider* controller) {
     TraceRecorderPtr ptr;
@@ -67,21 +76,60 @@ void TracingApp::StopAndFlush() {
   }
 
   tracing_active_ = false;
+  flight_recording_ = false;
   provider_ptrs_.ForAllPtrs(
       [](TraceProvider* controller) { controller->StopTracing(); });
 
-  // Sending the StopTracing message to registered controllers will request that
-  // they send trace data back via the collector interface and, when they are
-  // done, close the collector pipe. We don't know how long they will take. We
-  // want to read all data that any collector might send until all collectors or
-  // closed or an (arbitrary) deadline has passed. Since the bindings don't
-  // support this directly we do our own MojoWaitMany over the handles and read
-  // individual messages until all are closed or our absolute deadline has
-  // elapsed.
+  CollectTraceData(&recorder_impls_, sink_.get());
+  AllDataCollected();
+}
+
+void TracingApp::StartFlightRecorder(const mojo::String& categories) {
+  if (tracing_active_) {
+    LOG(WARNING) << "Not flight recording: already tracing.";
+    return;
+  }
+  tracing_categories_ = categories;
+  flight_recording_ = true;
+  provider_ptrs_.ForAllPtrs([categories](TraceProvider* controller) {
+    controller->StartFlightRecorder(categories);
+  });
+}
+
+void TracingApp::Snapshot(mojo::ScopedDataPipeProducerHandle stream,
+                          uint32_t seconds) {
+  // Providers that aren't flight recording close their recorder right away.
+  scoped_ptr<TraceDataSink> sink(new TraceDataSink(stream.Pass()));
+  ScopedVector<TraceRecorderImpl> recorder_impls;
+  provider_ptrs_.ForAllPtrs(
+      [seconds, &sink, &recorder_impls](TraceProvider* controller) {
+        TraceRecorderPtr ptr;
+        recorder_impls.push_back(
+            new TraceRecorderImpl(GetProxy(&ptr), sink.get()));
+        controller->Snapshot(seconds, ptr.Pass());
+      });
+  CollectTraceData(&recorder_impls, sink.get());
+  CloseSink(sink.Pass());
+}
+
+void TracingApp::CollectTraceData(
+    ScopedVector<TraceRecorderImpl>* recorder_impls,
+    TraceDataSink* sink) {
+  // Sending the StopTracing (or Snapshot) message to registered controllers
+  // will request that they send trace data back via the collector interface
+  // and, when they are done, close the collector pipe. We don't know how long
+  // they will take. We want to read all data that any collector might send
+  // until all collectors or closed or an (arbitrary) deadline has passed. Since
+  // the bindings don't support this directly we do our own MojoWaitMany over
+  // the handles and read individual messages until all are closed or our
+  // absolute deadline has elapsed. We also wait for the sink to become
+  // writable while it has data its consumer hasn't taken yet, and stop reading
+  // messages while it is full, so that a slow consumer doesn't make us buffer
+  // the whole trace.
   static const MojoDeadline kTimeToWaitMicros = 5000 * 1000;
   MojoTimeTicks end = MojoGetTimeTicksNow() + kTimeToWaitMicros;
 
-  while (!recorder_impls_.empty()) {
+  while (!recorder_impls->empty()) {
     MojoTimeTicks now = MojoGetTimeTicksNow();
     if (now >= end)  // Timed out?
       break;
@@ -89,11 +137,17 @@ void TracingApp::StopAndFlush() {
     MojoDeadline mojo_deadline = end - now;
     std::vector<mojo::Handle> handles;
     std::vector<MojoHandleSignals> signals;
-    for (const auto& it : recorder_impls_) {
-      handles.push_back(it->TraceRecorderHandle());
+    size_t num_recorders = sink->IsFull() ? 0 : recorder_impls->size();
+    for (size_t i = 0; i < num_recorders; ++i) {
+      handles.push_back((*recorder_impls)[i]->TraceRecorderHandle());
       signals.push_back(MOJO_HANDLE_SIGNAL_READABLE |
                         MOJO_HANDLE_SIGNAL_PEER_CLOSED);
     }
+    bool sink_has_data = sink->buffered_bytes() != 0;
+    if (sink_has_data) {
+      handles.push_back(sink->handle());
+      signals.push_back(MOJO_HANDLE_SIGNAL_WRITABLE);
+    }
     std::vector<MojoHandleSignalsState> signals_states(signals.size());
     const mojo::WaitManyResult wait_many_result =
         mojo::WaitMany(handles, signals, mojo_deadline, &signals_states);
@@ -103,28 +157,44 @@ void TracingApp::StopAndFlush() {
       break;
     }
     if (wait_many_result.IsIndexValid()) {
-      // Iterate backwards so we can remove closed pipes from |recorder_impls_|
+      // This also notices if the consumer has gone away.
+      if (sink_has_data)
+        sink->TryWrite();
+      // Iterate backwards so we can remove closed pipes from |recorder_impls|
       // without invalidating subsequent offsets.
-      for (size_t i = signals_states.size(); i != 0; --i) {
+      for (size_t i = num_recorders; i != 0; --i) {
         size_t index = i - 1;
         MojoHandleSignals satisfied = signals_states[index].satisfied_signals;
         // To avoid dropping data, don't close unless there's no
         // readable signal.
         if (satisfied & MOJO_HANDLE_SIGNAL_READABLE)
-          recorder_impls_[index]->TryRead();
+          (*recorder_impls)[index]->TryRead();
         else if (satisfied & MOJO_HANDLE_SIGNAL_PEER_CLOSED)
-          recorder_impls_.erase(recorder_impls_.begin() + index);
+          recorder_impls->erase(recorder_impls->begin() + index);
       }
       // Something happened so push back the timeout deadline.
       end = MojoGetTimeTicksNow() + kTimeToWaitMicros;
     }
   }
-  AllDataCollected();
 }
 
 void TracingApp::AllDataCollected() {
   recorder_impls_.clear();
-  sink_.reset();
+  if (sink_)
+    CloseSink(sink_.Pass());
+}
+
+void TracingApp::CloseSink(scoped_ptr<TraceDataSink> sink) {
+  // Let the sink finish writing out what its consumer hasn't read yet.
+  TraceDataSink* raw_sink = sink.get();
+  closing_sinks_.push_back(sink.release());
+  raw_sink->Close(
+      base::Bind(&TracingApp::OnSinkClosed, base::Unretained(this), raw_sink));
+}
+
+void TracingApp::OnSinkClosed(TraceDataSink* sink) {
+  closing_sinks_.erase(
+      std::find(closing_sinks_.begin(), closing_sinks_.end(), sink));
 }
 
 }  // namespace tracing
@@ -38,14 +38,26 @@ class TracingApp : public mojo::ApplicationDelegate,
   void Start(mojo::ScopedDataPipeProducerHandle stream,
              const mojo::String& categories) override;
   void StopAndFlush() override;
+  void StartFlightRecorder(const mojo::String& categories) override;
+  void Snapshot(mojo::ScopedDataPipeProducerHandle stream,
+                uint32_t seconds) override;
 
+  // Passes the data sent via |recorder_impls| to |sink| until they are all
+  // closed (or time out).
+  void CollectTraceData(ScopedVector<TraceRecorderImpl>* recorder_impls,
+                        TraceDataSink* sink);
   void AllDataCollected();
+  void CloseSink(scoped_ptr<TraceDataSink> sink);
+  void OnSinkClosed(TraceDataSink* sink);
 
   scoped_ptr<TraceDataSink> sink_;
+  // Sinks of previous traces that are still being written out.
+  ScopedVector<TraceDataSink> closing_sinks_;
   ScopedVector<TraceRecorderImpl> recorder_impls_;
   mojo::InterfacePtrSet<TraceProvider> provider_ptrs_;
   mojo::Binding<TraceCollector> collector_binding_;
   bool tracing_active_;
+  bool flight_recording_;
   mojo::String tracing_categories_;
 
   DISALLOW_COPY_AND_ASSIGN(TracingApp);
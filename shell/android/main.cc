@@ -23,6 +23,7 @@
 #include "base/synchronization/waitable_event.h"
 #include "base/task_runner_util.h"
 #include "base/threading/simple_thread.h"
+#include "base/threading/work_stealing_pool.h"
 #include "gpu/config/gpu_util.h"
 #include "jni/ShellService_jni.h"
 #include "mojo/common/binding_set.h"
@@ -4,13 +4,23 @@
 
 #include "shell/application_manager/application_manager.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/process/process_metrics.h"
+#include "base/sequenced_task_runner.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
+#include "base/task_runner_util.h"
+#include "base/threading/work_stealing_pool.h"
 #include "base/trace_event/trace_event.h"
+#include "build/build_config.h"
 #include "mojo/public/cpp/bindings/binding.h"
 #include "mojo/services/authenticating_url_loader_interceptor/interfaces/authenticating_url_loader_interceptor_meta_factory.mojom.h"
 #include "mojo/services/authentication/interfaces/authentication.mojom.h"
@@ -20,6 +30,7 @@
 #include "shell/application_manager/network_fetcher.h"
 #include "shell/application_manager/query_util.h"
 #include "shell/application_manager/shell_impl.h"
+#include "shell/startup_timeline.h"
 
 using mojo::Application;
 using mojo::ApplicationPtr;
@@ -37,6 +48,18 @@ const bool kDoNotStripQuery = false;
 // Used by TestAPI.
 bool has_created_instance = false;
 
+// How often the memory use of applications is checked against the budget, when
+// reaping idle applications.
+const int64_t kMemoryBudgetCheckIntervalSeconds = 10;
+
+// How long a reaped application is given to quit before it's dropped anyway,
+// so that the connections waiting for it don't wait forever.
+const int64_t kQuitTimeoutSeconds = 5;
+
+// Bounds the number of cached resolved connections, since requested URLs
+// include their queries.
+const size_t kMaxResolvedConnections = 1000;
+
 std::vector<std::string> Concatenate(const std::vector<std::string>& v1,
                                      const std::vector<std::string>& v2) {
   if (!v1.size())
@@ -56,8 +79,48 @@ void AppendArgsForURL(const GURL& url,
   target->insert(target->end(), args.begin(), args.end());
 }
 
+// Estimates the memory used by the application of |shell_impl| (see
+// |ApplicationManager::EnableIdleReaping()|).
+size_t EstimateMemoryUse(const ShellImpl* shell_impl) {
+  if (!shell_impl->native_runner())
+    return 0;
+  base::ProcessHandle process = shell_impl->native_runner()->GetProcessHandle();
+  if (process == base::kNullProcessHandle)
+    return 0;
+#if defined(OS_MACOSX)
+  // Getting the metrics of another process requires a port provider.
+  return 0;
+#else
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(process));
+  return metrics->GetWorkingSetSize();
+#endif
+}
+
+void WriteDependencyGraph(const base::FilePath& path, const std::string& json) {
+  if (!base::CreateDirectory(path.DirName()) ||
+      !base::ImportantFileWriter::WriteFileAtomically(path, json))
+    LOG(WARNING) << "Failed to write preload manifest " << path.value();
+}
+
 }  // namespace
 
+// An application being (or that has been) fetched and loaded ahead of time.
+struct ApplicationManager::PreloadedApplication {
+  PreloadedApplication() : path_available(false), library(nullptr) {}
+
+  // A connection to the application that arrived while it was being fetched
+  // (or sniffed); it gets the fetcher once available.
+  base::Callback<void(scoped_ptr<Fetcher>)> waiting_callback;
+  // Set once fetched and sniffed. Kept alive (like in
+  // |RunNativeApplication()|) while the application may use |path|.
+  scoped_ptr<Fetcher> fetcher;
+  bool path_available;
+  base::FilePath path;
+  // Null if not loaded (yet).
+  base::NativeLibrary library;
+};
+
 class ApplicationManager::ContentHandlerConnection {
  public:
   ContentHandlerConnection(ApplicationManager* manager, Identity identity)
@@ -108,20 +171,91 @@ bool ApplicationManager::TestAPI::HasFactoryForURL(const GURL& url) const {
          manager_->identity_to_shell_impl_.end();
 }
 
+void ApplicationManager::TestAPI::SetQuitTimeout(base::TimeDelta quit_timeout) {
+  manager_->quit_timeout_ = quit_timeout;
+}
+
+bool ApplicationManager::TestAPI::IsPreloading(const GURL& url) const {
+  return manager_->preloaded_applications_.find(url) !=
+         manager_->preloaded_applications_.end();
+}
+
+bool ApplicationManager::TestAPI::IsPreloaded(const GURL& url) const {
+  auto it = manager_->preloaded_applications_.find(url);
+  return it != manager_->preloaded_applications_.end() &&
+         it->second->path_available;
+}
+
+bool ApplicationManager::TestAPI::IsWaitingForPreload(const GURL& url) const {
+  auto it = manager_->preloaded_applications_.find(url);
+  return it != manager_->preloaded_applications_.end() &&
+         !it->second->waiting_callback.is_null();
+}
+
 ApplicationManager::ApplicationManager(const Options& options,
                                        Delegate* delegate)
     : options_(options),
       delegate_(delegate),
+      mappings_version_(0),
       blocking_pool_(nullptr),
       initialized_authentication_interceptor_(false),
+      preload_libraries_(false),
+      idle_memory_budget_(0),
+      quit_timeout_(base::TimeDelta::FromSeconds(kQuitTimeoutSeconds)),
+      num_reaped_applications_(0),
+      reaped_bytes_(0),
       weak_ptr_factory_(this) {
 }
 
 ApplicationManager::~ApplicationManager() {
+  // Unload the libraries of preloaded applications that were never started.
+  for (const auto& it : preloaded_applications_) {
+    if (it.second->library)
+      base::UnloadNativeLibrary(it.second->library);
+  }
+}
+
+void ApplicationManager::EnablePreloading(const base::FilePath& manifest_path,
+                                          bool load_libraries) {
+  TRACE_EVENT0("mojo_shell", "ApplicationManager::EnablePreloading");
+  DCHECK(blocking_pool_);
+  // This only writes the manifest, which can wait for the fetches and loads.
+  preload_task_runner_ = blocking_pool_->GetSequencedTaskRunner(
+      blocking_pool_->GetSequenceToken(),
+      base::WorkStealingPool::PRIORITY_BACKGROUND,
+      base::WorkStealingPool::BLOCK_SHUTDOWN);
+  preload_manifest_path_ = manifest_path;
+  preload_libraries_ = load_libraries;
+
+  // This is read synchronously, since the first application is about to be
+  // requested and its dependencies should be known by then. The manifest is
+  // small.
+  std::string json;
+  if (base::ReadFileToString(manifest_path, &json) &&
+      !dependency_graph_.Deserialize(json)) {
+    LOG(WARNING) << "Ignoring invalid preload manifest "
+                 << manifest_path.value();
+  }
+}
+
+void ApplicationManager::EnableIdleReaping(size_t memory_budget,
+                                           base::TimeDelta min_idle_time) {
+  idle_memory_budget_ = memory_budget;
+  min_idle_time_ = min_idle_time;
+  memory_pressure_listener_.reset(new base::MemoryPressureListener(base::Bind(
+      &ApplicationManager::OnMemoryPressure, base::Unretained(this))));
+  if (memory_budget) {
+    memory_budget_timer_.Start(
+        FROM_HERE,
+        base::TimeDelta::FromSeconds(kMemoryBudgetCheckIntervalSeconds), this,
+        &ApplicationManager::CheckMemoryBudget);
+  }
 }
 
 void ApplicationManager::TerminateShellConnections() {
+  resolved_connections_.clear();
   identity_to_shell_impl_.clear();
+  connections_after_quit_.clear();
 }
 
 void ApplicationManager::ConnectToApplication(
@@ -148,21 +282,52 @@ void ApplicationManager::ConnectToApplicationWithParameters(
       "requestor_url", requestor_url.spec());
   DCHECK(requested_url.is_valid());
 
+  ResolvedConnection* resolved = ResolveConnection(requested_url);
+  if (resolved->shell_impl) {
+    ConnectToClient(resolved->shell_impl, resolved->shell_impl_url,
+                    requestor_url, services.Pass(), exposed_services.Pass());
+    return;
+  }
+
   // We check both the mapped and resolved urls for existing shell_impls because
   // external applications can be registered for the unresolved mojo:foo urls.
 
-  GURL mapped_url = delegate_->ResolveMappings(requested_url);
-  if (ConnectToRunningApplication(mapped_url, requestor_url, &services,
-                                  &exposed_services)) {
+  ShellImpl* quitting_shell_impl = GetQuittingShellImpl(resolved->mapped_url);
+  if (!quitting_shell_impl)
+    quitting_shell_impl = GetQuittingShellImpl(resolved->resolved_url);
+  if (quitting_shell_impl) {
+    // Starting a new instance while the old one is still running could have
+    // them fight over the same resources, so this waits for it to be gone.
+    connections_after_quit_[quitting_shell_impl->identity()].push_back(
+        base::Bind(&ApplicationManager::ConnectToApplicationWithParameters,
+                   weak_ptr_factory_.GetWeakPtr(), requested_url,
+                   requestor_url, base::Passed(services.Pass()),
+                   base::Passed(exposed_services.Pass()), on_application_end,
+                   pre_redirect_parameters));
     return;
   }
 
-  GURL resolved_url = delegate_->ResolveMojoURL(mapped_url);
-  if (ConnectToRunningApplication(resolved_url, requestor_url, &services,
-                                  &exposed_services)) {
+  ShellImpl* shell_impl = ConnectToRunningApplication(
+      resolved->mapped_url, requestor_url, &services, &exposed_services);
+  if (shell_impl) {
+    resolved->shell_impl = shell_impl;
+    resolved->shell_impl_url = resolved->mapped_url;
+    return;
+  }
+
+  shell_impl = ConnectToRunningApplication(
+      resolved->resolved_url, requestor_url, &services, &exposed_services);
+  if (shell_impl) {
+    resolved->shell_impl = shell_impl;
+    resolved->shell_impl_url = resolved->resolved_url;
     return;
   }
 
+  // Copied, since loading the application may connect to other ones, which
+  // invalidates |resolved|.
+  const GURL mapped_url = resolved->mapped_url;
+  const GURL resolved_url = resolved->resolved_url;
+
   // The application is not running, let's compute the parameters.
   std::vector<std::string> parameters =
       Concatenate(pre_redirect_parameters, GetArgsForURL(resolved_url));
@@ -185,11 +350,32 @@ void ApplicationManager::ConnectToApplicationWithParameters(
     return;
   }
 
-  auto callback = base::Bind(
+  if (preload_task_runner_) {
+    if (requestor_url.is_empty())
+      PreloadDependencies(resolved_url);
+    else
+      RecordDependency(requestor_url, resolved_url);
+
+    if (ConnectToPreloadedApplication(resolved_url, requestor_url, &services,
+                                      &exposed_services, on_application_end,
+                                      parameters)) {
+      return;
+    }
+  }
+
+  FetchCallback callback = base::Bind(
       &ApplicationManager::HandleFetchCallback, weak_ptr_factory_.GetWeakPtr(),
-      requestor_url, base::Passed(services.Pass()),
+      resolved_url, requestor_url, base::Passed(services.Pass()),
       base::Passed(exposed_services.Pass()), on_application_end, parameters);
+  if (preload_task_runner_ && WaitForPreload(resolved_url, callback))
+    return;
+  StartFetch(resolved_url, callback);
+}
 
+void ApplicationManager::StartFetch(const GURL& resolved_url,
+                                    const FetchCallback& callback) {
+  // Ends in |HandleFetchCallback()| or |OnPreloadFetched()|.
+  BeginStartupPhase("Fetch", resolved_url.spec());
   if (resolved_url.SchemeIsFile()) {
     new LocalFetcher(resolved_url, GetBaseURLAndQuery(resolved_url, nullptr),
                      callback);
@@ -237,7 +423,251 @@ void ApplicationManager::ConnectToApplicationWithParameters(
                      network_service, callback);
 }
 
-bool ApplicationManager::ConnectToRunningApplication(
+void ApplicationManager::RecordDependency(const GURL& requestor_url,
+                                          const GURL& resolved_url) {
+  GURL from = GetBaseURLAndQuery(requestor_url, nullptr);
+  GURL to = GetBaseURLAndQuery(resolved_url, nullptr);
+  if (!dependency_graph_.AddDependency(from, to))
+    return;
+
+  DVLOG(2) << "Recording dependency of " << from << " on " << to;
+  preload_task_runner_->PostTask(
+      FROM_HERE, base::Bind(&WriteDependencyGraph, preload_manifest_path_,
+                            dependency_graph_.Serialize()));
+}
+
+void ApplicationManager::PreloadDependencies(const GURL& resolved_url) {
+  // Applications served by loaders aren't fetched, so there's nothing to
+  // preload.
+  if (default_loader_)
+    return;
+
+  std::vector<GURL> dependencies = dependency_graph_.GetTransitiveDependencies(
+      GetBaseURLAndQuery(resolved_url, nullptr));
+  for (const GURL& url : dependencies) {
+    if (!url.SchemeIsFile() && !url.SchemeIsHTTPOrHTTPS())
+      continue;
+    if (GetShellImpl(url) || GetLoaderForURL(url) ||
+        preloaded_applications_.find(url) != preloaded_applications_.end()) {
+      continue;
+    }
+
+    PreloadedApplication* preloaded = new PreloadedApplication();
+    preloaded_applications_[url] = make_scoped_ptr(preloaded);
+    TRACE_EVENT_ASYNC_BEGIN1("mojo_shell", "ApplicationManager::Preload",
+                             preloaded, "url", url.spec());
+    StartFetch(url, base::Bind(&ApplicationManager::OnPreloadFetched,
+                               weak_ptr_factory_.GetWeakPtr(), url, preloaded));
+  }
+}
+
+void ApplicationManager::OnPreloadFetched(const GURL& url,
+                                          PreloadedApplication* preloaded,
+                                          scoped_ptr<Fetcher> fetcher) {
+  EndStartupPhase("Fetch", url.spec());
+  if (!IsCurrentPreload(url, preloaded) ||
+      HandOverPreload(url, preloaded, &fetcher)) {
+    return;
+  }
+
+  // Only plain native applications are preloaded. (Anything else will be
+  // fetched again when connected to, and handled as usual.)
+  if (!fetcher || GetShellImpl(url) || !fetcher->GetRedirectURL().is_empty() ||
+      mime_type_to_url_.find(fetcher->MimeType()) != mime_type_to_url_.end()) {
+    DiscardPreload(url);
+    return;
+  }
+
+  Fetcher* raw_fetcher = fetcher.get();
+  raw_fetcher->PeekContentHandler(
+      blocking_pool_,
+      base::Bind(&ApplicationManager::OnPreloadSniffed,
+                 weak_ptr_factory_.GetWeakPtr(), url, preloaded,
+                 base::Passed(&fetcher)));
+}
+
+void ApplicationManager::OnPreloadSniffed(const GURL& url,
+                                          PreloadedApplication* preloaded,
+                                          scoped_ptr<Fetcher> fetcher,
+                                          bool has_content_handler,
+                                          const std::string& shebang,
+                                          const GURL& content_handler_url) {
+  // A connection may have started waiting for the preload in the meantime; it
+  // will sniff the content again itself.
+  if (!IsCurrentPreload(url, preloaded) ||
+      HandOverPreload(url, preloaded, &fetcher)) {
+    return;
+  }
+
+  if (has_content_handler || GetShellImpl(url)) {
+    DiscardPreload(url);
+    return;
+  }
+
+  preloaded->fetcher = fetcher.Pass();
+  preloaded->fetcher->AsPath(
+      blocking_pool_,
+      base::Bind(&ApplicationManager::OnPreloadPathAvailable,
+                 weak_ptr_factory_.GetWeakPtr(), url, preloaded));
+}
+
+bool ApplicationManager::HandOverPreload(const GURL& url,
+                                         PreloadedApplication* preloaded,
+                                         scoped_ptr<Fetcher>* fetcher) {
+  if (preloaded->waiting_callback.is_null())
+    return false;
+
+  // Hand the fetcher (or the failure) over to the connection that has been
+  // waiting for it.
+  TRACE_EVENT_ASYNC_END0("mojo_shell", "ApplicationManager::Preload",
+                         preloaded);
+  FetchCallback callback = preloaded->waiting_callback;
+  preloaded_applications_.erase(url);
+  callback.Run(fetcher->Pass());
+  return true;
+}
+
+void ApplicationManager::OnPreloadPathAvailable(
+    const GURL& url,
+    PreloadedApplication* preloaded,
+    const base::FilePath& path,
+    bool path_exists) {
+  if (!IsCurrentPreload(url, preloaded))
+    return;
+  // The application may have been started (by another fetch) in the meantime.
+  if (!path_exists || GetShellImpl(url)) {
+    DiscardPreload(url);
+    return;
+  }
+
+  preloaded->path_available = true;
+  preloaded->path = path;
+  if (!preload_libraries_) {
+    TRACE_EVENT_ASYNC_END0("mojo_shell", "ApplicationManager::Preload",
+                           preloaded);
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      blocking_pool_, FROM_HERE, base::Bind(&LoadNativeApplication, path),
+      base::Bind(&ApplicationManager::OnPreloadLibraryLoaded,
+                 weak_ptr_factory_.GetWeakPtr(), url, preloaded));
+}
+
+void ApplicationManager::OnPreloadLibraryLoaded(
+    const GURL& url,
+    PreloadedApplication* preloaded,
+    base::NativeLibrary library) {
+  TRACE_EVENT_ASYNC_END0("mojo_shell", "ApplicationManager::Preload",
+                         preloaded);
+  if (!IsCurrentPreload(url, preloaded)) {
+    // Either the application has been started in the meantime (in which case
+    // it has loaded the library itself), or the preload was discarded.
+    if (library)
+      base::UnloadNativeLibrary(library);
+    return;
+  }
+  preloaded->library = library;
+}
+
+bool ApplicationManager::IsCurrentPreload(
+    const GURL& url,
+    PreloadedApplication* preloaded) const {
+  auto it = preloaded_applications_.find(url);
+  return it != preloaded_applications_.end() && it->second.get() == preloaded;
+}
+
+void ApplicationManager::DiscardPreload(const GURL& url) {
+  auto it = preloaded_applications_.find(url);
+  DCHECK(it != preloaded_applications_.end());
+  TRACE_EVENT_ASYNC_END0("mojo_shell", "ApplicationManager::Preload",
+                         it->second.get());
+  if (it->second->library)
+    base::UnloadNativeLibrary(it->second->library);
+  preloaded_applications_.erase(it);
+}
+
+bool ApplicationManager::WaitForPreload(const GURL& resolved_url,
+                                        const FetchCallback& callback) {
+  auto it = preloaded_applications_.find(resolved_url);
+  if (it == preloaded_applications_.end() || it->second->fetcher ||
+      it->second->path_available || !it->second->waiting_callback.is_null()) {
+    return false;
+  }
+  it->second->waiting_callback = callback;
+  return true;
+}
+
+bool ApplicationManager::ConnectToPreloadedApplication(
+    const GURL& resolved_url,
+    const GURL& requestor_url,
+    InterfaceRequest<ServiceProvider>* services,
+    ServiceProviderPtr* exposed_services,
+    const base::Closure& on_application_end,
+    const std::vector<std::string>& parameters) {
+  // Applications started with a query are fetched (with the query) as usual.
+  if (resolved_url.has_query())
+    return false;
+  auto it = preloaded_applications_.find(resolved_url);
+  if (it == preloaded_applications_.end() || !it->second->path_available)
+    return false;
+
+  TRACE_EVENT_INSTANT1("mojo_shell",
+                       "ApplicationManager::ConnectToPreloadedApplication",
+                       TRACE_EVENT_SCOPE_THREAD, "url", resolved_url.spec());
+  scoped_ptr<PreloadedApplication> preloaded = it->second.Pass();
+  preloaded_applications_.erase(it);
+  // Note: |preloaded->library| is intentionally not unloaded: the application
+  // will load the same library (if run in process), and libraries of native
+  // applications are never unloaded anyway.
+
+  Identity app_identity = MakeApplicationIdentity(resolved_url);
+  InterfaceRequest<Application> request(RegisterShell(
+      app_identity, resolved_url, requestor_url, services->Pass(),
+      exposed_services->Pass(), on_application_end, parameters));
+  NativeApplicationOptions options;
+  if (url_to_native_options_.find(resolved_url) !=
+      url_to_native_options_.end()) {
+    options = url_to_native_options_[resolved_url];
+  }
+  RunNativeApplication(app_identity, request.Pass(), options,
+                       preloaded->fetcher.Pass(), preloaded->path, true);
+  return true;
+}
+
+ApplicationManager::ResolvedConnection* ApplicationManager::ResolveConnection(
+    const GURL& requested_url) {
+  uint64_t mappings_version = delegate_->GetMappingsVersion();
+  if (mappings_version != mappings_version_) {
+    resolved_connections_.clear();
+    mappings_version_ = mappings_version;
+  }
+
+  auto it = resolved_connections_.find(requested_url.spec());
+  if (it != resolved_connections_.end())
+    return &it->second;
+
+  if (resolved_connections_.size() >= kMaxResolvedConnections)
+    resolved_connections_.clear();
+  ResolvedConnection* resolved = &resolved_connections_[requested_url.spec()];
+
+  BeginStartupPhase("ResolveMappings", requested_url.spec());
+  resolved->mapped_url = delegate_->ResolveMappings(requested_url);
+  EndStartupPhase("ResolveMappings", requested_url.spec());
+
+  BeginStartupPhase("ResolveMojoURL", resolved->mapped_url.spec());
+  resolved->resolved_url = delegate_->ResolveMojoURL(resolved->mapped_url);
+  EndStartupPhase("ResolveMojoURL", resolved->mapped_url.spec());
+  return resolved;
+}
+
+void ApplicationManager::ForgetResolvedConnections(ShellImpl* shell_impl) {
+  for (auto& it : resolved_connections_) {
+    if (it.second.shell_impl == shell_impl)
+      it.second.shell_impl = nullptr;
+  }
+}
+
+ShellImpl* ApplicationManager::ConnectToRunningApplication(
     const GURL& resolved_url,
     const GURL& requestor_url,
     InterfaceRequest<ServiceProvider>* services,
@@ -245,14 +675,14 @@ bool ApplicationManager::ConnectToRunningApplication(
   GURL application_url = GetBaseURLAndQuery(resolved_url, nullptr);
   ShellImpl* shell_impl = GetShellImpl(application_url);
   if (!shell_impl)
-    return false;
+    return nullptr;
 
   DCHECK(!GetNativeApplicationOptionsForURL(application_url)
               ->new_process_per_connection);
 
   ConnectToClient(shell_impl, resolved_url, requestor_url, services->Pass(),
                   exposed_services->Pass());
-  return true;
+  return shell_impl;
 }
 
 bool ApplicationManager::ConnectToApplicationWithLoader(
@@ -266,13 +696,156 @@ bool ApplicationManager::ConnectToApplicationWithLoader(
   if (!loader)
     return false;
 
-  loader->Load(
-      resolved_url,
-      RegisterShell(resolved_url, requestor_url, services->Pass(),
-                    exposed_services->Pass(), on_application_end, parameters));
+  loader->Load(resolved_url,
+               RegisterShell(MakeApplicationIdentity(resolved_url),
+                             resolved_url, requestor_url, services->Pass(),
+                             exposed_services->Pass(), on_application_end,
+                             parameters));
   return true;
 }
 
+void ApplicationManager::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level) {
+  switch (memory_pressure_level) {
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+      // With no budget, this reaps all idle applications.
+      ReapIdleApplications(idle_memory_budget_ / 2);
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+      ReapIdleApplications(0);
+      break;
+  }
+}
+
+void ApplicationManager::CheckMemoryBudget() {
+  DCHECK(idle_memory_budget_);
+  ReapIdleApplications(idle_memory_budget_);
+}
+
+void ApplicationManager::ReapIdleApplications(size_t target_bytes) {
+  TRACE_EVENT1("mojo_shell", "ApplicationManager::ReapIdleApplications",
+               "target_bytes", static_cast<uint64_t>(target_bytes));
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  std::set<GURL> content_handler_urls;
+  for (const auto& it : identity_to_content_handler_) {
+    content_handler_urls.insert(
+        GetBaseURLAndQuery(it.second->content_handler_url(), nullptr));
+  }
+
+  struct IdleApplication {
+    base::TimeTicks last_connection_time;
+    ShellImpl* shell_impl;
+    size_t bytes;
+  };
+  std::vector<IdleApplication> idle_applications;
+  size_t total_bytes = 0;
+  for (const auto& it : identity_to_shell_impl_) {
+    size_t bytes = EstimateMemoryUse(it.second.get());
+    total_bytes += bytes;
+    if (IsIdleApplication(it.second.get(), now, content_handler_urls)) {
+      idle_applications.push_back(
+          {it.second->last_connection_time(), it.second.get(), bytes});
+    }
+  }
+  if (target_bytes && total_bytes <= target_bytes)
+    return;
+
+  std::sort(idle_applications.begin(), idle_applications.end(),
+            [](const IdleApplication& a, const IdleApplication& b) {
+              return a.last_connection_time < b.last_connection_time;
+            });
+  for (const auto& idle_application : idle_applications) {
+    if (target_bytes && total_bytes <= target_bytes)
+      break;
+    // Reaping applications of unknown cost wouldn't help with the budget.
+    if (target_bytes && !idle_application.bytes)
+      continue;
+    ReapApplication(idle_application.shell_impl->identity());
+    total_bytes -= idle_application.bytes;
+    num_reaped_applications_++;
+    reaped_bytes_ += idle_application.bytes;
+  }
+  TRACE_COUNTER1("mojo_shell", "ReapedApplications", num_reaped_applications_);
+  TRACE_COUNTER1("mojo_shell", "ReapedApplicationBytes", reaped_bytes_);
+}
+
+bool ApplicationManager::IsIdleApplication(
+    const ShellImpl* shell_impl,
+    base::TimeTicks now,
+    const std::set<GURL>& content_handler_urls) const {
+  if (now - shell_impl->last_connection_time() < min_idle_time_)
+    return false;
+  if (shell_impl->quitting() || !shell_impl->on_application_end().is_null())
+    return false;
+  // Only applications that were fetched can be started again transparently.
+  if (!shell_impl->native_runner() &&
+      shell_impl->content_handler_url().is_empty())
+    return false;
+  bool is_content_handler =
+      content_handler_urls.count(shell_impl->identity().url) > 0;
+  if (shell_impl->connected_by_shell() && !is_content_handler)
+    return false;
+  if (is_content_handler) {
+    // Don't take down the applications it runs.
+    for (const auto& it : identity_to_shell_impl_) {
+      if (it.second->content_handler_url() == shell_impl->identity().url)
+        return false;
+    }
+  }
+  return true;
+}
+
+void ApplicationManager::ReapApplication(const Identity& app_identity) {
+  // Copied, since |app_identity| may belong to the |ShellImpl| that's reaped.
+  const Identity identity = app_identity;
+  TRACE_EVENT_INSTANT1("mojo_shell", "ApplicationManager::ReapApplication",
+                       TRACE_EVENT_SCOPE_THREAD, "url", identity.url.spec());
+  DVLOG(2) << "Reaping idle application " << identity.url;
+  auto it = identity_to_shell_impl_.find(identity);
+  DCHECK(it != identity_to_shell_impl_.end());
+
+  // Applications started from now on get a new instance of the content handler.
+  for (auto handler_it = identity_to_content_handler_.begin();
+       handler_it != identity_to_content_handler_.end();) {
+    if (GetBaseURLAndQuery(handler_it->second->content_handler_url(),
+                           nullptr) == identity.url) {
+      handler_it = identity_to_content_handler_.erase(handler_it);
+    } else {
+      ++handler_it;
+    }
+  }
+
+  // Ask the application to quit. It's kept until it has, or until
+  // |quit_timeout_| (see |OnShellImplError()|), and the connections to it in
+  // the meantime wait for a new instance.
+  it->second->RequestQuit(quit_timeout_);
+  ForgetResolvedConnections(it->second.get());
+}
+
+ShellImpl* ApplicationManager::GetQuittingShellImpl(const GURL& url) {
+  const auto& shell_it =
+      identity_to_shell_impl_.find(Identity(GetBaseURLAndQuery(url, nullptr)));
+  if (shell_it != identity_to_shell_impl_.end() &&
+      shell_it->second->quitting()) {
+    return shell_it->second.get();
+  }
+  return nullptr;
+}
+
+void ApplicationManager::RunConnectionsAfterQuit(const Identity& app_identity) {
+  auto it = connections_after_quit_.find(app_identity);
+  if (it == connections_after_quit_.end())
+    return;
+  std::vector<base::Closure> connections;
+  connections.swap(it->second);
+  connections_after_quit_.erase(it);
+  for (const base::Closure& connection : connections)
+    connection.Run();
+}
+
 Identity ApplicationManager::MakeApplicationIdentity(const GURL& resolved_url,
                                                      bool strip_query) {
   static uint64_t unique_id_number = 1;
@@ -287,23 +860,28 @@ Identity ApplicationManager::MakeApplicationIdentity(const GURL& resolved_url,
 }
 
 InterfaceRequest<Application> ApplicationManager::RegisterShell(
+    const Identity& app_identity,
     const GURL& resolved_url,
     const GURL& requestor_url,
     InterfaceRequest<ServiceProvider> services,
     ServiceProviderPtr exposed_services,
     const base::Closure& on_application_end,
     const std::vector<std::string>& parameters) {
-  Identity app_identity = MakeApplicationIdentity(resolved_url);
-
   mojo::ApplicationPtr application;
   InterfaceRequest<Application> application_request =
       mojo::GetProxy(&application);
   ShellImpl* shell =
       new ShellImpl(application.Pass(), this, app_identity, on_application_end);
-  identity_to_shell_impl_[app_identity] = make_scoped_ptr(shell);
+  scoped_ptr<ShellImpl>& shell_ptr = identity_to_shell_impl_[app_identity];
+  if (shell_ptr)
+    ForgetResolvedConnections(shell_ptr.get());
+  shell_ptr = make_scoped_ptr(shell);
   shell->InitializeApplication(mojo::Array<mojo::String>::From(parameters));
   ConnectToClient(shell, resolved_url, requestor_url, services.Pass(),
                   exposed_services.Pass());
+  // A quitting instance may have been replaced (by an application whose fetch
+  // was started before it was reaped), so this is its new one.
+  RunConnectionsAfterQuit(app_identity);
   return application_request;
 }
 
@@ -313,8 +891,10 @@ InterfaceRequest<Application> ApplicationManager::RegisterShell(
 ShellImpl* ApplicationManager::GetShellImpl(const GURL& url) {
   DCHECK(!url.has_query());
   const auto& shell_it = identity_to_shell_impl_.find(Identity(url));
-  if (shell_it != identity_to_shell_impl_.end())
+  if (shell_it != identity_to_shell_impl_.end() &&
+      !shell_it->second->quitting()) {
     return shell_it->second.get();
+  }
   return nullptr;
 }
 
@@ -329,12 +909,16 @@ void ApplicationManager::ConnectToClient(
 }
 
 void ApplicationManager::HandleFetchCallback(
+    const GURL& resolved_url,
     const GURL& requestor_url,
     InterfaceRequest<ServiceProvider> services,
     ServiceProviderPtr exposed_services,
     const base::Closure& on_application_end,
     const std::vector<std::string>& parameters,
     scoped_ptr<Fetcher> fetcher) {
+  // The phase began in |StartFetch()| for |resolved_url|, which redirects and
+  // fetchers may have changed.
+  EndStartupPhase("Fetch", resolved_url.spec());
   if (!fetcher) {
     // Network error. Drop |application_request| to tell requestor.
     return;
@@ -360,25 +944,45 @@ void ApplicationManager::HandleFetchCallback(
     return;
   }
 
-  InterfaceRequest<Application> request(
-      RegisterShell(fetcher->GetURL(), requestor_url, services.Pass(),
-                    exposed_services.Pass(), on_application_end, parameters));
+  Identity app_identity = MakeApplicationIdentity(fetcher->GetURL());
+  InterfaceRequest<Application> request(RegisterShell(
+      app_identity, fetcher->GetURL(), requestor_url, services.Pass(),
+      exposed_services.Pass(), on_application_end, parameters));
 
-  // If the response begins with a #!mojo <content-handler-url>, use it.
-  GURL content_handler_url;
-  std::string shebang;
-  if (fetcher->PeekContentHandler(&shebang, &content_handler_url)) {
-    LoadWithContentHandler(
-        content_handler_url, request.Pass(),
-        fetcher->AsURLResponse(blocking_pool_,
-                               static_cast<int>(shebang.size())));
+  // If the response begins with a #!mojo <content-handler-url>, use it. The
+  // content is sniffed asynchronously, so that other connections can proceed
+  // in the meantime.
+  Fetcher* raw_fetcher = fetcher.get();
+  raw_fetcher->PeekContentHandler(
+      blocking_pool_,
+      base::Bind(&ApplicationManager::OnContentHandlerSniffed,
+                 weak_ptr_factory_.GetWeakPtr(), app_identity,
+                 base::Passed(&request), base::Passed(&fetcher)));
+}
+
+void ApplicationManager::OnContentHandlerSniffed(
+    const Identity& app_identity,
+    InterfaceRequest<Application> request,
+    scoped_ptr<Fetcher> fetcher,
+    bool has_content_handler,
+    const std::string& shebang,
+    const GURL& content_handler_url) {
+  if (has_content_handler) {
+    fetcher->AsURLResponse(
+        blocking_pool_, static_cast<int>(shebang.size()),
+        base::Bind(&ApplicationManager::LoadWithContentHandler,
+                   weak_ptr_factory_.GetWeakPtr(), content_handler_url,
+                   app_identity, base::Passed(&request)));
     return;
   }
 
   auto it = mime_type_to_url_.find(fetcher->MimeType());
   if (it != mime_type_to_url_.end()) {
-    LoadWithContentHandler(it->second, request.Pass(),
-                           fetcher->AsURLResponse(blocking_pool_, 0));
+    fetcher->AsURLResponse(
+        blocking_pool_, 0,
+        base::Bind(&ApplicationManager::LoadWithContentHandler,
+                   weak_ptr_factory_.GetWeakPtr(), it->second, app_identity,
+                   base::Passed(&request)));
     return;
   }
 
@@ -399,14 +1003,17 @@ void ApplicationManager::HandleFetchCallback(
 
   TRACE_EVENT_ASYNC_BEGIN1("mojo_shell", "ApplicationManager::RetrievePath",
                            fetcher.get(), "url", fetcher->GetURL().spec());
+  BeginStartupPhase("RetrievePath", fetcher->GetURL().spec());
   fetcher->AsPath(
       blocking_pool_,
       base::Bind(&ApplicationManager::RunNativeApplication,
-                 weak_ptr_factory_.GetWeakPtr(), base::Passed(request.Pass()),
-                 options, base::Passed(fetcher.Pass())));
+                 weak_ptr_factory_.GetWeakPtr(), app_identity,
+                 base::Passed(request.Pass()), options,
+                 base::Passed(fetcher.Pass())));
 }
 
 void ApplicationManager::RunNativeApplication(
+    const Identity& app_identity,
     InterfaceRequest<Application> application_request,
     const NativeApplicationOptions& options,
     scoped_ptr<Fetcher> fetcher,
@@ -414,6 +1021,7 @@ void ApplicationManager::RunNativeApplication(
     bool path_exists) {
   TRACE_EVENT_ASYNC_END0("mojo_shell", "ApplicationManager::RetrievePath",
                          fetcher.get());
+  EndStartupPhase("RetrievePath", fetcher->GetURL().spec());
   // We only passed fetcher to keep it alive. Done with it now.
   fetcher.reset();
 
@@ -429,6 +1037,9 @@ void ApplicationManager::RunNativeApplication(
                path.AsUTF8Unsafe());
   NativeRunner* runner = native_runner_factory_->Create(options).release();
   native_runners_.push_back(runner);
+  auto shell_it = identity_to_shell_impl_.find(app_identity);
+  if (shell_it != identity_to_shell_impl_.end())
+    shell_it->second->set_native_runner(runner);
   runner->Start(path, application_request.Pass(),
                 base::Bind(&ApplicationManager::CleanupRunner,
                            weak_ptr_factory_.GetWeakPtr(), runner));
@@ -444,8 +1055,15 @@ void ApplicationManager::RegisterContentHandler(
 
 void ApplicationManager::LoadWithContentHandler(
     const GURL& content_handler_url,
+    const Identity& app_identity,
     InterfaceRequest<Application> application_request,
     mojo::URLResponsePtr url_response) {
+  auto shell_it = identity_to_shell_impl_.find(app_identity);
+  if (shell_it != identity_to_shell_impl_.end()) {
+    shell_it->second->set_content_handler_url(
+        GetBaseURLAndQuery(content_handler_url, nullptr));
+  }
+
   ContentHandlerConnection* connection = nullptr;
   // If two content handler urls differ by query parameter, we want to create a
   // separate connection for each.
@@ -518,9 +1136,11 @@ void ApplicationManager::OnShellImplError(ShellImpl* shell_impl) {
   // Remove the shell.
   auto it = identity_to_shell_impl_.find(identity);
   DCHECK(it != identity_to_shell_impl_.end());
+  ForgetResolvedConnections(shell_impl);
   identity_to_shell_impl_.erase(it);
   if (!on_application_end.is_null())
     on_application_end.Run();
+  RunConnectionsAfterQuit(identity);
 }
 
 void ApplicationManager::OnContentHandlerError(
@@ -551,6 +1171,10 @@ std::vector<std::string> ApplicationManager::GetArgsForURL(const GURL& url) {
 }
 
 void ApplicationManager::CleanupRunner(NativeRunner* runner) {
+  for (const auto& it : identity_to_shell_impl_) {
+    if (it.second->native_runner() == runner)
+      it.second->set_native_runner(nullptr);
+  }
   native_runners_.erase(
       std::find(native_runners_.begin(), native_runners_.end(), runner));
 }
@@ -6,17 +6,27 @@
 #define SHELL_APPLICATION_MANAGER_APPLICATION_MANAGER_H_
 
 #include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
 
+#include "base/callback.h"
+#include "base/files/file_path.h"
 #include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/scoped_vector.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/interfaces/application/application.mojom.h"
 #include "mojo/public/interfaces/application/service_provider.mojom.h"
 #include "mojo/services/network/interfaces/network_service.mojom.h"
 #include "mojo/services/url_response_disk_cache/interfaces/url_response_disk_cache.mojom.h"
 #include "shell/application_manager/application_loader.h"
+#include "shell/application_manager/dependency_graph.h"
 #include "shell/application_manager/identity.h"
 #include "shell/application_manager/native_application_options.h"
 #include "shell/application_manager/native_runner.h"
@@ -24,8 +34,8 @@
 #include "url/gurl.h"
 
 namespace base {
-class FilePath;
-class SequencedWorkerPool;
+class SequencedTaskRunner;
+class WorkStealingPool;
 }
 
 namespace shell {
@@ -52,6 +62,11 @@ class ApplicationManager {
     // |url| if the scheme is not 'mojo'.
     virtual GURL ResolveMojoURL(const GURL& url) = 0;
 
+    // Returns a number that changes whenever the results of ResolveMappings()
+    // or ResolveMojoURL() may change (e.g., when a mapping is added), so that
+    // they can be cached in the meantime.
+    virtual uint64_t GetMappingsVersion() = 0;
+
    protected:
     virtual ~Delegate() {}
   };
@@ -66,6 +81,15 @@ class ApplicationManager {
     static bool HasCreatedInstance();
     // Returns true if there is a ShellImpl for this URL.
     bool HasFactoryForURL(const GURL& url) const;
+    // Sets how long a reaped application is given to quit.
+    void SetQuitTimeout(base::TimeDelta quit_timeout);
+    // Returns true if |url| is being (or has been) preloaded, and hasn't been
+    // connected to since.
+    bool IsPreloading(const GURL& url) const;
+    // Returns true if the preload of |url| has got as far as having a path.
+    bool IsPreloaded(const GURL& url) const;
+    // Returns true if a connection is waiting for the preload of |url|.
+    bool IsWaitingForPreload(const GURL& url) const;
 
    private:
     ApplicationManager* manager_;
@@ -108,9 +132,36 @@ class ApplicationManager {
       scoped_ptr<NativeRunnerFactory> runner_factory) {
     native_runner_factory_ = runner_factory.Pass();
   }
-  void set_blocking_pool(base::SequencedWorkerPool* blocking_pool) {
+  void set_blocking_pool(base::WorkStealingPool* blocking_pool) {
     blocking_pool_ = blocking_pool;
   }
+  // Enables preloading of dependencies: which applications each fetched
+  // application connects to (directly or indirectly) is recorded in a
+  // dependency graph, persisted at |manifest_path| (see |DependencyGraph| for
+  // the format). When an application is started (other than on behalf of
+  // another application), the applications it is known to connect to are
+  // fetched in parallel right away, instead of one after the other as they
+  // get connected to; if |load_libraries| is true, their libraries are also
+  // loaded (on the blocking pool). |manifest_path| is read now, if it exists.
+  // Must be called after |set_blocking_pool()|.
+  void EnablePreloading(const base::FilePath& manifest_path,
+                        bool load_libraries);
+  // Enables reaping of idle applications, i.e., applications that haven't been
+  // connected to for at least |min_idle_time|. When the system signals memory
+  // pressure, or (if |memory_budget| is nonzero) when the estimated memory use
+  // of the running applications exceeds |memory_budget| bytes, idle
+  // applications are asked to quit, least recently used first, until the
+  // estimate is back within the budget (half of it on moderate memory pressure;
+  // all idle applications are reaped on critical memory pressure). A reaped
+  // application is started again on its next connection, once it has quit, or
+  // been dropped for not quitting in time.
+  // Only applications that were fetched (not ones served by loaders) are
+  // reaped, and only if nobody is waiting for them to end, the shell itself
+  // hasn't connected to them (other than to use them as content handlers), and
+  // they aren't running other applications (as content handlers). The memory
+  // use of an application is estimated as the resident set size of its process
+  // if it runs in a process of its own, and as zero otherwise.
+  void EnableIdleReaping(size_t memory_budget, base::TimeDelta min_idle_time);
   // Sets a Loader to be used for a specific url.
   void SetLoaderForURL(scoped_ptr<ApplicationLoader> loader, const GURL& url);
   // Sets a Loader to be used for a specific url scheme.
@@ -141,16 +192,37 @@ class ApplicationManager {
 
  private:
   class ContentHandlerConnection;
+  struct PreloadedApplication;
+
+  // What a requested URL was mapped and resolved to, and the running
+  // application it was last connected to (see |resolved_connections_|).
+  struct ResolvedConnection {
+    ResolvedConnection() : shell_impl(nullptr) {}
+
+    GURL mapped_url;
+    GURL resolved_url;
+    // Null if the application wasn't running (or has gone away since).
+    ShellImpl* shell_impl;
+    // Either |mapped_url| or |resolved_url|, whichever |shell_impl| was found
+    // for.
+    GURL shell_impl_url;
+  };
 
   using URLToLoaderMap = std::map<GURL, scoped_ptr<ApplicationLoader>>;
   using SchemeToLoaderMap =
       std::map<std::string, scoped_ptr<ApplicationLoader>>;
   using IdentityToShellImplMap = std::map<Identity, scoped_ptr<ShellImpl>>;
+  using IdentityToClosuresMap = std::map<Identity, std::vector<base::Closure>>;
   using IdentityToContentHandlerMap =
       std::map<Identity, scoped_ptr<ContentHandlerConnection>>;
   using URLToArgsMap = std::map<GURL, std::vector<std::string>>;
   using MimeTypeToURLMap = std::map<std::string, GURL>;
   using URLToNativeOptionsMap = std::map<GURL, NativeApplicationOptions>;
+  using URLToPreloadedApplicationMap =
+      std::map<GURL, scoped_ptr<PreloadedApplication>>;
+  using FetchCallback = base::Callback<void(scoped_ptr<Fetcher>)>;
+  using ResolvedConnectionMap =
+      std::unordered_map<std::string, ResolvedConnection>;
 
   void ConnectToApplicationWithParameters(
       const GURL& application_url,
@@ -160,7 +232,15 @@ class ApplicationManager {
       const base::Closure& on_application_end,
       const std::vector<std::string>& pre_redirect_parameters);
 
-  bool ConnectToRunningApplication(
+  // Returns the |ResolvedConnection| for |requested_url|, resolving it if it
+  // isn't cached (in which case its |shell_impl| is null). The result is only
+  // valid until the next call, which may clear the cache.
+  ResolvedConnection* ResolveConnection(const GURL& requested_url);
+  // Drops |shell_impl| from |resolved_connections_|.
+  void ForgetResolvedConnections(ShellImpl* shell_impl);
+
+  // Returns the running application that was connected to, if any.
+  ShellImpl* ConnectToRunningApplication(
       const GURL& resolved_url,
       const GURL& requestor_url,
       mojo::InterfaceRequest<mojo::ServiceProvider>* services,
@@ -175,6 +255,69 @@ class ApplicationManager {
       const std::vector<std::string>& parameters,
       ApplicationLoader* loader);
 
+  // Fetches |resolved_url| from the file system or the network.
+  void StartFetch(const GURL& resolved_url, const FetchCallback& callback);
+
+  // Preloading (see |EnablePreloading()|):
+  void RecordDependency(const GURL& requestor_url, const GURL& resolved_url);
+  void PreloadDependencies(const GURL& resolved_url);
+  void OnPreloadFetched(const GURL& url,
+                        PreloadedApplication* preloaded,
+                        scoped_ptr<Fetcher> fetcher);
+  void OnPreloadSniffed(const GURL& url,
+                        PreloadedApplication* preloaded,
+                        scoped_ptr<Fetcher> fetcher,
+                        bool has_content_handler,
+                        const std::string& shebang,
+                        const GURL& content_handler_url);
+  // If a connection is waiting for the preload of |url|, removes the preload
+  // and runs the connection's callback with |fetcher|, and returns true.
+  bool HandOverPreload(const GURL& url,
+                       PreloadedApplication* preloaded,
+                       scoped_ptr<Fetcher>* fetcher);
+  void OnPreloadPathAvailable(const GURL& url,
+                              PreloadedApplication* preloaded,
+                              const base::FilePath& path,
+                              bool path_exists);
+  void OnPreloadLibraryLoaded(const GURL& url,
+                              PreloadedApplication* preloaded,
+                              base::NativeLibrary library);
+  // Returns true if |preloaded| is still the preload in progress for |url|.
+  bool IsCurrentPreload(const GURL& url,
+                        PreloadedApplication* preloaded) const;
+  void DiscardPreload(const GURL& url);
+  // If |resolved_url| is still being fetched for preloading, arranges for
+  // |callback| to get the fetcher instead, and returns true.
+  bool WaitForPreload(const GURL& resolved_url, const FetchCallback& callback);
+  // Starts the application at |resolved_url| from its preloaded library, if
+  // it has been preloaded far enough. Returns true if so.
+  bool ConnectToPreloadedApplication(
+      const GURL& resolved_url,
+      const GURL& requestor_url,
+      mojo::InterfaceRequest<mojo::ServiceProvider>* services,
+      mojo::ServiceProviderPtr* exposed_services,
+      const base::Closure& on_application_end,
+      const std::vector<std::string>& parameters);
+
+  // Idle reaping (see |EnableIdleReaping()|):
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level);
+  void CheckMemoryBudget();
+  // Reaps idle applications, least recently used first, until the estimated
+  // memory use of all applications is at most |target_bytes| (or all of them,
+  // if |target_bytes| is zero).
+  void ReapIdleApplications(size_t target_bytes);
+  bool IsIdleApplication(const ShellImpl* shell_impl,
+                         base::TimeTicks now,
+                         const std::set<GURL>& content_handler_urls) const;
+  void ReapApplication(const Identity& app_identity);
+  // Returns the instance of the application at |url| that is quitting, if
+  // any.
+  ShellImpl* GetQuittingShellImpl(const GURL& url);
+  // Runs the connections to |app_identity| that were held back while its
+  // previous instance was quitting.
+  void RunConnectionsAfterQuit(const Identity& app_identity);
+
   // Creates an Identity for the service identified by |resolved_url|.
   // If |new_process_per_connection| is true for the URL's options, then the
   // identity is unique. Otherwise, repeated invocations with the same
@@ -184,6 +327,7 @@ class ApplicationManager {
                                    bool strip_query = true);
 
   mojo::InterfaceRequest<mojo::Application> RegisterShell(
+      const Identity& app_identity,
       // The URL after resolution and redirects, including the querystring.
       const GURL& resolved_url,
       const GURL& requestor_url,
@@ -192,6 +336,8 @@ class ApplicationManager {
       const base::Closure& on_application_end,
       const std::vector<std::string>& parameters);
 
+  // Returns the running instance of the application at |url|, if any. An
+  // instance that is quitting doesn't count.
   ShellImpl* GetShellImpl(const GURL& url);
 
   void ConnectToClient(ShellImpl* shell_impl,
@@ -200,7 +346,10 @@ class ApplicationManager {
                        mojo::InterfaceRequest<mojo::ServiceProvider> services,
                        mojo::ServiceProviderPtr exposed_services);
 
+  // |resolved_url| is the URL the fetch was started for, which may differ from
+  // |fetcher->GetURL()|.
   void HandleFetchCallback(
+      const GURL& resolved_url,
       const GURL& requestor_url,
       mojo::InterfaceRequest<mojo::ServiceProvider> services,
       mojo::ServiceProviderPtr exposed_services,
@@ -208,7 +357,16 @@ class ApplicationManager {
       const std::vector<std::string>& parameters,
       scoped_ptr<Fetcher> fetcher);
 
+  void OnContentHandlerSniffed(
+      const Identity& app_identity,
+      mojo::InterfaceRequest<mojo::Application> request,
+      scoped_ptr<Fetcher> fetcher,
+      bool has_content_handler,
+      const std::string& shebang,
+      const GURL& content_handler_url);
+
   void RunNativeApplication(
+      const Identity& app_identity,
       mojo::InterfaceRequest<mojo::Application> application_request,
       const NativeApplicationOptions& options,
       scoped_ptr<Fetcher> fetcher,
@@ -217,6 +375,7 @@ class ApplicationManager {
 
   void LoadWithContentHandler(
       const GURL& content_handler_url,
+      const Identity& app_identity,
       mojo::InterfaceRequest<mojo::Application> application_request,
       mojo::URLResponsePtr url_response);
 
@@ -242,18 +401,49 @@ class ApplicationManager {
   scoped_ptr<NativeRunnerFactory> native_runner_factory_;
 
   IdentityToShellImplMap identity_to_shell_impl_;
+  // Keyed by the spec of requested URLs, so that repeated connections to a
+  // running application don't go through the delegate's mappings and the
+  // (|GURL|-keyed) maps above. Cleared when the delegate's mappings change,
+  // i.e., when |GetMappingsVersion()| doesn't return |mappings_version_|.
+  ResolvedConnectionMap resolved_connections_;
+  uint64_t mappings_version_;
   IdentityToContentHandlerMap identity_to_content_handler_;
   URLToArgsMap url_to_args_;
   // Note: The keys are URLs after mapping and resolving.
   URLToNativeOptionsMap url_to_native_options_;
 
-  base::SequencedWorkerPool* blocking_pool_;
+  base::WorkStealingPool* blocking_pool_;
   mojo::URLResponseDiskCachePtr url_response_disk_cache_;
   mojo::NetworkServicePtr network_service_;
   mojo::NetworkServicePtr authenticating_network_service_;
   MimeTypeToURLMap mime_type_to_url_;
   ScopedVector<NativeRunner> native_runners_;
   bool initialized_authentication_interceptor_;
+
+  // Preloading state; |preload_task_runner_| is null if preloading isn't
+  // enabled.
+  scoped_refptr<base::SequencedTaskRunner> preload_task_runner_;
+  base::FilePath preload_manifest_path_;
+  bool preload_libraries_;
+  DependencyGraph dependency_graph_;
+  // Keyed by resolved URL (without query).
+  URLToPreloadedApplicationMap preloaded_applications_;
+
+  // Idle reaping state; |memory_pressure_listener_| is null if reaping isn't
+  // enabled.
+  scoped_ptr<base::MemoryPressureListener> memory_pressure_listener_;
+  size_t idle_memory_budget_;
+  base::TimeDelta min_idle_time_;
+  base::RepeatingTimer<ApplicationManager> memory_budget_timer_;
+  // How long a reaped application is given to quit.
+  base::TimeDelta quit_timeout_;
+  // Connections made to applications while they were quitting. A new instance
+  // is only started once the old one is gone.
+  IdentityToClosuresMap connections_after_quit_;
+  // Totals, reported as trace counters.
+  uint64_t num_reaped_applications_;
+  uint64_t reaped_bytes_;
+
   base::WeakPtrFactory<ApplicationManager> weak_ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(ApplicationManager);
@@ -2,11 +2,20 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+
 #include "base/at_exit.h"
 #include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/scoped_vector.h"
 #include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/work_stealing_pool.h"
+#include "base/time/time.h"
 #include "mojo/public/cpp/application/application_connection.h"
 #include "mojo/public/cpp/application/application_delegate.h"
 #include "mojo/public/cpp/application/application_impl.h"
@@ -15,6 +24,9 @@
 #include "mojo/public/interfaces/application/service_provider.mojom.h"
 #include "shell/application_manager/application_loader.h"
 #include "shell/application_manager/application_manager.h"
+#include "shell/application_manager/dependency_graph.h"
+#include "shell/application_manager/native_application_options.h"
+#include "shell/application_manager/native_runner.h"
 #include "shell/application_manager/test.mojom.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -384,7 +396,12 @@ class Tester : public ApplicationDelegate,
 
 class TestDelegate : public ApplicationManager::Delegate {
  public:
-  void AddMapping(const GURL& from, const GURL& to) { mappings_[from] = to; }
+  TestDelegate() : mappings_version_(0) {}
+
+  void AddMapping(const GURL& from, const GURL& to) {
+    mappings_[from] = to;
+    mappings_version_++;
+  }
 
   // ApplicationManager::Delegate
   GURL ResolveMappings(const GURL& url) override {
@@ -403,9 +420,11 @@ class TestDelegate : public ApplicationManager::Delegate {
     }
     return mapped_url;
   }
+  uint64_t GetMappingsVersion() override { return mappings_version_; }
 
  private:
   std::map<GURL, GURL> mappings_;
+  uint64_t mappings_version_;
 };
 
 class TestExternal : public ApplicationDelegate {
@@ -810,6 +829,43 @@ TEST_F(ApplicationManagerTest, MappedURLsShouldWorkWithLoaders) {
   custom_loader->set_context(nullptr);
 }
 
+TEST_F(ApplicationManagerTest, ConnectionsFollowMappingChanges) {
+  // 1 because ApplicationManagerTest connects once at startup.
+  EXPECT_EQ(1, test_loader_->num_loads());
+
+  TestServicePtr test_service;
+  application_manager_->ConnectToService(GURL("foo:foo"), &test_service);
+  EXPECT_EQ(2, test_loader_->num_loads());
+  application_manager_->ConnectToService(GURL("foo:foo"), &test_service);
+  EXPECT_EQ(2, test_loader_->num_loads());
+
+  // foo:foo now connects to another application.
+  test_delegate_.AddMapping(GURL("foo:foo"), GURL("foo:bar"));
+  application_manager_->ConnectToService(GURL("foo:foo"), &test_service);
+  EXPECT_EQ(3, test_loader_->num_loads());
+  application_manager_->ConnectToService(GURL("foo:bar"), &test_service);
+  EXPECT_EQ(3, test_loader_->num_loads());
+}
+
+// Measures repeated connections to a running application (as made by services
+// that connect to others for each request they handle).
+TEST_F(ApplicationManagerTest, ConnectToRunningApplicationPerf) {
+  const int kNumConnections = 100000;
+  const GURL url("mojo:perf");
+  test_delegate_.AddMapping(url, GURL(kTestURLString));
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumConnections; i++) {
+    application_manager_->ConnectToApplication(url, GURL(), nullptr, nullptr,
+                                               base::Closure());
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  EXPECT_EQ(1, test_loader_->num_loads());
+  LOG(INFO) << kNumConnections << " connections to a running application: "
+            << elapsed.InMicroseconds() / static_cast<double>(kNumConnections)
+            << " us/connection";
+}
+
 TEST_F(ApplicationManagerTest, TestQueryWithLoaders) {
   TestApplicationLoader* url_loader = new TestApplicationLoader;
   TestApplicationLoader* scheme_loader = new TestApplicationLoader;
@@ -845,5 +901,230 @@ TEST_F(ApplicationManagerTest, TestEndApplicationClosure) {
   EXPECT_TRUE(called);
 }
 
+// Preloading ------------------------------------------------------------------
+
+// Records the applications started by PreloadTestNativeRunners.
+struct PreloadTestState {
+  std::vector<base::FilePath> started_app_paths;
+  // The applications' ends of their pipes, kept open as if they were running.
+  ScopedVector<InterfaceRequest<Application>> application_requests;
+  // Called when a runner is started, if not null.
+  base::Closure runner_started_callback;
+};
+
+class PreloadTestNativeRunner : public NativeRunner {
+ public:
+  explicit PreloadTestNativeRunner(PreloadTestState* state) : state_(state) {}
+  ~PreloadTestNativeRunner() override {}
+
+  void Start(const base::FilePath& app_path,
+             InterfaceRequest<Application> application_request,
+             const base::Closure& app_completed_callback) override {
+    state_->started_app_paths.push_back(app_path);
+    state_->application_requests.push_back(
+        new InterfaceRequest<Application>(application_request.Pass()));
+    if (!state_->runner_started_callback.is_null())
+      state_->runner_started_callback.Run();
+  }
+
+ private:
+  PreloadTestState* state_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreloadTestNativeRunner);
+};
+
+class PreloadTestNativeRunnerFactory : public NativeRunnerFactory {
+ public:
+  explicit PreloadTestNativeRunnerFactory(PreloadTestState* state)
+      : state_(state) {}
+  ~PreloadTestNativeRunnerFactory() override {}
+
+  scoped_ptr<NativeRunner> Create(
+      const NativeApplicationOptions& options) override {
+    return make_scoped_ptr(new PreloadTestNativeRunner(state_));
+  }
+
+ private:
+  PreloadTestState* state_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreloadTestNativeRunnerFactory);
+};
+
+// Runs two file: applications, A and B, where A connects to B, with preloading
+// enabled (but without loading the libraries).
+class ApplicationManagerPreloadTest : public testing::Test {
+ public:
+  ApplicationManagerPreloadTest()
+      : blocking_pool_(new base::WorkStealingPool(2, "blocking_pool")),
+        application_manager_(ApplicationManager::Options(), &test_delegate_),
+        test_api_(&application_manager_) {}
+  ~ApplicationManagerPreloadTest() override {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    manifest_path_ = temp_dir_.path().AppendASCII("preload_manifest.json");
+    app_a_path_ = CreateApplication("a.mojo");
+    app_b_path_ = CreateApplication("b.mojo");
+    app_a_url_ = FilePathToURL(app_a_path_);
+    app_b_url_ = FilePathToURL(app_b_path_);
+
+    application_manager_.set_native_runner_factory(
+        make_scoped_ptr(new PreloadTestNativeRunnerFactory(&state_)));
+    application_manager_.set_blocking_pool(blocking_pool_.get());
+  }
+
+  void TearDown() override { blocking_pool_->Shutdown(); }
+
+ protected:
+  static GURL FilePathToURL(const base::FilePath& path) {
+    return GURL("file://" + path.value());
+  }
+
+  // The contents don't matter, since the applications are never loaded.
+  base::FilePath CreateApplication(const std::string& name) {
+    const char kContents[] = "not really a library";
+    base::FilePath path = temp_dir_.path().AppendASCII(name);
+    EXPECT_EQ(static_cast<int>(sizeof(kContents)),
+              base::WriteFile(path, kContents, sizeof(kContents)));
+    return path;
+  }
+
+  void WriteManifest(const DependencyGraph& graph) {
+    std::string json = graph.Serialize();
+    ASSERT_EQ(static_cast<int>(json.size()),
+              base::WriteFile(manifest_path_, json.data(), json.size()));
+  }
+
+  void Connect(const GURL& url, const GURL& requestor_url) {
+    mojo::ServiceProviderPtr services;
+    application_manager_.ConnectToApplication(
+        url, requestor_url, mojo::GetProxy(&services), nullptr,
+        base::Closure());
+  }
+
+  // Runs the loop until |num_runners| runners have been started in total.
+  void WaitForRunnerStarts(size_t num_runners) {
+    while (state_.started_app_paths.size() < num_runners) {
+      base::RunLoop run_loop;
+      state_.runner_started_callback = run_loop.QuitClosure();
+      run_loop.Run();
+      state_.runner_started_callback.Reset();
+    }
+  }
+
+  // Preloads are fetched and sniffed on the blocking pool, so running the
+  // tasks pending on the loop isn't enough to wait for them.
+  void WaitForPreloadToSettle(const GURL& url) {
+    while (test_api_.IsPreloading(url) && !test_api_.IsPreloaded(url)) {
+      base::RunLoop().RunUntilIdle();
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+    }
+  }
+
+  bool WasStarted(const base::FilePath& path) const {
+    return std::find(state_.started_app_paths.begin(),
+                     state_.started_app_paths.end(),
+                     path) != state_.started_app_paths.end();
+  }
+
+  base::MessageLoop loop_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath manifest_path_;
+  base::FilePath app_a_path_;
+  base::FilePath app_b_path_;
+  GURL app_a_url_;
+  GURL app_b_url_;
+  scoped_refptr<base::WorkStealingPool> blocking_pool_;
+  TestDelegate test_delegate_;
+  PreloadTestState state_;
+  ApplicationManager application_manager_;
+  ApplicationManager::TestAPI test_api_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ApplicationManagerPreloadTest);
+};
+
+TEST_F(ApplicationManagerPreloadTest, ManifestPreloadsDependencies) {
+  DependencyGraph graph;
+  graph.AddDependency(app_a_url_, app_b_url_);
+  WriteManifest(graph);
+  application_manager_.EnablePreloading(manifest_path_, false);
+
+  // Connecting to A starts preloading B, which A is known to connect to.
+  Connect(app_a_url_, GURL());
+  EXPECT_TRUE(test_api_.IsPreloading(app_b_url_));
+  WaitForPreloadToSettle(app_b_url_);
+  ASSERT_TRUE(test_api_.IsPreloaded(app_b_url_));
+
+  // B is then started right away from its preloaded path.
+  size_t num_started = state_.started_app_paths.size();
+  Connect(app_b_url_, app_a_url_);
+  ASSERT_EQ(num_started + 1, state_.started_app_paths.size());
+  EXPECT_EQ(app_b_path_, state_.started_app_paths.back());
+  EXPECT_FALSE(test_api_.IsPreloading(app_b_url_));
+
+  WaitForRunnerStarts(2);
+  EXPECT_TRUE(WasStarted(app_a_path_));
+}
+
+TEST_F(ApplicationManagerPreloadTest, ConnectWhilePreloading) {
+  DependencyGraph graph;
+  graph.AddDependency(app_a_url_, app_b_url_);
+  WriteManifest(graph);
+  application_manager_.EnablePreloading(manifest_path_, false);
+
+  // B is still being sniffed (on the blocking pool) when A connects to it, so
+  // the connection waits for the preload rather than fetching B again.
+  Connect(app_a_url_, GURL());
+  Connect(app_b_url_, app_a_url_);
+  EXPECT_TRUE(test_api_.IsWaitingForPreload(app_b_url_));
+
+  WaitForRunnerStarts(2);
+  EXPECT_TRUE(WasStarted(app_a_path_));
+  EXPECT_TRUE(WasStarted(app_b_path_));
+  EXPECT_FALSE(test_api_.IsPreloading(app_b_url_));
+}
+
+TEST_F(ApplicationManagerPreloadTest, StaleManifest) {
+  // The manifest refers to an application that no longer exists.
+  GURL app_c_url(FilePathToURL(temp_dir_.path().AppendASCII("c.mojo")));
+  DependencyGraph graph;
+  graph.AddDependency(app_a_url_, app_c_url);
+  WriteManifest(graph);
+  application_manager_.EnablePreloading(manifest_path_, false);
+
+  Connect(app_a_url_, GURL());
+  WaitForPreloadToSettle(app_c_url);
+  EXPECT_FALSE(test_api_.IsPreloading(app_c_url));
+
+  WaitForRunnerStarts(1);
+  EXPECT_EQ(app_a_path_, state_.started_app_paths[0]);
+}
+
+TEST_F(ApplicationManagerPreloadTest, MissingManifest) {
+  application_manager_.EnablePreloading(manifest_path_, false);
+
+  // Nothing is known about A yet, so nothing is preloaded.
+  Connect(app_a_url_, GURL());
+  EXPECT_FALSE(test_api_.IsPreloading(app_b_url_));
+  WaitForRunnerStarts(1);
+
+  // B is fetched as usual, and the dependency is recorded in a new manifest.
+  Connect(app_b_url_, app_a_url_);
+  WaitForRunnerStarts(2);
+  EXPECT_EQ(app_b_path_, state_.started_app_paths[1]);
+
+  std::string json;
+  while (!base::ReadFileToString(manifest_path_, &json) || json.empty()) {
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+  }
+  DependencyGraph graph;
+  ASSERT_TRUE(graph.Deserialize(json));
+  std::vector<GURL> dependencies =
+      graph.GetTransitiveDependencies(app_a_url_);
+  ASSERT_EQ(1u, dependencies.size());
+  EXPECT_EQ(app_b_url_, dependencies[0]);
+}
+
 }  // namespace
 }  // namespace shell
@@ -7,7 +7,12 @@
 #include <stdint.h>
 
 #include "base/bind.h"
+#include "base/callback.h"
+#include "base/location.h"
 #include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/timer/timer.h"
+#include "mojo/message_pump/handle_watcher.h"
 
 namespace shell {
 
@@ -109,10 +114,124 @@ bool BlockingPeekHelper(mojo::DataPipeConsumerHandle source,
   return false;
 }
 
-PeekStatus PeekLine(size_t max_line_length,
-                    const void* buffer,
-                    uint32_t buffer_num_bytes,
-                    std::string* line) {
+// The asynchronous counterpart of |BlockingPeekHelper()|. Instead of sleeping,
+// it watches |source| while no data is available, and polls it (every
+// |kRetryDelayMicros|) while some is but not enough for |peek_func|. Unlike
+// |PeekSleeper|, it gives up as soon as the producer is known to have been
+// closed before all of the data was read. It owns itself, and deletes itself
+// once it has called |callback|.
+class AsyncPeekHelper {
+ public:
+  AsyncPeekHelper(mojo::ScopedDataPipeConsumerHandle source,
+                  MojoDeadline timeout,
+                  PeekFunc peek_func,
+                  const PeekCallback& callback)
+      : source_(source.Pass()),
+        deadline_((timeout == MOJO_DEADLINE_INDEFINITE)
+                      ? 0
+                      : 1 + mojo::GetTimeTicksNow() +
+                            static_cast<MojoTimeTicks>(timeout)),
+        peek_func_(peek_func),
+        callback_(callback) {
+    base::MessageLoop::current()->PostTask(
+        FROM_HERE,
+        base::Bind(&AsyncPeekHelper::TryPeek, base::Unretained(this)));
+  }
+
+ private:
+  static const MojoTimeTicks kRetryDelayMicros = 1000 * 10;  // 10 ms
+
+  ~AsyncPeekHelper() {}
+
+  bool DeadlineExceeded() const {
+    return deadline_ != 0 && mojo::GetTimeTicksNow() >= deadline_;
+  }
+
+  void TryPeek() {
+    // If the producer was closed before reading, no more data will come.
+    bool producer_closed =
+        Wait(source_.get(), MOJO_HANDLE_SIGNAL_PEER_CLOSED, 0, nullptr) ==
+        MOJO_RESULT_OK;
+
+    const void* buffer;
+    uint32_t num_bytes;
+    MojoResult result = BeginReadDataRaw(source_.get(), &buffer, &num_bytes,
+                                         MOJO_READ_DATA_FLAG_NONE);
+    if (result == MOJO_RESULT_SHOULD_WAIT) {
+      if (DeadlineExceeded()) {
+        Finish(false);
+        return;
+      }
+      watcher_.Start(
+          source_.get(), MOJO_HANDLE_SIGNAL_READABLE,
+          deadline_ ? static_cast<MojoDeadline>(deadline_ -
+                                                mojo::GetTimeTicksNow())
+                    : MOJO_DEADLINE_INDEFINITE,
+          base::Bind(&AsyncPeekHelper::OnHandleReady, base::Unretained(this)));
+      return;
+    }
+    if (result != MOJO_RESULT_OK) {
+      Finish(false);
+      return;
+    }
+
+    PeekStatus status = peek_func_.Run(buffer, num_bytes, &value_);
+    CHECK_EQ(EndReadDataRaw(source_.get(), 0), MOJO_RESULT_OK);
+    switch (status) {
+      case PeekStatus::kSuccess:
+        Finish(true);
+        return;
+      case PeekStatus::kFail:
+        Finish(false);
+        return;
+      case PeekStatus::kKeepReading:
+        break;
+    }
+
+    // Readability doesn't tell whether more data has arrived, so poll.
+    if (producer_closed || DeadlineExceeded()) {
+      Finish(false);
+      return;
+    }
+    retry_timer_.Start(FROM_HERE,
+                       base::TimeDelta::FromMicroseconds(kRetryDelayMicros),
+                       this, &AsyncPeekHelper::TryPeek);
+  }
+
+  void OnHandleReady(MojoResult result) {
+    if (result != MOJO_RESULT_OK) {
+      Finish(false);
+      return;
+    }
+    TryPeek();
+  }
+
+  void Finish(bool success) {
+    PeekCallback callback = callback_;
+    std::string value = success ? value_ : std::string();
+    mojo::ScopedDataPipeConsumerHandle source = source_.Pass();
+    delete this;
+    callback.Run(success, value, source.Pass());
+  }
+
+  mojo::ScopedDataPipeConsumerHandle source_;
+  const MojoTimeTicks deadline_;  // 0 => MOJO_DEADLINE_INDEFINITE
+  const base::Callback<PeekStatus(const void*, uint32_t, std::string*)>
+      peek_func_;
+  const PeekCallback callback_;
+  std::string value_;
+  mojo::common::HandleWatcher watcher_;
+  base::OneShotTimer<AsyncPeekHelper> retry_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncPeekHelper);
+};
+
+const MojoTimeTicks AsyncPeekHelper::kRetryDelayMicros;
+
+PeekStatus PeekLineInBuffer(size_t max_line_length,
+                            const void* buffer,
+                            uint32_t buffer_num_bytes,
+                            std::string* line) {
   const char* p = static_cast<const char*>(buffer);
   size_t max_p_index = std::min<size_t>(buffer_num_bytes, max_line_length);
   for (size_t i = 0; i < max_p_index; i++) {
@@ -125,10 +244,10 @@ PeekStatus PeekLine(size_t max_line_length,
                                                : PeekStatus::kKeepReading;
 }
 
-PeekStatus PeekNBytes(size_t bytes_length,
-                      const void* buffer,
-                      uint32_t buffer_num_bytes,
-                      std::string* bytes) {
+PeekStatus PeekNBytesInBuffer(size_t bytes_length,
+                              const void* buffer,
+                              uint32_t buffer_num_bytes,
+                              std::string* bytes) {
   if (buffer_num_bytes >= bytes_length) {
     const char* p = static_cast<const char*>(buffer);
     *bytes = std::string(p, bytes_length);
@@ -143,7 +262,7 @@ bool BlockingPeekNBytes(mojo::DataPipeConsumerHandle source,
                         std::string* bytes,
                         size_t bytes_length,
                         MojoDeadline timeout) {
-  PeekFunc peek_nbytes = base::Bind(PeekNBytes, bytes_length);
+  PeekFunc peek_nbytes = base::Bind(PeekNBytesInBuffer, bytes_length);
   return BlockingPeekHelper(source, bytes, timeout, peek_nbytes);
 }
 
@@ -151,8 +270,24 @@ bool BlockingPeekLine(mojo::DataPipeConsumerHandle source,
                       std::string* line,
                       size_t max_line_length,
                       MojoDeadline timeout) {
-  PeekFunc peek_line = base::Bind(PeekLine, max_line_length);
+  PeekFunc peek_line = base::Bind(PeekLineInBuffer, max_line_length);
   return BlockingPeekHelper(source, line, timeout, peek_line);
 }
 
+void PeekNBytes(mojo::ScopedDataPipeConsumerHandle source,
+                size_t bytes_length,
+                MojoDeadline timeout,
+                const PeekCallback& callback) {
+  new AsyncPeekHelper(source.Pass(), timeout,
+                      base::Bind(PeekNBytesInBuffer, bytes_length), callback);
+}
+
+void PeekLine(mojo::ScopedDataPipeConsumerHandle source,
+              size_t max_line_length,
+              MojoDeadline timeout,
+              const PeekCallback& callback) {
+  new AsyncPeekHelper(source.Pass(), timeout,
+                      base::Bind(PeekLineInBuffer, max_line_length), callback);
+}
+
 }  // namespace shell
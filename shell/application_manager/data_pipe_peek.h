@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "base/callback_forward.h"
 #include "mojo/public/cpp/system/core.h"
 
 namespace shell {
@@ -31,6 +32,27 @@ bool BlockingPeekNBytes(mojo::DataPipeConsumerHandle source,
                         size_t bytes_length,
                         MojoDeadline timeout);
 
+// Called with true and the line (or bytes) peeked at, or false, and the data
+// pipe that was peeked at (none of its data has been consumed).
+typedef base::Callback<
+    void(bool, const std::string&, mojo::ScopedDataPipeConsumerHandle)>
+    PeekCallback;
+
+// Asynchronous versions of the functions above, which don't block the calling
+// thread while waiting for data: the data pipe is watched using the current
+// thread's message loop, and |callback| is called on it (never synchronously)
+// once the line (or bytes) are available, or with false if they never will be
+// (e.g., because the producer was closed) or the timeout is exceeded. Any
+// number of these may be in progress at the same time.
+void PeekLine(mojo::ScopedDataPipeConsumerHandle source,
+              size_t max_line_length,
+              MojoDeadline timeout,
+              const PeekCallback& callback);
+void PeekNBytes(mojo::ScopedDataPipeConsumerHandle source,
+                size_t bytes_length,
+                MojoDeadline timeout,
+                const PeekCallback& callback);
+
 }  // namespace shell
 
 #endif  // SHELL_APPLICATION_MANAGER_DATA_PIPE_SEEK_H_
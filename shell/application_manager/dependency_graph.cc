@@ -0,0 +1,94 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/application_manager/dependency_graph.h"
+
+#include <deque>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/values.h"
+
+namespace shell {
+
+DependencyGraph::DependencyGraph() {}
+
+DependencyGraph::~DependencyGraph() {}
+
+bool DependencyGraph::AddDependency(const GURL& from, const GURL& to) {
+  DCHECK(from.is_valid());
+  DCHECK(to.is_valid());
+  if (from == to)
+    return false;
+  return dependencies_[from].insert(to).second;
+}
+
+std::vector<GURL> DependencyGraph::GetTransitiveDependencies(
+    const GURL& root) const {
+  std::vector<GURL> result;
+  std::set<GURL> visited;
+  visited.insert(root);
+  std::deque<GURL> queue(1, root);
+  // Breadth-first, so that direct dependencies come first.
+  while (!queue.empty()) {
+    auto it = dependencies_.find(queue.front());
+    queue.pop_front();
+    if (it == dependencies_.end())
+      continue;
+    for (const GURL& dependency : it->second) {
+      if (!visited.insert(dependency).second)
+        continue;
+      result.push_back(dependency);
+      queue.push_back(dependency);
+    }
+  }
+  return result;
+}
+
+bool DependencyGraph::Deserialize(const std::string& json) {
+  dependencies_.clear();
+
+  scoped_ptr<base::Value> value = base::JSONReader::Read(json);
+  const base::DictionaryValue* dictionary = nullptr;
+  if (!value || !value->GetAsDictionary(&dictionary))
+    return false;
+
+  for (base::DictionaryValue::Iterator it(*dictionary); !it.IsAtEnd();
+       it.Advance()) {
+    GURL from(it.key());
+    const base::ListValue* list = nullptr;
+    if (!from.is_valid() || !it.value().GetAsList(&list)) {
+      dependencies_.clear();
+      return false;
+    }
+    for (size_t i = 0; i < list->GetSize(); i++) {
+      std::string to_spec;
+      GURL to;
+      if (list->GetString(i, &to_spec))
+        to = GURL(to_spec);
+      if (!to.is_valid()) {
+        dependencies_.clear();
+        return false;
+      }
+      AddDependency(from, to);
+    }
+  }
+  return true;
+}
+
+std::string DependencyGraph::Serialize() const {
+  base::DictionaryValue dictionary;
+  for (const auto& entry : dependencies_) {
+    scoped_ptr<base::ListValue> list(new base::ListValue());
+    for (const GURL& to : entry.second)
+      list->AppendString(to.spec());
+    dictionary.SetWithoutPathExpansion(entry.first.spec(), list.Pass());
+  }
+  std::string json;
+  base::JSONWriter::Write(dictionary, &json);
+  return json;
+}
+
+}  // namespace shell
@@ -0,0 +1,54 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SHELL_APPLICATION_MANAGER_DEPENDENCY_GRAPH_H_
+#define SHELL_APPLICATION_MANAGER_DEPENDENCY_GRAPH_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "url/gurl.h"
+
+namespace shell {
+
+// Records which applications connect to which other applications, so that the
+// dependencies of an application can be fetched and loaded ahead of time the
+// next time it is started. URLs are resolved URLs, without query.
+//
+// The graph is serialized as a JSON dictionary mapping each application URL to
+// the list of URLs of the applications it connects to, e.g.:
+//   {"https://example.com/a.mojo": ["https://example.com/b.mojo"]}
+// This is also the format of a hand-written preload manifest.
+class DependencyGraph {
+ public:
+  DependencyGraph();
+  ~DependencyGraph();
+
+  // Records that |from| connects to |to|. Returns true if this wasn't known
+  // yet.
+  bool AddDependency(const GURL& from, const GURL& to);
+
+  // Returns the applications that |root| connects to, directly or indirectly,
+  // nearest first. |root| itself is not included.
+  std::vector<GURL> GetTransitiveDependencies(const GURL& root) const;
+
+  // Replaces the contents of the graph with that of |json|. Returns false (and
+  // leaves the graph empty) if |json| isn't in the format described above.
+  bool Deserialize(const std::string& json);
+  std::string Serialize() const;
+
+  bool empty() const { return dependencies_.empty(); }
+
+ private:
+  std::map<GURL, std::set<GURL>> dependencies_;
+
+  DISALLOW_COPY_AND_ASSIGN(DependencyGraph);
+};
+
+}  // namespace shell
+
+#endif  // SHELL_APPLICATION_MANAGER_DEPENDENCY_GRAPH_H_
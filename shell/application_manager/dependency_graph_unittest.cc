@@ -0,0 +1,68 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/application_manager/dependency_graph.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace shell {
+namespace {
+
+const char kA[] = "https://example.com/a.mojo";
+const char kB[] = "https://example.com/b.mojo";
+const char kC[] = "https://example.com/c.mojo";
+const char kD[] = "https://example.com/d.mojo";
+
+TEST(DependencyGraph, AddDependency) {
+  DependencyGraph graph;
+  EXPECT_TRUE(graph.empty());
+  EXPECT_TRUE(graph.AddDependency(GURL(kA), GURL(kB)));
+  EXPECT_FALSE(graph.AddDependency(GURL(kA), GURL(kB)));
+  EXPECT_FALSE(graph.AddDependency(GURL(kA), GURL(kA)));
+  EXPECT_FALSE(graph.empty());
+}
+
+TEST(DependencyGraph, TransitiveDependencies) {
+  DependencyGraph graph;
+  graph.AddDependency(GURL(kA), GURL(kB));
+  graph.AddDependency(GURL(kB), GURL(kC));
+  graph.AddDependency(GURL(kA), GURL(kD));
+  // A cycle shouldn't be a problem.
+  graph.AddDependency(GURL(kC), GURL(kA));
+
+  std::vector<GURL> dependencies = graph.GetTransitiveDependencies(GURL(kA));
+  ASSERT_EQ(3u, dependencies.size());
+  // Direct dependencies first.
+  EXPECT_EQ(GURL(kB), dependencies[0]);
+  EXPECT_EQ(GURL(kD), dependencies[1]);
+  EXPECT_EQ(GURL(kC), dependencies[2]);
+
+  EXPECT_TRUE(graph.GetTransitiveDependencies(GURL(kD)).empty());
+}
+
+TEST(DependencyGraph, Serialization) {
+  DependencyGraph graph;
+  graph.AddDependency(GURL(kA), GURL(kB));
+  graph.AddDependency(GURL(kB), GURL(kC));
+
+  DependencyGraph copy;
+  ASSERT_TRUE(copy.Deserialize(graph.Serialize()));
+  std::vector<GURL> dependencies = copy.GetTransitiveDependencies(GURL(kA));
+  ASSERT_EQ(2u, dependencies.size());
+  EXPECT_EQ(GURL(kB), dependencies[0]);
+  EXPECT_EQ(GURL(kC), dependencies[1]);
+}
+
+TEST(DependencyGraph, InvalidManifest) {
+  DependencyGraph graph;
+  EXPECT_FALSE(graph.Deserialize("not json"));
+  EXPECT_FALSE(graph.Deserialize("[]"));
+  EXPECT_FALSE(graph.Deserialize("{\"not a url\": []}"));
+  EXPECT_FALSE(graph.Deserialize(std::string("{\"") + kA + "\": [42]}"));
+  EXPECT_TRUE(graph.empty());
+  EXPECT_TRUE(graph.Deserialize(std::string("{\"") + kA + "\": []}"));
+}
+
+}  // namespace
+}  // namespace shell
@@ -4,57 +4,177 @@
 
 #include "shell/application_manager/fetcher.h"
 
+#include <string.h>
+
+#include <limits>
+
+#include "base/bind.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/task_runner_util.h"
+#include "build/build_config.h"
+#include "mojo/data_pipe_utils/data_pipe_utils.h"
+#include "mojo/edk/embedder/embedder.h"
+#include "mojo/edk/platform/scoped_platform_handle.h"
+#include "mojo/public/cpp/system/data_pipe.h"
+#include "shell/application_manager/data_pipe_peek.h"
+#include "shell/startup_timeline.h"
 #include "url/gurl.h"
 
 namespace shell {
 
 namespace {
+
 const char kMojoMagic[] = "#!mojo ";
 const size_t kMaxShebangLength = 2048;
+// Reading the first line of a file should never take that long.
+const MojoDeadline kPeekFirstLineTimeout = 10 * 1000 * 1000;  // 10 s
+
+void IgnoreResult(bool result) {
 }
 
-Fetcher::Fetcher(const FetchCallback& loader_callback)
-    : loader_callback_(loader_callback) {
+bool ReadMojoMagic(const base::FilePath& path) {
+  std::string magic;
+  base::ReadFileToString(path, &magic, strlen(kMojoMagic));
+  return magic == kMojoMagic;
 }
 
-Fetcher::~Fetcher() {
+void OnFirstLinePeeked(
+    const base::Callback<void(bool, const std::string&)>& callback,
+    bool success,
+    const std::string& line,
+    mojo::ScopedDataPipeConsumerHandle source) {
+  // Dropping |source| stops the copy of the rest of the file.
+  callback.Run(success, line);
 }
 
-bool Fetcher::PeekContentHandler(std::string* mojo_shebang,
-                                 GURL* mojo_content_handler_url) {
-  // TODO(aa): I guess this should just go in ApplicationManager now.
-  std::string shebang;
-  if (HasMojoMagic() && PeekFirstLine(&shebang)) {
+void OnFirstLineForContentHandler(
+    const std::string& url,
+    const Fetcher::ContentHandlerCallback& callback,
+    bool success,
+    const std::string& shebang) {
+  EndStartupPhase("SniffContentHandler", url);
+  if (success && shebang.compare(0, strlen(kMojoMagic), kMojoMagic) == 0) {
     GURL url(shebang.substr(arraysize(kMojoMagic) - 1, std::string::npos));
     if (url.is_valid()) {
-      *mojo_shebang = shebang;
-      *mojo_content_handler_url = url;
-      return true;
+      callback.Run(true, shebang, url);
+      return;
     }
   }
-  return false;
+  callback.Run(false, std::string(), GURL());
+}
+
+void OnMojoMagicForContentHandler(
+    Fetcher* fetcher,
+    scoped_refptr<base::TaskRunner> task_runner,
+    const std::string& url,
+    const Fetcher::ContentHandlerCallback& callback,
+    bool has_mojo_magic) {
+  if (!has_mojo_magic) {
+    OnFirstLineForContentHandler(url, callback, false, std::string());
+    return;
+  }
+  fetcher->PeekFirstLine(
+      task_runner.get(),
+      base::Bind(&OnFirstLineForContentHandler, url, callback));
+}
+
+// Does the blocking part of |Fetcher::SetBodyBuffer()|.
+void CreateBodyBuffer(const base::FilePath& path,
+                      uint32_t skip,
+                      mojo::URLResponse* response) {
+#if defined(OS_ANDROID)
+  // Shared buffers have to be ashmem regions, not regular files.
+  return;
+#else
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid())
+    return;
+  int64_t length = file.GetLength();
+  if (length <= static_cast<int64_t>(skip) ||
+      static_cast<uint64_t>(length) > std::numeric_limits<size_t>::max())
+    return;
+
+  MojoHandle handle = MOJO_HANDLE_INVALID;
+  if (mojo::embedder::CreateSharedBufferFromFile(
+          mojo::platform::ScopedPlatformHandle(
+              mojo::platform::PlatformHandle(file.TakePlatformFile())),
+          static_cast<size_t>(length), &handle) != MOJO_RESULT_OK) {
+    return;
+  }
+  response->body_buffer.reset(mojo::SharedBufferHandle(handle));
+  response->body_buffer_offset = skip;
+  response->body_buffer_size = static_cast<uint64_t>(length) - skip;
+#endif  // defined(OS_ANDROID)
+}
+
+void RunURLResponseCallback(const Fetcher::URLResponseCallback& callback,
+                            mojo::URLResponsePtr response) {
+  callback.Run(response.Pass());
+}
+
+}  // namespace
+
+Fetcher::Fetcher(const FetchCallback& loader_callback)
+    : loader_callback_(loader_callback) {
+}
+
+Fetcher::~Fetcher() {
+}
+
+void Fetcher::PeekContentHandler(base::TaskRunner* task_runner,
+                                 const ContentHandlerCallback& callback) {
+  // TODO(aa): I guess this should just go in ApplicationManager now.
+  BeginStartupPhase("SniffContentHandler", GetURL().spec());
+  HasMojoMagic(task_runner,
+               base::Bind(&OnMojoMagicForContentHandler, base::Unretained(this),
+                          make_scoped_refptr(task_runner), GetURL().spec(),
+                          callback));
 }
 
 // static
-bool Fetcher::HasMojoMagic(const base::FilePath& path) {
+void Fetcher::HasMojoMagic(const base::FilePath& path,
+                           base::TaskRunner* task_runner,
+                           const base::Callback<void(bool)>& callback) {
   DCHECK(!path.empty());
-  std::string magic;
-  ReadFileToString(path, &magic, strlen(kMojoMagic));
-  return magic == kMojoMagic;
+  base::PostTaskAndReplyWithResult(task_runner, FROM_HERE,
+                                   base::Bind(&ReadMojoMagic, path), callback);
+}
+
+// static
+void Fetcher::PeekFirstLine(
+    const base::FilePath& path,
+    base::TaskRunner* task_runner,
+    const base::Callback<void(bool, const std::string&)>& callback) {
+  DCHECK(!path.empty());
+  // The file is copied into a data pipe no bigger than the longest line we
+  // accept, so that at most that much of it gets read.
+  MojoCreateDataPipeOptions options = {sizeof(MojoCreateDataPipeOptions),
+                                       MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,
+                                       1u, kMaxShebangLength};
+  mojo::DataPipe data_pipe(options);
+  mojo::common::CopyFromFile(path, data_pipe.producer_handle.Pass(), 0,
+                             task_runner, base::Bind(&IgnoreResult));
+  PeekLine(data_pipe.consumer_handle.Pass(), kMaxShebangLength,
+           kPeekFirstLineTimeout, base::Bind(&OnFirstLinePeeked, callback));
 }
 
 // static
-bool Fetcher::PeekFirstLine(const base::FilePath& path, std::string* line) {
+void Fetcher::SetBodyBuffer(const base::FilePath& path,
+                            uint32_t skip,
+                            base::TaskRunner* task_runner,
+                            mojo::URLResponsePtr response,
+                            const URLResponseCallback& callback) {
   DCHECK(!path.empty());
-  std::string start_of_file;
-  ReadFileToString(path, &start_of_file, kMaxShebangLength);
-  size_t return_position = start_of_file.find('\n');
-  if (return_position == std::string::npos)
-    return false;
-  *line = start_of_file.substr(0, return_position + 1);
-  return true;
+  // The reply owns |response|, and only runs once the task is done with it.
+  mojo::URLResponse* raw_response = response.get();
+  task_runner->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&CreateBodyBuffer, path, skip, base::Unretained(raw_response)),
+      base::Bind(&RunURLResponseCallback, callback, base::Passed(&response)));
 }
 
 }  // namespace shell
@@ -5,6 +5,8 @@
 #ifndef SHELL_APPLICATION_MANAGER_FETCHER_H_
 #define SHELL_APPLICATION_MANAGER_FETCHER_H_
 
+#include <string>
+
 #include "base/callback.h"
 #include "base/memory/scoped_ptr.h"
 
@@ -36,6 +38,16 @@ class Fetcher {
   // - 4x or 5x HTTP errors
   typedef base::Callback<void(scoped_ptr<Fetcher>)> FetchCallback;
 
+  // Called with true, the first line of the content (including the trailing
+  // newline) and the URL of the content handler named by it, if the content
+  // starts with a "#!mojo <content handler URL>" line. Otherwise called with
+  // false.
+  typedef base::Callback<
+      void(bool, const std::string& shebang, const GURL& content_handler_url)>
+      ContentHandlerCallback;
+
+  typedef base::Callback<void(mojo::URLResponsePtr)> URLResponseCallback;
+
   Fetcher(const FetchCallback& fetch_callback);
   virtual ~Fetcher();
 
@@ -46,8 +58,13 @@ class Fetcher {
   // redirects. Otherwise, it returns an empty URL.
   virtual GURL GetRedirectURL() const = 0;
 
-  virtual mojo::URLResponsePtr AsURLResponse(base::TaskRunner* task_runner,
-                                             uint32_t skip) = 0;
+  // Calls |callback| with the content after the first |skip| bytes as a
+  // response for a content handler. |task_runner| is used to read the content
+  // and to open it as a shared buffer, and |callback| is called on the current
+  // thread, never synchronously.
+  virtual void AsURLResponse(base::TaskRunner* task_runner,
+                             uint32_t skip,
+                             const URLResponseCallback& callback) = 0;
 
   virtual void AsPath(
       base::TaskRunner* task_runner,
@@ -55,16 +72,49 @@ class Fetcher {
 
   virtual std::string MimeType() = 0;
 
-  virtual bool HasMojoMagic() = 0;
-
-  virtual bool PeekFirstLine(std::string* line) = 0;
+  // Calls |callback| with whether the content starts with "#!mojo ", which
+  // only takes reading a few bytes of it. Like |PeekFirstLine()|, doesn't
+  // block the calling thread.
+  virtual void HasMojoMagic(base::TaskRunner* task_runner,
+                            const base::Callback<void(bool)>& callback) = 0;
+
+  // Calls |callback| with true and the first line of the content (including
+  // the trailing newline), or with false if there is no (short enough) line.
+  // Doesn't block the calling thread: |task_runner| is used to read the
+  // content, and |callback| is called on the current thread, never
+  // synchronously.
+  virtual void PeekFirstLine(
+      base::TaskRunner* task_runner,
+      const base::Callback<void(bool, const std::string&)>& callback) = 0;
 
-  bool PeekContentHandler(std::string* mojo_shebang,
-                          GURL* mojo_content_handler_url);
+  // Finds out whether the content is to be run by a content handler. The
+  // first line is only peeked, using |PeekFirstLine()|, if |HasMojoMagic()|
+  // found the magic. This fetcher must stay alive until |callback| is called,
+  // which it can be bound to.
+  void PeekContentHandler(base::TaskRunner* task_runner,
+                          const ContentHandlerCallback& callback);
 
  protected:
-  static bool HasMojoMagic(const base::FilePath& path);
-  static bool PeekFirstLine(const base::FilePath& path, std::string* line);
+  static void HasMojoMagic(const base::FilePath& path,
+                           base::TaskRunner* task_runner,
+                           const base::Callback<void(bool)>& callback);
+
+  static void PeekFirstLine(
+      const base::FilePath& path,
+      base::TaskRunner* task_runner,
+      const base::Callback<void(bool, const std::string&)>& callback);
+
+  // Makes the contents of |path| after the first |skip| bytes available to
+  // content handlers as |response->body_buffer|, a shared buffer backed by a
+  // read-only handle to the file, so that they can map it instead of copying
+  // it out of |response->body|. Leaves |response->body_buffer| null if that
+  // isn't possible. The file is opened on |task_runner|, after which
+  // |callback| is called with |response| on the current thread.
+  static void SetBodyBuffer(const base::FilePath& path,
+                            uint32_t skip,
+                            base::TaskRunner* task_runner,
+                            mojo::URLResponsePtr response,
+                            const URLResponseCallback& callback);
 
   FetchCallback loader_callback_;
 };
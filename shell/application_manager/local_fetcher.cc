@@ -54,8 +54,9 @@ GURL LocalFetcher::GetRedirectURL() const {
   return GURL::EmptyGURL();
 }
 
-mojo::URLResponsePtr LocalFetcher::AsURLResponse(base::TaskRunner* task_runner,
-                                                 uint32_t skip) {
+void LocalFetcher::AsURLResponse(base::TaskRunner* task_runner,
+                                 uint32_t skip,
+                                 const URLResponseCallback& callback) {
   mojo::URLResponsePtr response(mojo::URLResponse::New());
   response->url = mojo::String::From(url_);
   mojo::DataPipe data_pipe;
@@ -81,7 +82,7 @@ mojo::URLResponsePtr LocalFetcher::AsURLResponse(base::TaskRunner* task_runner,
   }
   mojo::common::CopyFromFile(path_, data_pipe.producer_handle.Pass(), skip,
                              task_runner, base::Bind(&IgnoreResult));
-  return response;
+  SetBodyBuffer(path_, skip, task_runner, response.Pass(), callback);
 }
 
 void LocalFetcher::AsPath(
@@ -96,12 +97,16 @@ std::string LocalFetcher::MimeType() {
   return "";
 }
 
-bool LocalFetcher::HasMojoMagic() {
-  return Fetcher::HasMojoMagic(path_);
+void LocalFetcher::HasMojoMagic(
+    base::TaskRunner* task_runner,
+    const base::Callback<void(bool)>& callback) {
+  Fetcher::HasMojoMagic(path_, task_runner, callback);
 }
 
-bool LocalFetcher::PeekFirstLine(std::string* line) {
-  return Fetcher::PeekFirstLine(path_, line);
+void LocalFetcher::PeekFirstLine(
+    base::TaskRunner* task_runner,
+    const base::Callback<void(bool, const std::string&)>& callback) {
+  Fetcher::PeekFirstLine(path_, task_runner, callback);
 }
 
 }  // namespace shell
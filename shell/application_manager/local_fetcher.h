@@ -25,8 +25,9 @@ class LocalFetcher : public Fetcher {
   const GURL& GetURL() const override;
   GURL GetRedirectURL() const override;
 
-  mojo::URLResponsePtr AsURLResponse(base::TaskRunner* task_runner,
-                                     uint32_t skip) override;
+  void AsURLResponse(base::TaskRunner* task_runner,
+                     uint32_t skip,
+                     const URLResponseCallback& callback) override;
 
   void AsPath(
       base::TaskRunner* task_runner,
@@ -34,9 +35,12 @@ class LocalFetcher : public Fetcher {
 
   std::string MimeType() override;
 
-  bool HasMojoMagic() override;
+  void HasMojoMagic(base::TaskRunner* task_runner,
+                    const base::Callback<void(bool)>& callback) override;
 
-  bool PeekFirstLine(std::string* line) override;
+  void PeekFirstLine(
+      base::TaskRunner* task_runner,
+      const base::Callback<void(bool, const std::string&)>& callback) override;
 
   GURL url_;
   base::FilePath path_;
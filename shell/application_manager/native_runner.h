@@ -7,6 +7,7 @@
 
 #include "base/callback_forward.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/process/process_handle.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/interfaces/application/application.mojom.h"
 #include "shell/native_application_support.h"
@@ -37,6 +38,12 @@ class NativeRunner {
       const base::FilePath& app_path,
       mojo::InterfaceRequest<mojo::Application> application_request,
       const base::Closure& app_completed_callback) = 0;
+
+  // Returns the handle to the process the app runs in, if it runs in a process
+  // of its own (and that process has been started), or |kNullProcessHandle|.
+  virtual base::ProcessHandle GetProcessHandle() const {
+    return base::kNullProcessHandle;
+  }
 };
 
 class NativeRunnerFactory {
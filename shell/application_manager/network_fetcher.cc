@@ -22,6 +22,7 @@
 #include "mojo/converters/url/url_type_converters.h"
 #include "mojo/data_pipe_utils/data_pipe_utils.h"
 #include "shell/application_manager/data_pipe_peek.h"
+#include "shell/startup_timeline.h"
 
 namespace shell {
 
@@ -184,16 +185,16 @@ GURL NetworkFetcher::GetRedirectURL() const {
   return GURL(response_->redirect_url);
 }
 
-mojo::URLResponsePtr NetworkFetcher::AsURLResponse(
-    base::TaskRunner* task_runner,
-    uint32_t skip) {
+void NetworkFetcher::AsURLResponse(base::TaskRunner* task_runner,
+                                   uint32_t skip,
+                                   const URLResponseCallback& callback) {
   DCHECK(response_);
   DCHECK(!path_.empty());
   mojo::DataPipe data_pipe;
   response_->body = data_pipe.consumer_handle.Pass();
   mojo::common::CopyFromFile(path_, data_pipe.producer_handle.Pass(), skip,
                              task_runner, base::Bind(&IgnoreResult));
-  return response_.Pass();
+  SetBodyBuffer(path_, skip, task_runner, response_.Pass(), callback);
 }
 
 void NetworkFetcher::AsPath(
@@ -212,12 +213,16 @@ std::string NetworkFetcher::MimeType() {
   return response_->mime_type;
 }
 
-bool NetworkFetcher::HasMojoMagic() {
-  return Fetcher::HasMojoMagic(path_);
+void NetworkFetcher::HasMojoMagic(
+    base::TaskRunner* task_runner,
+    const base::Callback<void(bool)>& callback) {
+  Fetcher::HasMojoMagic(path_, task_runner, callback);
 }
 
-bool NetworkFetcher::PeekFirstLine(std::string* line) {
-  return Fetcher::PeekFirstLine(path_, line);
+void NetworkFetcher::PeekFirstLine(
+    base::TaskRunner* task_runner,
+    const base::Callback<void(bool, const std::string&)>& callback) {
+  Fetcher::PeekFirstLine(path_, task_runner, callback);
 }
 
 bool NetworkFetcher::CanLoadDirectlyFromCache() {
@@ -232,6 +237,7 @@ bool NetworkFetcher::CanLoadDirectlyFromCache() {
 }
 
 void NetworkFetcher::LoadFromCache() {
+  BeginStartupPhase("CacheLookup", url_.spec());
   url_response_disk_cache_->Get(
       mojo::String::From(url_),
       base::Bind(&NetworkFetcher::OnResponseReceived, base::Unretained(this),
@@ -242,6 +248,7 @@ void NetworkFetcher::OnResponseReceived(bool schedule_update,
                                         mojo::URLResponsePtr response,
                                         mojo::Array<uint8_t> path_as_array,
                                         mojo::Array<uint8_t> cache_dir) {
+  EndStartupPhase("CacheLookup", url_.spec());
   if (!response) {
     // Not in cache, loading from net.
     StartNetworkRequest();
@@ -262,6 +269,7 @@ void NetworkFetcher::OnResponseReceived(bool schedule_update,
 void NetworkFetcher::StartNetworkRequest() {
   TRACE_EVENT_ASYNC_BEGIN1("mojo_shell", "NetworkFetcher::NetworkRequest", this,
                            "url", url_.spec());
+  BeginStartupPhase("NetworkRequest", url_.spec());
   network_service_->CreateURLLoader(GetProxy(&url_loader_));
   url_loader_->Start(GetRequest(url_, disable_cache_),
                      base::Bind(&NetworkFetcher::OnLoadComplete,
@@ -270,6 +278,7 @@ void NetworkFetcher::StartNetworkRequest() {
 
 void NetworkFetcher::OnLoadComplete(mojo::URLResponsePtr response) {
   TRACE_EVENT_ASYNC_END0("mojo_shell", "NetworkFetcher::NetworkRequest", this);
+  EndStartupPhase("NetworkRequest", url_.spec());
   if (response->error) {
     LOG(ERROR) << "Error (" << response->error->code << ": "
                << response->error->description << ") while fetching "
@@ -295,6 +304,7 @@ void NetworkFetcher::OnLoadComplete(mojo::URLResponsePtr response) {
   }
 
   mojo::URLResponsePtr cloned_response = CloneResponse(response);
+  BeginStartupPhase("SaveToCache", url_.spec());
   url_response_disk_cache_->UpdateAndGet(
       response.Pass(), base::Bind(&NetworkFetcher::OnFileSavedToCache,
                                   weak_ptr_factory_.GetWeakPtr(),
@@ -304,6 +314,7 @@ void NetworkFetcher::OnLoadComplete(mojo::URLResponsePtr response) {
 void NetworkFetcher::OnFileSavedToCache(mojo::URLResponsePtr response,
                                         mojo::Array<uint8_t> path_as_array,
                                         mojo::Array<uint8_t> cache_dir) {
+  EndStartupPhase("SaveToCache", url_.spec());
   if (!path_as_array) {
     LOG(WARNING) << "Error when retrieving content from cache for: "
                  << url_.spec();
@@ -32,8 +32,9 @@ class NetworkFetcher : public Fetcher {
   const GURL& GetURL() const override;
   GURL GetRedirectURL() const override;
 
-  mojo::URLResponsePtr AsURLResponse(base::TaskRunner* task_runner,
-                                     uint32_t skip) override;
+  void AsURLResponse(base::TaskRunner* task_runner,
+                     uint32_t skip,
+                     const URLResponseCallback& callback) override;
 
   void AsPath(
       base::TaskRunner* task_runner,
@@ -41,9 +42,12 @@ class NetworkFetcher : public Fetcher {
 
   std::string MimeType() override;
 
-  bool HasMojoMagic() override;
+  void HasMojoMagic(base::TaskRunner* task_runner,
+                    const base::Callback<void(bool)>& callback) override;
 
-  bool PeekFirstLine(std::string* line) override;
+  void PeekFirstLine(
+      base::TaskRunner* task_runner,
+      const base::Callback<void(bool, const std::string&)>& callback) override;
 
   // Returns whether the content can be loaded directly from cache. Local hosts
   // are not loaded from cache to allow effective development.
@@ -53,6 +53,10 @@ ShellImpl::ShellImpl(ApplicationPtr application,
       on_application_end_(on_application_end),
       application_(std::move(application)),
       binding_(this),
+      last_connection_time_(base::TimeTicks::Now()),
+      connected_by_shell_(false),
+      native_runner_(nullptr),
+      quitting_(false),
       application_connector_impl_(this) {
   binding_.set_connection_error_handler(
       [this]() { manager_->OnShellImplError(this); });
@@ -68,10 +72,19 @@ void ShellImpl::InitializeApplication(Array<String> args) {
                            identity_.url.spec());
 }
 
+void ShellImpl::RequestQuit(base::TimeDelta timeout) {
+  quitting_ = true;
+  application_->RequestQuit();
+  quit_timer_.Start(FROM_HERE, timeout, this, &ShellImpl::OnQuitTimeout);
+}
+
 void ShellImpl::ConnectToClient(const GURL& requested_url,
                                 const GURL& requestor_url,
                                 InterfaceRequest<ServiceProvider> services,
                                 ServiceProviderPtr exposed_services) {
+  last_connection_time_ = base::TimeTicks::Now();
+  if (requestor_url.is_empty())
+    connected_by_shell_ = true;
   application_->AcceptConnection(
       String::From(requestor_url), std::move(services),
       std::move(exposed_services), requested_url.spec());
@@ -95,4 +108,11 @@ void ShellImpl::CreateApplicationConnector(
       std::move(application_connector_request));
 }
 
+void ShellImpl::OnQuitTimeout() {
+  LOG(WARNING) << "Application " << identity_.url
+               << " didn't quit when asked to; dropping it";
+  // Deletes |this|.
+  manager_->OnShellImplError(this);
+}
+
 }  // namespace shell
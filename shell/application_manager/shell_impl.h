@@ -7,6 +7,8 @@
 
 #include "base/callback.h"
 #include "base/macros.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "mojo/common/binding_set.h"
 #include "mojo/public/cpp/bindings/binding.h"
 #include "mojo/public/interfaces/application/application.mojom.h"
@@ -18,6 +20,7 @@
 namespace shell {
 
 class ApplicationManager;
+class NativeRunner;
 
 // TODO(vtl): This both implements the |Shell| interface and holds the
 // |ApplicationPtr| (from back when they were paired interfaces on the same
@@ -40,10 +43,41 @@ class ShellImpl : public mojo::Shell {
                        mojo::InterfaceRequest<mojo::ServiceProvider> services,
                        mojo::ServiceProviderPtr exposed_services);
 
+  // Asks the application to quit (see |mojo::Application::RequestQuit()|). If
+  // it hasn't within |timeout|, it's dropped as if it had (see
+  // |ApplicationManager::OnShellImplError()|), which deletes this.
+  void RequestQuit(base::TimeDelta timeout);
+  // Whether |RequestQuit()| was called. The application is still running
+  // until it closes its end of the |Shell| pipe.
+  bool quitting() const { return quitting_; }
+
   mojo::Application* application() { return application_.get(); }
   const Identity& identity() const { return identity_; }
   base::Closure on_application_end() const { return on_application_end_; }
 
+  // The time of the last |ConnectToClient()|.
+  base::TimeTicks last_connection_time() const {
+    return last_connection_time_;
+  }
+  // Whether the shell itself (rather than another application) has connected
+  // to the application, i.e., |ConnectToClient()| was called with an empty
+  // |requestor_url|.
+  bool connected_by_shell() const { return connected_by_shell_; }
+
+  // The runner running the application, if it's a native application that has
+  // been started (and hasn't completed yet).
+  NativeRunner* native_runner() const { return native_runner_; }
+  void set_native_runner(NativeRunner* native_runner) {
+    native_runner_ = native_runner;
+  }
+
+  // The URL (without query) of the content handler running the application, if
+  // any.
+  const GURL& content_handler_url() const { return content_handler_url_; }
+  void set_content_handler_url(const GURL& content_handler_url) {
+    content_handler_url_ = content_handler_url;
+  }
+
  private:
   // This is a per-|ShellImpl| singleton.
   class ApplicationConnectorImpl : public mojo::ApplicationConnector {
@@ -74,11 +108,19 @@ class ShellImpl : public mojo::Shell {
       mojo::InterfaceRequest<mojo::ApplicationConnector>
           application_connector_request) override;
 
+  void OnQuitTimeout();
+
   ApplicationManager* const manager_;
   const Identity identity_;
   base::Closure on_application_end_;
   mojo::ApplicationPtr application_;
   mojo::Binding<mojo::Shell> binding_;
+  base::TimeTicks last_connection_time_;
+  bool connected_by_shell_;
+  NativeRunner* native_runner_;
+  GURL content_handler_url_;
+  bool quitting_;
+  base::OneShotTimer<ShellImpl> quit_timer_;
 
   ApplicationConnectorImpl application_connector_impl_;
 
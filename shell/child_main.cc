@@ -4,6 +4,7 @@
 
 #include <unistd.h>
 
+#include <limits>
 #include <memory>
 
 #include "base/at_exit.h"
@@ -17,11 +18,13 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
+#include "base/metrics/shared_histogram_allocator.h"
 #include "base/single_thread_task_runner.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/thread_task_runner_handle.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_checker.h"
+#include "mojo/edk/base_edk/memory_dump_provider_impl.h"
 #include "mojo/edk/base_edk/platform_handle_watcher_impl.h"
 #include "mojo/edk/base_edk/platform_task_runner_impl.h"
 #include "mojo/edk/embedder/embedder.h"
@@ -36,11 +39,13 @@
 #include "mojo/edk/util/ref_ptr.h"
 #include "mojo/message_pump/message_pump_mojo.h"
 #include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/public/cpp/system/buffer.h"
 #include "mojo/public/cpp/system/core.h"
 #include "shell/child_controller.mojom.h"
 #include "shell/child_switches.h"
 #include "shell/init.h"
 #include "shell/native_application_support.h"
+#include "shell/startup_timeline.h"
 
 using mojo::platform::PlatformHandleWatcher;
 using mojo::platform::ScopedPlatformHandle;
@@ -136,6 +141,7 @@ class AppContext : public mojo::embedder::SlaveProcessDelegate {
     mojo::embedder::InitIPCSupport(
         mojo::embedder::ProcessType::SLAVE, controller_runner_.Clone(), this,
         io_runner_.Clone(), io_watcher_.get(), platform_handle.Pass());
+    base_edk::MemoryDumpProviderImpl::Install(io_thread_.task_runner());
   }
 
   void Shutdown() {
@@ -239,7 +245,40 @@ class ChildControllerImpl : public ChildController {
     on_app_complete_ = on_app_complete;
     unblocker_.Unblock(base::Bind(&ChildControllerImpl::StartAppOnMainThread,
                                   base::FilePath::FromUTF8Unsafe(app_path),
-                                  base::Passed(&application_request)));
+                                  base::Passed(&application_request),
+                                  histogram_arena_,
+                                  histogram_arena_num_bytes_));
+  }
+
+  void SetHistogramArena(mojo::ScopedSharedBufferHandle buffer,
+                         uint64_t num_bytes) override {
+    DVLOG(2) << "ChildControllerImpl::SetHistogramArena(..., " << num_bytes
+             << ")";
+    DCHECK(thread_checker_.CalledOnValidThread());
+    if (histogram_arena_) {
+      LOG(ERROR) << "Histogram arena already set";
+      return;
+    }
+
+    void* memory = nullptr;
+    if (num_bytes > std::numeric_limits<size_t>::max() ||
+        mojo::MapBuffer(buffer.get(), 0, num_bytes, &memory,
+                        MOJO_MAP_BUFFER_FLAG_NONE) != MOJO_RESULT_OK) {
+      LOG(ERROR) << "Failed to map histogram arena";
+      return;
+    }
+    scoped_ptr<base::SharedHistogramAllocator> allocator =
+        base::SharedHistogramAllocator::Attach(memory,
+                                               static_cast<size_t>(num_bytes));
+    if (!allocator) {
+      LOG(ERROR) << "Invalid histogram arena";
+      mojo::UnmapBuffer(memory);
+      return;
+    }
+    // Histograms point into the arena, so it is never unmapped.
+    base::SharedHistogramAllocator::SetGlobal(allocator.Pass());
+    histogram_arena_ = memory;
+    histogram_arena_num_bytes_ = static_cast<size_t>(num_bytes);
   }
 
   void ExitNow(int32_t exit_code) override {
@@ -255,6 +294,8 @@ class ChildControllerImpl : public ChildController {
         mojo_task_runner_(MakeRefCounted<base_edk::PlatformTaskRunnerImpl>(
             base::ThreadTaskRunnerHandle::Get())),
         channel_info_(nullptr),
+        histogram_arena_(nullptr),
+        histogram_arena_num_bytes_(0u),
         binding_(this) {
     binding_.set_connection_error_handler([this]() { OnConnectionError(); });
   }
@@ -274,7 +315,9 @@ class ChildControllerImpl : public ChildController {
 
   static void StartAppOnMainThread(
       const base::FilePath& app_path,
-      mojo::InterfaceRequest<mojo::Application> application_request) {
+      mojo::InterfaceRequest<mojo::Application> application_request,
+      void* histogram_arena,
+      size_t histogram_arena_num_bytes) {
     // TODO(vtl): This is copied from in_process_native_runner.cc.
     DVLOG(2) << "Loading/running Mojo app from " << app_path.value()
              << " out of process";
@@ -282,6 +325,11 @@ class ChildControllerImpl : public ChildController {
     // We intentionally don't unload the native library as its lifetime is the
     // same as that of the process.
     base::NativeLibrary app_library = LoadNativeApplication(app_path);
+    if (histogram_arena) {
+      SetNativeApplicationHistogramArena(app_library, histogram_arena,
+                                         histogram_arena_num_bytes);
+    }
+    MarkStartupEvent("MojoMain", app_path.AsUTF8Unsafe());
     RunNativeApplication(app_library, application_request.Pass());
   }
 
@@ -292,6 +340,11 @@ class ChildControllerImpl : public ChildController {
   StartAppCallback on_app_complete_;
 
   mojo::embedder::ChannelInfo* channel_info_;
+
+  // The shared histogram arena set by the shell, if any.
+  void* histogram_arena_;
+  size_t histogram_arena_num_bytes_;
+
   mojo::Binding<ChildController> binding_;
 
   DISALLOW_COPY_AND_ASSIGN(ChildControllerImpl);
@@ -308,6 +361,12 @@ int main(int argc, char** argv) {
 
   shell::InitializeLogging();
 
+  if (command_line.HasSwitch(switches::kStartupTimeline)) {
+    shell::EnableStartupTimeline(
+        command_line.GetSwitchValuePath(switches::kStartupTimeline), false,
+        "ChildStart");
+  }
+
   // Make sure that we're really meant to be invoked as the child process.
 
   CHECK(command_line.HasSwitch(switches::kChildConnectionId));
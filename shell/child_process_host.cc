@@ -11,20 +11,25 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/metrics/shared_histogram_allocator.h"
 #include "base/process/kill.h"
 #include "base/process/launch.h"
 #include "base/task_runner.h"
 #include "base/task_runner_util.h"
 #include "base/thread_task_runner_handle.h"
+#include "base/threading/work_stealing_pool.h"
 #include "build/build_config.h"
 #include "mojo/edk/base_edk/platform_task_runner_impl.h"
 #include "mojo/edk/embedder/multiprocess_embedder.h"
 #include "mojo/edk/embedder/platform_channel_pair.h"
 #include "mojo/edk/util/ref_ptr.h"
+#include "mojo/public/cpp/system/buffer.h"
 #include "mojo/public/cpp/system/message_pipe.h"
 #include "shell/application_manager/native_application_options.h"
 #include "shell/child_switches.h"
 #include "shell/context.h"
+#include "shell/histogram_aggregator.h"
+#include "shell/startup_timeline.h"
 #include "shell/task_runners.h"
 
 using mojo::util::MakeRefCounted;
@@ -42,11 +47,18 @@ struct ChildProcessHost::LaunchData {
 };
 
 ChildProcessHost::ChildProcessHost(Context* context)
-    : context_(context), channel_info_(nullptr) {
+    : context_(context), channel_info_(nullptr), histogram_arena_(nullptr) {
 }
 
 ChildProcessHost::~ChildProcessHost() {
   DCHECK(!child_process_.IsValid());
+
+  if (histogram_allocator_) {
+    context_->histogram_aggregator()->RemoveArena(histogram_allocator_.get());
+    histogram_allocator_.reset();
+  }
+  if (histogram_arena_)
+    mojo::UnmapBuffer(histogram_arena_);
 }
 
 void ChildProcessHost::Start(const NativeApplicationOptions& options) {
@@ -78,6 +90,7 @@ void ChildProcessHost::Start(const NativeApplicationOptions& options) {
 
   controller_.Bind(mojo::InterfacePtrInfo<ChildController>(handle.Pass(), 0u));
   controller_.set_connection_error_handler([this]() { OnConnectionError(); });
+  CreateHistogramArena();
 
   CHECK(base::PostTaskAndReplyWithResult(
       context_->task_runners()->blocking_pool(), FROM_HERE,
@@ -101,6 +114,11 @@ void ChildProcessHost::StartApp(
     const ChildController::StartAppCallback& on_app_complete) {
   DCHECK(controller_);
 
+  if (histogram_allocator_) {
+    context_->histogram_aggregator()->AddArena(histogram_allocator_.get(),
+                                               app_path);
+  }
+
   on_app_complete_ = on_app_complete;
   controller_->StartApp(
       app_path, application_request.Pass(),
@@ -132,8 +150,10 @@ void ChildProcessHost::DidConnectToSlave() {
 }
 
 base::Process ChildProcessHost::DoLaunch(scoped_ptr<LaunchData> launch_data) {
+  ScopedStartupPhase phase("LaunchChild", launch_data->child_connection_id);
   static const char* kForwardSwitches[] = {
-      switches::kTraceToConsole, switches::kV, switches::kVModule,
+      switches::kStartupTimeline, switches::kTraceToConsole, switches::kV,
+      switches::kVModule,
   };
 
   base::CommandLine child_command_line(launch_data->child_path);
@@ -176,4 +196,27 @@ void ChildProcessHost::OnConnectionError() {
   AppCompleted(MOJO_RESULT_UNKNOWN);
 }
 
+void ChildProcessHost::CreateHistogramArena() {
+  DCHECK(!histogram_arena_);
+
+  // Histograms are an optional feature: the child works without an arena.
+  mojo::ScopedSharedBufferHandle buffer;
+  if (mojo::CreateSharedBuffer(nullptr, HistogramAggregator::kArenaNumBytes,
+                               &buffer) != MOJO_RESULT_OK ||
+      mojo::MapBuffer(buffer.get(), 0, HistogramAggregator::kArenaNumBytes,
+                      &histogram_arena_,
+                      MOJO_MAP_BUFFER_FLAG_NONE) != MOJO_RESULT_OK) {
+    LOG(ERROR) << "Failed to create histogram arena";
+    histogram_arena_ = nullptr;
+    return;
+  }
+  histogram_allocator_ = base::SharedHistogramAllocator::Create(
+      histogram_arena_, HistogramAggregator::kArenaNumBytes);
+  CHECK(histogram_allocator_);
+
+  // The mapping stays valid after |buffer| is handed over.
+  controller_->SetHistogramArena(buffer.Pass(),
+                                 HistogramAggregator::kArenaNumBytes);
+}
+
 }  // namespace shell
@@ -15,6 +15,10 @@
 #include "mojo/edk/embedder/channel_info_forward.h"
 #include "shell/child_controller.mojom.h"
 
+namespace base {
+class SharedHistogramAllocator;
+}
+
 namespace shell {
 
 class Context;
@@ -59,6 +63,14 @@ class ChildProcessHost {
                 const ChildController::StartAppCallback& on_app_complete);
   void ExitNow(int32_t exit_code);
 
+  // Returns true if the connection to the child's |ChildController| has been
+  // lost (e.g., because the child process died).
+  bool encountered_error() const { return controller_.encountered_error(); }
+
+  // Returns the handle to the child process, or |kNullProcessHandle| if it
+  // hasn't been started (yet).
+  base::ProcessHandle process_handle() const { return child_process_.Handle(); }
+
   // TODO(vtl): This is virtual, so tests can override it, but really |Start()|
   // should take a callback (see above) and this should be private.
   virtual void DidStart(base::Process child_process);
@@ -76,6 +88,10 @@ class ChildProcessHost {
   void AppCompleted(int32_t result);
   void OnConnectionError();
 
+  // Creates the arena in which the child records its histograms, and hands it
+  // to the child.
+  void CreateHistogramArena();
+
   Context* const context_;
 
   ChildControllerPtr controller_;
@@ -84,6 +100,10 @@ class ChildProcessHost {
 
   base::Process child_process_;
 
+  // The child's histogram arena, as mapped in this process (or null).
+  void* histogram_arena_;
+  scoped_ptr<base::SharedHistogramAllocator> histogram_allocator_;
+
   DISALLOW_COPY_AND_ASSIGN(ChildProcessHost);
 };
 
@@ -0,0 +1,145 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/child_process_pool.h"
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/process/process.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
+#include "shell/application_manager/native_application_options.h"
+#include "shell/child_process_host.h"
+
+namespace shell {
+
+// A |ChildProcessHost| that knows whether its child has been launched, and can
+// be abandoned (by the pool, on destruction) before that happens.
+class ChildProcessPool::PooledChildProcessHost : public ChildProcessHost {
+ public:
+  PooledChildProcessHost(Context* context, const base::Closure& on_started)
+      : ChildProcessHost(context),
+        on_started_(on_started),
+        started_(false),
+        launched_(false),
+        abandoned_(false) {}
+  ~PooledChildProcessHost() override {}
+
+  // True once |DidStart()| has been called.
+  bool started() const { return started_; }
+  // True if the child process was launched successfully.
+  bool launched() const { return launched_; }
+
+  // Makes the child process exit, and destroys this object (possibly later,
+  // since it must not be destroyed before |DidStart()|).
+  void Abandon() {
+    DCHECK(!abandoned_);
+    abandoned_ = true;
+    // If the child hasn't been launched yet, this will be delivered once it
+    // connects.
+    ExitNow(0);
+    if (started_)
+      Destroy();
+  }
+
+  // |ChildProcessHost| method:
+  void DidStart(base::Process child_process) override {
+    launched_ = child_process.IsValid();
+    ChildProcessHost::DidStart(child_process.Pass());
+    started_ = true;
+    if (abandoned_) {
+      Destroy();
+      return;
+    }
+    if (!on_started_.is_null())
+      on_started_.Run();
+  }
+
+ private:
+  void Destroy() {
+    if (launched_)
+      Join();
+    delete this;
+  }
+
+  const base::Closure on_started_;
+  bool started_;
+  bool launched_;
+  bool abandoned_;
+
+  DISALLOW_COPY_AND_ASSIGN(PooledChildProcessHost);
+};
+
+ChildProcessPool::ChildProcessPool(Context* context, size_t size)
+    : context_(context),
+      size_(size),
+      refill_scheduled_(false),
+      weak_factory_(this) {
+  Refill();
+}
+
+ChildProcessPool::~ChildProcessPool() {
+  for (PooledChildProcessHost* host : hosts_)
+    host->Abandon();
+}
+
+scoped_ptr<ChildProcessHost> ChildProcessPool::TakeHost(
+    const NativeApplicationOptions& options) {
+  // Pooled children are launched with the default options. (Options that only
+  // matter to the parent, like |new_process_per_connection|, don't count.)
+  if (options.require_32_bit || options.allow_new_privs)
+    return nullptr;
+
+  scoped_ptr<ChildProcessHost> result;
+  while (!hosts_.empty() && !result) {
+    PooledChildProcessHost* host = hosts_.front();
+    hosts_.pop_front();
+    // Discard children that failed to launch or that have died since. (A child
+    // that hasn't been launched yet is fine: |StartApp()| may be called right
+    // away.)
+    if (host->encountered_error() || (host->started() && !host->launched())) {
+      LOG(WARNING) << "Discarding dead pooled child process";
+      host->Abandon();
+      continue;
+    }
+    result.reset(host);
+  }
+  TRACE_EVENT_INSTANT1("mojo_shell", "ChildProcessPool::TakeHost",
+                       TRACE_EVENT_SCOPE_THREAD, "hit", !!result);
+
+  // Don't start replacements now, since our caller is on the critical path of
+  // starting an app.
+  ScheduleRefill();
+  return result;
+}
+
+void ChildProcessPool::Refill() {
+  TRACE_EVENT1("mojo_shell", "ChildProcessPool::Refill", "num_hosts",
+               hosts_.size());
+  refill_scheduled_ = false;
+  while (hosts_.size() < size_) {
+    PooledChildProcessHost* host = new PooledChildProcessHost(
+        context_, base::Bind(&ChildProcessPool::OnHostStarted,
+                             weak_factory_.GetWeakPtr()));
+    host->Start(NativeApplicationOptions());
+    hosts_.push_back(host);
+  }
+}
+
+void ChildProcessPool::ScheduleRefill() {
+  if (refill_scheduled_ || hosts_.size() >= size_)
+    return;
+  refill_scheduled_ = true;
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE,
+      base::Bind(&ChildProcessPool::Refill, weak_factory_.GetWeakPtr()));
+}
+
+void ChildProcessPool::OnHostStarted() {
+  if (!host_started_callback_for_testing_.is_null())
+    host_started_callback_for_testing_.Run();
+}
+
+}  // namespace shell
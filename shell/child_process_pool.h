@@ -0,0 +1,81 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SHELL_CHILD_PROCESS_POOL_H_
+#define SHELL_CHILD_PROCESS_POOL_H_
+
+#include <stddef.h>
+
+#include <deque>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+
+namespace shell {
+
+class ChildProcessHost;
+class Context;
+struct NativeApplicationOptions;
+
+// A pool of pre-started ("zygote") child processes for running native apps out
+// of process. Each pooled child has been launched and has already initialized
+// the EDK and connected its |ChildController| to us, and is just waiting for
+// |StartApp()|. Taking a child from the pool thus skips launching the process
+// and bootstrapping its channel. The pool refills itself in the background.
+//
+// Only children with default |NativeApplicationOptions| are pooled (e.g., not
+// 32-bit children); |TakeHost()| returns null for anything else.
+//
+// This class is not thread-safe. It should be created/used/destroyed on the
+// shell thread, after IPC support has been initialized and before it is shut
+// down.
+class ChildProcessPool {
+ public:
+  // Starts |size| child processes.
+  ChildProcessPool(Context* context, size_t size);
+  // Makes the remaining pooled children exit.
+  ~ChildProcessPool();
+
+  // Returns a started |ChildProcessHost| (on which |Start()| has already been
+  // called), or null if none is available or if |options| require a child
+  // process that isn't pooled. In the latter case, the caller should start a
+  // child process of its own.
+  scoped_ptr<ChildProcessHost> TakeHost(
+      const NativeApplicationOptions& options);
+
+  size_t size() const { return size_; }
+
+  // Called each time a pooled child process has been launched (or has failed to
+  // launch).
+  void set_host_started_callback_for_testing(const base::Closure& callback) {
+    host_started_callback_for_testing_ = callback;
+  }
+
+ private:
+  class PooledChildProcessHost;
+
+  // Starts child processes until there are |size_| of them.
+  void Refill();
+  void ScheduleRefill();
+  void OnHostStarted();
+
+  Context* const context_;
+  const size_t size_;
+
+  // Oldest first.
+  std::deque<PooledChildProcessHost*> hosts_;
+  bool refill_scheduled_;
+
+  base::Closure host_started_callback_for_testing_;
+
+  base::WeakPtrFactory<ChildProcessPool> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChildProcessPool);
+};
+
+}  // namespace shell
+
+#endif  // SHELL_CHILD_PROCESS_POOL_H_
@@ -0,0 +1,119 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/child_process_pool.h"
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "build/build_config.h"
+#include "mojo/message_pump/message_pump_mojo.h"
+#include "shell/application_manager/native_application_options.h"
+#include "shell/child_process_host.h"
+#include "shell/context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace shell {
+namespace {
+
+// Runs the message loop until |count| pooled child processes have started.
+class StartedWaiter {
+ public:
+  explicit StartedWaiter(ChildProcessPool* pool) : num_started_(0) {
+    pool->set_host_started_callback_for_testing(
+        base::Bind(&StartedWaiter::OnStarted, base::Unretained(this)));
+  }
+  ~StartedWaiter() {}
+
+  void WaitForTotal(int count) {
+    while (num_started_ < count)
+      base::MessageLoop::current()->Run();
+  }
+
+ private:
+  void OnStarted() {
+    num_started_++;
+    base::MessageLoop::current()->QuitWhenIdle();
+  }
+
+  int num_started_;
+
+  DISALLOW_COPY_AND_ASSIGN(StartedWaiter);
+};
+
+#if defined(OS_ANDROID)
+// TODO(qsr): Multiprocess shell tests are not supported on android.
+#define MAYBE_TakeAndRefill DISABLED_TakeAndRefill
+#else
+#define MAYBE_TakeAndRefill TakeAndRefill
+#endif  // defined(OS_ANDROID)
+// Tests taking a pre-started child process from the pool, and that the pool
+// replaces it.
+TEST(ChildProcessPoolTest, MAYBE_TakeAndRefill) {
+  Context context;
+  base::MessageLoop message_loop(
+      scoped_ptr<base::MessagePump>(new mojo::common::MessagePumpMojo()));
+  context.Init();
+  {
+    ChildProcessPool pool(&context, 2u);
+    StartedWaiter waiter(&pool);
+    waiter.WaitForTotal(2);
+
+    scoped_ptr<ChildProcessHost> host =
+        pool.TakeHost(NativeApplicationOptions());
+    ASSERT_TRUE(host);
+    // A replacement should get started.
+    waiter.WaitForTotal(3);
+
+    host->ExitNow(123);
+    int exit_code = host->Join();
+    VLOG(2) << "Joined child: exit_code = " << exit_code;
+    EXPECT_EQ(123, exit_code);
+
+    // Destroying the pool makes the remaining children exit.
+  }
+
+  context.Shutdown();
+}
+
+#if defined(OS_ANDROID)
+// TODO(qsr): Multiprocess shell tests are not supported on android.
+#define MAYBE_UnpooledOptions DISABLED_UnpooledOptions
+#else
+#define MAYBE_UnpooledOptions UnpooledOptions
+#endif  // defined(OS_ANDROID)
+// Tests that child processes needing non-default options aren't taken from the
+// pool.
+TEST(ChildProcessPoolTest, MAYBE_UnpooledOptions) {
+  Context context;
+  base::MessageLoop message_loop(
+      scoped_ptr<base::MessagePump>(new mojo::common::MessagePumpMojo()));
+  context.Init();
+  {
+    ChildProcessPool pool(&context, 1u);
+    StartedWaiter waiter(&pool);
+    waiter.WaitForTotal(1);
+
+    NativeApplicationOptions options;
+    options.require_32_bit = true;
+    EXPECT_FALSE(pool.TakeHost(options));
+    options = NativeApplicationOptions();
+    options.allow_new_privs = true;
+    EXPECT_FALSE(pool.TakeHost(options));
+
+    // Options that don't affect the child process itself are fine.
+    options = NativeApplicationOptions();
+    options.new_process_per_connection = true;
+    scoped_ptr<ChildProcessHost> host = pool.TakeHost(options);
+    ASSERT_TRUE(host);
+    host->ExitNow(0);
+    host->Join();
+  }
+
+  context.Shutdown();
+}
+
+}  // namespace
+}  // namespace shell
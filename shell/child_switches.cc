@@ -15,4 +15,9 @@ const char kChildConnectionId[] = "child-connection-id";
 // be given to |PlatformChannelPair::PassClientHandleFromParentProcess()|.
 const char kPlatformChannelHandleInfo[] = "platform-channel-handle-info";
 
+// Appends the startup timeline (see startup_timeline.h) to the file given as
+// the value of this switch. This is also a switch for mojo_shell, which empties
+// the file and forwards the switch to its child processes.
+const char kStartupTimeline[] = "startup-timeline";
+
 }  // namespace switches
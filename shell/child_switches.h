@@ -13,6 +13,7 @@ namespace switches {
 // alongside the definition of their values in the .cc file.
 extern const char kChildConnectionId[];
 extern const char kPlatformChannelHandleInfo[];
+extern const char kStartupTimeline[];
 
 }  // namespace switches
 
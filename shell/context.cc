@@ -6,6 +6,7 @@
 
 #include <vector>
 
+#include "base/base_paths.h"
 #include "base/base_switches.h"
 #include "base/bind.h"
 #include "base/command_line.h"
@@ -17,12 +18,16 @@
 #include "base/memory/scoped_vector.h"
 #include "base/path_service.h"
 #include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
+#include "base/threading/work_stealing_pool.h"
 #include "base/trace_event/trace_event.h"
 #include "build/build_config.h"
+#include "mojo/common/bindings_trace_instrumentation.h"
 #include "mojo/common/trace_provider_impl.h"
 #include "mojo/common/tracing_impl.h"
+#include "mojo/edk/base_edk/memory_dump_provider_impl.h"
 #include "mojo/edk/embedder/embedder.h"
 #include "mojo/edk/embedder/multiprocess_embedder.h"
 #include "mojo/edk/embedder/simple_platform_support.h"
@@ -35,10 +40,12 @@
 #include "shell/application_manager/application_manager.h"
 #include "shell/application_manager/native_application_options.h"
 #include "shell/background_application_loader.h"
+#include "shell/child_process_pool.h"
 #include "shell/command_line_util.h"
 #include "shell/filename_util.h"
 #include "shell/in_process_native_runner.h"
 #include "shell/out_of_process_native_runner.h"
+#include "shell/startup_timeline.h"
 #include "shell/switches.h"
 #include "shell/tracer.h"
 #include "url/gurl.h"
@@ -68,6 +75,19 @@ class Setup {
   DISALLOW_COPY_AND_ASSIGN(Setup);
 };
 
+// Returns the path of the dependency preload manifest, which is kept next to
+// the URL response disk cache (see url_response_disk_cache_impl.cc).
+base::FilePath GetDefaultPreloadManifestPath() {
+  base::FilePath home_dir;
+  PathService::Get(base::DIR_HOME, &home_dir);
+  return home_dir.Append(".mojo_url_response_disk_cache")
+      .Append("preload_manifest.json");
+}
+
+// How long an app must not have been connected to before it may be reaped (see
+// --reap-idle-apps).
+const int64_t kMinIdleTimeSeconds = 60;
+
 ApplicationManager::Options MakeApplicationManagerOptions() {
   ApplicationManager::Options options;
   options.disable_cache = base::CommandLine::ForCurrentProcess()->HasSwitch(
@@ -287,12 +307,17 @@ bool Context::InitWithPaths(
     const base::FilePath& shell_child_path,
     mojo::URLResponseDiskCacheDelegate* url_response_disk_cache_delegate) {
   TRACE_EVENT0("mojo_shell", "Context::InitWithPaths");
+  ScopedStartupPhase startup_phase("ContextInit", std::string());
   const base::CommandLine& command_line =
       *base::CommandLine::ForCurrentProcess();
 
   if (command_line.HasSwitch(switches::kWaitForDebugger))
     base::debug::WaitForDebugger(60, true);
 
+  // Before any bindings are bound.
+  if (command_line.HasSwitch(switches::kTraceBindings))
+    mojo::BindingsTraceInstrumentation::Install();
+
   mojo_shell_child_path_ = shell_child_path;
 
   task_runners_.reset(
@@ -308,7 +333,12 @@ bool Context::InitWithPaths(
       GURL("mojo:url_response_disk_cache"));
 #endif
 
+  application_manager()->SetLoaderForURL(histogram_aggregator_.CreateLoader(),
+                                         GURL("mojo:histograms"));
+
+  BeginStartupPhase("InitEmbedder", std::string());
   EnsureEmbedderIsInitialized();
+  EndStartupPhase("InitEmbedder", std::string());
 
   // TODO(vtl): Probably these failures should be checked before |Init()|, and
   // this function simply shouldn't fail.
@@ -316,21 +346,63 @@ bool Context::InitWithPaths(
     return false;
   if (!ConfigureURLMappings(command_line, this))
     return false;
+  size_t child_process_pool_size = 0;
+  if (command_line.HasSwitch(switches::kChildProcessPoolSize) &&
+      !base::StringToSizeT(
+          command_line.GetSwitchValueASCII(switches::kChildProcessPoolSize),
+          &child_process_pool_size)) {
+    LOG(ERROR) << "Invalid value for switch "
+               << switches::kChildProcessPoolSize;
+    return false;
+  }
+  size_t idle_memory_budget_mb = 0;
+  if (command_line.HasSwitch(switches::kReapIdleApps) &&
+      !command_line.GetSwitchValueASCII(switches::kReapIdleApps).empty() &&
+      !base::StringToSizeT(
+          command_line.GetSwitchValueASCII(switches::kReapIdleApps),
+          &idle_memory_budget_mb)) {
+    LOG(ERROR) << "Invalid value for switch " << switches::kReapIdleApps;
+    return false;
+  }
 
+  BeginStartupPhase("InitIPCSupport", std::string());
   mojo::embedder::InitIPCSupport(mojo::embedder::ProcessType::MASTER,
                                  task_runners_->shell_runner().Clone(), this,
                                  task_runners_->io_runner().Clone(),
                                  task_runners_->io_watcher(),
                                  mojo::platform::ScopedPlatformHandle());
+  EndStartupPhase("InitIPCSupport", std::string());
+  base_edk::MemoryDumpProviderImpl::Install(
+      task_runners_->io_thread_task_runner());
 
   scoped_ptr<NativeRunnerFactory> runner_factory;
-  if (command_line.HasSwitch(switches::kEnableMultiprocess))
+  if (command_line.HasSwitch(switches::kEnableMultiprocess)) {
     runner_factory.reset(new OutOfProcessNativeRunnerFactory(this));
-  else
+    if (child_process_pool_size)
+      child_process_pool_.reset(
+          new ChildProcessPool(this, child_process_pool_size));
+  } else {
     runner_factory.reset(new InProcessNativeRunnerFactory(this));
+  }
   application_manager_.set_blocking_pool(task_runners_->blocking_pool());
   application_manager_.set_native_runner_factory(runner_factory.Pass());
 
+  if (command_line.HasSwitch(switches::kPreloadDependencies)) {
+    base::FilePath manifest_path =
+        command_line.GetSwitchValuePath(switches::kPreloadDependencies);
+    if (manifest_path.empty())
+      manifest_path = GetDefaultPreloadManifestPath();
+    // Loading libraries ahead of time only helps if they're run in process.
+    application_manager_.EnablePreloading(
+        manifest_path, !command_line.HasSwitch(switches::kEnableMultiprocess));
+  }
+
+  if (command_line.HasSwitch(switches::kReapIdleApps)) {
+    application_manager_.EnableIdleReaping(
+        idle_memory_budget_mb * 1024 * 1024,
+        base::TimeDelta::FromSeconds(kMinIdleTimeSeconds));
+  }
+
   InitContentHandlers(&application_manager_, command_line);
   InitNativeOptions(&application_manager_, command_line);
 
@@ -363,6 +435,9 @@ bool Context::InitWithPaths(
 void Context::Shutdown() {
   TRACE_EVENT0("mojo_shell", "Context::Shutdown");
   DCHECK(task_runners_->shell_runner()->RunsTasksOnCurrentThread());
+  // Pooled child processes must be told to exit while we can still talk to
+  // them.
+  child_process_pool_.reset();
   mojo::embedder::ShutdownIPCSupport();
   // We'll quit when we get OnShutdownComplete().
   base::MessageLoop::current()->Run();
@@ -376,6 +451,10 @@ GURL Context::ResolveMojoURL(const GURL& url) {
   return url_resolver_.ResolveMojoURL(url);
 }
 
+uint64_t Context::GetMappingsVersion() {
+  return url_resolver_.version();
+}
+
 void Context::OnShutdownComplete() {
   DCHECK(task_runners_->shell_runner()->RunsTasksOnCurrentThread());
   base::MessageLoop::current()->Quit();
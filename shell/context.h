@@ -10,6 +10,7 @@
 #include "base/macros.h"
 #include "mojo/edk/embedder/master_process_delegate.h"
 #include "shell/application_manager/application_manager.h"
+#include "shell/histogram_aggregator.h"
 #include "shell/task_runners.h"
 #include "shell/url_resolver.h"
 
@@ -18,6 +19,7 @@ class URLResponseDiskCacheDelegate;
 }
 
 namespace shell {
+class ChildProcessPool;
 class Tracer;
 
 // The "global" context for the shell's main process.
@@ -72,6 +74,12 @@ class Context : public ApplicationManager::Delegate,
     return mojo_shell_child_path_;
   }
   TaskRunners* task_runners() { return task_runners_.get(); }
+  // Null unless running apps out of process with a child process pool (see
+  // --child-process-pool-size).
+  ChildProcessPool* child_process_pool() { return child_process_pool_.get(); }
+  HistogramAggregator* histogram_aggregator() {
+    return &histogram_aggregator_;
+  }
 
  private:
   class NativeViewportApplicationLoader;
@@ -79,6 +87,7 @@ class Context : public ApplicationManager::Delegate,
   // ApplicationManager::Delegate overrides.
   GURL ResolveMappings(const GURL& url) override;
   GURL ResolveMojoURL(const GURL& url) override;
+  uint64_t GetMappingsVersion() override;
 
   // MasterProcessDelegate implementation.
   void OnShutdownComplete() override;
@@ -87,11 +96,14 @@ class Context : public ApplicationManager::Delegate,
   void OnApplicationEnd(const GURL& url);
 
   Tracer* const tracer_;
+  // Outlives |application_manager_|, which owns the child process hosts.
+  HistogramAggregator histogram_aggregator_;
   ApplicationManager application_manager_;
   URLResolver url_resolver_;
 
   base::FilePath mojo_shell_child_path_;
   scoped_ptr<TaskRunners> task_runners_;
+  scoped_ptr<ChildProcessPool> child_process_pool_;
 
   std::set<GURL> app_urls_;
   GURL shell_file_root_;
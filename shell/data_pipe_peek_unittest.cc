@@ -4,6 +4,13 @@
 
 #include "shell/application_manager/data_pipe_peek.h"
 
+#include <string.h>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "mojo/message_pump/message_pump_mojo.h"
 #include "shell/context.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -107,5 +114,124 @@ TEST(DataPipePeek, PeekLine) {
   EXPECT_FALSE(BlockingPeekLine(consumer, &str, max_str_length, timeout));
 }
 
+// Records the result of an asynchronous peek.
+struct AsyncPeekResult {
+  AsyncPeekResult() : done(false), success(false) {}
+
+  bool done;
+  bool success;
+  std::string value;
+  mojo::ScopedDataPipeConsumerHandle source;
+};
+
+void OnPeeked(AsyncPeekResult* result,
+              const base::Closure& quit_closure,
+              bool success,
+              const std::string& value,
+              mojo::ScopedDataPipeConsumerHandle source) {
+  EXPECT_FALSE(result->done);
+  result->done = true;
+  result->success = success;
+  result->value = value;
+  result->source = source.Pass();
+  quit_closure.Run();
+}
+
+void WriteString(mojo::DataPipeProducerHandle producer, const char* s) {
+  uint32_t num_bytes = static_cast<uint32_t>(strlen(s));
+  EXPECT_EQ(MOJO_RESULT_OK,
+            WriteDataRaw(producer, s, &num_bytes, MOJO_WRITE_DATA_FLAG_NONE));
+  EXPECT_EQ(strlen(s), num_bytes);
+}
+
+TEST(DataPipePeek, AsyncPeekLine) {
+  Context::EnsureEmbedderIsInitialized();
+  base::MessageLoop message_loop(
+      scoped_ptr<base::MessagePump>(new mojo::common::MessagePumpMojo()));
+
+  mojo::DataPipe data_pipe;
+  mojo::DataPipeProducerHandle producer(data_pipe.producer_handle.get());
+  WriteString(producer, "12");
+
+  base::RunLoop run_loop;
+  AsyncPeekResult result;
+  PeekLine(data_pipe.consumer_handle.Pass(), 10, MOJO_DEADLINE_INDEFINITE,
+           base::Bind(&OnPeeked, &result, run_loop.QuitClosure()));
+  // The callback is never called synchronously.
+  EXPECT_FALSE(result.done);
+
+  // The rest of the line is written by tasks that can only run because the
+  // peek doesn't block the thread.
+  message_loop.PostTask(FROM_HERE, base::Bind(&WriteString, producer, "34"));
+  message_loop.PostTask(FROM_HERE, base::Bind(&WriteString, producer, "\nx"));
+  run_loop.Run();
+
+  EXPECT_TRUE(result.done);
+  EXPECT_TRUE(result.success);
+  EXPECT_EQ("1234\n", result.value);
+
+  // Nothing was consumed from the data pipe, which is handed back.
+  std::string bytes;
+  EXPECT_TRUE(BlockingPeekNBytes(result.source.get(), &bytes, 6, 0));
+  EXPECT_EQ("1234\nx", bytes);
+}
+
+TEST(DataPipePeek, AsyncPeekNBytesFailure) {
+  Context::EnsureEmbedderIsInitialized();
+  base::MessageLoop message_loop(
+      scoped_ptr<base::MessagePump>(new mojo::common::MessagePumpMojo()));
+
+  // Peeking for 5 bytes when only 4 are available times out.
+  mojo::DataPipe data_pipe1;
+  WriteString(data_pipe1.producer_handle.get(), "1234");
+  AsyncPeekResult result1;
+  {
+    base::RunLoop run_loop;
+    PeekNBytes(data_pipe1.consumer_handle.Pass(), 5, 20 * 1000,  // 20 ms
+               base::Bind(&OnPeeked, &result1, run_loop.QuitClosure()));
+    run_loop.Run();
+  }
+  EXPECT_TRUE(result1.done);
+  EXPECT_FALSE(result1.success);
+  EXPECT_TRUE(result1.source.is_valid());
+
+  // It fails without timing out if the producer is closed.
+  mojo::DataPipe data_pipe2;
+  WriteString(data_pipe2.producer_handle.get(), "1234");
+  data_pipe2.producer_handle.reset();
+  AsyncPeekResult result2;
+  {
+    base::RunLoop run_loop;
+    PeekNBytes(data_pipe2.consumer_handle.Pass(), 5, MOJO_DEADLINE_INDEFINITE,
+               base::Bind(&OnPeeked, &result2, run_loop.QuitClosure()));
+    run_loop.Run();
+  }
+  EXPECT_TRUE(result2.done);
+  EXPECT_FALSE(result2.success);
+}
+
+TEST(DataPipePeek, ConcurrentAsyncPeeks) {
+  Context::EnsureEmbedderIsInitialized();
+  base::MessageLoop message_loop(
+      scoped_ptr<base::MessagePump>(new mojo::common::MessagePumpMojo()));
+
+  const size_t kNumPeeks = 10;
+  mojo::DataPipe data_pipes[kNumPeeks];
+  AsyncPeekResult results[kNumPeeks];
+  base::RunLoop run_loops[kNumPeeks];
+  for (size_t i = 0; i < kNumPeeks; i++) {
+    PeekNBytes(data_pipes[i].consumer_handle.Pass(), 2,
+               MOJO_DEADLINE_INDEFINITE,
+               base::Bind(&OnPeeked, &results[i], run_loops[i].QuitClosure()));
+  }
+  // Satisfy the peeks in reverse order.
+  for (size_t i = kNumPeeks; i > 0; i--) {
+    WriteString(data_pipes[i - 1].producer_handle.get(), "ab");
+    run_loops[i - 1].Run();
+    EXPECT_TRUE(results[i - 1].success);
+    EXPECT_EQ("ab", results[i - 1].value);
+  }
+}
+
 }  // namespace
 }  // namespace shell
@@ -18,8 +18,10 @@
 #include "base/synchronization/waitable_event.h"
 #include "base/trace_event/trace_event.h"
 #include "shell/command_line_util.h"
+#include "shell/child_switches.h"
 #include "shell/context.h"
 #include "shell/init.h"
+#include "shell/startup_timeline.h"
 #include "shell/switches.h"
 #include "shell/tracer.h"
 
@@ -30,11 +32,15 @@ void Usage() {
   std::cerr
       << "Usage: mojo_shell"
       << " [--" << switches::kArgsFor << "=<mojo-app>]"
+      << " [--" << switches::kChildProcessPoolSize << "=<count>]"
       << " [--" << switches::kContentHandlers << "=<handlers>]"
       << " [--" << switches::kCPUProfile << "]"
       << " [--" << switches::kDisableCache << "]"
       << " [--" << switches::kEnableMultiprocess << "]"
       << " [--" << switches::kOrigin << "=<url-lib-path>]"
+      << " [--" << switches::kPreloadDependencies << "[=<manifest-path>]]"
+      << " [--" << switches::kReapIdleApps << "[=<memory-budget-mb>]]"
+      << " [--" << switches::kStartupTimeline << "=<file_name>]"
       << " [--" << switches::kTraceStartup << "[=\"list,of,categories\"]]"
       << " [--" << switches::kTraceStartupDuration << "=<seconds>]"
       << " [--" << switches::kTraceStartupOutputName << "=<file_name>]"
@@ -77,6 +83,13 @@ int main(int argc, char** argv) {
     }
   }
 
+  // Before any other thread is started.
+  if (command_line.HasSwitch(switches::kStartupTimeline)) {
+    shell::EnableStartupTimeline(
+        command_line.GetSwitchValuePath(switches::kStartupTimeline), true,
+        "ShellStart");
+  }
+
   bool trace_startup = command_line.HasSwitch(switches::kTraceStartup);
   if (trace_startup) {
     std::string output_name =
@@ -0,0 +1,99 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/histogram_aggregator.h"
+
+#include <vector>
+
+#include "base/logging.h"
+#include "base/metrics/shared_histogram_allocator.h"
+#include "mojo/public/cpp/application/application_connection.h"
+#include "shell/application_manager/application_loader.h"
+
+namespace shell {
+
+class HistogramAggregator::Loader : public ApplicationLoader {
+ public:
+  explicit Loader(HistogramAggregator* aggregator) : aggregator_(aggregator) {}
+  ~Loader() override {}
+
+ private:
+  // |ApplicationLoader| override:
+  void Load(
+      const GURL& url,
+      mojo::InterfaceRequest<mojo::Application> application_request) override {
+    DCHECK(application_request.is_pending());
+    aggregator_->application_.reset(
+        new mojo::ApplicationImpl(aggregator_, application_request.Pass()));
+  }
+
+  HistogramAggregator* const aggregator_;
+
+  DISALLOW_COPY_AND_ASSIGN(Loader);
+};
+
+// static
+const size_t HistogramAggregator::kArenaNumBytes;
+
+HistogramAggregator::HistogramAggregator() {}
+
+HistogramAggregator::~HistogramAggregator() {
+  DCHECK(arenas_.empty());
+}
+
+scoped_ptr<ApplicationLoader> HistogramAggregator::CreateLoader() {
+  return make_scoped_ptr(new Loader(this));
+}
+
+void HistogramAggregator::AddArena(const base::SharedHistogramAllocator* arena,
+                                   const std::string& source) {
+  arenas_[arena] = source;
+}
+
+void HistogramAggregator::RemoveArena(
+    const base::SharedHistogramAllocator* arena) {
+  arenas_.erase(arena);
+}
+
+bool HistogramAggregator::ConfigureIncomingConnection(
+    mojo::ApplicationConnection* connection) {
+  connection->AddService<histograms::HistogramCollector>(this);
+  return true;
+}
+
+void HistogramAggregator::Create(
+    mojo::ApplicationConnection* connection,
+    mojo::InterfaceRequest<histograms::HistogramCollector> request) {
+  bindings_.AddBinding(this, request.Pass());
+}
+
+void HistogramAggregator::GetHistograms(
+    const GetHistogramsCallback& callback) {
+  auto result = mojo::Array<histograms::HistogramPtr>::New(0);
+  std::vector<base::SharedHistogramAllocator::HistogramData> arena_histograms;
+  for (const auto& arena : arenas_) {
+    arena_histograms.clear();
+    arena.first->GetHistograms(&arena_histograms);
+    for (const auto& data : arena_histograms) {
+      auto histogram = histograms::Histogram::New();
+      histogram->source = arena.second;
+      histogram->name = data.name;
+      histogram->sum = data.sum;
+      histogram->buckets = mojo::Array<histograms::HistogramBucketPtr>::New(0);
+      for (size_t i = 0; i < data.counts.size(); i++) {
+        if (!data.counts[i])
+          continue;
+        auto bucket = histograms::HistogramBucket::New();
+        bucket->min = data.ranges[i];
+        bucket->max = data.ranges[i + 1];
+        bucket->count = data.counts[i];
+        histogram->buckets.push_back(bucket.Pass());
+      }
+      result.push_back(histogram.Pass());
+    }
+  }
+  callback.Run(result.Pass());
+}
+
+}  // namespace shell
@@ -0,0 +1,79 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SHELL_HISTOGRAM_AGGREGATOR_H_
+#define SHELL_HISTOGRAM_AGGREGATOR_H_
+
+#include <map>
+#include <string>
+
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "mojo/common/binding_set.h"
+#include "mojo/public/cpp/application/application_delegate.h"
+#include "mojo/public/cpp/application/application_impl.h"
+#include "mojo/public/cpp/application/interface_factory.h"
+#include "mojo/services/histograms/interfaces/histograms.mojom.h"
+
+namespace base {
+class SharedHistogramAllocator;
+}
+
+namespace shell {
+
+class ApplicationLoader;
+
+// Keeps track of the shared histogram arenas of the child processes (see
+// |base::SharedHistogramAllocator|), and implements the "mojo:histograms"
+// application, which reads the histograms from all of them.
+//
+// This class is not thread-safe. It should be created/used/destroyed on the
+// shell thread.
+class HistogramAggregator
+    : public mojo::ApplicationDelegate,
+      public mojo::InterfaceFactory<histograms::HistogramCollector>,
+      public histograms::HistogramCollector {
+ public:
+  // Size of the arena of each child process.
+  static const size_t kArenaNumBytes = 512 * 1024;
+
+  HistogramAggregator();
+  ~HistogramAggregator() override;
+
+  // Returns a loader for "mojo:histograms". It must not outlive this object.
+  scoped_ptr<ApplicationLoader> CreateLoader();
+
+  // |histograms::HistogramCollector|:
+  void GetHistograms(const GetHistogramsCallback& callback) override;
+
+  // Adds |arena|, whose histograms are attributed to |source|, until it is
+  // removed. Adding an arena again changes its source; removing an arena which
+  // wasn't added does nothing.
+  void AddArena(const base::SharedHistogramAllocator* arena,
+                const std::string& source);
+  void RemoveArena(const base::SharedHistogramAllocator* arena);
+
+ private:
+  class Loader;
+
+  // |mojo::ApplicationDelegate|:
+  bool ConfigureIncomingConnection(
+      mojo::ApplicationConnection* connection) override;
+
+  // |mojo::InterfaceFactory<histograms::HistogramCollector>|:
+  void Create(
+      mojo::ApplicationConnection* connection,
+      mojo::InterfaceRequest<histograms::HistogramCollector> request) override;
+
+  std::map<const base::SharedHistogramAllocator*, std::string> arenas_;
+
+  scoped_ptr<mojo::ApplicationImpl> application_;
+  mojo::BindingSet<histograms::HistogramCollector> bindings_;
+
+  DISALLOW_COPY_AND_ASSIGN(HistogramAggregator);
+};
+
+}  // namespace shell
+
+#endif  // SHELL_HISTOGRAM_AGGREGATOR_H_
@@ -0,0 +1,77 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/histogram_aggregator.h"
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/shared_histogram_allocator.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace shell {
+namespace {
+
+const size_t kArenaSize = 16 * 1024;
+
+mojo::Array<histograms::HistogramPtr> GetHistograms(
+    HistogramAggregator* aggregator) {
+  mojo::Array<histograms::HistogramPtr> result;
+  aggregator->GetHistograms(
+      [&result](mojo::Array<histograms::HistogramPtr> histograms) {
+        result = histograms.Pass();
+      });
+  return result;
+}
+
+TEST(HistogramAggregatorTest, ReadsArenas) {
+  std::vector<uint64_t> memory1(kArenaSize / sizeof(uint64_t));
+  std::vector<uint64_t> memory2(kArenaSize / sizeof(uint64_t));
+  scoped_ptr<base::SharedHistogramAllocator> arena1 =
+      base::SharedHistogramAllocator::Create(&memory1[0], kArenaSize);
+  scoped_ptr<base::SharedHistogramAllocator> arena2 =
+      base::SharedHistogramAllocator::Create(&memory2[0], kArenaSize);
+  ASSERT_TRUE(arena1);
+  ASSERT_TRUE(arena2);
+
+  base::HistogramBase* histogram1 = arena1->GetOrCreateHistogram(
+      base::LINEAR_HISTOGRAM, "Test.Histogram", 1, 10, 11,
+      base::HistogramBase::kNoFlags);
+  ASSERT_TRUE(histogram1);
+  histogram1->Add(2);
+  histogram1->Add(2);
+  histogram1->Add(7);
+
+  HistogramAggregator aggregator;
+  EXPECT_EQ(0u, GetHistograms(&aggregator).size());
+
+  aggregator.AddArena(arena1.get(), "app1");
+  aggregator.AddArena(arena2.get(), "app2");
+  auto histograms = GetHistograms(&aggregator);
+  ASSERT_EQ(1u, histograms.size());
+  EXPECT_EQ("app1", histograms[0]->source);
+  EXPECT_EQ("Test.Histogram", histograms[0]->name);
+  EXPECT_EQ(11, histograms[0]->sum);
+  // Only the buckets with samples are returned.
+  ASSERT_EQ(2u, histograms[0]->buckets.size());
+  EXPECT_EQ(2, histograms[0]->buckets[0]->min);
+  EXPECT_EQ(3, histograms[0]->buckets[0]->max);
+  EXPECT_EQ(2, histograms[0]->buckets[0]->count);
+  EXPECT_EQ(7, histograms[0]->buckets[1]->min);
+  EXPECT_EQ(1, histograms[0]->buckets[1]->count);
+
+  // Samples recorded later are read directly from the arena.
+  histogram1->Add(7);
+  histograms = GetHistograms(&aggregator);
+  ASSERT_EQ(1u, histograms.size());
+  EXPECT_EQ(2, histograms[0]->buckets[1]->count);
+
+  aggregator.RemoveArena(arena1.get());
+  aggregator.RemoveArena(arena2.get());
+  EXPECT_EQ(0u, GetHistograms(&aggregator).size());
+}
+
+}  // namespace
+}  // namespace shell
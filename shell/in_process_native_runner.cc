@@ -10,6 +10,7 @@
 #include "base/thread_task_runner_handle.h"
 #include "base/threading/platform_thread.h"
 #include "shell/native_application_support.h"
+#include "shell/startup_timeline.h"
 
 namespace shell {
 
@@ -56,6 +57,7 @@ void InProcessNativeRunner::Run() {
   // TODO(vtl): ScopedNativeLibrary doesn't have a .get() method!
   base::NativeLibrary app_library = LoadNativeApplication(app_path_);
   app_library_.Reset(app_library);
+  MarkStartupEvent("MojoMain", app_path_.AsUTF8Unsafe());
   RunNativeApplication(app_library, application_request_.Pass());
   app_completed_callback_runner_.Run();
   app_completed_callback_runner_.Reset();
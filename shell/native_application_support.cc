@@ -26,6 +26,7 @@
 #include "mojo/public/platform/native/mgl_thunks.h"
 #include "mojo/public/platform/native/system_impl_private_thunks.h"
 #include "mojo/public/platform/native/system_thunks.h"
+#include "shell/startup_timeline.h"
 
 namespace shell {
 
@@ -54,6 +55,7 @@ bool SetThunks(Thunks (*make_thunks)(),
 
 base::NativeLibrary LoadNativeApplication(const base::FilePath& app_path) {
   DVLOG(2) << "Loading Mojo app in process from library: " << app_path.value();
+  ScopedStartupPhase phase("LoadLibrary", app_path.AsUTF8Unsafe());
 
   base::NativeLibraryLoadError error;
   base::NativeLibrary app_library = base::LoadNativeLibrary(app_path, &error);
@@ -62,6 +64,23 @@ base::NativeLibrary LoadNativeApplication(const base::FilePath& app_path) {
   return app_library;
 }
 
+bool SetNativeApplicationHistogramArena(base::NativeLibrary app_library,
+                                        void* memory,
+                                        size_t num_bytes) {
+  if (!app_library)
+    return false;
+
+  typedef void (*MojoSetHistogramArenaFunction)(void*, size_t);
+  MojoSetHistogramArenaFunction set_histogram_arena =
+      reinterpret_cast<MojoSetHistogramArenaFunction>(
+          base::GetFunctionPointerFromNativeLibrary(app_library,
+                                                    "MojoSetHistogramArena"));
+  if (!set_histogram_arena)
+    return false;
+  set_histogram_arena(memory, num_bytes);
+  return true;
+}
+
 bool RunNativeApplication(
     base::NativeLibrary app_library,
     mojo::InterfaceRequest<mojo::Application> application_request) {
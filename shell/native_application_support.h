@@ -5,6 +5,8 @@
 #ifndef SHELL_NATIVE_APPLICATION_SUPPORT_H_
 #define SHELL_NATIVE_APPLICATION_SUPPORT_H_
 
+#include <stddef.h>
+
 #include "base/native_library.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
 
@@ -28,6 +30,16 @@ namespace shell {
 // thread-local destructors have been executed.
 base::NativeLibrary LoadNativeApplication(const base::FilePath& app_path);
 
+// Gives the native Mojo application from the DSO that was loaded using
+// |LoadNativeApplication()| the |num_bytes| shared histogram arena at |memory|
+// (see |base::SharedHistogramAllocator|) to record its histograms in, if it
+// supports it (i.e., if it exports |MojoSetHistogramArena()|, as applications
+// using |mojo::ApplicationRunnerChromium| do). This should be called before
+// |RunNativeApplication()|. Returns true if the application took the arena.
+bool SetNativeApplicationHistogramArena(base::NativeLibrary app_library,
+                                        void* memory,
+                                        size_t num_bytes);
+
 // Runs the native Mojo application from the DSO that was loaded using
 // |LoadNativeApplication()|; this tolerates |app_library| being null. This
 // should be called on the same thread as |LoadNativeApplication()|. Returns
@@ -2,7 +2,15 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
 #include "base/files/scoped_temp_dir.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/run_loop.h"
 #include "shell/application_manager/application_manager.h"
 #include "shell/application_manager/native_application_options.h"
 #include "shell/context.h"
@@ -21,6 +29,13 @@ struct TestState {
   bool runner_was_created;
   bool runner_was_started;
   bool runner_was_destroyed;
+  // Called when a runner is started, if not null.
+  base::Closure runner_started_callback;
+  // The path of the application of the last runner started.
+  base::FilePath started_app_path;
+  // The application's end of its pipe, for the last runner started. Resetting
+  // it is like the application quitting.
+  mojo::InterfaceRequest<mojo::Application> application_request;
 };
 
 class TestNativeRunner : public NativeRunner {
@@ -36,6 +51,11 @@ class TestNativeRunner : public NativeRunner {
              mojo::InterfaceRequest<mojo::Application> application_request,
              const base::Closure& app_completed_callback) override {
     state_->runner_was_started = true;
+    state_->started_app_path = app_path;
+    // Keep the application's end of its pipes open (as if it were running).
+    state_->application_request = application_request.Pass();
+    if (!state_->runner_started_callback.is_null())
+      state_->runner_started_callback.Run();
   }
 
  private:
@@ -72,6 +92,16 @@ class NativeApplicationLoaderTest : public testing::Test,
   void TearDown() override { context_.Shutdown(); }
 
  protected:
+  // Runs the loop until a runner is started. The application is fetched on
+  // |blocking_pool()|, so it may take more than running the tasks pending on
+  // the loop.
+  void WaitForRunnerStart() {
+    base::RunLoop run_loop;
+    state_.runner_started_callback = run_loop.QuitClosure();
+    run_loop.Run();
+    state_.runner_started_callback.Reset();
+  }
+
   shell::Context context_;
   base::MessageLoop loop_;
   ApplicationManager application_manager_;
@@ -81,6 +111,7 @@ class NativeApplicationLoaderTest : public testing::Test,
   // ApplicationManager::Delegate
   GURL ResolveMappings(const GURL& url) override { return url; }
   GURL ResolveMojoURL(const GURL& url) override { return url; }
+  uint64_t GetMappingsVersion() override { return 0; }
 };
 
 TEST_F(NativeApplicationLoaderTest, DoesNotExist) {
@@ -97,5 +128,144 @@ TEST_F(NativeApplicationLoaderTest, DoesNotExist) {
   EXPECT_FALSE(state_.runner_was_destroyed);
 }
 
+TEST_F(NativeApplicationLoaderTest, ReapIdleApplications) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath app_path(temp_dir.path().Append(FILE_PATH_LITERAL("app")));
+  ASSERT_EQ(0, base::WriteFile(app_path, "", 0));
+  GURL url(FilePathToFileURL(app_path));
+  ApplicationManager::TestAPI test_api(&application_manager_);
+
+  mojo::ServiceProviderPtr services;
+  application_manager_.ConnectToApplication(url, GURL("test:requestor"),
+                                            mojo::GetProxy(&services), nullptr,
+                                            base::Closure());
+  WaitForRunnerStart();
+  EXPECT_TRUE(state_.runner_was_started);
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+
+  // The application has been connected to too recently to be reaped.
+  application_manager_.EnableIdleReaping(0u, base::TimeDelta::FromHours(1));
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  loop_.RunUntilIdle();
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+
+  // It's asked to quit, and kept until it has.
+  application_manager_.EnableIdleReaping(0u, base::TimeDelta());
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  loop_.RunUntilIdle();
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+
+  // The next connection waits for it to quit, rather than starting a second
+  // instance alongside.
+  state_.runner_was_started = false;
+  mojo::ServiceProviderPtr services2;
+  application_manager_.ConnectToApplication(url, GURL("test:requestor"),
+                                            mojo::GetProxy(&services2), nullptr,
+                                            base::Closure());
+  loop_.RunUntilIdle();
+  EXPECT_FALSE(state_.runner_was_started);
+
+  // Then it's started again.
+  state_.application_request = nullptr;
+  WaitForRunnerStart();
+  EXPECT_TRUE(state_.runner_was_started);
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+}
+
+TEST_F(NativeApplicationLoaderTest, ReapedApplicationThatNeverQuits) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath app_path(temp_dir.path().Append(FILE_PATH_LITERAL("app")));
+  ASSERT_EQ(0, base::WriteFile(app_path, "", 0));
+  GURL url(FilePathToFileURL(app_path));
+  ApplicationManager::TestAPI test_api(&application_manager_);
+  test_api.SetQuitTimeout(base::TimeDelta::FromMilliseconds(100));
+
+  mojo::ServiceProviderPtr services;
+  application_manager_.ConnectToApplication(url, GURL("test:requestor"),
+                                            mojo::GetProxy(&services), nullptr,
+                                            base::Closure());
+  WaitForRunnerStart();
+
+  // The application is asked to quit, but keeps its end of its pipe open.
+  application_manager_.EnableIdleReaping(0u, base::TimeDelta());
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  loop_.RunUntilIdle();
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+  state_.runner_was_started = false;
+  mojo::ServiceProviderPtr services2;
+  application_manager_.ConnectToApplication(url, GURL("test:requestor"),
+                                            mojo::GetProxy(&services2), nullptr,
+                                            base::Closure());
+  loop_.RunUntilIdle();
+  EXPECT_FALSE(state_.runner_was_started);
+
+  // Once the quit timeout has passed, it's dropped, and the connection that
+  // waited for it starts a new instance.
+  WaitForRunnerStart();
+  EXPECT_TRUE(state_.runner_was_started);
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+}
+
+TEST_F(NativeApplicationLoaderTest, DontReapApplicationsUsedByShell) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath app_path(temp_dir.path().Append(FILE_PATH_LITERAL("app")));
+  ASSERT_EQ(0, base::WriteFile(app_path, "", 0));
+  GURL url(FilePathToFileURL(app_path));
+  ApplicationManager::TestAPI test_api(&application_manager_);
+
+  mojo::ServiceProviderPtr services;
+  application_manager_.ConnectToApplication(
+      url, GURL(), mojo::GetProxy(&services), nullptr, base::Closure());
+  WaitForRunnerStart();
+  EXPECT_TRUE(state_.runner_was_started);
+
+  application_manager_.EnableIdleReaping(0u, base::TimeDelta());
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  loop_.RunUntilIdle();
+  EXPECT_TRUE(test_api.HasFactoryForURL(url));
+}
+
+TEST_F(NativeApplicationLoaderTest, StalledFetchDoesntBlockOtherApplications) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  // Reading a FIFO stalls until something writes to it.
+  base::FilePath stalled_path(
+      temp_dir.path().Append(FILE_PATH_LITERAL("stalled")));
+  ASSERT_EQ(0, mkfifo(stalled_path.value().c_str(), 0600));
+  base::FilePath app_path(temp_dir.path().Append(FILE_PATH_LITERAL("app")));
+  ASSERT_EQ(0, base::WriteFile(app_path, "", 0));
+
+  mojo::ServiceProviderPtr stalled_services;
+  application_manager_.ConnectToApplication(
+      FilePathToFileURL(stalled_path), GURL(),
+      mojo::GetProxy(&stalled_services), nullptr, base::Closure());
+  loop_.RunUntilIdle();
+  EXPECT_FALSE(state_.runner_was_started);
+
+  // Another application is still started while the first one's fetch stalls.
+  mojo::ServiceProviderPtr services;
+  application_manager_.ConnectToApplication(FilePathToFileURL(app_path), GURL(),
+                                            mojo::GetProxy(&services), nullptr,
+                                            base::Closure());
+  WaitForRunnerStart();
+  EXPECT_EQ(app_path, state_.started_app_path);
+
+  // Once the FIFO has been written to, the first one is started too. It's
+  // opened for writing and reading both, so that neither this nor the fetch
+  // blocks in open(), and what's written stays there until the fetch reads it.
+  base::ScopedFD fifo(HANDLE_EINTR(open(stalled_path.value().c_str(), O_RDWR)));
+  ASSERT_TRUE(fifo.is_valid());
+  ASSERT_TRUE(base::WriteFileDescriptor(fifo.get(), "garbage", 7));
+  WaitForRunnerStart();
+  EXPECT_EQ(stalled_path, state_.started_app_path);
+}
+
 }  // namespace
 }  // namespace shell
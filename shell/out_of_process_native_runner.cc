@@ -14,7 +14,10 @@
 #include "base/strings/string_util.h"
 #include "shell/child_controller.mojom.h"
 #include "shell/child_process_host.h"
+#include "shell/child_process_pool.h"
+#include "shell/context.h"
 #include "shell/in_process_native_runner.h"
+#include "shell/startup_timeline.h"
 
 namespace {
 
@@ -68,20 +71,30 @@ void OutOfProcessNativeRunner::Start(
   DCHECK(app_completed_callback_.is_null());
   app_completed_callback_ = app_completed_callback;
 
-  child_process_host_.reset(new ChildProcessHost(context_));
-
   NativeApplicationOptions options = options_;
   if (Require32Bit(app_path))
     options.require_32_bit = true;
-  child_process_host_->Start(options);
+
+  if (context_->child_process_pool())
+    child_process_host_ = context_->child_process_pool()->TakeHost(options);
+  if (!child_process_host_) {
+    child_process_host_.reset(new ChildProcessHost(context_));
+    child_process_host_->Start(options);
+  }
 
   // TODO(vtl): |app_path.AsUTF8Unsafe()| is unsafe.
+  MarkStartupEvent("StartChildApp", app_path.AsUTF8Unsafe());
   child_process_host_->StartApp(
       app_path.AsUTF8Unsafe(), application_request.Pass(),
       base::Bind(&OutOfProcessNativeRunner::AppCompleted,
                  base::Unretained(this)));
 }
 
+base::ProcessHandle OutOfProcessNativeRunner::GetProcessHandle() const {
+  return child_process_host_ ? child_process_host_->process_handle()
+                             : base::kNullProcessHandle;
+}
+
 void OutOfProcessNativeRunner::AppCompleted(int32_t result) {
   DVLOG(2) << "OutOfProcessNativeRunner::AppCompleted(" << result << ")";
 
@@ -25,10 +25,11 @@ class OutOfProcessNativeRunner : public NativeRunner {
                            const NativeApplicationOptions& options);
   ~OutOfProcessNativeRunner() override;
 
-  // |NativeRunner| method:
+  // |NativeRunner| methods:
   void Start(const base::FilePath& app_path,
              mojo::InterfaceRequest<mojo::Application> application_request,
              const base::Closure& app_completed_callback) override;
+  base::ProcessHandle GetProcessHandle() const override;
 
  private:
   // |ChildProcessHost::StartApp()| callback:
@@ -0,0 +1,133 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/startup_timeline.h"
+
+#include <map>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/format_macros.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+
+namespace shell {
+
+namespace {
+
+class StartupTimeline {
+ public:
+  explicit StartupTimeline(base::File file) : file_(file.Pass()) {}
+  ~StartupTimeline() {}
+
+  void Begin(const char* phase, const std::string& target) {
+    base::AutoLock lock(lock_);
+    begin_times_[std::make_pair(std::string(phase), target)] =
+        base::TimeTicks::Now();
+  }
+
+  void End(const char* phase, const std::string& target) {
+    base::TimeTicks end = base::TimeTicks::Now();
+    base::AutoLock lock(lock_);
+    auto it = begin_times_.find(std::make_pair(std::string(phase), target));
+    if (it == begin_times_.end())
+      return;
+    WriteLine(phase, it->second, end, target);
+    begin_times_.erase(it);
+  }
+
+  void Mark(const char* event, const std::string& target) {
+    base::TimeTicks now = base::TimeTicks::Now();
+    base::AutoLock lock(lock_);
+    WriteLine(event, now, now, target);
+  }
+
+ private:
+  void WriteLine(const char* phase,
+                 base::TimeTicks begin,
+                 base::TimeTicks end,
+                 const std::string& target) {
+    lock_.AssertAcquired();
+    std::string line = base::StringPrintf(
+        "%s %" PRId64 " %" PRId64 " %s\n", phase, begin.ToInternalValue(),
+        end.ToInternalValue(), target.c_str());
+    // The file is opened for appending, so that lines written by different
+    // processes don't overwrite each other.
+    if (file_.WriteAtCurrentPos(line.data(), static_cast<int>(line.size())) !=
+        static_cast<int>(line.size())) {
+      LOG(ERROR) << "Failed to write to the startup timeline";
+    }
+  }
+
+  base::Lock lock_;
+  base::File file_;
+  // When the phases in progress began, by phase and target.
+  std::map<std::pair<std::string, std::string>, base::TimeTicks> begin_times_;
+
+  DISALLOW_COPY_AND_ASSIGN(StartupTimeline);
+};
+
+// Set once, before any other thread is started, and then never deleted (other
+// than by tests), so that it can be used from any thread without locking.
+StartupTimeline* g_startup_timeline = nullptr;
+
+}  // namespace
+
+bool EnableStartupTimeline(const base::FilePath& path,
+                           bool truncate,
+                           const char* start_event) {
+  DCHECK(!g_startup_timeline);
+  base::File file(path, (truncate ? base::File::FLAG_CREATE_ALWAYS
+                                  : base::File::FLAG_OPEN_ALWAYS) |
+                            base::File::FLAG_WRITE | base::File::FLAG_APPEND);
+  if (!file.IsValid()) {
+    LOG(ERROR) << "Failed to open the startup timeline " << path.value();
+    return false;
+  }
+  g_startup_timeline = new StartupTimeline(file.Pass());
+  MarkStartupEvent(start_event, std::string());
+  return true;
+}
+
+void DisableStartupTimelineForTesting() {
+  delete g_startup_timeline;
+  g_startup_timeline = nullptr;
+}
+
+void BeginStartupPhase(const char* phase, const std::string& target) {
+  TRACE_EVENT_ASYNC_BEGIN1("mojo_shell", phase, base::Hash(target), "target",
+                           target);
+  if (g_startup_timeline)
+    g_startup_timeline->Begin(phase, target);
+}
+
+void EndStartupPhase(const char* phase, const std::string& target) {
+  TRACE_EVENT_ASYNC_END0("mojo_shell", phase, base::Hash(target));
+  if (g_startup_timeline)
+    g_startup_timeline->End(phase, target);
+}
+
+void MarkStartupEvent(const char* event, const std::string& target) {
+  TRACE_EVENT_INSTANT1("mojo_shell", event, TRACE_EVENT_SCOPE_PROCESS,
+                       "target", target);
+  if (g_startup_timeline)
+    g_startup_timeline->Mark(event, target);
+}
+
+ScopedStartupPhase::ScopedStartupPhase(const char* phase,
+                                       const std::string& target)
+    : phase_(phase), target_(target) {
+  BeginStartupPhase(phase_, target_);
+}
+
+ScopedStartupPhase::~ScopedStartupPhase() {
+  EndStartupPhase(phase_, target_);
+}
+
+}  // namespace shell
@@ -0,0 +1,70 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// The startup timeline records the critical path of the startup of the shell
+// and of the applications it runs: initializing the shell, and then, for each
+// application, resolving its URL, fetching it (possibly from the cache),
+// sniffing it, launching a child process, loading its library, up to calling
+// its |MojoMain()|.
+//
+// Each phase is always traced (as an async "mojo_shell" event). If the
+// timeline has been enabled (with --startup-timeline=<path>), each phase is
+// also appended, as soon as it ends, to the timeline file as a line:
+//   <phase> <begin> <end> <target>
+// where <begin> and <end> are |base::TimeTicks| in microseconds (which are
+// comparable between processes on the same machine) and <target> is what the
+// phase is for: the URL or path of an application, the connection ID of a
+// child process, or nothing for phases of the shell itself. Child processes
+// append to the same file. Writes are unbuffered, so that the timeline is
+// complete even if an application exits the process from its |MojoMain()|.
+
+#ifndef SHELL_STARTUP_TIMELINE_H_
+#define SHELL_STARTUP_TIMELINE_H_
+
+#include <string>
+
+#include "base/macros.h"
+
+namespace base {
+class FilePath;
+}
+
+namespace shell {
+
+// Starts appending the timeline to |path|, which is emptied first if
+// |truncate| is true (i.e., in the shell as opposed to child processes), and
+// records |start_event| (e.g., "ShellStart"). Must be called before any other
+// thread is started. Returns false if |path| can't be opened.
+bool EnableStartupTimeline(const base::FilePath& path,
+                           bool truncate,
+                           const char* start_event);
+
+// Stops appending the timeline, so that tests can enable it again.
+void DisableStartupTimelineForTesting();
+
+// Records the beginning and the end of |phase| for |target|. |phase| must be a
+// string literal. Ending a phase that didn't begin (e.g., because an
+// application was preloaded) does nothing. May be called on any thread.
+void BeginStartupPhase(const char* phase, const std::string& target);
+void EndStartupPhase(const char* phase, const std::string& target);
+
+// Records |event| for |target|, as a phase that ends as soon as it begins.
+void MarkStartupEvent(const char* event, const std::string& target);
+
+// Records |phase| for |target| for the lifetime of this object.
+class ScopedStartupPhase {
+ public:
+  ScopedStartupPhase(const char* phase, const std::string& target);
+  ~ScopedStartupPhase();
+
+ private:
+  const char* const phase_;
+  const std::string target_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedStartupPhase);
+};
+
+}  // namespace shell
+
+#endif  // SHELL_STARTUP_TIMELINE_H_
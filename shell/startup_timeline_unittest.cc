@@ -0,0 +1,134 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/startup_timeline.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace shell {
+namespace {
+
+struct TimelineLine {
+  std::string phase;
+  int64 begin;
+  int64 end;
+  std::string target;
+};
+
+class StartupTimelineTest : public testing::Test {
+ public:
+  StartupTimelineTest() {}
+  ~StartupTimelineTest() override {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.path().AppendASCII("timeline");
+  }
+
+  void TearDown() override { DisableStartupTimelineForTesting(); }
+
+ protected:
+  // Parses the lines of the timeline file.
+  std::vector<TimelineLine> ReadTimeline() {
+    std::vector<TimelineLine> lines;
+    std::string contents;
+    EXPECT_TRUE(base::ReadFileToString(path_, &contents));
+    std::vector<std::string> raw_lines;
+    base::SplitStringDontTrim(contents, '\n', &raw_lines);
+    for (const std::string& raw_line : raw_lines) {
+      if (raw_line.empty())
+        continue;
+      // The target is empty for the phases of the shell itself.
+      std::vector<std::string> fields;
+      base::SplitStringDontTrim(raw_line, ' ', &fields);
+      EXPECT_EQ(4u, fields.size()) << raw_line;
+      if (fields.size() != 4u)
+        continue;
+      TimelineLine line;
+      line.phase = fields[0];
+      EXPECT_TRUE(base::StringToInt64(fields[1], &line.begin)) << raw_line;
+      EXPECT_TRUE(base::StringToInt64(fields[2], &line.end)) << raw_line;
+      EXPECT_LE(line.begin, line.end) << raw_line;
+      line.target = fields[3];
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath path_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(StartupTimelineTest);
+};
+
+TEST_F(StartupTimelineTest, RecordsPhases) {
+  ASSERT_TRUE(EnableStartupTimeline(path_, true, "ShellStart"));
+  BeginStartupPhase("Fetch", "http://a/app.mojo");
+  BeginStartupPhase("Fetch", "http://b/app.mojo");
+  MarkStartupEvent("MojoMain", "http://c/app.mojo");
+  EndStartupPhase("Fetch", "http://b/app.mojo");
+  // Phases which didn't begin, or already ended, aren't recorded.
+  EndStartupPhase("Fetch", "http://b/app.mojo");
+  EndStartupPhase("LoadLibrary", "http://a/app.mojo");
+  { ScopedStartupPhase phase("ContextInit", std::string()); }
+  EndStartupPhase("Fetch", "http://a/app.mojo");
+
+  std::vector<TimelineLine> lines = ReadTimeline();
+  ASSERT_EQ(5u, lines.size());
+  EXPECT_EQ("ShellStart", lines[0].phase);
+  EXPECT_EQ(lines[0].begin, lines[0].end);
+  EXPECT_EQ(std::string(), lines[0].target);
+  EXPECT_EQ("MojoMain", lines[1].phase);
+  EXPECT_EQ(lines[1].begin, lines[1].end);
+  EXPECT_EQ("http://c/app.mojo", lines[1].target);
+  EXPECT_EQ("Fetch", lines[2].phase);
+  EXPECT_EQ("http://b/app.mojo", lines[2].target);
+  EXPECT_EQ("ContextInit", lines[3].phase);
+  EXPECT_EQ(std::string(), lines[3].target);
+  EXPECT_EQ("Fetch", lines[4].phase);
+  EXPECT_EQ("http://a/app.mojo", lines[4].target);
+
+  // The phases are timed from their own beginnings.
+  EXPECT_LE(lines[0].begin, lines[4].begin);
+  EXPECT_LE(lines[4].begin, lines[2].begin);
+  EXPECT_LE(lines[2].end, lines[4].end);
+}
+
+// Child processes append to the timeline of the shell, which empties it.
+TEST_F(StartupTimelineTest, TruncatesOrAppends) {
+  ASSERT_EQ(12, base::WriteFile(path_, "Stale 1 2 x\n", 12));
+  ASSERT_TRUE(EnableStartupTimeline(path_, true, "ShellStart"));
+  DisableStartupTimelineForTesting();
+  ASSERT_TRUE(EnableStartupTimeline(path_, false, "ChildStart"));
+  MarkStartupEvent("StartChildApp", "1");
+
+  std::vector<TimelineLine> lines = ReadTimeline();
+  ASSERT_EQ(3u, lines.size());
+  EXPECT_EQ("ShellStart", lines[0].phase);
+  EXPECT_EQ("ChildStart", lines[1].phase);
+  EXPECT_EQ("StartChildApp", lines[2].phase);
+  EXPECT_EQ("1", lines[2].target);
+}
+
+TEST_F(StartupTimelineTest, FailsOnBadPath) {
+  EXPECT_FALSE(EnableStartupTimeline(
+      temp_dir_.path().AppendASCII("missing").AppendASCII("timeline"), true,
+      "ShellStart"));
+  // Disabled phases are only traced.
+  BeginStartupPhase("Fetch", "http://a/app.mojo");
+  EndStartupPhase("Fetch", "http://a/app.mojo");
+  EXPECT_FALSE(base::PathExists(path_));
+}
+
+}  // namespace
+}  // namespace shell
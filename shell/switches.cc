@@ -5,6 +5,7 @@
 #include "shell/switches.h"
 
 #include "base/macros.h"
+#include "shell/child_switches.h"
 
 namespace switches {
 
@@ -21,6 +22,11 @@ const char kV[] = "v";
 // --args-for='mojo:wget http://www.google.com'
 const char kArgsFor[] = "args-for";
 
+// In multiprocess mode, keeps this many child processes started ahead of time,
+// ready to run apps, so that starting an app out of process doesn't have to
+// wait for a child process to launch and connect. Defaults to 0 (none).
+const char kChildProcessPoolSize[] = "child-process-pool-size";
+
 // Comma separated list like:
 // text/html,mojo:html_viewer,application/bravo,https://abarth.com/bravo
 const char kContentHandlers[] = "content-handlers";
@@ -60,6 +66,25 @@ const char kMapOrigin[] = "map-origin";
 // url_resolver.cc for details.
 const char kOrigin[] = "origin";
 
+// Records which apps each app connects to, and on later runs fetches (and, in
+// single process mode, loads) all the apps an app is known to connect to as
+// soon as it is started. The optional value is the path of the file the
+// dependencies are stored in (a JSON dictionary from app URL to the list of
+// URLs it connects to, which may also be written by hand); by default it is
+// stored next to the URL response disk cache.
+const char kPreloadDependencies[] = "preload-dependencies";
+
+// Asks apps that haven't been connected to for a minute to quit when the system
+// is low on memory, least recently used first; they're started again when
+// connected to. The optional value is a memory budget in MB: apps are also
+// reaped while the apps running in processes of their own use more than that.
+const char kReapIdleApps[] = "reap-idle-apps";
+
+// Records per-method statistics for the interfaces used by the shell, as
+// "mojo_bindings" trace counters and histograms. Pass --trace-bindings to an
+// app (see --args-for) to do the same for the app.
+const char kTraceBindings[] = "trace-bindings";
+
 // Starts tracing when the shell starts up, saving a trace file on disk after 5
 // seconds or when the shell exits.
 const char kTraceStartup[] = "trace-startup";
@@ -69,7 +94,8 @@ const char kTraceStartup[] = "trace-startup";
 const char kTraceStartupDuration[] = "trace-startup-duration";
 
 // Sets the name of the output file for startup tracing. If omitted a default of
-// 'mojo_shell.trace' is used.
+// 'mojo_shell.trace' is used. The trace is compressed with gzip if the name
+// ends with '.gz'.
 const char kTraceStartupOutputName[] = "trace-startup-output-name";
 
 // Specifies a set of mappings to apply when resolving urls. The value is a set
@@ -81,6 +107,7 @@ const char kURLMappings[] = "url-mappings";
 // Switches valid for the main process (i.e., that the user may pass in).
 const char* kSwitchArray[] = {kV,
                               kArgsFor,
+                              kChildProcessPoolSize,
                               kContentHandlers,
                               kCPUProfile,
                               kDisableCache,
@@ -91,6 +118,10 @@ const char* kSwitchArray[] = {kV,
                               kHelp,
                               kMapOrigin,
                               kOrigin,
+                              kPreloadDependencies,
+                              kReapIdleApps,
+                              kStartupTimeline,
+                              kTraceBindings,
                               kTraceStartup,
                               kTraceStartupDuration,
                               kTraceStartupOutputName,
@@ -14,6 +14,7 @@ namespace switches {
 // alongside the definition of their values in the .cc file and, as needed, in
 // desktop/main.cc's Usage() function.
 extern const char kArgsFor[];
+extern const char kChildProcessPoolSize[];
 extern const char kContentHandlers[];
 extern const char kCPUProfile[];
 extern const char kDisableCache[];
@@ -24,6 +25,9 @@ extern const char kForceOfflineByDefault[];
 extern const char kHelp[];
 extern const char kMapOrigin[];
 extern const char kOrigin[];
+extern const char kPreloadDependencies[];
+extern const char kReapIdleApps[];
+extern const char kTraceBindings[];
 extern const char kTraceStartup[];
 extern const char kTraceStartupDuration[];
 extern const char kTraceStartupOutputName[];
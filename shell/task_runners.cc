@@ -4,7 +4,7 @@
 
 #include "shell/task_runners.h"
 
-#include "base/threading/sequenced_worker_pool.h"
+#include "base/threading/work_stealing_pool.h"
 #include "mojo/edk/base_edk/platform_handle_watcher_impl.h"
 #include "mojo/edk/base_edk/platform_task_runner_impl.h"
 #include "mojo/edk/util/make_unique.h"
@@ -16,7 +16,7 @@ namespace shell {
 
 namespace {
 
-const size_t kMaxBlockingPoolThreads = 3;
+const size_t kBlockingPoolThreads = 3;
 
 scoped_ptr<base::Thread> CreateIOThread(const char* name) {
   scoped_ptr<base::Thread> thread(new base::Thread(name));
@@ -37,8 +37,8 @@ TaskRunners::TaskRunners(
           io_thread_->task_runner())),
       io_watcher_(MakeUnique<base_edk::PlatformHandleWatcherImpl>(
           static_cast<base::MessageLoopForIO*>(io_thread_->message_loop()))),
-      blocking_pool_(new base::SequencedWorkerPool(kMaxBlockingPoolThreads,
-                                                   "blocking_pool")) {}
+      blocking_pool_(new base::WorkStealingPool(kBlockingPoolThreads,
+                                                "blocking_pool")) {}
 
 TaskRunners::~TaskRunners() {
   blocking_pool_->Shutdown();
@@ -17,7 +17,7 @@
 #include "mojo/edk/util/ref_ptr.h"
 
 namespace base {
-class SequencedWorkerPool;
+class WorkStealingPool;
 }
 
 namespace shell {
@@ -38,11 +38,16 @@ class TaskRunners {
     return io_runner_;
   }
 
+  // The //base task runner for the same thread as |io_runner()|.
+  scoped_refptr<base::SingleThreadTaskRunner> io_thread_task_runner() const {
+    return io_thread_->task_runner();
+  }
+
   mojo::platform::PlatformHandleWatcher* io_watcher() const {
     return io_watcher_.get();
   }
 
-  base::SequencedWorkerPool* blocking_pool() const {
+  base::WorkStealingPool* blocking_pool() const {
     return blocking_pool_.get();
   }
 
@@ -52,7 +57,7 @@ class TaskRunners {
   mojo::util::RefPtr<mojo::platform::TaskRunner> io_runner_;
   std::unique_ptr<mojo::platform::PlatformHandleWatcher> io_watcher_;
 
-  scoped_refptr<base::SequencedWorkerPool> blocking_pool_;
+  scoped_refptr<base::WorkStealingPool> blocking_pool_;
 
   DISALLOW_COPY_AND_ASSIGN(TaskRunners);
 };
@@ -9,15 +9,31 @@
 
 #include "base/message_loop/message_loop.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
 #include "base/trace_event/trace_config.h"
 #include "base/trace_event/trace_event.h"
+#include "third_party/zlib/zlib.h"
 
 namespace shell {
 
+namespace {
+
+// Compressing is done as the data comes, so favor speed.
+const int kCompressionLevel = Z_BEST_SPEED;
+
+// For deflateInit2(): the maximum window, with a gzip header.
+const int kGzipWindowBits = MAX_WBITS + 16;
+const int kMemLevel = 8;
+
+}  // namespace
+
 Tracer::Tracer()
-    : tracing_(false), first_chunk_written_(false), trace_file_(nullptr) {}
+    : tracing_(false),
+      first_chunk_written_(false),
+      trace_service_data_started_(false),
+      trace_file_(nullptr) {}
 
 Tracer::~Tracer() {}
 
@@ -70,10 +86,7 @@ void Tracer::ConnectToProvider(
 
 void Tracer::StopTracingAndFlushToDisk() {
   tracing_ = false;
-  trace_file_ = fopen(trace_filename_.c_str(), "w+");
-  PCHECK(trace_file_);
-  static const char kStart[] = "{\"traceEvents\":[";
-  PCHECK(fwrite(kStart, 1, strlen(kStart), trace_file_) == strlen(kStart));
+  OpenTraceFileIfNeeded();
 
   // At this point we might be connected to the tracing service, in which case
   // we want to tell it to stop tracing and we will send the data we've
@@ -103,12 +116,57 @@ void Tracer::StopTracingAndFlushToDisk() {
           ->SetCurrentThreadBlocksMessageLoop();
       flush_complete_event.Wait();
     }
+    WriteFooterAndClose();
+  }
+}
+
+void Tracer::OpenTraceFileIfNeeded() {
+  if (trace_file_)
+    return;
+  trace_file_ = fopen(trace_filename_.c_str(), "w+");
+  PCHECK(trace_file_);
+  if (EndsWith(trace_filename_, ".gz", true)) {
+    zstream_.reset(new z_stream);
+    memset(zstream_.get(), 0, sizeof(z_stream));
+    CHECK_EQ(Z_OK, deflateInit2(zstream_.get(), kCompressionLevel, Z_DEFLATED,
+                                kGzipWindowBits, kMemLevel,
+                                Z_DEFAULT_STRATEGY));
+  }
+  static const char kStart[] = "{\"traceEvents\":[";
+  WriteToTraceFile(kStart, strlen(kStart));
+}
+
+void Tracer::WriteToTraceFile(const char* data, size_t num_bytes) {
+  if (!zstream_) {
+    PCHECK(fwrite(data, 1, num_bytes, trace_file_) == num_bytes);
+    return;
   }
+
+  // With no data, finishes the compressed stream.
+  int flush = num_bytes ? Z_NO_FLUSH : Z_FINISH;
+  zstream_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  zstream_->avail_in = static_cast<uInt>(num_bytes);
+  char buffer[16 * 1024];
+  do {
+    zstream_->next_out = reinterpret_cast<Bytef*>(buffer);
+    zstream_->avail_out = sizeof(buffer);
+    int result = deflate(zstream_.get(), flush);
+    CHECK(result == Z_OK || result == Z_STREAM_END || result == Z_BUF_ERROR)
+        << result;
+    size_t num_compressed_bytes = sizeof(buffer) - zstream_->avail_out;
+    PCHECK(fwrite(buffer, 1, num_compressed_bytes, trace_file_) ==
+           num_compressed_bytes);
+  } while (zstream_->avail_out == 0);
 }
 
 void Tracer::WriteFooterAndClose() {
   static const char kEnd[] = "]}";
-  PCHECK(fwrite(kEnd, 1, strlen(kEnd), trace_file_) == strlen(kEnd));
+  WriteToTraceFile(kEnd, strlen(kEnd));
+  if (zstream_) {
+    WriteToTraceFile(nullptr, 0);
+    CHECK_EQ(Z_OK, deflateEnd(zstream_.get()));
+    zstream_.reset();
+  }
   PCHECK(fclose(trace_file_) == 0);
   trace_file_ = nullptr;
   LOG(INFO) << "Wrote trace data to " << trace_filename_;
@@ -127,9 +185,7 @@ void Tracer::WriteTraceDataCollected(
     bool has_more_events) {
   if (events_str->size()) {
     WriteCommaIfNeeded();
-
-    PCHECK(fwrite(events_str->data().c_str(), 1, events_str->data().length(),
-                  trace_file_) == events_str->data().length());
+    WriteToTraceFile(events_str->data().data(), events_str->data().length());
   }
 
   if (!has_more_events && !done_callback.is_null())
@@ -137,18 +193,17 @@ void Tracer::WriteTraceDataCollected(
 }
 
 void Tracer::OnDataAvailable(const void* data, size_t num_bytes) {
-  const char* chars = static_cast<const char*>(data);
-  trace_service_data_.append(chars, num_bytes);
+  // The tracing service sends a single list of events, which we stream to the
+  // file rather than holding on to it.
+  OpenTraceFileIfNeeded();
+  if (!trace_service_data_started_ && num_bytes)
+    WriteCommaIfNeeded();
+  trace_service_data_started_ = true;
+  WriteToTraceFile(static_cast<const char*>(data), num_bytes);
 }
 
 void Tracer::OnDataComplete() {
-  if (!trace_service_data_.empty()) {
-    WriteCommaIfNeeded();
-    const char* const chars = trace_service_data_.data();
-    size_t num_bytes = trace_service_data_.length();
-    PCHECK(fwrite(chars, 1, num_bytes, trace_file_) == num_bytes);
-    trace_service_data_ = std::string();
-  }
+  OpenTraceFileIfNeeded();
   drainer_.reset();
   coordinator_.reset();
   WriteFooterAndClose();
@@ -156,7 +211,7 @@ void Tracer::OnDataComplete() {
 
 void Tracer::WriteCommaIfNeeded() {
   if (first_chunk_written_)
-    PCHECK(fwrite(",", 1, 1, trace_file_) == 1);
+    WriteToTraceFile(",", 1);
   first_chunk_written_ = true;
 }
 
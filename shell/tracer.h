@@ -12,18 +12,22 @@
 #include "base/callback.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted_memory.h"
+#include "base/memory/scoped_ptr.h"
 #include "mojo/common/trace_provider_impl.h"
 #include "mojo/data_pipe_utils/data_pipe_drainer.h"
 #include "mojo/services/tracing/interfaces/tracing.mojom.h"
 
+struct z_stream_s;
+
 namespace shell {
 
 // Tracer collects tracing data from base/trace_event and from externally
 // configured sources, aggregates it into a single stream, and writes it out to
-// a file. It should be constructed very early in a process' lifetime before any
-// initialization that may be interesting to trace has occured and be shut down
-// as late as possible to capture as much initialization/shutdown code as
-// possible.
+// a file as it comes (so that the size of a trace isn't bounded by memory),
+// compressing it with gzip if the name of the file ends with ".gz". It should
+// be constructed very early in a process' lifetime before any initialization
+// that may be interesting to trace has occured and be shut down as late as
+// possible to capture as much initialization/shutdown code as possible.
 class Tracer : public mojo::common::DataPipeDrainer::Client {
  public:
   Tracer();
@@ -71,6 +75,12 @@ class Tracer : public mojo::common::DataPipeDrainer::Client {
   void OnDataAvailable(const void* data, size_t num_bytes) override;
   void OnDataComplete() override;
 
+  // Opens the trace file and writes its header, unless already done.
+  void OpenTraceFileIfNeeded();
+
+  // Writes to the trace file, compressing if needed.
+  void WriteToTraceFile(const char* data, size_t num_bytes);
+
   // Emits a comma if needed.
   void WriteCommaIfNeeded();
 
@@ -91,10 +101,13 @@ class Tracer : public mojo::common::DataPipeDrainer::Client {
 
   // Whether we've written the first chunk.
   bool first_chunk_written_;
-  std::string trace_service_data_;
+  // Whether we've started writing the data from the tracing service.
+  bool trace_service_data_started_;
 
   // Trace file, if open.
   FILE* trace_file_;
+  // Compression state, if the trace file is compressed.
+  scoped_ptr<z_stream_s> zstream_;
   std::string trace_filename_;
 
   DISALLOW_COPY_AND_ASSIGN(Tracer);
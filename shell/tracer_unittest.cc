@@ -0,0 +1,114 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shell/tracer.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/trace_event/trace_event.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/zlib.h"
+
+namespace shell {
+namespace {
+
+// Enough events for TraceLog::Flush() to hand over several chunks of about
+// 100KB each.
+const int kNumEvents = 10000;
+
+// Inflates the gzip stream |compressed| into |output|.
+bool Gunzip(const std::string& compressed, std::string* output) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK)
+    return false;
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  stream.avail_in = static_cast<uInt>(compressed.size());
+  char buffer[16 * 1024];
+  int result;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+    output->append(buffer, sizeof(buffer) - stream.avail_out);
+  } while (result == Z_OK);
+  inflateEnd(&stream);
+  return result == Z_STREAM_END;
+}
+
+class TracerTest : public testing::Test {
+ public:
+  TracerTest() {}
+  ~TracerTest() override {}
+
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+ protected:
+  // Traces |kNumEvents| events to |filename| without a tracing service and
+  // returns the uncompressed contents of the file.
+  std::string TraceToFile(const std::string& filename, bool gzip) {
+    base::FilePath path = temp_dir_.path().AppendASCII(filename);
+    Tracer tracer;
+    tracer.Start("tracer_test", "", path.value());
+    for (int i = 0; i < kNumEvents; i++) {
+      TRACE_EVENT_INSTANT1("tracer_test", "TracerTestEvent",
+                           TRACE_EVENT_SCOPE_THREAD, "index", i);
+    }
+    tracer.StopAndFlushToFile();
+
+    std::string contents;
+    EXPECT_TRUE(base::ReadFileToString(path, &contents));
+    if (!gzip)
+      return contents;
+    std::string uncompressed;
+    EXPECT_TRUE(Gunzip(contents, &uncompressed));
+    return uncompressed;
+  }
+
+  // Checks that |json| is a trace holding all the events of TraceToFile().
+  void ExpectValidTrace(const std::string& json) {
+    // Several chunks were flushed, so they were joined with commas.
+    EXPECT_GT(json.size(), 2u * 100 * 1024);
+    scoped_ptr<base::Value> value(base::JSONReader::Read(json));
+    ASSERT_TRUE(value);
+    base::DictionaryValue* dict = nullptr;
+    ASSERT_TRUE(value->GetAsDictionary(&dict));
+    base::ListValue* events = nullptr;
+    ASSERT_TRUE(dict->GetList("traceEvents", &events));
+    size_t num_test_events = 0;
+    for (const base::Value* event_value : *events) {
+      const base::DictionaryValue* event = nullptr;
+      ASSERT_TRUE(event_value->GetAsDictionary(&event));
+      std::string name;
+      if (event->GetString("name", &name) && name == "TracerTestEvent")
+        num_test_events++;
+    }
+    EXPECT_EQ(static_cast<size_t>(kNumEvents), num_test_events);
+  }
+
+ private:
+  base::ScopedTempDir temp_dir_;
+
+  DISALLOW_COPY_AND_ASSIGN(TracerTest);
+};
+
+TEST_F(TracerTest, MultipleChunks) {
+  ExpectValidTrace(TraceToFile("trace.json", false));
+}
+
+TEST_F(TracerTest, MultipleChunksGzip) {
+  ExpectValidTrace(TraceToFile("trace.json.gz", true));
+}
+
+}  // namespace
+}  // namespace shell
@@ -14,7 +14,7 @@
 
 namespace shell {
 
-URLResolver::URLResolver() {
+URLResolver::URLResolver() : version_(0) {
   // Needed to treat first component of mojo URLs as host, not path.
   url::AddStandardScheme("mojo");
 }
@@ -50,6 +50,7 @@ std::vector<URLResolver::OriginMapping> URLResolver::GetOriginMappings(
 
 void URLResolver::AddURLMapping(const GURL& url, const GURL& mapped_url) {
   url_map_[url] = mapped_url;
+  version_++;
 }
 
 void URLResolver::AddOriginMapping(const GURL& origin, const GURL& base_url) {
@@ -61,6 +62,7 @@ void URLResolver::AddOriginMapping(const GURL& origin, const GURL& base_url) {
   }
   // Force both origin and base_url to have trailing slashes.
   origin_map_[origin] = AddTrailingSlashIfNeeded(base_url);
+  version_++;
 }
 
 GURL URLResolver::ApplyMappings(const GURL& url) const {
@@ -91,6 +93,7 @@ void URLResolver::SetMojoBaseURL(const GURL& mojo_base_url) {
   // Force a trailing slash on the base_url to simplify resolving
   // relative files and URLs below.
   mojo_base_url_ = AddTrailingSlashIfNeeded(mojo_base_url);
+  version_++;
 }
 
 GURL URLResolver::ResolveMojoURL(const GURL& mojo_url) const {
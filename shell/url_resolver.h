@@ -62,11 +62,15 @@ class URLResolver {
   // code for the corresponding Mojo App.
   GURL ResolveMojoURL(const GURL& mojo_url) const;
 
+  // Incremented whenever a mapping or the mojo base URL changes.
+  uint64_t version() const { return version_; }
+
  private:
   using GURLToGURLMap = std::map<GURL, GURL>;
   GURLToGURLMap url_map_;
   GURLToGURLMap origin_map_;
   GURL mojo_base_url_;
+  uint64_t version_;
 
   DISALLOW_COPY_AND_ASSIGN(URLResolver);
 };